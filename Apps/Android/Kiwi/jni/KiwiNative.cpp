@@ -210,6 +210,7 @@ bool setupGraphics(int w, int h)
   app = new vesKiwiViewerApp();
   cameraSpinner.setApp(app);
   app->resizeView(w, h);
+  app->setInteractiveResolutionScaling(true);
 
   if (isResume && !appState.currentDataset.empty()) {
     app->loadDataset(appState.currentDataset);
@@ -357,7 +358,7 @@ JNIEXPORT jboolean JNICALL Java_com_kitware_KiwiViewer_KiwiNative_render(JNIEnv
 
   fpsFrames++;
 
-  return cameraSpinner.spinIsActive() || app->isAnimating();
+  return cameraSpinner.spinIsActive() || app->isRenderNeeded();
 }
 
 JNIEXPORT void JNICALL Java_com_kitware_KiwiViewer_KiwiNative_resetCamera(JNIEnv * env, jobject obj)
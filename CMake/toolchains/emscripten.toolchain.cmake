@@ -29,3 +29,7 @@ set (CMAKE_RANLIB ${EMSCRIPTEN_PATH}/emranlib CACHE PATH "ranlib" FORCE)
 set (EMSCRIPTEN True)
 set (BUILD_EMSCRIPTEN True)
 
+# Browsers run without shared memory unless the page opts in, so build
+# without worker threads by default.
+set (VES_USE_THREADS OFF CACHE BOOL "Run sorting, culling and loading work on background threads.  Requires pthreads.")
+
@@ -0,0 +1,411 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+
+// Headless performance benchmark of the KiwiViewer app. Renders into an
+// EGL pbuffer through vesHeadlessContext, so it runs on a software
+// rasterizer without a display or GPU. For each builtin dataset it
+// measures the load time, the first frame (which uploads the geometry), the
+// steady state frame times along scripted camera paths and the pick
+// latency, and it reports the peak resident memory and the bytes uploaded
+// to the GPU. The results are written as JSON and can be checked against a
+// baseline written by an earlier run. With --pipelined the renderer culls
+// the next frame on its worker thread while the current one is drawn.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <sys/resource.h>
+#include <sys/time.h>
+
+#include <vesKiwiViewerApp.h>
+#include <vesRenderer.h>
+#include <vesRenderStatistics.h>
+#include <vesSetGet.h>
+
+#include <GLES2/gl2.h>
+
+#include "vesHeadlessTesting.h"
+
+//----------------------------------------------------------------------------
+namespace {
+
+typedef std::vector<std::pair<std::string, double> > Metrics;
+
+const int viewWidth = 800;
+const int viewHeight = 600;
+const int framesPerPath = 60;
+const int numberOfPicks = 20;
+
+//----------------------------------------------------------------------------
+class vesBenchmarkApp : public vesKiwiViewerApp
+{
+public:
+
+  // The benchmark picks and switches pipelining through the renderer, which
+  // the app keeps protected.
+  vesSharedPtr<vesRenderer> benchmarkRenderer() const
+  {
+    return this->renderer();
+  }
+};
+
+//----------------------------------------------------------------------------
+class vesBenchmarkOptions
+{
+public:
+
+  vesBenchmarkOptions() : Tolerance(0.25), Pipelined(false)
+  {
+  }
+
+  std::string SourceDirectory;
+  std::string OutputFile;
+  std::string BaselineFile;
+  double Tolerance;
+  bool Pipelined;
+};
+
+//----------------------------------------------------------------------------
+double CurrentTime()
+{
+  timeval time;
+  gettimeofday(&time, 0);
+  return time.tv_sec + time.tv_usec * 1e-6;
+}
+
+//----------------------------------------------------------------------------
+double PeakResidentBytes()
+{
+  rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  // ru_maxrss is in kilobytes on Linux.
+  return usage.ru_maxrss * 1024.0;
+}
+
+//----------------------------------------------------------------------------
+double Percentile(std::vector<double> values, double fraction)
+{
+  if (values.empty()) {
+    return 0.0;
+  }
+  std::sort(values.begin(), values.end());
+  size_t index = static_cast<size_t>(fraction * (values.size() - 1) + 0.5);
+  return values[index];
+}
+
+//----------------------------------------------------------------------------
+std::string MetricName(const std::string& dataset, const std::string& name)
+{
+  return dataset + "/" + name;
+}
+
+//----------------------------------------------------------------------------
+// Renders one frame and waits for the GPU, so the time covers the whole
+// frame and not only the submission.
+double TimeFrame(vesBenchmarkApp* app, unsigned long& bytesUploaded)
+{
+  double startTime = CurrentTime();
+  app->render();
+  glFinish();
+  bytesUploaded += app->renderStatistics().m_bytesUploaded;
+  return CurrentTime() - startTime;
+}
+
+//----------------------------------------------------------------------------
+// Moves the camera along one of the scripted paths through the same
+// gestures a user would make, one gesture per frame.
+void ApplyCameraPath(vesBenchmarkApp* app, const std::string& path, int frame)
+{
+  if (path == "orbit") {
+    app->handleSingleTouchPanGesture(viewWidth / 60.0, 0.0);
+  }
+  else if (path == "tumble") {
+    app->handleSingleTouchPanGesture(viewWidth / 90.0, viewHeight / 90.0);
+  }
+  else if (path == "zoom") {
+    app->handleTwoTouchPinchGesture(frame < framesPerPath / 2 ? 1.02 : 1.0 / 1.02);
+  }
+  else if (path == "pan") {
+    double x = viewWidth / 2.0;
+    double y = viewHeight / 2.0;
+    double step = frame < framesPerPath / 2 ? 4.0 : -4.0;
+    app->handleTwoTouchPanGesture(x, y, x + step, y);
+  }
+}
+
+//----------------------------------------------------------------------------
+void BenchmarkDataset(vesBenchmarkApp* app, const vesBenchmarkOptions& options,
+                      int index, Metrics& metrics, unsigned long& bytesUploaded)
+{
+  std::string name = app->builtinDatasetName(index);
+  std::string filename = BuiltinDatasetPath(options.SourceDirectory,
+                                            app->builtinDatasetFilename(index));
+
+  double startTime = CurrentTime();
+  if (!app->loadDataset(filename)) {
+    std::cout << "Skipping dataset '" << name << "': "
+              << app->loadDatasetErrorMessage() << std::endl;
+    return;
+  }
+  metrics.push_back(std::make_pair(MetricName(name, "loadTime"),
+                                   CurrentTime() - startTime));
+
+  app->applyBuiltinDatasetCameraParameters(index);
+  metrics.push_back(std::make_pair(MetricName(name, "firstFrameTime"),
+                                   TimeFrame(app, bytesUploaded)));
+
+  const char* paths[] = { "orbit", "tumble", "zoom", "pan" };
+  for (size_t i = 0; i < sizeof(paths) / sizeof(paths[0]); ++i) {
+    app->applyBuiltinDatasetCameraParameters(index);
+    std::vector<double> frameTimes;
+    for (int frame = 0; frame < framesPerPath; ++frame) {
+      ApplyCameraPath(app, paths[i], frame);
+      frameTimes.push_back(TimeFrame(app, bytesUploaded));
+    }
+    std::string path = std::string("frameTime/") + paths[i];
+    metrics.push_back(std::make_pair(MetricName(name, path + "/median"),
+                                     Percentile(frameTimes, 0.5)));
+    metrics.push_back(std::make_pair(MetricName(name, path + "/p95"),
+                                     Percentile(frameTimes, 0.95)));
+  }
+
+  // Pick along the diagonal, through the object and the background.
+  app->applyBuiltinDatasetCameraParameters(index);
+  TimeFrame(app, bytesUploaded);
+  std::vector<double> pickTimes;
+  for (int i = 0; i < numberOfPicks; ++i) {
+    int x = (viewWidth * (i + 1)) / (numberOfPicks + 1);
+    int y = (viewHeight * (i + 1)) / (numberOfPicks + 1);
+    double pickStart = CurrentTime();
+    app->benchmarkRenderer()->pickActor(x, y);
+    pickTimes.push_back(CurrentTime() - pickStart);
+  }
+  metrics.push_back(std::make_pair(MetricName(name, "pickTime/median"),
+                                   Percentile(pickTimes, 0.5)));
+
+  std::cout << "Dataset '" << name << "' done" << std::endl;
+}
+
+//----------------------------------------------------------------------------
+std::string EscapeJSON(const std::string& value)
+{
+  std::string escaped;
+  for (size_t i = 0; i < value.size(); ++i) {
+    if (value[i] == '"' || value[i] == '\\') {
+      escaped += '\\';
+    }
+    escaped += value[i];
+  }
+  return escaped;
+}
+
+//----------------------------------------------------------------------------
+std::string MetricsToJSON(const Metrics& metrics, bool pipelined)
+{
+  std::ostringstream json;
+  json.precision(9);
+  json << "{\n"
+       << "  \"renderer\": \"" << EscapeJSON(
+            reinterpret_cast<const char*>(glGetString(GL_RENDERER))) << "\",\n"
+       << "  \"viewSize\": [" << viewWidth << ", " << viewHeight << "],\n"
+       << "  \"pipelined\": " << (pipelined ? "true" : "false") << ",\n"
+       << "  \"metrics\": {\n";
+  for (size_t i = 0; i < metrics.size(); ++i) {
+    json << "    \"" << EscapeJSON(metrics[i].first) << "\": " << metrics[i].second
+         << (i + 1 < metrics.size() ? ",\n" : "\n");
+  }
+  json << "  }\n}\n";
+  return json.str();
+}
+
+//----------------------------------------------------------------------------
+// Reads the "metrics" object of a file written by MetricsToJSON(). Only
+// that format is understood, this is not a general JSON parser.
+bool ReadBaseline(const std::string& filename, std::map<std::string, double>& baseline)
+{
+  std::ifstream file(filename.c_str());
+  if (!file) {
+    return false;
+  }
+  std::stringstream buffer;
+  buffer << file.rdbuf();
+  std::string text = buffer.str();
+
+  size_t position = text.find("\"metrics\"");
+  if (position == std::string::npos) {
+    return false;
+  }
+  position = text.find('{', position);
+  size_t end = text.find('}', position);
+
+  while (true) {
+    size_t keyStart = text.find('"', position + 1);
+    if (position == std::string::npos || keyStart == std::string::npos ||
+        keyStart > end) {
+      break;
+    }
+    std::string key;
+    size_t i = keyStart + 1;
+    for (; i < text.size() && text[i] != '"'; ++i) {
+      if (text[i] == '\\' && i + 1 < text.size()) {
+        ++i;
+      }
+      key += text[i];
+    }
+    size_t colon = text.find(':', i);
+    if (colon == std::string::npos || colon > end) {
+      break;
+    }
+    baseline[key] = atof(text.c_str() + colon + 1);
+    position = colon;
+  }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+// Every metric is a time or a size, so only values that grew beyond the
+// tolerance count as regressions. Metrics missing from either side are
+// ignored, so that datasets can be added or skipped.
+bool CheckBaseline(const Metrics& metrics, const std::map<std::string, double>& baseline,
+                   double tolerance)
+{
+  bool passed = true;
+  for (size_t i = 0; i < metrics.size(); ++i) {
+    std::map<std::string, double>::const_iterator itr = baseline.find(metrics[i].first);
+    if (itr == baseline.end() || itr->second <= 0.0) {
+      continue;
+    }
+    double limit = itr->second * (1.0 + tolerance);
+    if (metrics[i].second > limit) {
+      std::cout << "Regression in '" << metrics[i].first << "': " << metrics[i].second
+                << " exceeds baseline " << itr->second << " by more than "
+                << tolerance * 100.0 << "%" << std::endl;
+      passed = false;
+    }
+  }
+  return passed;
+}
+
+//----------------------------------------------------------------------------
+bool ParseOptions(int argc, char* argv[], vesBenchmarkOptions& options)
+{
+  if (argc < 2) {
+    printf("Usage: %s <path to VES source directory> [--output file.json]"
+           " [--baseline file.json] [--tolerance fraction] [--pipelined]\n", argv[0]);
+    return false;
+  }
+
+  options.SourceDirectory = argv[1];
+  for (int i = 2; i < argc; ++i) {
+    if (!strcmp(argv[i], "--pipelined")) {
+      options.Pipelined = true;
+    }
+    else if (i + 1 == argc) {
+      printf("Missing value for option: %s\n", argv[i]);
+      return false;
+    }
+    else if (!strcmp(argv[i], "--output")) {
+      options.OutputFile = argv[++i];
+    }
+    else if (!strcmp(argv[i], "--baseline")) {
+      options.BaselineFile = argv[++i];
+    }
+    else if (!strcmp(argv[i], "--tolerance")) {
+      options.Tolerance = atof(argv[++i]);
+    }
+    else {
+      printf("Unknown option: %s\n", argv[i]);
+      return false;
+    }
+  }
+  return true;
+}
+
+}; // end namespace
+//----------------------------------------------------------------------------
+
+
+int
+main(int argc, char *argv[])
+{
+  vesBenchmarkOptions options;
+  if (!ParseOptions(argc, argv, options)) {
+    return -1;
+  }
+
+  vesHeadlessContext context;
+  if (!context.initialize(viewWidth, viewHeight)) {
+    return -1;
+  }
+
+  printf("GL_RENDERER = %s\n", (const char*) glGetString(GL_RENDERER));
+
+  Metrics metrics;
+  unsigned long bytesUploaded = 0;
+  {
+    vesBenchmarkApp app;
+    app.resizeView(viewWidth, viewHeight);
+    app.benchmarkRenderer()->setPipelined(options.Pipelined);
+
+    for (int i = 0; i < app.numberOfBuiltinDatasets(); ++i) {
+      // Needs a server to connect to.
+      if (app.builtinDatasetFilename(i) == "pvweb") {
+        continue;
+      }
+      BenchmarkDataset(&app, options, i, metrics, bytesUploaded);
+    }
+  }
+
+  metrics.push_back(std::make_pair(std::string("peakResidentBytes"), PeakResidentBytes()));
+  metrics.push_back(std::make_pair(std::string("gpuBytesUploaded"),
+                                   static_cast<double>(bytesUploaded)));
+
+  std::string json = MetricsToJSON(metrics, options.Pipelined);
+  if (options.OutputFile.empty()) {
+    std::cout << json;
+  }
+  else {
+    std::ofstream file(options.OutputFile.c_str());
+    file << json;
+    std::cout << "Wrote " << options.OutputFile << std::endl;
+  }
+
+  bool passed = true;
+  if (!options.BaselineFile.empty()) {
+    std::map<std::string, double> baseline;
+    if (!ReadBaseline(options.BaselineFile, baseline)) {
+      std::cout << "Could not read baseline: " << options.BaselineFile << std::endl;
+      passed = false;
+    }
+    else {
+      passed = CheckBaseline(metrics, baseline, options.Tolerance);
+    }
+  }
+
+  return passed ? 0 : 1;
+}
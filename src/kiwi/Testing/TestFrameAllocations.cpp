@@ -0,0 +1,178 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+
+// Checks that rendering does not allocate once a scene has settled. Every
+// builtin dataset is loaded into a headless KiwiViewer and orbited for a few
+// frames, which upload the geometry, compile the shaders and grow the
+// render stage and the frame arena. The frames after that must not make a
+// single heap allocation on the rendering thread. Only C++ allocations are
+// counted, those of the GL driver are out of our hands, and so are those of
+// background threads like the isosurface extractor; the triangle sorter's
+// worker does not allocate either once its buffers circulate.
+
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <string>
+
+#include <vesKiwiViewerApp.h>
+#include <vesSetGet.h>
+
+#include <unistd.h>
+
+#include <GLES2/gl2.h>
+
+#include "vesHeadlessTesting.h"
+
+//----------------------------------------------------------------------------
+namespace {
+
+const int viewWidth = 400;
+const int viewHeight = 300;
+const int warmUpFrames = 10;
+const int measuredFrames = 30;
+const int settleFrames = 500;
+
+// Set by the rendering thread for itself only.
+__thread bool countAllocations = false;
+__thread unsigned long numberOfAllocations = 0;
+
+//----------------------------------------------------------------------------
+void* CountedAllocate(size_t size)
+{
+  if (countAllocations) {
+    ++numberOfAllocations;
+  }
+  void* memory = malloc(size ? size : 1);
+  if (!memory) {
+    throw std::bad_alloc();
+  }
+  return memory;
+}
+
+//----------------------------------------------------------------------------
+// Orbits the camera, the gesture is applied by the next render.
+void RenderFrame(vesKiwiViewerApp* app)
+{
+  app->handleSingleTouchPanGesture(viewWidth / 60.0, viewHeight / 120.0);
+  app->render();
+}
+
+//----------------------------------------------------------------------------
+bool TestDataset(vesKiwiViewerApp* app, const std::string& sourceDirectory, int index)
+{
+  std::string name = app->builtinDatasetName(index);
+  std::string filename = BuiltinDatasetPath(sourceDirectory,
+                                            app->builtinDatasetFilename(index));
+
+  if (!app->loadDataset(filename)) {
+    std::cout << "Could not load dataset '" << name << "': "
+              << app->loadDatasetErrorMessage() << std::endl;
+    return false;
+  }
+  app->applyBuiltinDatasetCameraParameters(index);
+
+  for (int i = 0; i < warmUpFrames; ++i) {
+    RenderFrame(app);
+  }
+
+  // Let background work, like the isosurface of the image datasets, land.
+  for (int i = 0; i < settleFrames && app->isRenderNeeded(); ++i) {
+    app->render();
+    usleep(10000);
+  }
+  glFinish();
+
+  numberOfAllocations = 0;
+  countAllocations = true;
+  for (int i = 0; i < measuredFrames; ++i) {
+    RenderFrame(app);
+  }
+  countAllocations = false;
+
+  std::cout << "Dataset '" << name << "': " << numberOfAllocations
+            << " allocations in " << measuredFrames << " frames" << std::endl;
+  return numberOfAllocations == 0;
+}
+
+}; // end namespace
+
+//----------------------------------------------------------------------------
+void* operator new(size_t size)
+{
+  return CountedAllocate(size);
+}
+
+//----------------------------------------------------------------------------
+void* operator new[](size_t size)
+{
+  return CountedAllocate(size);
+}
+
+//----------------------------------------------------------------------------
+void operator delete(void* memory) throw()
+{
+  free(memory);
+}
+
+//----------------------------------------------------------------------------
+void operator delete[](void* memory) throw()
+{
+  free(memory);
+}
+
+//----------------------------------------------------------------------------
+
+
+int
+main(int argc, char *argv[])
+{
+  if (argc < 2) {
+    printf("Usage: %s <path to VES source directory>\n", argv[0]);
+    return -1;
+  }
+
+  vesHeadlessContext context;
+  if (!context.initialize(viewWidth, viewHeight)) {
+    return -1;
+  }
+
+  bool passed = true;
+  {
+    vesKiwiViewerApp app;
+    app.resizeView(viewWidth, viewHeight);
+
+    // Switching resolutions resizes offscreen buffers, keep it steady.
+    app.setInteractiveResolutionScaling(false);
+
+    for (int i = 0; i < app.numberOfBuiltinDatasets(); ++i) {
+      // Needs a server to connect to.
+      if (app.builtinDatasetFilename(i) == "pvweb") {
+        continue;
+      }
+      if (!TestDataset(&app, argv[1], i)) {
+        passed = false;
+      }
+    }
+  }
+
+  return passed ? 0 : 1;
+}
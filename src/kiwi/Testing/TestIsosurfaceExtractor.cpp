@@ -0,0 +1,267 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+
+// Extracts a sphere from a small image whose scalars fall off with the
+// distance from its center and checks that the surface is closed and
+// consistently wound, faces outwards and lies on the analytic radius, that
+// any number of threads extracts the same triangles, and that only the last
+// of several background requests is handed over.
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <map>
+#include <utility>
+#include <vector>
+
+#include <vesGeometryData.h>
+#include <vesKiwiIsosurfaceExtractor.h>
+#include <vesSetGet.h>
+#include <vesSourceData.h>
+#include <vesVertexAttributeKeys.h>
+
+#include <vtkImageData.h>
+#include <vtkSmartPointer.h>
+
+#include <unistd.h>
+
+//----------------------------------------------------------------------------
+namespace {
+
+const int dimension = 24;
+const double radius = 0.6;
+
+typedef std::vector<float> Point;
+typedef std::vector<float> Triangle;
+
+//----------------------------------------------------------------------------
+// Image over [-1, 1]^3 whose scalars are radius minus the distance from the
+// origin, so they grow towards the inside of the sphere at isovalue 0.
+vtkSmartPointer<vtkImageData> CreateSphereImage()
+{
+  const double spacing = 2.0 / (dimension - 1);
+  vtkSmartPointer<vtkImageData> image = vtkSmartPointer<vtkImageData>::New();
+  image->SetDimensions(dimension, dimension, dimension);
+  image->SetOrigin(-1.0, -1.0, -1.0);
+  image->SetSpacing(spacing, spacing, spacing);
+  image->SetScalarTypeToFloat();
+  image->SetNumberOfScalarComponents(1);
+  image->AllocateScalars();
+
+  float* scalars = static_cast<float*>(image->GetScalarPointer());
+  for (int k = 0; k < dimension; ++k) {
+    for (int j = 0; j < dimension; ++j) {
+      for (int i = 0; i < dimension; ++i) {
+        const double x = -1.0 + i * spacing;
+        const double y = -1.0 + j * spacing;
+        const double z = -1.0 + k * spacing;
+        *scalars++ = static_cast<float>(radius - std::sqrt(x * x + y * y + z * z));
+      }
+    }
+  }
+  return image;
+}
+
+//----------------------------------------------------------------------------
+Point ToPoint(const vesVector3f& position)
+{
+  return Point(position.data(), position.data() + 3);
+}
+
+//----------------------------------------------------------------------------
+// Return the triangles of all pieces as their three corner positions, each
+// rotated to start at its smallest corner so that the winding is kept, and
+// sorted. Slabs share the vertices on their boundaries by position only.
+std::vector<Triangle> Triangles(const vesKiwiIsosurfaceExtractor::Pieces& pieces)
+{
+  std::vector<Triangle> triangles;
+  for (size_t p = 0; p < pieces.size(); ++p) {
+    vesSourceDataP3N3f::Ptr sourceData = std::tr1::static_pointer_cast<vesSourceDataP3N3f>(
+      pieces[p]->sourceData(vesVertexAttributeKeys::Position));
+    const std::vector<vesVertexDataP3N3f>& vertices = sourceData->arrayReference();
+    vesPrimitive::Ptr primitive = pieces[p]->triangles();
+
+    for (unsigned int i = 0; i + 2 < primitive->numberOfIndices(); i += 3) {
+      Point corners[3];
+      for (int c = 0; c < 3; ++c) {
+        corners[c] = ToPoint(vertices[primitive->at(i + c)].m_position);
+      }
+      const int first = static_cast<int>(std::min_element(corners, corners + 3) - corners);
+      Triangle triangle;
+      for (int c = 0; c < 3; ++c) {
+        const Point& corner = corners[(first + c) % 3];
+        triangle.insert(triangle.end(), corner.begin(), corner.end());
+      }
+      triangles.push_back(triangle);
+    }
+  }
+  std::sort(triangles.begin(), triangles.end());
+  return triangles;
+}
+
+//----------------------------------------------------------------------------
+bool Check(bool condition, const char* message)
+{
+  if (!condition) {
+    std::cout << message << std::endl;
+  }
+  return condition;
+}
+
+//----------------------------------------------------------------------------
+// Every directed edge must be matched by exactly one edge running the other
+// way, which holds for a closed surface whose triangles are all wound alike.
+bool IsClosedAndConsistentlyWound(const std::vector<Triangle>& triangles)
+{
+  std::map<std::pair<Point, Point>, int> edges;
+  for (size_t t = 0; t < triangles.size(); ++t) {
+    for (int c = 0; c < 3; ++c) {
+      const Point from(triangles[t].begin() + 3 * c, triangles[t].begin() + 3 * c + 3);
+      const int next = 3 * ((c + 1) % 3);
+      const Point to(triangles[t].begin() + next, triangles[t].begin() + next + 3);
+      ++edges[std::make_pair(from, to)];
+    }
+  }
+
+  for (std::map<std::pair<Point, Point>, int>::const_iterator itr = edges.begin();
+       itr != edges.end(); ++itr) {
+    std::map<std::pair<Point, Point>, int>::const_iterator opposite =
+      edges.find(std::make_pair(itr->first.second, itr->first.first));
+    if (itr->second != 1 || opposite == edges.end() || opposite->second != 1) {
+      return false;
+    }
+  }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool TestSphere(const vesKiwiIsosurfaceExtractor::Pieces& pieces)
+{
+  const std::vector<Triangle> triangles = Triangles(pieces);
+  bool passed = Check(!triangles.empty(), "no triangles were extracted");
+  passed &= Check(IsClosedAndConsistentlyWound(triangles),
+                  "the sphere is not closed or not consistently wound");
+
+  // Linear interpolation of the distance places the vertices a little inside.
+  const float tolerance = 0.01f;
+  bool onSphere = true;
+  bool outwards = true;
+  for (size_t p = 0; p < pieces.size(); ++p) {
+    vesSourceDataP3N3f::Ptr sourceData = std::tr1::static_pointer_cast<vesSourceDataP3N3f>(
+      pieces[p]->sourceData(vesVertexAttributeKeys::Position));
+    const std::vector<vesVertexDataP3N3f>& vertices = sourceData->arrayReference();
+    passed &= Check(vertices.size() <= 65536, "a piece has more vertices than its indices address");
+
+    for (size_t i = 0; i < vertices.size(); ++i) {
+      const vesVector3f& position = vertices[i].m_position;
+      onSphere &= std::fabs(position.norm() - radius) < tolerance;
+      outwards &= vertices[i].m_normal.dot(position.normalized()) > 0.99f;
+    }
+  }
+  passed &= Check(onSphere, "a vertex is off the sphere");
+  passed &= Check(outwards, "a vertex normal does not point outwards");
+
+  for (size_t t = 0; t < triangles.size(); ++t) {
+    const vesVector3f a(&triangles[t][0]);
+    const vesVector3f b(&triangles[t][3]);
+    const vesVector3f c(&triangles[t][6]);
+    if ((b - a).cross(c - a).dot(a + b + c) <= 0.0f) {
+      passed &= Check(false, "a triangle faces inwards");
+      break;
+    }
+  }
+  return passed;
+}
+
+//----------------------------------------------------------------------------
+bool TestThreads(vtkImageData* image)
+{
+  const vesKiwiIsosurfaceExtractor::Pieces serial = vesKiwiIsosurfaceExtractor::extract(image, 0.0, 1);
+  bool passed = TestSphere(serial);
+
+  for (int numberOfThreads = 2; numberOfThreads <= 8; numberOfThreads *= 2) {
+    const vesKiwiIsosurfaceExtractor::Pieces parallel =
+      vesKiwiIsosurfaceExtractor::extract(image, 0.0, numberOfThreads);
+    passed &= Check(Triangles(parallel) == Triangles(serial),
+                    "threads extract different triangles than a single thread");
+  }
+  return passed;
+}
+
+//----------------------------------------------------------------------------
+// Wait up to five seconds for the extractor to hand over an isosurface.
+bool WaitForIsosurface(vesKiwiIsosurfaceExtractor& extractor,
+                       vesKiwiIsosurfaceExtractor::Pieces& pieces, double& isovalue)
+{
+  for (int i = 0; i < 500; ++i) {
+    if (extractor.takeIsosurface(pieces, isovalue)) {
+      return true;
+    }
+    usleep(10000);
+  }
+  return false;
+}
+
+//----------------------------------------------------------------------------
+bool TestRequests(vtkImageData* image)
+{
+  vesKiwiIsosurfaceExtractor extractor;
+  extractor.setNumberOfThreads(2);
+  extractor.setImageData(image);
+
+  // The first two requests are superseded before they can be taken.
+  extractor.requestIsosurface(0.3);
+  extractor.requestIsosurface(-0.2);
+  extractor.requestIsosurface(0.0);
+
+  vesKiwiIsosurfaceExtractor::Pieces pieces;
+  double isovalue = 1.0;
+  bool passed = Check(WaitForIsosurface(extractor, pieces, isovalue), "no isosurface was handed over");
+  passed &= Check(isovalue == 0.0, "a superseded isosurface was handed over");
+  passed &= Check(Triangles(pieces) == Triangles(vesKiwiIsosurfaceExtractor::extract(image, 0.0, 1)),
+                  "the background isosurface differs from the one extracted in place");
+  passed &= Check(!extractor.isBusy() && !extractor.takeIsosurface(pieces, isovalue),
+                  "the superseded requests were not cancelled");
+
+  // Setting the image cancels the request in progress.
+  extractor.requestIsosurface(0.3);
+  extractor.setImageData(image);
+  passed &= Check(!extractor.isBusy(), "setting the image did not cancel the request");
+
+  return passed;
+}
+
+}; // end namespace
+//----------------------------------------------------------------------------
+
+
+int
+main(int argc, char *argv[])
+{
+  vesNotUsed(argc);
+  vesNotUsed(argv);
+
+  vtkSmartPointer<vtkImageData> image = CreateSphereImage();
+  bool passed = TestThreads(image);
+  passed &= TestRequests(image);
+
+  std::cout << (passed ? "Passed" : "Failed") << std::endl;
+  return passed ? 0 : 1;
+}
@@ -0,0 +1,200 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+
+// Checks that pipelined rendering draws what serial rendering draws. Every
+// builtin dataset is loaded into two headless KiwiViewers, one of them
+// pipelined, left to settle and then orbited once. A pipelined renderer
+// draws the frame culled by the previous render(), so it gets one extra
+// frame to catch up; after that both must report the same render leaves
+// and draw calls and must have drawn the same pixels.
+
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <vesKiwiViewerApp.h>
+#include <vesRenderer.h>
+#include <vesRenderStatistics.h>
+#include <vesSetGet.h>
+
+#include <unistd.h>
+
+#include <GLES2/gl2.h>
+
+#include "vesHeadlessTesting.h"
+
+//----------------------------------------------------------------------------
+namespace {
+
+const int viewWidth = 400;
+const int viewHeight = 300;
+const int settleFrames = 500;
+// Allowed difference per color channel, for the rounding of the rasterizer.
+const int pixelTolerance = 2;
+
+//----------------------------------------------------------------------------
+class vesPipelinedTestApp : public vesKiwiViewerApp
+{
+public:
+
+  // Pipelining is switched through the renderer, which the app keeps protected.
+  void setPipelined(bool pipelined)
+  {
+    this->renderer()->setPipelined(pipelined);
+  }
+
+  const vesRenderStatistics& statistics() const
+  {
+    return this->renderer()->statistics();
+  }
+};
+
+//----------------------------------------------------------------------------
+class vesFrameCapture
+{
+public:
+
+  vesFrameCapture() : RenderLeaves(0), DrawCalls(0)
+  {
+  }
+
+  int RenderLeaves;
+  int DrawCalls;
+  std::vector<unsigned char> Pixels;
+};
+
+//----------------------------------------------------------------------------
+bool CaptureDataset(const std::string& sourceDirectory, int index, bool pipelined,
+                    vesFrameCapture& capture)
+{
+  vesPipelinedTestApp app;
+  app.resizeView(viewWidth, viewHeight);
+  app.setPipelined(pipelined);
+
+  // Both apps must render at the same resolution.
+  app.setInteractiveResolutionScaling(false);
+
+  std::string filename = BuiltinDatasetPath(sourceDirectory,
+                                            app.builtinDatasetFilename(index));
+  if (!app.loadDataset(filename)) {
+    std::cout << "Could not load dataset '" << app.builtinDatasetName(index)
+              << "': " << app.loadDatasetErrorMessage() << std::endl;
+    return false;
+  }
+  app.applyBuiltinDatasetCameraParameters(index);
+
+  // Let background work, like the isosurface of the image datasets, land.
+  for (int i = 0; i < settleFrames && app.isRenderNeeded(); ++i) {
+    app.render();
+    usleep(10000);
+  }
+
+  app.handleSingleTouchPanGesture(viewWidth / 60.0, viewHeight / 120.0);
+  app.render();
+  if (pipelined) {
+    // The gesture is culled by the first render() and drawn by this one.
+    if (!app.isRenderNeeded()) {
+      std::cout << "Pipelined renderer does not need to render the pending frame"
+                << std::endl;
+      return false;
+    }
+    app.render();
+  }
+
+  capture.RenderLeaves = app.statistics().m_renderLeaves;
+  capture.DrawCalls = app.statistics().m_drawCalls;
+  capture.Pixels.resize(viewWidth * viewHeight * 4);
+  glReadPixels(0, 0, viewWidth, viewHeight, GL_RGBA, GL_UNSIGNED_BYTE, &capture.Pixels[0]);
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool TestDataset(const std::string& sourceDirectory, int index, const std::string& name)
+{
+  vesFrameCapture serial;
+  vesFrameCapture pipelined;
+  if (!CaptureDataset(sourceDirectory, index, false, serial) ||
+      !CaptureDataset(sourceDirectory, index, true, pipelined)) {
+    return false;
+  }
+
+  bool passed = true;
+  if (serial.RenderLeaves != pipelined.RenderLeaves ||
+      serial.DrawCalls != pipelined.DrawCalls) {
+    std::cout << "Dataset '" << name << "': serial frame has "
+              << serial.RenderLeaves << " render leaves and " << serial.DrawCalls
+              << " draw calls, pipelined frame " << pipelined.RenderLeaves
+              << " and " << pipelined.DrawCalls << std::endl;
+    passed = false;
+  }
+
+  size_t differentPixels = 0;
+  for (size_t i = 0; i < serial.Pixels.size(); i += 4) {
+    for (size_t c = 0; c < 4; ++c) {
+      if (abs(serial.Pixels[i + c] - pipelined.Pixels[i + c]) > pixelTolerance) {
+        ++differentPixels;
+        break;
+      }
+    }
+  }
+  if (differentPixels) {
+    std::cout << "Dataset '" << name << "': " << differentPixels
+              << " pixels differ between the serial and the pipelined frame" << std::endl;
+    passed = false;
+  }
+
+  std::cout << "Dataset '" << name << "': " << serial.RenderLeaves << " render leaves, "
+            << serial.DrawCalls << " draw calls" << std::endl;
+  return passed;
+}
+
+}; // end namespace
+//----------------------------------------------------------------------------
+
+
+int
+main(int argc, char *argv[])
+{
+  if (argc < 2) {
+    printf("Usage: %s <path to VES source directory>\n", argv[0]);
+    return -1;
+  }
+
+  vesHeadlessContext context;
+  if (!context.initialize(viewWidth, viewHeight)) {
+    return -1;
+  }
+
+  bool passed = true;
+  vesKiwiViewerApp app;
+  for (int i = 0; i < app.numberOfBuiltinDatasets(); ++i) {
+    // Needs a server to connect to.
+    if (app.builtinDatasetFilename(i) == "pvweb") {
+      continue;
+    }
+    if (!TestDataset(argv[1], i, app.builtinDatasetName(i))) {
+      passed = false;
+    }
+  }
+
+  return passed ? 0 : 1;
+}
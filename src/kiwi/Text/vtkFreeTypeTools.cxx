@@ -1229,3 +1229,66 @@ inline FT_Bitmap* vtkFreeTypeTools::GetBitmap(FT_UInt32 c,
 
   return bitmap;
 }
+
+//----------------------------------------------------------------------------
+bool vtkFreeTypeTools::GetGlyphBitmap(vtkTextProperty *tprop, FT_UInt32 c,
+                                      FT_UInt *gindex, FT_Bitmap **bitmap,
+                                      int bearing[2], int *advance)
+{
+  if (!tprop || !gindex || !bitmap || !bearing || !advance)
+    {
+    vtkErrorMacro(<< "Wrong parameters, one of them is NULL");
+    return false;
+    }
+
+  unsigned long tprop_cache_id;
+  this->MapTextPropertyToId(tprop, &tprop_cache_id);
+
+  FT_BitmapGlyph bitmap_glyph;
+  *bitmap = this->GetBitmap(c, tprop_cache_id, tprop->GetFontSize(), *gindex,
+                            bitmap_glyph);
+  if (!*bitmap)
+    {
+    return false;
+    }
+
+  bearing[0] = bitmap_glyph->left;
+  bearing[1] = bitmap_glyph->top;
+  *advance = (bitmap_glyph->root.advance.x + 0x8000) >> 16;
+  return true;
+}
+
+//----------------------------------------------------------------------------
+int vtkFreeTypeTools::GetKerning(vtkTextProperty *tprop,
+                                 FT_UInt previous_gindex, FT_UInt gindex)
+{
+  if (!previous_gindex || !gindex)
+    {
+    return 0;
+    }
+
+  unsigned long tprop_cache_id;
+  FT_Face face;
+  bool face_has_kerning = false;
+  if (!this->GetFace(tprop, tprop_cache_id, face, face_has_kerning) ||
+      !face_has_kerning)
+    {
+    return 0;
+    }
+
+  // The face is shared with the glyph cache, make sure the kerning is
+  // expressed at the requested font size.
+  FT_Size size;
+  if (!this->GetSize(tprop_cache_id, tprop->GetFontSize(), &size))
+    {
+    return 0;
+    }
+
+  FT_Vector kerning_delta;
+  if (FT_Get_Kerning(face, previous_gindex, gindex, ft_kerning_default,
+                     &kerning_delta))
+    {
+    return 0;
+    }
+  return kerning_delta.x >> 6;
+}
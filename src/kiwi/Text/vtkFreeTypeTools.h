@@ -105,6 +105,24 @@ public:
   bool RenderString(vtkTextProperty *tprop, const vtkUnicodeString& str,
                     vtkImageData *data);
 
+  // Description:
+  // Given a text property and a character, get its glyph index and its
+  // rasterized glyph from the cache. 'bearing' receives the horizontal
+  // distance from the pen to the left of the bitmap and the vertical distance
+  // from the baseline to its top, 'advance' the horizontal pen advance, all
+  // in pixels. The bitmap is owned by the cache and is only valid until the
+  // next glyph request. Return true on success, false otherwise (e.g. if the
+  // character is not in the face).
+  bool GetGlyphBitmap(vtkTextProperty *tprop, FT_UInt32 c, FT_UInt *gindex,
+                      FT_Bitmap **bitmap, int bearing[2], int *advance);
+
+  // Description:
+  // Given a text property and the glyph indices of two consecutive
+  // characters, get the horizontal kerning in pixels to add to the pen
+  // position between them. Return 0 if the face has no kerning information.
+  int GetKerning(vtkTextProperty *tprop, FT_UInt previous_gindex,
+                 FT_UInt gindex);
+
   // Description:
   // Given a text property 'tprop', get its unique ID in our cache framework.
   // In the same way, given a unique ID in our cache, retrieve the
@@ -0,0 +1,195 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+
+// Encodes a mesh into the compressed .vesz format that vesKiwiDataLoader
+// reads with vesMeshCodec, for serving smaller downloads. Any file the
+// viewer opens as polydata can be encoded. The output is decoded again to
+// check it and the sizes and the decode time are reported.
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <sys/time.h>
+
+#include <vesGeometryData.h>
+#include <vesKiwiDataLoader.h>
+#include <vesKiwiPolyDataRepresentation.h>
+#include <vesMeshCodec.h>
+#include <vesSetGet.h>
+
+#include <vtkDataSet.h>
+#include <vtkPolyData.h>
+
+//----------------------------------------------------------------------------
+namespace {
+
+//----------------------------------------------------------------------------
+double Seconds()
+{
+  timeval time;
+  gettimeofday(&time, 0);
+  return time.tv_sec + time.tv_usec * 1e-6;
+}
+
+//----------------------------------------------------------------------------
+size_t UncompressedSize(vesGeometryData& geometryData)
+{
+  size_t size = 0;
+  for (unsigned int i = 0; i < geometryData.numberOfSources(); ++i) {
+    vesSharedPtr<vesSourceData> source = geometryData.source(i);
+    size += source->sizeOfArray() * source->sizeOfElement();
+  }
+  for (unsigned int i = 0; i < geometryData.numberOfPrimitiveTypes(); ++i) {
+    size += geometryData.primitive(i)->sizeInBytes();
+  }
+  return size;
+}
+
+//----------------------------------------------------------------------------
+void PrintUsage(const char* program)
+{
+  printf("Usage: %s [options] <input file> <output file.vesz>\n"
+         "Options set the quantization bits per attribute:\n"
+         "  --position-bits n            (default 14)\n"
+         "  --normal-bits n              (default 10, 0 recomputes normals when decoding)\n"
+         "  --texture-coordinate-bits n  (default 12)\n"
+         "  --color-bits n               (default 8)\n"
+         "  --scalar-bits n              (default 16)\n", program);
+}
+
+//----------------------------------------------------------------------------
+bool ParseOptions(int argc, char* argv[], vesMeshCodec& codec,
+                  std::string& inputFile, std::string& outputFile)
+{
+  int i = 1;
+  for (; i + 1 < argc && !strncmp(argv[i], "--", 2); i += 2) {
+    int key;
+    if (!strcmp(argv[i], "--position-bits")) {
+      key = vesVertexAttributeKeys::Position;
+    }
+    else if (!strcmp(argv[i], "--normal-bits")) {
+      key = vesVertexAttributeKeys::Normal;
+    }
+    else if (!strcmp(argv[i], "--texture-coordinate-bits")) {
+      key = vesVertexAttributeKeys::TextureCoordinate;
+    }
+    else if (!strcmp(argv[i], "--color-bits")) {
+      key = vesVertexAttributeKeys::Color;
+    }
+    else if (!strcmp(argv[i], "--scalar-bits")) {
+      key = vesVertexAttributeKeys::Scalar;
+    }
+    else {
+      printf("Unknown option: %s\n", argv[i]);
+      return false;
+    }
+    codec.setQuantizationBits(key, atoi(argv[i + 1]));
+  }
+
+  if (argc - i != 2) {
+    PrintUsage(argv[0]);
+    return false;
+  }
+  inputFile = argv[i];
+  outputFile = argv[i + 1];
+
+  if (!vesMeshCodec::canReadFile(outputFile)) {
+    printf("Error: the output file needs the .vesz extension\n");
+    return false;
+  }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+vesSharedPtr<vesGeometryData> LoadGeometryData(const std::string& filename)
+{
+  vesKiwiDataLoader dataLoader;
+  vesSharedPtr<vesGeometryData> geometryData = dataLoader.loadGeometryData(filename);
+  if (geometryData || !dataLoader.errorMessage().empty()) {
+    if (!geometryData) {
+      printf("Error: %s\n", dataLoader.errorMessage().c_str());
+    }
+    return geometryData;
+  }
+
+  vtkSmartPointer<vtkDataSet> dataSet = dataLoader.loadDataset(filename);
+  vtkPolyData* polyData = vtkPolyData::SafeDownCast(dataSet);
+  if (!polyData) {
+    printf("Error: %s\n", dataSet ? "Only polydata can be encoded"
+                                  : dataLoader.errorMessage().c_str());
+    return vesSharedPtr<vesGeometryData>();
+  }
+  return vesKiwiPolyDataRepresentation::convertPolyData(polyData);
+}
+
+}; // end namespace
+//----------------------------------------------------------------------------
+
+
+int
+main(int argc, char *argv[])
+{
+  vesMeshCodec codec;
+  std::string inputFile;
+  std::string outputFile;
+  if (!ParseOptions(argc, argv, codec, inputFile, outputFile)) {
+    return -1;
+  }
+
+  vesSharedPtr<vesGeometryData> geometryData = LoadGeometryData(inputFile);
+  if (!geometryData) {
+    return -1;
+  }
+
+  std::vector<unsigned char> encoded;
+  if (!codec.encode(*geometryData, encoded)) {
+    printf("Error: %s\n", codec.errorMessage().c_str());
+    return -1;
+  }
+
+  std::ofstream file(outputFile.c_str(), std::ios::binary);
+  file.write(reinterpret_cast<const char*>(&encoded[0]), encoded.size());
+  file.close();
+  if (!file) {
+    printf("Error: could not write %s\n", outputFile.c_str());
+    return -1;
+  }
+
+  const double start = Seconds();
+  vesSharedPtr<vesGeometryData> decoded = codec.decode(&encoded[0], encoded.size());
+  const double decodeTime = Seconds() - start;
+  if (!decoded) {
+    printf("Error: the encoded mesh does not decode: %s\n", codec.errorMessage().c_str());
+    return -1;
+  }
+
+  const size_t uncompressedSize = UncompressedSize(*geometryData);
+  printf("Wrote %s\n", outputFile.c_str());
+  printf("  vertices:     %u\n", decoded->sourceData(vesVertexAttributeKeys::Position)->sizeOfArray());
+  printf("  uncompressed: %lu bytes\n", static_cast<unsigned long>(uncompressedSize));
+  printf("  encoded:      %lu bytes (%.1fx smaller)\n", static_cast<unsigned long>(encoded.size()),
+         static_cast<double>(uncompressedSize) / encoded.size());
+  printf("  decode time:  %.1f ms\n", decodeTime * 1000.0);
+  return 0;
+}
@@ -5,12 +5,18 @@ set(headers
   vesKiwiDataConversionTools.h
   vesKiwiDataLoader.h
   vesKiwiDataRepresentation.h
+  vesKiwiGlyphAtlas.h
   vesKiwiImagePlaneDataRepresentation.h
   vesKiwiImageWidgetRepresentation.h
+  vesKiwiIsosurfaceExtractor.h
+  vesKiwiIsosurfaceRepresentation.h
+  vesKiwiLoadScheduler.h
+  vesKiwiOverlayBatch.h
   vesKiwiPlaneWidget.h
   vesKiwiPolyDataRepresentation.h
   vesKiwiText2DRepresentation.h
   vesKiwiViewerApp.h
+  vesKiwiVolumeRepresentation.h
   vesKiwiWidgetRepresentation.h
   )
 
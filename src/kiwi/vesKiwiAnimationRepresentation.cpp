@@ -26,8 +26,9 @@
 #include "vesActor.h"
 #include "vesShaderProgram.h"
 #include "vesTexture.h"
-#include "vesKiwiDataLoader.h"
 #include "vesKiwiDataConversionTools.h"
+#include "vesKiwiLoadScheduler.h"
+#include "vesKiwiOverlayBatch.h"
 #include "vesKiwiText2DRepresentation.h"
 #include "vesKiwiPolyDataRepresentation.h"
 
@@ -87,10 +88,8 @@ public:
   std::vector<vesKiwiDataRepresentation*> AllReps;
   std::vector<vesKiwiPolyDataRepresentation*> FrameReps;
 
-  vtkSmartPointer<vtkUnsignedCharArray> ColorTable;
-
   vesSharedPtr<vesShaderProgram> GeometryShader;
-  vesSharedPtr<vesShaderProgram> TextureShader;
+  vesSharedPtr<vesShaderProgram> ScalarColorMapShader;
 };
 
 //----------------------------------------------------------------------------
@@ -109,10 +108,10 @@ vesKiwiAnimationRepresentation::~vesKiwiAnimationRepresentation()
 void vesKiwiAnimationRepresentation::initializeWithShader(
   vesSharedPtr<vesShaderProgram> geometryShader, 
   vesSharedPtr<vesShaderProgram> textureShader,
-  vesSharedPtr<vesShaderProgram> gouraudTextureShader)
+  vesSharedPtr<vesShaderProgram> scalarColorMapShader)
 {
   this->Internal->GeometryShader = geometryShader;
-  this->Internal->TextureShader = gouraudTextureShader;
+  this->Internal->ScalarColorMapShader = scalarColorMapShader;
 
   this->Internal->TextRep = new vesKiwiText2DRepresentation();
   this->Internal->TextRep->initializeWithShader(textureShader);
@@ -127,68 +126,83 @@ void vesKiwiAnimationRepresentation::initializeWithShader(
 }
 
 //----------------------------------------------------------------------------
-void vesKiwiAnimationRepresentation::loadData(const std::string& filename)
+void vesKiwiAnimationRepresentation::setOverlayBatch(vesSharedPtr<vesKiwiOverlayBatch> batch)
 {
+  this->Internal->TextRep->setOverlayBatch(batch);
+  this->Internal->PlayRep->setOverlayBatch(batch);
+}
 
-  std::string dataDir = vtksys::SystemTools::GetFilenamePath(filename);
+//----------------------------------------------------------------------------
+namespace {
 
-  std::vector<std::string> filenames;
-  for (int i = 0; i < 44; ++i) {
-    std::stringstream str;
-    str << "can" << setfill ('0') << setw(4) << i << ".vtp";
-    filenames.push_back(str.str());
+class FrameJob : public vesKiwiLoadScheduler::Job
+{
+public:
+
+  FrameJob(const std::string& filename, const double scalarRange[2])
+    : vesKiwiLoadScheduler::Job(filename)
+  {
+    this->ScalarRange[0] = scalarRange[0];
+    this->ScalarRange[1] = scalarRange[1];
+  }
+
+protected:
+
+  virtual vesSharedPtr<vesGeometryData> convertPolyData(vtkPolyData* polyData)
+  {
+    // The color map caches its table while mapping values, so the frames
+    // loading concurrently each use their own.
+    vtkSmartPointer<vtkScalarsToColors> scalarsToColors =
+      vesKiwiDataConversionTools::GetBlackBodyRadiationColorMap(this->ScalarRange);
+    vesSharedPtr<vesGeometryData> geometryData =
+      vesKiwiPolyDataRepresentation::convertPolyData(polyData, scalarsToColors);
+
+    // The scalars are mapped on the GPU by the scalar color map shader.
+    vtkDataArray* scalars = vesKiwiDataConversionTools::FindScalarsArray(polyData);
+    assert(scalars);
+    vesKiwiDataConversionTools::SetVertexScalars(scalars, geometryData);
+    return geometryData;
   }
 
-  vesKiwiDataLoader dataLoader;
+  double ScalarRange[2];
+};
+
+} // end namespace
+
+//----------------------------------------------------------------------------
+void vesKiwiAnimationRepresentation::loadData(const std::string& filename)
+{
+
+  std::string dataDir = vtksys::SystemTools::GetFilenamePath(filename);
 
   double scalarRange[2] = {0.0, 6000.0};
   vtkSmartPointer<vtkScalarsToColors> scalarsToColors = vesKiwiDataConversionTools::GetBlackBodyRadiationColorMap(scalarRange);
 
-  int colorTableResolution = 256;
-  vtkNew<vtkDoubleArray> scalarRangeValues;
-  scalarRangeValues->SetNumberOfComponents(1);
-  scalarRangeValues->SetNumberOfTuples(colorTableResolution);
-  double scalarRangeDist = scalarRange[1] - scalarRange[0];
-  double colorTableScalarRangeStep = scalarRangeDist/(colorTableResolution-1);
-  for (int i = 0; i < colorTableResolution; ++i) {
-    double scalarRangeValue = scalarRange[0] + (i*colorTableScalarRangeStep);
-    scalarRangeValues->SetValue(i, scalarRangeValue);
+  // Frames are read and converted concurrently, a few at a time ahead of
+  // the one being added.
+  vesKiwiLoadScheduler scheduler;
+  for (int i = 0; i < 44; ++i) {
+    std::stringstream str;
+    str << "can" << setfill ('0') << setw(4) << i << ".vtp";
+    scheduler.addJob(vesKiwiLoadScheduler::Job::Ptr(
+      new FrameJob(dataDir + "/" + str.str(), scalarRange)));
   }
 
-  this->Internal->ColorTable = vesKiwiDataConversionTools::MapScalars(scalarRangeValues.GetPointer(), scalarsToColors);
-
-  for (size_t i = 0; i < filenames.size(); ++i) {
+  scheduler.start();
 
-    std::string modelFile = dataDir + "/" + filenames[i];
+  while (vesKiwiLoadScheduler::Job::Ptr job = scheduler.next()) {
 
-    vtkSmartPointer<vtkPolyData> polyData = vtkPolyData::SafeDownCast(dataLoader.loadDataset(modelFile));
-    if (!polyData) {
-      printf("Failed to read: %s\n", modelFile.c_str());
+    if (!job->isLoaded() || !job->geometryData()) {
+      printf("Failed to read: %s\n", job->filename().c_str());
       continue;
     }
 
     vesKiwiPolyDataRepresentation* rep = new vesKiwiPolyDataRepresentation();
     rep->initializeWithShader(this->Internal->GeometryShader);
-    rep->setPolyData(polyData, scalarsToColors);
+    rep->setGeometryData(job->geometryData());
 
-    vtkDataArray* scalars = vesKiwiDataConversionTools::FindScalarsArray(polyData);
-    assert(scalars);
-    const vtkIdType nTuples = scalars->GetNumberOfTuples();
-    vtkNew<vtkDoubleArray> tcoords;
-    tcoords->SetNumberOfComponents(2);
-    tcoords->SetNumberOfTuples(nTuples);
-    for (vtkIdType k = 0; k < nTuples; ++k) {
-      double scalarValue = scalars->GetComponent(k, 0);
-      double lookupTableValue = (scalarValue - scalarRange[0]) / (scalarRange[1] - scalarRange[0]);
-      lookupTableValue = lookupTableValue > 1.0 ? 1.0 : (lookupTableValue < 0.0 ? 0.0 : lookupTableValue);
-      tcoords->SetTuple2(k, lookupTableValue, 0);
-    }
-
-    rep->addTextureCoordinates(tcoords.GetPointer());
-
-    vesTexture::Ptr texture = vesTexture::Ptr(new vesTexture());
-    vesKiwiDataConversionTools::SetTextureData(this->Internal->ColorTable, texture, this->Internal->ColorTable->GetNumberOfTuples(), 1);
-    rep->setTexture(texture);
+    // All frames share the same lookup table texture.
+    rep->setColorMap(scalarsToColors, scalarRange);
 
     this->Internal->AllReps.push_back(rep);
     this->Internal->FrameReps.push_back(rep);
@@ -249,7 +263,7 @@ bool vesKiwiAnimationRepresentation::handleSingleTouchTap(int displayX, int disp
 
     vesShaderProgram::Ptr newShader = this->Internal->GeometryShader;
     if (this->Internal->FrameReps[0]->shaderProgram() == newShader) {
-      newShader = this->Internal->TextureShader;
+      newShader = this->Internal->ScalarColorMapShader;
     }
 
     for (size_t i = 0; i < this->Internal->FrameReps.size(); ++i) {
@@ -310,6 +324,12 @@ bool vesKiwiAnimationRepresentation::handleSingleTouchPanGesture(double deltaX,
   return true;
 }
 
+//----------------------------------------------------------------------------
+bool vesKiwiAnimationRepresentation::isRenderNeeded() const
+{
+  return this->Internal->PlayMode;
+}
+
 //----------------------------------------------------------------------------
 void vesKiwiAnimationRepresentation::willRender(vesSharedPtr<vesRenderer> renderer)
 {
@@ -333,8 +353,8 @@ void vesKiwiAnimationRepresentation::willRender(vesSharedPtr<vesRenderer> render
 
   int screenHeight = this->renderer()->height();
   double margin = 10;
-  vesVector2f textSize = this->Internal->PlayRep->textureSize();
-  this->Internal->PlayRep->setDisplayPosition(vesVector2f(margin, screenHeight - (margin + textSize[1])));
+  const int textHeight = this->Internal->PlayRep->textHeight();
+  this->Internal->PlayRep->setDisplayPosition(vesVector2f(margin, screenHeight - (margin + textHeight)));
 
 
   if (this->Internal->LastFrame != this->Internal->CurrentFrame) {
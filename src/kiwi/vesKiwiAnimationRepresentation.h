@@ -25,6 +25,7 @@
 #include "vesKiwiWidgetRepresentation.h"
 
 class vesShaderProgram;
+class vesKiwiOverlayBatch;
 class vesKiwiPolyDataRepresentation;
 
 class vesKiwiAnimationRepresentation : public vesKiwiWidgetRepresentation
@@ -37,13 +38,17 @@ public:
 
   void initializeWithShader(vesSharedPtr<vesShaderProgram> geometryShader, 
     vesSharedPtr<vesShaderProgram> textureShader,
-    vesSharedPtr<vesShaderProgram> gouraudTextureShader);
+    vesSharedPtr<vesShaderProgram> scalarColorMapShader);
 
   void loadData(const std::string& filename);
 
+  /// Draw the time and play labels with the other labels of \a batch.
+  void setOverlayBatch(vesSharedPtr<vesKiwiOverlayBatch> batch);
+
   virtual void addSelfToRenderer(vesSharedPtr<vesRenderer> renderer);
   virtual void removeSelfFromRenderer(vesSharedPtr<vesRenderer> renderer);
   virtual void willRender(vesSharedPtr<vesRenderer> renderer);
+  virtual bool isRenderNeeded() const;
 
   virtual int numberOfFacets();
   virtual int numberOfVertices();
@@ -20,7 +20,9 @@
 
 #include <vesKiwiBaseApp.h>
 #include <vesCamera.h>
+#include <vesFrameRateGovernor.h>
 #include <vesRenderer.h>
+#include <vesRenderStatistics.h>
 #include <vesSetGet.h>
 #include <vesUniform.h>
 #include <vesVertexAttribute.h>
@@ -31,6 +33,8 @@
 #include <vesProjectionUniform.h>
 #include <vesVertexAttributeKeys.h>
 
+#include <vtkTimerLog.h>
+
 #include <cassert>
 #include <cmath>
 #include <vector>
@@ -42,20 +46,135 @@ public:
 
   vesInternal()
   {
+    this->ResolutionScaling = false;
+    this->LastInteractionTime = 0.0;
+    this->LastRenderTime = 0.0;
+    this->LastRenderInteractive = false;
+    this->clearPendingGestures();
   }
 
   ~vesInternal()
   {
   }
 
+  void updateResolutionScale();
+
+  bool hasPendingGestures() const;
+  void clearPendingGestures();
+  void applyPendingGestures();
+
   vesSharedPtr<vesRenderer> Renderer;
 
+  bool ResolutionScaling;
+  vesFrameRateGovernor Governor;
+  double LastInteractionTime;
+  double LastRenderTime;
+  bool LastRenderInteractive;
+
+  // Camera motion of the gestures received since the last update.
+  double PendingAzimuth;
+  double PendingElevation;
+  double PendingDolly;
+  double PendingRoll;
+  bool HasPendingPan;
+  double PendingPan[4];
+
   std::vector< vesSharedPtr<vesShaderProgram> > ShaderPrograms;
   std::vector< vesSharedPtr<vesShader> > Shaders;
   std::vector< vesSharedPtr<vesUniform> > Uniforms;
   std::vector< vesSharedPtr<vesVertexAttribute> > VertexAttributes;
 };
 
+//----------------------------------------------------------------------------
+void vesKiwiBaseApp::vesInternal::updateResolutionScale()
+{
+  if (!this->ResolutionScaling) {
+    this->Renderer->setResolutionScale(1.0f);
+    return;
+  }
+
+  // Gestures come in at least this often while the user is interacting.
+  const double idleDelay = 0.25;
+
+  double currentTime = vtkTimerLog::GetUniversalTime();
+  bool interactive = currentTime - this->LastInteractionTime < idleDelay;
+
+  // Only the time between two interactive frames tells how fast frames can
+  // be rendered, anything longer is the view waiting for input.
+  if (interactive && this->LastRenderInteractive &&
+      currentTime - this->LastRenderTime < idleDelay) {
+    this->Governor.addFrameTime(currentTime - this->LastRenderTime,
+                                this->Renderer->resolutionScale());
+  }
+
+  this->Renderer->setResolutionScale(interactive ? this->Governor.scale() : 1.0f);
+  this->LastRenderTime = currentTime;
+  this->LastRenderInteractive = interactive;
+}
+
+//----------------------------------------------------------------------------
+bool vesKiwiBaseApp::vesInternal::hasPendingGestures() const
+{
+  return this->PendingAzimuth != 0.0 || this->PendingElevation != 0.0 ||
+    this->PendingDolly != 1.0 || this->PendingRoll != 0.0 || this->HasPendingPan;
+}
+
+//----------------------------------------------------------------------------
+void vesKiwiBaseApp::vesInternal::clearPendingGestures()
+{
+  this->PendingAzimuth = 0.0;
+  this->PendingElevation = 0.0;
+  this->PendingDolly = 1.0;
+  this->PendingRoll = 0.0;
+  this->HasPendingPan = false;
+}
+
+//----------------------------------------------------------------------------
+void vesKiwiBaseApp::vesInternal::applyPendingGestures()
+{
+  if (!this->hasPendingGestures()) {
+    return;
+  }
+
+  vesSharedPtr<vesRenderer> ren = this->Renderer;
+  vesSharedPtr<vesCamera> camera = ren->camera();
+
+  if (this->HasPendingPan) {
+    // calculate the focal depth so we'll know how far to move
+    vesVector3f viewFocus = camera->focalPoint();
+    vesVector3f viewPoint = camera->position();
+    vesVector3f viewFocusDisplay = ren->computeWorldToDisplay(viewFocus);
+    float focalDepth = viewFocusDisplay[2];
+
+    // map change into world coordinates
+    vesVector3f oldPickPoint = ren->computeDisplayToWorld(
+      vesVector3f(this->PendingPan[0], this->PendingPan[1], focalDepth));
+    vesVector3f newPickPoint = ren->computeDisplayToWorld(
+      vesVector3f(this->PendingPan[2], this->PendingPan[3], focalDepth));
+    vesVector3f motionVector = oldPickPoint - newPickPoint;
+
+    camera->setFocalPoint(viewFocus + motionVector);
+    camera->setPosition(viewPoint + motionVector);
+  }
+
+  if (this->PendingAzimuth != 0.0 || this->PendingElevation != 0.0) {
+    camera->azimuth(this->PendingAzimuth);
+    camera->elevation(this->PendingElevation);
+    camera->orthogonalizeViewUp();
+  }
+
+  if (this->PendingDolly != 1.0) {
+    camera->dolly(this->PendingDolly);
+  }
+
+  if (this->PendingRoll != 0.0) {
+    camera->roll(this->PendingRoll);
+    camera->orthogonalizeViewUp();
+  }
+
+  this->clearPendingGestures();
+}
+
 //----------------------------------------------------------------------------
 vesKiwiBaseApp::vesKiwiBaseApp()
 {
@@ -73,27 +192,40 @@ vesKiwiBaseApp::~vesKiwiBaseApp()
 std::tr1::shared_ptr<vesCamera> vesKiwiBaseApp::camera() const
 {
   assert(this->Internal->Renderer);
+  this->Internal->applyPendingGestures();
   return this->Internal->Renderer->camera();
 }
 
 //----------------------------------------------------------------------------
 vesSharedPtr<vesRenderer> vesKiwiBaseApp::renderer() const
 {
+  // Subclasses may look at the camera through the renderer.
+  this->Internal->applyPendingGestures();
   return this->Internal->Renderer;
 }
 
 //----------------------------------------------------------------------------
 void vesKiwiBaseApp::render()
 {
+  this->Internal->applyPendingGestures();
   this->willRender();
+  this->Internal->updateResolutionScale();
   this->Internal->Renderer->resetCameraClippingRange();
   this->Internal->Renderer->render();
   this->didRender();
 }
 
+//----------------------------------------------------------------------------
+bool vesKiwiBaseApp::isRenderNeeded() const
+{
+  return this->Internal->hasPendingGestures() || this->isResolutionReduced() ||
+    this->Internal->Renderer->isRenderNeeded();
+}
+
 //----------------------------------------------------------------------------
 void vesKiwiBaseApp::resizeView(int width, int height)
 {
+  this->Internal->applyPendingGestures();
   this->Internal->Renderer->resize(width, height, 1.0f);
 }
 
@@ -115,6 +247,7 @@ void vesKiwiBaseApp::resetView(const vesVector3f& viewDirection, const vesVector
 
   //
   // set direction to look from
+  this->Internal->clearPendingGestures();
   vesSharedPtr<vesRenderer> renderer = this->Internal->Renderer;
 
   renderer->camera()->setViewPlaneNormal(-viewDirection);
@@ -135,34 +268,29 @@ void vesKiwiBaseApp::resetView(const vesVector3f& viewDirection, const vesVector
 //----------------------------------------------------------------------------
 void vesKiwiBaseApp::handleTwoTouchPanGesture(double x0, double y0, double x1, double y1)
 {
-  // calculate the focal depth so we'll know how far to move
-  vesSharedPtr<vesRenderer> ren = this->Internal->Renderer;
-  std::tr1::shared_ptr<vesCamera> camera = ren->camera();
-  vesVector3f viewFocus = camera->focalPoint();
-  vesVector3f viewPoint = camera->position();
-  vesVector3f viewFocusDisplay = ren->computeWorldToDisplay(viewFocus);
-  float focalDepth = viewFocusDisplay[2];
-
-  // map change into world coordinates
-  vesVector3f oldPickPoint = ren->computeDisplayToWorld(vesVector3f(x0, y0, focalDepth));
-  vesVector3f newPickPoint = ren->computeDisplayToWorld(vesVector3f(x1, y1, focalDepth));
-  vesVector3f motionVector = oldPickPoint - newPickPoint;
+  this->interactionOccurred();
 
-  vesVector3f newViewFocus = viewFocus + motionVector;
-  vesVector3f newViewPoint = viewPoint + motionVector;
-  camera->setFocalPoint(newViewFocus);
-  camera->setPosition(newViewPoint);
+  // Consecutive pans chain up, so the combined motion goes from the start
+  // of the first to the end of the last one.
+  if (!this->Internal->HasPendingPan) {
+    this->Internal->HasPendingPan = true;
+    this->Internal->PendingPan[0] = x0;
+    this->Internal->PendingPan[1] = y0;
+  }
+  this->Internal->PendingPan[2] = x1;
+  this->Internal->PendingPan[3] = y1;
 }
 
 //----------------------------------------------------------------------------
 void vesKiwiBaseApp::handleSingleTouchPanGesture(double deltaX, double deltaY)
 {
+  this->interactionOccurred();
+
   //
   // Rotate camera
   // Based on vtkInteractionStyleTrackballCamera::Rotate().
   //
   vesSharedPtr<vesRenderer> ren = this->Internal->Renderer;
-  std::tr1::shared_ptr<vesCamera> camera = ren->camera();
 
   double delta_elevation = -20.0 / ren->height();
   double delta_azimuth   = -20.0 / ren->width();
@@ -172,9 +300,8 @@ void vesKiwiBaseApp::handleSingleTouchPanGesture(double deltaX, double deltaY)
   double rxf = deltaX * delta_azimuth * motionFactor;
   double ryf = deltaY * delta_elevation * motionFactor;
 
-  camera->azimuth(rxf);
-  camera->elevation(ryf);
-  camera->orthogonalizeViewUp();
+  this->Internal->PendingAzimuth += rxf;
+  this->Internal->PendingElevation += ryf;
 }
 
 
@@ -214,15 +341,20 @@ void vesKiwiBaseApp::handleSingleTouchDown(int displayX, int displayY)
 //----------------------------------------------------------------------------
 void vesKiwiBaseApp::handleTwoTouchPinchGesture(double scale)
 {
-  this->Internal->Renderer->camera()->dolly(scale);
+  this->interactionOccurred();
+
+  // Dollies compose by multiplying their factors.
+  if (scale > 0.0) {
+    this->Internal->PendingDolly *= scale;
+  }
 }
 
 //----------------------------------------------------------------------------
 void vesKiwiBaseApp::handleTwoTouchRotationGesture(double rotation)
 {
-  std::tr1::shared_ptr<vesCamera> camera = this->Internal->Renderer->camera();
-  camera->roll(rotation * 180.0 / M_PI);
-  camera->orthogonalizeViewUp();
+  this->interactionOccurred();
+
+  this->Internal->PendingRoll += rotation * 180.0 / M_PI;
 }
 
 //----------------------------------------------------------------------------
@@ -345,12 +477,36 @@ vesSharedPtr<vesVertexAttribute> vesKiwiBaseApp::addVertexTextureCoordinateAttri
   return this->Internal->VertexAttributes.back();
 }
 
+//----------------------------------------------------------------------------
+vesSharedPtr<vesVertexAttribute> vesKiwiBaseApp::addVertexScalarAttribute(
+  vesSharedPtr<vesShaderProgram> program, const std::string& name)
+{
+  this->Internal->VertexAttributes.push_back(
+    name.empty() ? vesSharedPtr<vesVertexAttribute>(new vesScalarVertexAttribute())
+    : vesSharedPtr<vesVertexAttribute>(new vesScalarVertexAttribute(name)));
+  program->addVertexAttribute(this->Internal->VertexAttributes.back(), vesVertexAttributeKeys::Scalar);
+
+  return this->Internal->VertexAttributes.back();
+}
+
 //----------------------------------------------------------------------------
 void vesKiwiBaseApp::setBackgroundColor(double r, double g, double b)
 {
   this->Internal->Renderer->setBackgroundColor(r, g, b, 1.0);
 }
 
+//----------------------------------------------------------------------------
+const vesRenderStatistics& vesKiwiBaseApp::renderStatistics() const
+{
+  return this->Internal->Renderer->statistics();
+}
+
+//----------------------------------------------------------------------------
+std::string vesKiwiBaseApp::renderStatisticsJSON() const
+{
+  return this->Internal->Renderer->statistics().toJSON();
+}
+
 //----------------------------------------------------------------------------
 int vesKiwiBaseApp::viewWidth() const
 {
@@ -398,3 +554,39 @@ void vesKiwiBaseApp::setCameraViewUp(const vesVector3f& viewUp)
 {
   this->renderer()->camera()->setViewUp(viewUp);
 }
+
+//----------------------------------------------------------------------------
+void vesKiwiBaseApp::setInteractiveResolutionScaling(bool enabled)
+{
+  this->Internal->ResolutionScaling = enabled;
+}
+
+//----------------------------------------------------------------------------
+bool vesKiwiBaseApp::interactiveResolutionScaling() const
+{
+  return this->Internal->ResolutionScaling;
+}
+
+//----------------------------------------------------------------------------
+void vesKiwiBaseApp::setInteractiveFramesPerSecond(double framesPerSecond)
+{
+  this->Internal->Governor.setTargetFramesPerSecond(framesPerSecond);
+}
+
+//----------------------------------------------------------------------------
+double vesKiwiBaseApp::interactiveFramesPerSecond() const
+{
+  return this->Internal->Governor.targetFramesPerSecond();
+}
+
+//----------------------------------------------------------------------------
+bool vesKiwiBaseApp::isResolutionReduced() const
+{
+  return this->Internal->Renderer->resolutionScale() < 1.0f;
+}
+
+//----------------------------------------------------------------------------
+void vesKiwiBaseApp::interactionOccurred()
+{
+  this->Internal->LastInteractionTime = vtkTimerLog::GetUniversalTime();
+}
@@ -34,6 +34,7 @@
 
 class vesCamera;
 class vesRenderer;
+class vesRenderStatistics;
 class vesShader;
 class vesShaderProgram;
 class vesUniform;
@@ -52,6 +53,14 @@ public:
   /// behavior, rather than overriding this method.
   void render();
 
+  /// Return true if the next call to render() would draw a different image,
+  /// because the scene or the camera changed, gestures are waiting to be
+  /// applied, or the last frame was rendered at reduced resolution. The
+  /// platform code can stop rendering while this returns false and resume
+  /// when it becomes true, e.g. after delivering touch events.
+  /// \see vesRenderer::isRenderNeeded()
+  virtual bool isRenderNeeded() const;
+
   /// Reset the camera to a default viewing direction and position.
   /// The camera view direction is reset to the world +Z axis and the view up
   /// direction is set to +Y.  The camera focal point is set to the center of
@@ -70,6 +79,11 @@ public:
   /// Resizes the renderer to the given width and height.
   virtual void resizeView(int width, int height);
 
+  // The camera gestures below do not move the camera right away. Gestures
+  // received between two frames are accumulated and applied once, at the
+  // next render() or camera access, so a burst of touch events costs a
+  // single camera update.
+
   /// Handle a two touch pan gesture.  The implementation translates the movement
   /// in 2D to a 3D translation to be applied to the camera position and focal point.
   virtual void handleTwoTouchPanGesture(double x0, double y0, double x1, double y1);
@@ -109,6 +123,31 @@ public:
   /// Set the background color of the renderer.
   void setBackgroundColor(double r, double g, double b);
 
+  /// Enable rendering at reduced resolution while the camera is moved by
+  /// touch gestures. The resolution is chosen by a vesFrameRateGovernor to
+  /// reach the target frame rate, and full resolution is restored once the
+  /// gestures stop. Disabled by default.
+  /// \see isResolutionReduced()
+  void setInteractiveResolutionScaling(bool enabled);
+  bool interactiveResolutionScaling() const;
+
+  /// Set the frame rate aimed at while interacting, 30 by default.
+  void setInteractiveFramesPerSecond(double framesPerSecond);
+  double interactiveFramesPerSecond() const;
+
+  /// Return true if the last frame was rendered at reduced resolution.
+  /// The platform code should keep calling render() while this is true,
+  /// so that a full resolution frame follows the end of the interaction.
+  bool isResolutionReduced() const;
+
+  /// Get the draw call counts, state changes, uploads and phase timings
+  /// of the last rendered frame.
+  const vesRenderStatistics& renderStatistics() const;
+
+  /// Get the statistics of the last rendered frame as a JSON object, for
+  /// logging.
+  std::string renderStatisticsJSON() const;
+
   /// Get the width of the renderer.
   /// \see resizeView()
   int viewWidth() const;
@@ -142,6 +181,11 @@ protected:
   virtual void willRender() {}
   virtual void didRender() {}
 
+  /// Record that the user is interacting with the view. The gesture
+  /// handlers of this class call it; subclasses handling gestures without
+  /// calling the superclass should call it too.
+  void interactionOccurred();
+
   vesSharedPtr<vesShaderProgram> addShaderProgram(
     const std::string& vertexShaderSource, const std::string& fragmentShaderSource);
   void deleteShaderProgram(vesSharedPtr<vesShaderProgram> shaderProgram);
@@ -162,6 +206,8 @@ protected:
     vesSharedPtr<vesShaderProgram> program, const std::string& name=std::string());
   vesSharedPtr<vesVertexAttribute> addVertexTextureCoordinateAttribute(
     vesSharedPtr<vesShaderProgram> program, const std::string& name=std::string());
+  vesSharedPtr<vesVertexAttribute> addVertexScalarAttribute(
+    vesSharedPtr<vesShaderProgram> program, const std::string& name=std::string());
 
   /// This accessor is protected so that clients of this class do not use the
   /// API of the returned object. Instead, this class should provide public methods
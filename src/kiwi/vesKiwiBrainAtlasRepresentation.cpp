@@ -24,20 +24,21 @@
 #include "vesCamera.h"
 #include "vesMapper.h"
 #include "vesActor.h"
-#include "vesKiwiDataLoader.h"
+#include "vesGeometryData.h"
+#include "vesBoundingVolumeHierarchy.h"
+#include "vesKiwiLoadScheduler.h"
+#include "vesKiwiOverlayBatch.h"
 #include "vesKiwiText2DRepresentation.h"
 #include "vesKiwiPolyDataRepresentation.h"
 #include "vesEigen.h"
 
 #include <vtkNew.h>
-#include <vtkBoundingBox.h>
 #include <vtkPlane.h>
 #include <vtkPlaneSource.h>
 #include <vtkArrowSource.h>
 #include <vtkPolyData.h>
 #include <vtkOutlineFilter.h>
 #include <vtkPointData.h>
-#include <vtkCellLocator.h>
 #include <vtkAppendPolyData.h>
 #include <vtkTransform.h>
 
@@ -58,6 +59,7 @@ public:
     this->SkinRepIndex = -1;
     this->SkullRepIndex = -1;
     this->SkinOpacity = 1.0;
+    this->Hierarchy = vesBoundingVolumeHierarchy::Ptr(new vesBoundingVolumeHierarchy);
   }
 
   ~vesInternal()
@@ -80,7 +82,6 @@ public:
   vesKiwiPolyDataRepresentation::Ptr SkinRep;
   std::vector<bool> ModelStatus;
   std::vector<bool> ModelSceneStatus;
-  std::vector<vtkSmartPointer<vtkCellLocator> > Locators;
   std::vector<std::string> AnatomicalNames;
   std::vector<vesKiwiPolyDataRepresentation::Ptr> AnatomicalModels;
   std::vector<vesVector3f> Colors;
@@ -88,6 +89,10 @@ public:
   std::vector<double> AnchorOffsets;
 
   vtkSmartPointer<vtkPlane> Plane;
+
+  // Triangles of all the models for picking, actor indices match
+  // AnatomicalModels.
+  vesBoundingVolumeHierarchy::Ptr Hierarchy;
 };
 
 //----------------------------------------------------------------------------
@@ -119,10 +124,30 @@ void vesKiwiBrainAtlasRepresentation::initializeWithShader(vesSharedPtr<vesShade
 }
 
 //----------------------------------------------------------------------------
-void vesKiwiBrainAtlasRepresentation::loadData(const std::string& filename)
+namespace {
+
+class AnatomicalModelJob : public vesKiwiLoadScheduler::Job
 {
-  this->Internal->Locators.clear();
+public:
+
+  AnatomicalModelJob(const std::string& anatomicalName, const double color[3],
+                     const std::string& modelFile)
+    : vesKiwiLoadScheduler::Job(modelFile), AnatomicalName(anatomicalName)
+  {
+    this->Color[0] = color[0];
+    this->Color[1] = color[1];
+    this->Color[2] = color[2];
+  }
+
+  std::string AnatomicalName;
+  double Color[3];
+};
 
+} // end namespace
+
+//----------------------------------------------------------------------------
+void vesKiwiBrainAtlasRepresentation::loadData(const std::string& filename)
+{
   std::ifstream f;
 
   std::string modelInfoFile = filename;
@@ -132,6 +157,10 @@ void vesKiwiBrainAtlasRepresentation::loadData(const std::string& filename)
 
   f.open(modelInfoFile.c_str());
 
+  // The models are independent files, they are read and converted
+  // concurrently and added to the scene in the order of the info file.
+  vesKiwiLoadScheduler scheduler;
+
   while (!f.eof()) {
 
     std::string anatomicalName;
@@ -147,13 +176,24 @@ void vesKiwiBrainAtlasRepresentation::loadData(const std::string& filename)
 
     modelFile = dataDir + "/" + modelFile;
 
-    vesKiwiDataLoader dataLoader;
-    vtkSmartPointer<vtkPolyData> polyData = vtkPolyData::SafeDownCast(dataLoader.loadDataset(modelFile));
-    if (!polyData) {
-      std::cout << "Failed to read: " << modelFile << std::endl;
+    scheduler.addJob(vesKiwiLoadScheduler::Job::Ptr(
+      new AnatomicalModelJob(anatomicalName, color, modelFile)));
+  }
+
+  scheduler.start();
+
+  while (vesKiwiLoadScheduler::Job::Ptr loadedJob = scheduler.next()) {
+
+    AnatomicalModelJob* job = static_cast<AnatomicalModelJob*>(loadedJob.get());
+    vesSharedPtr<vesGeometryData> geometryData = job->geometryData();
+    if (!job->isLoaded() || !geometryData) {
+      std::cout << "Failed to read: " << job->filename() << std::endl;
       continue;
     }
 
+    const std::string& anatomicalName = job->AnatomicalName;
+    const double* color = job->Color;
+
     vesSharedPtr<vesShaderProgram> shader = this->Internal->GeometryShader;
 
     double opacity = 1.0;
@@ -165,15 +205,13 @@ void vesKiwiBrainAtlasRepresentation::loadData(const std::string& filename)
 
     vesKiwiPolyDataRepresentation::Ptr rep = vesKiwiPolyDataRepresentation::Ptr(new vesKiwiPolyDataRepresentation);
     rep->initializeWithShader(shader);
-    rep->setPolyData(polyData);
+    rep->setGeometryData(geometryData);
+    rep->shareGeometryData();
     rep->setColor(color[0], color[1], color[2], opacity);
     rep->setBinNumber(binNumber);
     this->Internal->AllReps.push_back(rep);
 
-    vtkSmartPointer<vtkCellLocator> locator = vtkSmartPointer<vtkCellLocator>::New();
-    locator->SetDataSet(polyData);
-    locator->BuildLocator();
-    this->Internal->Locators.push_back(locator);
+    this->Internal->Hierarchy->addActor(rep->actor());
     this->Internal->AnatomicalNames.push_back(anatomicalName);
     this->Internal->AnatomicalModels.push_back(rep);
     this->Internal->ModelStatus.push_back(true);
@@ -181,15 +219,10 @@ void vesKiwiBrainAtlasRepresentation::loadData(const std::string& filename)
     this->Internal->Colors.push_back(vesVector3f(color[0], color[1], color[2]));
 
 
-    double center[3];
-    vesVector3f anchor;
-    vtkBoundingBox bounds;
-    bounds.SetBounds(polyData->GetBounds());
-    bounds.GetCenter(center);
-    anchor[0] = center[0];
-    anchor[1] = center[1];
-    anchor[2] = center[2];
-    double modelRadius = bounds.GetDiagonalLength() / 2.0;
+    const vesVector3f boundsMin = geometryData->boundsMin();
+    const vesVector3f boundsMax = geometryData->boundsMax();
+    vesVector3f anchor = (boundsMin + boundsMax) / 2.0f;
+    double modelRadius = (boundsMax - boundsMin).norm() / 2.0;
     this->Internal->AnnotationAnchors.push_back(anchor);
     this->Internal->AnchorOffsets.push_back(modelRadius);
 
@@ -197,31 +230,19 @@ void vesKiwiBrainAtlasRepresentation::loadData(const std::string& filename)
       this->Internal->SkinRepIndex = this->Internal->AnatomicalModels.size() - 1;
       this->Internal->SkinRep = rep;
       rep->setBinNumber(5);
+      rep->setSortTriangles(true);
     }
     else if (anatomicalName == "skull_bone") {
       this->Internal->SkullRepIndex = this->Internal->AnatomicalModels.size() - 1;
     }
   }
+
+  this->Internal->Hierarchy->buildInBackground();
 }
 
 //----------------------------------------------------------------------------
 namespace {
 
-double PickDataSet(vtkCellLocator* locator, vesVector3d& rayPoint0, vesVector3d& rayPoint1)
-{
-  double pickPoint[3];
-  double t;
-  double paramCoords[3];
-  int subId;
-
-  int result = locator->IntersectWithLine(rayPoint0.data(), rayPoint1.data(), 0.0, t, pickPoint, paramCoords, subId);
-  if (result == 1) {
-      return t*vesVector3d(rayPoint1 - rayPoint0).norm();
-  }
-
-  return -1;
-}
-
 std::string GetHumanReadableName(std::string name)
 {
   vtksys::SystemTools::ReplaceString(name, "_R", " (right)");
@@ -278,45 +299,40 @@ int vesKiwiBrainAtlasRepresentation::findTappedModel(int displayX, int displayY)
   vesSharedPtr<vesRenderer> ren = this->renderer();
   displayY = ren->height() - displayY;
 
-  vesVector3d rayPoint0 = ren->computeDisplayToWorld(vesVector3f(displayX, displayY, /*focalDepth=*/0.0)).cast<double>();
-  vesVector3d rayPoint1 = ren->computeDisplayToWorld(vesVector3f(displayX, displayY, /*focalDepth=*/1.0)).cast<double>();
-
-  int tappedModel = -1;
-  double minDist = -1;
+  vesVector3f rayPoint0 = ren->computeDisplayToWorld(vesVector3f(displayX, displayY, /*focalDepth=*/0.0));
+  vesVector3f rayPoint1 = ren->computeDisplayToWorld(vesVector3f(displayX, displayY, /*focalDepth=*/1.0));
 
-  double extraDist = 0;
-  for (size_t i = 0; i < this->Internal->Locators.size(); ++i) {
+  vesBoundingVolumeHierarchy::Ptr hierarchy = this->Internal->Hierarchy;
+  for (size_t i = 0; i < this->Internal->ModelStatus.size(); ++i) {
+    hierarchy->setPickable(i, this->Internal->ModelStatus[i]);
+  }
 
-    if (!this->Internal->ModelStatus[i])
+  // only the non-clipped portion of the skin and skull can be picked
+  int clippedModels[2] = {this->Internal->SkinRepIndex, this->Internal->SkullRepIndex};
+  for (int i = 0; i < 2; ++i) {
+    if (clippedModels[i] < 0) {
       continue;
-
-    vesVector3d pickRayPoint0 = rayPoint0;
-    extraDist = 0.0;
-
-    if (static_cast<int>(i) == this->Internal->SkullRepIndex
-        || static_cast<int>(i) == this->Internal->SkinRepIndex) {
-
-      // set rayPoint0 to intersection of ray with plane so that the ray
-      // only intersects with the non-clipped portion of these models
-      if (this->Internal->Plane && this->Internal->Plane->EvaluateFunction (rayPoint0.data()) > 0) {
-        double t;
-        vesVector3d planeIntersection;
-        this->Internal->Plane->IntersectWithLine(rayPoint0.data(), rayPoint1.data(), t, planeIntersection.data());
-        pickRayPoint0 = planeIntersection;
-        vesVector3d rayToPlane = pickRayPoint0 - rayPoint0;
-        extraDist = rayToPlane.norm();
-      }
     }
+    if (this->Internal->Plane) {
+      vesVector3f normal(this->Internal->Plane->GetNormal()[0],
+                         this->Internal->Plane->GetNormal()[1],
+                         this->Internal->Plane->GetNormal()[2]);
+      vesVector3f origin(this->Internal->Plane->GetOrigin()[0],
+                         this->Internal->Plane->GetOrigin()[1],
+                         this->Internal->Plane->GetOrigin()[2]);
+      hierarchy->setClipPlane(clippedModels[i], vesVector4f(-normal[0], -normal[1], -normal[2], normal.dot(origin)));
+    }
+    else {
+      hierarchy->removeClipPlane(clippedModels[i]);
+    }
+  }
 
-    double dist = PickDataSet(this->Internal->Locators[i], pickRayPoint0, rayPoint1);
-
-    if (dist >= 0)
-      dist += extraDist;
+  hierarchy->refit();
 
-    if (dist >= 0 && (minDist == -1 || dist < minDist)) {
-      tappedModel = i;
-      minDist = dist;
-    }
+  vesBoundingVolumeHierarchy::Hit hit;
+  int tappedModel = -1;
+  if (hierarchy->pick(rayPoint0, rayPoint1, hit)) {
+    tappedModel = hit.m_actor;
   }
 
   return tappedModel;
@@ -337,6 +353,12 @@ bool vesKiwiBrainAtlasRepresentation::hideModel(int displayX, int displayY)
   return false;
 }
 
+//----------------------------------------------------------------------------
+void vesKiwiBrainAtlasRepresentation::setOverlayBatch(vesSharedPtr<vesKiwiOverlayBatch> batch)
+{
+  this->Internal->TextRep->setOverlayBatch(batch);
+}
+
 //----------------------------------------------------------------------------
 void vesKiwiBrainAtlasRepresentation::showTextLabel(int modelIndex) {
 
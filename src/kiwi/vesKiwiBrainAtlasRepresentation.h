@@ -24,6 +24,7 @@
 
 #include "vesKiwiWidgetRepresentation.h"
 
+class vesKiwiOverlayBatch;
 class vesShaderProgram;
 class vtkPlane;
 
@@ -43,6 +44,9 @@ public:
 
   void setClipPlane(vtkPlane* plane);
 
+  /// Draw the anatomical label with the other labels of \a batch.
+  void setOverlayBatch(vesSharedPtr<vesKiwiOverlayBatch> batch);
+
   virtual void addSelfToRenderer(vesSharedPtr<vesRenderer> renderer);
   virtual void removeSelfFromRenderer(vesSharedPtr<vesRenderer> renderer);
   virtual void willRender(vesSharedPtr<vesRenderer> renderer);
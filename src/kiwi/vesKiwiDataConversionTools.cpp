@@ -23,18 +23,448 @@
 // VES includes
 #include "vtkCellArray.h"
 #include "vtkDiscretizableColorTransferFunction.h"
+#include "vtkDoubleArray.h"
 #include "vesGeometryData.h"
+#include "vesGL.h"
 #include "vesGLTypes.h"
 #include "vtkLookupTable.h"
 #include "vesMath.h"
+#include "vtkMath.h"
 #include "vtkNew.h"
 #include "vtkPointData.h"
+#include "vtkPoints.h"
 #include "vtkPolyData.h"
+#include "vesResourceCache.h"
 #include "vesTexture.h"
+#include "vesThreadPool.h"
 #include "vtkUnsignedCharArray.h"
 
 // C/C++ includes
+#include <algorithm>
 #include <cassert>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+// Tuples per chunk of the parallel conversion loops, small inputs are
+// converted on the calling thread.
+const size_t ConversionGrainSize = 16384;
+
+//----------------------------------------------------------------------------
+template <class Kernel>
+void RunKernel(size_t count, Kernel& kernel, bool parallel=true)
+{
+  if (parallel)
+    {
+    vesThreadPool::instance()->parallelFor(count, ConversionGrainSize, kernel);
+    }
+  else
+    {
+    kernel.execute(0, count);
+    }
+}
+
+//----------------------------------------------------------------------------
+// Colors of scalar values as vtkScalarsToColors::GetColor() returns them.
+// A vtkLookupTable is read directly, which is safe from several threads
+// once the table is built. Other color maps may update cached state while
+// mapping a value and have to be called from one thread.
+class ScalarColors
+{
+public:
+  explicit ScalarColors(vtkScalarsToColors* scalarsToColors) :
+    ScalarsToColors(scalarsToColors),
+    LookupTable(vtkLookupTable::SafeDownCast(scalarsToColors)),
+    Table(0)
+  {
+    if (this->LookupTable && this->LookupTable->GetTable() &&
+        this->LookupTable->GetTable()->GetNumberOfTuples() > 0)
+      {
+      this->Table = this->LookupTable->GetTable()->GetPointer(0);
+      this->LookupTable->GetColor(vtkMath::Nan(), this->NanColor);
+      }
+  }
+
+  bool isThreadSafe() const { return this->Table != 0; }
+
+  void getColor(double value, double rgb[3]) const
+  {
+    if (!this->Table)
+      {
+      this->ScalarsToColors->GetColor(value, rgb);
+      return;
+      }
+
+    const vtkIdType index = this->LookupTable->GetIndex(value);
+    if (index < 0)
+      {
+      std::copy(this->NanColor, this->NanColor + 3, rgb);
+      return;
+      }
+
+    const unsigned char* color = this->Table + 4*index;
+    rgb[0] = color[0]/255.0;
+    rgb[1] = color[1]/255.0;
+    rgb[2] = color[2]/255.0;
+  }
+
+private:
+  vtkScalarsToColors* ScalarsToColors;
+  vtkLookupTable* LookupTable;
+  const unsigned char* Table;
+  double NanColor[3];
+};
+
+//----------------------------------------------------------------------------
+class RGBColorsKernel
+{
+public:
+  RGBColorsKernel(const unsigned char* colors, vesVertexDataC3f* output) :
+    Colors(colors), Output(output)
+  {
+  }
+
+  void execute(size_t begin, size_t end)
+  {
+    for (size_t i = begin; i < end; ++i)
+      {
+      const unsigned char* rgb = this->Colors + 3*i;
+      this->Output[i].m_color = vesVector3f(rgb[0]/255.0, rgb[1]/255.0, rgb[2]/255.0);
+      }
+  }
+
+  const unsigned char* Colors;
+  vesVertexDataC3f* Output;
+};
+
+//----------------------------------------------------------------------------
+template <typename T>
+class ScalarColorsKernel
+{
+public:
+  ScalarColorsKernel(const T* scalars, int stride, const ScalarColors& colors,
+    vesVertexDataC3f* output) :
+    Scalars(scalars), Stride(stride), Colors(colors), Output(output)
+  {
+  }
+
+  void execute(size_t begin, size_t end)
+  {
+    double rgb[3];
+    for (size_t i = begin; i < end; ++i)
+      {
+      this->Colors.getColor(static_cast<double>(this->Scalars[i*this->Stride]), rgb);
+      this->Output[i].m_color = vesVector3f(rgb[0], rgb[1], rgb[2]);
+      }
+  }
+
+  const T* Scalars;
+  int Stride;
+  const ScalarColors& Colors;
+  vesVertexDataC3f* Output;
+};
+
+//----------------------------------------------------------------------------
+template <typename T>
+void SetScalarColors(const T* scalars, size_t count, int stride,
+  const ScalarColors& colors, vesVertexDataC3f* output)
+{
+  ScalarColorsKernel<T> kernel(scalars, stride, colors, output);
+  RunKernel(count, kernel, colors.isThreadSafe());
+}
+
+//----------------------------------------------------------------------------
+template <typename T>
+class MapScalarsKernel
+{
+public:
+  MapScalarsKernel(const T* scalars, int stride, const ScalarColors& colors,
+    unsigned char* output) :
+    Scalars(scalars), Stride(stride), Colors(colors), Output(output)
+  {
+  }
+
+  void execute(size_t begin, size_t end)
+  {
+    double rgb[3];
+    for (size_t i = begin; i < end; ++i)
+      {
+      this->Colors.getColor(static_cast<double>(this->Scalars[i*this->Stride]), rgb);
+
+      // Truncated like vtkUnsignedCharArray::SetTuple4() does.
+      unsigned char* rgba = this->Output + 4*i;
+      rgba[0] = static_cast<unsigned char>(rgb[0]*255);
+      rgba[1] = static_cast<unsigned char>(rgb[1]*255);
+      rgba[2] = static_cast<unsigned char>(rgb[2]*255);
+      rgba[3] = 255;
+      }
+  }
+
+  const T* Scalars;
+  int Stride;
+  const ScalarColors& Colors;
+  unsigned char* Output;
+};
+
+//----------------------------------------------------------------------------
+template <typename T>
+void MapScalarsToRGBA(const T* scalars, size_t count, int stride,
+  const ScalarColors& colors, unsigned char* output)
+{
+  MapScalarsKernel<T> kernel(scalars, stride, colors, output);
+  RunKernel(count, kernel, colors.isThreadSafe());
+}
+
+//----------------------------------------------------------------------------
+template <typename T>
+class TextureCoordinatesKernel
+{
+public:
+  TextureCoordinatesKernel(const T* tcoords, int stride, vesVertexDataT2f* output) :
+    TCoords(tcoords), Stride(stride), Output(output)
+  {
+  }
+
+  void execute(size_t begin, size_t end)
+  {
+    for (size_t i = begin; i < end; ++i)
+      {
+      const T* values = this->TCoords + i*this->Stride;
+      this->Output[i].m_textureCoordinate = vesVector2f(
+        static_cast<double>(values[0]), static_cast<double>(values[1]));
+      }
+  }
+
+  const T* TCoords;
+  int Stride;
+  vesVertexDataT2f* Output;
+};
+
+//----------------------------------------------------------------------------
+template <typename T>
+void SetTextureCoordinatesFrom(const T* tcoords, size_t count, int stride,
+  vesVertexDataT2f* output)
+{
+  TextureCoordinatesKernel<T> kernel(tcoords, stride, output);
+  RunKernel(count, kernel);
+}
+
+//----------------------------------------------------------------------------
+// Copies 3 component tuples into one member of vertices, the position or
+// the normal.
+template <typename T, typename Vertex>
+class VectorsKernel
+{
+public:
+  VectorsKernel(const T* vectors, int stride, Vertex* output,
+    vesVector3f Vertex::* member) :
+    Vectors(vectors), Stride(stride), Output(output), Member(member)
+  {
+  }
+
+  void execute(size_t begin, size_t end)
+  {
+    for (size_t i = begin; i < end; ++i)
+      {
+      const T* values = this->Vectors + i*this->Stride;
+      this->Output[i].*this->Member = vesVector3f(static_cast<double>(values[0]),
+        static_cast<double>(values[1]), static_cast<double>(values[2]));
+      }
+  }
+
+  const T* Vectors;
+  int Stride;
+  Vertex* Output;
+  vesVector3f Vertex::* Member;
+};
+
+//----------------------------------------------------------------------------
+template <typename T, typename Vertex>
+void CopyVectors(const T* vectors, size_t count, int stride, Vertex* output,
+  vesVector3f Vertex::* member)
+{
+  VectorsKernel<T, Vertex> kernel(vectors, stride, output, member);
+  RunKernel(count, kernel);
+}
+
+//----------------------------------------------------------------------------
+template <typename Vertex>
+void CopyVectors(vtkDataArray* vectors, std::vector<Vertex>& output,
+  vesVector3f Vertex::* member)
+{
+  const size_t count = std::min(static_cast<size_t>(vectors->GetNumberOfTuples()),
+    output.size());
+  const int stride = vectors->GetNumberOfComponents();
+  if (!count)
+    {
+    return;
+    }
+  assert(stride >= 3);
+
+  switch (vectors->GetDataType())
+    {
+    vtkTemplateMacro(
+      CopyVectors(static_cast<const VTK_TT*>(vectors->GetVoidPointer(0)),
+        count, stride, &output[0], member));
+    default:
+      for (size_t i = 0; i < count; ++i)
+        {
+        double* tuple = vectors->GetTuple(i);
+        output[i].*member = vesVector3f(tuple[0], tuple[1], tuple[2]);
+        }
+    }
+}
+
+//----------------------------------------------------------------------------
+// Primitives of the general conversion: triangles from triangles and quads,
+// triangles from strips, line segments from polylines and vertices.
+enum CellConversion
+{
+  PolygonTriangles,
+  StripTriangles,
+  LineSegments,
+  Vertices
+};
+
+//----------------------------------------------------------------------------
+size_t IndicesPerCell(CellConversion conversion, vtkIdType numberOfPoints)
+{
+  switch (conversion)
+    {
+    case PolygonTriangles:
+      return numberOfPoints == 3 ? 3 : numberOfPoints == 4 ? 6 : 0;
+    case StripTriangles:
+      return numberOfPoints > 2 ? 3*(numberOfPoints - 2) : 0;
+    case LineSegments:
+      return numberOfPoints > 1 ? 2*(numberOfPoints - 1) : 0;
+    case Vertices:
+      return numberOfPoints > 0 ? 1 : 0;
+    }
+  return 0;
+}
+
+//----------------------------------------------------------------------------
+// Writes the indices of each cell at an offset found by a serial scan over
+// the cell sizes, so that cells are converted in parallel into the same
+// index order as one after the other.
+class CellIndicesKernel
+{
+public:
+  CellIndicesKernel(CellConversion conversion, const vtkIdType* connectivity,
+    const std::vector<vtkIdType>& cellOffsets,
+    const std::vector<size_t>& indexOffsets, unsigned short* output) :
+    Conversion(conversion), Connectivity(connectivity), CellOffsets(cellOffsets),
+    IndexOffsets(indexOffsets), Output(output)
+  {
+  }
+
+  void execute(size_t begin, size_t end)
+  {
+    for (size_t cell = begin; cell < end; ++cell)
+      {
+      const vtkIdType* points = this->Connectivity + this->CellOffsets[cell];
+      const vtkIdType numberOfPoints = *points++;
+      unsigned short* index = this->Output + this->IndexOffsets[cell];
+
+      switch (this->Conversion)
+        {
+        case PolygonTriangles:
+          if (numberOfPoints == 3 || numberOfPoints == 4)
+            {
+            *index++ = points[0];
+            *index++ = points[1];
+            *index++ = points[2];
+            }
+          if (numberOfPoints == 4)
+            {
+            *index++ = points[3];
+            *index++ = points[0];
+            *index++ = points[2];
+            }
+          break;
+        case StripTriangles:
+          for (vtkIdType i = 2; i < numberOfPoints; ++i)
+            {
+            *index++ = points[(i & 1) ? i-1 : i-2];
+            *index++ = points[(i & 1) ? i-2 : i-1];
+            *index++ = points[i];
+            }
+          break;
+        case LineSegments:
+          for (vtkIdType i = 1; i < numberOfPoints; ++i)
+            {
+            *index++ = points[i-1];
+            *index++ = points[i];
+            }
+          break;
+        case Vertices:
+          if (numberOfPoints > 0)
+            {
+            *index++ = points[0];
+            }
+          break;
+        }
+      }
+  }
+
+  CellConversion Conversion;
+  const vtkIdType* Connectivity;
+  const std::vector<vtkIdType>& CellOffsets;
+  const std::vector<size_t>& IndexOffsets;
+  unsigned short* Output;
+};
+
+//----------------------------------------------------------------------------
+void ConvertCells(vtkCellArray* cells, vtkIdType maximumNumberOfCells,
+  CellConversion conversion, vesPrimitive::Indices& indices)
+{
+  const vtkIdType numberOfCells =
+    std::min(cells->GetNumberOfCells(), maximumNumberOfCells);
+  const vtkIdType* connectivity = cells->GetPointer();
+
+  std::vector<vtkIdType> cellOffsets(numberOfCells);
+  std::vector<size_t> indexOffsets(numberOfCells + 1);
+  vtkIdType cellOffset = 0;
+  indexOffsets[0] = 0;
+  for (vtkIdType i = 0; i < numberOfCells; ++i)
+    {
+    cellOffsets[i] = cellOffset;
+    indexOffsets[i+1] = indexOffsets[i] +
+      IndicesPerCell(conversion, connectivity[cellOffset]);
+    cellOffset += connectivity[cellOffset] + 1;
+    }
+
+  indices.resize(indexOffsets[numberOfCells]);
+  if (indices.empty())
+    {
+    return;
+    }
+
+  CellIndicesKernel kernel(conversion, connectivity, cellOffsets, indexOffsets,
+    &indices.front());
+  RunKernel(numberOfCells, kernel);
+}
+
+//----------------------------------------------------------------------------
+class CopyKernel
+{
+public:
+  CopyKernel(const unsigned char* input, unsigned char* output) :
+    Input(input), Output(output)
+  {
+  }
+
+  void execute(size_t begin, size_t end)
+  {
+    memcpy(this->Output + begin, this->Input + begin, end - begin);
+  }
+
+  const unsigned char* Input;
+  unsigned char* Output;
+};
+
+} // end namespace
 
 //----------------------------------------------------------------------------
 vtkDataArray* vesKiwiDataConversionTools::FindScalarsArray(vtkDataSet* dataSet)
@@ -128,16 +558,14 @@ void vesKiwiDataConversionTools::SetVertexColors(
   assert(colors);
   assert(colors->GetNumberOfComponents() == 3);
 
-  unsigned char rgb[3];
   const size_t nTuples = colors->GetNumberOfTuples();
 
   vesSourceDataC3f::Ptr colorSourceData (new vesSourceDataC3f());
-  for (size_t i = 0; i < nTuples; ++i)
+  colorSourceData->arrayReference().resize(nTuples);
+  if (nTuples)
     {
-    colors->GetTupleValue(i, rgb);
-    vesVertexDataC3f color;
-    color.m_color = vesVector3f(rgb[0]/255.0, rgb[1]/255.0, rgb[2]/255.0);
-    colorSourceData->pushBack(color);
+    RGBColorsKernel kernel(colors->GetPointer(0), &colorSourceData->arrayReference()[0]);
+    RunKernel(nTuples, kernel);
     }
 
   geometryData->addSource(colorSourceData);
@@ -151,17 +579,26 @@ void vesKiwiDataConversionTools::SetVertexColors(vtkDataArray* scalars,
   assert(scalars->GetNumberOfComponents() == 1);
   assert(geometryData);
 
-  double rgb[3];
   const size_t nTuples = scalars->GetNumberOfTuples();
+  const int stride = scalars->GetNumberOfComponents();
 
   vesSourceDataC3f::Ptr colorSourceData (new vesSourceDataC3f());
+  colorSourceData->arrayReference().resize(nTuples);
 
-  for (size_t i = 0; i < nTuples; ++i)
+  const ScalarColors colors(scalarsToColors);
+  vesVertexDataC3f* output = nTuples ? &colorSourceData->arrayReference()[0] : 0;
+  switch (nTuples ? scalars->GetDataType() : -1)
     {
-    scalarsToColors->GetColor(scalars->GetComponent(i, 0), rgb);
-    vesVertexDataC3f color;
-    color.m_color = vesVector3f(rgb[0], rgb[1], rgb[2]);
-    colorSourceData->pushBack(color);
+    vtkTemplateMacro(
+      SetScalarColors(static_cast<const VTK_TT*>(scalars->GetVoidPointer(0)),
+        nTuples, stride, colors, output));
+    default:
+      for (size_t i = 0; i < nTuples; ++i)
+        {
+        double rgb[3];
+        colors.getColor(scalars->GetComponent(i, 0), rgb);
+        output[i].m_color = vesVector3f(rgb[0], rgb[1], rgb[2]);
+        }
     }
 
   geometryData->addSource(colorSourceData);
@@ -176,20 +613,68 @@ void vesKiwiDataConversionTools::SetTextureCoordinates(vtkDataArray* tcoords,
   assert(geometryData);
 
   const size_t nTuples = tcoords->GetNumberOfTuples();
+  const int stride = tcoords->GetNumberOfComponents();
 
   vesSourceDataT2f::Ptr texCoordSourceData (new vesSourceDataT2f());
+  texCoordSourceData->arrayReference().resize(nTuples);
 
-  for (size_t i = 0; i < nTuples; ++i)
+  vesVertexDataT2f* output = nTuples ? &texCoordSourceData->arrayReference()[0] : 0;
+  switch (nTuples ? tcoords->GetDataType() : -1)
     {
-    double* values = tcoords->GetTuple(i);
-    vesVertexDataT2f textureCoordinate;
-    textureCoordinate.m_textureCoordinate = vesVector2f(values[0], values[1]);
-    texCoordSourceData->pushBack(textureCoordinate);
+    vtkTemplateMacro(
+      SetTextureCoordinatesFrom(static_cast<const VTK_TT*>(tcoords->GetVoidPointer(0)),
+        nTuples, stride, output));
+    default:
+      for (size_t i = 0; i < nTuples; ++i)
+        {
+        double* values = tcoords->GetTuple(i);
+        output[i].m_textureCoordinate = vesVector2f(values[0], values[1]);
+        }
     }
 
   geometryData->addSource(texCoordSourceData);
 }
 
+//----------------------------------------------------------------------------
+void vesKiwiDataConversionTools::SetVertexScalars(vtkDataArray* scalars,
+  vesSharedPtr<vesGeometryData> geometryData)
+{
+  assert(scalars);
+  assert(scalars->GetNumberOfComponents() == 1);
+  assert(geometryData);
+
+  const size_t nTuples = scalars->GetNumberOfTuples();
+
+  vesSourceDataf::Ptr scalarSourceData (new vesSourceDataf());
+  scalarSourceData->arrayReference().resize(nTuples);
+
+  for (size_t i = 0; i < nTuples; ++i)
+    {
+    scalarSourceData->arrayReference()[i].m_scalar = scalars->GetComponent(i, 0);
+    }
+
+  geometryData->addSource(scalarSourceData);
+}
+
+//----------------------------------------------------------------------------
+vtkSmartPointer<vtkUnsignedCharArray> vesKiwiDataConversionTools::GetColorTable(
+  vtkScalarsToColors* scalarsToColors, double scalarRange[2], int resolution)
+{
+  assert(scalarsToColors);
+  assert(resolution > 1);
+
+  vtkNew<vtkDoubleArray> scalarRangeValues;
+  scalarRangeValues->SetNumberOfComponents(1);
+  scalarRangeValues->SetNumberOfTuples(resolution);
+  const double step = (scalarRange[1] - scalarRange[0]) / (resolution - 1);
+  for (int i = 0; i < resolution; ++i)
+    {
+    scalarRangeValues->SetValue(i, scalarRange[0] + i*step);
+    }
+
+  return MapScalars(scalarRangeValues.GetPointer(), scalarsToColors);
+}
+
 //----------------------------------------------------------------------------
 vtkSmartPointer<vtkUnsignedCharArray> vesKiwiDataConversionTools::MapScalars(
 vtkDataArray* scalars, vtkScalarsToColors* scalarsToColors)
@@ -201,21 +686,126 @@ vtkDataArray* scalars, vtkScalarsToColors* scalarsToColors)
   colors->SetNumberOfComponents(4);
   colors->SetNumberOfTuples(scalars->GetNumberOfTuples());
 
-  double rgb[3];
   const size_t nTuples = scalars->GetNumberOfTuples();
-  for (size_t i = 0; i < nTuples; ++i)
+  const int stride = scalars->GetNumberOfComponents();
+  const ScalarColors scalarColors(scalarsToColors);
+  switch (nTuples ? scalars->GetDataType() : -1)
     {
-    scalarsToColors->GetColor(scalars->GetComponent(i, 0), rgb);
-    colors->SetTuple4(i, rgb[0]*255, rgb[1]*255, rgb[2]*255, 255);
+    vtkTemplateMacro(
+      MapScalarsToRGBA(static_cast<const VTK_TT*>(scalars->GetVoidPointer(0)),
+        nTuples, stride, scalarColors, colors->GetPointer(0)));
+    default:
+      for (size_t i = 0; i < nTuples; ++i)
+        {
+        double rgb[3];
+        scalarColors.getColor(scalars->GetComponent(i, 0), rgb);
+        colors->SetTuple4(i, rgb[0]*255, rgb[1]*255, rgb[2]*255, 255);
+        }
     }
   return colors;
 }
 
 //----------------------------------------------------------------------------
-void vesKiwiDataConversionTools::SetTextureData(vtkUnsignedCharArray* pixels,
-  vesSharedPtr<vesTexture> texture, int width, int height)
+vtkSmartPointer<vtkUnsignedCharArray> vesKiwiDataConversionTools::QuantizeScalars(
+  vtkDataArray* scalars, double scalarRange[2])
+{
+  assert(scalars->GetNumberOfComponents() == 1);
+
+  vtkSmartPointer<vtkUnsignedCharArray> levels
+    = vtkSmartPointer<vtkUnsignedCharArray>::New();
+  levels->SetNumberOfComponents(1);
+  levels->SetNumberOfTuples(scalars->GetNumberOfTuples());
+
+  const double delta = scalarRange[1] - scalarRange[0];
+  const double scale = delta > 0.0 ? 255.0 / delta : 0.0;
+  unsigned char* output = levels->GetPointer(0);
+  const vtkIdType nTuples = scalars->GetNumberOfTuples();
+  for (vtkIdType i = 0; i < nTuples; ++i)
+    {
+    double level = (scalars->GetComponent(i, 0) - scalarRange[0]) * scale;
+    output[i] = static_cast<unsigned char>(
+      level <= 0.0 ? 0 : level >= 255.0 ? 255 : level + 0.5);
+    }
+  return levels;
+}
+
+//----------------------------------------------------------------------------
+void vesKiwiDataConversionTools::GetSliceAxes(int flatDimension, int& uAxis, int& vAxis)
+{
+  // Same orientation as the textures of single image slices.
+  uAxis = flatDimension == 0 ? 1 : 0;
+  vAxis = flatDimension == 2 ? 1 : 2;
+}
+
+//----------------------------------------------------------------------------
+bool vesKiwiDataConversionTools::GetSliceAtlasLayout(int width, int height,
+  int numberOfSlices, int& columns, int& rows)
+{
+  GLint maximumTextureSize = 0;
+  glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maximumTextureSize);
+  if (maximumTextureSize <= 0)
+    {
+    // No context yet, assume the lowest size found on ES 2.0 devices.
+    maximumTextureSize = 2048;
+    }
+
+  columns = std::min(numberOfSlices, maximumTextureSize / width);
+  if (columns < 1)
+    {
+    return false;
+    }
+  rows = (numberOfSlices + columns - 1) / columns;
+  return rows * height <= maximumTextureSize;
+}
+
+//----------------------------------------------------------------------------
+vtkSmartPointer<vtkUnsignedCharArray> vesKiwiDataConversionTools::GetSliceAtlas(
+  vtkUnsignedCharArray* levels, const int dimensions[3], int flatDimension,
+  int columns, int rows)
+{
+  assert(levels && levels->GetNumberOfComponents() == 1);
+  assert(levels->GetNumberOfTuples() == dimensions[0]*dimensions[1]*dimensions[2]);
+
+  int uAxis;
+  int vAxis;
+  GetSliceAxes(flatDimension, uAxis, vAxis);
+  const int width = dimensions[uAxis];
+  const int height = dimensions[vAxis];
+  const int numberOfSlices = dimensions[flatDimension];
+  const int atlasWidth = columns * width;
+  const int atlasHeight = rows * height;
+
+  vtkSmartPointer<vtkUnsignedCharArray> atlas
+    = vtkSmartPointer<vtkUnsignedCharArray>::New();
+  atlas->SetNumberOfTuples(atlasWidth * atlasHeight);
+  std::fill(atlas->GetPointer(0), atlas->GetPointer(0) + atlasWidth * atlasHeight, 0);
+
+  const unsigned char* input = levels->GetPointer(0);
+  unsigned char* output = atlas->GetPointer(0);
+  const vtkIdType increments[3] = {1, dimensions[0], dimensions[0]*dimensions[1]};
+
+  for (int slice = 0; slice < numberOfSlices; ++slice)
+    {
+    const int tileX = (slice % columns) * width;
+    const int tileY = (slice / columns) * height;
+    for (int j = 0; j < height; ++j)
+      {
+      const unsigned char* voxel =
+        input + slice * increments[flatDimension] + j * increments[vAxis];
+      unsigned char* pixel = output + (tileY + j) * atlasWidth + tileX;
+      for (int i = 0; i < width; ++i, voxel += increments[uAxis])
+        {
+        pixel[i] = *voxel;
+        }
+      }
+    }
+  return atlas;
+}
+
+//----------------------------------------------------------------------------
+vesSharedPtr<vesImage> vesKiwiDataConversionTools::ConvertImage(
+  vtkUnsignedCharArray* pixels, int width, int height)
 {
-  assert(texture);
   assert(pixels);
   assert(pixels->GetNumberOfTuples() == width*height);
 
@@ -226,9 +816,29 @@ void vesKiwiDataConversionTools::SetTextureData(vtkUnsignedCharArray* pixels,
                         : pixels->GetNumberOfComponents() == 3 ? vesColorDataType::RGB
                         : vesColorDataType::Luminance);
   image->setPixelDataType(vesColorDataType::UnsignedByte);
-  image->setData(pixels->WriteVoidPointer(0, 0), pixels->GetSize());
 
-  texture->setImage(image);
+  const size_t size = pixels->GetNumberOfTuples()*pixels->GetNumberOfComponents();
+  if (size && image->allocateData(size))
+    {
+    CopyKernel kernel(pixels->GetPointer(0), static_cast<unsigned char*>(image->data()));
+    RunKernel(size, kernel);
+    }
+  return image;
+}
+
+//----------------------------------------------------------------------------
+void vesKiwiDataConversionTools::SetTextureData(vtkUnsignedCharArray* pixels,
+  vesSharedPtr<vesTexture> texture, int width, int height)
+{
+  assert(texture);
+  texture->setImage(ConvertImage(pixels, width, height));
+}
+
+//----------------------------------------------------------------------------
+vesSharedPtr<vesTexture> vesKiwiDataConversionTools::SharedTexture(
+  vtkUnsignedCharArray* pixels, int width, int height)
+{
+  return vesResourceCache::instance()->texture(ConvertImage(pixels, width, height));
 }
 
 //----------------------------------------------------------------------------
@@ -241,46 +851,22 @@ void vesKiwiDataConversionTools::ConvertTriangles(
   }
 
   vesSourceDataP3N3f::Ptr sourceData (new vesSourceDataP3N3f());
+  sourceData->arrayReference().resize(input->GetNumberOfPoints());
+  if (input->GetPoints())
+    {
+    CopyVectors(input->GetPoints()->GetData(), sourceData->arrayReference(),
+      &vesVertexDataP3N3f::m_position);
+    }
 
-  double inPoint[3];
-  for (int i = 0; i < input->GetNumberOfPoints(); ++i){
-    input->GetPoint(i, inPoint);
-
-    vesVertexDataP3N3f vertexData;
-    vertexData.m_position = vesVector3f(inPoint[0], inPoint[1], inPoint[2]);
-    sourceData->pushBack(vertexData);
-  }
-
-  // copy triangles in place to ves structure
-  vtkCellArray* polys = input->GetPolys();
-  vtkIdType num;
-  vtkIdType* vertices;
-
-  vesPrimitive::Indices* triangleIndices
-    = output->triangles()->indices();
-
-  triangleIndices->clear();
-  triangleIndices->resize(polys->GetNumberOfCells());
-
-  unsigned short* outIndex = &triangleIndices->front();
-  for (int i = 0; i < polys->GetNumberOfCells(); ++i)
-  {
-    // there are 4 elements for each triangle cell in the array (count, i1, i2, i3)
-    polys->GetCell(4*i, num, vertices);
-    *outIndex++ = vertices[0];
-    *outIndex++ = vertices[1];
-    *outIndex++ = vertices[2];
-  }
+  // copy triangles in place to ves structure, there are 4 elements for each
+  // triangle cell in the array (count, i1, i2, i3)
+  ConvertCells(input->GetPolys(), input->GetPolys()->GetNumberOfCells(),
+    PolygonTriangles, *output->triangles()->indices());
 
   if (input->GetPointData()->GetNormals())
   {
-    vtkDataArray* normals = input->GetPointData()->GetNormals();
-    for (int i = 0; i < input->GetNumberOfPoints(); ++i)
-    {
-      sourceData->arrayReference()[i].m_normal[0] = normals->GetTuple(i)[0];
-      sourceData->arrayReference()[i].m_normal[1] = normals->GetTuple(i)[1];
-      sourceData->arrayReference()[i].m_normal[2] = normals->GetTuple(i)[2];
-    }
+    CopyVectors(input->GetPointData()->GetNormals(), sourceData->arrayReference(),
+      &vesVertexDataP3N3f::m_normal);
   }
   else
   {
@@ -296,12 +882,10 @@ vesSharedPtr<vesGeometryData> vesKiwiDataConversionTools::ConvertPoints(vtkPolyD
   vesSharedPtr<vesGeometryData> output(new vesGeometryData());
   vesSourceDataP3f::Ptr sourceData(new vesSourceDataP3f());
 
-  vesVertexDataP3f vertexData;
-  for (int i = 0; i < input->GetNumberOfPoints(); ++i){
-    vertexData.m_position[0] = input->GetPoint(i)[0];
-    vertexData.m_position[1] = input->GetPoint(i)[1];
-    vertexData.m_position[2] = input->GetPoint(i)[2];
-    sourceData->pushBack(vertexData);
+  sourceData->arrayReference().resize(input->GetNumberOfPoints());
+  if (input->GetPoints()) {
+    CopyVectors(input->GetPoints()->GetData(), sourceData->arrayReference(),
+      &vesVertexDataP3f::m_position);
   }
 
   output->addSource(sourceData);
@@ -328,26 +912,18 @@ vesSharedPtr<vesGeometryData> vesKiwiDataConversionTools::Convert(vtkPolyData* i
   vesSourceDataP3N3f::Ptr sourceData (new vesSourceDataP3N3f());
 
   vesVertexDataP3N3f vertexData;
-  for (int i = 0; i < input->GetNumberOfPoints(); ++i){
-    vertexData.m_position[0] = input->GetPoint(i)[0];
-    vertexData.m_position[1] = input->GetPoint(i)[1];
-    vertexData.m_position[2] = input->GetPoint(i)[2];
-    vertexData.m_normal[0] = 1.0f;
-    vertexData.m_normal[1] = 0.0f;
-    vertexData.m_normal[2] = 0.0f;
-    sourceData->pushBack(vertexData);
+  vertexData.m_normal = vesVector3f(1.0f, 0.0f, 0.0f);
+  sourceData->arrayReference().resize(input->GetNumberOfPoints(), vertexData);
+  if (input->GetPoints()) {
+    CopyVectors(input->GetPoints()->GetData(), sourceData->arrayReference(),
+      &vesVertexDataP3N3f::m_position);
   }
 
   output->addSource(sourceData);
   output->setName("PolyData");
 
-  vtkIdType num;
-  vtkIdType* vertices;
-
   // Add triangles
   vtkCellArray* polys = input->GetPolys();
-  polys->InitTraversal();
-
   if (polys->GetNumberOfCells() > 0) {
     trianglesPrimitive = vesPrimitive::Ptr(new vesPrimitive());
     trianglesPrimitive->setIndexCount(3);
@@ -355,22 +931,12 @@ vesSharedPtr<vesGeometryData> vesKiwiDataConversionTools::Convert(vtkPolyData* i
 
     output->addPrimitive(trianglesPrimitive);
 
-    for (int i = 0; i < polys->GetNumberOfCells(); ++i) {
-      polys->GetNextCell(num, vertices);
-      if (num == 3) {
-        trianglesPrimitive->pushBackIndices(vertices[0], vertices[1], vertices[2]);
-      }
-      else if (num == 4) {
-        trianglesPrimitive->pushBackIndices(vertices[0], vertices[1], vertices[2]);
-        trianglesPrimitive->pushBackIndices(vertices[3], vertices[0], vertices[2]);
-      }
-    }
+    ConvertCells(polys, polys->GetNumberOfCells(), PolygonTriangles,
+      *trianglesPrimitive->indices());
   }
 
   // Add triangle strips
   vtkCellArray* strips = input->GetStrips();
-  strips->InitTraversal();
-
   if (strips->GetNumberOfCells() > 0) {
     triangleStripsPrimitive = vesPrimitive::Ptr(new vesPrimitive());
     triangleStripsPrimitive->setIndexCount(1);
@@ -378,26 +944,12 @@ vesSharedPtr<vesGeometryData> vesKiwiDataConversionTools::Convert(vtkPolyData* i
 
     output->addPrimitive(triangleStripsPrimitive);
 
-    for (int i = 0; i < strips->GetNumberOfCells(); ++i) {
-      strips->GetNextCell(num, vertices);
-      for (int i = 2; i < num; ++i)
-      {
-        if (i & 1)
-        {
-          triangleStripsPrimitive->pushBackIndices(vertices[i-1], vertices[i-2], vertices[i]);
-        }
-        else
-        {
-          triangleStripsPrimitive->pushBackIndices(vertices[i-2], vertices[i-1], vertices[i]);
-        }
-      }
-    }
+    ConvertCells(strips, strips->GetNumberOfCells(), StripTriangles,
+      *triangleStripsPrimitive->indices());
   }
 
   // Add lines
   vtkCellArray* lines = input->GetLines();
-  lines->InitTraversal();
-
   if (lines->GetNumberOfCells() > 0) {
     linesPrimitive = vesPrimitive::Ptr(new vesPrimitive());
     linesPrimitive->setIndexCount(2);
@@ -405,19 +957,12 @@ vesSharedPtr<vesGeometryData> vesKiwiDataConversionTools::Convert(vtkPolyData* i
 
     output->addPrimitive(linesPrimitive);
 
-    for (int i = 0; i < lines->GetNumberOfCells(); ++i) {
-      lines->GetNextCell(num, vertices);
-      for (int i = 1; i < num; ++i)
-      {
-        linesPrimitive->pushBackIndices(vertices[i-1], vertices[i]);
-      }
-    }
+    ConvertCells(lines, lines->GetNumberOfCells(), LineSegments,
+      *linesPrimitive->indices());
   }
 
   // Add verts
   vtkCellArray* verts = input->GetVerts();
-  verts->InitTraversal();
-
   if (verts->GetNumberOfCells() > 0) {
     verticesPrimitive = vesPrimitive::Ptr(new vesPrimitive());
     verticesPrimitive->setIndexCount(1);
@@ -425,19 +970,12 @@ vesSharedPtr<vesGeometryData> vesKiwiDataConversionTools::Convert(vtkPolyData* i
 
     output->addPrimitive(verticesPrimitive);
 
-    for (int i = 0; i < verts->GetNumberOfCells() && i < 65000; ++i) {
-      verts->GetNextCell(num, vertices);
-      verticesPrimitive->pushBackIndices(vertices[0]);
-    }
+    ConvertCells(verts, 65000, Vertices, *verticesPrimitive->indices());
   }
 
   if (input->GetPointData()->GetNormals()) {
-    vtkDataArray* normals = input->GetPointData()->GetNormals();
-    for (int i = 0; i < input->GetNumberOfPoints(); ++i) {
-      sourceData->arrayReference()[i].m_normal[0] = normals->GetTuple(i)[0];
-      sourceData->arrayReference()[i].m_normal[1] = normals->GetTuple(i)[1];
-      sourceData->arrayReference()[i].m_normal[2] = normals->GetTuple(i)[2];
-    }
+    CopyVectors(input->GetPointData()->GetNormals(), sourceData->arrayReference(),
+      &vesVertexDataP3N3f::m_normal);
   }
   else
   {
@@ -31,6 +31,7 @@ class vtkDataArray;
 class vtkScalarsToColors;
 
 class vesGeometryData;
+class vesImage;
 class vesTexture;
 
 #include <vesSharedPtr.h>
@@ -70,10 +71,52 @@ public:
   static void SetTextureCoordinates(
     vtkDataArray* tcoords, vesSharedPtr<vesGeometryData> triangleData);
 
+  /// Add the scalars as a float vertex attribute, so that they can be mapped
+  /// to colors on the GPU.
+  static void SetVertexScalars(vtkDataArray* scalars,
+    vesSharedPtr<vesGeometryData> geometryData);
+
+  /// Sample the color map over the scalar range into an RGBA color table,
+  /// suitable for a lookup table texture.
+  static vtkSmartPointer<vtkUnsignedCharArray> GetColorTable(
+    vtkScalarsToColors* scalarsToColors, double scalarRange[2], int resolution=256);
+
   static vtkSmartPointer<vtkUnsignedCharArray> MapScalars(vtkDataArray* scalars, vtkScalarsToColors* scalarsToColors);
+
+  /// Quantize the scalars to one byte per value, 0 and 255 corresponding to
+  /// the ends of the scalar range, so that they index a color table returned
+  /// by GetColorTable().
+  static vtkSmartPointer<vtkUnsignedCharArray> QuantizeScalars(
+    vtkDataArray* scalars, double scalarRange[2]);
+
+  /// Return the volume axes that run along the width and height of the slices
+  /// perpendicular to \a flatDimension, as laid out in slice atlases.
+  static void GetSliceAxes(int flatDimension, int& uAxis, int& vAxis);
+
+  /// Compute a grid of \a columns by \a rows tiles holding \a numberOfSlices
+  /// slices of width by height texels, within the maximum texture size.
+  /// Returns false if the slices do not fit into a single texture.
+  static bool GetSliceAtlasLayout(int width, int height, int numberOfSlices,
+    int& columns, int& rows);
+
+  /// Copy the slices of a one byte per voxel volume into the tiles of an
+  /// atlas laid out by GetSliceAtlasLayout(), slice i going to column
+  /// i % columns of row i / columns. Unused tiles are zero.
+  static vtkSmartPointer<vtkUnsignedCharArray> GetSliceAtlas(
+    vtkUnsignedCharArray* levels, const int dimensions[3], int flatDimension,
+    int columns, int rows);
+
+  static vesSharedPtr<vesImage> ConvertImage(vtkUnsignedCharArray* pixels,
+    int width, int height);
   static void SetTextureData(vtkUnsignedCharArray* pixels,
     vesSharedPtr<vesTexture> texture, int width, int height);
 
+  /// Return a texture for the given pixels, shared with every other caller
+  /// asking for identical pixels.
+  /// \see vesResourceCache
+  static vesSharedPtr<vesTexture> SharedTexture(vtkUnsignedCharArray* pixels,
+    int width, int height);
+
 };
 
 #endif
@@ -20,6 +20,10 @@
 
 #include "vesKiwiDataLoader.h"
 
+#include "vesGeometryData.h"
+#include "vesMeshCodec.h"
+#include "vesMeshReader.h"
+
 #include <vtkSmartPointer.h>
 #include <vtkXMLPolyDataReader.h>
 #include <vtkXMLImageDataReader.h>
@@ -261,6 +265,30 @@ vtkSmartPointer<vtkDataSet> vesKiwiDataLoader::loadDataset(const std::string& fi
     }
 }
 
+//----------------------------------------------------------------------------
+vesSharedPtr<vesGeometryData> vesKiwiDataLoader::loadGeometryData(const std::string& filename)
+{
+  this->Internal->ErrorTitle = std::string();
+  this->Internal->ErrorMessage = std::string();
+
+  if (vesMeshCodec::canReadFile(filename)) {
+    vesMeshCodec codec;
+    vesSharedPtr<vesGeometryData> geometryData = codec.readFile(filename);
+    if (!geometryData) {
+      this->Internal->ErrorTitle = "Could not read file";
+      this->Internal->ErrorMessage = codec.errorMessage();
+    }
+    return geometryData;
+  }
+
+  if (!vesMeshReader::canReadFile(filename)) {
+    return vesSharedPtr<vesGeometryData>();
+  }
+
+  vesMeshReader reader;
+  return reader.read(filename);
+}
+
 //----------------------------------------------------------------------------
 void vesKiwiDataLoader::setMaximumNumberOfPointsErrorMessage()
 {
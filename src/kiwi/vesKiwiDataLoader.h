@@ -23,8 +23,10 @@
 #define __vesKiwiDataLoader_h
 
 #include <string>
+#include <vesSharedPtr.h>
 #include <vtkSmartPointer.h>
 
+class vesGeometryData;
 class vtkAlgorithm;
 class vtkDataSet;
 
@@ -36,6 +38,15 @@ public:
   ~vesKiwiDataLoader();
 
   vtkSmartPointer<vtkDataSet> loadDataset(const std::string& filename);
+
+  /// Read STL, PLY and OBJ files with vesMeshReader, and .vesz files with
+  /// vesMeshCodec, straight into geometry data and without going through
+  /// VTK. Return an empty pointer for other formats and for files the mesh
+  /// reader does not handle, which loadDataset() reads instead. Since only
+  /// vesMeshCodec reads .vesz files, errorMessage() is set when decoding one
+  /// fails.
+  vesSharedPtr<vesGeometryData> loadGeometryData(const std::string& filename);
+
   std::string errorTitle() const;
   std::string errorMessage() const;
 
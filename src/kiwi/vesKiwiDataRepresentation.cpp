@@ -29,6 +29,12 @@ void vesKiwiDataRepresentation::willRender(vesSharedPtr<vesRenderer> renderer)
   vesNotUsed(renderer);
 }
 
+//----------------------------------------------------------------------------
+bool vesKiwiDataRepresentation::isRenderNeeded() const
+{
+  return false;
+}
+
 //----------------------------------------------------------------------------
 void vesKiwiDataRepresentation::setTransformOnActor(vesSharedPtr<vesActor> actor, vtkTransform* transform)
 {
@@ -44,6 +44,11 @@ public:
   virtual void removeSelfFromRenderer(vesSharedPtr<vesRenderer> renderer) = 0;
   virtual void willRender(vesSharedPtr<vesRenderer> renderer);
 
+  /// Return true to ask for another frame although nothing was changed from
+  /// the outside, e.g. while an animation plays or while the results of
+  /// background work are waiting to be picked up in willRender().
+  virtual bool isRenderNeeded() const;
+
   virtual int numberOfFacets() = 0;
   virtual int numberOfVertices() = 0;
   virtual int numberOfLines() = 0;
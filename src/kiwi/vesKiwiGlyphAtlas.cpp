@@ -0,0 +1,382 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+
+#include "vesKiwiGlyphAtlas.h"
+#include "vesKiwiDataConversionTools.h"
+
+#include "vesGeometryData.h"
+#include "vesPrimitive.h"
+#include "vesSourceData.h"
+#include "vesTexture.h"
+
+#include <vtkFreeTypeTools.h>
+#include <vtkTextProperty.h>
+#include <vtkSmartPointer.h>
+#include <vtkUnsignedCharArray.h>
+
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <sstream>
+
+namespace {
+
+// Empty texels kept around every glyph so linear filtering never picks up
+// a neighbor.
+const int GlyphPadding = 1;
+
+// Quads addressable with 16 bit indices.
+const size_t MaximumNumberOfGlyphs = 65536 / 4;
+
+struct Glyph
+{
+  Glyph() : Loaded(false), Valid(false), Index(0), Advance(0)
+  {
+    this->Bearing[0] = this->Bearing[1] = 0;
+    this->Size[0] = this->Size[1] = 0;
+    this->Offset[0] = this->Offset[1] = 0;
+  }
+
+  bool Loaded;
+  bool Valid;
+  unsigned int Index;
+  int Bearing[2];
+  int Advance;
+  int Size[2];
+  int Offset[2];
+};
+
+typedef std::map<std::string, vesWeakPtr<vesKiwiGlyphAtlas> > AtlasMap;
+
+AtlasMap& atlases()
+{
+  static AtlasMap map;
+  return map;
+}
+
+} // end namespace
+
+//----------------------------------------------------------------------------
+class vesKiwiGlyphAtlas::vesInternal
+{
+public:
+
+  vesInternal()
+  {
+    this->Texture = vesSharedPtr<vesTexture>(new vesTexture());
+    this->TextProperty = vtkSmartPointer<vtkTextProperty>::New();
+    this->Generation = 0;
+    this->Modified = false;
+    this->Size[0] = this->Size[1] = 0;
+    this->ShelfX = this->ShelfY = GlyphPadding;
+    this->ShelfHeight = 0;
+  }
+
+  const Glyph& glyph(unsigned char c);
+  void grow();
+  void upload();
+
+  vtkSmartPointer<vtkTextProperty> TextProperty;
+  vtkSmartPointer<vtkUnsignedCharArray> Pixels;
+  unsigned char Color[3];
+  int Size[2];
+
+  // Glyphs are packed left to right on shelves stacked bottom to top.
+  int ShelfX;
+  int ShelfY;
+  int ShelfHeight;
+
+  Glyph Glyphs[256];
+
+  vesSharedPtr<vesTexture> Texture;
+  int Generation;
+  bool Modified;
+};
+
+//----------------------------------------------------------------------------
+const Glyph& vesKiwiGlyphAtlas::vesInternal::glyph(unsigned char c)
+{
+  Glyph& glyph = this->Glyphs[c];
+  if (glyph.Loaded) {
+    return glyph;
+  }
+  glyph.Loaded = true;
+
+  FT_UInt gindex;
+  FT_Bitmap* bitmap;
+  if (!vtkFreeTypeTools::GetInstance()->GetGlyphBitmap(
+        this->TextProperty, c, &gindex, &bitmap, glyph.Bearing, &glyph.Advance)) {
+    return glyph;
+  }
+
+  glyph.Valid = true;
+  glyph.Index = gindex;
+  glyph.Size[0] = bitmap->width;
+  glyph.Size[1] = bitmap->rows;
+  if (!glyph.Size[0] || !glyph.Size[1]) {
+    return glyph;
+  }
+
+  if (this->ShelfX + glyph.Size[0] + GlyphPadding > this->Size[0]) {
+    this->ShelfX = GlyphPadding;
+    this->ShelfY += this->ShelfHeight + GlyphPadding;
+    this->ShelfHeight = 0;
+  }
+  while (this->ShelfY + glyph.Size[1] + GlyphPadding > this->Size[1]) {
+    this->grow();
+  }
+
+  glyph.Offset[0] = this->ShelfX;
+  glyph.Offset[1] = this->ShelfY;
+  this->ShelfX += glyph.Size[0] + GlyphPadding;
+  this->ShelfHeight = std::max(this->ShelfHeight, glyph.Size[1]);
+
+  // FreeType rows go top down, texture rows bottom up.
+  const unsigned char* row = bitmap->buffer;
+  for (int j = glyph.Size[1] - 1; j >= 0; --j, row += bitmap->pitch) {
+    unsigned char* texel = this->Pixels->GetPointer(
+      4 * ((glyph.Offset[1] + j) * this->Size[0] + glyph.Offset[0]));
+    for (int i = 0; i < glyph.Size[0]; ++i, texel += 4) {
+      texel[0] = this->Color[0];
+      texel[1] = this->Color[1];
+      texel[2] = this->Color[2];
+      texel[3] = row[i];
+    }
+  }
+
+  this->Modified = true;
+  return glyph;
+}
+
+//----------------------------------------------------------------------------
+void vesKiwiGlyphAtlas::vesInternal::grow()
+{
+  // Rows are appended at the top, so placed glyphs keep their texels and
+  // only the vertical texture coordinates change.
+  const int height = this->Size[1] ? 2 * this->Size[1] : 64;
+  vtkSmartPointer<vtkUnsignedCharArray> pixels = vtkSmartPointer<vtkUnsignedCharArray>::New();
+  pixels->SetNumberOfComponents(4);
+  pixels->SetNumberOfTuples(this->Size[0] * height);
+
+  const size_t oldSize = 4 * this->Size[0] * this->Size[1];
+  unsigned char* data = pixels->GetPointer(0);
+  if (oldSize) {
+    memcpy(data, this->Pixels->GetPointer(0), oldSize);
+  }
+  for (size_t i = oldSize; i < 4 * static_cast<size_t>(this->Size[0] * height); i += 4) {
+    data[i] = this->Color[0];
+    data[i+1] = this->Color[1];
+    data[i+2] = this->Color[2];
+    data[i+3] = 0;
+  }
+
+  this->Pixels = pixels;
+  this->Size[1] = height;
+  ++this->Generation;
+  this->Modified = true;
+}
+
+//----------------------------------------------------------------------------
+void vesKiwiGlyphAtlas::vesInternal::upload()
+{
+  if (this->Modified) {
+    vesKiwiDataConversionTools::SetTextureData(this->Pixels, this->Texture, this->Size[0], this->Size[1]);
+    this->Modified = false;
+  }
+}
+
+//----------------------------------------------------------------------------
+vesKiwiGlyphAtlas::vesKiwiGlyphAtlas(int fontFamily, int fontSize, bool bold,
+                                     bool italic, const double color[3])
+{
+  this->Internal = new vesInternal();
+
+  vtkTextProperty* textProperty = this->Internal->TextProperty;
+  textProperty->SetFontFamily(fontFamily);
+  textProperty->SetFontSize(fontSize);
+  textProperty->SetBold(bold);
+  textProperty->SetItalic(italic);
+  textProperty->SetColor(color[0], color[1], color[2]);
+
+  for (int i = 0; i < 3; ++i) {
+    this->Internal->Color[i] = static_cast<unsigned char>(255.0 * std::max(0.0, std::min(color[i], 1.0)));
+  }
+
+  // Wide enough for a few of the largest glyphs per shelf.
+  int width = 256;
+  while (width < 4 * fontSize) {
+    width *= 2;
+  }
+  this->Internal->Size[0] = width;
+  this->Internal->grow();
+
+  for (int c = ' '; c <= '~'; ++c) {
+    this->Internal->glyph(c);
+  }
+  this->Internal->upload();
+}
+
+//----------------------------------------------------------------------------
+vesKiwiGlyphAtlas::~vesKiwiGlyphAtlas()
+{
+  delete this->Internal;
+}
+
+//----------------------------------------------------------------------------
+vesKiwiGlyphAtlas::Ptr vesKiwiGlyphAtlas::atlas(int fontFamily, int fontSize, bool bold,
+                                                bool italic, const double color[3])
+{
+  std::stringstream key;
+  key << fontFamily << " " << fontSize << " " << bold << " " << italic << " "
+      << color[0] << " " << color[1] << " " << color[2];
+
+  AtlasMap& map = atlases();
+  vesKiwiGlyphAtlas::Ptr atlas = map[key.str()].lock();
+  if (!atlas) {
+    atlas = vesKiwiGlyphAtlas::Ptr(new vesKiwiGlyphAtlas(fontFamily, fontSize, bold, italic, color));
+    map[key.str()] = atlas;
+  }
+  return atlas;
+}
+
+//----------------------------------------------------------------------------
+vesSharedPtr<vesGeometryData> vesKiwiGlyphAtlas::layoutText(const std::string& text, int size[2])
+{
+  vesSourceDataP3f::Ptr positions(new vesSourceDataP3f());
+  vesSourceDataT2f::Ptr textureCoordinates(new vesSourceDataT2f());
+  vesPrimitive::Ptr triangles(new vesPrimitive());
+  triangles->setPrimitiveType(vesPrimitiveRenderType::Triangles);
+  triangles->setIndexCount(3);
+
+  vesSharedPtr<vesGeometryData> geometryData(new vesGeometryData());
+  geometryData->setName("Text");
+  geometryData->addSource(positions);
+  geometryData->addSource(textureCoordinates);
+  geometryData->addPrimitive(triangles);
+  this->layoutText(text, size, geometryData);
+  return geometryData;
+}
+
+//----------------------------------------------------------------------------
+void vesKiwiGlyphAtlas::layoutText(const std::string& text, int size[2],
+                                   vesSharedPtr<vesGeometryData> geometryData)
+{
+  std::vector<vesVertexDataP3f>& positions = std::tr1::static_pointer_cast<vesSourceDataP3f>(
+    geometryData->sourceData(vesVertexAttributeKeys::Position))->arrayReference();
+  std::vector<vesVertexDataT2f>& textureCoordinates = std::tr1::static_pointer_cast<vesSourceDataT2f>(
+    geometryData->sourceData(vesVertexAttributeKeys::TextureCoordinate))->arrayReference();
+  std::vector<unsigned short>& indices = *geometryData->triangles()->indices();
+
+  // Glyphs may be added below, so the atlas size is only known afterwards.
+  std::vector<const Glyph*> glyphs;
+  std::vector<vesVector2f> origins;
+  glyphs.reserve(text.size());
+  origins.reserve(text.size());
+
+  vtkFreeTypeTools* freeType = vtkFreeTypeTools::GetInstance();
+  vtkTextProperty* textProperty = this->Internal->TextProperty;
+
+  float bounds[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+  int penX = 0;
+  unsigned int previousIndex = 0;
+  for (size_t i = 0; i < text.size() && glyphs.size() < MaximumNumberOfGlyphs; ++i) {
+    const Glyph& glyph = this->Internal->glyph(static_cast<unsigned char>(text[i]));
+    if (!glyph.Valid) {
+      continue;
+    }
+
+    penX += freeType->GetKerning(textProperty, previousIndex, glyph.Index);
+    previousIndex = glyph.Index;
+
+    if (glyph.Size[0] && glyph.Size[1]) {
+      vesVector2f origin(penX + glyph.Bearing[0], glyph.Bearing[1] - glyph.Size[1]);
+      if (glyphs.empty()) {
+        bounds[0] = bounds[1] = origin[0];
+        bounds[2] = bounds[3] = origin[1];
+      }
+      bounds[0] = std::min(bounds[0], origin[0]);
+      bounds[1] = std::max(bounds[1], origin[0] + glyph.Size[0]);
+      bounds[2] = std::min(bounds[2], origin[1]);
+      bounds[3] = std::max(bounds[3], origin[1] + glyph.Size[1]);
+      glyphs.push_back(&glyph);
+      origins.push_back(origin);
+    }
+
+    penX += glyph.Advance;
+  }
+
+  this->Internal->upload();
+
+  // Shrinking keeps the capacity, so the arrays only reallocate when the
+  // text gets longer than it ever was.
+  positions.resize(4 * glyphs.size());
+  textureCoordinates.resize(4 * glyphs.size());
+  indices.resize(6 * glyphs.size());
+
+  const float atlasWidth = this->Internal->Size[0];
+  const float atlasHeight = this->Internal->Size[1];
+  for (size_t i = 0; i < glyphs.size(); ++i) {
+    const Glyph& glyph = *glyphs[i];
+    const float x0 = origins[i][0] - bounds[0];
+    const float y0 = origins[i][1] - bounds[2];
+    const float s0 = glyph.Offset[0] / atlasWidth;
+    const float t0 = glyph.Offset[1] / atlasHeight;
+    const float s1 = (glyph.Offset[0] + glyph.Size[0]) / atlasWidth;
+    const float t1 = (glyph.Offset[1] + glyph.Size[1]) / atlasHeight;
+
+    for (int corner = 0; corner < 4; ++corner) {
+      const bool right = corner == 1 || corner == 2;
+      const bool top = corner >= 2;
+      positions[4 * i + corner].m_position = vesVector3f(x0 + (right ? glyph.Size[0] : 0),
+                                                         y0 + (top ? glyph.Size[1] : 0), 0.0f);
+      textureCoordinates[4 * i + corner].m_textureCoordinate =
+        vesVector2f(right ? s1 : s0, top ? t1 : t0);
+    }
+
+    const unsigned short first = static_cast<unsigned short>(4 * i);
+    unsigned short* quad = &indices[6 * i];
+    quad[0] = first;
+    quad[1] = first + 1;
+    quad[2] = first + 2;
+    quad[3] = first;
+    quad[4] = first + 2;
+    quad[5] = first + 3;
+  }
+
+  size[0] = static_cast<int>(bounds[1] - bounds[0]);
+  size[1] = static_cast<int>(bounds[3] - bounds[2]);
+
+  geometryData->setDataModified();
+  if (!glyphs.empty()) {
+    geometryData->computeBounds();
+  }
+}
+
+//----------------------------------------------------------------------------
+vesSharedPtr<vesTexture> vesKiwiGlyphAtlas::texture() const
+{
+  return this->Internal->Texture;
+}
+
+//----------------------------------------------------------------------------
+int vesKiwiGlyphAtlas::generation() const
+{
+  return this->Internal->Generation;
+}
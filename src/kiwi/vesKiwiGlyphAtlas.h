@@ -0,0 +1,88 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+/// \class vesKiwiGlyphAtlas
+/// \ingroup KiwiPlatform
+/// \brief Texture atlas of glyphs rasterized through the FreeType cache.
+///
+/// All text drawn with the same font shares one atlas. A glyph is rasterized
+/// and copied into the atlas the first time it is used (the printable ASCII
+/// range is added up front), after which laying out a string only produces
+/// one textured quad per glyph. Changing a string therefore never rasterizes
+/// or uploads a new image.
+///
+/// \see vesKiwiText2DRepresentation
+#ifndef __vesKiwiGlyphAtlas_h
+#define __vesKiwiGlyphAtlas_h
+
+// VES includes
+#include <vesSharedPtr.h>
+#include <vesSetGet.h>
+
+#include <string>
+
+class vesGeometryData;
+class vesTexture;
+
+class vesKiwiGlyphAtlas
+{
+public:
+
+  vesTypeMacro(vesKiwiGlyphAtlas);
+
+  ~vesKiwiGlyphAtlas();
+
+  /// Return the atlas of the given font, shared with every other client of
+  /// the same font while any of them holds on to it. \a fontFamily is one of
+  /// VTK_ARIAL, VTK_COURIER or VTK_TIMES, \a fontSize is in pixels.
+  static vesKiwiGlyphAtlas::Ptr atlas(int fontFamily, int fontSize, bool bold,
+                                      bool italic, const double color[3]);
+
+  /// Lay out \a text as two triangles per glyph, in pixels, with the lower
+  /// left corner of its bounding box at the origin, and return the size of
+  /// the bounding box in \a size. Characters are taken as Latin-1.
+  vesSharedPtr<vesGeometryData> layoutText(const std::string& text, int size[2]);
+
+  /// Same as above, but lay out into \a geometryData, which must come from
+  /// the method above. Its arrays are resized and overwritten in place and
+  /// marked modified, so mappers update their buffers instead of creating
+  /// new ones.
+  void layoutText(const std::string& text, int size[2],
+                  vesSharedPtr<vesGeometryData> geometryData);
+
+  /// The atlas texture, to be used with the geometry from layoutText().
+  vesSharedPtr<vesTexture> texture() const;
+
+  /// Incremented whenever the atlas grows. Text laid out with an earlier
+  /// generation has stale texture coordinates and must be laid out again.
+  int generation() const;
+
+private:
+
+  vesKiwiGlyphAtlas(int fontFamily, int fontSize, bool bold, bool italic,
+                    const double color[3]);
+
+  vesKiwiGlyphAtlas(const vesKiwiGlyphAtlas&); // Not implemented
+  void operator=(const vesKiwiGlyphAtlas&); // Not implemented
+
+  class vesInternal;
+  vesInternal* Internal;
+};
+
+#endif
@@ -20,8 +20,12 @@
 
 #include "vesKiwiImagePlaneDataRepresentation.h"
 #include "vesKiwiDataConversionTools.h"
+#include "vesActor.h"
+#include "vesMaterial.h"
+#include "vesMaterialUniforms.h"
 #include "vesSetGet.h"
 #include "vesTexture.h"
+#include "vesUniform.h"
 
 #include <vtkScalarsToColors.h>
 #include <vtkImageData.h>
@@ -32,7 +36,9 @@
 #include <vtkPoints.h>
 #include <vtkNew.h>
 #include <vtkQuad.h>
+#include <vtkUnsignedCharArray.h>
 
+#include <algorithm>
 #include <cassert>
 
 //----------------------------------------------------------------------------
@@ -42,6 +48,10 @@ public:
 
   vesInternal()
   {
+    this->FlatDimension = -1;
+    this->NumberOfSlices = 0;
+    this->AtlasColumns = 1;
+    this->SliceSpacing = 0.0;
   }
 
   ~vesInternal()
@@ -51,6 +61,16 @@ public:
   vtkSmartPointer<vtkScalarsToColors> ColorMap;
   vtkSmartPointer<vtkUnsignedCharArray> TextureData;
   vtkSmartPointer<vtkPolyData> ImagePlane;
+
+  // Volume atlas state, see setVolumeData()
+  int FlatDimension;
+  int NumberOfSlices;
+  int AtlasColumns;
+  int TileSize[2];
+  int AtlasSize[2];
+  double SliceSpacing;
+  vesSharedPtr<vesTexture> AtlasTexture;
+  vesSharedPtr<vesUniform> AtlasTileUniform;
 };
 
 //----------------------------------------------------------------------------
@@ -80,6 +100,113 @@ void vesKiwiImagePlaneDataRepresentation::setImageData(vtkImageData* imageData)
   this->setTextureFromImage(this->texture(), imageData);
 }
 
+//----------------------------------------------------------------------------
+bool vesKiwiImagePlaneDataRepresentation::volumeAtlasFits(vtkImageData* volume)
+{
+  int dimensions[3];
+  volume->GetDimensions(dimensions);
+
+  for (int flatDimension = 0; flatDimension < 3; ++flatDimension) {
+    int uAxis;
+    int vAxis;
+    int columns;
+    int rows;
+    vesKiwiDataConversionTools::GetSliceAxes(flatDimension, uAxis, vAxis);
+    if (!vesKiwiDataConversionTools::GetSliceAtlasLayout(
+          dimensions[uAxis], dimensions[vAxis], dimensions[flatDimension], columns, rows)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool vesKiwiImagePlaneDataRepresentation::setVolumeData(
+  vtkImageData* volume, vtkUnsignedCharArray* levels, int flatDimension,
+  double scalarRange[2], vesSharedPtr<vesShaderProgram> imageAtlasShader)
+{
+  assert(volume);
+  assert(levels && levels->GetNumberOfComponents() == 1);
+  assert(levels->GetNumberOfTuples() == volume->GetNumberOfPoints());
+  assert(flatDimension >= 0 && flatDimension < 3);
+  assert(this->colorMap());
+
+  int dimensions[3];
+  volume->GetDimensions(dimensions);
+
+  int uAxis;
+  int vAxis;
+  vesKiwiDataConversionTools::GetSliceAxes(flatDimension, uAxis, vAxis);
+  const int width = dimensions[uAxis];
+  const int height = dimensions[vAxis];
+  const int numberOfSlices = dimensions[flatDimension];
+
+  int columns;
+  int rows;
+  if (!vesKiwiDataConversionTools::GetSliceAtlasLayout(width, height, numberOfSlices, columns, rows)) {
+    return false;
+  }
+
+  const int atlasWidth = columns * width;
+  const int atlasHeight = rows * height;
+  vtkSmartPointer<vtkUnsignedCharArray> atlas = vesKiwiDataConversionTools::GetSliceAtlas(
+    levels, dimensions, flatDimension, columns, rows);
+
+  vesSharedPtr<vesTexture> atlasTexture(new vesTexture());
+  atlasTexture->setTextureUnit(1);
+  vesKiwiDataConversionTools::SetTextureData(atlas, atlasTexture, atlasWidth, atlasHeight);
+
+  double bounds[6];
+  volume->GetBounds(bounds);
+  bounds[2*flatDimension + 1] = bounds[2*flatDimension];
+  vtkSmartPointer<vtkPolyData> imagePlane = this->polyDataForImagePlane(bounds, flatDimension);
+  this->setPolyData(imagePlane);
+  this->Internal->ImagePlane = imagePlane;
+
+  this->vesKiwiPolyDataRepresentation::setShaderProgram(imageAtlasShader);
+  this->vesKiwiPolyDataRepresentation::setColorMap(this->colorMap(), scalarRange);
+  this->actor()->material()->addAttribute(atlasTexture);
+
+  if (!this->Internal->AtlasTileUniform) {
+    this->Internal->AtlasTileUniform = vesUniform::Ptr(
+      new vesUniform("atlasTile", vesVector4f(0.0f, 0.0f, 1.0f, 1.0f)));
+    this->materialUniforms()->addUniform(this->Internal->AtlasTileUniform);
+  }
+
+  this->Internal->AtlasTexture = atlasTexture;
+  this->Internal->FlatDimension = flatDimension;
+  this->Internal->NumberOfSlices = numberOfSlices;
+  this->Internal->AtlasColumns = columns;
+  this->Internal->TileSize[0] = width;
+  this->Internal->TileSize[1] = height;
+  this->Internal->AtlasSize[0] = atlasWidth;
+  this->Internal->AtlasSize[1] = atlasHeight;
+  this->Internal->SliceSpacing = volume->GetSpacing()[flatDimension];
+  return true;
+}
+
+//----------------------------------------------------------------------------
+void vesKiwiImagePlaneDataRepresentation::setSliceIndex(int sliceIndex)
+{
+  assert(this->Internal->AtlasTexture);
+
+  sliceIndex = std::max(0, std::min(sliceIndex, this->Internal->NumberOfSlices - 1));
+
+  // Map the plane texture coordinates onto the texel centers of the tile,
+  // so linear filtering never reads from the neighboring slices.
+  const int* tileSize = this->Internal->TileSize;
+  const int* atlasSize = this->Internal->AtlasSize;
+  const int tileX = (sliceIndex % this->Internal->AtlasColumns) * tileSize[0];
+  const int tileY = (sliceIndex / this->Internal->AtlasColumns) * tileSize[1];
+  this->Internal->AtlasTileUniform->set(vesVector4f(
+    (tileX + 0.5f) / atlasSize[0], (tileY + 0.5f) / atlasSize[1],
+    (tileSize[0] - 1.0f) / atlasSize[0], (tileSize[1] - 1.0f) / atlasSize[1]));
+
+  vesVector3f translation(0.0f, 0.0f, 0.0f);
+  translation[this->Internal->FlatDimension] = sliceIndex * this->Internal->SliceSpacing;
+  this->setTranslation(translation);
+}
+
 //----------------------------------------------------------------------------
 vesVector2f vesKiwiImagePlaneDataRepresentation::textureSize() const
 {
@@ -181,11 +308,16 @@ vtkSmartPointer<vtkPolyData> vesKiwiImagePlaneDataRepresentation::polyDataForIma
 {
   double bounds[6];
   image->GetBounds(bounds);
+  return polyDataForImagePlane(bounds, imageFlatDimension(image));
+}
 
+//----------------------------------------------------------------------------
+vtkSmartPointer<vtkPolyData> vesKiwiImagePlaneDataRepresentation::polyDataForImagePlane(
+  const double bounds[6], int flatDimension)
+{
   vtkNew<vtkPoints> quadPoints;
   quadPoints->SetNumberOfPoints(4);
 
-  const int flatDimension = vesKiwiImagePlaneDataRepresentation::imageFlatDimension(image);
   if (flatDimension == 2) {
     // XY plane
     quadPoints->SetPoint(0, bounds[0],bounds[2],bounds[4]);
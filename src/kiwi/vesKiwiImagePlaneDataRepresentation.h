@@ -30,6 +30,7 @@
 
 class vtkImageData;
 class vtkScalarsToColors;
+class vtkUnsignedCharArray;
 
 class vesKiwiImagePlaneDataRepresentation : public vesKiwiPolyDataRepresentation
 {
@@ -49,9 +50,28 @@ public:
 
   void setGrayscaleColorMap(double scalarRange[2]);
 
+  /// Upload every slice of the volume perpendicular to \a flatDimension
+  /// into a single texture atlas, drawn with \a imageAtlasShader (see
+  /// vesImageAtlas_vert.glsl). The levels are the volume scalars quantized
+  /// over \a scalarRange, see vesKiwiDataConversionTools::QuantizeScalars(),
+  /// and are colored on the GPU through the color map. Once done, switching
+  /// slices with setSliceIndex() only moves the plane and the atlas tile.
+  /// Returns false if the atlas does not fit into a texture.
+  bool setVolumeData(vtkImageData* volume, vtkUnsignedCharArray* levels,
+                     int flatDimension, double scalarRange[2],
+                     vesSharedPtr<vesShaderProgram> imageAtlasShader);
+
+  /// Show the given slice of the volume set with setVolumeData().
+  void setSliceIndex(int sliceIndex);
+
+  /// Return whether the atlases of all three axes of the volume fit into
+  /// textures, requires a current context for the actual size limit.
+  static bool volumeAtlasFits(vtkImageData* volume);
+
   virtual void setShaderProgram(vesSharedPtr<vesShaderProgram> shaderProgram);
 
   static vtkSmartPointer<vtkPolyData> polyDataForImagePlane(vtkImageData* image);
+  static vtkSmartPointer<vtkPolyData> polyDataForImagePlane(const double bounds[6], int flatDimension);
   static int imageFlatDimension(vtkImageData* image);
 
   vesVector2f textureSize() const;
@@ -25,7 +25,9 @@
 #include "vesMapper.h"
 #include "vesKiwiDataConversionTools.h"
 #include "vesKiwiImagePlaneDataRepresentation.h"
+#include "vesKiwiIsosurfaceRepresentation.h"
 #include "vesKiwiPolyDataRepresentation.h"
+#include "vesKiwiVolumeRepresentation.h"
 
 #include <vtkNew.h>
 #include <vtkImageData.h>
@@ -34,9 +36,7 @@
 #include <vtkOutlineFilter.h>
 #include <vtkPointData.h>
 #include <vtkExtractVOI.h>
-#include <vtkContourFilter.h>
-#include <vtkCellLocator.h>
-#include <vtkAppendPolyData.h>
+#include <vtkUnsignedCharArray.h>
 
 #include <vector>
 #include <map>
@@ -58,7 +58,9 @@ public:
 
     this->ContourRep = 0;
     this->OutlineRep = 0;
+    this->VolumeRep = 0;
     this->UseContour = false;
+    this->UseImageAtlas = false;
     this->InteractionEnabled = true;
   }
 
@@ -67,27 +69,44 @@ public:
     for (size_t i = 0; i < this->AllReps.size(); ++i) {
       delete this->AllReps[i];
     }
+    delete this->VolumeRep;
   }
 
+  // Values of ContourVis
+  enum ContourVisibility
+  {
+    ContourHidden = 0,
+    ContourTranslucent,
+    ContourOpaque,
+    VolumeVisible
+  };
 
   int SelectedImageDimension;
   int CurrentSliceIndices[3];
   int ContourVis;
   bool UseContour;
+  bool UseImageAtlas;
   bool InteractionEnabled;
   double ImageScalarRange[2];
+  int ImageDimensions[3];
+  double ImageOrigin[3];
+  double ImageSpacing[3];
+  double ImageBounds[6];
 
   std::vector<vesKiwiDataRepresentation*> AllReps;
   std::vector<vesKiwiImagePlaneDataRepresentation*> SliceReps;
 
   std::map<int, int> TargetSliceIndex;
 
-  vesKiwiPolyDataRepresentation* ContourRep;
+  vesKiwiIsosurfaceRepresentation* ContourRep;
   vesKiwiPolyDataRepresentation* OutlineRep;
 
+  // Shown in place of the contour, not part of AllReps
+  vesKiwiVolumeRepresentation* VolumeRep;
+
   vtkSmartPointer<vtkExtractVOI> SliceFilter;
-  vtkSmartPointer<vtkCellLocator> Locator;
-  vtkSmartPointer<vtkAppendPolyData> AppendFilter;
+  vesSharedPtr<vesShaderProgram> ImageAtlasShader;
+  vesSharedPtr<vesShaderProgram> VolumeShader;
 };
 
 //----------------------------------------------------------------------------
@@ -105,7 +124,13 @@ vesKiwiImageWidgetRepresentation::~vesKiwiImageWidgetRepresentation()
 //----------------------------------------------------------------------------
 void vesKiwiImageWidgetRepresentation::willRender(vesSharedPtr<vesRenderer> renderer)
 {
-  vesNotUsed(renderer);
+  if (this->Internal->ContourRep) {
+    this->Internal->ContourRep->willRender(renderer);
+  }
+
+  if (this->Internal->ContourVis == vesInternal::VolumeVisible) {
+    this->Internal->VolumeRep->willRender(renderer);
+  }
 
   if (this->Internal->TargetSliceIndex.size()) {
 
@@ -128,14 +153,56 @@ void vesKiwiImageWidgetRepresentation::setImageData(vtkImageData* image)
     this->Internal->SliceReps[i]->setColorMap(colorMap);
 
 
-  int dimensions[3];
+  int* dimensions = this->Internal->ImageDimensions;
   image->GetDimensions(dimensions);
+  image->GetOrigin(this->Internal->ImageOrigin);
+  image->GetSpacing(this->Internal->ImageSpacing);
+  image->GetBounds(this->Internal->ImageBounds);
   this->Internal->CurrentSliceIndices[0] = dimensions[0]/2;
   this->Internal->CurrentSliceIndices[1] = dimensions[1]/2;
   this->Internal->CurrentSliceIndices[2] = dimensions[2]/2;
 
-  this->Internal->SliceFilter = vtkSmartPointer<vtkExtractVOI>::New();
-  this->Internal->SliceFilter->SetInput(image);
+  // Both the slice atlases and the volume rendering use quantized scalars.
+  vtkSmartPointer<vtkUnsignedCharArray> levels;
+  if (image->GetNumberOfScalarComponents() == 1
+      && (this->Internal->ImageAtlasShader || this->Internal->VolumeShader)) {
+    levels = vesKiwiDataConversionTools::QuantizeScalars(
+      image->GetPointData()->GetScalars(), this->Internal->ImageScalarRange);
+  }
+
+  this->Internal->UseImageAtlas = false;
+  if (levels && this->Internal->ImageAtlasShader
+      && vesKiwiImagePlaneDataRepresentation::volumeAtlasFits(image)) {
+
+    for (int i = 0; i < 3; ++i) {
+      this->Internal->SliceReps[i]->setVolumeData(image, levels, i,
+        this->Internal->ImageScalarRange, this->Internal->ImageAtlasShader);
+    }
+    this->Internal->UseImageAtlas = true;
+  }
+
+  if (this->Internal->ContourVis == vesInternal::VolumeVisible) {
+    if (this->renderer()) {
+      this->Internal->VolumeRep->removeSelfFromRenderer(this->renderer());
+      this->Internal->ContourRep->addSelfToRenderer(this->renderer());
+    }
+    this->Internal->ContourVis = vesInternal::ContourTranslucent;
+  }
+  delete this->Internal->VolumeRep;
+  this->Internal->VolumeRep = 0;
+  if (levels && this->Internal->VolumeShader
+      && vesKiwiVolumeRepresentation::volumeFits(image)) {
+    this->Internal->VolumeRep = new vesKiwiVolumeRepresentation();
+    this->Internal->VolumeRep->initializeWithShader(this->Internal->VolumeShader);
+    this->Internal->VolumeRep->setBinNumber(3);
+    this->Internal->VolumeRep->setVolumeData(image, levels, this->Internal->ImageScalarRange,
+      vesKiwiVolumeRepresentation::defaultTransferFunction(this->Internal->ImageScalarRange));
+  }
+
+  if (!this->Internal->UseImageAtlas) {
+    this->Internal->SliceFilter = vtkSmartPointer<vtkExtractVOI>::New();
+    this->Internal->SliceFilter->SetInput(image);
+  }
 
   for (int i = 0; i < 3; ++i)
     this->setSliceIndex(i, this->Internal->CurrentSliceIndices[i]);
@@ -144,34 +211,71 @@ void vesKiwiImageWidgetRepresentation::setImageData(vtkImageData* image)
   outline->SetInput(image);
   outline->Update();
   this->Internal->OutlineRep->setPolyData(outline->GetOutput());
+  this->Internal->OutlineRep->shareGeometryData();
   this->Internal->OutlineRep->setColor(0.5, 0.5, 0.5, 0.5);
 
-  if (image->GetNumberOfPoints() < 600000) {
-    vtkNew<vtkContourFilter> contour;
-    contour->SetInput(image);
-    // contour value hardcoded for head image dataset
-    contour->SetValue(0, 1400);
-    contour->ComputeScalarsOff();
-    contour->ComputeNormalsOff();
-    contour->Update();
-
-    this->Internal->ContourRep->setPolyData(contour->GetOutput());
-    this->Internal->ContourRep->setColor(0.8, 0.8, 0.8, 0.4);
-    this->Internal->ContourVis = 1;
+  // The default contour value suits the head image dataset; other images
+  // start at the middle of their scalar range.
+  const double* range = this->Internal->ImageScalarRange;
+  double contourValue = 1400;
+  if (contourValue < range[0] || contourValue > range[1]) {
+    contourValue = 0.5 * (range[0] + range[1]);
+  }
+
+  // The surface is extracted in the background and shows up in willRender()
+  // once it is ready, so large images no longer block loading.
+  this->Internal->ContourRep->setContourValue(contourValue);
+  this->Internal->ContourRep->setImageData(image);
+  this->Internal->ContourRep->setColor(0.8, 0.8, 0.8, 0.4);
+  if (!this->Internal->UseContour) {
+    this->Internal->ContourVis = vesInternal::ContourTranslucent;
     this->Internal->AllReps.push_back(this->Internal->ContourRep);
     this->Internal->UseContour = true;
   }
 }
 
+//----------------------------------------------------------------------------
+void vesKiwiImageWidgetRepresentation::setContourValue(double value)
+{
+  this->Internal->ContourRep->setContourValue(value);
+}
+
+//----------------------------------------------------------------------------
+double vesKiwiImageWidgetRepresentation::contourValue() const
+{
+  return this->Internal->ContourRep->contourValue();
+}
+
+//----------------------------------------------------------------------------
+bool vesKiwiImageWidgetRepresentation::volumeNeedsRefinement() const
+{
+  return this->Internal->ContourVis == vesInternal::VolumeVisible
+    && this->Internal->VolumeRep->needsRefinement();
+}
+
+//----------------------------------------------------------------------------
+bool vesKiwiImageWidgetRepresentation::isExtractingContour() const
+{
+  return this->Internal->UseContour && this->Internal->ContourRep->isExtracting();
+}
+
+//----------------------------------------------------------------------------
+bool vesKiwiImageWidgetRepresentation::isRenderNeeded() const
+{
+  return this->isExtractingContour() || this->volumeNeedsRefinement();
+}
+
 //----------------------------------------------------------------------------
 void vesKiwiImageWidgetRepresentation::initializeWithShader(
   vesSharedPtr<vesShaderProgram> geometryShader,
-  vesSharedPtr<vesShaderProgram> textureShader)
+  vesSharedPtr<vesShaderProgram> textureShader,
+  vesSharedPtr<vesShaderProgram> imageAtlasShader,
+  vesSharedPtr<vesShaderProgram> volumeShader)
 {
+  this->Internal->ImageAtlasShader = imageAtlasShader;
+  this->Internal->VolumeShader = volumeShader;
 
-  this->Internal->AppendFilter = vtkSmartPointer<vtkAppendPolyData>::New();
-
-  this->Internal->ContourRep = new vesKiwiPolyDataRepresentation();
+  this->Internal->ContourRep = new vesKiwiIsosurfaceRepresentation();
   this->Internal->ContourRep->initializeWithShader(geometryShader);
   this->Internal->ContourRep->setBinNumber(2);
   this->Internal->OutlineRep = new vesKiwiPolyDataRepresentation();
@@ -185,7 +289,6 @@ void vesKiwiImageWidgetRepresentation::initializeWithShader(
     rep->setBinNumber(1);
     this->Internal->SliceReps.push_back(rep);
     this->Internal->AllReps.push_back(rep);
-    this->Internal->AppendFilter->AddInput(vtkSmartPointer<vtkPolyData>::New());
   }
 
 }
@@ -261,8 +364,7 @@ void vesKiwiImageWidgetRepresentation::scrollImageSlice(double deltaX, double de
 //----------------------------------------------------------------------------
 void vesKiwiImageWidgetRepresentation::setSliceIndex(int planeIndex, int sliceIndex)
 {
-  int dimensions[3];
-  vtkImageData::SafeDownCast(this->Internal->SliceFilter->GetInput())->GetDimensions(dimensions);
+  const int* dimensions = this->Internal->ImageDimensions;
 
   if (sliceIndex < 0) {
     sliceIndex = 0;
@@ -271,6 +373,14 @@ void vesKiwiImageWidgetRepresentation::setSliceIndex(int planeIndex, int sliceIn
     sliceIndex = dimensions[planeIndex] - 1;
   }
 
+  vesKiwiImagePlaneDataRepresentation* rep = this->Internal->SliceReps[planeIndex];
+  this->Internal->CurrentSliceIndices[planeIndex] = sliceIndex;
+
+  if (this->Internal->UseImageAtlas) {
+    rep->setSliceIndex(sliceIndex);
+    return;
+  }
+
   if (planeIndex == 0) {
     this->Internal->SliceFilter->SetVOI(sliceIndex, sliceIndex, 0, dimensions[1], 0, dimensions[2]);
   }
@@ -282,12 +392,46 @@ void vesKiwiImageWidgetRepresentation::setSliceIndex(int planeIndex, int sliceIn
   }
 
   this->Internal->SliceFilter->Update();
-  vtkImageData* sliceImage = this->Internal->SliceFilter->GetOutput();
+  rep->setImageData(this->Internal->SliceFilter->GetOutput());
+}
 
-  vesKiwiImagePlaneDataRepresentation* rep = this->Internal->SliceReps[planeIndex];
-  rep->setImageData(sliceImage);
-  this->Internal->AppendFilter->GetInput(planeIndex)->DeepCopy(rep->imagePlanePolyData());
-  this->Internal->CurrentSliceIndices[planeIndex] = sliceIndex;
+//----------------------------------------------------------------------------
+int vesKiwiImageWidgetRepresentation::pickSlicePlane(
+  const vesVector3f& point0, const vesVector3f& point1) const
+{
+  const double* bounds = this->Internal->ImageBounds;
+  const vesVector3f direction = point1 - point0;
+
+  int pickedPlane = -1;
+  double pickedT = VTK_DOUBLE_MAX;
+
+  for (int planeIndex = 0; planeIndex < 3; ++planeIndex) {
+    if (fabs(direction[planeIndex]) < 1e-12) {
+      continue;
+    }
+
+    const double planePosition = this->Internal->ImageOrigin[planeIndex]
+      + this->Internal->CurrentSliceIndices[planeIndex] * this->Internal->ImageSpacing[planeIndex];
+    const double t = (planePosition - point0[planeIndex]) / direction[planeIndex];
+    if (t < 0.0 || t > 1.0 || t >= pickedT) {
+      continue;
+    }
+
+    bool inside = true;
+    for (int i = 0; i < 3 && inside; ++i) {
+      if (i != planeIndex) {
+        const double x = point0[i] + t * direction[i];
+        inside = x >= bounds[2*i] && x <= bounds[2*i + 1];
+      }
+    }
+
+    if (inside) {
+      pickedPlane = planeIndex;
+      pickedT = t;
+    }
+  }
+
+  return pickedPlane;
 }
 
 //----------------------------------------------------------------------------
@@ -329,27 +473,11 @@ bool vesKiwiImageWidgetRepresentation::handleSingleTouchDown(int displayX, int d
   rayDirection *= 1000.0;
   rayPoint1 += rayDirection;
 
-  vtkNew<vtkCellLocator> locator;
-  this->Internal->AppendFilter->Update();
-  locator->SetDataSet(this->Internal->AppendFilter->GetOutput());
-  locator->BuildLocator();
-
-  double p0[3] = {rayPoint0[0], rayPoint0[1], rayPoint0[2]};
-  double p1[3] = {rayPoint1[0], rayPoint1[1], rayPoint1[2]};
-
-  double pickPoint[3];
-  double t;
-  double paramCoords[3];
-  vtkIdType cellId = -1;
-  int subId;
-
-  int result = locator->IntersectWithLine(p0, p1, 0.0, t, pickPoint, paramCoords, subId, cellId);
-  if (result == 1) {
-    this->Internal->SelectedImageDimension = cellId;
+  this->Internal->SelectedImageDimension = this->pickSlicePlane(rayPoint0, rayPoint1);
+  if (this->Internal->SelectedImageDimension >= 0) {
     this->interactionOn();
   }
   else {
-    this->Internal->SelectedImageDimension = -1;
     this->interactionOff();
   }
 
@@ -368,16 +496,28 @@ bool vesKiwiImageWidgetRepresentation::handleDoubleTap(int displayX, int display
     return true;
   }
 
-  this->Internal->ContourVis = (this->Internal->ContourVis + 1) % 3;
-  if (this->Internal->ContourVis == 0) {
-    this->Internal->ContourRep->removeSelfFromRenderer(this->renderer());
+  // Cycle through translucent contour, opaque contour, volume rendering
+  // when available, and none.
+  const int numberOfStates = this->Internal->VolumeRep ? 4 : 3;
+  this->Internal->ContourVis = (this->Internal->ContourVis + 1) % numberOfStates;
+  if (this->Internal->ContourVis == vesInternal::ContourHidden) {
+    if (this->Internal->VolumeRep) {
+      this->Internal->VolumeRep->removeSelfFromRenderer(this->renderer());
+    }
+    else {
+      this->Internal->ContourRep->removeSelfFromRenderer(this->renderer());
+    }
   }
-  else if (this->Internal->ContourVis == 1) {
+  else if (this->Internal->ContourVis == vesInternal::ContourTranslucent) {
     this->Internal->ContourRep->addSelfToRenderer(this->renderer());
-    this->Internal->ContourRep->mapper()->setColor(0.8, 0.8, 0.8, 0.3);
+    this->Internal->ContourRep->setColor(0.8, 0.8, 0.8, 0.3);
+  }
+  else if (this->Internal->ContourVis == vesInternal::ContourOpaque) {
+    this->Internal->ContourRep->setColor(0.8, 0.8, 0.8, 1.0);
   }
   else {
-    this->Internal->ContourRep->mapper()->setColor(0.8, 0.8, 0.8, 1.0);
+    this->Internal->ContourRep->removeSelfFromRenderer(this->renderer());
+    this->Internal->VolumeRep->addSelfToRenderer(this->renderer());
   }
 
   return true;
@@ -401,8 +541,17 @@ void vesKiwiImageWidgetRepresentation::addSelfToRenderer(
 {
   this->Superclass::addSelfToRenderer(renderer);
   for (size_t i = 0; i < this->Internal->AllReps.size(); ++i) {
+    if (this->Internal->AllReps[i] == this->Internal->ContourRep
+        && (this->Internal->ContourVis == vesInternal::ContourHidden
+            || this->Internal->ContourVis == vesInternal::VolumeVisible)) {
+      continue;
+    }
     this->Internal->AllReps[i]->addSelfToRenderer(renderer);
   }
+
+  if (this->Internal->ContourVis == vesInternal::VolumeVisible) {
+    this->Internal->VolumeRep->addSelfToRenderer(renderer);
+  }
 }
 
 //----------------------------------------------------------------------------
@@ -413,6 +562,10 @@ void vesKiwiImageWidgetRepresentation::removeSelfFromRenderer(
   for (size_t i = 0; i < this->Internal->AllReps.size(); ++i) {
     this->Internal->AllReps[i]->removeSelfFromRenderer(renderer);
   }
+
+  if (this->Internal->ContourVis == vesInternal::VolumeVisible) {
+    this->Internal->VolumeRep->removeSelfFromRenderer(renderer);
+  }
 }
 
 //----------------------------------------------------------------------------
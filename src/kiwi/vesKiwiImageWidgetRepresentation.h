@@ -40,8 +40,35 @@ public:
   ~vesKiwiImageWidgetRepresentation();
 
   void setImageData(vtkImageData* imageData);
+
+  /// Initialize the representations. When \a imageAtlasShader is given,
+  /// the slices are drawn from per axis texture atlases holding the whole
+  /// volume, so slice changes do not upload anything. Otherwise each slice
+  /// change extracts, colors and uploads a new slice image. When
+  /// \a volumeShader is given, double taps also cycle through a ray cast
+  /// rendering of the whole volume, see vesKiwiVolumeRepresentation.
   void initializeWithShader(vesSharedPtr<vesShaderProgram> geometryShader,
-                            vesSharedPtr<vesShaderProgram> textureShader);
+                            vesSharedPtr<vesShaderProgram> textureShader,
+                            vesSharedPtr<vesShaderProgram> imageAtlasShader
+                              = vesSharedPtr<vesShaderProgram>(),
+                            vesSharedPtr<vesShaderProgram> volumeShader
+                              = vesSharedPtr<vesShaderProgram>());
+
+  /// Set the value of the isosurface shown with the slices. The surface is
+  /// extracted in the background and replaces the current one when ready.
+  void setContourValue(double value);
+  double contourValue() const;
+
+  /// Return true while the isosurface for the contour value is being extracted.
+  bool isExtractingContour() const;
+
+  /// Return true if the shown volume rendering was drawn at interactive
+  /// quality and needs another frame.
+  bool volumeNeedsRefinement() const;
+
+  /// Keep rendering until the extracted isosurface has been picked up and
+  /// the volume rendering is back at full quality.
+  virtual bool isRenderNeeded() const;
 
   virtual void addSelfToRenderer(vesSharedPtr<vesRenderer> renderer);
   virtual void removeSelfFromRenderer(vesSharedPtr<vesRenderer> renderer);
@@ -68,6 +95,9 @@ protected:
 
   void scrollImageSlice(double deltaX, double deltaY);
 
+  // Returns the index of the first slice plane hit by the segment, or -1.
+  int pickSlicePlane(const vesVector3f& point0, const vesVector3f& point1) const;
+
   // note- performs clamping on sliceIndex
   void setSliceIndex(int planeIndex, int sliceIndex);
 
@@ -0,0 +1,839 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+
+#include "vesKiwiIsosurfaceExtractor.h"
+
+#include "vesConditionVariable.h"
+#include "vesGeometryData.h"
+#include "vesGLTypes.h"
+#include "vesMutex.h"
+#include "vesPrimitive.h"
+#include "vesSourceData.h"
+#include "vesThread.h"
+
+#include <vtkDataArray.h>
+#include <vtkImageData.h>
+#include <vtkPointData.h>
+#include <vtkSmartPointer.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+namespace {
+
+// Indices are unsigned short; leave room for the 12 vertices a cell may add.
+const unsigned int MaximumVerticesPerPiece = 65535 - 12;
+
+// Cube corner c sits at (c & 1, (c >> 1) & 1, (c >> 2) & 1). Edges 0-3 run
+// along x, 4-7 along y and 8-11 along z.
+const int EdgeCorners[12][2] = {
+  {0, 1}, {2, 3}, {4, 5}, {6, 7},
+  {0, 2}, {1, 3}, {4, 6}, {5, 7},
+  {0, 4}, {1, 5}, {2, 6}, {3, 7}
+};
+
+// Corners of each cube face in cyclic order.
+const int FaceCorners[6][4] = {
+  {0, 2, 6, 4}, {1, 3, 7, 5},
+  {0, 1, 5, 4}, {2, 3, 7, 6},
+  {0, 1, 3, 2}, {4, 5, 7, 6}
+};
+
+//----------------------------------------------------------------------------
+// Marching cubes triangle table, derived from the cube topology instead of
+// being spelled out. On each face the contour edges are paired up; faces
+// with four contour edges cut off the inside corners, which depends on the
+// face alone and therefore matches the neighboring cell. The pairs form
+// closed loops which are fanned into triangles facing the outside corners.
+class MarchingCubesCases
+{
+public:
+
+  static const MarchingCubesCases& instance()
+  {
+    static MarchingCubesCases* cases = 0;
+
+    vesMutexLocker locker(Mutex);
+    if (!cases) {
+      cases = new MarchingCubesCases();
+    }
+    return *cases;
+  }
+
+  // Triangles of each case as triples of edge indices
+  std::vector<unsigned char> Triangles[256];
+
+private:
+
+  static vesMutex Mutex;
+
+  MarchingCubesCases()
+  {
+    int edgeIndex[8][8];
+    for (int i = 0; i < 12; ++i) {
+      edgeIndex[EdgeCorners[i][0]][EdgeCorners[i][1]] = i;
+      edgeIndex[EdgeCorners[i][1]][EdgeCorners[i][0]] = i;
+    }
+
+    for (int mask = 1; mask < 255; ++mask) {
+      this->addCase(mask, edgeIndex);
+    }
+  }
+
+  static void corner(int c, double point[3])
+  {
+    point[0] = c & 1;
+    point[1] = (c >> 1) & 1;
+    point[2] = (c >> 2) & 1;
+  }
+
+  static void link(int partners[12][2], int a, int b)
+  {
+    partners[a][partners[a][0] < 0 ? 0 : 1] = b;
+    partners[b][partners[b][0] < 0 ? 0 : 1] = a;
+  }
+
+  void addCase(int mask, int edgeIndex[8][8])
+  {
+    int partners[12][2];
+    for (int i = 0; i < 12; ++i) {
+      partners[i][0] = partners[i][1] = -1;
+    }
+
+    for (int face = 0; face < 6; ++face) {
+      const int* c = FaceCorners[face];
+      int edges[4];
+      int active[4];
+      int numberOfActive = 0;
+      for (int i = 0; i < 4; ++i) {
+        edges[i] = edgeIndex[c[i]][c[(i + 1) % 4]];
+        if (((mask >> c[i]) & 1) != ((mask >> c[(i + 1) % 4]) & 1)) {
+          active[numberOfActive++] = edges[i];
+        }
+      }
+
+      if (numberOfActive == 2) {
+        link(partners, active[0], active[1]);
+      }
+      else if (numberOfActive == 4) {
+        // Edge i runs from corner i to corner i + 1
+        if ((mask >> c[0]) & 1) {
+          link(partners, edges[3], edges[0]);
+          link(partners, edges[1], edges[2]);
+        }
+        else {
+          link(partners, edges[0], edges[1]);
+          link(partners, edges[2], edges[3]);
+        }
+      }
+    }
+
+    bool visited[12] = {false};
+    for (int start = 0; start < 12; ++start) {
+      if (visited[start] || partners[start][0] < 0) {
+        continue;
+      }
+
+      std::vector<int> loop;
+      int previous = -1;
+      int current = start;
+      do {
+        loop.push_back(current);
+        visited[current] = true;
+        int next = partners[current][0] == previous ? partners[current][1] : partners[current][0];
+        previous = current;
+        current = next;
+      } while (current != start);
+
+      // Orient the loop so its normal points from the inside to the outside
+      double normal[3] = {0.0, 0.0, 0.0};
+      double outward[3] = {0.0, 0.0, 0.0};
+      for (size_t i = 0; i < loop.size(); ++i) {
+        double a0[3], a1[3], b0[3], b1[3];
+        corner(EdgeCorners[loop[i]][0], a0);
+        corner(EdgeCorners[loop[i]][1], a1);
+        corner(EdgeCorners[loop[(i + 1) % loop.size()]][0], b0);
+        corner(EdgeCorners[loop[(i + 1) % loop.size()]][1], b1);
+
+        const double m[3] = {a0[0] + a1[0], a0[1] + a1[1], a0[2] + a1[2]};
+        const double n[3] = {b0[0] + b1[0], b0[1] + b1[1], b0[2] + b1[2]};
+        normal[0] += m[1] * n[2] - m[2] * n[1];
+        normal[1] += m[2] * n[0] - m[0] * n[2];
+        normal[2] += m[0] * n[1] - m[1] * n[0];
+
+        const double sign = ((mask >> EdgeCorners[loop[i]][0]) & 1) ? 1.0 : -1.0;
+        for (int j = 0; j < 3; ++j) {
+          outward[j] += sign * (a1[j] - a0[j]);
+        }
+      }
+
+      if (normal[0] * outward[0] + normal[1] * outward[1] + normal[2] * outward[2] < 0.0) {
+        std::reverse(loop.begin(), loop.end());
+      }
+
+      for (size_t i = 1; i + 1 < loop.size(); ++i) {
+        this->Triangles[mask].push_back(loop[0]);
+        this->Triangles[mask].push_back(loop[i]);
+        this->Triangles[mask].push_back(loop[i + 1]);
+      }
+    }
+  }
+};
+
+vesMutex MarchingCubesCases::Mutex;
+
+//----------------------------------------------------------------------------
+struct ScalarVolume
+{
+  const void* Scalars;
+  int ScalarType;
+  int Dimensions[3];
+  double Origin[3];
+  double Spacing[3];
+};
+
+//----------------------------------------------------------------------------
+bool VolumeFromImage(vtkImageData* image, ScalarVolume& volume)
+{
+  vtkDataArray* scalars = image ? image->GetPointData()->GetScalars() : 0;
+  if (!scalars || scalars->GetNumberOfComponents() != 1) {
+    return false;
+  }
+
+  volume.Scalars = scalars->GetVoidPointer(0);
+  volume.ScalarType = scalars->GetDataType();
+  image->GetDimensions(volume.Dimensions);
+  image->GetOrigin(volume.Origin);
+  image->GetSpacing(volume.Spacing);
+  return true;
+}
+
+//----------------------------------------------------------------------------
+// Polled by the extraction threads; tells whether a newer request has
+// superseded the one being extracted.
+class CancellationCheck
+{
+public:
+
+  CancellationCheck() : Mutex(0), Generation(0), ExpectedGeneration(0)
+  {
+  }
+
+  CancellationCheck(vesMutex* mutex, const int* generation, int expectedGeneration)
+    : Mutex(mutex), Generation(generation), ExpectedGeneration(expectedGeneration)
+  {
+  }
+
+  bool requested() const
+  {
+    if (!this->Mutex) {
+      return false;
+    }
+
+    vesMutexLocker locker(*this->Mutex);
+    return *this->Generation != this->ExpectedGeneration;
+  }
+
+private:
+
+  vesMutex* Mutex;
+  const int* Generation;
+  int ExpectedGeneration;
+};
+
+//----------------------------------------------------------------------------
+template <typename T>
+class SlabContour
+{
+public:
+
+  SlabContour(const T* scalars, const ScalarVolume& volume, double isovalue)
+    : Scalars(scalars), Isovalue(isovalue), Bottom(0),
+      Cases(MarchingCubesCases::instance())
+  {
+    for (int i = 0; i < 3; ++i) {
+      this->Dimensions[i] = volume.Dimensions[i];
+      this->Origin[i] = volume.Origin[i];
+      this->Spacing[i] = volume.Spacing[i];
+    }
+
+    const int nx = this->Dimensions[0];
+    const int ny = this->Dimensions[1];
+    this->Increments[0] = 1;
+    this->Increments[1] = nx;
+    this->Increments[2] = static_cast<vtkIdType>(nx) * ny;
+
+    for (int layer = 0; layer < 2; ++layer) {
+      this->Inside[layer].resize(nx * ny);
+      this->XEdges[layer].resize(ny * (nx - 1));
+      this->YEdges[layer].resize((ny - 1) * nx);
+    }
+    this->ZEdges.resize(ny * nx);
+
+    this->newPiece();
+  }
+
+  // Contour the cells of layers [kBegin, kEnd), appending to pieces.
+  // Returns false if cancelled.
+  bool extract(int kBegin, int kEnd, const CancellationCheck& cancellation, vesKiwiIsosurfaceExtractor::Pieces& pieces)
+  {
+    const int nx = this->Dimensions[0];
+    const int ny = this->Dimensions[1];
+    this->resetCache();
+
+    this->classify(kBegin, this->Inside[this->Bottom]);
+
+    for (int k = kBegin; k < kEnd; ++k) {
+      if (cancellation.requested()) {
+        return false;
+      }
+
+      const int top = 1 - this->Bottom;
+      std::fill(this->XEdges[top].begin(), this->XEdges[top].end(), -1);
+      std::fill(this->YEdges[top].begin(), this->YEdges[top].end(), -1);
+      std::fill(this->ZEdges.begin(), this->ZEdges.end(), -1);
+      this->classify(k + 1, this->Inside[top]);
+
+      for (int j = 0; j < ny - 1; ++j) {
+        const unsigned char* below = &this->Inside[this->Bottom][j * nx];
+        const unsigned char* above = &this->Inside[top][j * nx];
+        for (int i = 0; i < nx - 1; ++i, ++below, ++above) {
+          const int mask = below[0] | (below[1] << 1) | (below[nx] << 2) | (below[nx + 1] << 3)
+            | (above[0] << 4) | (above[1] << 5) | (above[nx] << 6) | (above[nx + 1] << 7);
+
+          const std::vector<unsigned char>& triangles = this->Cases.Triangles[mask];
+          if (triangles.empty()) {
+            continue;
+          }
+
+          if (this->Source->sizeOfArray() > MaximumVerticesPerPiece) {
+            this->flush(pieces);
+            this->resetCache();
+          }
+
+          for (size_t t = 0; t < triangles.size(); ++t) {
+            int* id = this->cachedVertex(triangles[t], i, j);
+            if (*id < 0) {
+              *id = this->addVertex(triangles[t], i, j, k);
+            }
+            this->Triangles->pushBackIndices(static_cast<unsigned short>(*id));
+          }
+        }
+      }
+
+      this->Bottom = top;
+    }
+
+    this->flush(pieces);
+    return true;
+  }
+
+private:
+
+  int* cachedVertex(int edge, int i, int j)
+  {
+    const int nx = this->Dimensions[0];
+    std::vector<int>& xBottom = this->XEdges[this->Bottom];
+    std::vector<int>& xTop = this->XEdges[1 - this->Bottom];
+    std::vector<int>& yBottom = this->YEdges[this->Bottom];
+    std::vector<int>& yTop = this->YEdges[1 - this->Bottom];
+
+    switch (edge) {
+      case 0: return &xBottom[j * (nx - 1) + i];
+      case 1: return &xBottom[(j + 1) * (nx - 1) + i];
+      case 2: return &xTop[j * (nx - 1) + i];
+      case 3: return &xTop[(j + 1) * (nx - 1) + i];
+      case 4: return &yBottom[j * nx + i];
+      case 5: return &yBottom[j * nx + i + 1];
+      case 6: return &yTop[j * nx + i];
+      case 7: return &yTop[j * nx + i + 1];
+      case 8: return &this->ZEdges[j * nx + i];
+      case 9: return &this->ZEdges[j * nx + i + 1];
+      case 10: return &this->ZEdges[(j + 1) * nx + i];
+      default: return &this->ZEdges[(j + 1) * nx + i + 1];
+    }
+  }
+
+  // Mark the points of layer k that are inside the isosurface.
+  void classify(int k, std::vector<unsigned char>& inside) const
+  {
+    const T* value = this->Scalars + k * this->Increments[2];
+    const vtkIdType size = this->Increments[2];
+    for (vtkIdType i = 0; i < size; ++i) {
+      inside[i] = static_cast<double>(value[i]) >= this->Isovalue;
+    }
+  }
+
+  int addVertex(int edge, int i, int j, int k)
+  {
+    const int a = EdgeCorners[edge][0];
+    const int b = EdgeCorners[edge][1];
+    const int pointA[3] = {i + (a & 1), j + ((a >> 1) & 1), k + ((a >> 2) & 1)};
+    const int pointB[3] = {i + (b & 1), j + ((b >> 1) & 1), k + ((b >> 2) & 1)};
+
+    const double valueA = this->value(pointA);
+    const double valueB = this->value(pointB);
+    const double t = (this->Isovalue - valueA) / (valueB - valueA);
+
+    double gradientA[3];
+    double gradientB[3];
+    this->gradient(pointA, gradientA);
+    this->gradient(pointB, gradientB);
+
+    vesVertexDataP3N3f vertex;
+    for (int c = 0; c < 3; ++c) {
+      vertex.m_position[c] = this->Origin[c]
+        + this->Spacing[c] * (pointA[c] + t * (pointB[c] - pointA[c]));
+      // Scalars grow towards the inside, so the outward normal is the
+      // negated gradient.
+      vertex.m_normal[c] = -(gradientA[c] + t * (gradientB[c] - gradientA[c]));
+    }
+
+    const float length = vertex.m_normal.norm();
+    if (length > 0.0f) {
+      vertex.m_normal /= length;
+    }
+
+    this->Source->pushBack(vertex);
+    return static_cast<int>(this->Source->sizeOfArray()) - 1;
+  }
+
+  double value(const int point[3]) const
+  {
+    return static_cast<double>(this->Scalars[point[0] + point[1] * this->Increments[1]
+      + point[2] * this->Increments[2]]);
+  }
+
+  void gradient(const int point[3], double gradient[3]) const
+  {
+    const T* value = this->Scalars + point[0] + point[1] * this->Increments[1]
+      + point[2] * this->Increments[2];
+
+    for (int c = 0; c < 3; ++c) {
+      const int lower = point[c] > 0 ? 1 : 0;
+      const int upper = point[c] + 1 < this->Dimensions[c] ? 1 : 0;
+      if (lower + upper == 0) {
+        gradient[c] = 0.0;
+        continue;
+      }
+
+      const double difference = static_cast<double>(value[upper * this->Increments[c]])
+        - static_cast<double>(value[-lower * this->Increments[c]]);
+      gradient[c] = difference / ((lower + upper) * this->Spacing[c]);
+    }
+  }
+
+  void resetCache()
+  {
+    for (int layer = 0; layer < 2; ++layer) {
+      std::fill(this->XEdges[layer].begin(), this->XEdges[layer].end(), -1);
+      std::fill(this->YEdges[layer].begin(), this->YEdges[layer].end(), -1);
+    }
+    std::fill(this->ZEdges.begin(), this->ZEdges.end(), -1);
+  }
+
+  void newPiece()
+  {
+    this->Source = vesSourceDataP3N3f::Ptr(new vesSourceDataP3N3f());
+    this->Triangles = vesPrimitive::Ptr(new vesPrimitive());
+    this->Triangles->setPrimitiveType(vesPrimitiveRenderType::Triangles);
+    this->Triangles->setIndexCount(3);
+  }
+
+  void flush(vesKiwiIsosurfaceExtractor::Pieces& pieces)
+  {
+    if (!this->Triangles->numberOfIndices()) {
+      return;
+    }
+
+    vesSharedPtr<vesGeometryData> geometryData(new vesGeometryData());
+    geometryData->setName("Isosurface");
+    geometryData->addSource(this->Source);
+    geometryData->addPrimitive(this->Triangles);
+    geometryData->computeBounds();
+    pieces.push_back(geometryData);
+
+    this->newPiece();
+  }
+
+  const T* Scalars;
+  double Isovalue;
+  int Dimensions[3];
+  double Origin[3];
+  double Spacing[3];
+  vtkIdType Increments[3];
+
+  // Inside flags of the points and vertex ids of the edges of the bottom
+  // and top layers of the current cell layer, and of the edges between them.
+  std::vector<unsigned char> Inside[2];
+  std::vector<int> XEdges[2];
+  std::vector<int> YEdges[2];
+  std::vector<int> ZEdges;
+  int Bottom;
+
+  const MarchingCubesCases& Cases;
+  vesSourceDataP3N3f::Ptr Source;
+  vesPrimitive::Ptr Triangles;
+};
+
+//----------------------------------------------------------------------------
+// One extraction, shared by the threads working on it. Each thread takes
+// the next slab of layers until none is left; slabs are small enough to
+// balance the load but big enough to share most vertices.
+class ExtractionJob
+{
+public:
+
+  ExtractionJob(const ScalarVolume& volume, double isovalue, const CancellationCheck& cancellation, int numberOfSlabs)
+    : Volume(volume), Isovalue(isovalue), Cancellation(cancellation),
+      NextSlab(0), Cancelled(false), SlabPieces(numberOfSlabs)
+  {
+    const int numberOfLayers = volume.Dimensions[2] - 1;
+    for (int slab = 0; slab <= numberOfSlabs; ++slab) {
+      this->SlabBounds.push_back(slab * numberOfLayers / numberOfSlabs);
+    }
+  }
+
+  void run()
+  {
+    while (true) {
+      int slab;
+      {
+        vesMutexLocker locker(this->Mutex);
+        if (this->Cancelled || this->NextSlab >= static_cast<int>(this->SlabPieces.size())) {
+          return;
+        }
+        slab = this->NextSlab++;
+      }
+
+      if (!this->extractSlab(slab)) {
+        vesMutexLocker locker(this->Mutex);
+        this->Cancelled = true;
+        return;
+      }
+    }
+  }
+
+  // Concatenate the pieces of all slabs, in order. Call after all threads
+  // returned from run().
+  bool collect(vesKiwiIsosurfaceExtractor::Pieces& pieces)
+  {
+    if (this->Cancelled) {
+      return false;
+    }
+
+    for (size_t i = 0; i < this->SlabPieces.size(); ++i) {
+      pieces.insert(pieces.end(), this->SlabPieces[i].begin(), this->SlabPieces[i].end());
+    }
+    return true;
+  }
+
+private:
+
+  bool extractSlab(int slab)
+  {
+    const int kBegin = this->SlabBounds[slab];
+    const int kEnd = this->SlabBounds[slab + 1];
+    vesKiwiIsosurfaceExtractor::Pieces& pieces = this->SlabPieces[slab];
+
+    switch (this->Volume.ScalarType) {
+      vtkTemplateMacro(
+        return SlabContour<VTK_TT>(static_cast<const VTK_TT*>(this->Volume.Scalars),
+          this->Volume, this->Isovalue).extract(kBegin, kEnd, this->Cancellation, pieces));
+    }
+    return true;
+  }
+
+  const ScalarVolume Volume;
+  const double Isovalue;
+  const CancellationCheck Cancellation;
+
+  vesMutex Mutex;
+  int NextSlab;
+  bool Cancelled;
+  std::vector<int> SlabBounds;
+  std::vector<vesKiwiIsosurfaceExtractor::Pieces> SlabPieces;
+};
+
+//----------------------------------------------------------------------------
+class ExtractionThread : public vesThread
+{
+public:
+
+  ExtractionThread(ExtractionJob& job) : Job(job)
+  {
+  }
+
+  ~ExtractionThread()
+  {
+    this->join();
+  }
+
+protected:
+
+  virtual void run()
+  {
+    this->Job.run();
+  }
+
+private:
+
+  ExtractionJob& Job;
+};
+
+//----------------------------------------------------------------------------
+bool ExtractPieces(const ScalarVolume& volume, double isovalue, int numberOfThreads,
+                   const CancellationCheck& cancellation, vesKiwiIsosurfaceExtractor::Pieces& pieces)
+{
+  for (int i = 0; i < 3; ++i) {
+    if (volume.Dimensions[i] < 2) {
+      return true;
+    }
+  }
+
+  numberOfThreads = std::max(1, numberOfThreads);
+  const int numberOfSlabs = std::min(volume.Dimensions[2] - 1, 4 * numberOfThreads);
+  ExtractionJob job(volume, isovalue, cancellation, numberOfSlabs);
+
+  std::vector<ExtractionThread*> threads;
+  for (int i = 1; i < numberOfThreads; ++i) {
+    threads.push_back(new ExtractionThread(job));
+    if (!threads.back()->start()) {
+      delete threads.back();
+      threads.pop_back();
+      break;
+    }
+  }
+
+  job.run();
+
+  for (size_t i = 0; i < threads.size(); ++i) {
+    delete threads[i];
+  }
+
+  return job.collect(pieces);
+}
+
+} // end namespace
+
+//----------------------------------------------------------------------------
+class vesKiwiIsosurfaceExtractor::vesInternal : public vesThread
+{
+public:
+
+  vesInternal()
+  {
+    this->NumberOfThreads = vesThread::numberOfProcessors();
+    this->HasVolume = false;
+    this->Synchronous = false;
+    this->Generation = 0;
+    this->HasRequest = false;
+    this->Running = false;
+    this->HasResult = false;
+    this->Quit = false;
+    this->RequestedIsovalue = 0.0;
+    this->ResultIsovalue = 0.0;
+  }
+
+  ~vesInternal()
+  {
+    {
+      vesMutexLocker locker(this->Mutex);
+      this->Quit = true;
+      ++this->Generation;
+      this->RequestCondition.signal();
+    }
+    this->join();
+  }
+
+  // Cancel the request in progress and wait until the worker is idle.
+  // Call with the mutex locked.
+  void cancel()
+  {
+    ++this->Generation;
+    this->HasRequest = false;
+    this->HasResult = false;
+    this->Result.clear();
+    while (this->Running) {
+      this->IdleCondition.wait(this->Mutex);
+    }
+  }
+
+  vesMutex Mutex;
+  vesConditionVariable RequestCondition;
+  vesConditionVariable IdleCondition;
+
+  int NumberOfThreads;
+  vtkSmartPointer<vtkImageData> Image;
+  ScalarVolume Volume;
+  bool HasVolume;
+
+  // Set when the worker thread could not be started, requests are then
+  // extracted on the calling thread.
+  bool Synchronous;
+
+  int Generation;
+  bool HasRequest;
+  bool Running;
+  bool HasResult;
+  bool Quit;
+  double RequestedIsovalue;
+  double ResultIsovalue;
+  Pieces Result;
+
+protected:
+
+  virtual void run()
+  {
+    vesMutexLocker locker(this->Mutex);
+
+    while (true) {
+      while (!this->Quit && !this->HasRequest) {
+        this->RequestCondition.wait(this->Mutex);
+      }
+
+      if (this->Quit) {
+        return;
+      }
+
+      const ScalarVolume volume = this->Volume;
+      const double isovalue = this->RequestedIsovalue;
+      const int generation = this->Generation;
+      const int numberOfThreads = this->NumberOfThreads;
+      this->HasRequest = false;
+      this->Running = true;
+
+      Pieces pieces;
+      this->Mutex.unlock();
+      bool completed = ExtractPieces(volume, isovalue, numberOfThreads,
+        CancellationCheck(&this->Mutex, &this->Generation, generation), pieces);
+      this->Mutex.lock();
+
+      this->Running = false;
+      if (completed && generation == this->Generation) {
+        this->Result.swap(pieces);
+        this->ResultIsovalue = isovalue;
+        this->HasResult = true;
+      }
+      this->IdleCondition.broadcast();
+    }
+  }
+};
+
+//----------------------------------------------------------------------------
+vesKiwiIsosurfaceExtractor::vesKiwiIsosurfaceExtractor()
+{
+  this->Internal = new vesInternal();
+}
+
+//----------------------------------------------------------------------------
+vesKiwiIsosurfaceExtractor::~vesKiwiIsosurfaceExtractor()
+{
+  delete this->Internal;
+}
+
+//----------------------------------------------------------------------------
+void vesKiwiIsosurfaceExtractor::setImageData(vtkImageData* image)
+{
+  vesMutexLocker locker(this->Internal->Mutex);
+  this->Internal->cancel();
+
+  this->Internal->Image = image;
+  this->Internal->HasVolume = VolumeFromImage(image, this->Internal->Volume);
+
+  if (!this->Internal->Synchronous && !this->Internal->isStarted()) {
+    this->Internal->Synchronous = !this->Internal->start();
+  }
+}
+
+//----------------------------------------------------------------------------
+void vesKiwiIsosurfaceExtractor::requestIsosurface(double isovalue)
+{
+  vesMutexLocker locker(this->Internal->Mutex);
+  if (!this->Internal->HasVolume) {
+    return;
+  }
+
+  ++this->Internal->Generation;
+  this->Internal->HasResult = false;
+  this->Internal->Result.clear();
+
+  if (this->Internal->Synchronous) {
+    // Nothing extracts in the background, the isosurface is extracted here.
+    ExtractPieces(this->Internal->Volume, isovalue, this->Internal->NumberOfThreads,
+      CancellationCheck(), this->Internal->Result);
+    this->Internal->ResultIsovalue = isovalue;
+    this->Internal->HasResult = true;
+    return;
+  }
+
+  this->Internal->RequestedIsovalue = isovalue;
+  this->Internal->HasRequest = true;
+  this->Internal->RequestCondition.signal();
+}
+
+//----------------------------------------------------------------------------
+bool vesKiwiIsosurfaceExtractor::takeIsosurface(Pieces& pieces, double& isovalue)
+{
+  vesMutexLocker locker(this->Internal->Mutex);
+  if (!this->Internal->HasResult) {
+    return false;
+  }
+
+  pieces.clear();
+  pieces.swap(this->Internal->Result);
+  isovalue = this->Internal->ResultIsovalue;
+  this->Internal->HasResult = false;
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool vesKiwiIsosurfaceExtractor::isBusy() const
+{
+  vesMutexLocker locker(this->Internal->Mutex);
+  return this->Internal->HasRequest || this->Internal->Running || this->Internal->HasResult;
+}
+
+//----------------------------------------------------------------------------
+void vesKiwiIsosurfaceExtractor::setNumberOfThreads(int numberOfThreads)
+{
+  vesMutexLocker locker(this->Internal->Mutex);
+  this->Internal->NumberOfThreads = std::max(1, numberOfThreads);
+}
+
+//----------------------------------------------------------------------------
+int vesKiwiIsosurfaceExtractor::numberOfThreads() const
+{
+  vesMutexLocker locker(this->Internal->Mutex);
+  return this->Internal->NumberOfThreads;
+}
+
+//----------------------------------------------------------------------------
+vesKiwiIsosurfaceExtractor::Pieces vesKiwiIsosurfaceExtractor::extract(
+  vtkImageData* image, double isovalue, int numberOfThreads)
+{
+  Pieces pieces;
+  ScalarVolume volume;
+  if (VolumeFromImage(image, volume)) {
+    ExtractPieces(volume, isovalue, numberOfThreads, CancellationCheck(), pieces);
+  }
+  return pieces;
+}
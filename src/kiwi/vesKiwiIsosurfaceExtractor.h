@@ -0,0 +1,90 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+/// \class vesKiwiIsosurfaceExtractor
+/// \ingroup KiwiPlatform
+/// \brief Extracts isosurfaces of image data on a background thread.
+///
+/// The volume is split into slabs that are contoured with marching cubes in
+/// parallel. Each slab writes its triangles straight into vesGeometryData
+/// pieces with gradient normals; a piece never holds more vertices than 16
+/// bit indices can address, so large surfaces come back as several pieces.
+///
+/// requestIsosurface() returns immediately. A new request cancels the one
+/// in progress, so isovalues can be changed interactively. The result is
+/// picked up with takeIsosurface(), typically from willRender(). Where no
+/// thread can be started, requestIsosurface() extracts the isosurface before
+/// it returns and the result is ready to take right away.
+#ifndef __vesKiwiIsosurfaceExtractor_h
+#define __vesKiwiIsosurfaceExtractor_h
+
+// VES includes
+#include <vesSharedPtr.h>
+#include <vesSetGet.h>
+
+#include <vector>
+
+class vesGeometryData;
+class vtkImageData;
+
+class vesKiwiIsosurfaceExtractor
+{
+public:
+
+  vesTypeMacro(vesKiwiIsosurfaceExtractor);
+  typedef std::vector<vesSharedPtr<vesGeometryData> > Pieces;
+
+  vesKiwiIsosurfaceExtractor();
+  ~vesKiwiIsosurfaceExtractor();
+
+  /// Set the volume to contour. Cancels the extraction in progress and
+  /// waits for the worker to let go of the previous volume. The image must
+  /// not be modified while it is set.
+  void setImageData(vtkImageData* image);
+
+  /// Start extracting the isosurface in the background, cancelling any
+  /// earlier request that has not finished yet.
+  void requestIsosurface(double isovalue);
+
+  /// If an isosurface finished since the last call, return true and hand
+  /// over its pieces and isovalue.
+  bool takeIsosurface(Pieces& pieces, double& isovalue);
+
+  /// Return true while the last request has not been taken yet.
+  bool isBusy() const;
+
+  /// Number of threads used per extraction, defaults to the number of
+  /// processors.
+  void setNumberOfThreads(int numberOfThreads);
+  int numberOfThreads() const;
+
+  /// Extract the isosurface on the calling thread plus numberOfThreads - 1
+  /// helper threads and return when done.
+  static Pieces extract(vtkImageData* image, double isovalue, int numberOfThreads);
+
+private:
+
+  vesKiwiIsosurfaceExtractor(const vesKiwiIsosurfaceExtractor&); // Not implemented
+  void operator=(const vesKiwiIsosurfaceExtractor&); // Not implemented
+
+  class vesInternal;
+  vesInternal* Internal;
+};
+
+#endif
@@ -0,0 +1,243 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+
+#include "vesKiwiIsosurfaceRepresentation.h"
+#include "vesKiwiIsosurfaceExtractor.h"
+#include "vesKiwiPolyDataRepresentation.h"
+
+#include "vesGeometryData.h"
+#include "vesRenderer.h"
+#include "vesShaderProgram.h"
+
+#include <vtkImageData.h>
+
+#include <vector>
+#include <cassert>
+
+//----------------------------------------------------------------------------
+class vesKiwiIsosurfaceRepresentation::vesInternal
+{
+public:
+
+  vesInternal()
+  {
+    this->ContourValue = 0.0;
+    this->BinNumber = 0;
+    this->Color[0] = this->Color[1] = this->Color[2] = this->Color[3] = 1.0;
+  }
+
+  ~vesInternal()
+  {
+    this->clearPieces();
+  }
+
+  void clearPieces()
+  {
+    for (size_t i = 0; i < this->PieceReps.size(); ++i) {
+      if (this->Renderer) {
+        this->PieceReps[i]->removeSelfFromRenderer(this->Renderer);
+      }
+      delete this->PieceReps[i];
+    }
+    this->PieceReps.clear();
+  }
+
+  vesKiwiIsosurfaceExtractor Extractor;
+  vesSharedPtr<vesShaderProgram> ShaderProgram;
+  vesSharedPtr<vesRenderer> Renderer;
+  std::vector<vesKiwiPolyDataRepresentation*> PieceReps;
+
+  double ContourValue;
+  double Color[4];
+  int BinNumber;
+};
+
+//----------------------------------------------------------------------------
+vesKiwiIsosurfaceRepresentation::vesKiwiIsosurfaceRepresentation()
+{
+  this->Internal = new vesInternal();
+}
+
+//----------------------------------------------------------------------------
+vesKiwiIsosurfaceRepresentation::~vesKiwiIsosurfaceRepresentation()
+{
+  delete this->Internal;
+}
+
+//----------------------------------------------------------------------------
+void vesKiwiIsosurfaceRepresentation::initializeWithShader(
+  vesSharedPtr<vesShaderProgram> shaderProgram)
+{
+  assert(shaderProgram);
+  this->Internal->ShaderProgram = shaderProgram;
+}
+
+//----------------------------------------------------------------------------
+void vesKiwiIsosurfaceRepresentation::setImageData(vtkImageData* image)
+{
+  this->Internal->Extractor.setImageData(image);
+  this->Internal->Extractor.requestIsosurface(this->Internal->ContourValue);
+}
+
+//----------------------------------------------------------------------------
+void vesKiwiIsosurfaceRepresentation::setContourValue(double value)
+{
+  if (value == this->Internal->ContourValue) {
+    return;
+  }
+
+  this->Internal->ContourValue = value;
+  this->Internal->Extractor.requestIsosurface(value);
+}
+
+//----------------------------------------------------------------------------
+double vesKiwiIsosurfaceRepresentation::contourValue() const
+{
+  return this->Internal->ContourValue;
+}
+
+//----------------------------------------------------------------------------
+bool vesKiwiIsosurfaceRepresentation::isExtracting() const
+{
+  return this->Internal->Extractor.isBusy();
+}
+
+//----------------------------------------------------------------------------
+void vesKiwiIsosurfaceRepresentation::willRender(vesSharedPtr<vesRenderer> renderer)
+{
+  vesNotUsed(renderer);
+
+  vesKiwiIsosurfaceExtractor::Pieces pieces;
+  double contourValue;
+  if (!this->Internal->Extractor.takeIsosurface(pieces, contourValue)) {
+    return;
+  }
+
+  this->Internal->clearPieces();
+
+  for (size_t i = 0; i < pieces.size(); ++i) {
+    vesKiwiPolyDataRepresentation* rep = new vesKiwiPolyDataRepresentation();
+    rep->initializeWithShader(this->Internal->ShaderProgram);
+    rep->setGeometryData(pieces[i]);
+    rep->setColor(this->Internal->Color[0], this->Internal->Color[1],
+                  this->Internal->Color[2], this->Internal->Color[3]);
+    rep->setBinNumber(this->Internal->BinNumber);
+    if (this->Internal->Renderer) {
+      rep->addSelfToRenderer(this->Internal->Renderer);
+    }
+    this->Internal->PieceReps.push_back(rep);
+  }
+}
+
+//----------------------------------------------------------------------------
+void vesKiwiIsosurfaceRepresentation::setColor(double r, double g, double b, double a)
+{
+  this->Internal->Color[0] = r;
+  this->Internal->Color[1] = g;
+  this->Internal->Color[2] = b;
+  this->Internal->Color[3] = a;
+
+  for (size_t i = 0; i < this->Internal->PieceReps.size(); ++i) {
+    this->Internal->PieceReps[i]->setColor(r, g, b, a);
+  }
+}
+
+//----------------------------------------------------------------------------
+void vesKiwiIsosurfaceRepresentation::setBinNumber(int binNumber)
+{
+  this->Internal->BinNumber = binNumber;
+
+  for (size_t i = 0; i < this->Internal->PieceReps.size(); ++i) {
+    this->Internal->PieceReps[i]->setBinNumber(binNumber);
+  }
+}
+
+//----------------------------------------------------------------------------
+void vesKiwiIsosurfaceRepresentation::setShaderProgram(
+  vesSharedPtr<vesShaderProgram> shaderProgram)
+{
+  if (!shaderProgram) {
+    return;
+  }
+
+  this->Internal->ShaderProgram = shaderProgram;
+
+  for (size_t i = 0; i < this->Internal->PieceReps.size(); ++i) {
+    this->Internal->PieceReps[i]->setShaderProgram(shaderProgram);
+  }
+}
+
+//----------------------------------------------------------------------------
+vesSharedPtr<vesShaderProgram> vesKiwiIsosurfaceRepresentation::shaderProgram() const
+{
+  return this->Internal->ShaderProgram;
+}
+
+//----------------------------------------------------------------------------
+void vesKiwiIsosurfaceRepresentation::addSelfToRenderer(
+  vesSharedPtr<vesRenderer> renderer)
+{
+  assert(renderer);
+  this->Internal->Renderer = renderer;
+
+  for (size_t i = 0; i < this->Internal->PieceReps.size(); ++i) {
+    this->Internal->PieceReps[i]->addSelfToRenderer(renderer);
+  }
+}
+
+//----------------------------------------------------------------------------
+void vesKiwiIsosurfaceRepresentation::removeSelfFromRenderer(
+  vesSharedPtr<vesRenderer> renderer)
+{
+  assert(renderer);
+
+  for (size_t i = 0; i < this->Internal->PieceReps.size(); ++i) {
+    this->Internal->PieceReps[i]->removeSelfFromRenderer(renderer);
+  }
+
+  this->Internal->Renderer.reset();
+}
+
+//----------------------------------------------------------------------------
+int vesKiwiIsosurfaceRepresentation::numberOfFacets()
+{
+  int count = 0;
+  for (size_t i = 0; i < this->Internal->PieceReps.size(); ++i)
+    count += this->Internal->PieceReps[i]->numberOfFacets();
+  return count;
+}
+
+//----------------------------------------------------------------------------
+int vesKiwiIsosurfaceRepresentation::numberOfVertices()
+{
+  int count = 0;
+  for (size_t i = 0; i < this->Internal->PieceReps.size(); ++i)
+    count += this->Internal->PieceReps[i]->numberOfVertices();
+  return count;
+}
+
+//----------------------------------------------------------------------------
+int vesKiwiIsosurfaceRepresentation::numberOfLines()
+{
+  int count = 0;
+  for (size_t i = 0; i < this->Internal->PieceReps.size(); ++i)
+    count += this->Internal->PieceReps[i]->numberOfLines();
+  return count;
+}
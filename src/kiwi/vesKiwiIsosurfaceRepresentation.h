@@ -0,0 +1,79 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+/// \class vesKiwiIsosurfaceRepresentation
+/// \ingroup KiwiPlatform
+/// \brief Shows an isosurface of image data, extracted in the background.
+///
+/// Changing the contour value restarts the extraction; the previous surface
+/// stays visible until the new one is picked up in willRender().
+/// \see vesKiwiIsosurfaceExtractor
+#ifndef __vesKiwiIsosurfaceRepresentation_h
+#define __vesKiwiIsosurfaceRepresentation_h
+
+#include "vesKiwiDataRepresentation.h"
+
+class vesShaderProgram;
+
+class vtkImageData;
+
+class vesKiwiIsosurfaceRepresentation : public vesKiwiDataRepresentation
+{
+public:
+
+  vesTypeMacro(vesKiwiIsosurfaceRepresentation);
+
+  vesKiwiIsosurfaceRepresentation();
+  ~vesKiwiIsosurfaceRepresentation();
+
+  void initializeWithShader(vesSharedPtr<vesShaderProgram> shaderProgram);
+
+  /// Set the image and start extracting the surface at the contour value.
+  void setImageData(vtkImageData* image);
+
+  void setContourValue(double value);
+  double contourValue() const;
+
+  /// Return true while the surface for the contour value is not shown yet.
+  bool isExtracting() const;
+
+  void setColor(double r, double g, double b, double a);
+  void setBinNumber(int binNumber);
+
+  void setShaderProgram(vesSharedPtr<vesShaderProgram> shaderProgram);
+  vesSharedPtr<vesShaderProgram> shaderProgram() const;
+
+  virtual void addSelfToRenderer(vesSharedPtr<vesRenderer> renderer);
+  virtual void removeSelfFromRenderer(vesSharedPtr<vesRenderer> renderer);
+  virtual void willRender(vesSharedPtr<vesRenderer> renderer);
+
+  virtual int numberOfFacets();
+  virtual int numberOfVertices();
+  virtual int numberOfLines();
+
+private:
+
+  vesKiwiIsosurfaceRepresentation(const vesKiwiIsosurfaceRepresentation&); // Not implemented
+  void operator=(const vesKiwiIsosurfaceRepresentation&); // Not implemented
+
+  class vesInternal;
+  vesInternal* Internal;
+};
+
+#endif
@@ -0,0 +1,303 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+
+#include "vesKiwiLoadScheduler.h"
+
+#include "vesConditionVariable.h"
+#include "vesGeometryData.h"
+#include "vesKiwiDataLoader.h"
+#include "vesKiwiPolyDataRepresentation.h"
+#include "vesMutex.h"
+#include "vesThread.h"
+
+#include <vtkDataSet.h>
+#include <vtkPolyData.h>
+
+#include <algorithm>
+#include <cassert>
+#include <vector>
+
+//----------------------------------------------------------------------------
+vesKiwiLoadScheduler::Job::Job(const std::string& filename)
+  : Filename(filename), Loaded(false)
+{
+}
+
+//----------------------------------------------------------------------------
+vesKiwiLoadScheduler::Job::~Job()
+{
+}
+
+//----------------------------------------------------------------------------
+const std::string& vesKiwiLoadScheduler::Job::filename() const
+{
+  return this->Filename;
+}
+
+//----------------------------------------------------------------------------
+bool vesKiwiLoadScheduler::Job::load()
+{
+  vesKiwiDataLoader dataLoader;
+  this->GeometryData = dataLoader.loadGeometryData(this->Filename);
+  if (this->GeometryData) {
+    this->GeometryData->computeBounds();
+    return true;
+  }
+  else if (!dataLoader.errorMessage().empty()) {
+    this->ErrorTitle = dataLoader.errorTitle();
+    this->ErrorMessage = dataLoader.errorMessage();
+    return false;
+  }
+
+  this->DataSet = dataLoader.loadDataset(this->Filename);
+  if (!this->DataSet) {
+    this->ErrorTitle = dataLoader.errorTitle();
+    this->ErrorMessage = dataLoader.errorMessage();
+    return false;
+  }
+
+  if (vtkPolyData* polyData = this->polyData()) {
+    // Bounds are computed on first request and cached in the dataset.
+    polyData->GetBounds();
+    this->GeometryData = this->convertPolyData(polyData);
+  }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+vesSharedPtr<vesGeometryData> vesKiwiLoadScheduler::Job::convertPolyData(vtkPolyData* polyData)
+{
+  return vesKiwiPolyDataRepresentation::convertPolyData(polyData);
+}
+
+//----------------------------------------------------------------------------
+bool vesKiwiLoadScheduler::Job::isLoaded() const
+{
+  return this->Loaded;
+}
+
+//----------------------------------------------------------------------------
+vtkSmartPointer<vtkDataSet> vesKiwiLoadScheduler::Job::dataSet() const
+{
+  return this->DataSet;
+}
+
+//----------------------------------------------------------------------------
+vtkPolyData* vesKiwiLoadScheduler::Job::polyData() const
+{
+  return vtkPolyData::SafeDownCast(this->DataSet);
+}
+
+//----------------------------------------------------------------------------
+vesSharedPtr<vesGeometryData> vesKiwiLoadScheduler::Job::geometryData() const
+{
+  return this->GeometryData;
+}
+
+//----------------------------------------------------------------------------
+std::string vesKiwiLoadScheduler::Job::errorTitle() const
+{
+  return this->ErrorTitle;
+}
+
+//----------------------------------------------------------------------------
+std::string vesKiwiLoadScheduler::Job::errorMessage() const
+{
+  return this->ErrorMessage;
+}
+
+//----------------------------------------------------------------------------
+class vesKiwiLoadScheduler::vesInternal
+{
+public:
+
+  class LoadThread : public vesThread
+  {
+  public:
+
+    LoadThread(vesInternal* internal) : Internal(internal)
+    {
+    }
+
+    ~LoadThread()
+    {
+      this->join();
+    }
+
+  protected:
+
+    virtual void run()
+    {
+      this->Internal->loadJobs();
+    }
+
+    vesInternal* Internal;
+  };
+
+  vesInternal()
+  {
+    this->NumberOfThreads = 1;
+    this->MaximumLoadedJobs = 1;
+    this->NextJob = 0;
+    this->NextResult = 0;
+    this->Started = false;
+    this->Quit = false;
+  }
+
+  void loadJobs();
+
+  int NumberOfThreads;
+  int MaximumLoadedJobs;
+  std::vector<LoadThread*> Threads;
+
+  vesMutex Mutex;
+  vesConditionVariable JobAllowed;
+  vesConditionVariable JobLoaded;
+
+  // Guarded by Mutex. Jobs are dropped once handed out by next().
+  std::vector<vesKiwiLoadScheduler::Job::Ptr> Jobs;
+  std::vector<bool> Done;
+  size_t NextJob;
+  size_t NextResult;
+  bool Started;
+  bool Quit;
+};
+
+//----------------------------------------------------------------------------
+void vesKiwiLoadScheduler::vesInternal::loadJobs()
+{
+  vesMutexLocker locker(this->Mutex);
+  for (;;) {
+    while (!this->Quit && this->NextJob < this->Jobs.size()
+           && this->NextJob >= this->NextResult + this->MaximumLoadedJobs) {
+      this->JobAllowed.wait(this->Mutex);
+    }
+    if (this->Quit || this->NextJob == this->Jobs.size()) {
+      return;
+    }
+
+    const size_t index = this->NextJob++;
+    vesKiwiLoadScheduler::Job::Ptr job = this->Jobs[index];
+
+    this->Mutex.unlock();
+    const bool loaded = job->load();
+    this->Mutex.lock();
+
+    job->Loaded = loaded;
+    this->Done[index] = true;
+    this->JobLoaded.broadcast();
+  }
+}
+
+//----------------------------------------------------------------------------
+vesKiwiLoadScheduler::vesKiwiLoadScheduler(int numberOfThreads, int maximumLoadedJobs)
+{
+  this->Internal = new vesInternal();
+  this->Internal->NumberOfThreads = numberOfThreads > 0 ? numberOfThreads
+                                                        : vesThread::numberOfProcessors();
+  this->Internal->MaximumLoadedJobs = maximumLoadedJobs > 0 ? maximumLoadedJobs
+                                                            : 2 * this->Internal->NumberOfThreads;
+}
+
+//----------------------------------------------------------------------------
+vesKiwiLoadScheduler::~vesKiwiLoadScheduler()
+{
+  {
+    vesMutexLocker locker(this->Internal->Mutex);
+    this->Internal->Quit = true;
+    this->Internal->JobAllowed.broadcast();
+  }
+
+  for (size_t i = 0; i < this->Internal->Threads.size(); ++i) {
+    delete this->Internal->Threads[i];
+  }
+
+  delete this->Internal;
+}
+
+//----------------------------------------------------------------------------
+void vesKiwiLoadScheduler::addJob(Job::Ptr job)
+{
+  assert(job);
+  vesMutexLocker locker(this->Internal->Mutex);
+  assert(!this->Internal->Started);
+  this->Internal->Jobs.push_back(job);
+  this->Internal->Done.push_back(false);
+}
+
+//----------------------------------------------------------------------------
+void vesKiwiLoadScheduler::start()
+{
+  {
+    vesMutexLocker locker(this->Internal->Mutex);
+    if (this->Internal->Started) {
+      return;
+    }
+    this->Internal->Started = true;
+  }
+
+  const int numberOfThreads = std::min(this->Internal->NumberOfThreads,
+    static_cast<int>(this->Internal->Jobs.size()));
+  for (int i = 0; i < numberOfThreads; ++i) {
+    vesInternal::LoadThread* thread = new vesInternal::LoadThread(this->Internal);
+    if (!thread->start()) {
+      delete thread;
+      break;
+    }
+    this->Internal->Threads.push_back(thread);
+  }
+}
+
+//----------------------------------------------------------------------------
+vesKiwiLoadScheduler::Job::Ptr vesKiwiLoadScheduler::next()
+{
+  this->start();
+
+  vesMutexLocker locker(this->Internal->Mutex);
+  vesInternal* internal = this->Internal;
+  if (internal->NextResult == internal->Jobs.size()) {
+    return Job::Ptr();
+  }
+
+  const size_t index = internal->NextResult;
+  if (internal->Threads.empty()) {
+    // Nothing loads in the background, the job is loaded here.
+    ++internal->NextJob;
+    Job::Ptr job = internal->Jobs[index];
+    job->Loaded = job->load();
+    internal->Done[index] = true;
+  }
+
+  while (!internal->Done[index]) {
+    internal->JobLoaded.wait(internal->Mutex);
+  }
+
+  Job::Ptr job = internal->Jobs[index];
+  internal->Jobs[index].reset();
+  ++internal->NextResult;
+  internal->JobAllowed.broadcast();
+  return job;
+}
+
+//----------------------------------------------------------------------------
+int vesKiwiLoadScheduler::numberOfThreads() const
+{
+  return this->Internal->NumberOfThreads;
+}
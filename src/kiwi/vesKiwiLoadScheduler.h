@@ -0,0 +1,139 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+/// \class vesKiwiLoadScheduler
+/// \ingroup KiwiPlatform
+/// \brief Loads independent files concurrently and hands them back in order.
+///
+/// Each file is a Job whose load() reads, filters and converts it on one of
+/// the loading threads; polydata is converted to vesGeometryData there, so
+/// only building the scene is left to the calling thread. next() returns
+/// the jobs in the order they were added, waiting for the next one if it is
+/// still loading.
+///
+/// At most maximumLoadedJobs jobs are loaded or loading ahead of the last
+/// one returned by next(), which bounds the memory held by results nobody
+/// consumed yet.
+#ifndef __vesKiwiLoadScheduler_h
+#define __vesKiwiLoadScheduler_h
+
+// VES includes
+#include <vesSharedPtr.h>
+#include <vesSetGet.h>
+
+#include <vtkSmartPointer.h>
+
+#include <string>
+
+class vesGeometryData;
+class vtkDataSet;
+class vtkPolyData;
+
+class vesKiwiLoadScheduler
+{
+public:
+
+  vesTypeMacro(vesKiwiLoadScheduler);
+
+  /// One file to load. Subclasses add work that has to happen off the
+  /// calling thread by overriding load(); it must not touch the scene or
+  /// anything shared with other jobs.
+  class Job
+  {
+  public:
+
+    vesTypeMacro(Job);
+
+    explicit Job(const std::string& filename);
+    virtual ~Job();
+
+    const std::string& filename() const;
+
+    /// Read the file with a vesKiwiDataLoader and convert polydata to
+    /// geometry data. STL, PLY and OBJ files the mesh reader handles are
+    /// read straight into geometry data, leaving dataSet() NULL. Return
+    /// false if the file could not be loaded.
+    virtual bool load();
+
+    /// True once load() succeeded.
+    bool isLoaded() const;
+
+    vtkSmartPointer<vtkDataSet> dataSet() const;
+
+    /// The dataset as polydata, or NULL for other datasets.
+    vtkPolyData* polyData() const;
+
+    /// The converted or directly read geometry, NULL for other datasets.
+    vesSharedPtr<vesGeometryData> geometryData() const;
+
+    std::string errorTitle() const;
+    std::string errorMessage() const;
+
+  protected:
+
+    /// Convert the loaded polydata, called by load(). The default uses
+    /// vesKiwiPolyDataRepresentation::convertPolyData().
+    virtual vesSharedPtr<vesGeometryData> convertPolyData(vtkPolyData* polyData);
+
+  private:
+
+    Job(const Job&); // Not implemented
+    void operator=(const Job&); // Not implemented
+
+    friend class vesKiwiLoadScheduler;
+
+    std::string Filename;
+    bool Loaded;
+    vtkSmartPointer<vtkDataSet> DataSet;
+    vesSharedPtr<vesGeometryData> GeometryData;
+    std::string ErrorTitle;
+    std::string ErrorMessage;
+  };
+
+  /// Load with \a numberOfThreads threads, defaulting to the number of
+  /// processors, keeping at most \a maximumLoadedJobs results ahead,
+  /// defaulting to twice the number of threads.
+  explicit vesKiwiLoadScheduler(int numberOfThreads=0, int maximumLoadedJobs=0);
+
+  /// Waits for the jobs being loaded, jobs not started are dropped.
+  ~vesKiwiLoadScheduler();
+
+  /// Queue a job. Jobs can only be added before start().
+  void addJob(Job::Ptr job);
+
+  /// Start loading the queued jobs.
+  void start();
+
+  /// Return the next job in the order they were added once it is loaded,
+  /// or an empty pointer after the last job. Check isLoaded() for errors.
+  /// Without loading threads, the job is loaded here.
+  Job::Ptr next();
+
+  int numberOfThreads() const;
+
+private:
+
+  vesKiwiLoadScheduler(const vesKiwiLoadScheduler&); // Not implemented
+  void operator=(const vesKiwiLoadScheduler&); // Not implemented
+
+  class vesInternal;
+  vesInternal* Internal;
+};
+
+#endif
@@ -0,0 +1,262 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+
+#include "vesKiwiOverlayBatch.h"
+#include "vesKiwiGlyphAtlas.h"
+#include "vesKiwiText2DRepresentation.h"
+
+#include "vesActor.h"
+#include "vesCamera.h"
+#include "vesGeometryData.h"
+#include "vesMapper.h"
+#include "vesPrimitive.h"
+#include "vesRenderer.h"
+#include "vesSourceData.h"
+
+#include <algorithm>
+#include <cassert>
+#include <vector>
+
+namespace {
+
+// Quads addressable with 16 bit indices.
+const size_t MaximumNumberOfQuads = 65536 / 4;
+
+// What a label looked like when the vertex buffer was last built. Labels
+// lay their text out in place, so the geometry alone does not tell.
+struct LabelState
+{
+  vesSharedPtr<vesGeometryData> Geometry;
+  unsigned int GeometryVersion;
+  vesVector2f DisplayPosition;
+
+  bool operator==(const LabelState& other) const
+  {
+    return this->Geometry == other.Geometry && this->GeometryVersion == other.GeometryVersion
+      && this->DisplayPosition == other.DisplayPosition;
+  }
+};
+
+} // end namespace
+
+//----------------------------------------------------------------------------
+class vesKiwiOverlayBatch::vesInternal
+{
+public:
+
+  vesInternal()
+  {
+    this->NumberOfQuads = 0;
+  }
+
+  ~vesInternal()
+  {
+  }
+
+  std::vector<vesKiwiText2DRepresentation*> Labels;
+  std::vector<LabelState> BuiltStates;
+
+  // Scratch space of willRender(), kept to avoid allocating every frame.
+  std::vector<LabelState> States;
+  std::vector<vesKiwiText2DRepresentation*> AnchoredLabels;
+  std::vector<vesVector3f> WorldPoints;
+  std::vector<vesVector3f> DisplayPoints;
+
+  vesKiwiGlyphAtlas::Ptr GlyphAtlas;
+  size_t NumberOfQuads;
+  vesSharedPtr<vesRenderer> Renderer;
+};
+
+//----------------------------------------------------------------------------
+vesKiwiOverlayBatch::vesKiwiOverlayBatch()
+{
+  this->Internal = new vesInternal();
+}
+
+//----------------------------------------------------------------------------
+vesKiwiOverlayBatch::~vesKiwiOverlayBatch()
+{
+  if (this->Internal->Renderer) {
+    this->removeSelfFromRenderer(this->Internal->Renderer);
+  }
+  delete this->Internal;
+}
+
+//----------------------------------------------------------------------------
+bool vesKiwiOverlayBatch::addLabel(vesKiwiText2DRepresentation* label)
+{
+  assert(label);
+  assert(this->actor());
+
+  if (std::find(this->Internal->Labels.begin(), this->Internal->Labels.end(), label)
+      != this->Internal->Labels.end()) {
+    return true;
+  }
+
+  if (this->Internal->Labels.empty()) {
+    if (this->Internal->GlyphAtlas != label->glyphAtlas()) {
+      this->Internal->GlyphAtlas = label->glyphAtlas();
+      this->setTexture(this->Internal->GlyphAtlas->texture());
+    }
+    this->actor()->setIsOverlayNode(true);
+    this->setBinNumber(20);
+  }
+  else if (label->glyphAtlas() != this->Internal->GlyphAtlas) {
+    return false;
+  }
+
+  this->Internal->Labels.push_back(label);
+  return true;
+}
+
+//----------------------------------------------------------------------------
+void vesKiwiOverlayBatch::removeLabel(vesKiwiText2DRepresentation* label)
+{
+  this->Internal->Labels.erase(
+    std::remove(this->Internal->Labels.begin(), this->Internal->Labels.end(), label),
+    this->Internal->Labels.end());
+}
+
+//----------------------------------------------------------------------------
+int vesKiwiOverlayBatch::numberOfLabels() const
+{
+  return static_cast<int>(this->Internal->Labels.size());
+}
+
+//----------------------------------------------------------------------------
+void vesKiwiOverlayBatch::willRender(vesSharedPtr<vesRenderer> renderer)
+{
+  assert(renderer);
+  std::vector<vesKiwiText2DRepresentation*>& labels = this->Internal->Labels;
+
+  // Labels laid out before the atlas grew need new texture coordinates.
+  for (size_t i = 0; i < labels.size(); ++i) {
+    labels[i]->setText(labels[i]->text());
+  }
+
+  // Place all the labels following world points in one pass.
+  vesVector3f anchorDirection = renderer->camera()->viewUp();
+  anchorDirection.normalize();
+  std::vector<vesKiwiText2DRepresentation*>& anchoredLabels = this->Internal->AnchoredLabels;
+  std::vector<vesVector3f>& worldPoints = this->Internal->WorldPoints;
+  anchoredLabels.clear();
+  worldPoints.clear();
+  for (size_t i = 0; i < labels.size(); ++i) {
+    if (labels[i]->worldAnchorPointEnabled()) {
+      anchoredLabels.push_back(labels[i]);
+      worldPoints.push_back(labels[i]->worldAnchorPoint()
+                            - anchorDirection * labels[i]->anchorOffset());
+    }
+  }
+
+  if (!worldPoints.empty()) {
+    std::vector<vesVector3f>& displayPoints = this->Internal->DisplayPoints;
+    renderer->computeWorldToDisplay(worldPoints, displayPoints);
+    for (size_t i = 0; i < anchoredLabels.size(); ++i) {
+      anchoredLabels[i]->setDisplayPosition(vesVector2f(
+        displayPoints[i][0] - anchoredLabels[i]->textWidth() / 2.0,
+        displayPoints[i][1]));
+    }
+  }
+
+  std::vector<LabelState>& states = this->Internal->States;
+  states.resize(labels.size());
+  for (size_t i = 0; i < labels.size(); ++i) {
+    states[i].Geometry = labels[i]->actor()->mapper()->geometryData();
+    states[i].GeometryVersion = states[i].Geometry ? states[i].Geometry->dataVersion() : 0;
+    states[i].DisplayPosition = labels[i]->displayPosition();
+  }
+  if (states != this->Internal->BuiltStates) {
+    this->Internal->BuiltStates = states;
+    this->rebuild();
+  }
+
+  // The batch manages its own actor, which is only in the scene while
+  // there is something to draw.
+  if (this->Internal->Renderer && (!this->Internal->NumberOfQuads || this->Internal->Renderer != renderer)) {
+    this->removeSelfFromRenderer(this->Internal->Renderer);
+    this->Internal->Renderer.reset();
+  }
+  if (!this->Internal->Renderer && this->Internal->NumberOfQuads) {
+    this->addSelfToRenderer(renderer);
+    this->Internal->Renderer = renderer;
+  }
+}
+
+//----------------------------------------------------------------------------
+void vesKiwiOverlayBatch::rebuild()
+{
+  std::vector<vesKiwiText2DRepresentation*>& labels = this->Internal->Labels;
+  const std::vector<LabelState>& states = this->Internal->BuiltStates;
+
+  vesSourceDataP3f::Ptr positions(new vesSourceDataP3f());
+  vesSourceDataT2f::Ptr textureCoordinates(new vesSourceDataT2f());
+  vesPrimitive::Ptr triangles(new vesPrimitive());
+  triangles->setPrimitiveType(vesPrimitiveRenderType::Triangles);
+  triangles->setIndexCount(3);
+
+  for (size_t i = 0; i < labels.size(); ++i) {
+    vesSharedPtr<vesGeometryData> geometryData = states[i].Geometry;
+    if (!geometryData) {
+      continue;
+    }
+
+    vesSourceDataP3f::Ptr labelPositions = std::tr1::static_pointer_cast<vesSourceDataP3f>(
+      geometryData->sourceData(vesVertexAttributeKeys::Position));
+    vesSourceDataT2f::Ptr labelTextureCoordinates = std::tr1::static_pointer_cast<vesSourceDataT2f>(
+      geometryData->sourceData(vesVertexAttributeKeys::TextureCoordinate));
+    if (!labelPositions || !labelTextureCoordinates) {
+      continue;
+    }
+
+    const vesVector2f& displayPosition = states[i].DisplayPosition;
+    const vesVector3f offset(displayPosition[0], displayPosition[1], 0.0f);
+    const std::vector<vesVertexDataP3f>& labelVertices = labelPositions->arrayReference();
+    const std::vector<vesVertexDataT2f>& labelTexels = labelTextureCoordinates->arrayReference();
+    for (size_t quad = 0; quad < labelVertices.size() / 4; ++quad) {
+      if (positions->sizeOfArray() / 4 >= MaximumNumberOfQuads) {
+        break;
+      }
+
+      const unsigned short first = static_cast<unsigned short>(positions->sizeOfArray());
+      for (size_t corner = 4 * quad; corner < 4 * quad + 4; ++corner) {
+        vesVertexDataP3f vertex;
+        vertex.m_position = labelVertices[corner].m_position + offset;
+        positions->pushBack(vertex);
+        textureCoordinates->pushBack(labelTexels[corner]);
+      }
+      triangles->pushBackIndices(first, first + 1, first + 2);
+      triangles->pushBackIndices(first, first + 2, first + 3);
+    }
+  }
+
+  this->Internal->NumberOfQuads = positions->sizeOfArray() / 4;
+  if (!this->Internal->NumberOfQuads) {
+    return;
+  }
+
+  vesSharedPtr<vesGeometryData> geometryData(new vesGeometryData());
+  geometryData->setName("OverlayBatch");
+  geometryData->addSource(positions);
+  geometryData->addSource(textureCoordinates);
+  geometryData->addPrimitive(triangles);
+  geometryData->computeBounds();
+  this->setGeometryData(geometryData);
+}
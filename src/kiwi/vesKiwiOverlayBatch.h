@@ -0,0 +1,70 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+/// \class vesKiwiOverlayBatch
+/// \ingroup KiwiPlatform
+/// \brief Draws the overlay text labels sharing a glyph atlas with one actor.
+///
+/// Labels added to the batch do not put their own actor into the scene.
+/// Instead, willRender() places the labels anchored at world points with a
+/// single world to display transform and, if any label moved or changed,
+/// concatenates the glyph quads of all labels into one vertex buffer that
+/// is drawn with a single call. The batch adds its actor to the renderer
+/// passed to willRender() while there is anything to draw, do not add it
+/// yourself.
+///
+/// \see vesKiwiText2DRepresentation::setOverlayBatch()
+#ifndef __vesKiwiOverlayBatch_h
+#define __vesKiwiOverlayBatch_h
+
+#include "vesKiwiPolyDataRepresentation.h"
+
+class vesKiwiText2DRepresentation;
+
+class vesKiwiOverlayBatch : public vesKiwiPolyDataRepresentation
+{
+public:
+
+  vesTypeMacro(vesKiwiOverlayBatch);
+
+  vesKiwiOverlayBatch();
+  ~vesKiwiOverlayBatch();
+
+  /// Draw \a label as part of the batch. Returns false if the label uses a
+  /// different glyph atlas than the labels already in the batch.
+  bool addLabel(vesKiwiText2DRepresentation* label);
+  void removeLabel(vesKiwiText2DRepresentation* label);
+  int numberOfLabels() const;
+
+  /// Position the labels and rebuild the vertex buffer if needed. Call once
+  /// per frame after the labels themselves have been updated.
+  virtual void willRender(vesSharedPtr<vesRenderer> renderer);
+
+private:
+
+  void rebuild();
+
+  vesKiwiOverlayBatch(const vesKiwiOverlayBatch&); // Not implemented
+  void operator=(const vesKiwiOverlayBatch&); // Not implemented
+
+  class vesInternal;
+  vesInternal* Internal;
+};
+
+#endif
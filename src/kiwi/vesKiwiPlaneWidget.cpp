@@ -32,7 +32,6 @@
 #include <vtkPlaneSource.h>
 #include <vtkPolyData.h>
 #include <vtkPointData.h>
-#include <vtkCellLocator.h>
 #include <vtkAppendPolyData.h>
 #include <vtkSmartPointer.h>
 #include <vtkTransform.h>
@@ -149,11 +148,13 @@ void vesKiwiPlaneWidget::initializeWithShader(vesSharedPtr<vesShaderProgram> geo
   this->Internal->PlaneRep->setBinNumber(10);
   this->Internal->PlaneRep->setPolyData(this->Internal->PlaneSource->GetOutput());
   this->Internal->PlaneRep->setColor(1.0, 1.0, 0.0, 0.15);
+  this->Internal->PlaneRep->shareGeometryData();
 
   this->Internal->NormalRep = vesKiwiPolyDataRepresentation::Ptr(new vesKiwiPolyDataRepresentation());
   this->Internal->NormalRep->initializeWithShader(geometryShader);
   this->Internal->NormalRep->setBinNumber(1);
   this->Internal->NormalRep->setPolyData(this->Internal->Handle->GetOutput());
+  this->Internal->NormalRep->shareGeometryData();
 
   // make the handle bigger so that it is easier to pick
   this->Internal->SphereSource->SetRadius(0.3);
@@ -260,29 +261,6 @@ bool vesKiwiPlaneWidget::handleSingleTouchPanGesture(double deltaX, double delta
   return true;
 }
 
-namespace {
-
-bool PickDataSet(vtkDataSet* dataSet, const vesVector3f& rayPoint0, const vesVector3f& rayPoint1)
-{
-  vtkNew<vtkCellLocator> locator;
-  locator->SetDataSet(dataSet);
-  locator->BuildLocator();
-
-  double p0[3] = {rayPoint0[0], rayPoint0[1], rayPoint0[2]};
-  double p1[3] = {rayPoint1[0], rayPoint1[1], rayPoint1[2]};
-
-  double pickPoint[3];
-  double t;
-  double paramCoords[3];
-  vtkIdType cellId = -1;
-  int subId;
-
-  int result = locator->IntersectWithLine(p0, p1, 0, t, pickPoint, paramCoords, subId, cellId);
-  return (result == 1);
-}
-
-}
-
 //----------------------------------------------------------------------------
 bool vesKiwiPlaneWidget::handleSingleTouchDown(int displayX, int displayY)
 {
@@ -290,25 +268,25 @@ bool vesKiwiPlaneWidget::handleSingleTouchDown(int displayX, int displayY)
     return false;
   }
 
-  // calculate the focal depth so we'll know how far to move
   vesRenderer::Ptr ren = this->renderer();
 
   // flip Y coordinate
   displayY = ren->height() - displayY;
 
-  vesVector3f rayPoint0 = ren->computeDisplayToWorld(vesVector3f(displayX, displayY, /*focalDepth=*/0.0));
-  vesVector3f rayPoint1 = ren->computeDisplayToWorld(vesVector3f(displayX, displayY, /*focalDepth=*/1.0));
-
-  this->Internal->WidgetTransform->GetLinearInverse()->TransformPoint(rayPoint0.data(), rayPoint0.data());
-  this->Internal->WidgetTransform->GetLinearInverse()->TransformPoint(rayPoint1.data(), rayPoint1.data());
+  // only the widget geometry is drawn into the id buffer, so the models
+  // behind or in front of it don't get in the way
+  std::vector<vesActor::Ptr> widgetActors;
+  widgetActors.push_back(this->Internal->NormalRep->actor());
+  widgetActors.push_back(this->Internal->PlaneRep->actor());
+  vesActor::Ptr pickedActor = ren->pickActor(displayX, displayY, widgetActors);
 
-  if (PickDataSet(this->Internal->Handle->GetOutput(), rayPoint0, rayPoint1)) {
+  if (pickedActor == this->Internal->NormalRep->actor()) {
     this->Internal->InteractionIsRotate = true;
     this->Internal->InteractionIsTranslate = false;
     this->Internal->NormalRep->setColor(0.0, 1.0, 0.0, 1.0);
     this->interactionOn();
   }
-  else if (PickDataSet(this->Internal->PlaneSource->GetOutput(), rayPoint0, rayPoint1)) {
+  else if (pickedActor == this->Internal->PlaneRep->actor()) {
     this->Internal->InteractionIsRotate = false;
     this->Internal->InteractionIsTranslate = true;
     this->Internal->PlaneRep->setColor(0.0, 1.0, 0.0, 0.15);
@@ -26,9 +26,12 @@
 #include "vesGeometryData.h"
 #include "vesMapper.h"
 #include "vesMaterial.h"
+#include "vesMaterialUniforms.h"
 #include "vesRenderer.h"
+#include "vesResourceCache.h"
 #include "vesShaderProgram.h"
 #include "vesTexture.h"
+#include "vesUniform.h"
 
 #include "vesPVWebDataSet.h"
 
@@ -37,6 +40,7 @@
 #include <vtkNew.h>
 #include <vtkTriangleFilter.h>
 #include <vtkLookupTable.h>
+#include <vtkUnsignedCharArray.h>
 
 #include <cassert>
 
@@ -95,6 +99,7 @@ public:
 
   vesInternal()
   {
+    this->ShaderFeatures = NoShaderFeatures;
   }
 
   ~vesInternal()
@@ -107,6 +112,9 @@ public:
   vesSharedPtr<vesTexture>   Texture;
   vesSharedPtr<vesBlend>     Blend;
   vesSharedPtr<vesDepth>     Depth;
+  vesSharedPtr<vesMaterialUniforms> Uniforms;
+  vesSharedPtr<vesUniform>   ScalarRangeUniform;
+  unsigned int ShaderFeatures;
 };
 
 //----------------------------------------------------------------------------
@@ -127,9 +135,18 @@ void vesKiwiPolyDataRepresentation::setPolyData(vtkPolyData* polyData, vtkScalar
   assert(polyData);
   assert(this->Internal->Mapper);
 
+  this->Internal->Mapper->setGeometryData(convertPolyData(polyData, scalarsToColors));
+}
+
+//----------------------------------------------------------------------------
+vesSharedPtr<vesGeometryData> vesKiwiPolyDataRepresentation::convertPolyData(
+  vtkPolyData* polyData, vtkScalarsToColors* scalarsToColors)
+{
+  assert(polyData);
+
   vesSharedPtr<vesGeometryData> geometryData = GeometryDataFromPolyData(polyData);
   ConvertVertexArrays(polyData, geometryData, scalarsToColors);
-  this->Internal->Mapper->setGeometryData(geometryData);
+  return geometryData;
 }
 
 //----------------------------------------------------------------------------
@@ -227,6 +244,14 @@ void vesKiwiPolyDataRepresentation::setPVWebData(const vesSharedPtr<vesPVWebData
 
 }
 
+//----------------------------------------------------------------------------
+void vesKiwiPolyDataRepresentation::setGeometryData(vesSharedPtr<vesGeometryData> geometryData)
+{
+  assert(geometryData);
+  assert(this->Internal->Mapper);
+  this->Internal->Mapper->setGeometryData(geometryData);
+}
+
 //----------------------------------------------------------------------------
 vesSharedPtr<vesGeometryData> vesKiwiPolyDataRepresentation::geometryData() const
 {
@@ -236,6 +261,14 @@ vesSharedPtr<vesGeometryData> vesKiwiPolyDataRepresentation::geometryData() cons
   return vesSharedPtr<vesGeometryData>();
 }
 
+//----------------------------------------------------------------------------
+void vesKiwiPolyDataRepresentation::shareGeometryData()
+{
+  assert(this->Internal->Mapper);
+  this->Internal->Mapper->setGeometryData(
+    vesResourceCache::instance()->geometryData(this->Internal->Mapper->geometryData()));
+}
+
 //----------------------------------------------------------------------------
 void vesKiwiPolyDataRepresentation::addTextureCoordinates(vtkDataArray* textureCoordinates)
 {
@@ -243,9 +276,60 @@ void vesKiwiPolyDataRepresentation::addTextureCoordinates(vtkDataArray* textureC
   assert(this->Internal->Mapper->geometryData());
 
   vesGeometryData::Ptr geometryData = this->Internal->Mapper->geometryData();
+  // Arrays can only be added before the mapper releases them after upload.
+  assert(geometryData->isResident());
   vesKiwiDataConversionTools::SetTextureCoordinates(textureCoordinates, geometryData);
 }
 
+//----------------------------------------------------------------------------
+void vesKiwiPolyDataRepresentation::addVertexScalars(vtkDataArray* scalars)
+{
+  assert(this->Internal->Mapper);
+  assert(this->Internal->Mapper->geometryData());
+
+  vesGeometryData::Ptr geometryData = this->Internal->Mapper->geometryData();
+  // Arrays can only be added before the mapper releases them after upload.
+  assert(geometryData->isResident());
+  vesKiwiDataConversionTools::SetVertexScalars(scalars, geometryData);
+}
+
+//----------------------------------------------------------------------------
+void vesKiwiPolyDataRepresentation::setColorMap(vtkScalarsToColors* colorMap, double scalarRange[2])
+{
+  assert(colorMap);
+
+  vtkSmartPointer<vtkUnsignedCharArray> colorTable =
+    vesKiwiDataConversionTools::GetColorTable(colorMap, scalarRange);
+  this->setTexture(vesKiwiDataConversionTools::SharedTexture(
+    colorTable, colorTable->GetNumberOfTuples(), 1));
+  this->setScalarRange(scalarRange[0], scalarRange[1]);
+}
+
+//----------------------------------------------------------------------------
+void vesKiwiPolyDataRepresentation::setScalarRange(double minimum, double maximum)
+{
+  if (!this->Internal->ScalarRangeUniform) {
+    this->Internal->ScalarRangeUniform = vesUniform::Ptr(
+      new vesUniform("scalarRange", vesVector2f(0.0f, 1.0f)));
+    this->materialUniforms()->addUniform(this->Internal->ScalarRangeUniform);
+  }
+
+  this->Internal->ScalarRangeUniform->set(vesVector2f(minimum, maximum));
+}
+
+//----------------------------------------------------------------------------
+vesSharedPtr<vesMaterialUniforms> vesKiwiPolyDataRepresentation::materialUniforms()
+{
+  assert(this->Internal->Actor);
+
+  if (!this->Internal->Uniforms) {
+    this->Internal->Uniforms = vesMaterialUniforms::Ptr(new vesMaterialUniforms());
+    this->Internal->Actor->material()->addAttribute(this->Internal->Uniforms);
+  }
+
+  return this->Internal->Uniforms;
+}
+
 //----------------------------------------------------------------------------
 void vesKiwiPolyDataRepresentation::setTranslation(const vesVector3f& translation)
 {
@@ -270,6 +354,18 @@ vesSharedPtr<vesShaderProgram> vesKiwiPolyDataRepresentation::shaderProgram() co
   return this->Internal->Actor->material()->shaderProgram();
 }
 
+//----------------------------------------------------------------------------
+void vesKiwiPolyDataRepresentation::setShaderFeatures(unsigned int features)
+{
+  this->Internal->ShaderFeatures = features;
+}
+
+//----------------------------------------------------------------------------
+unsigned int vesKiwiPolyDataRepresentation::shaderFeatures() const
+{
+  return this->Internal->ShaderFeatures;
+}
+
 //----------------------------------------------------------------------------
 void vesKiwiPolyDataRepresentation::initializeWithShader(
   vesSharedPtr<vesShaderProgram> shaderProgram)
@@ -300,6 +396,13 @@ void vesKiwiPolyDataRepresentation::setBinNumber(int binNumber)
   this->Internal->Actor->material()->setBinNumber(binNumber);
 }
 
+//----------------------------------------------------------------------------
+void vesKiwiPolyDataRepresentation::setSortTriangles(bool enable)
+{
+  assert(this->Internal->Mapper);
+  this->Internal->Mapper->setSortTriangles(enable);
+}
+
 //----------------------------------------------------------------------------
 void vesKiwiPolyDataRepresentation::setTexture(vesSharedPtr<vesTexture> texture)
 {
@@ -359,20 +462,39 @@ vesSharedPtr<vesMapper> vesKiwiPolyDataRepresentation::mapper() const
 //----------------------------------------------------------------------------
 int vesKiwiPolyDataRepresentation::numberOfFacets()
 {
-  vesPrimitive::Ptr tris = this->geometryData()->triangles();
-  return tris ? static_cast<int>(tris->size()) : 0;
+  // The mapper may have released the arrays after upload.
+  vesGeometryData::Ptr geometryData = this->geometryData();
+  if (!geometryData->lockData()) {
+    return 0;
+  }
+  vesPrimitive::Ptr tris = geometryData->triangles();
+  const int count = tris ? static_cast<int>(tris->size()) : 0;
+  geometryData->unlockData();
+  return count;
 }
 
 //----------------------------------------------------------------------------
 int vesKiwiPolyDataRepresentation::numberOfVertices()
 {
-  vesSourceData::Ptr points = this->geometryData()->sourceData(vesVertexAttributeKeys::Position);
-  return points ? static_cast<int>(points->sizeOfArray()) : 0;
+  vesGeometryData::Ptr geometryData = this->geometryData();
+  if (!geometryData->lockData()) {
+    return 0;
+  }
+  vesSourceData::Ptr points = geometryData->sourceData(vesVertexAttributeKeys::Position);
+  const int count = points ? static_cast<int>(points->sizeOfArray()) : 0;
+  geometryData->unlockData();
+  return count;
 }
 
 //----------------------------------------------------------------------------
 int vesKiwiPolyDataRepresentation::numberOfLines()
 {
-  vesPrimitive::Ptr lines = this->geometryData()->lines();
-  return lines ? static_cast<int>(lines->size()) : 0;
+  vesGeometryData::Ptr geometryData = this->geometryData();
+  if (!geometryData->lockData()) {
+    return 0;
+  }
+  vesPrimitive::Ptr lines = geometryData->lines();
+  const int count = lines ? static_cast<int>(lines->size()) : 0;
+  geometryData->unlockData();
+  return count;
 }
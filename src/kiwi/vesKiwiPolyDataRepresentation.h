@@ -30,6 +30,7 @@
 class vesGeometryData;
 class vesActor;
 class vesMapper;
+class vesMaterialUniforms;
 class vesRenderer;
 class vesShaderProgram;
 class vesTexture;
@@ -46,6 +47,18 @@ public:
 
   vesTypeMacro(vesKiwiPolyDataRepresentation);
 
+  /// What the shader program of a representation has to support, see
+  /// vesSurface_vert.glsl for the matching shader symbols.
+  enum ShaderFeature
+  {
+    NoShaderFeatures = 0,
+    Lighting         = 0x1,
+    VertexColors     = 0x2,
+    Texture          = 0x4,
+    ClipPlane        = 0x8,
+    PointSprites     = 0x10
+  };
+
   vesKiwiPolyDataRepresentation();
   ~vesKiwiPolyDataRepresentation();
 
@@ -53,12 +66,45 @@ public:
 
   void setPolyData(vtkPolyData* polyData, vtkScalarsToColors* scalarsToColors=NULL);
 
+  /// Convert polydata to the geometry data setPolyData() shows. It only
+  /// touches its arguments, so independent datasets can be converted on
+  /// several threads at once.
+  static vesSharedPtr<vesGeometryData> convertPolyData(vtkPolyData* polyData,
+    vtkScalarsToColors* scalarsToColors=NULL);
+
   void setPVWebData(const vesSharedPtr<vesPVWebDataSet> dataset);
 
   void addTextureCoordinates(vtkDataArray* textureCoordinates);
 
+  /// Add the scalars as a float vertex attribute to color them on the GPU.
+  /// This requires a shader program reading the vertexScalar attribute and
+  /// the scalarRange and colorMap uniforms, see vesScalarColorMap_vert.glsl.
+  /// \see setColorMap() setScalarRange()
+  void addVertexScalars(vtkDataArray* scalars);
+
+  /// Set the lookup table texture used to color the vertex scalars, sampled
+  /// from the color map over the given scalar range. Changing the color map
+  /// only uploads the new lookup table, the geometry is left untouched.
+  void setColorMap(vtkScalarsToColors* colorMap, double scalarRange[2]);
+
+  /// Set the scalar range mapped onto the lookup table texture.
+  void setScalarRange(double minimum, double maximum);
+
+  /// Uniform values private to this representation, overriding the values
+  /// set on its shader program. Created on first access.
+  vesSharedPtr<vesMaterialUniforms> materialUniforms();
+
+  /// Show geometry data built elsewhere, e.g. by a background filter.
+  void setGeometryData(vesSharedPtr<vesGeometryData> geometryData);
+
   vesSharedPtr<vesGeometryData> geometryData() const;
 
+  /// Replace the geometry data with the copy of identical content shared
+  /// through vesResourceCache, so that it is stored and uploaded only once.
+  /// Only call this after the geometry data is complete; it must not be
+  /// modified afterwards.
+  void shareGeometryData();
+
   virtual void addSelfToRenderer(vesSharedPtr<vesRenderer> renderer);
   virtual void removeSelfFromRenderer(vesSharedPtr<vesRenderer>);
 
@@ -70,11 +116,23 @@ public:
 
   void setBinNumber(int binNumber);
 
+  /// Draw the triangles back to front, for translucent surfaces that
+  /// overlap themselves. \see vesMapper::setSortTriangles()
+  void setSortTriangles(bool enable);
+
   virtual void setTranslation(const vesVector3f& translation);
 
   virtual void setShaderProgram(vesSharedPtr<vesShaderProgram> shaderProgram);
   virtual vesSharedPtr<vesShaderProgram> shaderProgram() const;
 
+  /// Declare the ShaderFeature flags this representation needs. The
+  /// application then picks the program, and picks it again when the
+  /// shading model changes. Representations declaring NoShaderFeatures, the
+  /// default, keep the program they are given.
+  /// \see vesKiwiViewerApp::surfaceShader()
+  void setShaderFeatures(unsigned int features);
+  unsigned int shaderFeatures() const;
+
   virtual int numberOfFacets();
   virtual int numberOfVertices();
   virtual int numberOfLines();
@@ -19,19 +19,15 @@
  ========================================================================*/
 
 #include "vesKiwiText2DRepresentation.h"
+#include "vesKiwiGlyphAtlas.h"
+#include "vesKiwiOverlayBatch.h"
 #include "vesActor.h"
 #include "vesRenderer.h"
 #include "vesCamera.h"
-#include "vesTexture.h"
-#include "vesImage.h"
+#include "vesGeometryData.h"
+#include "vesMapper.h"
 
-#include <vtkFreeTypeStringToImage.h>
 #include <vtkTextProperty.h>
-#include <vtkSmartPointer.h>
-#include <vtkStdString.h>
-#include <vtkImageData.h>
-#include <vtkPolyData.h>
-#include <vtkNew.h>
 
 #include <cassert>
 
@@ -42,16 +38,28 @@ public:
 
   vesInternal()
   {
-    this->TextToImage = vtkSmartPointer<vtkFreeTypeStringToImage>::New();
     this->WorldAnchorPointEnabled = false;
     this->AnchorOffset = 0.0;
+    this->AtlasGeneration = -1;
+    this->TextSize[0] = this->TextSize[1] = 0;
+    this->Batched = false;
+
+    const double color[3] = {1.0, 0.8, 0.0};
+    this->GlyphAtlas = vesKiwiGlyphAtlas::atlas(VTK_ARIAL, 32, false, false, color);
   }
 
   ~vesInternal()
   {
   }
 
-  vtkSmartPointer<vtkFreeTypeStringToImage> TextToImage;
+  vesKiwiGlyphAtlas::Ptr GlyphAtlas;
+  int AtlasGeneration;
+  std::string Text;
+  int TextSize[2];
+  vesSharedPtr<vesGeometryData> Geometry;
+
+  vesKiwiOverlayBatch::Ptr OverlayBatch;
+  bool Batched;
 
   bool WorldAnchorPointEnabled;
   double AnchorOffset;
@@ -68,6 +76,9 @@ vesKiwiText2DRepresentation::vesKiwiText2DRepresentation()
 //----------------------------------------------------------------------------
 vesKiwiText2DRepresentation::~vesKiwiText2DRepresentation()
 {
+  if (this->Internal->Batched) {
+    this->Internal->OverlayBatch->removeLabel(this);
+  }
   delete this->Internal;
 }
 
@@ -76,21 +87,80 @@ void vesKiwiText2DRepresentation::setText(const std::string& text)
 {
   assert(this->actor());
 
-  vtkNew<vtkTextProperty> textProperty;
-  textProperty->SetFontFamilyToArial();
-  textProperty->SetFontSize(32);
-  textProperty->SetColor(1.0, 0.8, 0.0);
+  if (!this->texture()) {
+    this->setTexture(this->Internal->GlyphAtlas->texture());
+    this->actor()->setIsOverlayNode(true);
+    this->setBinNumber(20);
+  }
+  else if (text == this->Internal->Text
+           && this->Internal->AtlasGeneration == this->Internal->GlyphAtlas->generation()) {
+    return;
+  }
+
+  // Only the quads change, the glyphs are rasterized once into the atlas,
+  // and they are laid out into the same arrays and buffers every time.
+  this->Internal->Text = text;
+  if (!this->Internal->Geometry) {
+    this->Internal->Geometry = this->Internal->GlyphAtlas->layoutText(text, this->Internal->TextSize);
+    this->setGeometryData(this->Internal->Geometry);
+  }
+  else {
+    this->Internal->GlyphAtlas->layoutText(text, this->Internal->TextSize, this->Internal->Geometry);
+    this->mapper()->setBoundsDirty(true);
+  }
+  this->Internal->AtlasGeneration = this->Internal->GlyphAtlas->generation();
+}
 
-  vtkNew<vtkImageData> imageTexture;
-  this->Internal->TextToImage->RenderString(textProperty.GetPointer(), text, imageTexture.GetPointer());
+//----------------------------------------------------------------------------
+const std::string& vesKiwiText2DRepresentation::text() const
+{
+  return this->Internal->Text;
+}
 
-  // The above call to RenderString() sets the imageTexture origin so some nonzero value, not sure why
-  imageTexture->SetOrigin(0, 0, 0);
+//----------------------------------------------------------------------------
+vesSharedPtr<vesKiwiGlyphAtlas> vesKiwiText2DRepresentation::glyphAtlas() const
+{
+  return this->Internal->GlyphAtlas;
+}
 
-  this->setImageData(imageTexture.GetPointer());
+//----------------------------------------------------------------------------
+void vesKiwiText2DRepresentation::setOverlayBatch(vesSharedPtr<vesKiwiOverlayBatch> batch)
+{
+  assert(!this->Internal->Batched);
+  this->Internal->OverlayBatch = batch;
+}
 
-  this->actor()->setIsOverlayNode(true);
-  this->setBinNumber(20);
+//----------------------------------------------------------------------------
+vesSharedPtr<vesKiwiOverlayBatch> vesKiwiText2DRepresentation::overlayBatch() const
+{
+  return this->Internal->OverlayBatch;
+}
+
+//----------------------------------------------------------------------------
+void vesKiwiText2DRepresentation::addSelfToRenderer(vesSharedPtr<vesRenderer> renderer)
+{
+  if (this->Internal->Batched) {
+    return;
+  }
+
+  if (this->Internal->OverlayBatch && this->Internal->OverlayBatch->addLabel(this)) {
+    this->Internal->Batched = true;
+    return;
+  }
+
+  this->Superclass::addSelfToRenderer(renderer);
+}
+
+//----------------------------------------------------------------------------
+void vesKiwiText2DRepresentation::removeSelfFromRenderer(vesSharedPtr<vesRenderer> renderer)
+{
+  if (this->Internal->Batched) {
+    this->Internal->OverlayBatch->removeLabel(this);
+    this->Internal->Batched = false;
+    return;
+  }
+
+  this->Superclass::removeSelfFromRenderer(renderer);
 }
 
 //----------------------------------------------------------------------------
@@ -145,13 +215,29 @@ vesVector2f vesKiwiText2DRepresentation::displayPosition() const
 //----------------------------------------------------------------------------
 int vesKiwiText2DRepresentation::textWidth()
 {
-  return this->texture()->image()->width();
+  return this->Internal->TextSize[0];
+}
+
+//----------------------------------------------------------------------------
+int vesKiwiText2DRepresentation::textHeight()
+{
+  return this->Internal->TextSize[1];
 }
 
 //----------------------------------------------------------------------------
 void vesKiwiText2DRepresentation::willRender(vesSharedPtr<vesRenderer> renderer)
 {
-  if (!this->Internal->WorldAnchorPointEnabled || !this->texture()) {
+  // The batch updates and places its labels all at once.
+  if (this->Internal->Batched || !this->texture()) {
+    return;
+  }
+
+  // Another text grew the shared atlas, refresh the texture coordinates.
+  if (this->Internal->AtlasGeneration != this->Internal->GlyphAtlas->generation()) {
+    this->setText(this->Internal->Text);
+  }
+
+  if (!this->Internal->WorldAnchorPointEnabled) {
     return;
   }
 
@@ -161,7 +247,7 @@ void vesKiwiText2DRepresentation::willRender(vesSharedPtr<vesRenderer> renderer)
   anchorOffset *= this->Internal->AnchorOffset;
   vesVector3f worldPoint = this->Internal->WorldAnchorPoint - anchorOffset;
   vesVector3f displayPoint = renderer->computeWorldToDisplay(worldPoint);
-  displayPoint[0] -= this->texture()->image()->width() / 2.0;
+  displayPoint[0] -= this->textWidth() / 2.0;
 
   this->setDisplayPosition(vesVector2f(displayPoint[0], displayPoint[1]));
 }
@@ -19,25 +19,44 @@
  ========================================================================*/
 /// \class vesKiwiText2DRepresentation
 /// \ingroup KiwiPlatform
+/// \brief Text drawn as an overlay in display coordinates.
+///
+/// The text is laid out as one textured quad per glyph from a glyph atlas
+/// shared by all text of the same font, see vesKiwiGlyphAtlas. Labels with
+/// an overlay batch are drawn together with the other labels of the batch
+/// rather than with their own actor.
 #ifndef __vesKiwiText2DRepresentation_h
 #define __vesKiwiText2DRepresentation_h
 
 #include "vesKiwiImagePlaneDataRepresentation.h"
 
-
-class vtkImageData;
+class vesKiwiGlyphAtlas;
+class vesKiwiOverlayBatch;
 
 class vesKiwiText2DRepresentation : public vesKiwiImagePlaneDataRepresentation
 {
 public:
 
   vesTypeMacro(vesKiwiText2DRepresentation);
+  typedef vesKiwiImagePlaneDataRepresentation Superclass;
 
   vesKiwiText2DRepresentation();
   ~vesKiwiText2DRepresentation();
 
   void setText(const std::string& text);
+  const std::string& text() const;
+
+  /// The glyph atlas the text is drawn from.
+  vesSharedPtr<vesKiwiGlyphAtlas> glyphAtlas() const;
 
+  /// Draw this text as part of \a batch from the next call to
+  /// addSelfToRenderer() on. Falls back to its own actor if the batch draws
+  /// from another glyph atlas.
+  void setOverlayBatch(vesSharedPtr<vesKiwiOverlayBatch> batch);
+  vesSharedPtr<vesKiwiOverlayBatch> overlayBatch() const;
+
+  virtual void addSelfToRenderer(vesSharedPtr<vesRenderer> renderer);
+  virtual void removeSelfFromRenderer(vesSharedPtr<vesRenderer> renderer);
   virtual void willRender(vesSharedPtr<vesRenderer> renderer);
 
   void setWorldAnchorPointEnabled(bool enabled);
@@ -52,9 +71,12 @@ public:
   void setDisplayPosition(vesVector2f displayPosition);
   vesVector2f displayPosition() const;
 
-  /// Return the width of the texture used by this text annotation.
+  /// Return the width in pixels of the bounding box of the text.
   int textWidth();
 
+  /// Return the height in pixels of the bounding box of the text.
+  int textHeight();
+
 private:
 
   vesKiwiText2DRepresentation(const vesKiwiText2DRepresentation&); // Not implemented
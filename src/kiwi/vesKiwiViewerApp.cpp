@@ -25,14 +25,17 @@
 #include "vesKiwiDataRepresentation.h"
 #include "vesKiwiImagePlaneDataRepresentation.h"
 #include "vesKiwiImageWidgetRepresentation.h"
+#include "vesKiwiLoadScheduler.h"
 #include "vesKiwiAnimationRepresentation.h"
 #include "vesKiwiBrainAtlasRepresentation.h"
+#include "vesKiwiOverlayBatch.h"
 #include "vesKiwiText2DRepresentation.h"
 #include "vesKiwiPlaneWidget.h"
 #include "vesKiwiPolyDataRepresentation.h"
 
 #include "vesCamera.h"
 #include "vesColorUniform.h"
+#include "vesMapper.h"
 #include "vesMath.h"
 #include "vesModelViewUniform.h"
 #include "vesNormalMatrixUniform.h"
@@ -40,6 +43,7 @@
 #include "vesRenderer.h"
 #include "vesActor.h"
 #include "vesShader.h"
+#include "vesShaderPermutations.h"
 #include "vesShaderProgram.h"
 #include "vesTexture.h"
 #include "vesUniform.h"
@@ -75,6 +79,7 @@ public:
   vesInternal()
   {
     this->IsAnimating = false;
+    this->ShadingModelFeatures = 0;
   }
 
   ~vesInternal()
@@ -85,16 +90,23 @@ public:
     this->BuiltinShadingModels.clear();
   }
 
-  struct vesShaderProgramData
+  // Surface shader feature bits selecting the lighting model, above the
+  // ones representations declare. Gouraud lighting has none.
+  enum LightingFeature
   {
-    vesShaderProgramData(
-      const std::string &name, vesSharedPtr<vesShaderProgram> shaderProgram) :
-      Name(name), ShaderProgram(shaderProgram)
+    BlinnPhongLighting = 0x100,
+    ToonLighting       = 0x200
+  };
+
+  struct vesShadingModel
+  {
+    vesShadingModel(const std::string &name, unsigned int features) :
+      Name(name), Features(features)
     {
     }
 
     std::string Name;
-    vesSharedPtr<vesShaderProgram> ShaderProgram;
+    unsigned int Features;
   };
 
   struct vesCameraParameters
@@ -114,20 +126,22 @@ public:
     vesVector3f ViewUp;
   };
 
-  bool setShaderProgramOnRepresentations(
-    vesSharedPtr<vesShaderProgram> shaderProgram);
+  vesSharedPtr<vesShaderProgram> surfaceShader(unsigned int features);
+  void updateSurfaceShaders();
 
   bool IsAnimating;
   std::string ErrorTitle;
   std::string ErrorMessage;
 
-  vesSharedPtr<vesShaderProgram> ShaderProgram;
-  vesSharedPtr<vesShaderProgram> TextureShader;
-  vesSharedPtr<vesShaderProgram> GouraudTextureShader;
-  vesSharedPtr<vesShaderProgram> ClipShader;
+  vesShaderPermutations::Ptr SurfaceShaders;
+  unsigned int ShadingModelFeatures;
+  vesSharedPtr<vesShaderProgram> ScalarColorMapShader;
+  vesSharedPtr<vesShaderProgram> ImageAtlasShader;
+  vesSharedPtr<vesShaderProgram> VolumeShader;
   vesSharedPtr<vesUniform> ClipUniform;
 
   std::vector<vesKiwiDataRepresentation*> DataRepresentations;
+  vesKiwiOverlayBatch::Ptr OverlayBatch;
 
   vesKiwiDataLoader DataLoader;
 
@@ -136,15 +150,26 @@ public:
   std::vector<vesCameraParameters> BuiltinDatasetCameraParameters;
 
   std::string CurrentShadingModel;
-  std::vector<vesShaderProgramData> BuiltinShadingModels;
+  std::vector<vesShadingModel> BuiltinShadingModels;
 };
 
 //----------------------------------------------------------------------------
-bool vesKiwiViewerApp::vesInternal::setShaderProgramOnRepresentations(
-  vesSharedPtr<vesShaderProgram> shaderProgram)
+vesSharedPtr<vesShaderProgram> vesKiwiViewerApp::vesInternal::surfaceShader(
+  unsigned int features)
 {
-  bool success = false;
+  if (!this->SurfaceShaders) {
+    return vesSharedPtr<vesShaderProgram>();
+  }
+
+  if (features & vesKiwiPolyDataRepresentation::Lighting) {
+    features |= this->ShadingModelFeatures;
+  }
+  return this->SurfaceShaders->program(features);
+}
 
+//----------------------------------------------------------------------------
+void vesKiwiViewerApp::vesInternal::updateSurfaceShaders()
+{
   for (size_t i = 0; i < this->DataRepresentations.size(); ++i) {
     vesKiwiPolyDataRepresentation *polyDataRepresentation =
         dynamic_cast<vesKiwiPolyDataRepresentation*>(this->DataRepresentations[i]);
@@ -152,17 +177,16 @@ bool vesKiwiViewerApp::vesInternal::setShaderProgramOnRepresentations(
     vesKiwiImageWidgetRepresentation *imageWidgetRepresentation =
         dynamic_cast<vesKiwiImageWidgetRepresentation*>(this->DataRepresentations[i]);
 
-    if (polyDataRepresentation) {
-      polyDataRepresentation->setShaderProgram(shaderProgram);
-      success = true;
+    if (polyDataRepresentation && polyDataRepresentation->shaderFeatures()) {
+      polyDataRepresentation->setShaderProgram(
+        this->surfaceShader(polyDataRepresentation->shaderFeatures()));
     }
     else if (imageWidgetRepresentation) {
-      imageWidgetRepresentation->setShaderProgram(shaderProgram);
-      success = true;
+      imageWidgetRepresentation->setShaderProgram(this->surfaceShader(
+        vesKiwiPolyDataRepresentation::Lighting |
+        vesKiwiPolyDataRepresentation::VertexColors));
     }
   }
-
-  return success;
 }
 
 //----------------------------------------------------------------------------
@@ -171,6 +195,9 @@ vesKiwiViewerApp::vesKiwiViewerApp()
   this->Internal = new vesInternal();
   this->resetScene();
 
+  // Translucent datasets and the atlas skin go to bin 5.
+  this->renderer()->setFirstTranslucentBin(5);
+
   this->addBuiltinDataset("Utah Teapot", "teapot.vtp");
   this->addBuiltinDataset("Stanford Bunny", "bunny.vtp");
   this->addBuiltinDataset("NLM Visible Woman Hand", "visible-woman-hand.vtp");
@@ -207,24 +234,27 @@ vesKiwiViewerApp::vesKiwiViewerApp()
 
   this->addBuiltinDataset("ParaView Web", "pvweb");
 
-  this->initBlinnPhongShader(
-    vesBuiltinShaders::vesBlinnPhong_vert(),
-    vesBuiltinShaders::vesBlinnPhong_frag());
-  this->initToonShader(
-    vesBuiltinShaders::vesToonShader_vert(),
-    vesBuiltinShaders::vesToonShader_frag());
-  this->initGouraudShader(
-    vesBuiltinShaders::vesShader_vert(),
-    vesBuiltinShaders::vesShader_frag());
-  this->initGouraudTextureShader(
-    vesBuiltinShaders::vesGouraudTexture_vert(),
-    vesBuiltinShaders::vesGouraudTexture_frag());
-  this->initTextureShader(
-    vesBuiltinShaders::vesBackgroundTexture_vert(),
-    vesBuiltinShaders::vesBackgroundTexture_frag());
-  this->initClipShader(
-    vesBuiltinShaders::vesClipPlane_vert(),
-    vesBuiltinShaders::vesClipPlane_frag());
+  this->addBuiltinShadingModel("BlinnPhong", vesInternal::BlinnPhongLighting);
+  this->addBuiltinShadingModel("Toon", vesInternal::ToonLighting);
+  this->addBuiltinShadingModel("Gouraud", 0);
+
+  this->initSurfaceShader(
+    vesBuiltinShaders::vesSurface_vert(),
+    vesBuiltinShaders::vesSurface_frag());
+  this->initScalarColorMapShader(
+    vesBuiltinShaders::vesScalarColorMap_vert(),
+    vesBuiltinShaders::vesScalarColorMap_frag());
+  this->initImageAtlasShader(
+    vesBuiltinShaders::vesImageAtlas_vert(),
+    vesBuiltinShaders::vesImageAtlas_frag());
+  this->initVolumeShader(
+    vesBuiltinShaders::vesVolumeRayCast_vert(),
+    vesBuiltinShaders::vesVolumeRayCast_frag());
+
+  // All text labels are drawn together in one call.
+  this->Internal->OverlayBatch = vesKiwiOverlayBatch::Ptr(new vesKiwiOverlayBatch());
+  this->Internal->OverlayBatch->initializeWithShader(
+    this->surfaceShader(vesKiwiPolyDataRepresentation::Texture));
 
   this->setShadingModel("Gouraud");
 }
@@ -305,7 +335,9 @@ bool vesKiwiViewerApp::doPVWebTest(const std::string& host, const std::string& s
       continue;
 
     vesKiwiPolyDataRepresentation* rep = new vesKiwiPolyDataRepresentation();
-    rep->initializeWithShader(this->shaderProgram());
+    rep->setShaderFeatures(vesKiwiPolyDataRepresentation::Lighting |
+                           vesKiwiPolyDataRepresentation::VertexColors);
+    rep->initializeWithShader(this->surfaceShader(rep->shaderFeatures()));
     rep->setPVWebData(dataset);
     rep->addSelfToRenderer(this->renderer());
     this->Internal->DataRepresentations.push_back(rep);
@@ -364,13 +396,23 @@ bool vesKiwiViewerApp::renameFile(const std::string& srcFile, const std::string&
 //----------------------------------------------------------------------------
 const vesSharedPtr<vesShaderProgram> vesKiwiViewerApp::shaderProgram() const
 {
-  return this->Internal->ShaderProgram;
+  return this->Internal->surfaceShader(
+    vesKiwiPolyDataRepresentation::Lighting |
+    vesKiwiPolyDataRepresentation::VertexColors);
 }
 
 //----------------------------------------------------------------------------
 vesSharedPtr<vesShaderProgram> vesKiwiViewerApp::shaderProgram()
 {
-  return this->Internal->ShaderProgram;
+  return this->Internal->surfaceShader(
+    vesKiwiPolyDataRepresentation::Lighting |
+    vesKiwiPolyDataRepresentation::VertexColors);
+}
+
+//----------------------------------------------------------------------------
+vesSharedPtr<vesShaderProgram> vesKiwiViewerApp::surfaceShader(unsigned int features)
+{
+  return this->Internal->surfaceShader(features);
 }
 
 //----------------------------------------------------------------------------
@@ -416,30 +458,38 @@ void vesKiwiViewerApp::applyBuiltinDatasetCameraParameters(int index)
 
 //----------------------------------------------------------------------------
 void vesKiwiViewerApp::addBuiltinShadingModel(
-  const std::string &name, vesSharedPtr<vesShaderProgram> shaderProgram)
+  const std::string &name, unsigned int lightingFeatures)
 {
-  assert(shaderProgram);
-
-  if (!shaderProgram) {
-    return;
-  }
-
   for(size_t i=0; i < this->Internal->BuiltinShadingModels.size(); ++i) {
     if (this->Internal->BuiltinShadingModels[i].Name == name) {
-      this->deleteShaderProgram(this->Internal->BuiltinShadingModels[i].ShaderProgram);
-      this->Internal->BuiltinShadingModels[i].ShaderProgram = shaderProgram;
+      this->Internal->BuiltinShadingModels[i].Features = lightingFeatures;
       return;
     }
   }
 
   this->Internal->BuiltinShadingModels.push_back(
-    vesInternal::vesShaderProgramData(name, shaderProgram));
+    vesInternal::vesShadingModel(name, lightingFeatures));
+}
+
+//----------------------------------------------------------------------------
+bool vesKiwiViewerApp::isRenderNeeded() const
+{
+  if (this->Internal->IsAnimating || this->Superclass::isRenderNeeded()) {
+    return true;
+  }
+
+  for (size_t i = 0; i < this->Internal->DataRepresentations.size(); ++i) {
+    if (this->Internal->DataRepresentations[i]->isRenderNeeded()) {
+      return true;
+    }
+  }
+  return false;
 }
 
 //----------------------------------------------------------------------------
 bool vesKiwiViewerApp::isAnimating() const
 {
-  return this->Internal->IsAnimating;
+  return this->isRenderNeeded();
 }
 
 //----------------------------------------------------------------------------
@@ -454,6 +504,7 @@ void vesKiwiViewerApp::willRender()
   for (size_t i = 0; i < this->Internal->DataRepresentations.size(); ++i) {
     this->Internal->DataRepresentations[i]->willRender(this->renderer());
   }
+  this->Internal->OverlayBatch->willRender(this->renderer());
 }
 
 //----------------------------------------------------------------------------
@@ -463,6 +514,8 @@ void vesKiwiViewerApp::handleSingleTouchPanGesture(double deltaX, double deltaY)
     vesKiwiWidgetRepresentation* rep = dynamic_cast<vesKiwiWidgetRepresentation*>(this->Internal->DataRepresentations[i]);
     if (rep) {
       if (rep->handleSingleTouchPanGesture(deltaX, deltaY)) {
+        this->interactionOccurred();
+        this->renderer()->requestRender();
         return;
       }
     }
@@ -478,6 +531,7 @@ void vesKiwiViewerApp::handleDoubleTap(int displayX, int displayY)
     vesKiwiWidgetRepresentation* rep = dynamic_cast<vesKiwiWidgetRepresentation*>(this->Internal->DataRepresentations[i]);
     if (rep) {
       if (rep->handleDoubleTap(displayX, displayY)) {
+        this->renderer()->requestRender();
         return;
       }
     }
@@ -491,6 +545,7 @@ void vesKiwiViewerApp::handleLongPress(int displayX, int displayY)
     vesKiwiWidgetRepresentation* rep = dynamic_cast<vesKiwiWidgetRepresentation*>(this->Internal->DataRepresentations[i]);
     if (rep) {
       if (rep->handleLongPress(displayX, displayY)) {
+        this->renderer()->requestRender();
         return;
       }
     }
@@ -504,6 +559,7 @@ void vesKiwiViewerApp::handleSingleTouchUp()
     vesKiwiWidgetRepresentation* rep = dynamic_cast<vesKiwiWidgetRepresentation*>(this->Internal->DataRepresentations[i]);
     if (rep) {
       if (rep->handleSingleTouchUp()) {
+        this->renderer()->requestRender();
         return;
       }
     }
@@ -517,6 +573,7 @@ void vesKiwiViewerApp::handleSingleTouchTap(int displayX, int displayY)
     vesKiwiWidgetRepresentation* rep = dynamic_cast<vesKiwiWidgetRepresentation*>(this->Internal->DataRepresentations[i]);
     if (rep) {
       if (rep->handleSingleTouchTap(displayX, displayY)) {
+        this->renderer()->requestRender();
         return;
       }
     }
@@ -530,6 +587,7 @@ void vesKiwiViewerApp::handleSingleTouchDown(int displayX, int displayY)
     vesKiwiWidgetRepresentation* rep = dynamic_cast<vesKiwiWidgetRepresentation*>(this->Internal->DataRepresentations[i]);
     if (rep) {
       if (rep->handleSingleTouchDown(displayX, displayY)) {
+        this->renderer()->requestRender();
         return;
       }
     }
@@ -578,124 +636,116 @@ std::string vesKiwiViewerApp::getShadingModel(int index) const
 //----------------------------------------------------------------------------
 bool vesKiwiViewerApp::setShadingModel(const std::string& name)
 {
-  bool success = true;
-
   for(size_t i=0; i < this->Internal->BuiltinShadingModels.size(); ++i) {
-    // Check if we have a match.
     if (this->Internal->BuiltinShadingModels[i].Name == name) {
-      // Check if we have a valid shader program before we switch.
-      if (this->Internal->BuiltinShadingModels[i].ShaderProgram) {
-        this->Internal->ShaderProgram =
-          this->Internal->BuiltinShadingModels[i].ShaderProgram;
+      this->Internal->CurrentShadingModel = name;
+      this->Internal->ShadingModelFeatures =
+        this->Internal->BuiltinShadingModels[i].Features;
 
-        return this->Internal->setShaderProgramOnRepresentations(
-          this->Internal->ShaderProgram);
-      }
+      // The variants of the new model are only compiled once drawn.
+      this->Internal->updateSurfaceShaders();
+      return true;
     }
   }
 
-  return !success;
-}
-
-//----------------------------------------------------------------------------
-bool vesKiwiViewerApp::initGouraudShader(const std::string& vertexSource, const std::string& fragmentSource)
-{
-  vesSharedPtr<vesShaderProgram> shaderProgram
-    = this->addShaderProgram(vertexSource, fragmentSource);
-  this->addModelViewMatrixUniform(shaderProgram);
-  this->addProjectionMatrixUniform(shaderProgram);
-  this->addNormalMatrixUniform(shaderProgram);
-  this->addVertexPositionAttribute(shaderProgram);
-  this->addVertexNormalAttribute(shaderProgram);
-  this->addVertexColorAttribute(shaderProgram);
-  this->Internal->ShaderProgram = shaderProgram;
-
-  this->addBuiltinShadingModel("Gouraud", shaderProgram);
-
-  return true;
+  return false;
 }
 
 //----------------------------------------------------------------------------
-bool vesKiwiViewerApp::initBlinnPhongShader(const std::string& vertexSource,
-                                            const std::string& fragmentSource)
+bool vesKiwiViewerApp::initSurfaceShader(const std::string& vertexSource,
+                                         const std::string& fragmentSource)
 {
-  vesSharedPtr<vesShaderProgram> shaderProgram
-    = this->addShaderProgram(vertexSource, fragmentSource);
-  this->addModelViewMatrixUniform(shaderProgram);
-  this->addProjectionMatrixUniform(shaderProgram);
-  this->addNormalMatrixUniform(shaderProgram);
-  this->addVertexPositionAttribute(shaderProgram);
-  this->addVertexNormalAttribute(shaderProgram);
-  this->addVertexColorAttribute(shaderProgram);
-  this->Internal->ShaderProgram = shaderProgram;
-
-  this->addBuiltinShadingModel("BlinnPhong", shaderProgram);
+  vesShaderPermutations::Ptr shaders(
+    new vesShaderPermutations(vertexSource, fragmentSource));
+
+  shaders->setFeatureDefine(vesKiwiPolyDataRepresentation::Lighting, "VES_LIGHTING");
+  shaders->setFeatureDefine(vesKiwiPolyDataRepresentation::VertexColors, "VES_VERTEX_COLORS");
+  shaders->setFeatureDefine(vesKiwiPolyDataRepresentation::Texture, "VES_TEXTURE");
+  shaders->setFeatureDefine(vesKiwiPolyDataRepresentation::ClipPlane, "VES_CLIP_PLANE");
+  shaders->setFeatureDefine(vesKiwiPolyDataRepresentation::PointSprites, "VES_POINT_SPRITES");
+  shaders->setFeatureDefine(vesInternal::BlinnPhongLighting, "VES_BLINN_PHONG");
+  shaders->setFeatureDefine(vesInternal::ToonLighting, "VES_TOON");
+
+  shaders->addUniform(vesUniform::Ptr(new vesModelViewUniform()));
+  shaders->addUniform(vesUniform::Ptr(new vesProjectionUniform()));
+  shaders->addUniform(vesUniform::Ptr(new vesNormalMatrixUniform()),
+                      vesKiwiPolyDataRepresentation::Lighting);
+  shaders->addVertexAttribute(
+    vesVertexAttribute::Ptr(new vesPositionVertexAttribute()),
+    vesVertexAttributeKeys::Position);
+  shaders->addVertexAttribute(
+    vesVertexAttribute::Ptr(new vesNormalVertexAttribute()),
+    vesVertexAttributeKeys::Normal, vesKiwiPolyDataRepresentation::Lighting);
+  shaders->addVertexAttribute(
+    vesVertexAttribute::Ptr(new vesColorVertexAttribute()),
+    vesVertexAttributeKeys::Color, vesKiwiPolyDataRepresentation::VertexColors);
+  shaders->addVertexAttribute(
+    vesVertexAttribute::Ptr(new vesTextureCoordinateVertexAttribute()),
+    vesVertexAttributeKeys::TextureCoordinate, vesKiwiPolyDataRepresentation::Texture);
+
+  // The plane widget moves the clip plane of every variant having one.
+  if (!this->Internal->ClipUniform) {
+    this->Internal->ClipUniform = vesUniform::Ptr(new vesUniform("clipPlaneEquation", vesVector4f(1.0f, 0.0f, 0.0f, 0.0f)));
+  }
+  shaders->addUniform(this->Internal->ClipUniform, vesKiwiPolyDataRepresentation::ClipPlane);
+  shaders->addUniform(vesUniform::Ptr(new vesUniform("pointSize", 4.0f)),
+                      vesKiwiPolyDataRepresentation::PointSprites);
 
+  this->Internal->SurfaceShaders = shaders;
+  this->Internal->updateSurfaceShaders();
   return true;
 }
 
 //----------------------------------------------------------------------------
-bool vesKiwiViewerApp::initToonShader(const std::string& vertexSource,
-                                      const std::string& fragmentSource)
+bool vesKiwiViewerApp::initScalarColorMapShader(const std::string& vertexSource, const std::string& fragmentSource)
 {
-  vesSharedPtr<vesShaderProgram> shaderProgram
-    = this->addShaderProgram(vertexSource, fragmentSource);
+  vesShaderProgram::Ptr shaderProgram = this->addShaderProgram(vertexSource, fragmentSource);
   this->addModelViewMatrixUniform(shaderProgram);
   this->addProjectionMatrixUniform(shaderProgram);
   this->addNormalMatrixUniform(shaderProgram);
   this->addVertexPositionAttribute(shaderProgram);
   this->addVertexNormalAttribute(shaderProgram);
+  this->addVertexScalarAttribute(shaderProgram);
 
-  this->Internal->ShaderProgram = shaderProgram;
-
-  this->addBuiltinShadingModel("Toon", shaderProgram);
-
+  // Defaults, each representation sets its own range as a material uniform.
+  shaderProgram->addUniform(vesUniform::Ptr(new vesUniform("scalarRange", vesVector2f(0.0f, 1.0f))));
+  shaderProgram->addUniform(vesUniform::Ptr(new vesUniform("colorMap", 0)));
+  this->Internal->ScalarColorMapShader = shaderProgram;
   return true;
 }
 
 //----------------------------------------------------------------------------
-bool vesKiwiViewerApp::initTextureShader(const std::string& vertexSource,
-                                         const std::string& fragmentSource)
-{
-  vesSharedPtr<vesShaderProgram> shaderProgram
-    = this->addShaderProgram(vertexSource, fragmentSource);
-  this->addModelViewMatrixUniform(shaderProgram);
-  this->addProjectionMatrixUniform(shaderProgram);
-  this->addVertexPositionAttribute(shaderProgram);
-  this->addVertexTextureCoordinateAttribute(shaderProgram);
-  this->Internal->TextureShader = shaderProgram;
-  return true;
-}
-
-//----------------------------------------------------------------------------
-bool vesKiwiViewerApp::initGouraudTextureShader(const std::string& vertexSource, const std::string& fragmentSource)
+bool vesKiwiViewerApp::initImageAtlasShader(const std::string& vertexSource, const std::string& fragmentSource)
 {
   vesShaderProgram::Ptr shaderProgram = this->addShaderProgram(vertexSource, fragmentSource);
   this->addModelViewMatrixUniform(shaderProgram);
   this->addProjectionMatrixUniform(shaderProgram);
-  this->addNormalMatrixUniform(shaderProgram);
   this->addVertexPositionAttribute(shaderProgram);
-  this->addVertexNormalAttribute(shaderProgram);
   this->addVertexTextureCoordinateAttribute(shaderProgram);
-  this->Internal->GouraudTextureShader = shaderProgram;
+
+  // The lookup table is bound to texture unit 0, the slice atlas to unit 1.
+  shaderProgram->addUniform(vesUniform::Ptr(new vesUniform("colorMap", 0)));
+  shaderProgram->addUniform(vesUniform::Ptr(new vesUniform("image", 1)));
+  shaderProgram->addUniform(vesUniform::Ptr(new vesUniform("atlasTile", vesVector4f(0.0f, 0.0f, 1.0f, 1.0f))));
+  this->Internal->ImageAtlasShader = shaderProgram;
   return true;
 }
 
 //----------------------------------------------------------------------------
-bool vesKiwiViewerApp::initClipShader(const std::string& vertexSource, const std::string& fragmentSource)
+bool vesKiwiViewerApp::initVolumeShader(const std::string& vertexSource, const std::string& fragmentSource)
 {
   vesShaderProgram::Ptr shaderProgram = this->addShaderProgram(vertexSource, fragmentSource);
   this->addModelViewMatrixUniform(shaderProgram);
   this->addProjectionMatrixUniform(shaderProgram);
-  this->addNormalMatrixUniform(shaderProgram);
   this->addVertexPositionAttribute(shaderProgram);
-  this->addVertexNormalAttribute(shaderProgram);
-  this->addVertexColorAttribute(shaderProgram);
-  this->addVertexTextureCoordinateAttribute(shaderProgram);
-  this->Internal->ClipShader = shaderProgram;
 
-  this->Internal->ClipUniform = vesUniform::Ptr(new vesUniform("clipPlaneEquation", vesVector4f(1.0f, 0.0f, 0.0f, 0.0f)));
-  this->Internal->ClipShader->addUniform(this->Internal->ClipUniform);
+  // The transfer function is bound to texture unit 0, the slice atlas to
+  // unit 1 and the brick occupancy to unit 2. The other uniforms are set
+  // by each volume representation.
+  shaderProgram->addUniform(vesUniform::Ptr(new vesUniform("transferFunction", 0)));
+  shaderProgram->addUniform(vesUniform::Ptr(new vesUniform("volume", 1)));
+  shaderProgram->addUniform(vesUniform::Ptr(new vesUniform("bricks", 2)));
+  this->Internal->VolumeShader = shaderProgram;
   return true;
 }
 
@@ -724,7 +774,8 @@ void vesKiwiViewerApp::addRepresentationsForDataSet(vtkDataSet* dataSet)
 {
 
   if (vtkPolyData::SafeDownCast(dataSet)) {
-    this->addPolyDataRepresentation(vtkPolyData::SafeDownCast(dataSet), this->shaderProgram());
+    this->addPolyDataRepresentation(vtkPolyData::SafeDownCast(dataSet),
+      vesKiwiPolyDataRepresentation::Lighting | vesKiwiPolyDataRepresentation::VertexColors);
   }
   else if (vtkImageData::SafeDownCast(dataSet)) {
 
@@ -733,7 +784,9 @@ void vesKiwiViewerApp::addRepresentationsForDataSet(vtkDataSet* dataSet)
     if (image->GetDataDimension() == 3) {
 
       vesKiwiImageWidgetRepresentation* rep = new vesKiwiImageWidgetRepresentation();
-      rep->initializeWithShader(this->shaderProgram(), this->Internal->TextureShader);
+      rep->initializeWithShader(this->shaderProgram(),
+                                this->surfaceShader(vesKiwiPolyDataRepresentation::Texture),
+                                this->Internal->ImageAtlasShader, this->Internal->VolumeShader);
       rep->setImageData(image);
       rep->addSelfToRenderer(this->renderer());
       this->Internal->DataRepresentations.push_back(rep);
@@ -742,7 +795,7 @@ void vesKiwiViewerApp::addRepresentationsForDataSet(vtkDataSet* dataSet)
     else {
 
       vesKiwiImagePlaneDataRepresentation* rep = new vesKiwiImagePlaneDataRepresentation();
-      rep->initializeWithShader(this->Internal->TextureShader);
+      rep->initializeWithShader(this->surfaceShader(vesKiwiPolyDataRepresentation::Texture));
       rep->setImageData(image);
       rep->addSelfToRenderer(this->renderer());
       this->Internal->DataRepresentations.push_back(rep);
@@ -753,11 +806,23 @@ void vesKiwiViewerApp::addRepresentationsForDataSet(vtkDataSet* dataSet)
 
 //----------------------------------------------------------------------------
 vesKiwiPolyDataRepresentation* vesKiwiViewerApp::addPolyDataRepresentation(
-  vtkPolyData* polyData, vesSharedPtr<vesShaderProgram> program)
+  vtkPolyData* polyData, unsigned int shaderFeatures)
+{
+  return this->addPolyDataRepresentation(
+    vesKiwiPolyDataRepresentation::convertPolyData(polyData), shaderFeatures);
+}
+
+//----------------------------------------------------------------------------
+vesKiwiPolyDataRepresentation* vesKiwiViewerApp::addPolyDataRepresentation(
+  vesSharedPtr<vesGeometryData> geometryData, unsigned int shaderFeatures)
 {
   vesKiwiPolyDataRepresentation* rep = new vesKiwiPolyDataRepresentation();
-  rep->initializeWithShader(program);
-  rep->setPolyData(polyData);
+  rep->setShaderFeatures(shaderFeatures);
+  rep->initializeWithShader(this->surfaceShader(shaderFeatures));
+  rep->setGeometryData(geometryData);
+
+  // Loaded datasets are not modified once shown, only the GPU copy is needed.
+  rep->mapper()->setResidencyPolicy(vesMapper::ReleaseAfterUpload);
   rep->addSelfToRenderer(this->renderer());
   this->Internal->DataRepresentations.push_back(rep);
   return rep;
@@ -767,8 +832,9 @@ vesKiwiPolyDataRepresentation* vesKiwiViewerApp::addPolyDataRepresentation(
 vesKiwiText2DRepresentation* vesKiwiViewerApp::addTextRepresentation(const std::string& text)
 {
   vesKiwiText2DRepresentation* rep = new vesKiwiText2DRepresentation();
-  rep->initializeWithShader(this->Internal->TextureShader);
+  rep->initializeWithShader(this->surfaceShader(vesKiwiPolyDataRepresentation::Texture));
   rep->setText(text);
+  rep->setOverlayBatch(this->Internal->OverlayBatch);
   rep->addSelfToRenderer(this->renderer());
   this->Internal->DataRepresentations.push_back(rep);
   return rep;
@@ -810,7 +876,12 @@ void vesKiwiViewerApp::checkForAdditionalData(const std::string& dirname)
 bool vesKiwiViewerApp::loadBrainAtlas(const std::string& filename)
 {
   vesKiwiBrainAtlasRepresentation* rep = new vesKiwiBrainAtlasRepresentation();
-  rep->initializeWithShader(this->shaderProgram(), this->Internal->TextureShader, this->Internal->ClipShader);
+  rep->initializeWithShader(this->shaderProgram(),
+    this->surfaceShader(vesKiwiPolyDataRepresentation::Texture),
+    this->surfaceShader(vesKiwiPolyDataRepresentation::Lighting |
+                        vesKiwiPolyDataRepresentation::VertexColors |
+                        vesKiwiPolyDataRepresentation::ClipPlane));
+  rep->setOverlayBatch(this->Internal->OverlayBatch);
   rep->loadData(filename);
   rep->addSelfToRenderer(this->renderer());
   this->Internal->DataRepresentations.push_back(rep);
@@ -826,11 +897,13 @@ bool vesKiwiViewerApp::loadBrainAtlas(const std::string& filename)
 bool vesKiwiViewerApp::loadCanSimulation(const std::string& filename)
 {
   vesKiwiAnimationRepresentation* rep = new vesKiwiAnimationRepresentation();
-  rep->initializeWithShader(this->shaderProgram(), this->Internal->TextureShader, this->Internal->GouraudTextureShader);
+  rep->initializeWithShader(this->shaderProgram(),
+    this->surfaceShader(vesKiwiPolyDataRepresentation::Texture),
+    this->Internal->ScalarColorMapShader);
+  rep->setOverlayBatch(this->Internal->OverlayBatch);
   rep->loadData(filename);
   rep->addSelfToRenderer(this->renderer());
   this->Internal->DataRepresentations.push_back(rep);
-  this->setAnimating(true);
   return true;
 }
 
@@ -851,7 +924,8 @@ bool vesKiwiViewerApp::loadBlueMarble(const std::string& filename)
     return false;
   }
 
-  vesKiwiPolyDataRepresentation* rep = this->addPolyDataRepresentation(polyData, this->Internal->GouraudTextureShader);
+  vesKiwiPolyDataRepresentation* rep = this->addPolyDataRepresentation(polyData,
+    vesKiwiPolyDataRepresentation::Lighting | vesKiwiPolyDataRepresentation::Texture);
   vtkSmartPointer<vtkUnsignedCharArray> pixels = vtkUnsignedCharArray::SafeDownCast(image->GetPointData()->GetScalars());
 
   int width = image->GetDimensions()[0];
@@ -889,6 +963,10 @@ bool vesKiwiViewerApp::loadKiwiScene(const std::string& sceneFile)
 
   const bool haveAlpha = (table->GetColumnByName("a") != NULL);
 
+  // Files are downloaded first, then read and converted concurrently and
+  // added to the scene in the order of the table rows.
+  vesKiwiLoadScheduler scheduler;
+
   for (int i = 0; i < table->GetNumberOfRows(); ++i) {
 
     std::string filename = table->GetValueByName(i, "filename").ToString();
@@ -913,16 +991,25 @@ bool vesKiwiViewerApp::loadKiwiScene(const std::string& sceneFile)
       }
     }
 
-    std::cout << "loading: " << filename << std::endl;
+    scheduler.addJob(vesKiwiLoadScheduler::Job::Ptr(new vesKiwiLoadScheduler::Job(filename)));
+  }
+
+  scheduler.start();
+
+  for (int i = 0; i < table->GetNumberOfRows(); ++i) {
+
+    vesKiwiLoadScheduler::Job::Ptr job = scheduler.next();
+
+    std::cout << "loading: " << job->filename() << std::endl;
 
-    vtkSmartPointer<vtkDataSet> dataSet = this->Internal->DataLoader.loadDataset(filename);
-    if (!dataSet) {
-      this->handleLoadDatasetError();
+    if (!job->isLoaded()) {
+      this->setErrorMessage(job->errorTitle(), job->errorMessage());
       return false;
     }
 
-    if (vtkPolyData::SafeDownCast(dataSet)) {
-      vesKiwiPolyDataRepresentation* polyDataRep = this->addPolyDataRepresentation(vtkPolyData::SafeDownCast(dataSet), this->shaderProgram());
+    if (job->geometryData()) {
+      vesKiwiPolyDataRepresentation* polyDataRep = this->addPolyDataRepresentation(job->geometryData(),
+        vesKiwiPolyDataRepresentation::Lighting | vesKiwiPolyDataRepresentation::VertexColors);
 
       vesVector4f color(1.0, 1.0, 1.0, 1.0);
       if (haveColor) {
@@ -939,7 +1026,7 @@ bool vesKiwiViewerApp::loadKiwiScene(const std::string& sceneFile)
       polyDataRep->setColor(color[0], color[1], color[2], color[3]);
     }
     else {
-      this->addRepresentationsForDataSet(dataSet);
+      this->addRepresentationsForDataSet(job->dataSet());
     }
   }
 
@@ -978,6 +1065,18 @@ bool vesKiwiViewerApp::loadDataset(const std::string& filename)
     return false;
   }
 
+  // Meshes the native readers handle skip VTK altogether.
+  vesSharedPtr<vesGeometryData> geometryData = this->Internal->DataLoader.loadGeometryData(filename);
+  if (geometryData) {
+    this->addPolyDataRepresentation(geometryData,
+      vesKiwiPolyDataRepresentation::Lighting | vesKiwiPolyDataRepresentation::VertexColors);
+    return true;
+  }
+  else if (!this->Internal->DataLoader.errorMessage().empty()) {
+    this->handleLoadDatasetError();
+    return false;
+  }
+
   vtkSmartPointer<vtkDataSet> dataSet = this->Internal->DataLoader.loadDataset(filename);
   if (!dataSet) {
     this->handleLoadDatasetError();
@@ -32,6 +32,7 @@
 
 // Forward declarations
 class vesCamera;
+class vesGeometryData;
 class vesKiwiDataRepresentation;
 class vesKiwiPolyDataRepresentation;
 class vesKiwiImagePlaneDataRepresentation;
@@ -76,13 +77,20 @@ public:
   std::string getShadingModel(int index) const;
   bool setShadingModel(const std::string& name);
 
-  bool initGouraudShader(const std::string& vertexSource, const std::string& fragmentSource);
-  bool initBlinnPhongShader(const std::string& vertexSource, const std::string& fragmentSource);
-  bool initToonShader(const std::string& vertexSource, const std::string& fragmentSource);
-  bool initTextureShader(const std::string& vertexSource, const std::string& fragmentSource);
-  bool initGouraudTextureShader(const std::string& vertexSource, const std::string& fragmentSource);
-  bool initClipShader(const std::string& vertexSource, const std::string& fragmentSource);
+  /// Set the annotated source the surface shader variants are built from,
+  /// see vesSurface_vert.glsl for the symbols it must understand. Replaces
+  /// the variants in use, representations are given the new ones.
+  bool initSurfaceShader(const std::string& vertexSource, const std::string& fragmentSource);
+  bool initScalarColorMapShader(const std::string& vertexSource, const std::string& fragmentSource);
+  bool initImageAtlasShader(const std::string& vertexSource, const std::string& fragmentSource);
+  bool initVolumeShader(const std::string& vertexSource, const std::string& fragmentSource);
 
+  /// Besides the changes tracked by the superclass, a render is needed
+  /// while any data representation asks for one.
+  /// \see vesKiwiDataRepresentation::isRenderNeeded()
+  virtual bool isRenderNeeded() const;
+
+  /// Same as isRenderNeeded(), kept for existing platform code.
   bool isAnimating() const;
   void setBackgroundTexture(const std::string& filename);
 
@@ -103,9 +111,17 @@ public:
 
   void applyBuiltinDatasetCameraParameters(int index);
 
+  /// The surface shader variant for vertex colored geometry lit by the
+  /// current shading model.
   const vesSharedPtr<vesShaderProgram> shaderProgram() const;
   vesSharedPtr<vesShaderProgram> shaderProgram();
 
+  /// Return the surface shader variant for \p features, a combination of
+  /// vesKiwiPolyDataRepresentation::ShaderFeature. The variant is built on
+  /// first use and shared afterwards. With the Lighting feature, the
+  /// lighting of the current shading model is used.
+  vesSharedPtr<vesShaderProgram> surfaceShader(unsigned int features);
+
 
 protected:
 
@@ -114,8 +130,7 @@ protected:
   virtual bool loadDatasetWithCustomBehavior(const std::string& filename);
 
   void addBuiltinDataset(const std::string& name, const std::string& filename);
-  void addBuiltinShadingModel(
-    const std::string& name, vesSharedPtr<vesShaderProgram> shaderProgram);
+  void addBuiltinShadingModel(const std::string& name, unsigned int lightingFeatures);
 
   void removeAllDataRepresentations();
   void addRepresentationsForDataSet(vtkDataSet* dataSet);
@@ -125,7 +140,9 @@ protected:
   void resetScene();
 
   vesKiwiPolyDataRepresentation* addPolyDataRepresentation(
-    vtkPolyData* polyData, vesSharedPtr<vesShaderProgram> program);
+    vtkPolyData* polyData, unsigned int shaderFeatures);
+  vesKiwiPolyDataRepresentation* addPolyDataRepresentation(
+    vesSharedPtr<vesGeometryData> geometryData, unsigned int shaderFeatures);
   vesKiwiText2DRepresentation* addTextRepresentation(const std::string& text);
   vesKiwiPlaneWidget* addPlaneWidget();
   bool loadBrainAtlas(const std::string& filename);
@@ -0,0 +1,434 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+
+#include "vesKiwiVolumeRepresentation.h"
+#include "vesKiwiDataConversionTools.h"
+
+#include "vesActor.h"
+#include "vesCamera.h"
+#include "vesDepth.h"
+#include "vesGeometryData.h"
+#include "vesMaterial.h"
+#include "vesMaterialUniforms.h"
+#include "vesPrimitive.h"
+#include "vesRenderer.h"
+#include "vesSourceData.h"
+#include "vesTexture.h"
+#include "vesUniform.h"
+
+#include <vtkImageData.h>
+#include <vtkLookupTable.h>
+#include <vtkScalarsToColors.h>
+#include <vtkUnsignedCharArray.h>
+
+#include <algorithm>
+#include <cassert>
+#include <vector>
+
+namespace {
+
+// Voxels along a brick edge of the empty space skipping grid.
+const int BrickSize = 8;
+
+const int TransferFunctionResolution = 256;
+
+//----------------------------------------------------------------------------
+vesSharedPtr<vesGeometryData> BoxGeometry(const double bounds[6])
+{
+  vesSourceDataP3f::Ptr source(new vesSourceDataP3f());
+  for (int corner = 0; corner < 8; ++corner) {
+    vesVertexDataP3f vertex;
+    vertex.m_position[0] = bounds[(corner & 1) ? 1 : 0];
+    vertex.m_position[1] = bounds[(corner & 2) ? 3 : 2];
+    vertex.m_position[2] = bounds[(corner & 4) ? 5 : 4];
+    source->pushBack(vertex);
+  }
+
+  // Counterclockwise seen from outside, the shader relies on it to tell
+  // back faces apart.
+  static const unsigned short faces[6][4] = {
+    {0, 4, 6, 2}, {1, 3, 7, 5},
+    {0, 1, 5, 4}, {2, 6, 7, 3},
+    {0, 2, 3, 1}, {4, 5, 7, 6}
+  };
+
+  vesPrimitive::Ptr triangles(new vesPrimitive());
+  triangles->setPrimitiveType(vesPrimitiveRenderType::Triangles);
+  triangles->setIndexCount(3);
+  for (int i = 0; i < 6; ++i) {
+    triangles->pushBackIndices(faces[i][0], faces[i][1], faces[i][2]);
+    triangles->pushBackIndices(faces[i][0], faces[i][2], faces[i][3]);
+  }
+
+  vesSharedPtr<vesGeometryData> geometryData(new vesGeometryData());
+  geometryData->setName("VolumeBox");
+  geometryData->addSource(source);
+  geometryData->addPrimitive(triangles);
+  geometryData->computeBounds();
+  return geometryData;
+}
+
+} // end namespace
+
+//----------------------------------------------------------------------------
+class vesKiwiVolumeRepresentation::vesInternal
+{
+public:
+
+  vesInternal()
+  {
+    this->SampleDistance = 1.0;
+    this->InteractiveSampleDistance = 3.0;
+    this->Interactive = false;
+    this->EyePosition = vesVector4f(0.0f, 0.0f, 0.0f, 0.0f);
+    for (int i = 0; i < 3; ++i) {
+      this->Dimensions[i] = 0;
+      this->BrickDimensions[i] = 0;
+    }
+    this->BrickAtlasGrid[0] = this->BrickAtlasGrid[1] = 0;
+  }
+
+  int Dimensions[3];
+  double Bounds[6];
+
+  int BrickDimensions[3];
+  int BrickAtlasGrid[2];
+  std::vector<unsigned char> BrickMinimum;
+  std::vector<unsigned char> BrickMaximum;
+
+  double ScalarRange[2];
+  vtkSmartPointer<vtkScalarsToColors> TransferFunction;
+  vtkSmartPointer<vtkUnsignedCharArray> TransferFunctionTable;
+
+  double SampleDistance;
+  double InteractiveSampleDistance;
+  bool Interactive;
+  vesVector4f EyePosition;
+
+  vesSharedPtr<vesTexture> VolumeTexture;
+  vesSharedPtr<vesTexture> BrickTexture;
+  vesSharedPtr<vesUniform> EyePositionUniform;
+  vesSharedPtr<vesUniform> SampleDistanceUniform;
+  vesSharedPtr<vesUniform> OpacityCorrectionUniform;
+};
+
+//----------------------------------------------------------------------------
+vesKiwiVolumeRepresentation::vesKiwiVolumeRepresentation()
+{
+  this->Internal = new vesInternal();
+}
+
+//----------------------------------------------------------------------------
+vesKiwiVolumeRepresentation::~vesKiwiVolumeRepresentation()
+{
+  delete this->Internal;
+}
+
+//----------------------------------------------------------------------------
+bool vesKiwiVolumeRepresentation::volumeFits(vtkImageData* volume)
+{
+  int dimensions[3];
+  volume->GetDimensions(dimensions);
+
+  int columns;
+  int rows;
+  return dimensions[0] > 1 && dimensions[1] > 1 && dimensions[2] > 1
+    && vesKiwiDataConversionTools::GetSliceAtlasLayout(
+         dimensions[0], dimensions[1], dimensions[2], columns, rows);
+}
+
+//----------------------------------------------------------------------------
+vtkSmartPointer<vtkLookupTable> vesKiwiVolumeRepresentation::defaultTransferFunction(
+  double scalarRange[2])
+{
+  vtkSmartPointer<vtkLookupTable> table = vtkSmartPointer<vtkLookupTable>::New();
+  table->SetNumberOfTableValues(TransferFunctionResolution);
+  table->SetRange(scalarRange);
+  for (int i = 0; i < TransferFunctionResolution; ++i) {
+    const double value = static_cast<double>(i) / (TransferFunctionResolution - 1);
+    const double ramp = std::max(0.0, (value - 1.0/3.0) * 1.5);
+    table->SetTableValue(i, value, value, value, 0.2 * ramp * ramp);
+  }
+  return table;
+}
+
+//----------------------------------------------------------------------------
+bool vesKiwiVolumeRepresentation::setVolumeData(vtkImageData* volume,
+  vtkUnsignedCharArray* levels, double scalarRange[2],
+  vtkScalarsToColors* transferFunction)
+{
+  assert(volume);
+  assert(levels && levels->GetNumberOfComponents() == 1);
+  assert(levels->GetNumberOfTuples() == volume->GetNumberOfPoints());
+  assert(transferFunction);
+
+  if (!volumeFits(volume)) {
+    return false;
+  }
+
+  int* dimensions = this->Internal->Dimensions;
+  volume->GetDimensions(dimensions);
+
+  int columns;
+  int rows;
+  vesKiwiDataConversionTools::GetSliceAtlasLayout(
+    dimensions[0], dimensions[1], dimensions[2], columns, rows);
+  vtkSmartPointer<vtkUnsignedCharArray> atlas =
+    vesKiwiDataConversionTools::GetSliceAtlas(levels, dimensions, 2, columns, rows);
+
+  this->Internal->VolumeTexture = vesTexture::Ptr(new vesTexture());
+  this->Internal->VolumeTexture->setTextureUnit(1);
+  vesKiwiDataConversionTools::SetTextureData(atlas, this->Internal->VolumeTexture,
+    columns * dimensions[0], rows * dimensions[1]);
+
+  // Value range of each brick, including the voxels shared with the next
+  // brick since samples in between interpolate them.
+  int* brickDimensions = this->Internal->BrickDimensions;
+  for (int i = 0; i < 3; ++i) {
+    brickDimensions[i] = (dimensions[i] - 2) / BrickSize + 1;
+  }
+  const int numberOfBricks = brickDimensions[0] * brickDimensions[1] * brickDimensions[2];
+  this->Internal->BrickMinimum.assign(numberOfBricks, 255);
+  this->Internal->BrickMaximum.assign(numberOfBricks, 0);
+
+  const unsigned char* input = levels->GetPointer(0);
+  for (int k = 0; k < dimensions[2]; ++k) {
+    const int k0 = std::min(k / BrickSize, brickDimensions[2] - 1);
+    const int k1 = (k % BrickSize == 0 && k > 0) ? k / BrickSize - 1 : k0;
+    for (int j = 0; j < dimensions[1]; ++j) {
+      const int j0 = std::min(j / BrickSize, brickDimensions[1] - 1);
+      const int j1 = (j % BrickSize == 0 && j > 0) ? j / BrickSize - 1 : j0;
+      for (int i = 0; i < dimensions[0]; ++i, ++input) {
+        const int i0 = std::min(i / BrickSize, brickDimensions[0] - 1);
+        const int i1 = (i % BrickSize == 0 && i > 0) ? i / BrickSize - 1 : i0;
+
+        // A voxel on a brick boundary belongs to the bricks on both sides.
+        for (int bk = k1; bk <= k0; ++bk) {
+          for (int bj = j1; bj <= j0; ++bj) {
+            for (int bi = i1; bi <= i0; ++bi) {
+              const int brick = (bk * brickDimensions[1] + bj) * brickDimensions[0] + bi;
+              this->Internal->BrickMinimum[brick] = std::min(this->Internal->BrickMinimum[brick], *input);
+              this->Internal->BrickMaximum[brick] = std::max(this->Internal->BrickMaximum[brick], *input);
+            }
+          }
+        }
+      }
+    }
+  }
+
+  vesKiwiDataConversionTools::GetSliceAtlasLayout(brickDimensions[0], brickDimensions[1],
+    brickDimensions[2], this->Internal->BrickAtlasGrid[0], this->Internal->BrickAtlasGrid[1]);
+  this->Internal->BrickTexture = vesTexture::Ptr(new vesTexture());
+  this->Internal->BrickTexture->setTextureUnit(2);
+
+  // The box spans the voxel centers, matching the sample positions.
+  volume->GetBounds(this->Internal->Bounds);
+  this->setGeometryData(BoxGeometry(this->Internal->Bounds));
+
+  vesSharedPtr<vesDepth> depth(new vesDepth());
+  depth->disable();
+  this->actor()->material()->addAttribute(depth);
+  this->actor()->material()->addAttribute(this->Internal->VolumeTexture);
+  this->actor()->material()->addAttribute(this->Internal->BrickTexture);
+
+  const double* bounds = this->Internal->Bounds;
+  vesSharedPtr<vesMaterialUniforms> uniforms = this->materialUniforms();
+  uniforms->addUniform(vesUniform::Ptr(new vesUniform("volumeOrigin",
+    vesVector3f(bounds[0], bounds[2], bounds[4]))));
+  uniforms->addUniform(vesUniform::Ptr(new vesUniform("volumeSize",
+    vesVector3f(bounds[1] - bounds[0], bounds[3] - bounds[2], bounds[5] - bounds[4]))));
+  uniforms->addUniform(vesUniform::Ptr(new vesUniform("volumeDimensions",
+    vesVector3f(dimensions[0], dimensions[1], dimensions[2]))));
+  uniforms->addUniform(vesUniform::Ptr(new vesUniform("atlasGrid",
+    vesVector2f(columns, rows))));
+  uniforms->addUniform(vesUniform::Ptr(new vesUniform("brickDimensions",
+    vesVector3f(brickDimensions[0], brickDimensions[1], brickDimensions[2]))));
+  uniforms->addUniform(vesUniform::Ptr(new vesUniform("brickAtlasGrid",
+    vesVector2f(this->Internal->BrickAtlasGrid[0], this->Internal->BrickAtlasGrid[1]))));
+  uniforms->addUniform(vesUniform::Ptr(new vesUniform("brickSize",
+    static_cast<float>(BrickSize))));
+
+  if (!this->Internal->EyePositionUniform) {
+    this->Internal->EyePositionUniform = vesUniform::Ptr(
+      new vesUniform("eyePosition", vesVector4f(0.0f, 0.0f, -1.0f, 0.0f)));
+    this->Internal->SampleDistanceUniform = vesUniform::Ptr(
+      new vesUniform("sampleDistance", 0.01f));
+    this->Internal->OpacityCorrectionUniform = vesUniform::Ptr(
+      new vesUniform("opacityCorrection", 1.0f));
+  }
+  uniforms->addUniform(this->Internal->EyePositionUniform);
+  uniforms->addUniform(this->Internal->SampleDistanceUniform);
+  uniforms->addUniform(this->Internal->OpacityCorrectionUniform);
+
+  this->Internal->ScalarRange[0] = scalarRange[0];
+  this->Internal->ScalarRange[1] = scalarRange[1];
+  this->setTransferFunction(transferFunction);
+  this->updateSampleDistance(false);
+  return true;
+}
+
+//----------------------------------------------------------------------------
+void vesKiwiVolumeRepresentation::setTransferFunction(vtkScalarsToColors* transferFunction)
+{
+  assert(transferFunction);
+  assert(this->Internal->BrickTexture);
+
+  vtkSmartPointer<vtkUnsignedCharArray> table = vtkSmartPointer<vtkUnsignedCharArray>::New();
+  table->SetNumberOfComponents(4);
+  table->SetNumberOfTuples(TransferFunctionResolution);
+
+  const double* range = this->Internal->ScalarRange;
+  const double step = (range[1] - range[0]) / (TransferFunctionResolution - 1);
+  double rgb[3];
+  for (int i = 0; i < TransferFunctionResolution; ++i) {
+    const double value = range[0] + i * step;
+    transferFunction->GetColor(value, rgb);
+    const double opacity = transferFunction->GetOpacity(value);
+    table->SetTuple4(i, rgb[0]*255, rgb[1]*255, rgb[2]*255, opacity*255);
+  }
+
+  this->Internal->TransferFunction = transferFunction;
+  this->Internal->TransferFunctionTable = table;
+  this->setTexture(vesKiwiDataConversionTools::SharedTexture(table, TransferFunctionResolution, 1));
+  this->updateBrickOccupancy();
+}
+
+//----------------------------------------------------------------------------
+void vesKiwiVolumeRepresentation::updateBrickOccupancy()
+{
+  // Number of levels up to each level that are not fully transparent, so
+  // that a brick is tested in constant time.
+  std::vector<int> visibleLevels(TransferFunctionResolution + 1, 0);
+  const unsigned char* table = this->Internal->TransferFunctionTable->GetPointer(0);
+  for (int i = 0; i < TransferFunctionResolution; ++i) {
+    visibleLevels[i + 1] = visibleLevels[i] + (table[4*i + 3] ? 1 : 0);
+  }
+
+  const size_t numberOfBricks = this->Internal->BrickMinimum.size();
+  vtkSmartPointer<vtkUnsignedCharArray> occupancy = vtkSmartPointer<vtkUnsignedCharArray>::New();
+  occupancy->SetNumberOfTuples(numberOfBricks);
+  for (size_t i = 0; i < numberOfBricks; ++i) {
+    const int minimum = this->Internal->BrickMinimum[i];
+    const int maximum = this->Internal->BrickMaximum[i];
+    occupancy->SetValue(i, visibleLevels[maximum + 1] > visibleLevels[minimum] ? 255 : 0);
+  }
+
+  const int* brickDimensions = this->Internal->BrickDimensions;
+  const int* grid = this->Internal->BrickAtlasGrid;
+  vtkSmartPointer<vtkUnsignedCharArray> atlas = vesKiwiDataConversionTools::GetSliceAtlas(
+    occupancy, brickDimensions, 2, grid[0], grid[1]);
+  vesKiwiDataConversionTools::SetTextureData(atlas, this->Internal->BrickTexture,
+    grid[0] * brickDimensions[0], grid[1] * brickDimensions[1]);
+}
+
+//----------------------------------------------------------------------------
+void vesKiwiVolumeRepresentation::updateSampleDistance(bool interactive)
+{
+  this->Internal->Interactive = interactive;
+
+  const double distance = interactive ? this->Internal->InteractiveSampleDistance
+                                      : this->Internal->SampleDistance;
+  const int* dimensions = this->Internal->Dimensions;
+  const int longestAxis = std::max(dimensions[0], std::max(dimensions[1], dimensions[2])) - 1;
+  if (longestAxis < 1 || !this->Internal->SampleDistanceUniform) {
+    return;
+  }
+
+  this->Internal->SampleDistanceUniform->set(static_cast<float>(distance / longestAxis));
+  this->Internal->OpacityCorrectionUniform->set(static_cast<float>(distance));
+}
+
+//----------------------------------------------------------------------------
+void vesKiwiVolumeRepresentation::willRender(vesSharedPtr<vesRenderer> renderer)
+{
+  if (!this->Internal->EyePositionUniform) {
+    return;
+  }
+
+  vesSharedPtr<vesCamera> camera = renderer->camera();
+  const vesMatrix4x4f worldToModel = this->actor()->matrix().inverse();
+  const double* bounds = this->Internal->Bounds;
+  const vesVector3f origin(bounds[0], bounds[2], bounds[4]);
+  const vesVector3f size(bounds[1] - bounds[0], bounds[3] - bounds[2], bounds[5] - bounds[4]);
+
+  // Camera in volume coordinates, where the box spans [0, 1] on each axis.
+  vesVector4f eyePosition;
+  if (camera->parallelProjection()) {
+    vesVector4f direction;
+    direction << camera->focalPoint() - camera->position(), 0.0f;
+    direction = worldToModel * direction;
+    vesVector3f volumeDirection = direction.head<3>().cwiseQuotient(size).normalized();
+    eyePosition << volumeDirection, 0.0f;
+  }
+  else {
+    vesVector4f position;
+    position << camera->position(), 1.0f;
+    position = worldToModel * position;
+    eyePosition << (position.head<3>() / position[3] - origin).cwiseQuotient(size), 1.0f;
+  }
+
+  // Sample coarser for as long as the camera moves.
+  const bool moved = eyePosition != this->Internal->EyePosition;
+  this->Internal->EyePosition = eyePosition;
+  this->Internal->EyePositionUniform->set(eyePosition);
+  if (moved != this->Internal->Interactive) {
+    this->updateSampleDistance(moved);
+  }
+}
+
+//----------------------------------------------------------------------------
+bool vesKiwiVolumeRepresentation::needsRefinement() const
+{
+  return this->Internal->Interactive;
+}
+
+//----------------------------------------------------------------------------
+void vesKiwiVolumeRepresentation::setSampleDistance(double distance)
+{
+  this->Internal->SampleDistance = std::max(distance, 0.1);
+  this->updateSampleDistance(this->Internal->Interactive);
+}
+
+//----------------------------------------------------------------------------
+double vesKiwiVolumeRepresentation::sampleDistance() const
+{
+  return this->Internal->SampleDistance;
+}
+
+//----------------------------------------------------------------------------
+void vesKiwiVolumeRepresentation::setInteractiveSampleDistance(double distance)
+{
+  this->Internal->InteractiveSampleDistance = std::max(distance, 0.1);
+  this->updateSampleDistance(this->Internal->Interactive);
+}
+
+//----------------------------------------------------------------------------
+double vesKiwiVolumeRepresentation::interactiveSampleDistance() const
+{
+  return this->Internal->InteractiveSampleDistance;
+}
+
+//----------------------------------------------------------------------------
+void vesKiwiVolumeRepresentation::setShaderProgram(
+  vesSharedPtr<vesShaderProgram> shaderProgram)
+{
+  // Do nothing.
+  vesNotUsed(shaderProgram);
+}
@@ -0,0 +1,99 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+/// \class vesKiwiVolumeRepresentation
+/// \ingroup KiwiPlatform
+/// \brief Ray casts image data on the GPU.
+///
+/// The volume is uploaded once as an atlas of z slices and drawn by
+/// vesVolumeRayCast_frag.glsl through its bounding box. A coarse grid of
+/// bricks, flagged empty when the transfer function makes all of their
+/// values transparent, lets rays jump over empty space. While the camera
+/// moves, rays are sampled with the interactive sample distance, and the
+/// full sample distance is restored on the first frame after it stops.
+#ifndef __vesKiwiVolumeRepresentation_h
+#define __vesKiwiVolumeRepresentation_h
+
+#include "vesKiwiPolyDataRepresentation.h"
+
+#include <vtkSmartPointer.h>
+
+class vtkImageData;
+class vtkLookupTable;
+class vtkScalarsToColors;
+class vtkUnsignedCharArray;
+
+class vesKiwiVolumeRepresentation : public vesKiwiPolyDataRepresentation
+{
+public:
+
+  vesTypeMacro(vesKiwiVolumeRepresentation);
+
+  vesKiwiVolumeRepresentation();
+  ~vesKiwiVolumeRepresentation();
+
+  /// Upload the volume. The levels are the volume scalars quantized over
+  /// \a scalarRange, see vesKiwiDataConversionTools::QuantizeScalars(). The
+  /// transfer function maps the scalar range to colors and opacities, the
+  /// opacities applying to samples one voxel apart. Returns false if the
+  /// atlas does not fit into a texture.
+  bool setVolumeData(vtkImageData* volume, vtkUnsignedCharArray* levels,
+                     double scalarRange[2], vtkScalarsToColors* transferFunction);
+
+  /// Replace the transfer function, this also updates which bricks are empty.
+  void setTransferFunction(vtkScalarsToColors* transferFunction);
+
+  /// Set the distance between samples along the rays, in voxels.
+  void setSampleDistance(double distance);
+  double sampleDistance() const;
+
+  /// Set the distance between samples used while the camera moves.
+  void setInteractiveSampleDistance(double distance);
+  double interactiveSampleDistance() const;
+
+  /// Return true if the last frame was drawn with the interactive sample
+  /// distance, so that another frame is needed for the full quality image.
+  bool needsRefinement() const;
+
+  virtual void willRender(vesSharedPtr<vesRenderer> renderer);
+
+  /// The volume has its own shader, so this does nothing.
+  virtual void setShaderProgram(vesSharedPtr<vesShaderProgram> shaderProgram);
+
+  /// Return whether the slice atlas of the volume fits into a texture,
+  /// requires a current context for the actual size limit.
+  static bool volumeFits(vtkImageData* volume);
+
+  /// Grayscale transfer function, transparent over the lower third of the
+  /// scalar range and increasingly opaque above.
+  static vtkSmartPointer<vtkLookupTable> defaultTransferFunction(double scalarRange[2]);
+
+private:
+
+  vesKiwiVolumeRepresentation(const vesKiwiVolumeRepresentation&); // Not implemented
+  void operator=(const vesKiwiVolumeRepresentation&); // Not implemented
+
+  void updateBrickOccupancy();
+  void updateSampleDistance(bool interactive);
+
+  class vesInternal;
+  vesInternal* Internal;
+};
+
+#endif
@@ -0,0 +1,36 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+/// \file vesImageAtlas_frag.glsl
+///
+/// \ingroup shaders
+
+// Uniforms.
+uniform lowp sampler2D image;
+uniform lowp sampler2D colorMap;
+
+// Varying attributes.
+varying highp vec2 atlasCoordinate;
+
+void main()
+{
+  // The atlas stores scalars normalized to the range of the lookup table.
+  lowp float scalar = texture2D(image, atlasCoordinate).x;
+  gl_FragColor = texture2D(colorMap, vec2(scalar, 0.5));
+}
@@ -0,0 +1,35 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+/// \file vesScalarColorMap_frag.glsl
+///
+/// \ingroup shaders
+
+// Uniforms.
+uniform lowp sampler2D colorMap;
+
+// Varying attributes.
+varying highp float lookupTableCoordinate;
+varying lowp float  nDotL;
+
+void main()
+{
+  lowp vec4 color = texture2D(colorMap, vec2(lookupTableCoordinate, 0.5));
+  gl_FragColor = vec4(color.xyz * nDotL, color.w);
+}
@@ -0,0 +1,65 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+/// \file vesScalarColorMap_vert.glsl
+///
+/// Maps a per vertex scalar to a color using a lookup table texture.
+///
+/// \ingroup shaders
+
+// Uniforms.
+uniform highp mat4   modelViewMatrix;
+uniform mediump mat3 normalMatrix;
+uniform highp mat4   projectionMatrix;
+uniform lowp int     primitiveType;
+uniform highp vec2   scalarRange;
+
+// Vertex attributes.
+attribute highp vec3   vertexPosition;
+attribute mediump vec3 vertexNormal;
+attribute highp float  vertexScalar;
+
+// Varying attributes.
+varying highp float lookupTableCoordinate;
+varying lowp float  nDotL;
+
+void main()
+{
+  // Normalize the scalar into the lookup table.
+  lookupTableCoordinate = clamp((vertexScalar - scalarRange.x) /
+    max(scalarRange.y - scalarRange.x, 1e-20), 0.0, 1.0);
+
+  nDotL = 1.0;
+
+  // 1 is line
+  if (primitiveType != 1 && primitiveType != 0) {
+    // Transform vertex normal into eye space.
+    lowp vec3 normal = normalize(normalMatrix * vertexNormal);
+
+    // Save light direction (direction light for now)
+    lowp vec3 lightDirection = normalize(vec3(0.0, 0.0, 0.650));
+
+    // Do backface lighting too.
+    nDotL = max(max(dot(normal, lightDirection), 0.0),
+                dot(-normal, lightDirection));
+  }
+
+  gl_PointSize = 1.0;
+  gl_Position = projectionMatrix * modelViewMatrix * vec4(vertexPosition, 1.0);
+}
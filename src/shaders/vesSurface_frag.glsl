@@ -0,0 +1,126 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+/// \file vesSurface_frag.glsl
+///
+/// \ingroup shaders
+///
+/// \see vesSurface_vert.glsl for the feature symbols.
+
+#if defined(VES_LIGHTING) && (defined(VES_BLINN_PHONG) || defined(VES_TOON))
+#define VES_PER_FRAGMENT_LIGHTING
+#endif
+
+// Uniforms.
+uniform lowp int primitiveType;
+
+#ifdef VES_LIGHTING
+const mediump vec3 lightDirection = vec3(0.0, 0.0, 1.0);
+
+#ifdef VES_PER_FRAGMENT_LIGHTING
+varying mediump vec3 varNormal;
+varying mediump vec3 varEyePosition;
+#else
+varying lowp float varDiffuse;
+#endif
+#endif
+
+#ifdef VES_VERTEX_COLORS
+varying lowp vec4 varColor;
+#endif
+
+#ifdef VES_TEXTURE
+uniform highp sampler2D image;
+varying mediump vec2    textureCoordinate;
+#endif
+
+#ifdef VES_CLIP_PLANE
+varying highp float clipDistance;
+#endif
+
+void main()
+{
+#ifdef VES_CLIP_PLANE
+  if (clipDistance < 0.0)
+    discard;
+#endif
+
+#ifdef VES_POINT_SPRITES
+  // 0 is points.
+  if (primitiveType == 0) {
+    mediump vec2 offset = gl_PointCoord - vec2(0.5, 0.5);
+    if (dot(offset, offset) > 0.25)
+      discard;
+  }
+#endif
+
+  lowp vec4 color = vec4(1.0, 1.0, 1.0, 1.0);
+
+#ifdef VES_VERTEX_COLORS
+  color = varColor;
+#endif
+
+#ifdef VES_TEXTURE
+  color = color * texture2D(image, textureCoordinate);
+#endif
+
+#ifdef VES_LIGHTING
+#if defined(VES_TOON)
+  mediump float intensity = 1.0;
+  if (primitiveType > 3) {
+    intensity = dot(normalize(varNormal), lightDirection);
+  }
+
+  if (intensity > 0.92) {
+    color = vec4(0.95, 0.55, 0.5, color.w);
+  }
+  else if (intensity > 0.70) {
+    color = vec4(0.7, 0.4, 0.33, color.w);
+  }
+  else if (intensity > 0.5) {
+    color = vec4(0.6, 0.33, 0.26, color.w);
+  }
+  else {
+    color = vec4(0.4, 0.25, 0.20, color.w);
+  }
+#elif defined(VES_BLINN_PHONG)
+  if (primitiveType > 3) {
+    highp vec3 n = normalize(varNormal);
+
+    // Default to metallic look and feel.
+    highp float specularShininess = 64.0;
+    lowp vec4 specularColor = vec4(0.6, 0.6, 0.6, 0.0);
+
+    // Using half vector for specular lighting as it is much cheaper than
+    // calculating reflection vector.
+    highp vec3 viewDirection = normalize(-varEyePosition);
+    highp vec3 halfVector = normalize(lightDirection + viewDirection);
+
+    lowp float nDotL = max(dot(n, lightDirection), 0.0);
+    lowp float nDotH = max(dot(n, halfVector), 0.1);
+    color = vec4(color.xyz * nDotL, color.w) +
+      specularColor * pow(nDotH, specularShininess);
+  }
+#else
+  color = vec4(color.xyz * varDiffuse, color.w);
+#endif
+#endif
+
+  gl_FragColor = color;
+}
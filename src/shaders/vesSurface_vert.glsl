@@ -0,0 +1,119 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+/// \file vesSurface_vert.glsl
+///
+/// \ingroup shaders
+///
+/// Surface shader built with vesShaderPermutations. The optional parts are
+/// enabled by:
+///   VES_LIGHTING       diffuse lighting, per vertex unless VES_BLINN_PHONG
+///                      or VES_TOON selects a per fragment model
+///   VES_VERTEX_COLORS  use the vertexColor attribute as base color
+///   VES_TEXTURE        modulate the color with the image texture
+///   VES_CLIP_PLANE     discard what is behind clipPlaneEquation
+///   VES_POINT_SPRITES  draw points as discs of pointSize pixels
+
+#if defined(VES_LIGHTING) && (defined(VES_BLINN_PHONG) || defined(VES_TOON))
+#define VES_PER_FRAGMENT_LIGHTING
+#endif
+
+// Uniforms.
+uniform highp mat4 modelViewMatrix;
+uniform highp mat4 projectionMatrix;
+uniform lowp int   primitiveType;
+
+// Vertex attributes.
+attribute highp vec3 vertexPosition;
+
+#ifdef VES_LIGHTING
+uniform mediump mat3   normalMatrix;
+attribute mediump vec3 vertexNormal;
+
+// Directional light along the view direction.
+const mediump vec3 lightDirection = vec3(0.0, 0.0, 1.0);
+
+#ifdef VES_PER_FRAGMENT_LIGHTING
+varying mediump vec3 varNormal;
+varying mediump vec3 varEyePosition;
+#else
+varying lowp float varDiffuse;
+#endif
+#endif
+
+#ifdef VES_VERTEX_COLORS
+attribute lowp vec4 vertexColor;
+varying lowp vec4   varColor;
+#endif
+
+#ifdef VES_TEXTURE
+attribute mediump vec4 vertexTextureCoordinate;
+varying mediump vec2   textureCoordinate;
+#endif
+
+#ifdef VES_CLIP_PLANE
+uniform highp vec4   clipPlaneEquation;
+varying highp float  clipDistance;
+#endif
+
+#ifdef VES_POINT_SPRITES
+uniform mediump float pointSize;
+#endif
+
+void main()
+{
+  highp vec4 eyePosition = modelViewMatrix * vec4(vertexPosition, 1.0);
+
+#ifdef VES_VERTEX_COLORS
+  varColor = vertexColor;
+#endif
+
+#ifdef VES_TEXTURE
+  textureCoordinate = vertexTextureCoordinate.xy;
+#endif
+
+#ifdef VES_CLIP_PLANE
+  clipDistance = dot(vertexPosition, clipPlaneEquation.xyz) + clipPlaneEquation.w;
+#endif
+
+#ifdef VES_LIGHTING
+  // Transform vertex normal into eye space.
+  mediump vec3 normal = normalize(normalMatrix * vertexNormal);
+
+#ifdef VES_PER_FRAGMENT_LIGHTING
+  varNormal = normal;
+  varEyePosition = eyePosition.xyz;
+#else
+  // Only surfaces are lit (4 and above are the triangle types), and back
+  // faces like front faces.
+  varDiffuse = 1.0;
+  if (primitiveType > 3) {
+    varDiffuse = abs(dot(normal, lightDirection));
+  }
+#endif
+#endif
+
+#ifdef VES_POINT_SPRITES
+  gl_PointSize = pointSize;
+#else
+  gl_PointSize = 1.0;
+#endif
+
+  gl_Position = projectionMatrix * eyePosition;
+}
@@ -0,0 +1,145 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+/// \file vesVolumeRayCast_frag.glsl
+///
+/// \ingroup shaders
+///
+/// Ray casts a volume stored as an atlas of z slices. Rays skip over bricks
+/// that are fully transparent under the transfer function and stop once the
+/// accumulated opacity saturates. Only back faces of the bounding box are
+/// shaded, so rays are also cast when the camera is inside the volume.
+
+// Uniforms.
+uniform lowp sampler2D transferFunction;
+uniform lowp sampler2D volume;
+uniform lowp sampler2D bricks;
+
+// Number of voxels along each axis, and tile columns and rows of the atlas.
+uniform highp vec3 volumeDimensions;
+uniform highp vec2 atlasGrid;
+
+// Number of bricks along each axis, tile columns and rows of the brick
+// occupancy atlas, and voxels along a brick edge.
+uniform highp vec3 brickDimensions;
+uniform highp vec2 brickAtlasGrid;
+uniform highp float brickSize;
+
+// Camera position in volume coordinates, or the direction of projection
+// for parallel projections, in which case w is zero.
+uniform highp vec4 eyePosition;
+
+// Distance between samples in volume coordinates, and the ratio to the
+// distance the transfer function opacities are defined for.
+uniform highp float sampleDistance;
+uniform mediump float opacityCorrection;
+
+// Varying attributes.
+varying highp vec3 volumeCoordinate;
+
+const int maximumNumberOfSamples = 1024;
+
+highp vec2 atlasCoordinate(highp vec2 texel, highp float slice,
+                           highp vec2 tileSize, highp vec2 grid)
+{
+  highp float row = floor((slice + 0.5) / grid.x);
+  highp float column = slice - row * grid.x;
+  return (vec2(column, row) * tileSize + texel) / (grid * tileSize);
+}
+
+lowp float sampleVolume(highp vec3 position)
+{
+  highp vec3 voxel = position * (volumeDimensions - 1.0);
+  highp vec2 texel = voxel.xy + 0.5;
+  highp float slice = min(floor(voxel.z), volumeDimensions.z - 2.0);
+  lowp float front = texture2D(volume,
+    atlasCoordinate(texel, slice, volumeDimensions.xy, atlasGrid)).x;
+  lowp float back = texture2D(volume,
+    atlasCoordinate(texel, slice + 1.0, volumeDimensions.xy, atlasGrid)).x;
+  return mix(front, back, voxel.z - slice);
+}
+
+bool brickIsEmpty(highp vec3 brick)
+{
+  return texture2D(bricks, atlasCoordinate(brick.xy + 0.5, brick.z,
+    brickDimensions.xy, brickAtlasGrid)).x < 0.5;
+}
+
+void main()
+{
+  if (gl_FrontFacing) {
+    discard;
+  }
+
+  highp vec3 rayEnd = volumeCoordinate;
+  highp vec3 rayStart = eyePosition.w > 0.5 ? eyePosition.xyz
+                                            : rayEnd - 2.0 * eyePosition.xyz;
+  highp vec3 direction = rayEnd - rayStart;
+  direction += vec3(equal(direction, vec3(0.0))) * 1.0e-6;
+  highp vec3 inverseDirection = 1.0 / direction;
+
+  // Enter the unit box, or start at the camera when it is inside.
+  highp vec3 entries = min(-rayStart * inverseDirection,
+                           (1.0 - rayStart) * inverseDirection);
+  highp float rayEnter = max(max(max(entries.x, entries.y), entries.z), 0.0);
+  highp float rayStep = sampleDistance / length(direction);
+  highp vec3 brickExtent = brickSize / (volumeDimensions - 1.0);
+  highp vec3 exitCorner = step(0.0, direction) * brickExtent;
+
+  mediump vec4 color = vec4(0.0);
+  highp float t = rayEnter;
+
+  for (int i = 0; i < maximumNumberOfSamples; ++i) {
+    if (t > 1.0) {
+      break;
+    }
+
+    highp vec3 position = clamp(rayStart + t * direction, 0.0, 1.0);
+    highp vec3 brick = min(floor(position / brickExtent), brickDimensions - 1.0);
+
+    if (brickIsEmpty(brick)) {
+      // Continue at the first sample past the brick, staying on the
+      // sample lattice of the ray.
+      highp vec3 exits = (brick * brickExtent + exitCorner - rayStart) * inverseDirection;
+      highp float brickExit = min(min(exits.x, exits.y), exits.z);
+      t = max(t + rayStep, rayEnter + rayStep * ceil((brickExit - rayEnter) / rayStep));
+      continue;
+    }
+
+    // Look up the transfer function at texel centers.
+    highp float scalar = sampleVolume(position) * (255.0 / 256.0) + (0.5 / 256.0);
+    mediump vec4 sampleColor = texture2D(transferFunction, vec2(scalar, 0.5));
+    mediump float alpha = 1.0 - pow(1.0 - sampleColor.a, opacityCorrection);
+
+    color.rgb += (1.0 - color.a) * alpha * sampleColor.rgb;
+    color.a += (1.0 - color.a) * alpha;
+
+    if (color.a > 0.95) {
+      break;
+    }
+
+    t += rayStep;
+  }
+
+  if (color.a < 1.0 / 255.0) {
+    discard;
+  }
+
+  gl_FragColor = vec4(color.rgb / color.a, color.a);
+}
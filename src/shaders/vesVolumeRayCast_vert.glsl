@@ -0,0 +1,43 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+/// \file vesVolumeRayCast_vert.glsl
+///
+/// \ingroup shaders
+
+// Uniforms.
+uniform highp mat4 modelViewMatrix;
+uniform highp mat4 projectionMatrix;
+
+// Position and size of the volume bounding box in model coordinates.
+uniform highp vec3 volumeOrigin;
+uniform highp vec3 volumeSize;
+
+// Vertex attributes.
+attribute highp vec4 vertexPosition;
+
+// Varying attributes.
+varying highp vec3 volumeCoordinate;
+
+void main()
+{
+  gl_Position = projectionMatrix * modelViewMatrix * vertexPosition;
+
+  volumeCoordinate = (vertexPosition.xyz - volumeOrigin) / volumeSize;
+}
@@ -0,0 +1,204 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+
+// Edits geometry data in place, shrinking and growing its arrays, and
+// checks that the two mappers sharing it draw the new content after
+// vesGeometryData::setDataModified(), uploading it once into their shared
+// buffers.
+
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+#include <vesActor.h>
+#include <vesCamera.h>
+#include <vesGeometryData.h>
+#include <vesMapper.h>
+#include <vesMaterial.h>
+#include <vesRenderer.h>
+#include <vesShaderProgram.h>
+#include <vesVertexAttributeKeys.h>
+
+#include <GLES2/gl2.h>
+
+#include "vesHeadlessTesting.h"
+
+//----------------------------------------------------------------------------
+namespace {
+
+const int viewWidth = 64;
+const int viewHeight = 64;
+
+//----------------------------------------------------------------------------
+// Overwrite the arrays of \p geometryData with green squares, given as
+// center x, center y and half size, without replacing the source or the
+// primitive.
+void SetSquares(vesGeometryData::Ptr geometryData, const std::vector<vesVector3f>& squares)
+{
+  std::vector<vesVertexDataP3N3C3f>& vertices =
+    std::tr1::static_pointer_cast<vesSourceDataP3N3C3f>(geometryData->source(0))->arrayReference();
+  std::vector<unsigned short>& indices = *geometryData->primitive(0)->indices();
+  vertices.resize(4 * squares.size());
+  indices.resize(6 * squares.size());
+
+  const float corners[4][2] = { {-1, -1}, {1, -1}, {1, 1}, {-1, 1} };
+  for (size_t i = 0; i < squares.size(); ++i) {
+    for (int j = 0; j < 4; ++j) {
+      vesVertexDataP3N3C3f& vertex = vertices[4 * i + j];
+      vertex.m_position = vesVector3f(squares[i][0] + squares[i][2] * corners[j][0],
+                                      squares[i][1] + squares[i][2] * corners[j][1], 0.0f);
+      vertex.m_normal = vesVector3f(0.0f, 0.0f, 1.0f);
+      vertex.m_color = vesVector3f(0.0f, 1.0f, 0.0f);
+    }
+
+    const unsigned short first = static_cast<unsigned short>(4 * i);
+    const unsigned short quad[6] = { first, static_cast<unsigned short>(first + 1),
+                                     static_cast<unsigned short>(first + 2), first,
+                                     static_cast<unsigned short>(first + 2),
+                                     static_cast<unsigned short>(first + 3) };
+    std::copy(quad, quad + 6, indices.begin() + 6 * i);
+  }
+
+  geometryData->setDataModified();
+}
+
+//----------------------------------------------------------------------------
+vesActor::Ptr CreateActor(vesShaderProgram::Ptr shaderProgram, vesGeometryData::Ptr geometryData)
+{
+  vesMapper::Ptr mapper(new vesMapper());
+  mapper->setGeometryData(geometryData);
+  vesMaterial::Ptr material(new vesMaterial());
+  material->addAttribute(shaderProgram);
+
+  vesActor::Ptr actor(new vesActor());
+  actor->setMapper(mapper);
+  actor->setMaterial(material);
+  return actor;
+}
+
+//----------------------------------------------------------------------------
+bool IsGreen(vesRenderer::Ptr renderer, float x, float y)
+{
+  const vesVector3f display = renderer->computeWorldToDisplay(vesVector3f(x, y, 0.0f));
+  unsigned char pixel[4];
+  glReadPixels(static_cast<int>(display[0]), static_cast<int>(display[1]), 1, 1,
+               GL_RGBA, GL_UNSIGNED_BYTE, pixel);
+  return pixel[0] < 64 && pixel[1] > 192;
+}
+
+//----------------------------------------------------------------------------
+unsigned long DataSize(vesGeometryData::Ptr geometryData)
+{
+  return geometryData->source(0)->sizeInBytes() + geometryData->primitive(0)->sizeInBytes();
+}
+
+//----------------------------------------------------------------------------
+bool Check(bool condition, const char* message)
+{
+  if (!condition) {
+    std::cout << message << std::endl;
+  }
+  return condition;
+}
+
+//----------------------------------------------------------------------------
+bool TestGeometryUpdate()
+{
+  vesShaderProgram::Ptr shaderProgram = CreateVertexColorShaderProgram();
+
+  vesGeometryData::Ptr geometryData(new vesGeometryData());
+  geometryData->addSource(vesSourceDataP3N3C3f::Ptr(new vesSourceDataP3N3C3f()));
+  vesPrimitive::Ptr triangles(new vesPrimitive());
+  triangles->setPrimitiveType(vesPrimitiveRenderType::Triangles);
+  triangles->setIndexCount(3);
+  geometryData->addPrimitive(triangles);
+
+  std::vector<vesVector3f> squares(1, vesVector3f(0.0f, 0.0f, 1.0f));
+  SetSquares(geometryData, squares);
+
+  vesRenderer::Ptr renderer(new vesRenderer());
+  renderer->resize(viewWidth, viewHeight, 1.0f);
+  renderer->addActor(CreateActor(shaderProgram, geometryData));
+  renderer->addActor(CreateActor(shaderProgram, geometryData));
+  renderer->resetCamera();
+
+  for (int i = 0; i < 3 && renderer->isRenderNeeded(); ++i) {
+    renderer->render();
+  }
+  bool passed = Check(!renderer->isRenderNeeded(), "the scene did not settle");
+  passed &= Check(IsGreen(renderer, 0.75f, 0.75f), "the square is not drawn");
+
+  // Nothing is uploaded while the arrays stay the same.
+  renderer->requestRender();
+  renderer->render();
+  const unsigned long bytesUploaded = renderer->statistics().m_bytesUploaded;
+
+  // Shrink, the buffers are large enough.
+  squares[0][2] = 0.25f;
+  SetSquares(geometryData, squares);
+  passed &= Check(renderer->isRenderNeeded(), "edits in place need no render");
+  renderer->render();
+  passed &= Check(renderer->statistics().m_bytesUploaded == bytesUploaded + DataSize(geometryData),
+                  "the shrunk arrays were not uploaded once");
+  passed &= Check(IsGreen(renderer, 0.0f, 0.0f), "the shrunk square is not drawn");
+  passed &= Check(!IsGreen(renderer, 0.75f, 0.75f), "the shrunk square is drawn at its old size");
+
+  // Grow past the size of the buffers.
+  squares.push_back(vesVector3f(0.6f, 0.6f, 0.25f));
+  squares.push_back(vesVector3f(-0.6f, -0.6f, 0.25f));
+  SetSquares(geometryData, squares);
+  renderer->render();
+  passed &= Check(renderer->statistics().m_bytesUploaded == bytesUploaded + DataSize(geometryData),
+                  "the grown arrays were not uploaded once");
+  passed &= Check(IsGreen(renderer, 0.0f, 0.0f) && IsGreen(renderer, 0.6f, 0.6f)
+                  && IsGreen(renderer, -0.6f, -0.6f), "the added squares are not drawn");
+  passed &= Check(!IsGreen(renderer, 0.6f, -0.6f), "the grown squares are wrong");
+  passed &= Check(!renderer->isRenderNeeded(), "the scene did not settle again");
+
+  // Back to one square, which must not draw the stale indices of the others.
+  squares.resize(1);
+  SetSquares(geometryData, squares);
+  renderer->render();
+  passed &= Check(IsGreen(renderer, 0.0f, 0.0f), "the remaining square is not drawn");
+  passed &= Check(!IsGreen(renderer, 0.6f, 0.6f), "the removed squares are still drawn");
+
+  return passed;
+}
+
+}; // end namespace
+//----------------------------------------------------------------------------
+
+
+int
+main(int argc, char *argv[])
+{
+  vesNotUsed(argc);
+  vesNotUsed(argv);
+
+  vesHeadlessContext context;
+  if (!context.initialize(viewWidth, viewHeight)) {
+    return -1;
+  }
+
+  bool passed = TestGeometryUpdate();
+
+  std::cout << (passed ? "Passed" : "Failed") << std::endl;
+  return passed ? 0 : 1;
+}
@@ -0,0 +1,353 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+
+// Encodes a torus with vesMeshCodec and decodes it again. The decoded mesh
+// must have the vertices and triangles of the original, with the attributes
+// within their quantization error: positions within half a step, normals
+// within 0.25 degrees at the default 10 bits. Without normal bits the
+// normals must be recomputed. Truncated and bit flipped data must fail to
+// decode with an error, and must not make the decoder read out of bounds
+// even when the flipped data carries a valid checksum.
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <vesGeometryData.h>
+#include <vesMeshCodec.h>
+#include <vesPrimitive.h>
+#include <vesSourceData.h>
+#include <vesVertexAttributeKeys.h>
+
+//----------------------------------------------------------------------------
+namespace {
+
+const float pi = 3.14159265358979f;
+const float radius = 2.0f;
+const float tubeRadius = 0.75f;
+
+//----------------------------------------------------------------------------
+bool Check(bool condition, const std::string& message)
+{
+  if (!condition) {
+    std::cout << message << std::endl;
+  }
+  return condition;
+}
+
+//----------------------------------------------------------------------------
+// Torus around the z axis with exact normals, colors and texture
+// coordinates, its grid wrapping around in both directions.
+vesGeometryData::Ptr CreateTorus(int segments, int rings)
+{
+  vesSourceDataP3N3f::Ptr vertices(new vesSourceDataP3N3f());
+  vesSourceDataC3f::Ptr colors(new vesSourceDataC3f());
+  vesSourceDataT2f::Ptr textureCoordinates(new vesSourceDataT2f());
+  for (int i = 0; i < segments; ++i) {
+    const float u = 2.0f * pi * i / segments;
+    for (int j = 0; j < rings; ++j) {
+      const float v = 2.0f * pi * j / rings;
+      vesVertexDataP3N3f vertex;
+      vertex.m_normal = vesVector3f(cos(v) * cos(u), cos(v) * sin(u), sin(v));
+      vertex.m_position = vesVector3f(radius * cos(u), radius * sin(u), 0.5f)
+        + tubeRadius * vertex.m_normal;
+      vertices->pushBack(vertex);
+
+      vesVertexDataC3f color;
+      color.m_color = vesVector3f(static_cast<float>(i) / segments,
+                                  static_cast<float>(j) / rings, 0.5f);
+      colors->pushBack(color);
+
+      vesVertexDataT2f textureCoordinate;
+      textureCoordinate.m_textureCoordinate = vesVector2f(
+        static_cast<float>(i) / segments, static_cast<float>(j) / rings);
+      textureCoordinates->pushBack(textureCoordinate);
+    }
+  }
+
+  vesPrimitive::Ptr triangles(new vesPrimitive());
+  for (int i = 0; i < segments; ++i) {
+    for (int j = 0; j < rings; ++j) {
+      const unsigned short a = i * rings + j;
+      const unsigned short b = ((i + 1) % segments) * rings + j;
+      const unsigned short c = ((i + 1) % segments) * rings + (j + 1) % rings;
+      const unsigned short d = i * rings + (j + 1) % rings;
+      triangles->pushBackIndices(a, b, c);
+      triangles->pushBackIndices(a, c, d);
+    }
+  }
+  triangles->setPrimitiveType(vesPrimitiveRenderType::Triangles);
+  triangles->setIndexCount(3);
+
+  vesGeometryData::Ptr geometryData(new vesGeometryData());
+  geometryData->setName("Torus");
+  geometryData->addSource(vertices);
+  geometryData->addSource(colors);
+  geometryData->addSource(textureCoordinates);
+  geometryData->addPrimitive(triangles);
+  return geometryData;
+}
+
+//----------------------------------------------------------------------------
+// Components of the attribute \p key of \p vertex, whichever source holds it.
+vesVector3f Attribute(vesGeometryData::Ptr geometryData, int key, unsigned int vertex)
+{
+  vesSourceData::Ptr source = geometryData->sourceData(key);
+  const float* values = reinterpret_cast<const float*>(
+    static_cast<const char*>(source->data()) + vertex * source->sizeOfElement()
+    + source->attributeOffset(key));
+  vesVector3f value(0.0f, 0.0f, 0.0f);
+  for (unsigned int i = 0; i < std::min(3u, source->numberOfComponents(key)); ++i) {
+    value[i] = values[i];
+  }
+  return value;
+}
+
+//----------------------------------------------------------------------------
+float AngleInDegrees(const vesVector3f& a, const vesVector3f& b)
+{
+  const float cosine = a.dot(b) / (a.norm() * b.norm());
+  return acos(std::min(1.0f, std::max(-1.0f, cosine))) * 180.0f / pi;
+}
+
+//----------------------------------------------------------------------------
+float MaximumDifference(const vesVector3f& a, const vesVector3f& b)
+{
+  return (a - b).cwiseAbs().maxCoeff();
+}
+
+//----------------------------------------------------------------------------
+// Decoded triangles keep their order, but their corners may be rotated.
+// Return the rotation, -1 if the positions do not match within tolerance.
+int FindRotation(vesGeometryData::Ptr original, const unsigned short* originalCorners,
+                 vesGeometryData::Ptr decoded, const unsigned short* decodedCorners,
+                 float tolerance)
+{
+  for (int rotation = 0; rotation < 3; ++rotation) {
+    bool matches = true;
+    for (int k = 0; k < 3 && matches; ++k) {
+      matches = MaximumDifference(
+        Attribute(original, vesVertexAttributeKeys::Position, originalCorners[(k + rotation) % 3]),
+        Attribute(decoded, vesVertexAttributeKeys::Position, decodedCorners[k])) <= tolerance;
+    }
+    if (matches) {
+      return rotation;
+    }
+  }
+  return -1;
+}
+
+//----------------------------------------------------------------------------
+bool TestRoundTrip(int normalBits)
+{
+  std::ostringstream name;
+  name << "Round trip with " << normalBits << " normal bits: ";
+
+  vesGeometryData::Ptr original = CreateTorus(48, 24);
+  vesMeshCodec codec;
+  codec.setQuantizationBits(vesVertexAttributeKeys::Normal, normalBits);
+  std::vector<unsigned char> encoded;
+  if (!Check(codec.encode(*original, encoded), name.str() + codec.errorMessage())) {
+    return false;
+  }
+  vesGeometryData::Ptr decoded = codec.decode(&encoded[0], encoded.size());
+  if (!Check(decoded, name.str() + codec.errorMessage())) {
+    return false;
+  }
+
+  const unsigned int numberOfVertices =
+    original->sourceData(vesVertexAttributeKeys::Position)->sizeOfArray();
+  const vesPrimitive::Indices& originalIndices = *original->triangles()->indices();
+  bool passed = Check(decoded->sourceData(vesVertexAttributeKeys::Position)->sizeOfArray() ==
+                      numberOfVertices, name.str() + "wrong number of vertices");
+  passed &= Check(decoded->triangles() &&
+                  decoded->triangles()->indices()->size() == originalIndices.size(),
+                  name.str() + "wrong number of triangles");
+  passed &= Check(decoded->sourceData(vesVertexAttributeKeys::Normal) &&
+                  decoded->sourceData(vesVertexAttributeKeys::Color) &&
+                  decoded->sourceData(vesVertexAttributeKeys::TextureCoordinate),
+                  name.str() + "missing attributes");
+  if (!passed) {
+    return false;
+  }
+  const vesPrimitive::Indices& decodedIndices = *decoded->triangles()->indices();
+
+  // Half the position step over the largest extent, 14 bits by default.
+  const float extent = 2.0f * (radius + tubeRadius);
+  const float positionTolerance = 0.5f * extent / ((1 << 14) - 1) * 1.01f;
+  // Recomputed normals average the faces around the vertex.
+  const float normalTolerance = normalBits ? 0.25f : 1.0f;
+  const float colorTolerance = 0.5f / 255.0f * 1.01f;
+  const float textureCoordinateTolerance = 0.5f / ((1 << 12) - 1) * 1.01f;
+
+  float positionError = 0.0f;
+  float normalError = 0.0f;
+  float colorError = 0.0f;
+  float textureCoordinateError = 0.0f;
+  for (size_t i = 0; i < originalIndices.size(); i += 3) {
+    const int rotation = FindRotation(original, &originalIndices[i], decoded,
+                                      &decodedIndices[i], positionTolerance);
+    if (!Check(rotation >= 0, name.str() + "positions out of tolerance")) {
+      return false;
+    }
+    for (int k = 0; k < 3; ++k) {
+      const unsigned int a = originalIndices[i + (k + rotation) % 3];
+      const unsigned int b = decodedIndices[i + k];
+      positionError = std::max(positionError, MaximumDifference(
+        Attribute(original, vesVertexAttributeKeys::Position, a),
+        Attribute(decoded, vesVertexAttributeKeys::Position, b)));
+      normalError = std::max(normalError, AngleInDegrees(
+        Attribute(original, vesVertexAttributeKeys::Normal, a),
+        Attribute(decoded, vesVertexAttributeKeys::Normal, b)));
+      colorError = std::max(colorError, MaximumDifference(
+        Attribute(original, vesVertexAttributeKeys::Color, a),
+        Attribute(decoded, vesVertexAttributeKeys::Color, b)));
+      textureCoordinateError = std::max(textureCoordinateError, MaximumDifference(
+        Attribute(original, vesVertexAttributeKeys::TextureCoordinate, a),
+        Attribute(decoded, vesVertexAttributeKeys::TextureCoordinate, b)));
+    }
+  }
+
+  std::cout << name.str() << encoded.size() << " bytes, position error "
+            << positionError << ", normal error " << normalError << " degrees"
+            << std::endl;
+  passed &= Check(positionError <= positionTolerance, name.str() + "positions out of tolerance");
+  passed &= Check(normalError <= normalTolerance, name.str() + "normals out of tolerance");
+  passed &= Check(colorError <= colorTolerance, name.str() + "colors out of tolerance");
+  passed &= Check(textureCoordinateError <= textureCoordinateTolerance,
+                  name.str() + "texture coordinates out of tolerance");
+  return passed;
+}
+
+//----------------------------------------------------------------------------
+bool ExpectFailure(vesMeshCodec& codec, const std::vector<unsigned char>& data,
+                   const std::string& message)
+{
+  // A copy of exactly the given size, for memory checkers to catch reads
+  // past its end.
+  unsigned char* copy = new unsigned char[std::max(data.size(), size_t(1))];
+  std::copy(data.begin(), data.end(), copy);
+  const bool decoded = codec.decode(copy, data.size());
+  delete [] copy;
+  return Check(!decoded && !codec.errorMessage().empty(), message);
+}
+
+//----------------------------------------------------------------------------
+// Replace the CRC-32 closing \p data with that of the bytes before it.
+void Seal(std::vector<unsigned char>& data)
+{
+  unsigned int crc = 0xFFFFFFFFu;
+  for (size_t i = 0; i + 4 < data.size(); ++i) {
+    crc ^= data[i];
+    for (int j = 0; j < 8; ++j) {
+      crc = (crc & 1) ? 0xEDB88320u ^ (crc >> 1) : crc >> 1;
+    }
+  }
+  crc = ~crc;
+  for (int i = 0; i < 4; ++i) {
+    data[data.size() - 4 + i] = static_cast<unsigned char>(crc >> (8 * i));
+  }
+}
+
+//----------------------------------------------------------------------------
+// Data corrupted behind the checksum's back may still decode, but only into
+// a mesh whose indices refer to its vertices.
+bool ExpectValidOrFailure(vesMeshCodec& codec, const std::vector<unsigned char>& data,
+                          const std::string& message)
+{
+  vesGeometryData::Ptr decoded = codec.decode(&data[0], data.size());
+  if (!decoded) {
+    return Check(!codec.errorMessage().empty(), message + " without an error");
+  }
+  const unsigned int numberOfVertices =
+    decoded->sourceData(vesVertexAttributeKeys::Position)->sizeOfArray();
+  for (unsigned int i = 0; i < decoded->numberOfPrimitiveTypes(); ++i) {
+    const vesPrimitive::Indices& indices = *decoded->primitive(i)->indices();
+    for (size_t j = 0; j < indices.size(); ++j) {
+      if (!Check(indices[j] < numberOfVertices, message + " into missing vertices")) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool TestCorruptData()
+{
+  vesGeometryData::Ptr original = CreateTorus(12, 6);
+  vesMeshCodec codec;
+  std::vector<unsigned char> encoded;
+  if (!Check(codec.encode(*original, encoded), codec.errorMessage())) {
+    return false;
+  }
+
+  bool passed = true;
+  for (size_t size = 0; size < encoded.size() && passed; ++size) {
+    std::ostringstream message;
+    message << "Decoded the first " << size << " of " << encoded.size() << " bytes";
+    passed = ExpectFailure(codec, std::vector<unsigned char>(
+      encoded.begin(), encoded.begin() + size), message.str());
+  }
+
+  std::vector<unsigned char> flipped = encoded;
+  for (size_t bit = 0; bit < 8 * encoded.size() && passed; ++bit) {
+    flipped[bit / 8] ^= 1 << (bit % 8);
+    std::ostringstream message;
+    message << "Decoded data with bit " << bit << " flipped";
+    passed = ExpectFailure(codec, flipped, message.str());
+    flipped[bit / 8] ^= 1 << (bit % 8);
+  }
+
+  passed = passed && Check(codec.decode(&flipped[0], flipped.size()),
+                           "Restored data does not decode");
+
+  // The same with valid checksums, for the checks of the decoder itself.
+  for (size_t bit = 0; bit < 8 * (encoded.size() - 4) && passed; ++bit) {
+    flipped[bit / 8] ^= 1 << (bit % 8);
+    Seal(flipped);
+    std::ostringstream message;
+    message << "Decoded sealed data with bit " << bit << " flipped";
+    passed = ExpectValidOrFailure(codec, flipped, message.str());
+    flipped[bit / 8] ^= 1 << (bit % 8);
+  }
+  return passed;
+}
+
+}; // end namespace
+//----------------------------------------------------------------------------
+
+
+int
+main(int argc, char *argv[])
+{
+  vesNotUsed(argc);
+  vesNotUsed(argv);
+
+  bool passed = TestRoundTrip(10);
+  passed &= TestRoundTrip(0);
+  passed &= TestCorruptData();
+
+  std::cout << (passed ? "Passed" : "Failed") << std::endl;
+  return passed ? 0 : 1;
+}
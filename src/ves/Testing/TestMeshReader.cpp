@@ -0,0 +1,457 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+
+// Reads STL, PLY and OBJ fixtures with vesMeshReader and checks the sources
+// and triangles they come out as. The text fixtures live in the Data
+// directory next to this file; binary files, and text files large enough to
+// span several parsing chunks, are written into the output directory first.
+// Every file is read on several numbers of threads, which must not change
+// the result, and corrupt files must be rejected with an error.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <vesGeometryData.h>
+#include <vesMeshReader.h>
+#include <vesPrimitive.h>
+#include <vesSourceData.h>
+#include <vesVertexAttributeKeys.h>
+
+//----------------------------------------------------------------------------
+namespace {
+
+std::string dataDirectory;
+std::string outputDirectory;
+
+// Square of the STL and PLY files, two triangles fanned from the origin.
+const float squarePositions[4][3] = {
+  {0, 0, 0}, {1, 0, 0}, {1, 1, 0}, {0, 1, 0} };
+const unsigned char squareColors[4][3] = {
+  {255, 0, 0}, {0, 255, 0}, {0, 0, 255}, {255, 255, 255} };
+const float squareTextureCoordinates[4][2] = {
+  {0, 0}, {1, 0}, {1, 1}, {0, 1} };
+const unsigned short squareTriangles[6] = { 0, 1, 2, 0, 2, 3 };
+
+//----------------------------------------------------------------------------
+bool Check(bool condition, const std::string& fileName, const std::string& message)
+{
+  if (!condition) {
+    std::cout << fileName << ": " << message << std::endl;
+  }
+  return condition;
+}
+
+//----------------------------------------------------------------------------
+// Component of the attribute \p key of \p vertex, whichever source holds it.
+float Attribute(vesGeometryData::Ptr geometryData, int key, unsigned int vertex,
+                int component)
+{
+  vesSourceData::Ptr source = geometryData->sourceData(key);
+  const char* element = static_cast<const char*>(source->data())
+    + vertex * source->sizeOfElement() + source->attributeOffset(key);
+  float value;
+  memcpy(&value, element + component * sizeof(float), sizeof(float));
+  return value;
+}
+
+//----------------------------------------------------------------------------
+unsigned int NumberOfVertices(vesGeometryData::Ptr geometryData)
+{
+  return geometryData->sourceData(vesVertexAttributeKeys::Position)->sizeOfArray();
+}
+
+//----------------------------------------------------------------------------
+// Bytes of every source and the indices of every primitive.
+std::string Contents(vesGeometryData::Ptr geometryData)
+{
+  std::string contents;
+  for (unsigned int i = 0; i < geometryData->numberOfSources(); ++i) {
+    vesSourceData::Ptr source = geometryData->source(i);
+    contents.append(static_cast<const char*>(source->data()), source->sizeInBytes());
+  }
+  for (unsigned int i = 0; i < geometryData->numberOfPrimitiveTypes(); ++i) {
+    const vesPrimitive::Indices& indices = *geometryData->primitive(i)->indices();
+    if (!indices.empty()) {
+      contents.append(reinterpret_cast<const char*>(&indices[0]),
+                      indices.size() * sizeof(indices[0]));
+    }
+  }
+  return contents;
+}
+
+//----------------------------------------------------------------------------
+// Read \p fileName on one thread and check that more threads read the same.
+vesGeometryData::Ptr Read(const std::string& fileName)
+{
+  vesMeshReader reader;
+  reader.setNumberOfThreads(1);
+  vesGeometryData::Ptr geometryData = reader.read(fileName);
+  if (!geometryData) {
+    std::cout << fileName << ": " << reader.errorMessage() << std::endl;
+    return geometryData;
+  }
+
+  const std::string contents = Contents(geometryData);
+  const int numberOfThreads[] = { 2, 3, 8, 0 };
+  for (size_t i = 0; i < sizeof(numberOfThreads) / sizeof(numberOfThreads[0]); ++i) {
+    reader.setNumberOfThreads(numberOfThreads[i]);
+    vesGeometryData::Ptr other = reader.read(fileName);
+    std::ostringstream message;
+    message << "reads differently on " << numberOfThreads[i] << " threads";
+    if (!Check(other && Contents(other) == contents, fileName, message.str())) {
+      return vesGeometryData::Ptr();
+    }
+  }
+  return geometryData;
+}
+
+//----------------------------------------------------------------------------
+bool CheckTriangles(vesGeometryData::Ptr geometryData, const std::string& fileName,
+                    const unsigned short* triangles, size_t numberOfIndices)
+{
+  vesPrimitive::Ptr primitive = geometryData->triangles();
+  return Check(primitive && primitive->indices()->size() == numberOfIndices &&
+               std::equal(triangles, triangles + numberOfIndices,
+                          primitive->indices()->begin()),
+               fileName, "wrong triangles");
+}
+
+//----------------------------------------------------------------------------
+bool CheckSquare(vesGeometryData::Ptr geometryData, const std::string& fileName,
+                 bool hasColors)
+{
+  if (!geometryData) {
+    return false;
+  }
+
+  bool passed = Check(NumberOfVertices(geometryData) == 4, fileName, "expected 4 vertices");
+  passed &= CheckTriangles(geometryData, fileName, squareTriangles, 6);
+  if (!passed) {
+    return false;
+  }
+
+  for (unsigned int i = 0; i < 4; ++i) {
+    for (int j = 0; j < 3; ++j) {
+      passed &= Check(Attribute(geometryData, vesVertexAttributeKeys::Position, i, j) ==
+                      squarePositions[i][j], fileName, "wrong position");
+    }
+    // Normals are not in the files and computed.
+    passed &= Check(Attribute(geometryData, vesVertexAttributeKeys::Normal, i, 2) > 0.99f,
+                    fileName, "wrong normal");
+  }
+
+  const bool colors = geometryData->sourceData(vesVertexAttributeKeys::Color);
+  const bool textureCoordinates =
+    geometryData->sourceData(vesVertexAttributeKeys::TextureCoordinate);
+  passed &= Check(colors == hasColors, fileName, "unexpected colors");
+  passed &= Check(textureCoordinates == hasColors, fileName,
+                  "unexpected texture coordinates");
+  if (!passed || !hasColors) {
+    return passed;
+  }
+
+  for (unsigned int i = 0; i < 4; ++i) {
+    for (int j = 0; j < 3; ++j) {
+      passed &= Check(Attribute(geometryData, vesVertexAttributeKeys::Color, i, j) ==
+                      squareColors[i][j] / 255.0f, fileName, "wrong color");
+    }
+    for (int j = 0; j < 2; ++j) {
+      passed &= Check(Attribute(geometryData, vesVertexAttributeKeys::TextureCoordinate, i, j) ==
+                      squareTextureCoordinates[i][j], fileName, "wrong texture coordinate");
+    }
+  }
+  return passed;
+}
+
+//----------------------------------------------------------------------------
+// Append \p value to \p bytes, most significant byte first if \p bigEndian.
+template <typename T>
+void Write(std::string& bytes, T value, bool bigEndian)
+{
+  unsigned char buffer[sizeof(T)];
+  memcpy(buffer, &value, sizeof(T));
+  const unsigned short one = 1;
+  const bool littleEndianHost = *reinterpret_cast<const unsigned char*>(&one) == 1;
+  if (bigEndian == littleEndianHost) {
+    std::reverse(buffer, buffer + sizeof(T));
+  }
+  bytes.append(reinterpret_cast<const char*>(buffer), sizeof(T));
+}
+
+//----------------------------------------------------------------------------
+std::string WriteFile(const std::string& name, const std::string& contents)
+{
+  const std::string fileName = outputDirectory + "/" + name;
+  std::ofstream file(fileName.c_str(), std::ios::binary);
+  file << contents;
+  return fileName;
+}
+
+//----------------------------------------------------------------------------
+// Binary STL whose header starts with "solid" like that of an ASCII file.
+std::string BinarySquareSTL()
+{
+  std::string bytes("solid binary square");
+  bytes.resize(80, ' ');
+  Write<unsigned int>(bytes, 2, false);
+  for (int i = 0; i < 2; ++i) {
+    const float normal[3] = { 0, 0, 1 };
+    for (int j = 0; j < 3; ++j) {
+      Write(bytes, normal[j], false);
+    }
+    for (int j = 0; j < 3; ++j) {
+      for (int k = 0; k < 3; ++k) {
+        Write(bytes, squarePositions[squareTriangles[3 * i + j]][k], false);
+      }
+    }
+    Write<unsigned short>(bytes, 0, false);
+  }
+  return bytes;
+}
+
+//----------------------------------------------------------------------------
+std::string BinarySquarePLY(bool bigEndian)
+{
+  std::string bytes = std::string("ply\nformat ") +
+    (bigEndian ? "binary_big_endian" : "binary_little_endian") + " 1.0\n"
+    "element vertex 4\n"
+    "property float x\nproperty float y\nproperty float z\n"
+    "property uchar red\nproperty uchar green\nproperty uchar blue\n"
+    "property float u\nproperty float v\n"
+    "element face 1\n"
+    "property list uchar int vertex_indices\n"
+    "end_header\n";
+  for (int i = 0; i < 4; ++i) {
+    for (int j = 0; j < 3; ++j) {
+      Write(bytes, squarePositions[i][j], bigEndian);
+    }
+    for (int j = 0; j < 3; ++j) {
+      Write(bytes, squareColors[i][j], bigEndian);
+    }
+    for (int j = 0; j < 2; ++j) {
+      Write(bytes, squareTextureCoordinates[i][j], bigEndian);
+    }
+  }
+  Write<unsigned char>(bytes, 4, bigEndian);
+  for (int i = 0; i < 4; ++i) {
+    Write<int>(bytes, i, bigEndian);
+  }
+  return bytes;
+}
+
+//----------------------------------------------------------------------------
+// Strip of quads, each given by four new vertices and texture coordinates
+// and one normal. Every face refers to the items of the quad before it, so
+// that relative indices reach back over the chunk boundaries.
+std::string QuadStripOBJ(int numberOfQuads, bool relative)
+{
+  std::ostringstream obj;
+  for (int i = 0; i <= numberOfQuads; ++i) {
+    obj << "v " << i << " 0 0\nv " << i + 1 << " 0 0\nv " << i + 1 << " 1 0\nv "
+        << i << " 1 0\n";
+    obj << "vt 0 0\nvt 1 0\nvt 1 1\nvt 0 1\n";
+    obj << "vn 0 0 " << (i % 2 ? 1 : -1) << "\n";
+    if (i == 0) {
+      continue;
+    }
+    obj << "f";
+    for (int j = 0; j < 4; ++j) {
+      if (relative) {
+        obj << " " << j - 8 << "/" << j - 8 << "/-2";
+      }
+      else {
+        const int item = 4 * (i - 1) + j + 1;
+        obj << " " << item << "/" << item << "/" << i;
+      }
+    }
+    obj << "\n";
+  }
+  return obj.str();
+}
+
+//----------------------------------------------------------------------------
+bool TestSTL()
+{
+  const std::string ascii = dataDirectory + "/square_ascii.stl";
+  const std::string binary = WriteFile("square_binary.stl", BinarySquareSTL());
+
+  vesGeometryData::Ptr asciiData = Read(ascii);
+  vesGeometryData::Ptr binaryData = Read(binary);
+  bool passed = CheckSquare(asciiData, ascii, false);
+  passed &= CheckSquare(binaryData, binary, false);
+  return passed && Check(Contents(asciiData) == Contents(binaryData), binary,
+                         "reads differently from the ASCII file");
+}
+
+//----------------------------------------------------------------------------
+bool TestPLY()
+{
+  const std::string ascii = dataDirectory + "/square_ascii.ply";
+  vesGeometryData::Ptr asciiData = Read(ascii);
+  bool passed = CheckSquare(asciiData, ascii, true);
+
+  for (int bigEndian = 0; bigEndian < 2; ++bigEndian) {
+    const std::string binary = WriteFile(
+      bigEndian ? "square_big_endian.ply" : "square_little_endian.ply",
+      BinarySquarePLY(bigEndian));
+    vesGeometryData::Ptr binaryData = Read(binary);
+    passed &= CheckSquare(binaryData, binary, true);
+    passed &= binaryData && asciiData &&
+      Check(Contents(binaryData) == Contents(asciiData), binary,
+            "reads differently from the ASCII file");
+  }
+  return passed;
+}
+
+//----------------------------------------------------------------------------
+bool TestOBJ()
+{
+  // Large enough to be cut into several chunks on any number of threads.
+  const int numberOfQuads = 4000;
+  const std::string relative = WriteFile("quad_strip_relative.obj",
+                                         QuadStripOBJ(numberOfQuads, true));
+  const std::string absolute = WriteFile("quad_strip_absolute.obj",
+                                         QuadStripOBJ(numberOfQuads, false));
+
+  vesGeometryData::Ptr relativeData = Read(relative);
+  vesGeometryData::Ptr absoluteData = Read(absolute);
+  if (!relativeData || !absoluteData) {
+    return false;
+  }
+  bool passed = Check(Contents(relativeData) == Contents(absoluteData), relative,
+                      "reads differently from absolute indices");
+
+  // Quads only share positions with their neighbors, which they do not
+  // share normals with.
+  passed &= Check(NumberOfVertices(relativeData) == 4u * numberOfQuads, relative,
+                  "wrong number of vertices");
+  passed &= Check(relativeData->triangles()->indices()->size() == 6u * numberOfQuads,
+                  relative, "wrong number of triangles");
+  for (int i = 0; i < numberOfQuads && passed; i += 997) {
+    const unsigned int vertex = 4 * i + 1;
+    passed &= Check(Attribute(relativeData, vesVertexAttributeKeys::Position, vertex, 0) == i + 1,
+                    relative, "wrong position");
+    passed &= Check(Attribute(relativeData, vesVertexAttributeKeys::Normal, vertex, 2) ==
+                    (i % 2 ? 1.0f : -1.0f), relative, "wrong normal");
+  }
+
+  // Corners sharing a position but not their other attributes.
+  const std::string welded = dataDirectory + "/welded.obj";
+  vesGeometryData::Ptr weldedData = Read(welded);
+  if (!weldedData) {
+    return false;
+  }
+  const unsigned short weldedTriangles[9] = { 0, 1, 2, 0, 2, 3, 4, 5, 6 };
+  passed &= Check(NumberOfVertices(weldedData) == 7, welded, "expected 7 vertices");
+  passed &= CheckTriangles(weldedData, welded, weldedTriangles, 9);
+  if (passed) {
+    const float expected[7][6] = {
+      {0, 0, 0, 0, 0, 1}, {1, 0, 1, 0, 0, 1}, {1, 1, 1, 1, 0, 1}, {0, 1, 0, 1, 0, 1},
+      {0, 0, 0.5f, 0.5f, 0, -1}, {1, 1, 1, 1, 0, -1}, {1, 0, 1, 0, 0, -1} };
+    for (unsigned int i = 0; i < 7; ++i) {
+      passed &= Check(
+        Attribute(weldedData, vesVertexAttributeKeys::Position, i, 0) == expected[i][0] &&
+        Attribute(weldedData, vesVertexAttributeKeys::Position, i, 1) == expected[i][1] &&
+        Attribute(weldedData, vesVertexAttributeKeys::TextureCoordinate, i, 0) == expected[i][2] &&
+        Attribute(weldedData, vesVertexAttributeKeys::TextureCoordinate, i, 1) == expected[i][3] &&
+        Attribute(weldedData, vesVertexAttributeKeys::Normal, i, 2) == expected[i][5],
+        welded, "wrong vertex");
+    }
+  }
+  return passed;
+}
+
+//----------------------------------------------------------------------------
+bool ExpectFailure(const std::string& fileName, const std::string& errorMessage)
+{
+  vesMeshReader reader;
+  const int numberOfThreads[] = { 1, 4 };
+  for (int i = 0; i < 2; ++i) {
+    reader.setNumberOfThreads(numberOfThreads[i]);
+    if (!Check(!reader.read(fileName), fileName, "read a corrupt file") ||
+        !Check(reader.errorMessage() == errorMessage, fileName,
+               "unexpected error '" + reader.errorMessage() + "'")) {
+      return false;
+    }
+  }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool TestCorruptFiles()
+{
+  bool passed = ExpectFailure(dataDirectory + "/truncated_ascii.stl",
+                              "Invalid vertex in STL file");
+  passed &= ExpectFailure(dataDirectory + "/truncated_ascii.ply", "PLY file is truncated");
+  passed &= ExpectFailure(dataDirectory + "/missing_vertex.ply", "Invalid PLY element");
+  passed &= ExpectFailure(dataDirectory + "/missing_texture_coordinate.obj",
+                          "OBJ face refers to a missing vertex");
+  passed &= ExpectFailure(dataDirectory + "/missing_normal.obj",
+                          "OBJ face refers to a missing vertex");
+  passed &= ExpectFailure(WriteFile("empty.stl", ""),
+                          "Cannot open " + outputDirectory + "/empty.stl");
+
+  // Binary files cut short, the STL one no longer matching its triangle
+  // count and passing for an ASCII file without facets.
+  const std::string stl = BinarySquareSTL();
+  passed &= ExpectFailure(WriteFile("truncated_binary.stl", stl.substr(0, stl.size() - 10)),
+                          "STL file without facets");
+  const std::string ply = BinarySquarePLY(false);
+  passed &= ExpectFailure(WriteFile("truncated_vertices.ply", ply.substr(0, ply.size() - 40)),
+                          "PLY file is truncated");
+  passed &= ExpectFailure(WriteFile("truncated_faces.ply", ply.substr(0, ply.size() - 2)),
+                          "PLY file is truncated");
+
+  // A face index flipped to point past the vertices.
+  std::string flipped = ply;
+  flipped[flipped.size() - 4] = 0x7f;
+  passed &= ExpectFailure(WriteFile("missing_vertex_binary.ply", flipped),
+                          "Invalid PLY face");
+  return passed;
+}
+
+}; // end namespace
+//----------------------------------------------------------------------------
+
+
+int
+main(int argc, char *argv[])
+{
+  if (argc < 3) {
+    printf("Usage: %s <path to test data> <output directory>\n", argv[0]);
+    return -1;
+  }
+  dataDirectory = argv[1];
+  outputDirectory = argv[2];
+
+  bool passed = TestSTL();
+  passed &= TestPLY();
+  passed &= TestOBJ();
+  passed &= TestCorruptFiles();
+
+  std::cout << (passed ? "Passed" : "Failed") << std::endl;
+  return passed ? 0 : 1;
+}
@@ -0,0 +1,244 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+
+// Queues a scene command from another thread and checks that the rendering
+// thread applies it and draws its result, with and without pipelining. A
+// pipelined renderer draws the frame culled by the previous render(), so
+// there the new actor shows up one render() later, isRenderNeeded() must
+// stay true until it does, and picking must already see it.
+
+#include <cstdio>
+#include <iostream>
+
+#include <vesActor.h>
+#include <vesCamera.h>
+#include <vesGeometryData.h>
+#include <vesMapper.h>
+#include <vesMaterial.h>
+#include <vesRenderer.h>
+#include <vesSceneCommand.h>
+#include <vesShaderProgram.h>
+#include <vesThread.h>
+#include <vesVertexAttributeKeys.h>
+
+#include <pthread.h>
+
+#include <GLES2/gl2.h>
+
+#include "vesHeadlessTesting.h"
+
+//----------------------------------------------------------------------------
+namespace {
+
+const int viewWidth = 64;
+const int viewHeight = 64;
+
+//----------------------------------------------------------------------------
+// A square of side 2 * halfSize at height z, facing the camera.
+vesActor::Ptr CreateSquare(vesShaderProgram::Ptr shaderProgram, float halfSize,
+                           float z, const vesVector3f& color)
+{
+  vesSourceDataP3N3C3f::Ptr sourceData(new vesSourceDataP3N3C3f());
+  const float corners[4][2] = { {-1, -1}, {1, -1}, {1, 1}, {-1, 1} };
+  for (int i = 0; i < 4; ++i) {
+    vesVertexDataP3N3C3f vertex;
+    vertex.m_position = vesVector3f(halfSize * corners[i][0], halfSize * corners[i][1], z);
+    vertex.m_normal = vesVector3f(0.0f, 0.0f, 1.0f);
+    vertex.m_color = color;
+    sourceData->pushBack(vertex);
+  }
+
+  vesPrimitive::Ptr triangles(new vesPrimitive());
+  triangles->pushBackIndices(0, 1, 2);
+  triangles->pushBackIndices(0, 2, 3);
+  triangles->setPrimitiveType(vesPrimitiveRenderType::Triangles);
+  triangles->setIndexCount(3);
+
+  vesGeometryData::Ptr geometryData(new vesGeometryData());
+  geometryData->addSource(sourceData);
+  geometryData->addPrimitive(triangles);
+
+  vesMapper::Ptr mapper(new vesMapper());
+  mapper->setGeometryData(geometryData);
+  vesMaterial::Ptr material(new vesMaterial());
+  material->addAttribute(shaderProgram);
+
+  vesActor::Ptr actor(new vesActor());
+  actor->setMapper(mapper);
+  actor->setMaterial(material);
+  return actor;
+}
+
+//----------------------------------------------------------------------------
+class vesAddActorCommand : public vesSceneCommand
+{
+public:
+
+  explicit vesAddActorCommand(vesActor::Ptr actor) :
+    m_actor(actor), m_executed(false)
+  {
+  }
+
+  virtual void execute(vesRenderer &renderer)
+  {
+    this->m_executed = true;
+    this->m_thread = pthread_self();
+    renderer.addActor(this->m_actor);
+  }
+
+  vesActor::Ptr m_actor;
+  bool m_executed;
+  pthread_t m_thread;
+};
+
+//----------------------------------------------------------------------------
+class vesEnqueueThread : public vesThread
+{
+public:
+
+  vesEnqueueThread(vesRenderer::Ptr renderer, vesSceneCommand::Ptr command) :
+    m_renderer(renderer), m_command(command)
+  {
+  }
+
+  ~vesEnqueueThread()
+  {
+    this->join();
+  }
+
+protected:
+
+  virtual void run()
+  {
+    this->m_renderer->enqueueSceneCommand(this->m_command);
+  }
+
+  vesRenderer::Ptr m_renderer;
+  vesSceneCommand::Ptr m_command;
+};
+
+//----------------------------------------------------------------------------
+bool CenterIsGreen()
+{
+  unsigned char pixel[4];
+  glReadPixels(viewWidth / 2, viewHeight / 2, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, pixel);
+  return pixel[0] < 64 && pixel[1] > 192;
+}
+
+//----------------------------------------------------------------------------
+bool Check(bool condition, const char* message, bool pipelined)
+{
+  if (!condition) {
+    std::cout << (pipelined ? "Pipelined: " : "Serial: ") << message << std::endl;
+  }
+  return condition;
+}
+
+//----------------------------------------------------------------------------
+bool TestSceneCommand(bool pipelined)
+{
+  vesShaderProgram::Ptr shaderProgram = CreateVertexColorShaderProgram();
+  vesRenderer::Ptr renderer(new vesRenderer());
+  renderer->resize(viewWidth, viewHeight, 1.0f);
+  renderer->setPipelined(pipelined);
+  if (!Check(renderer->pipelined() == pipelined, "could not switch pipelining", pipelined)) {
+    return false;
+  }
+
+  renderer->addActor(CreateSquare(shaderProgram, 1.0f, 0.0f, vesVector3f(1.0f, 0.0f, 0.0f)));
+  renderer->resetCamera();
+
+  for (int i = 0; i < 3 && renderer->isRenderNeeded(); ++i) {
+    renderer->render();
+  }
+  bool passed = Check(!renderer->isRenderNeeded(), "the scene did not settle", pipelined);
+
+  // The background is drawn too, count relative to the first actor.
+  const unsigned int drawCalls = renderer->statistics().m_drawCalls;
+  const unsigned int renderLeaves = renderer->statistics().m_renderLeaves;
+
+  vesSharedPtr<vesAddActorCommand> command(
+    new vesAddActorCommand(CreateSquare(shaderProgram, 0.5f, 0.1f,
+                                        vesVector3f(0.0f, 1.0f, 0.0f))));
+  {
+    vesEnqueueThread thread(renderer, command);
+    if (!Check(thread.start(), "could not start the enqueueing thread", pipelined)) {
+      return false;
+    }
+  }
+  passed &= Check(!command->m_executed, "the command ran before render()", pipelined);
+  passed &= Check(renderer->isRenderNeeded(), "the queued command needs no render", pipelined);
+
+  renderer->render();
+  passed &= Check(command->m_executed, "render() did not run the command", pipelined);
+  passed &= Check(command->m_executed && pthread_equal(command->m_thread, pthread_self()),
+                  "the command did not run on the rendering thread", pipelined);
+
+  if (pipelined) {
+    // Drawn from the frame culled before the command ran.
+    passed &= Check(renderer->statistics().m_drawCalls == drawCalls,
+                    "the first frame after the command drew it", pipelined);
+    passed &= Check(!CenterIsGreen(), "the first frame after the command shows it", pipelined);
+    passed &= Check(renderer->isRenderNeeded(),
+                    "isRenderNeeded() is false before the command is drawn", pipelined);
+    renderer->render();
+  }
+
+  passed &= Check(renderer->statistics().m_renderLeaves == renderLeaves + 1,
+                  "the new actor is not culled", pipelined);
+  passed &= Check(renderer->statistics().m_drawCalls == drawCalls + 1,
+                  "the new actor is not drawn", pipelined);
+  passed &= Check(CenterIsGreen(), "the new actor is not visible", pipelined);
+  passed &= Check(!renderer->isRenderNeeded(), "the scene did not settle again", pipelined);
+
+  passed &= Check(renderer->pickActor(viewWidth / 2, viewHeight / 2) == command->m_actor,
+                  "picking misses the new actor", pipelined);
+
+  // Picking must not disturb the frame culled ahead.
+  renderer->requestRender();
+  renderer->render();
+  passed &= Check(renderer->statistics().m_drawCalls == drawCalls + 1,
+                  "the frame after picking lost actors", pipelined);
+  passed &= Check(CenterIsGreen(), "the frame after picking is wrong", pipelined);
+
+  return passed;
+}
+
+}; // end namespace
+//----------------------------------------------------------------------------
+
+
+int
+main(int argc, char *argv[])
+{
+  vesNotUsed(argc);
+  vesNotUsed(argv);
+
+  vesHeadlessContext context;
+  if (!context.initialize(viewWidth, viewHeight)) {
+    return -1;
+  }
+
+  bool passed = TestSceneCommand(false);
+  passed &= TestSceneCommand(true);
+
+  std::cout << (passed ? "Passed" : "Failed") << std::endl;
+  return passed ? 0 : 1;
+}
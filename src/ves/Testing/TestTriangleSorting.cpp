@@ -0,0 +1,164 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+
+// Turns the camera around a stack of triangles sorted on the worker thread
+// of a vesTriangleSorter and checks that the order it publishes keeps
+// isRenderNeeded() true until a render() draws it, without the worker
+// touching the modification count, and that the scene settles afterwards.
+
+#include <iostream>
+
+#include <vesActor.h>
+#include <vesCamera.h>
+#include <vesGeometryData.h>
+#include <vesMapper.h>
+#include <vesMaterial.h>
+#include <vesObject.h>
+#include <vesRenderer.h>
+#include <vesShaderProgram.h>
+#include <vesTriangleSorter.h>
+#include <vesVertexAttributeKeys.h>
+
+#include <unistd.h>
+
+#include "vesHeadlessTesting.h"
+
+//----------------------------------------------------------------------------
+namespace {
+
+const int viewWidth = 64;
+const int viewHeight = 64;
+const int numberOfLayers = 16;
+
+//----------------------------------------------------------------------------
+// Squares stacked along z, one behind the other.
+vesActor::Ptr CreateStack(vesShaderProgram::Ptr shaderProgram)
+{
+  vesSourceDataP3N3C3f::Ptr sourceData(new vesSourceDataP3N3C3f());
+  vesPrimitive::Ptr triangles(new vesPrimitive());
+  triangles->setPrimitiveType(vesPrimitiveRenderType::Triangles);
+  triangles->setIndexCount(3);
+
+  const float corners[4][2] = { {-1, -1}, {1, -1}, {1, 1}, {-1, 1} };
+  for (int layer = 0; layer < numberOfLayers; ++layer) {
+    for (int i = 0; i < 4; ++i) {
+      vesVertexDataP3N3C3f vertex;
+      vertex.m_position = vesVector3f(corners[i][0], corners[i][1], 0.1f * layer);
+      vertex.m_normal = vesVector3f(0.0f, 0.0f, 1.0f);
+      vertex.m_color = vesVector3f(static_cast<float>(layer) / numberOfLayers, 0.5f, 0.5f);
+      sourceData->pushBack(vertex);
+    }
+    const unsigned short first = static_cast<unsigned short>(4 * layer);
+    triangles->pushBackIndices(first, first + 1, first + 2);
+    triangles->pushBackIndices(first, first + 2, first + 3);
+  }
+
+  vesGeometryData::Ptr geometryData(new vesGeometryData());
+  geometryData->addSource(sourceData);
+  geometryData->addPrimitive(triangles);
+
+  vesMapper::Ptr mapper(new vesMapper());
+  mapper->setGeometryData(geometryData);
+  mapper->setSortTriangles(true);
+  vesMaterial::Ptr material(new vesMaterial());
+  material->addAttribute(shaderProgram);
+
+  vesActor::Ptr actor(new vesActor());
+  actor->setMapper(mapper);
+  actor->setMaterial(material);
+  return actor;
+}
+
+//----------------------------------------------------------------------------
+// Wait up to two seconds for the worker to publish an order.
+bool WaitForSortedIndices(vesTriangleSorter::Ptr sorter)
+{
+  for (int i = 0; i < 200 && !sorter->hasSortedIndices(); ++i) {
+    usleep(10000);
+  }
+  return sorter->hasSortedIndices();
+}
+
+//----------------------------------------------------------------------------
+bool Check(bool condition, const char* message)
+{
+  if (!condition) {
+    std::cout << message << std::endl;
+  }
+  return condition;
+}
+
+//----------------------------------------------------------------------------
+bool TestTriangleSorting()
+{
+  vesRenderer::Ptr renderer(new vesRenderer());
+  renderer->resize(viewWidth, viewHeight, 1.0f);
+  vesActor::Ptr actor = CreateStack(CreateVertexColorShaderProgram());
+  renderer->addActor(actor);
+  renderer->resetCamera();
+
+  vesTriangleSorter::Ptr sorter = actor->mapper()->triangleSorter();
+  sorter->setUploadThreshold(0.0f);
+
+  // The first frame sets up the sorter and asks for an order, which is the
+  // one it already has.
+  for (int i = 0; i < 3 && renderer->isRenderNeeded(); ++i) {
+    renderer->render();
+  }
+  bool passed = Check(!renderer->isRenderNeeded(), "the scene did not settle");
+
+  // Looking from behind reverses the order.
+  renderer->camera()->azimuth(180.0);
+  renderer->resetCameraClippingRange();
+  renderer->render();
+  const unsigned int modificationCount = vesObject::modificationCount();
+
+  passed &= Check(WaitForSortedIndices(sorter), "no order was published for the new view");
+  passed &= Check(vesObject::modificationCount() == modificationCount,
+                  "the sorter worker marked the scene modified");
+  passed &= Check(renderer->isRenderNeeded(), "the published order needs no render");
+
+  renderer->render();
+  passed &= Check(!sorter->hasSortedIndices(), "render() did not take the published order");
+  passed &= Check(!renderer->isRenderNeeded(), "the scene did not settle again");
+
+  return passed;
+}
+
+}; // end namespace
+//----------------------------------------------------------------------------
+
+
+int
+main(int argc, char *argv[])
+{
+  vesNotUsed(argc);
+  vesNotUsed(argv);
+
+  vesHeadlessContext context;
+  if (!context.initialize(viewWidth, viewHeight)) {
+    return -1;
+  }
+
+  bool passed = TestTriangleSorting();
+
+  std::cout << (passed ? "Passed" : "Failed") << std::endl;
+  return passed ? 0 : 1;
+}
@@ -0,0 +1,195 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+
+#include "vesHeadlessTesting.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+#include <EGL/eglext.h>
+
+#include <vesModelViewUniform.h>
+#include <vesProjectionUniform.h>
+#include <vesShader.h>
+#include <vesShaderProgram.h>
+#include <vesVertexAttribute.h>
+#include <vesVertexAttributeKeys.h>
+
+//----------------------------------------------------------------------------
+namespace {
+
+//----------------------------------------------------------------------------
+EGLDisplay GetHeadlessDisplay()
+{
+#ifdef EGL_PLATFORM_SURFACELESS_MESA
+  const char* extensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+  PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+    reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(
+      eglGetProcAddress("eglGetPlatformDisplayEXT"));
+  if (extensions && strstr(extensions, "EGL_MESA_platform_surfaceless") &&
+      getPlatformDisplay) {
+    EGLDisplay display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA,
+                                            EGL_DEFAULT_DISPLAY, 0);
+    if (display != EGL_NO_DISPLAY) {
+      return display;
+    }
+  }
+#endif
+  return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+}
+
+//----------------------------------------------------------------------------
+bool FileExists(const std::string& filename)
+{
+  std::ifstream file(filename.c_str());
+  return file.good();
+}
+
+}; // end namespace
+
+//----------------------------------------------------------------------------
+vesHeadlessContext::vesHeadlessContext()
+{
+  this->Display = EGL_NO_DISPLAY;
+  this->Context = EGL_NO_CONTEXT;
+  this->Surface = EGL_NO_SURFACE;
+}
+
+//----------------------------------------------------------------------------
+vesHeadlessContext::~vesHeadlessContext()
+{
+  if (this->Display == EGL_NO_DISPLAY) {
+    return;
+  }
+
+  eglMakeCurrent(this->Display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+  if (this->Surface != EGL_NO_SURFACE) {
+    eglDestroySurface(this->Display, this->Surface);
+  }
+  if (this->Context != EGL_NO_CONTEXT) {
+    eglDestroyContext(this->Display, this->Context);
+  }
+  eglTerminate(this->Display);
+}
+
+//----------------------------------------------------------------------------
+bool vesHeadlessContext::initialize(int width, int height)
+{
+  EGLDisplay display = GetHeadlessDisplay();
+  if (display == EGL_NO_DISPLAY || !eglInitialize(display, 0, 0)) {
+    printf("Error: eglInitialize() failed\n");
+    return false;
+  }
+  this->Display = display;
+
+  static const EGLint attribs[] = {
+    EGL_RED_SIZE, 1,
+    EGL_GREEN_SIZE, 1,
+    EGL_BLUE_SIZE, 1,
+    EGL_DEPTH_SIZE, 1,
+    EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+    EGL_RENDERABLE_TYPE, EGL_OPENGL_ES2_BIT,
+    EGL_NONE
+  };
+  static const EGLint contextAttribs[] = {
+    EGL_CONTEXT_CLIENT_VERSION, 2,
+    EGL_NONE
+  };
+  const EGLint surfaceAttribs[] = {
+    EGL_WIDTH, width,
+    EGL_HEIGHT, height,
+    EGL_NONE
+  };
+
+  EGLConfig config;
+  EGLint numberOfConfigs = 0;
+  if (!eglChooseConfig(display, attribs, &config, 1, &numberOfConfigs) ||
+      numberOfConfigs < 1) {
+    printf("Error: couldn't get an EGL pbuffer config\n");
+    return false;
+  }
+
+  eglBindAPI(EGL_OPENGL_ES_API);
+  this->Context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttribs);
+  this->Surface = eglCreatePbufferSurface(display, config, surfaceAttribs);
+  if (this->Context == EGL_NO_CONTEXT || this->Surface == EGL_NO_SURFACE) {
+    printf("Error: couldn't create the EGL context or pbuffer\n");
+    return false;
+  }
+
+  return eglMakeCurrent(display, this->Surface, this->Surface, this->Context) == EGL_TRUE;
+}
+
+//----------------------------------------------------------------------------
+std::string BuiltinDatasetPath(const std::string& sourceDirectory,
+                               const std::string& filename)
+{
+  const std::string dataRoot = sourceDirectory + "/Apps/iOS/Kiwi/Kiwi/Data/";
+  const char* subdirectories[] = { "brain_atlas/", "can/" };
+  for (size_t i = 0; i < sizeof(subdirectories) / sizeof(subdirectories[0]); ++i) {
+    std::string path = dataRoot + subdirectories[i] + filename;
+    if (FileExists(path)) {
+      return path;
+    }
+  }
+  return dataRoot + filename;
+}
+
+//----------------------------------------------------------------------------
+vesShaderProgram::Ptr CreateVertexColorShaderProgram()
+{
+  const std::string vertexShaderSource =
+    "uniform highp mat4 modelViewMatrix;\n"
+    "uniform highp mat4 projectionMatrix;\n"
+    "attribute highp vec4 vertexPosition;\n"
+    "attribute mediump vec4 vertexColor;\n"
+    "varying mediump vec4 varColor;\n"
+    "void main()\n"
+    "{\n"
+    "  gl_Position = projectionMatrix * modelViewMatrix * vertexPosition;\n"
+    "  varColor = vertexColor;\n"
+    "}\n";
+
+  const std::string fragmentShaderSource =
+    "varying mediump vec4 varColor;\n"
+    "void main()\n"
+    "{\n"
+    "  gl_FragColor = varColor;\n"
+    "}\n";
+
+  vesShader::Ptr vertexShader(new vesShader(vesShader::Vertex));
+  vesShader::Ptr fragmentShader(new vesShader(vesShader::Fragment));
+  vertexShader->setShaderSource(vertexShaderSource);
+  fragmentShader->setShaderSource(fragmentShaderSource);
+
+  vesShaderProgram::Ptr shaderProgram(new vesShaderProgram());
+  shaderProgram->addShader(vertexShader);
+  shaderProgram->addShader(fragmentShader);
+  shaderProgram->addUniform(vesSharedPtr<vesModelViewUniform>(new vesModelViewUniform()));
+  shaderProgram->addUniform(vesSharedPtr<vesProjectionUniform>(new vesProjectionUniform()));
+  shaderProgram->addVertexAttribute(
+    vesSharedPtr<vesPositionVertexAttribute>(new vesPositionVertexAttribute()),
+    vesVertexAttributeKeys::Position);
+  shaderProgram->addVertexAttribute(
+    vesSharedPtr<vesColorVertexAttribute>(new vesColorVertexAttribute()),
+    vesVertexAttributeKeys::Color);
+  return shaderProgram;
+}
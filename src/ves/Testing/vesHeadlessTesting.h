@@ -0,0 +1,68 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+
+#ifndef __vesHeadlessTesting_h
+#define __vesHeadlessTesting_h
+
+#include <string>
+
+#include <EGL/egl.h>
+
+#include <vesSharedPtr.h>
+
+class vesShaderProgram;
+
+// Setup shared by the headless test and benchmark harnesses.
+
+// Offscreen EGL context. It renders into a pbuffer, preferring Mesa's
+// surfaceless platform, so it runs on a software rasterizer without a
+// display or GPU.
+class vesHeadlessContext
+{
+public:
+
+  vesHeadlessContext();
+  ~vesHeadlessContext();
+
+  // Creates a width x height pbuffer and makes it current. Prints what went
+  // wrong and returns false on failure.
+  bool initialize(int width, int height);
+
+private:
+
+  EGLDisplay Display;
+  EGLContext Context;
+  EGLSurface Surface;
+
+  vesHeadlessContext(const vesHeadlessContext&); // Not implemented
+  void operator=(const vesHeadlessContext&);     // Not implemented
+};
+
+// Path of a builtin dataset file under the source tree. The app bundles
+// flatten the data directory, in the source tree the brain atlas and the
+// can simulation live in subdirectories.
+std::string BuiltinDatasetPath(const std::string& sourceDirectory,
+                               const std::string& filename);
+
+// Unlit shader program drawing the vertex colors, with the model view and
+// projection uniforms and the position and color attributes.
+vesSharedPtr<vesShaderProgram> CreateVertexColorShaderProgram();
+
+#endif
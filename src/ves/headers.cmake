@@ -5,25 +5,36 @@ set(headers
   vesBlend.h
   vesBooleanUniform.h
   vesBoundingObject.h
+  vesBoundingVolumeHierarchy.h
   vesCamera.h
   vesColorUniform.h
+  vesConditionVariable.h
   vesCullVisitor.h
   vesDepth.h
   vesEigen.h
   vesEngineUniform.h
   vesFBO.h
   vesFBORenderTarget.h
+  vesFrameArena.h
+  vesFrameRateGovernor.h
   vesGeometryData.h
   vesGL.h
+  vesGLState.h
+  vesGPUTimer.h
   vesGLTypes.h
   vesGroupNode.h
+  vesIdBufferPicker.h
   vesImage.h
   vesIntegerUniform.h
   vesMapper.h
   vesMaterial.h
   vesMaterialAttribute.h
+  vesMaterialUniforms.h
   vesMath.h
+  vesMeshCodec.h
+  vesMeshReader.h
   vesModelViewUniform.h
+  vesMutex.h
   vesNode.h
   vesNormalMatrixUniform.h
   vesObject.h
@@ -32,17 +43,26 @@ set(headers
   vesRenderer.h
   vesRenderLeaf.h
   vesRenderStage.h
+  vesRenderStatistics.h
   vesRenderState.h
   vesRenderTarget.h
   vesRenderToTexture.h
+  vesResolutionScaler.h
+  vesResourceCache.h
+  vesSceneCommand.h
+  vesSceneStore.h
   vesSetGet.h
   vesShader.h
+  vesShaderPermutations.h
   vesShaderProgram.h
   vesSharedPtr.h
   vesStateAttributeBits.h
   vesSourceData.h
   vesTexture.h
+  vesThread.h
+  vesThreadPool.h
   vesTransformNode.h
+  vesTriangleSorter.h
   vesUniform.h
   vesVertexAttribute.h
   vesVertexAttributeKeys.h
@@ -48,6 +48,7 @@ void vesActor::setMapper(vesSharedPtr<vesMapper> mapper)
   if (mapper && mapper != this->m_mapper) {
     this->m_mapper = mapper;
     this->setBoundsDirty(true);
+    vesObject::modified();
   }
 }
 
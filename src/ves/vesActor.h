@@ -60,6 +60,10 @@ public:
   vesSharedPtr<vesMapper> mapper() { return this->m_mapper; }
   const vesSharedPtr<vesMapper> mapper() const { return this->m_mapper; }
 
+  /// \copydoc vesNode::asActor()
+  virtual vesActor* asActor() { return this; }
+  virtual const vesActor* asActor() const { return this; }
+
   /// \copydoc vesTransformNode::accept()
   virtual void accept(vesVisitor &visitor);
 
@@ -20,6 +20,9 @@
 
 #include "vesBlend.h"
 
+// VES includes
+#include "vesRenderState.h"
+
 // C/C++ includes
 #include <iostream>
 
@@ -46,26 +49,18 @@ void vesBlend::setBlendFunction(const vesBlendFunction &blendFunction)
 
 void vesBlend::bind(const vesRenderState &renderState)
 {
-  this->m_wasEnabled = glIsEnabled(GL_BLEND);
+  this->m_wasEnabled = renderState.m_glState->isEnabled(GL_BLEND);
 
+  renderState.m_glState->setEnabled(GL_BLEND, this->m_enable);
   if (this->m_enable) {
-    glEnable(GL_BLEND);
     this->m_blendFunction.apply(renderState);
-  } else {
-    glDisable(GL_BLEND);
   }
 }
 
 
 void vesBlend::unbind(const vesRenderState &renderState)
 {
-  vesNotUsed(renderState);
-
-  if (this->m_wasEnabled) {
-    glEnable(GL_BLEND);
-  } else {
-    glDisable(GL_BLEND);
-  }
+  renderState.m_glState->setEnabled(GL_BLEND, this->m_wasEnabled);
 
   this->setDirtyStateOff();
 }
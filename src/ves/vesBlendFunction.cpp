@@ -37,8 +37,6 @@ vesBlendFunction::~vesBlendFunction()
 
 void vesBlendFunction::apply(const vesRenderState &renderState)
 {
-  vesNotUsed(renderState);
-
-  glBlendFunc(m_source, m_destination);
+  renderState.m_glState->blendFunc(m_source, m_destination);
 }
 
@@ -0,0 +1,610 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+
+#include "vesBoundingVolumeHierarchy.h"
+
+// VES includes
+#include "vesActor.h"
+#include "vesGeometryData.h"
+#include "vesMapper.h"
+#include "vesMutex.h"
+#include "vesPrimitive.h"
+#include "vesSourceData.h"
+#include "vesThread.h"
+#include "vesVertexAttributeKeys.h"
+
+// C/C++ includes
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+namespace {
+
+// Triangles per leaf, small leaves keep the number of triangle tests low.
+const unsigned int MaximumLeafSize = 4;
+
+struct Triangle
+{
+  unsigned int m_vertices[3];
+  int m_actor;
+};
+
+// Inner nodes have m_count == 0 and their children at m_first and
+// m_first + 1, leaves hold m_count triangles starting at m_first. Children
+// are always stored after their parent.
+struct Node
+{
+  vesVector3f m_min;
+  vesVector3f m_max;
+  unsigned int m_first;
+  unsigned int m_count;
+};
+
+struct ActorEntry
+{
+  vesSharedPtr<vesActor> m_actor;
+  vesSharedPtr<vesGeometryData> m_geometryData;
+  vesMatrix4x4f m_matrix;
+  bool m_pickable;
+  bool m_clipped;
+  vesVector4f m_clipPlane;
+  unsigned int m_firstVertex;
+  unsigned int m_numberOfVertices;
+};
+
+class CentroidLess
+{
+public:
+  CentroidLess(const std::vector<vesVector3f> &centroids, int axis) :
+    m_centroids(centroids), m_axis(axis)
+  {
+  }
+
+  bool operator()(unsigned int a, unsigned int b) const
+  {
+    return this->m_centroids[a][this->m_axis] < this->m_centroids[b][this->m_axis];
+  }
+
+private:
+  const std::vector<vesVector3f> &m_centroids;
+  int m_axis;
+};
+
+// Append the positions of the geometry data transformed by matrix.
+void appendWorldPositions(vesGeometryData &geometryData,
+                          const vesMatrix4x4f &matrix,
+                          std::vector<vesVector3f> &positions)
+{
+  vesSourceData::Ptr source =
+    geometryData.sourceData(vesVertexAttributeKeys::Position);
+  if (!source || !source->sizeOfArray() ||
+      source->attributeDataType(vesVertexAttributeKeys::Position) != vesDataType::Float) {
+    return;
+  }
+
+  const int key = vesVertexAttributeKeys::Position;
+  const unsigned int components = source->numberOfComponents(key);
+  const unsigned int stride = source->attributeStride(key);
+  const char *data = static_cast<const char*>(source->data()) + source->attributeOffset(key);
+
+  for (unsigned int i = 0; i < source->sizeOfArray(); ++i) {
+    const float *position = reinterpret_cast<const float*>(data + i * stride);
+    vesVector4f local(position[0], components > 1 ? position[1] : 0.0f,
+                      components > 2 ? position[2] : 0.0f, 1.0f);
+    vesVector4f world = matrix * local;
+    positions.push_back(vesVector3f(world[0], world[1], world[2]));
+  }
+}
+
+// Moller-Trumbore, returns the segment parameter of the hit or a negative
+// value.
+float intersectTriangle(const vesVector3f &origin, const vesVector3f &direction,
+                        const vesVector3f &v0, const vesVector3f &v1,
+                        const vesVector3f &v2)
+{
+  const vesVector3f edge1 = v1 - v0;
+  const vesVector3f edge2 = v2 - v0;
+  const vesVector3f p = direction.cross(edge2);
+  const float determinant = edge1.dot(p);
+  if (std::fabs(determinant) < std::numeric_limits<float>::epsilon() * edge1.squaredNorm()) {
+    return -1.0f;
+  }
+
+  const float inverseDeterminant = 1.0f / determinant;
+  const vesVector3f s = origin - v0;
+  const float u = s.dot(p) * inverseDeterminant;
+  if (u < 0.0f || u > 1.0f) {
+    return -1.0f;
+  }
+
+  const vesVector3f q = s.cross(edge1);
+  const float v = direction.dot(q) * inverseDeterminant;
+  if (v < 0.0f || u + v > 1.0f) {
+    return -1.0f;
+  }
+
+  return edge2.dot(q) * inverseDeterminant;
+}
+
+// Slab test, returns whether the box is entered before tMax.
+bool intersectBox(const vesVector3f &origin, const vesVector3f &inverseDirection,
+                  const Node &node, float tMax, float &tEnter)
+{
+  float t0 = 0.0f;
+  float t1 = tMax;
+  for (int i = 0; i < 3; ++i) {
+    float tNear = (node.m_min[i] - origin[i]) * inverseDirection[i];
+    float tFar = (node.m_max[i] - origin[i]) * inverseDirection[i];
+    if (tNear > tFar) {
+      std::swap(tNear, tFar);
+    }
+    t0 = tNear > t0 ? tNear : t0;
+    t1 = tFar < t1 ? tFar : t1;
+    if (t0 > t1) {
+      return false;
+    }
+  }
+  tEnter = t0;
+  return true;
+}
+
+} // end namespace
+
+
+class vesBoundingVolumeHierarchy::vesInternal : public vesThread
+{
+public:
+  vesInternal() : m_building(false)
+  {
+  }
+
+  ~vesInternal()
+  {
+    this->join();
+  }
+
+  /// Wait for a background build and make its result current.
+  void waitForBuild()
+  {
+    this->join();
+    vesMutexLocker locker(this->m_mutex);
+    this->m_building = false;
+  }
+
+  void buildHierarchy();
+  void computeBounds(Node &node) const;
+
+  std::vector<ActorEntry> m_actors;
+
+  std::vector<vesVector3f> m_vertices;
+  std::vector<Triangle> m_triangles;
+  std::vector<Node> m_nodes;
+
+  mutable vesMutex m_mutex;
+  bool m_building;
+
+protected:
+  virtual void run()
+  {
+    this->buildHierarchy();
+    vesMutexLocker locker(this->m_mutex);
+    this->m_building = false;
+  }
+};
+
+
+void vesBoundingVolumeHierarchy::vesInternal::computeBounds(Node &node) const
+{
+  node.m_min = vesVector3f::Constant(std::numeric_limits<float>::max());
+  node.m_max = vesVector3f::Constant(-std::numeric_limits<float>::max());
+  for (unsigned int i = node.m_first; i < node.m_first + node.m_count; ++i) {
+    for (int j = 0; j < 3; ++j) {
+      const vesVector3f &vertex = this->m_vertices[this->m_triangles[i].m_vertices[j]];
+      node.m_min = node.m_min.cwiseMin(vertex);
+      node.m_max = node.m_max.cwiseMax(vertex);
+    }
+  }
+}
+
+
+void vesBoundingVolumeHierarchy::vesInternal::buildHierarchy()
+{
+  this->m_vertices.clear();
+  this->m_triangles.clear();
+  this->m_nodes.clear();
+
+  for (size_t i = 0; i < this->m_actors.size(); ++i) {
+    ActorEntry &entry = this->m_actors[i];
+    entry.m_firstVertex = static_cast<unsigned int>(this->m_vertices.size());
+    entry.m_numberOfVertices = 0;
+
+    // Released arrays are brought back while they are read, this may run
+    // on the build thread.
+    if (!entry.m_geometryData || !entry.m_geometryData->lockData()) {
+      continue;
+    }
+
+    appendWorldPositions(*entry.m_geometryData, entry.m_matrix, this->m_vertices);
+    entry.m_numberOfVertices =
+      static_cast<unsigned int>(this->m_vertices.size()) - entry.m_firstVertex;
+    if (!entry.m_numberOfVertices) {
+      entry.m_geometryData->unlockData();
+      continue;
+    }
+
+    for (unsigned int j = 0; j < entry.m_geometryData->numberOfPrimitiveTypes(); ++j) {
+      const vesSharedPtr<vesPrimitive> primitive = entry.m_geometryData->primitive(j);
+      if (primitive->primitiveType() != vesPrimitiveRenderType::Triangles) {
+        continue;
+      }
+
+      const vesPrimitive::Indices &indices = *primitive->indices();
+      for (size_t k = 0; k + 2 < indices.size(); k += 3) {
+        if (indices[k] >= entry.m_numberOfVertices ||
+            indices[k+1] >= entry.m_numberOfVertices ||
+            indices[k+2] >= entry.m_numberOfVertices) {
+          continue;
+        }
+        Triangle triangle;
+        triangle.m_actor = static_cast<int>(i);
+        for (int l = 0; l < 3; ++l) {
+          triangle.m_vertices[l] = entry.m_firstVertex + indices[k+l];
+        }
+        this->m_triangles.push_back(triangle);
+      }
+    }
+
+    entry.m_geometryData->unlockData();
+  }
+
+  const unsigned int numberOfTriangles = static_cast<unsigned int>(this->m_triangles.size());
+  if (!numberOfTriangles) {
+    return;
+  }
+
+  std::vector<vesVector3f> centroids(numberOfTriangles);
+  std::vector<unsigned int> order(numberOfTriangles);
+  for (unsigned int i = 0; i < numberOfTriangles; ++i) {
+    const unsigned int *vertices = this->m_triangles[i].m_vertices;
+    centroids[i] = (this->m_vertices[vertices[0]] + this->m_vertices[vertices[1]] +
+                    this->m_vertices[vertices[2]]) / 3.0f;
+    order[i] = i;
+  }
+
+  // Split on the median centroid along the widest axis, top down.
+  this->m_nodes.reserve(2 * numberOfTriangles / MaximumLeafSize + 1);
+  Node root;
+  root.m_first = 0;
+  root.m_count = numberOfTriangles;
+  this->m_nodes.push_back(root);
+
+  std::vector<unsigned int> stack(1, 0);
+  while (!stack.empty()) {
+    const unsigned int nodeIndex = stack.back();
+    stack.pop_back();
+
+    const unsigned int first = this->m_nodes[nodeIndex].m_first;
+    const unsigned int count = this->m_nodes[nodeIndex].m_count;
+    if (count <= MaximumLeafSize) {
+      continue;
+    }
+
+    vesVector3f centroidMin = centroids[order[first]];
+    vesVector3f centroidMax = centroidMin;
+    for (unsigned int i = first + 1; i < first + count; ++i) {
+      centroidMin = centroidMin.cwiseMin(centroids[order[i]]);
+      centroidMax = centroidMax.cwiseMax(centroids[order[i]]);
+    }
+
+    int axis;
+    const vesVector3f extent = centroidMax - centroidMin;
+    if (extent.maxCoeff(&axis) <= 0.0f) {
+      continue;
+    }
+
+    const unsigned int middle = first + count / 2;
+    std::nth_element(order.begin() + first, order.begin() + middle,
+                     order.begin() + first + count, CentroidLess(centroids, axis));
+
+    Node left;
+    left.m_first = first;
+    left.m_count = middle - first;
+    Node right;
+    right.m_first = middle;
+    right.m_count = first + count - middle;
+
+    const unsigned int children = static_cast<unsigned int>(this->m_nodes.size());
+    this->m_nodes[nodeIndex].m_first = children;
+    this->m_nodes[nodeIndex].m_count = 0;
+    this->m_nodes.push_back(left);
+    this->m_nodes.push_back(right);
+    stack.push_back(children);
+    stack.push_back(children + 1);
+  }
+
+  std::vector<Triangle> triangles(numberOfTriangles);
+  for (unsigned int i = 0; i < numberOfTriangles; ++i) {
+    triangles[i] = this->m_triangles[order[i]];
+  }
+  this->m_triangles.swap(triangles);
+
+  // Bounds bottom up, children come after their parent.
+  for (size_t i = this->m_nodes.size(); i-- > 0;) {
+    Node &node = this->m_nodes[i];
+    if (node.m_count) {
+      this->computeBounds(node);
+    }
+    else {
+      node.m_min = this->m_nodes[node.m_first].m_min.cwiseMin(this->m_nodes[node.m_first + 1].m_min);
+      node.m_max = this->m_nodes[node.m_first].m_max.cwiseMax(this->m_nodes[node.m_first + 1].m_max);
+    }
+  }
+}
+
+
+vesBoundingVolumeHierarchy::vesBoundingVolumeHierarchy()
+{
+  this->m_internal = new vesInternal();
+}
+
+
+vesBoundingVolumeHierarchy::~vesBoundingVolumeHierarchy()
+{
+  delete this->m_internal; this->m_internal = 0x0;
+}
+
+
+int vesBoundingVolumeHierarchy::addActor(vesSharedPtr<vesActor> actor)
+{
+  assert(actor);
+  this->m_internal->waitForBuild();
+
+  ActorEntry entry;
+  entry.m_actor = actor;
+  if (actor->mapper()) {
+    entry.m_geometryData = actor->mapper()->geometryData();
+  }
+  entry.m_matrix = actor->matrix();
+  entry.m_pickable = true;
+  entry.m_clipped = false;
+  entry.m_firstVertex = 0;
+  entry.m_numberOfVertices = 0;
+  this->m_internal->m_actors.push_back(entry);
+  return static_cast<int>(this->m_internal->m_actors.size()) - 1;
+}
+
+
+int vesBoundingVolumeHierarchy::numberOfActors() const
+{
+  return static_cast<int>(this->m_internal->m_actors.size());
+}
+
+
+void vesBoundingVolumeHierarchy::clear()
+{
+  this->m_internal->waitForBuild();
+  this->m_internal->m_actors.clear();
+  this->m_internal->m_vertices.clear();
+  this->m_internal->m_triangles.clear();
+  this->m_internal->m_nodes.clear();
+}
+
+
+void vesBoundingVolumeHierarchy::setPickable(int actor, bool pickable)
+{
+  assert(actor >= 0 && actor < this->numberOfActors());
+  this->m_internal->m_actors[actor].m_pickable = pickable;
+}
+
+
+bool vesBoundingVolumeHierarchy::isPickable(int actor) const
+{
+  assert(actor >= 0 && actor < this->numberOfActors());
+  return this->m_internal->m_actors[actor].m_pickable;
+}
+
+
+void vesBoundingVolumeHierarchy::setClipPlane(int actor, const vesVector4f &plane)
+{
+  assert(actor >= 0 && actor < this->numberOfActors());
+  this->m_internal->m_actors[actor].m_clipped = true;
+  this->m_internal->m_actors[actor].m_clipPlane = plane;
+}
+
+
+void vesBoundingVolumeHierarchy::removeClipPlane(int actor)
+{
+  assert(actor >= 0 && actor < this->numberOfActors());
+  this->m_internal->m_actors[actor].m_clipped = false;
+}
+
+
+void vesBoundingVolumeHierarchy::build()
+{
+  this->m_internal->waitForBuild();
+  for (size_t i = 0; i < this->m_internal->m_actors.size(); ++i) {
+    this->m_internal->m_actors[i].m_matrix = this->m_internal->m_actors[i].m_actor->matrix();
+  }
+  this->m_internal->buildHierarchy();
+}
+
+
+void vesBoundingVolumeHierarchy::buildInBackground()
+{
+  this->m_internal->waitForBuild();
+
+  // Scene graph nodes are not thread safe, read the transforms here.
+  for (size_t i = 0; i < this->m_internal->m_actors.size(); ++i) {
+    this->m_internal->m_actors[i].m_matrix = this->m_internal->m_actors[i].m_actor->matrix();
+  }
+
+  {
+    vesMutexLocker locker(this->m_internal->m_mutex);
+    this->m_internal->m_building = true;
+  }
+  if (!this->m_internal->start()) {
+    this->m_internal->buildHierarchy();
+    vesMutexLocker locker(this->m_internal->m_mutex);
+    this->m_internal->m_building = false;
+  }
+}
+
+
+bool vesBoundingVolumeHierarchy::isBuilding() const
+{
+  vesMutexLocker locker(this->m_internal->m_mutex);
+  return this->m_internal->m_building;
+}
+
+
+void vesBoundingVolumeHierarchy::refit()
+{
+  this->m_internal->waitForBuild();
+
+  std::vector<vesVector3f> positions;
+  bool moved = false;
+  for (size_t i = 0; i < this->m_internal->m_actors.size(); ++i) {
+    ActorEntry &entry = this->m_internal->m_actors[i];
+    const vesMatrix4x4f matrix = entry.m_actor->matrix();
+    if (matrix == entry.m_matrix || !entry.m_numberOfVertices) {
+      continue;
+    }
+
+    entry.m_matrix = matrix;
+    positions.clear();
+    if (entry.m_geometryData->lockData()) {
+      appendWorldPositions(*entry.m_geometryData, matrix, positions);
+      entry.m_geometryData->unlockData();
+    }
+    if (positions.size() != entry.m_numberOfVertices) {
+      // The geometry changed under us, a full build is needed.
+      continue;
+    }
+    std::copy(positions.begin(), positions.end(),
+              this->m_internal->m_vertices.begin() + entry.m_firstVertex);
+    moved = true;
+  }
+
+  if (!moved) {
+    return;
+  }
+
+  std::vector<Node> &nodes = this->m_internal->m_nodes;
+  for (size_t i = nodes.size(); i-- > 0;) {
+    Node &node = nodes[i];
+    if (node.m_count) {
+      this->m_internal->computeBounds(node);
+    }
+    else {
+      node.m_min = nodes[node.m_first].m_min.cwiseMin(nodes[node.m_first + 1].m_min);
+      node.m_max = nodes[node.m_first].m_max.cwiseMax(nodes[node.m_first + 1].m_max);
+    }
+  }
+}
+
+
+bool vesBoundingVolumeHierarchy::pick(const vesVector3f &origin,
+                                      const vesVector3f &end, Hit &hit)
+{
+  this->m_internal->waitForBuild();
+
+  hit = Hit();
+  const std::vector<Node> &nodes = this->m_internal->m_nodes;
+  if (nodes.empty()) {
+    return false;
+  }
+
+  const std::vector<ActorEntry> &actors = this->m_internal->m_actors;
+  std::vector<bool> pickable(actors.size());
+  for (size_t i = 0; i < actors.size(); ++i) {
+    pickable[i] = actors[i].m_pickable && actors[i].m_actor->isVisible();
+  }
+
+  const vesVector3f direction = end - origin;
+  const vesVector3f inverseDirection(1.0f / direction[0], 1.0f / direction[1],
+                                     1.0f / direction[2]);
+  const std::vector<vesVector3f> &vertices = this->m_internal->m_vertices;
+  const std::vector<Triangle> &triangles = this->m_internal->m_triangles;
+
+  float closest = 1.0f;
+  unsigned int stack[64];
+  int stackSize = 0;
+  float tEnter;
+  if (!intersectBox(origin, inverseDirection, nodes[0], closest, tEnter)) {
+    return false;
+  }
+  stack[stackSize++] = 0;
+
+  while (stackSize) {
+    const Node &node = nodes[stack[--stackSize]];
+
+    if (node.m_count) {
+      for (unsigned int i = node.m_first; i < node.m_first + node.m_count; ++i) {
+        const Triangle &triangle = triangles[i];
+        if (!pickable[triangle.m_actor]) {
+          continue;
+        }
+
+        const float t = intersectTriangle(
+          origin, direction, vertices[triangle.m_vertices[0]],
+          vertices[triangle.m_vertices[1]], vertices[triangle.m_vertices[2]]);
+        if (t < 0.0f || t >= closest) {
+          continue;
+        }
+
+        const ActorEntry &actor = actors[triangle.m_actor];
+        const vesVector3f point = origin + t * direction;
+        if (actor.m_clipped &&
+            actor.m_clipPlane.head<3>().dot(point) + actor.m_clipPlane[3] < 0.0f) {
+          continue;
+        }
+
+        closest = t;
+        hit.m_actor = triangle.m_actor;
+        hit.m_point = point;
+      }
+      continue;
+    }
+
+    // Visit the nearer child first so farther boxes are culled by the
+    // closest hit found so far.
+    const unsigned int children[2] = {node.m_first, node.m_first + 1};
+    float tChild[2];
+    bool entered[2];
+    for (int i = 0; i < 2; ++i) {
+      entered[i] = intersectBox(origin, inverseDirection, nodes[children[i]], closest, tChild[i]);
+    }
+    const int nearer = (entered[0] && entered[1] && tChild[1] < tChild[0]) ? 1 : 0;
+    for (int i = 1; i >= 0; --i) {
+      const int child = i ? 1 - nearer : nearer;
+      if (entered[child] && stackSize < 64) {
+        stack[stackSize++] = children[child];
+      }
+    }
+  }
+
+  if (hit.m_actor < 0) {
+    return false;
+  }
+  hit.m_distance = closest * direction.norm();
+  return true;
+}
@@ -0,0 +1,116 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+/// \class vesBoundingVolumeHierarchy
+/// \ingroup ves
+/// \brief Bounding volume hierarchy over the triangles of a set of actors,
+/// in world coordinates, for picking.
+///
+/// All actors share one hierarchy so a pick is a single closest hit query
+/// whatever the number of actors. The hierarchy can be built on a
+/// background thread; queries made before it is ready wait for it. When
+/// actors move, refit() updates the bounds in place instead of rebuilding.
+///
+/// Only geometry data triangles are considered, strips, lines and points are
+/// not pickable. The geometry data must not be modified while it is used
+/// by the hierarchy.
+///
+/// \see vesActor vesGeometryData
+
+#ifndef VESBOUNDINGVOLUMEHIERARCHY_H
+#define VESBOUNDINGVOLUMEHIERARCHY_H
+
+// VES includes
+#include "vesMath.h"
+#include "vesSetGet.h"
+
+// Forward declarations
+class vesActor;
+
+class vesBoundingVolumeHierarchy
+{
+public:
+  vesTypeMacro(vesBoundingVolumeHierarchy);
+
+  struct Hit
+  {
+    Hit() : m_actor(-1), m_distance(0.0f)
+    {
+    }
+
+    /// Index of the actor hit, see addActor(), or -1
+    int m_actor;
+
+    /// Distance from the ray origin to the hit point
+    float m_distance;
+
+    /// Hit point in world coordinates
+    vesVector3f m_point;
+  };
+
+  vesBoundingVolumeHierarchy();
+  ~vesBoundingVolumeHierarchy();
+
+  /// Add the triangles of the actor's geometry data and return the index
+  /// of the actor. Takes effect with the next build.
+  int addActor(vesSharedPtr<vesActor> actor);
+
+  int numberOfActors() const;
+
+  /// Remove all actors and the hierarchy.
+  void clear();
+
+  /// Set whether the triangles of the actor can be picked, true by default.
+  /// Actors that are not visible are never picked.
+  void setPickable(int actor, bool pickable);
+  bool isPickable(int actor) const;
+
+  /// Set a plane equation in world coordinates clipping the actor. Points
+  /// p with dot(plane.xyz, p) + plane.w < 0 are clipped away and can not
+  /// be picked, which matches vesClipPlane_frag.glsl.
+  void setClipPlane(int actor, const vesVector4f &plane);
+  void removeClipPlane(int actor);
+
+  /// Build the hierarchy on the calling thread.
+  void build();
+
+  /// Start building the hierarchy on a background thread and return.
+  void buildInBackground();
+
+  /// Return true while a background build has not finished.
+  bool isBuilding() const;
+
+  /// Update the world coordinates and bounds of the actors whose transform
+  /// changed since the hierarchy was built or last refit.
+  void refit();
+
+  /// Find the closest triangle hit by the segment from \p origin to \p end,
+  /// ignoring clipped parts and actors that are not pickable. Return false
+  /// if nothing was hit.
+  bool pick(const vesVector3f &origin, const vesVector3f &end, Hit &hit);
+
+private:
+  class vesInternal;
+  vesInternal *m_internal;
+
+  vesBoundingVolumeHierarchy(const vesBoundingVolumeHierarchy&); // Not implemented
+  void operator=(const vesBoundingVolumeHierarchy&);             // Not implemented
+};
+
+#endif // VESBOUNDINGVOLUMEHIERARCHY_H
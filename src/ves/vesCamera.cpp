@@ -33,7 +33,8 @@
 #include <cassert>
 #include <iostream>
 
-vesCamera::vesCamera() : vesTransformNode()
+vesCamera::vesCamera() : vesTransformNode(),
+  m_renderStageBuffer(0)
 {
   this->setReferenceFrame(Absolute);
 
@@ -355,22 +356,25 @@ vesSharedPtr<vesViewport> vesCamera::viewport()
 
 vesSharedPtr<vesRenderStage> vesCamera::renderStage()
 {
-  return this->m_renderStage;
+  return this->m_renderStages[this->m_renderStageBuffer];
 }
 
 
 const vesSharedPtr<vesRenderStage> vesCamera::renderStage() const
 {
-  return this->m_renderStage;
+  return this->m_renderStages[this->m_renderStageBuffer];
 }
 
 
-vesSharedPtr<vesRenderStage> vesCamera::getOrCreateRenderStage()
+vesSharedPtr<vesRenderStage> vesCamera::getOrCreateRenderStage(int buffer)
 {
-  if (!this->m_renderStage) {
-    this->m_renderStage = vesRenderStage::Ptr(new vesRenderStage());
+  assert(buffer == 0 || buffer == 1);
+
+  if (!this->m_renderStages[buffer]) {
+    this->m_renderStages[buffer] = vesRenderStage::Ptr(new vesRenderStage());
   }
-  return this->m_renderStage;
+  this->m_renderStageBuffer = buffer;
+  return this->m_renderStages[buffer];
 }
 
 
@@ -219,10 +219,13 @@ public:
   const vesSharedPtr<vesViewport> viewport() const;
   vesSharedPtr<vesViewport> viewport();
 
-  /// Get render stage of the camera
+  /// Get the render stage the camera was last culled into
   vesSharedPtr<vesRenderStage> renderStage();
   const vesSharedPtr<vesRenderStage> renderStage() const;
-  vesSharedPtr<vesRenderStage> getOrCreateRenderStage();
+
+  /// Get the render stage of \p buffer, creating it if needed. A pipelined
+  /// renderer culls into two stages in turn, see vesRenderer::setPipelined().
+  vesSharedPtr<vesRenderStage> getOrCreateRenderStage(int buffer=0);
 
   /// Set render order of the camera. Default is NestedRender.
   void setRenderOrder(RenderOrder renderOrder, int renderOrderPriority=0);
@@ -262,6 +265,10 @@ public:
   /// Return projection matrix for the camera
   virtual vesMatrix4x4f projectionMatrix();
 
+  /// \copydoc vesNode::asCamera()
+  virtual vesCamera* asCamera() { return this; }
+  virtual const vesCamera* asCamera() const { return this; }
+
   /// \copydoc vesTransformNode::accept()
   virtual void accept(vesVisitor &visitor);
 
@@ -274,6 +281,11 @@ public:
                                          vesVisitor& visitor);
 
 protected:
+  /// The view matrix depends on members that are modified all over the
+  /// place, so it is always recomputed; the local to world version still
+  /// only changes when its value does.
+  virtual bool isMatrixDirty() const { return true; }
+
   void computeDistance();
   void computeViewPlaneNormal();
 
@@ -291,7 +303,8 @@ protected:
   bool          m_parallelProjection;
 
   vesSharedPtr<vesViewport> m_viewport;
-  vesSharedPtr<vesRenderStage> m_renderStage;
+  vesSharedPtr<vesRenderStage> m_renderStages[2];
+  int m_renderStageBuffer;
 
   RenderOrder m_renderOrder;
   int         m_renderOrderPriority;
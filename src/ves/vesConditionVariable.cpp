@@ -0,0 +1,53 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+
+#include "vesConditionVariable.h"
+
+// VES includes
+#include "vesMutex.h"
+
+vesConditionVariable::vesConditionVariable()
+{
+  pthread_cond_init(&this->m_condition, 0);
+}
+
+
+vesConditionVariable::~vesConditionVariable()
+{
+  pthread_cond_destroy(&this->m_condition);
+}
+
+
+void vesConditionVariable::wait(vesMutex &mutex)
+{
+  pthread_cond_wait(&this->m_condition, &mutex.m_mutex);
+}
+
+
+void vesConditionVariable::signal()
+{
+  pthread_cond_signal(&this->m_condition);
+}
+
+
+void vesConditionVariable::broadcast()
+{
+  pthread_cond_broadcast(&this->m_condition);
+}
@@ -0,0 +1,59 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+/// \class vesConditionVariable
+/// \ingroup ves
+/// \brief Lets threads wait for a condition guarded by a vesMutex.
+///
+/// As with any condition variable, wakeups may be spurious: always wait in
+/// a loop that checks the condition.
+/// \see vesMutex vesThread
+
+#ifndef VESCONDITIONVARIABLE_H
+#define VESCONDITIONVARIABLE_H
+
+// C/C++ includes
+#include <pthread.h>
+
+class vesMutex;
+
+class vesConditionVariable
+{
+public:
+  vesConditionVariable();
+  ~vesConditionVariable();
+
+  /// Atomically unlock \p mutex, which must be locked by the calling
+  /// thread, and wait for a signal. The mutex is locked again on return.
+  void wait(vesMutex &mutex);
+
+  /// Wake up one waiting thread.
+  void signal();
+
+  /// Wake up all waiting threads.
+  void broadcast();
+
+private:
+  pthread_cond_t m_condition;
+
+  vesConditionVariable(const vesConditionVariable&); // Not implemented
+  void operator=(const vesConditionVariable&);       // Not implemented
+};
+
+#endif // VESCONDITIONVARIABLE_H
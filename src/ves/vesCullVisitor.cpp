@@ -26,38 +26,77 @@
 #include "vesGroupNode.h"
 #include "vesNode.h"
 #include "vesRenderStage.h"
+#include "vesRenderStatistics.h"
+#include "vesSceneStore.h"
 #include "vesTransformNode.h"
 
 void vesCullVisitor::addGeometryAndStates(
-  const vesSharedPtr<vesMapper> &mapper,
-  const vesSharedPtr<vesMaterial> &material,
-  const vesMatrix4x4f &modelViewMatrix,
-  const vesMatrix4x4f &projectionMatrix,
-  float depth)
+  vesMapper *mapper,
+  vesMaterial *material,
+  const vesMatrix4x4f *modelViewMatrix,
+  const vesMatrix4x4f *projectionMatrix,
+  float depth,
+  const vesActor *actor,
+  const vesMatrix3x3f *normalMatrix)
 {
   this->renderStage()->addRenderLeaf(
-    vesRenderLeaf(depth, modelViewMatrix, projectionMatrix, material, mapper));
+    vesRenderLeaf(depth, modelViewMatrix, projectionMatrix, material, mapper,
+                  actor, normalMatrix));
+}
+
+
+const vesMatrix4x4f* vesCullVisitor::frameProjection2DMatrix()
+{
+  if (!this->m_frameProjection2DMatrix) {
+    this->m_frameProjection2DMatrix =
+      this->frameArena()->copy(this->m_projection2DMatrix);
+  }
+  return this->m_frameProjection2DMatrix;
 }
 
 
 void vesCullVisitor::visit(vesNode &node)
 {
+  if (!node.isVisible()) {
+    vesRenderStatistics::addCullRejects(1);
+    return;
+  }
+
   this->invokeCallbacksAndTraverse(node);
 }
 
 
 void vesCullVisitor::visit(vesGroupNode &groupNode)
 {
+  if (!groupNode.isVisible()) {
+    vesRenderStatistics::addCullRejects(1);
+    return;
+  }
+
+  if (this->m_sceneStore && &groupNode == this->m_sceneStoreRoot &&
+      this->m_sceneStore->cull(groupNode, this->modelViewMatrix(),
+                               this->modelViewMatrixVersion(),
+                               this->projectionMatrix(),
+                               *this->frameProjection2DMatrix(),
+                               *this->renderStage())) {
+    return;
+  }
+
   this->invokeCallbacksAndTraverse(groupNode);
 }
 
 
 void vesCullVisitor::visit(vesTransformNode &transformNode)
 {
-  vesMatrix4x4f matrix = this->modelViewMatrix();
-  transformNode.computeLocalToWorldMatrix(matrix, *this);
+  if (!transformNode.isVisible()) {
+    vesRenderStatistics::addCullRejects(1);
+    return;
+  }
 
-  this->pushModelViewMatrix(matrix);
+  const vesMatrix4x4f &matrix = transformNode.localToWorldMatrix(
+    this->modelViewMatrix(), this->modelViewMatrixVersion(), *this);
+
+  this->pushModelViewMatrix(matrix, transformNode.localToWorldVersion());
 
   this->invokeCallbacksAndTraverse(transformNode);
 
@@ -67,19 +106,25 @@ void vesCullVisitor::visit(vesTransformNode &transformNode)
 
 void vesCullVisitor::visit(vesActor &actor)
 {
-  vesMatrix4x4f matrix = this->modelViewMatrix();
-  actor.computeLocalToWorldMatrix(matrix, *this);
+  if (!actor.isVisible()) {
+    vesRenderStatistics::addCullRejects(1);
+    return;
+  }
 
-  this->pushModelViewMatrix(matrix);
+  const vesMatrix4x4f &matrix = actor.localToWorldMatrix(
+    this->modelViewMatrix(), this->modelViewMatrixVersion(), *this);
 
-   if (actor.isOverlayNode()) {
-    this->addGeometryAndStates(actor.mapper(), actor.material(),
-      actor.modelViewMatrix(),  this->projection2DMatrix(), 1);
+  this->pushModelViewMatrix(matrix, actor.localToWorldVersion());
+
+  if (actor.isOverlayNode()) {
+    this->addGeometryAndStates(actor.mapper().get(), actor.material().get(),
+      this->frameArena()->copy(actor.modelViewMatrix()),
+      this->frameProjection2DMatrix(), 1, &actor);
   }
   else {
-    // \todo: We could do some optimization here.
-    this->addGeometryAndStates(actor.mapper(), actor.material(),
-      this->modelViewMatrix(), this->projectionMatrix(), 1);
+    // The actor keeps its matrices until the next cull.
+    this->addGeometryAndStates(actor.mapper().get(), actor.material().get(),
+      &matrix, &this->projectionMatrix(), 1, &actor, &actor.normalMatrix());
   }
 
   this->invokeCallbacksAndTraverse(actor);
@@ -90,16 +135,19 @@ void vesCullVisitor::visit(vesActor &actor)
 
 void vesCullVisitor::visit(vesCamera &camera)
 {
-  vesMatrix4x4f matrix = this->modelViewMatrix();
-  camera.computeLocalToWorldMatrix(matrix, *this);
+  const vesMatrix4x4f &matrix = camera.localToWorldMatrix(
+    this->modelViewMatrix(), this->modelViewMatrixVersion(), *this);
 
-  this->pushModelViewMatrix(matrix);
+  this->pushModelViewMatrix(matrix, camera.localToWorldVersion());
 
+  // The stack and the leaves keep a pointer, the projection must live
+  // until the stages are drawn.
+  vesMatrix4x4f *projectionMatrix =
+    this->frameArena()->copy(camera.projectionMatrix());
   if (camera.referenceFrame() == vesTransformNode::Relative) {
-    this->pushProjectionMatrix(this->projectionMatrix() * camera.projectionMatrix());
-  } else {
-    this->pushProjectionMatrix(camera.projectionMatrix());
+    *projectionMatrix = this->projectionMatrix() * (*projectionMatrix);
   }
+  this->pushProjectionMatrix(*projectionMatrix);
 
   // If camera is set as a NestedRender, treat camera as
   // a node that contains the subgraph in the current render stage.
@@ -107,10 +155,10 @@ void vesCullVisitor::visit(vesCamera &camera)
     this->invokeCallbacksAndTraverse(camera);
   } else {
 
-    vesSharedPtr<vesRenderStage> previousRenderStage = this->renderStage();
+    vesRenderStage *previousRenderStage = this->renderStage();
 
     vesSharedPtr<vesRenderStage> renderStage =
-      camera.getOrCreateRenderStage();
+      camera.getOrCreateRenderStage(this->m_stageBuffer);
     renderStage->clearAll();
     renderStage->setViewport( (camera.viewport() != 0)
       ? camera.viewport() : previousRenderStage->viewport() );
@@ -118,7 +166,7 @@ void vesCullVisitor::visit(vesCamera &camera)
     renderStage->setClearMask(camera.clearMask());
     renderStage->setClearDepth(camera.clearDepth());
 
-    this->pushRenderStage(renderStage);
+    this->pushRenderStage(renderStage.get());
 
     this->invokeCallbacksAndTraverse(camera);
 
@@ -126,10 +174,12 @@ void vesCullVisitor::visit(vesCamera &camera)
 
     switch (camera.renderOrder()) {
     case vesCamera::PreRender:
-      this->renderStage()->addPreRenderStage(renderStage, camera.renderOrderPriority());
+      this->renderStage()->addPreRenderStage(renderStage.get(),
+                                             camera.renderOrderPriority());
       break;
     case vesCamera::PostRender:
-      this->renderStage()->addPostRenderStage(renderStage, camera.renderOrderPriority());
+      this->renderStage()->addPostRenderStage(renderStage.get(),
+                                              camera.renderOrderPriority());
       break;
     case vesCamera::NestedRender:
     default:
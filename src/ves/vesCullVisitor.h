@@ -19,7 +19,16 @@
  ========================================================================*/
 /// \class vesCullVisitor
 /// \ingroup ves
-/// \see vesVisitor
+/// \brief Collects the render leaves of visible actors into render stages.
+///
+/// When a scene store is set, the subgraph below its root group node is
+/// culled by the store instead of being traversed.
+///
+/// The render leaves point at matrices instead of copying them. Those that
+/// are not kept by the scene graph, camera projections and overlay
+/// matrices, are copied into the frame arena, which must not be reset
+/// before the render stages are drawn.
+/// \see vesVisitor vesSceneStore vesFrameArena
 
 #ifndef VESCULLVISITOR_H
 #define VESCULLVISITOR_H
@@ -29,20 +38,29 @@
 // VES includes
 #include "vesSetGet.h"
 
+#include "vesFrameArena.h"
+
 // C/C++ includes.
 #include <vector>
 
 // Forward declarations
 class vesCamera;
 class vesRenderStage;
+class vesSceneStore;
 
 class vesCullVisitor : public vesVisitor
 {
 public:
   vesTypeMacro(vesCullVisitor);
 
-  vesCullVisitor(TraversalMode mode=TraverseAllChildren) :
-    vesVisitor    (CullVisitor, mode)
+  explicit vesCullVisitor(vesFrameArena &frameArena,
+                          TraversalMode mode=TraverseAllChildren) :
+    vesVisitor    (CullVisitor, mode, &frameArena),
+    m_renderStageStack(RenderStageAllocator(&frameArena)),
+    m_renderStage(0x0),
+    m_stageBuffer(0),
+    m_sceneStoreRoot(0x0),
+    m_frameProjection2DMatrix(0x0)
   {
   }
 
@@ -54,8 +72,8 @@ public:
   {
     bool success = true;
 
-    if (renderStage && this->m_renderStage != renderStage) {
-      this->m_renderStage = renderStage;
+    if (renderStage && this->m_renderStage != renderStage.get()) {
+      this->m_renderStage = renderStage.get();
       this->m_renderStageStack.push_back(this->m_renderStage);
 
       return success;
@@ -64,12 +82,12 @@ public:
     return !success;
   }
 
-  vesSharedPtr<vesRenderStage> renderStage() const
+  vesRenderStage* renderStage() const
   {
     return this->m_renderStageStack.back();
   }
 
-  void pushRenderStage(vesSharedPtr<vesRenderStage> renderStage)
+  void pushRenderStage(vesRenderStage *renderStage)
   {
     // No check is applied here.
     this->m_renderStageStack.push_back(renderStage);
@@ -80,6 +98,20 @@ public:
     this->m_renderStageStack.pop_back();
   }
 
+  /// Which of the two render stages of the cameras to cull into, see
+  /// vesCamera::getOrCreateRenderStage(). 0 by default.
+  void setStageBuffer(int buffer) { this->m_stageBuffer = buffer; }
+  int stageBuffer() const { return this->m_stageBuffer; }
+
+  /// Let \p sceneStore cull the subgraph below \p root. The graph is
+  /// traversed as usual if the store cannot flatten it.
+  void setSceneStore(vesSharedPtr<vesSceneStore> sceneStore,
+                     const vesGroupNode *root)
+  {
+    this->m_sceneStore = sceneStore;
+    this->m_sceneStoreRoot = root;
+  }
+
   virtual void visit(vesNode &node);
   virtual void visit(vesGroupNode &groupNode);
   virtual void visit(vesTransformNode &transformNode);
@@ -87,21 +119,33 @@ public:
   virtual void visit(vesCamera &camera);
 
 protected:
-  void addGeometryAndStates(const vesSharedPtr<vesMapper> &mapper,
-                            const vesSharedPtr<vesMaterial> &material,
-                            const vesMatrix4x4f &modelViewMatrix,
-                            const vesMatrix4x4f &projectionMatrix,
-                            float depth);
+  void addGeometryAndStates(vesMapper *mapper,
+                            vesMaterial *material,
+                            const vesMatrix4x4f *modelViewMatrix,
+                            const vesMatrix4x4f *projectionMatrix,
+                            float depth,
+                            const vesActor *actor=0x0,
+                            const vesMatrix3x3f *normalMatrix=0x0);
+
+  /// The 2D projection, copied into the frame arena on first use.
+  const vesMatrix4x4f* frameProjection2DMatrix();
 
   inline void invokeCallbacksAndTraverse(vesNode &node)
   {
     this->traverse(node);
   }
 
-  typedef std::vector< vesSharedPtr<vesRenderStage> > RenderStageStack;
+  typedef vesFrameArenaAllocator<vesRenderStage*> RenderStageAllocator;
+  typedef std::vector<vesRenderStage*, RenderStageAllocator> RenderStageStack;
 
   RenderStageStack m_renderStageStack;
-  vesSharedPtr<vesRenderStage> m_renderStage;
+  vesRenderStage *m_renderStage;
+  int m_stageBuffer;
+
+  vesSharedPtr<vesSceneStore> m_sceneStore;
+  const vesGroupNode *m_sceneStoreRoot;
+
+  const vesMatrix4x4f *m_frameProjection2DMatrix;
 };
 
 #endif // VESCULLVISITOR_H
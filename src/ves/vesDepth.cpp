@@ -22,6 +22,7 @@
 
 // VES includes.
 #include "vesGL.h"
+#include "vesRenderState.h"
 
 // C/C++ includes.
 #include <iostream>
@@ -43,32 +44,24 @@ vesDepth::~vesDepth()
 
 void vesDepth::bind(const vesRenderState &renderState)
 {
-  vesNotUsed(renderState);
-
   // Save current state.
-  this->m_wasEnabled = glIsEnabled(GL_DEPTH_TEST);
+  this->m_wasEnabled = renderState.m_glState->isEnabled(GL_DEPTH_TEST);
 
   // Save current depth mask for restoration later.
 //  glGet(GL_DEPTH_WRITEMASK, &this->m_previousDepthWriteMask);
 
+  renderState.m_glState->setEnabled(GL_DEPTH_TEST, this->m_enable);
   if (this->m_enable) {
-    glEnable(GL_DEPTH_TEST);
-    glDepthMask((GLboolean) this->m_depthWriteMask);
-  } else {
-    glDisable(GL_DEPTH_TEST);
+    renderState.m_glState->depthMask(this->m_depthWriteMask);
   }
 }
 
 
 void vesDepth::unbind(const vesRenderState &renderState)
 {
-  vesNotUsed(renderState);
-
+  renderState.m_glState->setEnabled(GL_DEPTH_TEST, this->m_wasEnabled);
   if (this->m_wasEnabled) {
-      glEnable(GL_DEPTH_TEST);
-      glDepthMask((GLboolean) this->m_depthWriteMask);
-  } else {
-    glDisable(GL_DEPTH_TEST);
+    renderState.m_glState->depthMask(this->m_depthWriteMask);
   }
 
   // Restore previous depth mask.
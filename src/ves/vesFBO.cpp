@@ -282,11 +282,15 @@ void vesFBO::deleteFBO(vesRenderState &renderState)
 {
   this->remove(renderState);
 
-  vesInternal::AttachmentToRBOMap::iterator itr = this->m_internal->m_attachmentToRBOMap.end();
+  vesInternal::AttachmentToRBOMap::iterator itr = this->m_internal->m_attachmentToRBOMap.begin();
 
   for (; itr != this->m_internal->m_attachmentToRBOMap.end(); ++itr) {
     glDeleteRenderbuffers(1, &(itr->second));
   }
+  this->m_internal->m_attachmentToRBOMap.clear();
 
-  glDeleteFramebuffers (1, &this->m_internal->m_frameBufferHandle);
+  if (this->m_internal->m_frameBufferHandle) {
+    glDeleteFramebuffers (1, &this->m_internal->m_frameBufferHandle);
+    this->m_internal->m_frameBufferHandle = 0;
+  }
 }
@@ -0,0 +1,102 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+
+#include "vesFrameArena.h"
+
+// C/C++ includes
+#include <algorithm>
+#include <cassert>
+
+vesFrameArena::vesFrameArena(size_t initialSize) :
+  m_currentBlock(0),
+  m_offset(0),
+  m_bytesUsed(0)
+{
+  Block block;
+  block.m_size = std::max(initialSize, static_cast<size_t>(64));
+  block.m_data = new char[block.m_size];
+  this->m_blocks.push_back(block);
+}
+
+
+vesFrameArena::~vesFrameArena()
+{
+  for (size_t i = 0; i < this->m_blocks.size(); ++i) {
+    delete [] this->m_blocks[i].m_data;
+  }
+}
+
+
+void* vesFrameArena::allocate(size_t size, size_t alignment)
+{
+  assert(alignment && !(alignment & (alignment - 1)));
+
+  while (true) {
+    Block &block = this->m_blocks[this->m_currentBlock];
+    size_t address = reinterpret_cast<size_t>(block.m_data) + this->m_offset;
+    size_t padding = (alignment - (address & (alignment - 1))) & (alignment - 1);
+    if (this->m_offset + padding + size <= block.m_size) {
+      void *result = block.m_data + this->m_offset + padding;
+      this->m_offset += padding + size;
+      this->m_bytesUsed += padding + size;
+      return result;
+    }
+
+    // Move on to the next block, adding one at least twice as large.
+    if (this->m_currentBlock + 1 == this->m_blocks.size()) {
+      Block next;
+      next.m_size = std::max(2 * block.m_size, size + alignment);
+      next.m_data = new char[next.m_size];
+      this->m_blocks.push_back(next);
+    }
+    this->m_bytesUsed += block.m_size - this->m_offset;
+    ++this->m_currentBlock;
+    this->m_offset = 0;
+  }
+}
+
+
+void vesFrameArena::reset()
+{
+  // Merge the blocks so the next frame of the same size fits in one.
+  if (this->m_blocks.size() > 1) {
+    Block merged;
+    merged.m_size = this->capacity();
+    for (size_t i = 0; i < this->m_blocks.size(); ++i) {
+      delete [] this->m_blocks[i].m_data;
+    }
+    merged.m_data = new char[merged.m_size];
+    this->m_blocks.assign(1, merged);
+  }
+
+  this->m_currentBlock = 0;
+  this->m_offset = 0;
+  this->m_bytesUsed = 0;
+}
+
+
+size_t vesFrameArena::capacity() const
+{
+  size_t size = 0;
+  for (size_t i = 0; i < this->m_blocks.size(); ++i) {
+    size += this->m_blocks[i].m_size;
+  }
+  return size;
+}
@@ -0,0 +1,160 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+/// \class vesFrameArena
+/// \ingroup ves
+/// \brief Linear allocator for data that lives for one frame.
+///
+/// Allocations bump a pointer and are never freed one by one, reset()
+/// releases them all at once. Blocks added while a frame grows are merged
+/// into one block by the next reset(), so once the frame size is stable the
+/// arena stops touching the heap. Destructors of objects placed in the
+/// arena are not run.
+///
+/// vesFrameArenaAllocator lets standard containers take their storage from
+/// an arena.
+/// \see vesRenderer vesCullVisitor
+
+#ifndef VESFRAMEARENA_H
+#define VESFRAMEARENA_H
+
+// C/C++ includes
+#include <cstddef>
+#include <new>
+#include <vector>
+
+class vesFrameArena
+{
+public:
+  explicit vesFrameArena(size_t initialSize=16384);
+  ~vesFrameArena();
+
+  /// Return \p size bytes aligned to \p alignment, which must be a power of
+  /// two. The memory stays valid until the next reset().
+  void* allocate(size_t size, size_t alignment=16);
+
+  /// Copy \p value into the arena.
+  template <typename T>
+  T* copy(const T &value)
+  {
+    return new (this->allocate(sizeof(T))) T(value);
+  }
+
+  /// Release everything allocated since the last reset.
+  void reset();
+
+  /// Bytes handed out since the last reset.
+  size_t bytesUsed() const { return this->m_bytesUsed; }
+
+  /// Bytes owned by the arena.
+  size_t capacity() const;
+
+private:
+  struct Block
+  {
+    char *m_data;
+    size_t m_size;
+  };
+
+  std::vector<Block> m_blocks;
+  size_t m_currentBlock;
+  size_t m_offset;
+  size_t m_bytesUsed;
+
+  vesFrameArena(const vesFrameArena&);     // Not implemented
+  void operator=(const vesFrameArena&); // Not implemented
+};
+
+
+/// \class vesFrameArenaAllocator
+/// \ingroup ves
+/// \brief Standard allocator drawing from a vesFrameArena.
+///
+/// Deallocation is a no-op, the memory comes back with the arena's reset().
+/// Without an arena it falls back to the heap.
+template <typename T>
+class vesFrameArenaAllocator
+{
+public:
+  typedef T value_type;
+  typedef T* pointer;
+  typedef const T* const_pointer;
+  typedef T& reference;
+  typedef const T& const_reference;
+  typedef size_t size_type;
+  typedef ptrdiff_t difference_type;
+
+  template <typename U>
+  struct rebind
+  {
+    typedef vesFrameArenaAllocator<U> other;
+  };
+
+  vesFrameArenaAllocator(vesFrameArena *arena=0x0) : m_arena(arena)
+  {
+  }
+
+  template <typename U>
+  vesFrameArenaAllocator(const vesFrameArenaAllocator<U> &other) :
+    m_arena(other.arena())
+  {
+  }
+
+  pointer allocate(size_type count, const void* =0x0)
+  {
+    if (this->m_arena) {
+      return static_cast<pointer>(this->m_arena->allocate(count * sizeof(T)));
+    }
+    return static_cast<pointer>(::operator new(count * sizeof(T)));
+  }
+
+  void deallocate(pointer p, size_type)
+  {
+    if (!this->m_arena) {
+      ::operator delete(p);
+    }
+  }
+
+  void construct(pointer p, const T &value) { new (p) T(value); }
+  void destroy(pointer p) { p->~T(); }
+
+  pointer address(reference value) const { return &value; }
+  const_pointer address(const_reference value) const { return &value; }
+
+  size_type max_size() const { return size_type(-1) / sizeof(T); }
+
+  vesFrameArena* arena() const { return this->m_arena; }
+
+  template <typename U>
+  bool operator==(const vesFrameArenaAllocator<U> &other) const
+  {
+    return this->m_arena == other.arena();
+  }
+
+  template <typename U>
+  bool operator!=(const vesFrameArenaAllocator<U> &other) const
+  {
+    return this->m_arena != other.arena();
+  }
+
+private:
+  vesFrameArena *m_arena;
+};
+
+#endif // VESFRAMEARENA_H
@@ -0,0 +1,136 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+
+#include "vesFrameRateGovernor.h"
+
+// C/C++ includes
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// Number of frames averaged
+const size_t FrameTimeHistory = 8;
+
+// Scales are multiples of this step, which keeps the offscreen buffers
+// from being reallocated for every frame.
+const float ScaleStep = 0.125f;
+
+} // end namespace
+
+vesFrameRateGovernor::vesFrameRateGovernor() :
+  m_targetFramesPerSecond(30.0),
+  m_minimumScale(0.25f),
+  m_scale(1.0f),
+  m_nextFrameTime(0)
+{
+}
+
+
+vesFrameRateGovernor::~vesFrameRateGovernor()
+{
+}
+
+
+void vesFrameRateGovernor::setTargetFramesPerSecond(double framesPerSecond)
+{
+  if (framesPerSecond > 0.0) {
+    this->m_targetFramesPerSecond = framesPerSecond;
+    this->updateScale();
+  }
+}
+
+
+double vesFrameRateGovernor::targetFramesPerSecond() const
+{
+  return this->m_targetFramesPerSecond;
+}
+
+
+void vesFrameRateGovernor::setMinimumScale(float scale)
+{
+  this->m_minimumScale = std::min(std::max(scale, 0.01f), 1.0f);
+  this->updateScale();
+}
+
+
+float vesFrameRateGovernor::minimumScale() const
+{
+  return this->m_minimumScale;
+}
+
+
+void vesFrameRateGovernor::addFrameTime(double seconds, float scale)
+{
+  if (seconds <= 0.0 || scale <= 0.0f) {
+    return;
+  }
+
+  double frameTime = seconds / (scale * scale);
+  if (this->m_frameTimes.size() < FrameTimeHistory) {
+    this->m_frameTimes.push_back(frameTime);
+  }
+  else {
+    this->m_frameTimes[this->m_nextFrameTime] = frameTime;
+  }
+  this->m_nextFrameTime = (this->m_nextFrameTime + 1) % FrameTimeHistory;
+
+  this->updateScale();
+}
+
+
+float vesFrameRateGovernor::scale() const
+{
+  return this->m_scale;
+}
+
+
+void vesFrameRateGovernor::reset()
+{
+  this->m_frameTimes.clear();
+  this->m_nextFrameTime = 0;
+  this->m_scale = 1.0f;
+}
+
+
+void vesFrameRateGovernor::updateScale()
+{
+  if (this->m_frameTimes.empty()) {
+    return;
+  }
+
+  double frameTime = 0.0;
+  for (size_t i = 0; i < this->m_frameTimes.size(); ++i) {
+    frameTime += this->m_frameTimes[i];
+  }
+  frameTime /= this->m_frameTimes.size();
+
+  double targetFrameTime = 1.0 / this->m_targetFramesPerSecond;
+  float scale = static_cast<float>(std::sqrt(targetFrameTime / frameTime));
+
+  // Round down to a step. Going up also needs a margin of half a step.
+  float steppedScale = std::floor(scale / ScaleStep) * ScaleStep;
+  if (steppedScale > this->m_scale &&
+      scale < steppedScale + 0.5f * ScaleStep) {
+    steppedScale = std::max(this->m_scale, steppedScale - ScaleStep);
+  }
+
+  this->m_scale = std::min(std::max(steppedScale, this->m_minimumScale), 1.0f);
+}
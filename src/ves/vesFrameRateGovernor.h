@@ -0,0 +1,82 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+/// \class vesFrameRateGovernor
+/// \ingroup ves
+/// \brief Chooses the resolution scale needed to reach a target frame rate.
+///
+/// The caller reports how long each frame took and at which resolution
+/// scale it was rendered. Assuming the cost of a frame is proportional to
+/// its number of pixels, every report is turned into the time a full
+/// resolution frame would take, and the average of the last few reports
+/// gives the scale that fits the frame into the target frame time.
+///
+/// The scale goes down in steps as soon as frames are too slow, but goes
+/// up only once the estimate clears a step by a margin, so that noise in
+/// the frame times does not make it oscillate.
+///
+/// \see vesRenderer::setResolutionScale
+
+#ifndef VESFRAMERATEGOVERNOR_H
+#define VESFRAMERATEGOVERNOR_H
+
+// VES includes
+#include "vesSetGet.h"
+
+// C/C++ includes
+#include <vector>
+
+class vesFrameRateGovernor
+{
+public:
+  vesTypeMacro(vesFrameRateGovernor);
+
+  vesFrameRateGovernor();
+  ~vesFrameRateGovernor();
+
+  /// Set the frame rate to reach, 30 by default.
+  void setTargetFramesPerSecond(double framesPerSecond);
+  double targetFramesPerSecond() const;
+
+  /// Set the lowest scale ever chosen, 0.25 by default.
+  void setMinimumScale(float scale);
+  float minimumScale() const;
+
+  /// Report that a frame rendered at \p scale took \p seconds.
+  void addFrameTime(double seconds, float scale);
+
+  /// Scale to render the next frame at, between the minimum scale and 1.
+  float scale() const;
+
+  /// Forget the reported frame times and go back to full resolution.
+  void reset();
+
+private:
+  void updateScale();
+
+  double m_targetFramesPerSecond;
+  float m_minimumScale;
+  float m_scale;
+
+  /// Full resolution frame times of the last frames, used as a ring
+  std::vector<double> m_frameTimes;
+  size_t m_nextFrameTime;
+};
+
+#endif // VESFRAMERATEGOVERNOR_H
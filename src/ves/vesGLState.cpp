@@ -0,0 +1,339 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+
+#include "vesGLState.h"
+
+// VES includes
+#include "vesGL.h"
+#include "vesRenderStatistics.h"
+
+vesGLState::vesGLState() :
+  m_arrayDisablePending(false),
+  m_avoidedCalls(0)
+{
+  this->invalidate();
+}
+
+
+vesGLState::~vesGLState()
+{
+}
+
+
+void vesGLState::avoided()
+{
+  ++this->m_avoidedCalls;
+  vesRenderStatistics::addAvoidedGLCalls(1);
+}
+
+
+void vesGLState::useProgram(unsigned int program)
+{
+  if (this->m_programKnown && this->m_program == program) {
+    this->avoided();
+    return;
+  }
+
+  glUseProgram(program);
+  vesRenderStatistics::addProgramBind();
+  this->m_programKnown = true;
+  this->m_program = program;
+}
+
+
+void vesGLState::bindBuffer(unsigned int target, unsigned int buffer)
+{
+  bool *known = 0x0;
+  unsigned int *bound = 0x0;
+  if (target == GL_ARRAY_BUFFER) {
+    known = &this->m_arrayBufferKnown;
+    bound = &this->m_arrayBuffer;
+  }
+  else if (target == GL_ELEMENT_ARRAY_BUFFER) {
+    known = &this->m_elementArrayBufferKnown;
+    bound = &this->m_elementArrayBuffer;
+  }
+
+  if (known && *known && *bound == buffer) {
+    this->avoided();
+    return;
+  }
+
+  glBindBuffer(target, buffer);
+  vesRenderStatistics::addBufferBind();
+  if (known) {
+    *known = true;
+    *bound = buffer;
+  }
+}
+
+
+void vesGLState::bindTexture(unsigned int unit, unsigned int texture)
+{
+  if (unit >= MaximumTextureUnits) {
+    glActiveTexture(GL_TEXTURE0 + unit);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    vesRenderStatistics::addTextureBind();
+    this->m_activeTextureUnitKnown = false;
+    return;
+  }
+
+  if (this->m_textureKnown[unit] && this->m_texture[unit] == texture) {
+    this->avoided();
+    return;
+  }
+
+  if (this->m_activeTextureUnitKnown && this->m_activeTextureUnit == unit) {
+    this->avoided();
+  }
+  else {
+    glActiveTexture(GL_TEXTURE0 + unit);
+    this->m_activeTextureUnitKnown = true;
+    this->m_activeTextureUnit = unit;
+  }
+
+  glBindTexture(GL_TEXTURE_2D, texture);
+  vesRenderStatistics::addTextureBind();
+  this->m_textureKnown[unit] = true;
+  this->m_texture[unit] = texture;
+}
+
+
+void vesGLState::setEnabled(unsigned int capability, bool enable)
+{
+  int *state = 0x0;
+  if (capability == GL_BLEND) {
+    state = &this->m_blend;
+  }
+  else if (capability == GL_DEPTH_TEST) {
+    state = &this->m_depthTest;
+  }
+
+  const int value = enable ? True : False;
+  if (state && *state == value) {
+    this->avoided();
+    return;
+  }
+
+  if (enable) {
+    glEnable(capability);
+  }
+  else {
+    glDisable(capability);
+  }
+
+  if (state) {
+    *state = value;
+  }
+}
+
+
+bool vesGLState::isEnabled(unsigned int capability)
+{
+  int *state = 0x0;
+  if (capability == GL_BLEND) {
+    state = &this->m_blend;
+  }
+  else if (capability == GL_DEPTH_TEST) {
+    state = &this->m_depthTest;
+  }
+
+  if (state && *state != Unknown) {
+    this->avoided();
+    return *state == True;
+  }
+
+  const bool enabled = glIsEnabled(capability) == GL_TRUE;
+  if (state) {
+    *state = enabled ? True : False;
+  }
+  return enabled;
+}
+
+
+void vesGLState::blendFunc(unsigned int source, unsigned int destination)
+{
+  if (this->m_blendFuncKnown && this->m_blendSource == source &&
+      this->m_blendDestination == destination) {
+    this->avoided();
+    return;
+  }
+
+  glBlendFunc(source, destination);
+  this->m_blendFuncKnown = true;
+  this->m_blendSource = source;
+  this->m_blendDestination = destination;
+}
+
+
+void vesGLState::depthMask(bool flag)
+{
+  const int value = flag ? True : False;
+  if (this->m_depthMask == value) {
+    this->avoided();
+    return;
+  }
+
+  glDepthMask(flag ? GL_TRUE : GL_FALSE);
+  this->m_depthMask = value;
+}
+
+
+void vesGLState::enableVertexAttribArray(unsigned int index)
+{
+  if (index >= MaximumVertexAttributes) {
+    glEnableVertexAttribArray(index);
+    return;
+  }
+
+  // Drawing from an array leaves the constant value undefined.
+  this->m_attributeValueKnown[index] = false;
+
+  if (this->m_arrays[index] == ArrayEnabled) {
+    this->avoided();
+    return;
+  }
+
+  if (this->m_arrays[index] == ArrayDisablePending) {
+    // Neither the disable nor the enable needs to be issued.
+    this->avoided();
+    this->avoided();
+  }
+  else {
+    glEnableVertexAttribArray(index);
+  }
+  this->m_arrays[index] = ArrayEnabled;
+}
+
+
+void vesGLState::disableVertexAttribArray(unsigned int index)
+{
+  if (index >= MaximumVertexAttributes) {
+    glDisableVertexAttribArray(index);
+    return;
+  }
+
+  if (this->m_arrays[index] == ArrayDisabled) {
+    this->avoided();
+    return;
+  }
+
+  if (this->m_arrays[index] != ArrayDisablePending) {
+    this->m_arrays[index] = ArrayDisablePending;
+    this->m_arrayDisablePending = true;
+  }
+}
+
+
+void vesGLState::applyVertexAttribArrays()
+{
+  if (!this->m_arrayDisablePending) {
+    return;
+  }
+
+  for (unsigned int i = 0; i < MaximumVertexAttributes; ++i) {
+    if (this->m_arrays[i] == ArrayDisablePending) {
+      glDisableVertexAttribArray(i);
+      this->m_arrays[i] = ArrayDisabled;
+    }
+  }
+  this->m_arrayDisablePending = false;
+}
+
+
+void vesGLState::vertexAttrib4fv(unsigned int index, const float *value)
+{
+  if (index < MaximumVertexAttributes) {
+    float *known = this->m_attributeValue[index];
+    if (this->m_attributeValueKnown[index] &&
+        known[0] == value[0] && known[1] == value[1] &&
+        known[2] == value[2] && known[3] == value[3]) {
+      this->avoided();
+      return;
+    }
+
+    known[0] = value[0]; known[1] = value[1];
+    known[2] = value[2]; known[3] = value[3];
+    this->m_attributeValueKnown[index] = true;
+  }
+
+  glVertexAttrib4fv(index, value);
+}
+
+
+void vesGLState::invalidate()
+{
+  this->invalidateProgram();
+  this->invalidateBuffers();
+  this->invalidateTextures();
+
+  this->m_blend = Unknown;
+  this->m_depthTest = Unknown;
+  this->m_depthMask = Unknown;
+  this->m_blendFuncKnown = false;
+
+  this->applyVertexAttribArrays();
+  for (unsigned int i = 0; i < MaximumVertexAttributes; ++i) {
+    this->m_arrays[i] = ArrayUnknown;
+    this->m_attributeValueKnown[i] = false;
+  }
+  this->m_arrayDisablePending = false;
+}
+
+
+void vesGLState::invalidateProgram()
+{
+  this->m_programKnown = false;
+}
+
+
+void vesGLState::invalidateBuffers()
+{
+  this->m_arrayBufferKnown = false;
+  this->m_elementArrayBufferKnown = false;
+}
+
+
+void vesGLState::invalidateTextures()
+{
+  this->m_activeTextureUnitKnown = false;
+  for (unsigned int i = 0; i < MaximumTextureUnits; ++i) {
+    this->m_textureKnown[i] = false;
+  }
+}
+
+
+void vesGLState::restore()
+{
+  this->applyVertexAttribArrays();
+  for (unsigned int i = 0; i < MaximumVertexAttributes; ++i) {
+    if (this->m_arrays[i] == ArrayEnabled) {
+      glDisableVertexAttribArray(i);
+      this->m_arrays[i] = ArrayDisabled;
+    }
+  }
+
+  if (this->m_arrayBufferKnown && this->m_arrayBuffer != 0) {
+    this->bindBuffer(GL_ARRAY_BUFFER, 0);
+  }
+  if (this->m_elementArrayBufferKnown && this->m_elementArrayBuffer != 0) {
+    this->bindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+  }
+}
@@ -0,0 +1,152 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+/// \class vesGLState
+/// \ingroup ves
+/// \brief Shadow of the GL state touched while rendering, filtering out
+/// calls that would not change it.
+///
+/// Every vesRenderState owns one. Materials, mappers and textures go
+/// through it to use programs, bind buffers and textures, toggle blending
+/// and depth testing and enable vertex attribute arrays, so that consecutive
+/// leaves sharing state do not submit it again. Disabling a vertex attribute
+/// array is deferred until the next draw, since the next leaf most likely
+/// enables it again.
+///
+/// The shadow starts out knowing nothing and only trusts values it has set
+/// itself, so GL calls made around it are safe as long as they happen
+/// before it is used or are followed by one of the invalidate methods.
+/// restore(), called when the render state goes away, puts back what code
+/// outside of the render states expects: no buffers bound and no vertex
+/// attribute arrays enabled.
+///
+/// \see vesRenderState vesRenderStatistics
+
+#ifndef VESGLSTATE_H
+#define VESGLSTATE_H
+
+// VES includes
+#include "vesSetGet.h"
+
+class vesGLState
+{
+public:
+  vesTypeMacro(vesGLState);
+
+  vesGLState();
+  ~vesGLState();
+
+  void useProgram(unsigned int program);
+
+  /// Bind \p buffer to GL_ARRAY_BUFFER or GL_ELEMENT_ARRAY_BUFFER.
+  void bindBuffer(unsigned int target, unsigned int buffer);
+
+  /// Bind \p texture as the GL_TEXTURE_2D of texture unit \p unit, which
+  /// becomes the active unit.
+  void bindTexture(unsigned int unit, unsigned int texture);
+
+  /// Enable or disable GL_BLEND or GL_DEPTH_TEST. Other capabilities are
+  /// passed through.
+  void setEnabled(unsigned int capability, bool enable);
+  bool isEnabled(unsigned int capability);
+
+  void blendFunc(unsigned int source, unsigned int destination);
+  void depthMask(bool flag);
+
+  void enableVertexAttribArray(unsigned int index);
+
+  /// Deferred until applyVertexAttribArrays().
+  void disableVertexAttribArray(unsigned int index);
+
+  /// Issue the deferred disables, must be called before drawing.
+  void applyVertexAttribArrays();
+
+  /// Set the constant value of a generic vertex attribute.
+  void vertexAttrib4fv(unsigned int index, const float *value);
+
+  /// Forget what is known about some or all of the state, after it was
+  /// changed behind the shadow's back.
+  void invalidate();
+  void invalidateProgram();
+  void invalidateBuffers();
+  void invalidateTextures();
+
+  /// Unbind the buffers bound through the shadow and disable the vertex
+  /// attribute arrays it enabled.
+  void restore();
+
+  /// Number of calls filtered out so far.
+  unsigned int numberOfAvoidedCalls() const { return this->m_avoidedCalls; }
+
+private:
+  enum
+  {
+    MaximumTextureUnits = 16,
+    MaximumVertexAttributes = 16
+  };
+
+  enum ArrayState
+  {
+    ArrayUnknown = 0,
+    ArrayEnabled,
+    ArrayDisabled,
+    ArrayDisablePending
+  };
+
+  enum TriState
+  {
+    Unknown = -1,
+    False = 0,
+    True = 1
+  };
+
+  void avoided();
+
+  bool m_programKnown;
+  unsigned int m_program;
+
+  bool m_arrayBufferKnown;
+  unsigned int m_arrayBuffer;
+  bool m_elementArrayBufferKnown;
+  unsigned int m_elementArrayBuffer;
+
+  bool m_activeTextureUnitKnown;
+  unsigned int m_activeTextureUnit;
+  bool m_textureKnown[MaximumTextureUnits];
+  unsigned int m_texture[MaximumTextureUnits];
+
+  int m_blend;
+  int m_depthTest;
+  int m_depthMask;
+  bool m_blendFuncKnown;
+  unsigned int m_blendSource;
+  unsigned int m_blendDestination;
+
+  ArrayState m_arrays[MaximumVertexAttributes];
+  bool m_arrayDisablePending;
+  bool m_attributeValueKnown[MaximumVertexAttributes];
+  float m_attributeValue[MaximumVertexAttributes][4];
+
+  unsigned int m_avoidedCalls;
+
+  vesGLState(const vesGLState&);     // Not implemented
+  void operator=(const vesGLState&); // Not implemented
+};
+
+#endif // VESGLSTATE_H
@@ -0,0 +1,217 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+
+#include "vesGPUTimer.h"
+
+// VES includes
+#include "vesGL.h"
+
+#if defined(ANDROID) && defined(GL_EXT_disjoint_timer_query)
+# include <EGL/egl.h>
+# define VES_GPU_TIMER_QUERY
+#endif
+
+// C/C++ includes
+#include <cstring>
+
+namespace {
+
+// Queries in flight; results usually arrive one or two frames late.
+const int numberOfQueries = 4;
+
+} // end namespace
+
+
+class vesGPUTimer::vesInternal
+{
+public:
+  vesInternal() :
+    m_checked(false),
+    m_supported(false),
+    m_next(0),
+    m_active(-1),
+    m_elapsedTime(-1.0)
+  {
+    for (int i = 0; i < numberOfQueries; ++i) {
+      this->m_queries[i] = 0;
+      this->m_pending[i] = false;
+    }
+  }
+
+  void collectResults();
+
+  bool m_checked;
+  bool m_supported;
+
+  unsigned int m_queries[numberOfQueries];
+  bool m_pending[numberOfQueries];
+  int m_next;
+  int m_active;
+
+  double m_elapsedTime;
+
+#ifdef VES_GPU_TIMER_QUERY
+  PFNGLGENQUERIESEXTPROC m_genQueries;
+  PFNGLDELETEQUERIESEXTPROC m_deleteQueries;
+  PFNGLBEGINQUERYEXTPROC m_beginQuery;
+  PFNGLENDQUERYEXTPROC m_endQuery;
+  PFNGLGETQUERYOBJECTUIVEXTPROC m_getQueryObjectuiv;
+  PFNGLGETQUERYOBJECTUI64VEXTPROC m_getQueryObjectui64v;
+#endif
+};
+
+
+void vesGPUTimer::vesInternal::collectResults()
+{
+#ifdef VES_GPU_TIMER_QUERY
+  // A disjoint operation invalidates every measurement in flight.
+  GLint disjoint = 0;
+  glGetIntegerv(GL_GPU_DISJOINT_EXT, &disjoint);
+
+  // Oldest query first, so the newest result wins.
+  for (int i = 0; i < numberOfQueries; ++i) {
+    int index = (this->m_next + i) % numberOfQueries;
+    if (!this->m_pending[index] || index == this->m_active) {
+      continue;
+    }
+
+    GLuint available = 0;
+    this->m_getQueryObjectuiv(this->m_queries[index],
+                              GL_QUERY_RESULT_AVAILABLE_EXT, &available);
+    if (!available && !disjoint) {
+      continue;
+    }
+
+    if (!disjoint) {
+      GLuint64 nanoseconds = 0;
+      this->m_getQueryObjectui64v(this->m_queries[index],
+                                  GL_QUERY_RESULT_EXT, &nanoseconds);
+      this->m_elapsedTime = nanoseconds * 1e-9;
+    }
+    this->m_pending[index] = false;
+  }
+#endif
+}
+
+
+vesGPUTimer::vesGPUTimer()
+{
+  this->m_internal = new vesInternal();
+}
+
+
+vesGPUTimer::~vesGPUTimer()
+{
+#ifdef VES_GPU_TIMER_QUERY
+  if (this->m_internal->m_supported) {
+    this->m_internal->m_deleteQueries(numberOfQueries,
+                                      this->m_internal->m_queries);
+  }
+#endif
+
+  delete this->m_internal; this->m_internal = 0x0;
+}
+
+
+bool vesGPUTimer::isSupported()
+{
+  vesInternal *internal = this->m_internal;
+  if (internal->m_checked) {
+    return internal->m_supported;
+  }
+  internal->m_checked = true;
+
+#ifdef VES_GPU_TIMER_QUERY
+  const char *extensions =
+    reinterpret_cast<const char*>(glGetString(GL_EXTENSIONS));
+  if (!extensions || !strstr(extensions, "GL_EXT_disjoint_timer_query")) {
+    return false;
+  }
+
+  internal->m_genQueries = reinterpret_cast<PFNGLGENQUERIESEXTPROC>(
+    eglGetProcAddress("glGenQueriesEXT"));
+  internal->m_deleteQueries = reinterpret_cast<PFNGLDELETEQUERIESEXTPROC>(
+    eglGetProcAddress("glDeleteQueriesEXT"));
+  internal->m_beginQuery = reinterpret_cast<PFNGLBEGINQUERYEXTPROC>(
+    eglGetProcAddress("glBeginQueryEXT"));
+  internal->m_endQuery = reinterpret_cast<PFNGLENDQUERYEXTPROC>(
+    eglGetProcAddress("glEndQueryEXT"));
+  internal->m_getQueryObjectuiv =
+    reinterpret_cast<PFNGLGETQUERYOBJECTUIVEXTPROC>(
+      eglGetProcAddress("glGetQueryObjectuivEXT"));
+  internal->m_getQueryObjectui64v =
+    reinterpret_cast<PFNGLGETQUERYOBJECTUI64VEXTPROC>(
+      eglGetProcAddress("glGetQueryObjectui64vEXT"));
+
+  if (!internal->m_genQueries || !internal->m_deleteQueries ||
+      !internal->m_beginQuery || !internal->m_endQuery ||
+      !internal->m_getQueryObjectuiv || !internal->m_getQueryObjectui64v) {
+    return false;
+  }
+
+  internal->m_genQueries(numberOfQueries, internal->m_queries);
+  internal->m_supported = true;
+#endif
+
+  return internal->m_supported;
+}
+
+
+void vesGPUTimer::begin()
+{
+  vesInternal *internal = this->m_internal;
+  if (!this->isSupported() || internal->m_active >= 0) {
+    return;
+  }
+
+  internal->collectResults();
+
+#ifdef VES_GPU_TIMER_QUERY
+  if (internal->m_pending[internal->m_next]) {
+    return;
+  }
+
+  internal->m_active = internal->m_next;
+  internal->m_next = (internal->m_next + 1) % numberOfQueries;
+  internal->m_beginQuery(GL_TIME_ELAPSED_EXT,
+                         internal->m_queries[internal->m_active]);
+#endif
+}
+
+
+void vesGPUTimer::end()
+{
+  vesInternal *internal = this->m_internal;
+  if (internal->m_active < 0) {
+    return;
+  }
+
+#ifdef VES_GPU_TIMER_QUERY
+  internal->m_endQuery(GL_TIME_ELAPSED_EXT);
+#endif
+  internal->m_pending[internal->m_active] = true;
+  internal->m_active = -1;
+}
+
+
+double vesGPUTimer::elapsedTime() const
+{
+  return this->m_internal->m_elapsedTime;
+}
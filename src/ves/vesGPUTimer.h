@@ -0,0 +1,66 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+/// \class vesGPUTimer
+/// \ingroup ves
+/// \brief Measures the GPU time of a span of GL commands.
+///
+/// Uses EXT_disjoint_timer_query. Results are read back only once the GPU
+/// reports them as available, so elapsedTime() lags a few frames behind
+/// and the pipeline is never stalled. Measurements the driver flags as
+/// disjoint, e.g. because of a frequency change, are dropped.
+///
+/// All methods must be called with the GL context current.
+///
+/// \see vesRenderStatistics
+
+#ifndef VESGPUTIMER_H
+#define VESGPUTIMER_H
+
+// VES includes
+#include "vesSetGet.h"
+
+class vesGPUTimer
+{
+public:
+  vesTypeMacro(vesGPUTimer);
+
+  vesGPUTimer();
+  ~vesGPUTimer();
+
+  /// Return true if the context supports timer queries.
+  bool isSupported();
+
+  /// Start timing the commands issued until end(). Does nothing if timer
+  /// queries are not supported or all queries are still in flight.
+  void begin();
+  void end();
+
+  /// Last measured time in seconds, or a negative value if none.
+  double elapsedTime() const;
+
+private:
+  vesGPUTimer(const vesGPUTimer&); // Not implemented
+  void operator=(const vesGPUTimer&); // Not implemented
+
+  class vesInternal;
+  vesInternal *m_internal;
+};
+
+#endif // VESGPUTIMER_H
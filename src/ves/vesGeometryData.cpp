@@ -1,11 +1,433 @@
 
 #include "vesGeometryData.h"
 
+#include "vesMutex.h"
+#include "vesObject.h"
+
 #include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <unistd.h>
+
+namespace {
+
+// Run length coding of a byte array: a header byte below 128 is followed by
+// that many plus one literal bytes, a header byte h of 128 and above by one
+// byte repeated h - 126 times.
+void appendRunLength(const std::vector<unsigned char> &in,
+                     std::vector<unsigned char> &out)
+{
+  const size_t size = in.size();
+  size_t i = 0;
+  while (i < size) {
+    size_t run = 1;
+    while (i + run < size && run < 129 && in[i + run] == in[i]) {
+      ++run;
+    }
+
+    if (run > 1) {
+      out.push_back(static_cast<unsigned char>(126 + run));
+      out.push_back(in[i]);
+      i += run;
+      continue;
+    }
+
+    const size_t start = i;
+    while (i < size && i - start < 128 &&
+           !(i + 1 < size && in[i + 1] == in[i])) {
+      ++i;
+    }
+    out.push_back(static_cast<unsigned char>(i - start - 1));
+    out.insert(out.end(), in.begin() + start, in.begin() + i);
+  }
+}
+
+bool decodeRunLength(const unsigned char *&in, const unsigned char *end,
+                     unsigned char *out, size_t size)
+{
+  size_t i = 0;
+  while (i < size && in < end) {
+    const unsigned int header = *in++;
+    if (header >= 128) {
+      const size_t run = header - 126;
+      if (in == end || i + run > size) {
+        return false;
+      }
+      memset(out + i, *in++, run);
+      i += run;
+    }
+    else {
+      const size_t length = header + 1;
+      if (in + length > end || i + length > size) {
+        return false;
+      }
+      memcpy(out + i, in, length);
+      in += length;
+      i += length;
+    }
+  }
+  return i == size;
+}
+
+// Vertex arrays are stored one plane per byte position in the element,
+// each byte as the difference to the same byte of the previous element.
+// On smooth meshes the high bytes of neighbouring vertices mostly agree,
+// which leaves long runs of zeros.
+void encodeElements(const unsigned char *data, unsigned int count,
+                    unsigned int elementSize, std::vector<unsigned char> &out)
+{
+  std::vector<unsigned char> planes(static_cast<size_t>(count) * elementSize);
+  for (unsigned int b = 0; b < elementSize; ++b) {
+    unsigned char previous = 0;
+    unsigned char *plane = &planes[0] + static_cast<size_t>(b) * count;
+    for (unsigned int i = 0; i < count; ++i) {
+      const unsigned char value = data[static_cast<size_t>(i) * elementSize + b];
+      plane[i] = static_cast<unsigned char>(value - previous);
+      previous = value;
+    }
+  }
+  appendRunLength(planes, out);
+}
+
+bool decodeElements(const unsigned char *&in, const unsigned char *end,
+                    unsigned char *data, unsigned int count,
+                    unsigned int elementSize)
+{
+  std::vector<unsigned char> planes(static_cast<size_t>(count) * elementSize);
+  if (!decodeRunLength(in, end, &planes[0], planes.size())) {
+    return false;
+  }
+
+  for (unsigned int b = 0; b < elementSize; ++b) {
+    unsigned char value = 0;
+    const unsigned char *plane = &planes[0] + static_cast<size_t>(b) * count;
+    for (unsigned int i = 0; i < count; ++i) {
+      value = static_cast<unsigned char>(value + plane[i]);
+      data[static_cast<size_t>(i) * elementSize + b] = value;
+    }
+  }
+  return true;
+}
+
+// Indices are stored as the zigzag coded difference to the previous index,
+// seven bits per byte, which takes one byte for most of them.
+void encodeIndices(const std::vector<unsigned short> &indices,
+                   std::vector<unsigned char> &out)
+{
+  int previous = 0;
+  for (size_t i = 0; i < indices.size(); ++i) {
+    const int delta = static_cast<int>(indices[i]) - previous;
+    unsigned int value = delta < 0 ? ((-delta) << 1) - 1 : delta << 1;
+    while (value >= 0x80) {
+      out.push_back(static_cast<unsigned char>(value | 0x80));
+      value >>= 7;
+    }
+    out.push_back(static_cast<unsigned char>(value));
+    previous = indices[i];
+  }
+}
+
+bool decodeIndices(const unsigned char *&in, const unsigned char *end,
+                   std::vector<unsigned short> &indices)
+{
+  int previous = 0;
+  for (size_t i = 0; i < indices.size(); ++i) {
+    unsigned int value = 0;
+    int shift = 0;
+    do {
+      if (in == end || shift > 21) {
+        return false;
+      }
+      value |= static_cast<unsigned int>(*in & 0x7f) << shift;
+      shift += 7;
+    } while (*in++ & 0x80);
+
+    const int delta = (value & 1) ? -static_cast<int>((value + 1) >> 1)
+                                  : static_cast<int>(value >> 1);
+    previous += delta;
+    indices[i] = static_cast<unsigned short>(previous);
+  }
+  return true;
+}
+
+} // end namespace
+
+
+class vesGeometryData::vesResidency
+{
+public:
+  vesResidency() :
+    m_resident(true),
+    m_archived(false),
+    m_lockCount(0)
+  {
+  }
+
+  ~vesResidency()
+  {
+    if (!this->m_fileName.empty()) {
+      remove(this->m_fileName.c_str());
+    }
+  }
+
+  bool archive(vesGeometryData &data, const std::string &cacheDirectory);
+  bool writeFile(vesGeometryData &data, const std::string &cacheDirectory);
+  bool restore(vesGeometryData &data);
+  bool readFile(vesGeometryData &data);
+  bool decompress(vesGeometryData &data);
+
+  vesMutex m_mutex;
+  bool m_resident;
+  bool m_archived;
+  int m_lockCount;
+
+  std::vector<unsigned int> m_sourceSizes;
+  std::vector<unsigned int> m_primitiveSizes;
+
+  // Either the file holding the arrays or their compressed content.
+  std::string m_fileName;
+  std::vector<unsigned char> m_compressed;
+};
+
+
+bool vesGeometryData::vesResidency::archive(vesGeometryData &data,
+                                            const std::string &cacheDirectory)
+{
+  this->m_sourceSizes.clear();
+  for (size_t i = 0; i < data.m_sources.size(); ++i) {
+    this->m_sourceSizes.push_back(data.m_sources[i]->sizeOfArray());
+  }
+  this->m_primitiveSizes.clear();
+  for (size_t i = 0; i < data.m_primitives.size(); ++i) {
+    this->m_primitiveSizes.push_back(data.m_primitives[i]->numberOfIndices());
+  }
+
+  if (!cacheDirectory.empty() && this->writeFile(data, cacheDirectory)) {
+    this->m_archived = true;
+    return true;
+  }
+
+  this->m_compressed.clear();
+  for (size_t i = 0; i < data.m_sources.size(); ++i) {
+    if (this->m_sourceSizes[i]) {
+      encodeElements(static_cast<unsigned char*>(data.m_sources[i]->data()),
+                     this->m_sourceSizes[i],
+                     data.m_sources[i]->sizeOfElement(), this->m_compressed);
+    }
+  }
+  for (size_t i = 0; i < data.m_primitives.size(); ++i) {
+    encodeIndices(*data.m_primitives[i]->indices(), this->m_compressed);
+  }
+  std::vector<unsigned char>(this->m_compressed).swap(this->m_compressed);
+
+  this->m_archived = true;
+  return true;
+}
+
+
+bool vesGeometryData::vesResidency::writeFile(vesGeometryData &data,
+                                              const std::string &cacheDirectory)
+{
+  static unsigned int counter = 0;
+  char name[64];
+  sprintf(name, "/vesGeometryData-%d-%u.bin", static_cast<int>(getpid()),
+          __sync_add_and_fetch(&counter, 1));
+  const std::string fileName = cacheDirectory + name;
+
+  FILE *file = fopen(fileName.c_str(), "wb");
+  if (!file) {
+    return false;
+  }
+
+  bool success = true;
+  for (size_t i = 0; i < data.m_sources.size() && success; ++i) {
+    const size_t size = static_cast<size_t>(this->m_sourceSizes[i]) *
+      data.m_sources[i]->sizeOfElement();
+    success = !size || fwrite(data.m_sources[i]->data(), 1, size, file) == size;
+  }
+  for (size_t i = 0; i < data.m_primitives.size() && success; ++i) {
+    const size_t size = data.m_primitives[i]->sizeInBytes();
+    success = !size || fwrite(data.m_primitives[i]->data(), 1, size, file) == size;
+  }
+
+  if (fclose(file) != 0 || !success) {
+    remove(fileName.c_str());
+    return false;
+  }
+
+  this->m_fileName = fileName;
+  return true;
+}
+
+
+bool vesGeometryData::vesResidency::restore(vesGeometryData &data)
+{
+  for (size_t i = 0; i < data.m_sources.size(); ++i) {
+    data.m_sources[i]->resize(this->m_sourceSizes[i]);
+  }
+  for (size_t i = 0; i < data.m_primitives.size(); ++i) {
+    data.m_primitives[i]->indices()->resize(this->m_primitiveSizes[i]);
+  }
+
+  return this->m_fileName.empty() ? this->decompress(data)
+                                  : this->readFile(data);
+}
+
+
+bool vesGeometryData::vesResidency::readFile(vesGeometryData &data)
+{
+  FILE *file = fopen(this->m_fileName.c_str(), "rb");
+  if (!file) {
+    return false;
+  }
+
+  bool success = true;
+  for (size_t i = 0; i < data.m_sources.size() && success; ++i) {
+    const size_t size = static_cast<size_t>(this->m_sourceSizes[i]) *
+      data.m_sources[i]->sizeOfElement();
+    success = !size || fread(data.m_sources[i]->data(), 1, size, file) == size;
+  }
+  for (size_t i = 0; i < data.m_primitives.size() && success; ++i) {
+    const size_t size = data.m_primitives[i]->sizeInBytes();
+    success = !size || fread(data.m_primitives[i]->data(), 1, size, file) == size;
+  }
+
+  fclose(file);
+  return success;
+}
+
+
+bool vesGeometryData::vesResidency::decompress(vesGeometryData &data)
+{
+  const unsigned char *in = this->m_compressed.empty() ? 0x0 : &this->m_compressed[0];
+  const unsigned char *end = in + this->m_compressed.size();
+
+  for (size_t i = 0; i < data.m_sources.size(); ++i) {
+    if (this->m_sourceSizes[i] &&
+        !decodeElements(in, end,
+                        static_cast<unsigned char*>(data.m_sources[i]->data()),
+                        this->m_sourceSizes[i],
+                        data.m_sources[i]->sizeOfElement())) {
+      return false;
+    }
+  }
+  for (size_t i = 0; i < data.m_primitives.size(); ++i) {
+    if (!decodeIndices(in, end, *data.m_primitives[i]->indices())) {
+      return false;
+    }
+  }
+  return true;
+}
+
+
+vesGeometryData::vesGeometryData() :
+  m_residency(new vesResidency()),
+  m_computeBounds(true),
+  m_computeNormals(true),
+  m_dataVersion(0)
+{
+}
+
+
+vesGeometryData::~vesGeometryData()
+{
+  delete this->m_residency;
+}
+
+
+bool vesGeometryData::releaseData(const std::string &cacheDirectory)
+{
+  // Keep what is computed from the arrays.
+  this->computeBounds();
+
+  vesMutexLocker locker(this->m_residency->m_mutex);
+  if (!this->m_residency->m_resident) {
+    return true;
+  }
+
+  if (this->m_residency->m_lockCount > 0) {
+    return false;
+  }
+
+  if (!this->m_residency->m_archived &&
+      !this->m_residency->archive(*this, cacheDirectory)) {
+    return false;
+  }
+
+  for (size_t i = 0; i < this->m_sources.size(); ++i) {
+    this->m_sources[i]->clear();
+  }
+  for (size_t i = 0; i < this->m_primitives.size(); ++i) {
+    vesPrimitive::Indices().swap(*this->m_primitives[i]->indices());
+  }
+
+  this->m_residency->m_resident = false;
+  return true;
+}
+
+
+bool vesGeometryData::makeResident()
+{
+  vesMutexLocker locker(this->m_residency->m_mutex);
+  if (this->m_residency->m_resident) {
+    return true;
+  }
+
+  if (!this->m_residency->restore(*this)) {
+    return false;
+  }
+
+  this->m_residency->m_resident = true;
+  return true;
+}
+
+
+bool vesGeometryData::isResident() const
+{
+  vesMutexLocker locker(this->m_residency->m_mutex);
+  return this->m_residency->m_resident;
+}
+
+
+bool vesGeometryData::lockData()
+{
+  vesMutexLocker locker(this->m_residency->m_mutex);
+  if (!this->m_residency->m_resident) {
+    if (!this->m_residency->restore(*this)) {
+      return false;
+    }
+    this->m_residency->m_resident = true;
+  }
+
+  ++this->m_residency->m_lockCount;
+  return true;
+}
+
+
+void vesGeometryData::unlockData()
+{
+  vesMutexLocker locker(this->m_residency->m_mutex);
+  assert(this->m_residency->m_lockCount > 0);
+  --this->m_residency->m_lockCount;
+}
+
+
+void vesGeometryData::setDataModified()
+{
+  vesMutexLocker locker(this->m_residency->m_mutex);
+  this->m_residency->m_archived = false;
+  this->m_computeBounds = true;
+  ++this->m_dataVersion;
+  vesObject::modified();
+}
+
 
 void vesGeometryData::computeBounds()
 {
-  if (!this->m_computeBounds)
+  // A pipelined renderer computes bounds on its cull thread, while the
+  // rendering thread may release the arrays.
+  vesMutexLocker locker(this->m_residency->m_mutex);
+  if (!this->m_computeBounds || !this->m_residency->m_resident)
   {
     return;
   }
@@ -57,11 +57,8 @@ public:
 
   vesTypeMacro(vesGeometryData);
 
-  vesGeometryData() :
-    m_computeBounds(true),
-    m_computeNormals(true)
-  {
-  }
+  vesGeometryData();
+  ~vesGeometryData();
 
   /// Get name / ID of the geometry data
   inline std::string name()
@@ -189,7 +186,42 @@ public:
   /// Return source data given a key. Return NULL on failure.
   inline vesSharedPtr<vesSourceData> sourceData(int key);
 
+  /// Free the vertex and index arrays, e.g. once they are uploaded. The
+  /// attribute layout and the bounds are kept. The content is written to a
+  /// file in \p cacheDirectory, or compressed in memory if no directory is
+  /// given or the file cannot be written, and makeResident() brings it
+  /// back. The data must not be modified after it was first released.
+  /// Return false, releasing nothing, while the data is locked.
+  bool releaseData(const std::string &cacheDirectory=std::string());
+
+  /// Restore the arrays freed by releaseData(). Return false on failure.
+  bool makeResident();
+
+  /// Return true unless the arrays are released.
+  bool isResident() const;
+
+  /// Make the arrays resident and keep them so until unlockData(). Use it
+  /// to read the arrays from threads other than the render thread.
+  bool lockData();
+  void unlockData();
+
+  /// Call after editing the sources or primitives in place, e.g. resizing
+  /// them and overwriting their arrays. The bounds are computed again and
+  /// mappers upload the arrays into their existing buffers at the next
+  /// render, reallocating only the buffers that became too small.
+  void setDataModified();
+
+  /// Incremented by setDataModified(). Compare two values to find out if
+  /// the arrays changed in between.
+  unsigned int dataVersion() const { return this->m_dataVersion; }
+
 private:
+  class vesResidency;
+  vesResidency *m_residency;
+
+  vesGeometryData(const vesGeometryData&); // Not implemented
+  void operator=(const vesGeometryData&);  // Not implemented
+
   void addAndUpdateNormal(unsigned int index, float n1, float n2, float n3,
                           void *data, unsigned int stride, unsigned int offset,
                           unsigned int sizeOfDataType);
@@ -204,6 +236,8 @@ private:
   bool m_computeBounds;
   bool m_computeNormals;
 
+  unsigned int m_dataVersion;
+
   vesVector3f m_boundsMin;
   vesVector3f m_boundsMax;
 };
@@ -23,6 +23,12 @@
 // VES includes.
 #include "vesVisitor.h"
 
+namespace {
+
+unsigned int groupNodeStructureVersion = 0;
+
+} // end namespace
+
 vesGroupNode::vesGroupNode() : vesNode()
 {
 }
@@ -53,6 +59,9 @@ bool vesGroupNode::addChild(vesSharedPtr<vesNode> child)
 
   this->setBoundsDirty(true);
 
+  ++groupNodeStructureVersion;
+  vesObject::modified();
+
   return true;
 }
 
@@ -73,6 +82,9 @@ bool vesGroupNode::removeChild(vesSharedPtr<vesNode> child)
 
     this->setBoundsDirty(true);
 
+    ++groupNodeStructureVersion;
+    vesObject::modified();
+
     return true;
   }
 
@@ -105,6 +117,9 @@ bool vesGroupNode::removeChild(vesNode *child)
 
     this->setBoundsDirty(true);
 
+    ++groupNodeStructureVersion;
+    vesObject::modified();
+
     return true;
   }
 
@@ -112,6 +127,12 @@ bool vesGroupNode::removeChild(vesNode *child)
 }
 
 
+unsigned int vesGroupNode::structureVersion()
+{
+  return groupNodeStructureVersion;
+}
+
+
 void vesGroupNode::accept(vesVisitor &visitor)
 {
   visitor.visit(*this);
@@ -56,16 +56,26 @@ public:
   bool removeChild(vesSharedPtr<vesNode> child);
   bool removeChild(vesNode *child);
 
-  /// Return list of child nodes
+  /// Return list of child nodes. Children added or removed through this
+  /// list directly do not change structureVersion().
   Children&       children()       { return this->m_children; }
   const Children& children() const { return this->m_children; }
 
+  /// \copydoc vesNode::asGroupNode()
+  virtual vesGroupNode* asGroupNode() { return this; }
+  virtual const vesGroupNode* asGroupNode() const { return this; }
+
   /// \copydoc vesNode::accept(vesVisitor&)
   virtual void accept(vesVisitor &visitor);
 
   /// \copydoc vesNode::traverse(vesVisitor&)
   virtual void traverse(vesVisitor &visitor);
 
+  /// Return a counter that changes whenever a child is added to or removed
+  /// from any group node. Lets flattened copies of a scene, such as
+  /// vesSceneStore, notice that they are outdated.
+  static unsigned int structureVersion();
+
 protected:
   void traverseChildrenAndUpdateBounds(vesVisitor &visitor);
   void traverseChildren(vesVisitor &visitor);
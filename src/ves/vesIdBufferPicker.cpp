@@ -0,0 +1,218 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+
+#include "vesIdBufferPicker.h"
+
+// VES includes
+#include "vesColorUniform.h"
+#include "vesDepth.h"
+#include "vesFBO.h"
+#include "vesGL.h"
+#include "vesMapper.h"
+#include "vesMaterial.h"
+#include "vesModelViewUniform.h"
+#include "vesProjectionUniform.h"
+#include "vesRenderStage.h"
+#include "vesRenderState.h"
+#include "vesShader.h"
+#include "vesShaderProgram.h"
+#include "vesVertexAttribute.h"
+#include "vesVertexAttributeKeys.h"
+#include "vesViewport.h"
+
+// C/C++ includes
+#include <algorithm>
+
+namespace {
+
+// The framebuffer object defaults to a RGB565 color buffer, which holds
+// 16 bit ids exactly.
+const unsigned int MaximumId = 0xFFFF;
+
+vesVector4f encodeId(unsigned int id)
+{
+  return vesVector4f(((id >> 11) & 0x1F) / 31.0f,
+                     ((id >> 5) & 0x3F) / 63.0f,
+                     (id & 0x1F) / 31.0f,
+                     1.0f);
+}
+
+unsigned int decodeId(const unsigned char pixel[4])
+{
+  const unsigned int r = (pixel[0] * 31 + 127) / 255;
+  const unsigned int g = (pixel[1] * 63 + 127) / 255;
+  const unsigned int b = (pixel[2] * 31 + 127) / 255;
+  return (r << 11) | (g << 5) | b;
+}
+
+} // end namespace
+
+
+class vesIdBufferPicker::vesInternal
+{
+public:
+  vesInternal() :
+    m_fbo(new vesFBO()),
+    m_material(new vesMaterial()),
+    m_shaderProgram(new vesShaderProgram()),
+    m_vertexShader(new vesShader(vesShader::Vertex)),
+    m_fragmentShader(new vesShader(vesShader::Fragment)),
+    m_modelViewUniform(new vesModelViewUniform()),
+    m_projectionUniform(new vesProjectionUniform()),
+    m_idUniform(new vesColorUniform("pickId")),
+    m_positionVertexAttribute(new vesPositionVertexAttribute()),
+    m_depth(new vesDepth())
+  {
+    this->m_fbo->setWidth(1);
+    this->m_fbo->setHeight(1);
+
+    const std::string vertexShaderSource =
+      "uniform highp mat4 modelViewMatrix;\n \
+       uniform highp mat4 projectionMatrix;\n \
+       attribute highp vec4 vertexPosition;\n \
+       void main()\n \
+       {\n \
+         gl_Position = projectionMatrix * modelViewMatrix * vertexPosition;\n \
+         gl_PointSize = 1.0;\n \
+       }";
+
+    const std::string fragmentShaderSource =
+      "uniform mediump vec4 pickId;\n \
+       void main()\n \
+       {\n \
+         gl_FragColor = pickId;\n \
+       }";
+
+    this->m_vertexShader->setShaderSource(vertexShaderSource);
+    this->m_fragmentShader->setShaderSource(fragmentShaderSource);
+
+    this->m_shaderProgram->addShader(this->m_vertexShader);
+    this->m_shaderProgram->addShader(this->m_fragmentShader);
+    this->m_shaderProgram->addUniform(this->m_modelViewUniform);
+    this->m_shaderProgram->addUniform(this->m_projectionUniform);
+    this->m_shaderProgram->addUniform(this->m_idUniform);
+    this->m_shaderProgram->addVertexAttribute(this->m_positionVertexAttribute,
+                                              vesVertexAttributeKeys::Position);
+
+    this->m_material->addAttribute(this->m_shaderProgram);
+    this->m_material->addAttribute(this->m_depth);
+  }
+
+  vesSharedPtr<vesFBO> m_fbo;
+  vesSharedPtr<vesMaterial> m_material;
+  vesSharedPtr<vesShaderProgram> m_shaderProgram;
+  vesSharedPtr<vesShader> m_vertexShader;
+  vesSharedPtr<vesShader> m_fragmentShader;
+  vesSharedPtr<vesModelViewUniform> m_modelViewUniform;
+  vesSharedPtr<vesProjectionUniform> m_projectionUniform;
+  vesSharedPtr<vesColorUniform> m_idUniform;
+  vesSharedPtr<vesPositionVertexAttribute> m_positionVertexAttribute;
+  vesSharedPtr<vesDepth> m_depth;
+
+  /// Actors in id order, id 0 is the background.
+  std::vector<const vesActor*> m_actors;
+};
+
+
+vesIdBufferPicker::vesIdBufferPicker()
+{
+  this->m_internal = new vesInternal();
+}
+
+
+vesIdBufferPicker::~vesIdBufferPicker()
+{
+  delete this->m_internal; this->m_internal = 0x0;
+}
+
+
+const vesActor* vesIdBufferPicker::pick(const vesRenderStage &renderStage,
+                                        int x, int y,
+                                        const std::vector<const vesActor*> &actors)
+{
+  const vesSharedPtr<vesViewport> viewport = renderStage.viewport();
+  if (!viewport || x < 0 || y < 0 ||
+      x >= viewport->width() || y >= viewport->height()) {
+    return 0x0;
+  }
+
+  GLint previousFrameBuffer = 0;
+  glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previousFrameBuffer);
+  const GLboolean blendWasEnabled = glIsEnabled(GL_BLEND);
+
+  vesRenderState renderState;
+  this->m_internal->m_fbo->render(renderState);
+
+  // Shift the viewport so the pick position lands on the only pixel.
+  glViewport(viewport->x() - x, viewport->y() - y,
+             viewport->width(), viewport->height());
+  glDisable(GL_BLEND);
+  glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+  glClearDepthf(1.0f);
+  glDepthMask(GL_TRUE);
+  glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+  this->m_internal->m_actors.assign(1, static_cast<const vesActor*>(0x0));
+  const vesSharedPtr<vesMaterial> &material = this->m_internal->m_material;
+  renderState.applyMaterial(material.get());
+
+  const vesRenderStage::BinRenderLeavesMap &bins = renderStage.binRenderLeaves();
+  vesRenderStage::BinRenderLeavesMap::const_iterator binItr = bins.begin();
+  for (; binItr != bins.end(); ++binItr) {
+    vesRenderStage::RenderLeaves::const_iterator leafItr = binItr->second.begin();
+    for (; leafItr != binItr->second.end(); ++leafItr) {
+      const vesRenderLeaf &leaf = *leafItr;
+      if (!leaf.m_actor || !leaf.m_mapper || !leaf.m_mapper->geometryData() ||
+          this->m_internal->m_actors.size() > MaximumId) {
+        continue;
+      }
+      if (!actors.empty() &&
+          std::find(actors.begin(), actors.end(), leaf.m_actor) == actors.end()) {
+        continue;
+      }
+
+      this->m_internal->m_idUniform->set(
+        encodeId(static_cast<unsigned int>(this->m_internal->m_actors.size())));
+      this->m_internal->m_actors.push_back(leaf.m_actor);
+
+      // The mapper looks at the bin to draw overlays without depth test.
+      material->setBinNumber(leaf.m_bin);
+
+      renderState.applyProjectionMatrix(leaf.m_projectionMatrix);
+      renderState.applyModelViewMatrix(leaf.m_modelViewMatrix);
+      renderState.applyMapper(leaf.m_mapper);
+
+      material->render(renderState);
+      leaf.m_mapper->render(renderState);
+    }
+  }
+  material->remove(renderState);
+
+  unsigned char pixel[4] = {0, 0, 0, 0};
+  glReadPixels(0, 0, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, pixel);
+
+  glBindFramebuffer(GL_FRAMEBUFFER, previousFrameBuffer);
+  if (blendWasEnabled) {
+    glEnable(GL_BLEND);
+  }
+
+  const unsigned int id = decodeId(pixel);
+  return id < this->m_internal->m_actors.size() ? this->m_internal->m_actors[id] : 0x0;
+}
@@ -0,0 +1,73 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+/// \class vesIdBufferPicker
+/// \ingroup ves
+/// \brief Picks actors by rendering their ids offscreen.
+///
+/// The render leaves of a culled render stage are drawn into a one pixel
+/// framebuffer object placed under the pick position, each actor in a
+/// flat color encoding its id, and the single pixel is read back. The cost
+/// does not depend on the number of triangles and anything the mappers can
+/// draw, points and overlays included, can be picked. Nothing is rendered
+/// unless a pick is requested.
+///
+/// The ids are drawn with their own shader, so shader effects that discard
+/// fragments, such as clip planes, are not taken into account.
+///
+/// \see vesRenderer::pickActor vesFBO
+
+#ifndef VESIDBUFFERPICKER_H
+#define VESIDBUFFERPICKER_H
+
+// VES includes
+#include "vesSetGet.h"
+
+// C/C++ includes
+#include <vector>
+
+// Forward declarations
+class vesActor;
+class vesRenderStage;
+
+class vesIdBufferPicker
+{
+public:
+  vesTypeMacro(vesIdBufferPicker);
+
+  vesIdBufferPicker();
+  ~vesIdBufferPicker();
+
+  /// Return the front most actor drawn by the render stage at the display
+  /// position, with the origin at the bottom left of the viewport, or 0x0.
+  /// If \p actors is not empty, only those actors are drawn and can hide
+  /// each other. Needs a current GL context; the framebuffer binding is
+  /// restored afterwards.
+  const vesActor* pick(const vesRenderStage &renderStage, int x, int y,
+                       const std::vector<const vesActor*> &actors);
+
+private:
+  class vesInternal;
+  vesInternal *m_internal;
+
+  vesIdBufferPicker(const vesIdBufferPicker&); // Not implemented
+  void operator=(const vesIdBufferPicker&);    // Not implemented
+};
+
+#endif // VESIDBUFFERPICKER_H
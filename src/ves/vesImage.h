@@ -40,7 +40,8 @@ public:
     m_depth(0),
     m_pixelFormat(vesColorDataType::PixelFormatNone),
     m_pixelDataType(vesColorDataType::PixelDataTypeNone),
-    m_data(0x0)
+    m_data(0x0),
+    m_dataSize(0)
   {
   }
 
@@ -117,12 +118,25 @@ public:
     return retval;
     }
 
+  /// Allocate \p size bytes of pixel data, left uninitialized for the
+  /// caller to fill through data()
+  inline bool allocateData(unsigned int size)
+    {
+    return this->allocate(size);
+    }
+
   /// Get pixel data
   void* data() const
     {
     return this->m_data;
     }
 
+  /// Get size of the pixel data in bytes
+  unsigned int dataSize() const
+    {
+    return this->m_dataSize;
+    }
+
 protected:
   int m_width;
   int m_height;
@@ -132,6 +146,7 @@ protected:
   vesColorDataType::PixelDataType m_pixelDataType;
 
   void *m_data;
+  unsigned int m_dataSize;
 
   inline bool allocate(unsigned int size)
     {
@@ -142,6 +157,7 @@ protected:
     this->m_data = malloc(size);
 
     if (this->m_data) {
+      this->m_dataSize = size;
       return true;
       }
 
@@ -152,6 +168,8 @@ protected:
     {
     if (this->m_data) {
       free(this->m_data);
+      this->m_data = 0x0;
+      this->m_dataSize = 0;
       }
     }
 };
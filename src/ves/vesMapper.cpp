@@ -23,24 +23,112 @@
 
 // VES includes
 #include "vesMaterial.h"
+#include "vesObject.h"
 #include "vesGeometryData.h"
+#include "vesGLState.h"
 #include "vesGLTypes.h"
 #include "vesRenderData.h"
 #include "vesRenderStage.h"
+#include "vesRenderStatistics.h"
 #include "vesShaderProgram.h"
+#include "vesTriangleSorter.h"
 #include "vesVertexAttributeKeys.h"
 
 #include "vesGL.h"
 
 // C++ includes
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
 #include <map>
 #include <vector>
-#include <cstdio>
+
+namespace {
+
+// Incremented by vesMapper::graphicsContextLost(). Buffers created for an
+// older value belong to a lost context.
+unsigned int contextGeneration = 0;
+
+// GPU buffers holding the uploaded content of one geometry data. Mappers
+// rendering the same geometry data share a single set of buffers.
+class vesBufferObjects
+{
+public:
+  vesBufferObjects() :
+    m_numberOfVertices(0),
+    m_dataVersion(0),
+    m_contextGeneration(contextGeneration)
+  {
+  }
+
+  ~vesBufferObjects()
+  {
+    if (!this->m_buffers.empty() && this->isCurrent()) {
+      glDeleteBuffers(this->m_buffers.size(), &this->m_buffers.front());
+    }
+  }
+
+  bool isCurrent() const
+  {
+    return this->m_contextGeneration == contextGeneration;
+  }
+
+  std::vector< unsigned int >                m_buffers;
+  std::vector< unsigned int >                m_bufferSizes;
+  std::map< unsigned int, std::vector<int> > m_bufferVertexAttributeMap;
+
+  // What was uploaded, for drawing once the arrays are released.
+  std::vector< unsigned int >                m_numberOfIndices;
+  unsigned int                               m_numberOfVertices;
+
+  // vesGeometryData::dataVersion() of the uploaded arrays.
+  unsigned int                               m_dataVersion;
+
+  unsigned int                               m_contextGeneration;
+};
+
+struct vesBufferObjectsEntry
+{
+  vesWeakPtr<vesGeometryData>  m_geometryData;
+  vesWeakPtr<vesBufferObjects> m_bufferObjects;
+};
+
+typedef std::map<const vesGeometryData*, vesBufferObjectsEntry>
+  vesBufferObjectsRegistry;
+
+vesBufferObjectsRegistry& bufferObjectsRegistry()
+{
+  static vesBufferObjectsRegistry registry;
+  return registry;
+}
+
+// Upload \p size bytes to the start of the buffer bound to \p target,
+// reallocating it only when it holds less than that. Buffers grow at least
+// twofold, so arrays growing a little at a time are seldom reallocated.
+void uploadInPlace(unsigned int target, unsigned int &capacity,
+                   unsigned int size, const void *data)
+{
+  if (size > capacity) {
+    capacity = std::max(size, 2 * capacity);
+    glBufferData(target, capacity, 0x0, GL_DYNAMIC_DRAW);
+  }
+  if (size) {
+    glBufferSubData(target, 0, size, data);
+  }
+  vesRenderStatistics::addBytesUploaded(size);
+}
+
+} // end namespace
+
 
 class vesMapper::vesInternal
 {
 public:
-  vesInternal()
+  vesInternal() :
+    m_residencyPolicy(vesMapper::KeepResident),
+    m_sortedPrimitive(-1),
+    m_sortedIndexBuffer(0),
+    m_sortedContextGeneration(0)
   {
     this->m_color.resize(4);
   }
@@ -62,13 +150,59 @@ public:
 
   void cleanUpDrawObjects()
   {
-    this->m_bufferVertexAttributeMap.clear();
-    this->m_buffers.clear();
+    this->m_bufferObjects.reset();
+
+    if (this->m_sortedIndexBuffer &&
+        this->m_sortedContextGeneration == contextGeneration) {
+      glDeleteBuffers(1, &this->m_sortedIndexBuffer);
+    }
+    this->m_sortedIndexBuffer = 0;
+    this->m_sortedPrimitive = -1;
   }
 
-  std::vector< float >                       m_color;
-  std::vector< unsigned int >                m_buffers;
-  std::map< unsigned int, std::vector<int> > m_bufferVertexAttributeMap;
+  /// Find buffers already uploaded for \p geometryData by another mapper.
+  static vesSharedPtr<vesBufferObjects> sharedBufferObjects(
+    vesSharedPtr<vesGeometryData> geometryData)
+  {
+    vesBufferObjectsRegistry &registry = bufferObjectsRegistry();
+    vesBufferObjectsRegistry::iterator itr = registry.find(geometryData.get());
+    if (itr == registry.end()) {
+      return vesSharedPtr<vesBufferObjects>();
+    }
+
+    // The address may have been reused by a newer geometry data.
+    vesSharedPtr<vesBufferObjects> bufferObjects =
+      itr->second.m_bufferObjects.lock();
+    if (!bufferObjects || !bufferObjects->isCurrent() ||
+        itr->second.m_geometryData.lock() != geometryData ||
+        bufferObjects->m_dataVersion != geometryData->dataVersion()) {
+      registry.erase(itr);
+      return vesSharedPtr<vesBufferObjects>();
+    }
+
+    return bufferObjects;
+  }
+
+  static void registerBufferObjects(vesSharedPtr<vesGeometryData> geometryData,
+                                    vesSharedPtr<vesBufferObjects> bufferObjects)
+  {
+    vesBufferObjectsEntry &entry = bufferObjectsRegistry()[geometryData.get()];
+    entry.m_geometryData = geometryData;
+    entry.m_bufferObjects = bufferObjects;
+  }
+
+  std::vector< float >             m_color;
+  vesSharedPtr<vesBufferObjects>   m_bufferObjects;
+
+  vesMapper::ResidencyPolicy       m_residencyPolicy;
+  std::string                      m_residencyCacheDirectory;
+
+  // Sorted copy of one triangle primitive, drawn instead of the shared one.
+  vesSharedPtr<vesTriangleSorter>  m_triangleSorter;
+  int                              m_sortedPrimitive;
+  unsigned int                     m_sortedIndexBuffer;
+  unsigned int                     m_sortedContextGeneration;
+  std::vector<unsigned short>      m_sortedIndices;
 };
 
 
@@ -85,11 +219,6 @@ vesMapper::vesMapper() : vesBoundingObject(),
 
 vesMapper::~vesMapper()
 {
-  if (this->m_initialized) {
-    // For now we are not checking if the context is valid.
-    this->deleteVertexBufferObjects();
-  }
-
   delete this->m_internal; this->m_internal = 0x0;
 }
 
@@ -128,6 +257,7 @@ bool vesMapper::setGeometryData(vesSharedPtr<vesGeometryData> geometryData)
   {
     this->m_geometryData = geometryData;
     this->m_initialized = false;
+    vesObject::modified();
   }
   else
   {
@@ -153,6 +283,7 @@ const vesSharedPtr<vesGeometryData> vesMapper::geometryData() const
 void vesMapper::setColor(float r, float g, float b, float a)
 {
   this->m_internal->setColor(r, g, b, a);
+  vesObject::modified();
 }
 
 
@@ -168,59 +299,146 @@ const float* vesMapper::color() const
 }
 
 
+void vesMapper::setSortTriangles(bool enable)
+{
+  if (enable == this->sortTriangles()) {
+    return;
+  }
+
+  if (enable) {
+    this->m_internal->m_triangleSorter =
+      vesSharedPtr<vesTriangleSorter>(new vesTriangleSorter());
+  }
+  else {
+    this->m_internal->m_triangleSorter.reset();
+  }
+
+  this->m_initialized = false;
+  vesObject::modified();
+}
+
+
+bool vesMapper::sortTriangles() const
+{
+  return this->m_internal->m_triangleSorter.get() != 0x0;
+}
+
+
+vesSharedPtr<vesTriangleSorter> vesMapper::triangleSorter()
+{
+  return this->m_internal->m_triangleSorter;
+}
+
+
+void vesMapper::setResidencyPolicy(ResidencyPolicy policy)
+{
+  this->m_internal->m_residencyPolicy = policy;
+}
+
+
+vesMapper::ResidencyPolicy vesMapper::residencyPolicy() const
+{
+  return this->m_internal->m_residencyPolicy;
+}
+
+
+void vesMapper::setResidencyCacheDirectory(const std::string &directory)
+{
+  this->m_internal->m_residencyCacheDirectory = directory;
+}
+
+
+const std::string& vesMapper::residencyCacheDirectory() const
+{
+  return this->m_internal->m_residencyCacheDirectory;
+}
+
+
+void vesMapper::graphicsContextLost()
+{
+  ++contextGeneration;
+}
+
+
 void vesMapper::render(const vesRenderState &renderState)
 {
   assert(this->m_geometryData);
 
-  if (!this->m_initialized) {
+  if (!this->m_initialized || !this->m_internal->m_bufferObjects ||
+      !this->m_internal->m_bufferObjects->isCurrent()) {
     this->setupDrawObjects(renderState);
   }
+  else if (this->m_internal->m_bufferObjects->m_dataVersion !=
+           this->m_geometryData->dataVersion()) {
+    this->updateVertexBufferObjects(renderState);
+  }
+  if (!this->m_initialized) {
+    return;
+  }
+
+  this->releaseGeometryData();
+
+  vesGLState &glState = *renderState.m_glState;
 
   if (renderState.m_material->binNumber() == vesMaterial::Overlay) {
-    glDisable(GL_DEPTH_TEST);
+    glState.setEnabled(GL_DEPTH_TEST, false);
   }
 
   // Fixed vertex color.
-  glVertexAttrib4fv(vesVertexAttributeKeys::Color, this->color());
+  glState.vertexAttrib4fv(vesVertexAttributeKeys::Color, this->color());
+
+  this->updateSortedTriangles(renderState);
+
+  const vesBufferObjects &bufferObjects = *this->m_internal->m_bufferObjects;
 
   std::map<unsigned int, std::vector<int> >::const_iterator constItr
-    = this->m_internal->m_bufferVertexAttributeMap.begin();
+    = bufferObjects.m_bufferVertexAttributeMap.begin();
 
   int bufferIndex = 0;
-  for (; constItr != this->m_internal->m_bufferVertexAttributeMap.end();
+  for (; constItr != bufferObjects.m_bufferVertexAttributeMap.end();
        ++constItr) {
-    glBindBuffer(GL_ARRAY_BUFFER, constItr->first);
+    glState.bindBuffer(GL_ARRAY_BUFFER, constItr->first);
     for (size_t i = 0; i < constItr->second.size(); ++i) {
       renderState.m_material->bindVertexData(renderState, constItr->second[i]);
     }
     ++bufferIndex;
   }
+  glState.applyVertexAttribArrays();
 
   unsigned int numberOfPrimitiveTypes = this->m_geometryData->numberOfPrimitiveTypes();
   for(unsigned int i = 0; i < numberOfPrimitiveTypes; ++i)
   {
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->m_internal->m_buffers[bufferIndex++]);
+    unsigned int indexBuffer = bufferObjects.m_buffers[bufferIndex++];
+    if (static_cast<int>(i) == this->m_internal->m_sortedPrimitive) {
+      indexBuffer = this->m_internal->m_sortedIndexBuffer;
+    }
+    glState.bindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
 
+    const unsigned int numberOfIndices = bufferObjects.m_numberOfIndices[i];
     if (this->m_geometryData->primitive(i)->primitiveType()
       == vesPrimitiveRenderType::Triangles) {
       // Draw triangles
-      this->drawTriangles(renderState, this->m_geometryData->primitive(i));
+      this->drawTriangles(renderState, this->m_geometryData->primitive(i),
+                          numberOfIndices);
     }
     else if (this->m_geometryData->primitive(i)->primitiveType()
       == vesPrimitiveRenderType::Points )
       {
-      this->drawPoints(renderState, this->m_geometryData->primitive(i));
+      this->drawPoints(renderState, this->m_geometryData->primitive(i),
+                       numberOfIndices, bufferObjects.m_numberOfVertices);
       }
     // Draw rest of the primitives
     else {
-      this->drawPrimitive(renderState, this->m_geometryData->primitive(i));
+      this->drawPrimitive(renderState, this->m_geometryData->primitive(i),
+                          numberOfIndices);
     }
   }
 
-  // Unbind.
+  // Unbind. The render state only disables the arrays that the next
+  // mapper does not enable again, and leaves the buffers bound.
   bufferIndex = 0;
-  constItr = this->m_internal->m_bufferVertexAttributeMap.begin();
-  for (; constItr != this->m_internal->m_bufferVertexAttributeMap.end();
+  constItr = bufferObjects.m_bufferVertexAttributeMap.begin();
+  for (; constItr != bufferObjects.m_bufferVertexAttributeMap.end();
        ++constItr) {
     for (size_t i = 0; i < constItr->second.size(); ++i) {
       renderState.m_material->unbindVertexData(renderState, constItr->second[i]);
@@ -228,51 +446,147 @@ void vesMapper::render(const vesRenderState &renderState)
     ++bufferIndex;
   }
 
-  glBindBuffer(GL_ARRAY_BUFFER, 0);
-  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-
   if (renderState.m_material->binNumber() == vesMaterial::Overlay) {
-    glEnable(GL_DEPTH_TEST);
+    glState.setEnabled(GL_DEPTH_TEST, true);
   }
 }
 
 
 void vesMapper::setupDrawObjects(const vesRenderState &renderState)
 {
-  vesNotUsed(renderState);
-
   // Delete buffer objects from past if any.
   this->deleteVertexBufferObjects();
 
   // Now clean up any cache related to draw objects.
   this->m_internal->cleanUpDrawObjects();
 
-  // Now construct the new ones.
-  this->createVertexBufferObjects();
+  this->m_initialized = false;
+
+  // Now construct the new ones, unless another mapper has already uploaded
+  // the same geometry data.
+  this->m_internal->m_bufferObjects =
+    vesInternal::sharedBufferObjects(this->m_geometryData);
+  const bool needsArrays = !this->m_internal->m_bufferObjects ||
+    this->m_internal->m_triangleSorter;
+  if (needsArrays && !this->m_geometryData->lockData()) {
+    std::cerr << "ERROR: Cannot restore released geometry data" << std::endl;
+    this->m_internal->m_bufferObjects.reset();
+    return;
+  }
+
+  if (!this->m_internal->m_bufferObjects) {
+    this->createVertexBufferObjects();
+  }
+
+  if (this->m_internal->m_triangleSorter) {
+    this->setupSortedTriangles();
+  }
+
+  if (needsArrays) {
+    this->m_geometryData->unlockData();
+  }
+
+  // Buffers were created, bound and deleted behind the render state.
+  renderState.m_glState->invalidateBuffers();
 
   this->m_initialized = true;
 }
 
 
+void vesMapper::releaseGeometryData()
+{
+  if (this->m_internal->m_residencyPolicy == ReleaseAfterUpload &&
+      this->m_geometryData->isResident()) {
+    this->m_geometryData->releaseData(
+      this->m_internal->m_residencyCacheDirectory);
+  }
+}
+
+
+void vesMapper::setupSortedTriangles()
+{
+  vesInternal &internal = *this->m_internal;
+
+  unsigned int numberOfPrimitiveTypes =
+    this->m_geometryData->numberOfPrimitiveTypes();
+  for (unsigned int i = 0; i < numberOfPrimitiveTypes; ++i) {
+    vesSharedPtr<vesPrimitive> primitive = this->m_geometryData->primitive(i);
+    if (primitive->primitiveType() != vesPrimitiveRenderType::Triangles) {
+      continue;
+    }
+
+    if (internal.m_triangleSorter->setTriangles(this->m_geometryData,
+                                                primitive)) {
+      internal.m_sortedPrimitive = static_cast<int>(i);
+      glGenBuffers(1, &internal.m_sortedIndexBuffer);
+      internal.m_sortedContextGeneration = contextGeneration;
+      glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, internal.m_sortedIndexBuffer);
+      glBufferData(GL_ELEMENT_ARRAY_BUFFER, primitive->sizeInBytes(),
+                   primitive->data(), GL_DYNAMIC_DRAW);
+      vesRenderStatistics::addBytesUploaded(primitive->sizeInBytes());
+
+      // Circulates with the sorter's buffers, see takeSortedIndices().
+      internal.m_sortedIndices.resize(primitive->numberOfIndices());
+    }
+    break;
+  }
+}
+
+
+void vesMapper::updateSortedTriangles(const vesRenderState &renderState)
+{
+  vesInternal &internal = *this->m_internal;
+  if (internal.m_sortedPrimitive < 0) {
+    return;
+  }
+
+  // Upload the order sorted for an earlier frame, then ask for this one.
+  if (internal.m_triangleSorter->takeSortedIndices(internal.m_sortedIndices)) {
+    const unsigned int size =
+      internal.m_sortedIndices.size() * sizeof(unsigned short);
+    renderState.m_glState->bindBuffer(GL_ELEMENT_ARRAY_BUFFER,
+                                      internal.m_sortedIndexBuffer);
+    glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, size,
+                    &internal.m_sortedIndices.front());
+    vesRenderStatistics::addBytesUploaded(size);
+  }
+
+  internal.m_triangleSorter->requestSort(*renderState.m_modelViewMatrix);
+}
+
+
 void vesMapper::createVertexBufferObjects()
 {
   assert(this->m_geometryData);
 
+  vesSharedPtr<vesBufferObjects> bufferObjects(new vesBufferObjects());
+
   unsigned int bufferId;
 
+  vesSharedPtr<vesSourceData> positions =
+    this->m_geometryData->sourceData(vesVertexAttributeKeys::Position);
+  if (positions) {
+    bufferObjects->m_numberOfVertices = positions->sizeOfArray();
+  }
+  bufferObjects->m_dataVersion = this->m_geometryData->dataVersion();
+
   unsigned int numberOfSources = this->m_geometryData->numberOfSources();
   for(unsigned int i = 0; i < numberOfSources; ++i)
   {
     glGenBuffers(1, &bufferId);
-    this->m_internal->m_buffers.push_back(bufferId);
-    glBindBuffer(GL_ARRAY_BUFFER, this->m_internal->m_buffers.back());
+    bufferObjects->m_buffers.push_back(bufferId);
+    bufferObjects->m_bufferSizes.push_back(
+      this->m_geometryData->source(i)->sizeInBytes());
+    glBindBuffer(GL_ARRAY_BUFFER, bufferObjects->m_buffers.back());
     glBufferData(GL_ARRAY_BUFFER, this->m_geometryData->source(i)->sizeInBytes(),
       this->m_geometryData->source(i)->data(), GL_STATIC_DRAW);
+    vesRenderStatistics::addBytesUploaded(
+      this->m_geometryData->source(i)->sizeInBytes());
 
     std::vector<int> keys = this->m_geometryData->source(i)->keys();
     for(size_t j = 0; j < keys.size(); ++j) {
-      this->m_internal->m_bufferVertexAttributeMap[
-      this->m_internal->m_buffers.back()].push_back(keys[j]);
+      bufferObjects->m_bufferVertexAttributeMap[
+      bufferObjects->m_buffers.back()].push_back(keys[j]);
     }
   }
 
@@ -280,47 +594,109 @@ void vesMapper::createVertexBufferObjects()
   for(size_t i = 0; i < numberOfPrimitiveTypes; ++i)
   {
     glGenBuffers(1, &bufferId);
-    this->m_internal->m_buffers.push_back(bufferId);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->m_internal->m_buffers.back());
+    bufferObjects->m_buffers.push_back(bufferId);
+    bufferObjects->m_bufferSizes.push_back(
+      this->m_geometryData->primitive(i)->sizeInBytes());
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, bufferObjects->m_buffers.back());
     glBufferData(GL_ELEMENT_ARRAY_BUFFER,
       this->m_geometryData->primitive(i)->sizeInBytes(),
       this->m_geometryData->primitive(i)->data(),
       GL_STATIC_DRAW);
+    vesRenderStatistics::addBytesUploaded(
+      this->m_geometryData->primitive(i)->sizeInBytes());
+    bufferObjects->m_numberOfIndices.push_back(
+      this->m_geometryData->primitive(i)->numberOfIndices());
   }
 
+  this->m_internal->m_bufferObjects = bufferObjects;
+  vesInternal::registerBufferObjects(this->m_geometryData, bufferObjects);
+
   this->m_initialized = true;
 }
 
 
-void vesMapper::deleteVertexBufferObjects()
+void vesMapper::updateVertexBufferObjects(const vesRenderState &renderState)
 {
-  if (!this->m_internal->m_buffers.empty()) {
-    glDeleteBuffers(this->m_internal->m_buffers.size(),
-                    &this->m_internal->m_buffers.front());
+  assert(this->m_geometryData);
+
+  vesBufferObjects &bufferObjects = *this->m_internal->m_bufferObjects;
+  const unsigned int numberOfSources = this->m_geometryData->numberOfSources();
+  const unsigned int numberOfPrimitiveTypes =
+    this->m_geometryData->numberOfPrimitiveTypes();
+
+  // Sources or primitives were added, or the sorted copy of the triangles
+  // needs to be set up again: start over.
+  if (this->m_internal->m_triangleSorter ||
+      bufferObjects.m_buffers.size() != numberOfSources + numberOfPrimitiveTypes) {
+    this->setupDrawObjects(renderState);
+    return;
+  }
+
+  if (!this->m_geometryData->lockData()) {
+    std::cerr << "ERROR: Cannot restore released geometry data" << std::endl;
+    this->m_initialized = false;
+    return;
+  }
+
+  vesGLState &glState = *renderState.m_glState;
+
+  vesSharedPtr<vesSourceData> positions =
+    this->m_geometryData->sourceData(vesVertexAttributeKeys::Position);
+  if (positions) {
+    bufferObjects.m_numberOfVertices = positions->sizeOfArray();
   }
+
+  for (unsigned int i = 0; i < numberOfSources; ++i) {
+    vesSharedPtr<vesSourceData> source = this->m_geometryData->source(i);
+    glState.bindBuffer(GL_ARRAY_BUFFER, bufferObjects.m_buffers[i]);
+    uploadInPlace(GL_ARRAY_BUFFER, bufferObjects.m_bufferSizes[i],
+                  source->sizeInBytes(),
+                  source->sizeOfArray() ? source->data() : 0x0);
+  }
+
+  for (unsigned int i = 0; i < numberOfPrimitiveTypes; ++i) {
+    vesSharedPtr<vesPrimitive> primitive = this->m_geometryData->primitive(i);
+    const unsigned int buffer = numberOfSources + i;
+    glState.bindBuffer(GL_ELEMENT_ARRAY_BUFFER, bufferObjects.m_buffers[buffer]);
+    uploadInPlace(GL_ELEMENT_ARRAY_BUFFER, bufferObjects.m_bufferSizes[buffer],
+                  primitive->sizeInBytes(),
+                  primitive->numberOfIndices() ? primitive->data() : 0x0);
+    bufferObjects.m_numberOfIndices[i] = primitive->numberOfIndices();
+  }
+
+  this->m_geometryData->unlockData();
+
+  bufferObjects.m_dataVersion = this->m_geometryData->dataVersion();
+}
+
+
+void vesMapper::deleteVertexBufferObjects()
+{
+  // The buffers are deleted once no other mapper is using them.
+  this->m_internal->m_bufferObjects.reset();
 }
 
 
 void vesMapper::drawPrimitive(const vesRenderState &renderState,
-                              vesSharedPtr<vesPrimitive> primitive)
+                              vesSharedPtr<vesPrimitive> primitive,
+                              unsigned int numberOfIndices)
 {
   // Send the primitive type information out
   renderState.m_material->bindRenderData(
     renderState, vesRenderData(primitive->primitiveType()));
 
-  glDrawElements(primitive->primitiveType(), primitive->numberOfIndices(),
+  glDrawElements(primitive->primitiveType(), numberOfIndices,
                  GL_UNSIGNED_SHORT,  (void*)0);
+  vesRenderStatistics::addDraw(primitive->primitiveType(), numberOfIndices);
 }
 
 
 void vesMapper::drawTriangles(const vesRenderState &renderState,
-                              vesSharedPtr<vesPrimitive> triangles)
+                              vesSharedPtr<vesPrimitive> triangles,
+                              unsigned int numberOfIndices)
 {
   assert(this->m_geometryData);
 
-  const unsigned int numberOfIndices
-    = triangles->numberOfIndices();
-
   unsigned int drawnIndices = 0;
 
   while (drawnIndices < numberOfIndices) {
@@ -341,6 +717,8 @@ void vesMapper::drawTriangles(const vesRenderState &renderState,
     // Now draw the elements
     glDrawElements(triangles->primitiveType(), numberOfIndicesToDraw,
                    GL_UNSIGNED_SHORT, (void*)offset);
+    vesRenderStatistics::addDraw(triangles->primitiveType(),
+                                 numberOfIndicesToDraw);
 
 
     drawnIndices += numberOfIndicesToDraw;
@@ -349,22 +727,23 @@ void vesMapper::drawTriangles(const vesRenderState &renderState,
 
 
 void vesMapper::drawPoints(const vesRenderState &renderState,
-                           vesSharedPtr<vesPrimitive> points)
+                           vesSharedPtr<vesPrimitive> points,
+                           unsigned int numberOfIndices,
+                           unsigned int numberOfVertices)
 {
   assert(this->m_geometryData);
 
-  if(points->size())
+  if(numberOfIndices)
   {
     // Draw using indices
-    this->drawPrimitive(renderState, points);
+    this->drawPrimitive(renderState, points, numberOfIndices);
   }
   else
   {
-    vesSharedPtr<vesSourceData> data =
-        m_geometryData->sourceData(vesVertexAttributeKeys::Position);
     // Send the primitive type information out
     renderState.m_material->bindRenderData(
       renderState, vesRenderData(vesPrimitiveRenderType::Points));
-    glDrawArrays(points->primitiveType(), 0, data->sizeOfArray());
+    glDrawArrays(points->primitiveType(), 0, numberOfVertices);
+    vesRenderStatistics::addDraw(points->primitiveType(), numberOfVertices);
   }
 }
@@ -26,7 +26,10 @@
 /// Actor and mapper works in pair where mapper takes the responsibility of
 /// rendering a geometry using OpenGL ES 2.0 API. vesMapper defines
 /// a light weight polydata rendering entity that works in conjunction with a
-/// vesActor.
+/// vesActor. Mappers that render the same vesGeometryData share its vertex
+/// buffer objects, so the data is uploaded only once.
+/// Geometry data edited in place, see vesGeometryData::setDataModified(), is
+/// uploaded again into the same buffers.
 ///
 /// \see vesBoundingObject vesActor vesGeometryData
 
@@ -39,6 +42,7 @@
 #include "vesSetGet.h"
 
 // C/C++ includes
+#include <string>
 #include <vector>
 
 // Forward declarations
@@ -46,12 +50,25 @@ class vesGeometryData;
 class vesPrimitive;
 class vesVisitor;
 class vesRenderState;
+class vesTriangleSorter;
 
 class vesMapper : public vesBoundingObject
 {
 public:
   vesTypeMacro(vesMapper);
 
+  /// What becomes of the CPU copy of the geometry data once it is uploaded
+  enum ResidencyPolicy
+  {
+    /// Keep the arrays in memory
+    KeepResident,
+
+    /// Release the arrays after the upload, and again after they were
+    /// brought back for CPU access, e.g. picking or a new upload.
+    /// \see vesGeometryData::releaseData()
+    ReleaseAfterUpload
+  };
+
   vesMapper();
   virtual ~vesMapper();
 
@@ -72,6 +89,30 @@ public:
   float* color();
   const float* color() const;
 
+  /// Draw the triangles of translucent geometry back to front. The order
+  /// is maintained by a vesTriangleSorter on a worker thread and lags the
+  /// camera by a frame or so. Only the first triangle primitive is sorted.
+  /// Disabled by default.
+  void setSortTriangles(bool enable);
+  bool sortTriangles() const;
+
+  /// Get the triangle sorter, a null pointer unless sorting is enabled
+  vesSharedPtr<vesTriangleSorter> triangleSorter();
+
+  /// Set the residency policy of the geometry data. Default is KeepResident.
+  void setResidencyPolicy(ResidencyPolicy policy);
+  ResidencyPolicy residencyPolicy() const;
+
+  /// Directory for the files holding released geometry data. When empty,
+  /// the default, released data is kept compressed in memory instead.
+  void setResidencyCacheDirectory(const std::string &directory);
+  const std::string& residencyCacheDirectory() const;
+
+  /// Forget the buffers of all mappers after the GL context was lost,
+  /// without deleting them. Each mapper uploads its geometry data again at
+  /// its next render, restoring released arrays first.
+  static void graphicsContextLost();
+
   /// Render the geometry
   virtual void render(const vesRenderState &renderState);
 
@@ -79,19 +120,30 @@ private:
   virtual void setupDrawObjects(const vesRenderState &renderState);
 
   virtual void createVertexBufferObjects();
+  void updateVertexBufferObjects(const vesRenderState &renderState);
   virtual void deleteVertexBufferObjects();
 
+  void setupSortedTriangles();
+  void updateSortedTriangles(const vesRenderState &renderState);
+  void releaseGeometryData();
+
   //\todo: Why do we need this?
   void normalize();
   vesMatrix4x4f m_normalizedMatrix;
 
 protected:
+  // The counts come from the uploaded buffers, the arrays of the geometry
+  // data may be released.
   void drawPrimitive(const vesRenderState &renderState,
-                     vesSharedPtr<vesPrimitive> primitive);
+                     vesSharedPtr<vesPrimitive> primitive,
+                     unsigned int numberOfIndices);
   void drawTriangles(const vesRenderState &renderState,
-                     vesSharedPtr<vesPrimitive> triangles);
+                     vesSharedPtr<vesPrimitive> triangles,
+                     unsigned int numberOfIndices);
   void drawPoints(const vesRenderState &renderState,
-                  vesSharedPtr<vesPrimitive> points);
+                  vesSharedPtr<vesPrimitive> points,
+                  unsigned int numberOfIndices,
+                  unsigned int numberOfVertices);
 
   bool m_initialized;
 
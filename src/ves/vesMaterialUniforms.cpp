@@ -0,0 +1,86 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+
+#include "vesMaterialUniforms.h"
+
+// VES includes
+#include "vesRenderState.h"
+#include "vesShaderProgram.h"
+#include "vesUniform.h"
+
+vesMaterialUniforms::vesMaterialUniforms() : vesMaterialAttribute()
+{
+  this->m_type = Uniforms;
+
+  // Bound together with the shader program so that the program is in use.
+  this->m_binding = BindAll;
+}
+
+
+vesMaterialUniforms::~vesMaterialUniforms()
+{
+}
+
+
+bool vesMaterialUniforms::addUniform(vesSharedPtr<vesUniform> uniform)
+{
+  if (!uniform) {
+    return false;
+  }
+
+  for (size_t i = 0; i < this->m_uniforms.size(); ++i) {
+    if (this->m_uniforms[i]->name() == uniform->name()) {
+      this->m_uniforms[i] = uniform;
+      return true;
+    }
+  }
+
+  this->m_uniforms.push_back(uniform);
+  return true;
+}
+
+
+vesSharedPtr<vesUniform> vesMaterialUniforms::uniform(
+  const std::string &name) const
+{
+  for (size_t i = 0; i < this->m_uniforms.size(); ++i) {
+    if (this->m_uniforms[i]->name() == name) {
+      return this->m_uniforms[i];
+    }
+  }
+
+  return vesSharedPtr<vesUniform>();
+}
+
+
+void vesMaterialUniforms::bind(const vesRenderState &renderState)
+{
+  if (!this->m_enable || !renderState.m_material->shaderProgram()) {
+    return;
+  }
+
+  const vesShaderProgram &program = *renderState.m_material->shaderProgram();
+  for (size_t i = 0; i < this->m_uniforms.size(); ++i) {
+    int location = program.uniformLocation(this->m_uniforms[i]->name());
+    if (location >= 0) {
+      this->m_uniforms[i]->callGL(location);
+    }
+  }
+}
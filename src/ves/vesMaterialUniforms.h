@@ -0,0 +1,66 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+/// \class vesMaterialUniforms
+/// \ingroup ves
+/// \brief Material attribute holding uniform values private to one material.
+///
+/// Uniforms added to a vesShaderProgram are shared by every material that
+/// uses the program. vesMaterialUniforms lets a material override some of
+/// them: the values are sent right after the shader program is bound. The
+/// program must declare a uniform of the same name, which also provides the
+/// value used by materials that do not override it.
+/// \see vesMaterial vesMaterialAttribute vesUniform
+
+#ifndef VESMATERIALUNIFORMS_H
+#define VESMATERIALUNIFORMS_H
+
+#include "vesMaterial.h"
+
+// VES includes
+#include "vesSetGet.h"
+
+// C/C++ includes
+#include <string>
+#include <vector>
+
+// Forward declarations
+class vesUniform;
+
+class vesMaterialUniforms : public vesMaterialAttribute
+{
+public:
+  vesTypeMacro(vesMaterialUniforms);
+
+  vesMaterialUniforms();
+  virtual ~vesMaterialUniforms();
+
+  /// Add uniform, replacing any uniform with the same name.
+  bool addUniform(vesSharedPtr<vesUniform> uniform);
+
+  /// Get uniform by name, or an empty pointer if there is none.
+  vesSharedPtr<vesUniform> uniform(const std::string &name) const;
+
+  virtual void bind(const vesRenderState &renderState);
+
+protected:
+  std::vector< vesSharedPtr<vesUniform> > m_uniforms;
+};
+
+#endif // VESMATERIALUNIFORMS_H
@@ -0,0 +1,1413 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+
+#include "vesMeshCodec.h"
+
+// VES includes
+#include "vesGeometryData.h"
+
+// C/C++ includes
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+namespace {
+
+const unsigned char MagicNumber[4] = { 'V', 'E', 'S', 'Z' };
+const unsigned int FormatVersion = 1;
+
+// Set when the decoder computes the normals the encoder left out.
+const unsigned int ComputeNormalsFlag = 1;
+
+// Limits keeping corrupt headers from allocating without bounds.
+const unsigned int MaximumNumberOfVertices = 1 << 24;
+const unsigned int MaximumNumberOfIndices = 1 << 26;
+const unsigned int MaximumNumberOfPrimitives = 1024;
+
+enum vesAttributeEncoding
+{
+  LinearEncoding,
+  OctahedralEncoding
+};
+
+const int ProbabilityBits = 11;
+const unsigned short InitialProbability = 1 << (ProbabilityBits - 1);
+const int AdaptationShift = 5;
+const unsigned int TopValue = 1u << 24;
+
+
+// Binary range coder with adaptive probabilities, as used by LZMA.
+class vesRangeEncoder
+{
+public:
+  vesRangeEncoder() :
+    m_low(0), m_range(0xFFFFFFFFu), m_cache(0), m_cacheSize(1)
+  {
+  }
+
+  void encodeBit(unsigned short &probability, unsigned int bit)
+  {
+    const unsigned int bound = (this->m_range >> ProbabilityBits) * probability;
+    if (!bit) {
+      this->m_range = bound;
+      probability += ((1 << ProbabilityBits) - probability) >> AdaptationShift;
+    }
+    else {
+      this->m_low += bound;
+      this->m_range -= bound;
+      probability -= probability >> AdaptationShift;
+    }
+    this->normalize();
+  }
+
+  /// Encode the low \p numberOfBits bits of \p value with probability 1/2.
+  void encodeDirect(unsigned int value, int numberOfBits)
+  {
+    for (int i = numberOfBits - 1; i >= 0; --i) {
+      this->m_range >>= 1;
+      if ((value >> i) & 1) {
+        this->m_low += this->m_range;
+      }
+      this->normalize();
+    }
+  }
+
+  void flush()
+  {
+    for (int i = 0; i < 5; ++i) {
+      this->shiftLow();
+    }
+  }
+
+  const std::vector<unsigned char>& output() const { return this->m_output; }
+
+private:
+  void normalize()
+  {
+    while (this->m_range < TopValue) {
+      this->m_range <<= 8;
+      this->shiftLow();
+    }
+  }
+
+  void shiftLow()
+  {
+    if (static_cast<unsigned int>(this->m_low) < 0xFF000000u || (this->m_low >> 32)) {
+      const unsigned char carry = static_cast<unsigned char>(this->m_low >> 32);
+      unsigned char byte = this->m_cache;
+      do {
+        this->m_output.push_back(static_cast<unsigned char>(byte + carry));
+        byte = 0xFF;
+      } while (--this->m_cacheSize);
+      this->m_cache = static_cast<unsigned char>(this->m_low >> 24);
+    }
+    ++this->m_cacheSize;
+    this->m_low = (this->m_low & 0x00FFFFFFu) << 8;
+  }
+
+  unsigned long long m_low;
+  unsigned int m_range;
+  unsigned char m_cache;
+  unsigned long long m_cacheSize;
+  std::vector<unsigned char> m_output;
+};
+
+
+class vesRangeDecoder
+{
+public:
+  vesRangeDecoder() :
+    m_code(0), m_range(0xFFFFFFFFu), m_input(0x0), m_end(0x0), m_overrun(false)
+  {
+  }
+
+  void initialize(const unsigned char *input, size_t size)
+  {
+    this->m_input = input;
+    this->m_end = input + size;
+    for (int i = 0; i < 5; ++i) {
+      this->m_code = (this->m_code << 8) | this->nextByte();
+    }
+  }
+
+  unsigned int decodeBit(unsigned short &probability)
+  {
+    const unsigned int bound = (this->m_range >> ProbabilityBits) * probability;
+    unsigned int bit;
+    if (this->m_code < bound) {
+      this->m_range = bound;
+      probability += ((1 << ProbabilityBits) - probability) >> AdaptationShift;
+      bit = 0;
+    }
+    else {
+      this->m_code -= bound;
+      this->m_range -= bound;
+      probability -= probability >> AdaptationShift;
+      bit = 1;
+    }
+    this->normalize();
+    return bit;
+  }
+
+  unsigned int decodeDirect(int numberOfBits)
+  {
+    unsigned int value = 0;
+    for (int i = 0; i < numberOfBits; ++i) {
+      this->m_range >>= 1;
+      unsigned int bit = 0;
+      if (this->m_code >= this->m_range) {
+        this->m_code -= this->m_range;
+        bit = 1;
+      }
+      value = (value << 1) | bit;
+      this->normalize();
+    }
+    return value;
+  }
+
+  /// True if decoding read past the end of the input.
+  bool overrun() const { return this->m_overrun; }
+
+private:
+  void normalize()
+  {
+    while (this->m_range < TopValue) {
+      this->m_range <<= 8;
+      this->m_code = (this->m_code << 8) | this->nextByte();
+    }
+  }
+
+  unsigned int nextByte()
+  {
+    if (this->m_input < this->m_end) {
+      return *this->m_input++;
+    }
+    this->m_overrun = true;
+    return 0;
+  }
+
+  unsigned int m_code;
+  unsigned int m_range;
+  const unsigned char *m_input;
+  const unsigned char *m_end;
+  bool m_overrun;
+};
+
+
+// Unsigned values are coded as their number of significant bits, the bit
+// after the leading one, both adaptive, and the remaining bits as they are.
+struct vesValueModel
+{
+  vesValueModel()
+  {
+    std::fill(this->m_lengths, this->m_lengths + 64, InitialProbability);
+    std::fill(this->m_leadingBits, this->m_leadingBits + 33, InitialProbability);
+  }
+
+  unsigned short m_lengths[64];
+  unsigned short m_leadingBits[33];
+};
+
+
+void encodeValue(vesRangeEncoder &encoder, vesValueModel &model, unsigned int value)
+{
+  int length = 0;
+  while (length < 32 && (value >> length)) {
+    ++length;
+  }
+
+  int node = 1;
+  for (int i = 5; i >= 0; --i) {
+    const unsigned int bit = (length >> i) & 1;
+    encoder.encodeBit(model.m_lengths[node], bit);
+    node = 2 * node + bit;
+  }
+
+  if (length >= 2) {
+    encoder.encodeBit(model.m_leadingBits[length], (value >> (length - 2)) & 1);
+    if (length >= 3) {
+      encoder.encodeDirect(value, length - 2);
+    }
+  }
+}
+
+
+unsigned int decodeValue(vesRangeDecoder &decoder, vesValueModel &model, bool &failed)
+{
+  int node = 1;
+  for (int i = 0; i < 6; ++i) {
+    node = 2 * node + decoder.decodeBit(model.m_lengths[node]);
+  }
+
+  const int length = node - 64;
+  if (length > 32) {
+    failed = true;
+    return 0;
+  }
+  if (!length) {
+    return 0;
+  }
+
+  unsigned int value = 1;
+  if (length >= 2) {
+    value = (value << 1) | decoder.decodeBit(model.m_leadingBits[length]);
+    if (length >= 3) {
+      value = (value << (length - 2)) | decoder.decodeDirect(length - 2);
+    }
+  }
+  return value;
+}
+
+
+inline unsigned int zigzag(int value)
+{
+  return (static_cast<unsigned int>(value) << 1) ^ static_cast<unsigned int>(value >> 31);
+}
+
+
+inline int unzigzag(unsigned int value)
+{
+  return static_cast<int>(value >> 1) ^ -static_cast<int>(value & 1);
+}
+
+
+bool isSupportedAttribute(int key, unsigned int numberOfComponents)
+{
+  switch (key) {
+    case vesVertexAttributeKeys::Position:
+    case vesVertexAttributeKeys::Normal:
+      return numberOfComponents == 3;
+    case vesVertexAttributeKeys::TextureCoordinate:
+      return numberOfComponents == 2 || numberOfComponents == 3;
+    case vesVertexAttributeKeys::Color:
+      return numberOfComponents == 3 || numberOfComponents == 4;
+    case vesVertexAttributeKeys::Scalar:
+      return numberOfComponents == 1;
+    default:
+      return false;
+  }
+}
+
+
+inline bool isTriangles(unsigned int type, unsigned int indexCount,
+                        size_t numberOfIndices)
+{
+  return type == vesPrimitiveRenderType::Triangles && indexCount == 3
+    && numberOfIndices % 3 == 0;
+}
+
+
+// An attribute as integers, each coded component being quantized to
+// minimum + value * step.
+struct vesCodedAttribute
+{
+  unsigned int codedComponents() const
+  {
+    return this->m_encoding == OctahedralEncoding ? 2 : this->m_numberOfComponents;
+  }
+
+  int maximum() const
+  {
+    return (1 << this->m_bits) - 1;
+  }
+
+  int m_key;
+  unsigned int m_numberOfComponents;
+  unsigned int m_encoding;
+  unsigned int m_bits;
+  std::vector<float> m_minimum;
+  std::vector<float> m_step;
+
+  // Values of the vertices in the order they are coded.
+  std::vector<int> m_values;
+  std::vector<vesValueModel> m_models;
+};
+
+
+inline int quantize(float value, float minimum, float step, int maximum)
+{
+  if (!(step > 0.0f)) {
+    return 0;
+  }
+  const double scaled = (value - minimum) / static_cast<double>(step) + 0.5;
+  if (!(scaled >= 0.0)) {
+    return 0;
+  }
+  return scaled >= maximum ? maximum : static_cast<int>(scaled);
+}
+
+
+inline void octahedralEncode(const float normal[3], float &u, float &v)
+{
+  const float sum = fabs(normal[0]) + fabs(normal[1]) + fabs(normal[2]);
+  if (!(sum > 0.0f)) {
+    u = v = 0.0f;
+    return;
+  }
+  u = normal[0] / sum;
+  v = normal[1] / sum;
+  if (normal[2] < 0.0f) {
+    const float foldedU = (1.0f - fabs(v)) * (u >= 0.0f ? 1.0f : -1.0f);
+    v = (1.0f - fabs(u)) * (v >= 0.0f ? 1.0f : -1.0f);
+    u = foldedU;
+  }
+}
+
+
+inline void octahedralDecode(float u, float v, float *normal)
+{
+  float x = u;
+  float y = v;
+  const float z = 1.0f - fabs(u) - fabs(v);
+  if (z < 0.0f) {
+    x = (1.0f - fabs(v)) * (u >= 0.0f ? 1.0f : -1.0f);
+    y = (1.0f - fabs(u)) * (v >= 0.0f ? 1.0f : -1.0f);
+  }
+  const float length = sqrt(x * x + y * y + z * z);
+  normal[0] = x / length;
+  normal[1] = y / length;
+  normal[2] = z / length;
+}
+
+
+// Directed triangle edges and the vertex opposite to them.
+const unsigned long long EmptyKey = ~0ULL;
+
+class vesEdgeTable
+{
+public:
+  vesEdgeTable(size_t numberOfEdges)
+  {
+    size_t size = 1024;
+    this->m_shift = 54;
+    while (size < 2 * numberOfEdges) {
+      size *= 2;
+      --this->m_shift;
+    }
+    this->m_keys.resize(size, EmptyKey);
+    this->m_opposites.resize(size);
+  }
+
+  void insert(int from, int to, int opposite)
+  {
+    const unsigned long long edge = key(from, to);
+    const size_t mask = this->m_keys.size() - 1;
+    for (size_t slot = this->hash(edge); ; slot = (slot + 1) & mask) {
+      if (this->m_keys[slot] == edge) {
+        return;
+      }
+      if (this->m_keys[slot] == EmptyKey) {
+        this->m_keys[slot] = edge;
+        this->m_opposites[slot] = opposite;
+        return;
+      }
+    }
+  }
+
+  int find(int from, int to) const
+  {
+    const unsigned long long edge = key(from, to);
+    const size_t mask = this->m_keys.size() - 1;
+    for (size_t slot = this->hash(edge); ; slot = (slot + 1) & mask) {
+      if (this->m_keys[slot] == edge) {
+        return this->m_opposites[slot];
+      }
+      if (this->m_keys[slot] == EmptyKey) {
+        return -1;
+      }
+    }
+  }
+
+private:
+  static unsigned long long key(int from, int to)
+  {
+    return (static_cast<unsigned long long>(from) << 32) | static_cast<unsigned int>(to);
+  }
+
+  // Fibonacci hashing, taking the well mixed high bits of the product.
+  size_t hash(unsigned long long key) const
+  {
+    return static_cast<size_t>((key * 0x9E3779B97F4A7C15ULL) >> this->m_shift);
+  }
+
+  int m_shift;
+  std::vector<unsigned long long> m_keys;
+  std::vector<int> m_opposites;
+};
+
+
+// Vertices, by coding order, a new vertex is predicted from; -1 where
+// there is none.
+struct vesPredictors
+{
+  int m_first;
+  int m_second;
+  int m_opposite;
+  int m_previous;
+};
+
+
+vesPredictors previousPredictors(int previous)
+{
+  const vesPredictors predictors = { -1, -1, -1, previous };
+  return predictors;
+}
+
+
+// A new vertex at \p corner of a triangle is predicted from the corners
+// before it, completing the parallelogram with the triangle across their
+// edge when it is known.
+vesPredictors cornerPredictors(const int *corners, int corner,
+                               const vesEdgeTable &edges, int previous)
+{
+  vesPredictors predictors = previousPredictors(previous);
+  if (corner >= 1) {
+    predictors.m_first = corners[0];
+  }
+  if (corner == 2) {
+    predictors.m_second = corners[1];
+    predictors.m_opposite = edges.find(corners[1], corners[0]);
+  }
+  return predictors;
+}
+
+
+void predict(const vesCodedAttribute &attribute, const vesPredictors &predictors,
+             int *prediction)
+{
+  const int components = static_cast<int>(attribute.codedComponents());
+  const int *values = &attribute.m_values[0];
+  const int first = predictors.m_first * components;
+  const int second = predictors.m_second * components;
+  const int opposite = predictors.m_opposite * components;
+  const int previous = predictors.m_previous * components;
+
+  for (int i = 0; i < components; ++i) {
+    if (predictors.m_opposite >= 0) {
+      prediction[i] = std::max(0, std::min(attribute.maximum(), values[first + i]
+                                           + values[second + i] - values[opposite + i]));
+    }
+    else if (predictors.m_second >= 0) {
+      prediction[i] = (values[first + i] + values[second + i]) / 2;
+    }
+    else if (predictors.m_first >= 0) {
+      prediction[i] = values[first + i];
+    }
+    else if (predictors.m_previous >= 0) {
+      prediction[i] = values[previous + i];
+    }
+    else {
+      prediction[i] = 0;
+    }
+  }
+}
+
+
+void writeUInt32(std::vector<unsigned char> &output, unsigned int value)
+{
+  for (int i = 0; i < 4; ++i) {
+    output.push_back(static_cast<unsigned char>(value >> (8 * i)));
+  }
+}
+
+
+void writeFloat(std::vector<unsigned char> &output, float value)
+{
+  unsigned int bits;
+  memcpy(&bits, &value, sizeof(bits));
+  writeUInt32(output, bits);
+}
+
+
+// CRC-32 as in zlib and PNG. Closes the encoded data, so that corrupt
+// downloads are rejected before they are decoded.
+unsigned int checksum(const unsigned char *data, size_t size)
+{
+  unsigned int table[256];
+  for (unsigned int i = 0; i < 256; ++i) {
+    unsigned int value = i;
+    for (int j = 0; j < 8; ++j) {
+      value = (value & 1) ? 0xEDB88320u ^ (value >> 1) : value >> 1;
+    }
+    table[i] = value;
+  }
+
+  unsigned int crc = 0xFFFFFFFFu;
+  for (size_t i = 0; i < size; ++i) {
+    crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+  }
+  return ~crc;
+}
+
+
+class vesByteReader
+{
+public:
+  vesByteReader(const unsigned char *data, size_t size) :
+    m_data(data), m_end(data + size), m_failed(false)
+  {
+  }
+
+  const unsigned char* readBytes(size_t size)
+  {
+    if (this->m_failed || static_cast<size_t>(this->m_end - this->m_data) < size) {
+      this->m_failed = true;
+      return 0x0;
+    }
+    const unsigned char *bytes = this->m_data;
+    this->m_data += size;
+    return bytes;
+  }
+
+  unsigned int readUInt32()
+  {
+    const unsigned char *bytes = this->readBytes(4);
+    if (!bytes) {
+      return 0;
+    }
+    return bytes[0] | (bytes[1] << 8) | (bytes[2] << 16)
+      | (static_cast<unsigned int>(bytes[3]) << 24);
+  }
+
+  float readFloat()
+  {
+    const unsigned int bits = this->readUInt32();
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+  }
+
+  bool failed() const { return this->m_failed; }
+
+private:
+  const unsigned char *m_data;
+  const unsigned char *m_end;
+  bool m_failed;
+};
+
+
+struct vesCodedPrimitive
+{
+  unsigned int m_type;
+  unsigned int m_indexCount;
+  unsigned int m_numberOfIndices;
+};
+
+
+// Quantizes the attributes and codes them along the primitives.
+class vesMeshEncoder
+{
+public:
+  vesMeshEncoder(const int *bits) : m_bits(bits), m_numberOfVertices(0),
+    m_computeNormals(false), m_next(0)
+  {
+  }
+
+  bool encode(vesGeometryData &geometryData, std::vector<unsigned char> &output,
+              std::string &errorMessage)
+  {
+    if (!this->gatherAttributes(geometryData, errorMessage)
+        || !this->gatherPrimitives(geometryData, errorMessage)) {
+      return false;
+    }
+
+    this->m_encoders.resize(this->m_attributes.size());
+    this->m_newIndices.resize(this->m_numberOfVertices, -1);
+    size_t numberOfEdges = 0;
+    for (size_t i = 0; i < this->m_primitives.size(); ++i) {
+      const vesCodedPrimitive &primitive = this->m_primitives[i];
+      if (isTriangles(primitive.m_type, primitive.m_indexCount,
+                      primitive.m_numberOfIndices)) {
+        numberOfEdges += primitive.m_numberOfIndices;
+      }
+    }
+    vesEdgeTable edges(numberOfEdges);
+
+    for (size_t i = 0; i < this->m_primitives.size(); ++i) {
+      const vesCodedPrimitive &primitive = this->m_primitives[i];
+      const vesPrimitive::Indices &indices =
+        *geometryData.primitive(static_cast<unsigned int>(i))->indices();
+
+      if (!isTriangles(primitive.m_type, primitive.m_indexCount, indices.size())) {
+        for (size_t j = 0; j < indices.size(); ++j) {
+          this->encodeIndex(indices[j], this->m_connectivityModels[3],
+                            previousPredictors(this->m_next - 1));
+        }
+        continue;
+      }
+
+      for (size_t j = 0; j < indices.size(); j += 3) {
+        // Put new vertices last, to be predicted from the known ones.
+        bool known[3];
+        int numberOfKnown = 0;
+        for (int k = 0; k < 3; ++k) {
+          known[k] = this->m_newIndices[indices[j + k]] >= 0;
+          numberOfKnown += known[k];
+        }
+        int rotation = 0;
+        if (numberOfKnown == 2) {
+          rotation = !known[0] ? 1 : !known[1] ? 2 : 0;
+        }
+        else if (numberOfKnown == 1) {
+          rotation = known[1] ? 1 : known[2] ? 2 : 0;
+        }
+
+        int corners[3];
+        for (int k = 0; k < 3; ++k) {
+          corners[k] = this->encodeIndex(
+            indices[j + (k + rotation) % 3], this->m_connectivityModels[k],
+            cornerPredictors(corners, k, edges, this->m_next - 1));
+        }
+        edges.insert(corners[0], corners[1], corners[2]);
+        edges.insert(corners[1], corners[2], corners[0]);
+        edges.insert(corners[2], corners[0], corners[1]);
+      }
+    }
+
+    // Vertices no primitive uses follow in their original order.
+    for (unsigned int i = 0; i < this->m_numberOfVertices; ++i) {
+      if (this->m_newIndices[i] < 0) {
+        this->addVertex(i, previousPredictors(this->m_next - 1));
+      }
+    }
+
+    this->m_connectivity.flush();
+    for (size_t i = 0; i < this->m_encoders.size(); ++i) {
+      this->m_encoders[i].flush();
+    }
+    this->writeHeader(geometryData, output);
+    this->writeStream(this->m_connectivity, output);
+    for (size_t i = 0; i < this->m_encoders.size(); ++i) {
+      this->writeStream(this->m_encoders[i], output);
+    }
+    writeUInt32(output, checksum(&output[0], output.size()));
+    return true;
+  }
+
+private:
+  bool gatherAttributes(vesGeometryData &geometryData, std::string &errorMessage)
+  {
+    bool hasVertices = false;
+    for (unsigned int i = 0; i < geometryData.numberOfSources(); ++i) {
+      vesSourceData::Ptr source = geometryData.source(i);
+      const std::vector<int> keys = source->keys();
+      for (size_t j = 0; j < keys.size(); ++j) {
+        const int key = keys[j];
+        if (key < 0 || key >= vesVertexAttributeKeys::CountAttributeIndex
+            || !isSupportedAttribute(key, source->numberOfComponents(key))) {
+          errorMessage = "Unsupported vertex attribute";
+          return false;
+        }
+        if (source->attributeDataType(key) != vesDataType::Float
+            || source->sizeOfAttributeDataType(key) != sizeof(float)) {
+          errorMessage = "Only float vertex attributes can be encoded";
+          return false;
+        }
+        if (hasVertices && source->sizeOfArray() != this->m_numberOfVertices) {
+          errorMessage = "Sources differ in their number of vertices";
+          return false;
+        }
+        hasVertices = true;
+        this->m_numberOfVertices = source->sizeOfArray();
+      }
+    }
+
+    if (!geometryData.sourceData(vesVertexAttributeKeys::Position)
+        || !this->m_numberOfVertices) {
+      errorMessage = "Geometry without vertex positions";
+      return false;
+    }
+    if (this->m_numberOfVertices > MaximumNumberOfVertices) {
+      errorMessage = "Too many vertices";
+      return false;
+    }
+
+    // Attributes are coded in key order, positions first.
+    for (int key = 0; key < vesVertexAttributeKeys::CountAttributeIndex; ++key) {
+      vesSourceData::Ptr source = geometryData.sourceData(key);
+      if (!source) {
+        continue;
+      }
+      if (key == vesVertexAttributeKeys::Normal && !this->m_bits[key]) {
+        this->m_computeNormals = true;
+        continue;
+      }
+      this->m_attributes.push_back(vesCodedAttribute());
+      this->quantize(*source, key, this->m_attributes.back());
+    }
+    return true;
+  }
+
+  void quantize(vesSourceData &source, int key, vesCodedAttribute &attribute)
+  {
+    attribute.m_key = key;
+    attribute.m_numberOfComponents = source.numberOfComponents(key);
+    attribute.m_encoding = key == vesVertexAttributeKeys::Normal
+      ? OctahedralEncoding : LinearEncoding;
+    attribute.m_bits = this->m_bits[key];
+
+    const unsigned int count = this->m_numberOfVertices;
+    const unsigned int components = attribute.m_numberOfComponents;
+    const unsigned int codedComponents = attribute.codedComponents();
+    const int maximum = attribute.maximum();
+    const char *data = static_cast<const char*>(source.data());
+    const int stride = source.attributeStride(key);
+    const int offset = source.attributeOffset(key);
+
+    std::vector<float> values(static_cast<size_t>(count) * components);
+    for (unsigned int i = 0; i < count; ++i) {
+      memcpy(&values[i * components], data + i * stride + offset,
+             components * sizeof(float));
+    }
+
+    attribute.m_minimum.assign(codedComponents, 0.0f);
+    attribute.m_step.assign(codedComponents, 0.0f);
+    attribute.m_models.resize(codedComponents);
+
+    if (attribute.m_encoding == OctahedralEncoding) {
+      attribute.m_minimum.assign(codedComponents, -1.0f);
+      attribute.m_step.assign(codedComponents, 2.0f / maximum);
+    }
+    else if (key == vesVertexAttributeKeys::Color) {
+      attribute.m_step.assign(codedComponents, 1.0f / maximum);
+    }
+    else {
+      std::vector<float> upper(components, 0.0f);
+      std::vector<bool> found(components, false);
+      for (size_t i = 0; i < values.size(); ++i) {
+        const unsigned int c = i % components;
+        if (values[i] == values[i] && fabs(values[i]) <= 3.4e38f) {
+          if (!found[c] || values[i] < attribute.m_minimum[c]) {
+            attribute.m_minimum[c] = values[i];
+          }
+          if (!found[c] || values[i] > upper[c]) {
+            upper[c] = values[i];
+          }
+          found[c] = true;
+        }
+      }
+      float extent = 0.0f;
+      for (unsigned int c = 0; c < components; ++c) {
+        attribute.m_step[c] = (upper[c] - attribute.m_minimum[c]) / maximum;
+        extent = std::max(extent, upper[c] - attribute.m_minimum[c]);
+      }
+
+      // Positions share one step so that the grid has the shape of the mesh.
+      if (key == vesVertexAttributeKeys::Position) {
+        attribute.m_step.assign(codedComponents, extent / maximum);
+      }
+    }
+
+    this->m_quantized.push_back(std::vector<int>(
+      static_cast<size_t>(count) * codedComponents));
+    std::vector<int> &quantized = this->m_quantized.back();
+    for (unsigned int i = 0; i < count; ++i) {
+      float coded[4];
+      if (attribute.m_encoding == OctahedralEncoding) {
+        octahedralEncode(&values[i * components], coded[0], coded[1]);
+      }
+      else {
+        std::copy(&values[i * components], &values[i * components] + components, coded);
+      }
+      for (unsigned int c = 0; c < codedComponents; ++c) {
+        quantized[i * codedComponents + c] = ::quantize(
+          coded[c], attribute.m_minimum[c], attribute.m_step[c], maximum);
+      }
+    }
+    attribute.m_values.resize(quantized.size());
+  }
+
+  bool gatherPrimitives(vesGeometryData &geometryData, std::string &errorMessage)
+  {
+    for (unsigned int i = 0; i < geometryData.numberOfPrimitiveTypes(); ++i) {
+      vesPrimitive::Ptr primitive = geometryData.primitive(i);
+      const vesPrimitive::Indices &indices = *primitive->indices();
+      for (size_t j = 0; j < indices.size(); ++j) {
+        if (indices[j] >= this->m_numberOfVertices) {
+          errorMessage = "Primitive refers to a missing vertex";
+          return false;
+        }
+      }
+
+      const vesCodedPrimitive codedPrimitive = {
+        primitive->primitiveType(), primitive->indexCount(),
+        static_cast<unsigned int>(indices.size()) };
+      this->m_primitives.push_back(codedPrimitive);
+    }
+    return true;
+  }
+
+  int encodeIndex(unsigned int original, vesValueModel &model,
+                  const vesPredictors &predictors)
+  {
+    const int index = this->m_newIndices[original];
+    if (index >= 0) {
+      encodeValue(this->m_connectivity, model, this->m_next - index);
+      return index;
+    }
+    encodeValue(this->m_connectivity, model, 0);
+    return this->addVertex(original, predictors);
+  }
+
+  int addVertex(unsigned int original, const vesPredictors &predictors)
+  {
+    const int index = this->m_next++;
+    this->m_newIndices[original] = index;
+
+    for (size_t i = 0; i < this->m_attributes.size(); ++i) {
+      vesCodedAttribute &attribute = this->m_attributes[i];
+      const unsigned int components = attribute.codedComponents();
+      int prediction[4];
+      predict(attribute, predictors, prediction);
+      for (unsigned int c = 0; c < components; ++c) {
+        const int value = this->m_quantized[i][original * components + c];
+        attribute.m_values[index * components + c] = value;
+        encodeValue(this->m_encoders[i], attribute.m_models[c],
+                    zigzag(value - prediction[c]));
+      }
+    }
+    return index;
+  }
+
+  void writeHeader(vesGeometryData &geometryData, std::vector<unsigned char> &output)
+  {
+    output.insert(output.end(), MagicNumber, MagicNumber + 4);
+    writeUInt32(output, FormatVersion);
+
+    const std::string &name = geometryData.name();
+    writeUInt32(output, static_cast<unsigned int>(name.size()));
+    output.insert(output.end(), name.begin(), name.end());
+
+    writeUInt32(output, this->m_numberOfVertices);
+    writeUInt32(output, this->m_computeNormals ? ComputeNormalsFlag : 0);
+
+    writeUInt32(output, static_cast<unsigned int>(this->m_attributes.size()));
+    for (size_t i = 0; i < this->m_attributes.size(); ++i) {
+      const vesCodedAttribute &attribute = this->m_attributes[i];
+      writeUInt32(output, attribute.m_key);
+      writeUInt32(output, attribute.m_numberOfComponents);
+      writeUInt32(output, attribute.m_encoding);
+      writeUInt32(output, attribute.m_bits);
+      for (unsigned int c = 0; c < attribute.codedComponents(); ++c) {
+        writeFloat(output, attribute.m_minimum[c]);
+        writeFloat(output, attribute.m_step[c]);
+      }
+    }
+
+    writeUInt32(output, static_cast<unsigned int>(this->m_primitives.size()));
+    for (size_t i = 0; i < this->m_primitives.size(); ++i) {
+      writeUInt32(output, this->m_primitives[i].m_type);
+      writeUInt32(output, this->m_primitives[i].m_indexCount);
+      writeUInt32(output, this->m_primitives[i].m_numberOfIndices);
+    }
+  }
+
+  void writeStream(const vesRangeEncoder &encoder, std::vector<unsigned char> &output)
+  {
+    writeUInt32(output, static_cast<unsigned int>(encoder.output().size()));
+    output.insert(output.end(), encoder.output().begin(), encoder.output().end());
+  }
+
+  const int *m_bits;
+  unsigned int m_numberOfVertices;
+  bool m_computeNormals;
+  std::vector<vesCodedAttribute> m_attributes;
+  std::vector<vesCodedPrimitive> m_primitives;
+
+  // Attribute values in the original vertex order.
+  std::vector<std::vector<int> > m_quantized;
+
+  std::vector<int> m_newIndices;
+  int m_next;
+  vesRangeEncoder m_connectivity;
+  vesValueModel m_connectivityModels[4];
+  std::vector<vesRangeEncoder> m_encoders;
+};
+
+
+// Mirror of vesMeshEncoder, writing the vertices straight into the sources.
+class vesMeshDecoder
+{
+public:
+  vesMeshDecoder() : m_numberOfVertices(0), m_flags(0), m_next(0), m_failed(false)
+  {
+  }
+
+  vesGeometryData::Ptr decode(const unsigned char *data, size_t size,
+                              std::string &errorMessage)
+  {
+    // The checksum takes the last four bytes.
+    vesByteReader reader(data, size >= 4 ? size - 4 : 0);
+    const unsigned char *magicNumber = reader.readBytes(4);
+    if (!magicNumber || memcmp(magicNumber, MagicNumber, 4) != 0) {
+      errorMessage = "Not an encoded mesh";
+      return vesGeometryData::Ptr();
+    }
+    if (reader.readUInt32() != FormatVersion) {
+      errorMessage = "Unsupported encoded mesh version";
+      return vesGeometryData::Ptr();
+    }
+
+    vesByteReader trailer(data + size - 4, 4);
+    if (trailer.readUInt32() != checksum(data, size - 4)) {
+      errorMessage = "Corrupt encoded mesh";
+      return vesGeometryData::Ptr();
+    }
+
+    if (!this->readHeader(reader) || !this->decodeStreams()) {
+      errorMessage = "Corrupt encoded mesh";
+      return vesGeometryData::Ptr();
+    }
+    return this->createGeometryData();
+  }
+
+private:
+  bool readHeader(vesByteReader &reader)
+  {
+    const unsigned int nameSize = reader.readUInt32();
+    const unsigned char *name = reader.readBytes(nameSize);
+    if (name) {
+      this->m_name.assign(name, name + nameSize);
+    }
+
+    this->m_numberOfVertices = reader.readUInt32();
+    this->m_flags = reader.readUInt32();
+    if (!this->m_numberOfVertices || this->m_numberOfVertices > MaximumNumberOfVertices) {
+      return false;
+    }
+
+    const unsigned int numberOfAttributes = reader.readUInt32();
+    if (numberOfAttributes > vesVertexAttributeKeys::CountAttributeIndex) {
+      return false;
+    }
+    for (unsigned int i = 0; i < numberOfAttributes && !reader.failed(); ++i) {
+      vesCodedAttribute attribute;
+      attribute.m_key = static_cast<int>(reader.readUInt32());
+      attribute.m_numberOfComponents = reader.readUInt32();
+      attribute.m_encoding = reader.readUInt32();
+      attribute.m_bits = reader.readUInt32();
+
+      const bool octahedral = attribute.m_key == vesVertexAttributeKeys::Normal;
+      if (!isSupportedAttribute(attribute.m_key, attribute.m_numberOfComponents)
+          || attribute.m_encoding != (octahedral ? OctahedralEncoding : LinearEncoding)
+          || attribute.m_bits < 1 || attribute.m_bits > 24
+          || (i && attribute.m_key <= this->m_attributes.back().m_key)) {
+        return false;
+      }
+
+      for (unsigned int c = 0; c < attribute.codedComponents(); ++c) {
+        attribute.m_minimum.push_back(reader.readFloat());
+        attribute.m_step.push_back(reader.readFloat());
+      }
+      attribute.m_values.resize(this->m_numberOfVertices * attribute.codedComponents());
+      attribute.m_models.resize(attribute.codedComponents());
+      this->m_attributes.push_back(attribute);
+    }
+    if (this->m_attributes.empty()
+        || this->m_attributes[0].m_key != vesVertexAttributeKeys::Position) {
+      return false;
+    }
+
+    const unsigned int numberOfPrimitives = reader.readUInt32();
+    if (numberOfPrimitives > MaximumNumberOfPrimitives) {
+      return false;
+    }
+    for (unsigned int i = 0; i < numberOfPrimitives && !reader.failed(); ++i) {
+      vesCodedPrimitive primitive;
+      primitive.m_type = reader.readUInt32();
+      primitive.m_indexCount = reader.readUInt32();
+      primitive.m_numberOfIndices = reader.readUInt32();
+      if (primitive.m_numberOfIndices > MaximumNumberOfIndices
+          || (primitive.m_numberOfIndices && this->m_numberOfVertices > 65536)) {
+        return false;
+      }
+      this->m_primitives.push_back(primitive);
+    }
+
+    this->m_decoders.resize(1 + this->m_attributes.size());
+    for (size_t i = 0; i < this->m_decoders.size(); ++i) {
+      const unsigned int streamSize = reader.readUInt32();
+      const unsigned char *stream = reader.readBytes(streamSize);
+      if (!stream) {
+        return false;
+      }
+      this->m_decoders[i].initialize(stream, streamSize);
+    }
+    return !reader.failed();
+  }
+
+  bool decodeStreams()
+  {
+    size_t numberOfEdges = 0;
+    for (size_t i = 0; i < this->m_primitives.size(); ++i) {
+      const vesCodedPrimitive &primitive = this->m_primitives[i];
+      if (isTriangles(primitive.m_type, primitive.m_indexCount,
+                      primitive.m_numberOfIndices)) {
+        numberOfEdges += primitive.m_numberOfIndices;
+      }
+    }
+    vesEdgeTable edges(numberOfEdges);
+
+    this->m_indices.resize(this->m_primitives.size());
+    for (size_t i = 0; i < this->m_primitives.size() && !this->m_failed; ++i) {
+      const vesCodedPrimitive &primitive = this->m_primitives[i];
+      vesPrimitive::Indices &indices = this->m_indices[i];
+      indices.resize(primitive.m_numberOfIndices);
+
+      if (!isTriangles(primitive.m_type, primitive.m_indexCount, indices.size())) {
+        for (size_t j = 0; j < indices.size() && !this->m_failed; ++j) {
+          indices[j] = this->decodeIndex(this->m_connectivityModels[3],
+                                         previousPredictors(this->m_next - 1));
+        }
+        continue;
+      }
+
+      for (size_t j = 0; j < indices.size() && !this->m_failed; j += 3) {
+        int corners[3];
+        for (int k = 0; k < 3; ++k) {
+          corners[k] = this->decodeIndex(
+            this->m_connectivityModels[k],
+            cornerPredictors(corners, k, edges, this->m_next - 1));
+          indices[j + k] = corners[k];
+        }
+        edges.insert(corners[0], corners[1], corners[2]);
+        edges.insert(corners[1], corners[2], corners[0]);
+        edges.insert(corners[2], corners[0], corners[1]);
+      }
+    }
+
+    while (this->m_next < static_cast<int>(this->m_numberOfVertices) && !this->m_failed) {
+      this->decodeVertex(previousPredictors(this->m_next - 1));
+    }
+
+    for (size_t i = 0; i < this->m_decoders.size(); ++i) {
+      this->m_failed = this->m_failed || this->m_decoders[i].overrun();
+    }
+    return !this->m_failed;
+  }
+
+  int decodeIndex(vesValueModel &model, const vesPredictors &predictors)
+  {
+    const unsigned int distance = decodeValue(this->m_decoders[0], model, this->m_failed);
+    if (distance) {
+      if (distance > static_cast<unsigned int>(this->m_next)) {
+        this->m_failed = true;
+        return 0;
+      }
+      return this->m_next - static_cast<int>(distance);
+    }
+
+    if (this->m_next >= static_cast<int>(this->m_numberOfVertices)) {
+      this->m_failed = true;
+      return 0;
+    }
+    return this->decodeVertex(predictors);
+  }
+
+  int decodeVertex(const vesPredictors &predictors)
+  {
+    const int index = this->m_next++;
+    for (size_t i = 0; i < this->m_attributes.size(); ++i) {
+      vesCodedAttribute &attribute = this->m_attributes[i];
+      const unsigned int components = attribute.codedComponents();
+      int prediction[4];
+      predict(attribute, predictors, prediction);
+      for (unsigned int c = 0; c < components; ++c) {
+        // Corrupt residuals must not overflow, nor leave values out of range
+        // for the predictions of the next vertices.
+        long long value = static_cast<long long>(prediction[c]) + unzigzag(decodeValue(
+          this->m_decoders[i + 1], attribute.m_models[c], this->m_failed));
+        if (value < 0 || value > attribute.maximum()) {
+          this->m_failed = true;
+          value = 0;
+        }
+        attribute.m_values[index * components + c] = static_cast<int>(value);
+      }
+    }
+    return index;
+  }
+
+  void writeAttribute(const vesCodedAttribute &attribute, vesSourceData &source)
+  {
+    const int key = attribute.m_key;
+    char *data = static_cast<char*>(source.data());
+    const int stride = source.attributeStride(key);
+    const int offset = source.attributeOffset(key);
+    const unsigned int components = attribute.codedComponents();
+    const int *values = &attribute.m_values[0];
+
+    for (unsigned int i = 0; i < this->m_numberOfVertices; ++i, values += components) {
+      float decoded[4];
+      for (unsigned int c = 0; c < components; ++c) {
+        decoded[c] = attribute.m_minimum[c] + values[c] * attribute.m_step[c];
+      }
+      float *destination = reinterpret_cast<float*>(data + i * stride + offset);
+      if (attribute.m_encoding == OctahedralEncoding) {
+        octahedralDecode(decoded[0], decoded[1], destination);
+      }
+      else {
+        std::copy(decoded, decoded + components, destination);
+      }
+    }
+  }
+
+  vesGeometryData::Ptr createGeometryData()
+  {
+    vesGeometryData::Ptr geometryData(new vesGeometryData());
+    geometryData->setName(this->m_name);
+
+    bool hasTriangles = false;
+    for (size_t i = 0; i < this->m_primitives.size(); ++i) {
+      hasTriangles = hasTriangles || isTriangles(this->m_primitives[i].m_type,
+                                                 this->m_primitives[i].m_indexCount,
+                                                 this->m_primitives[i].m_numberOfIndices);
+    }
+    const bool hasNormals = this->m_attributes.size() > 1
+      && this->m_attributes[1].m_key == vesVertexAttributeKeys::Normal;
+    const bool computeNormals = !hasNormals && hasTriangles
+      && (this->m_flags & ComputeNormalsFlag);
+
+    for (size_t i = 0; i < this->m_attributes.size(); ++i) {
+      const vesCodedAttribute &attribute = this->m_attributes[i];
+      vesSourceData::Ptr source;
+      switch (attribute.m_key) {
+        case vesVertexAttributeKeys::Position:
+          if (hasNormals || computeNormals) {
+            source = vesSourceData::Ptr(new vesSourceDataP3N3f());
+          }
+          else {
+            source = vesSourceData::Ptr(new vesSourceDataP3f());
+          }
+          break;
+        case vesVertexAttributeKeys::Normal:
+          // Shares the position source.
+          this->writeAttribute(attribute, *geometryData->source(0));
+          continue;
+        case vesVertexAttributeKeys::TextureCoordinate:
+          if (attribute.m_numberOfComponents == 2) {
+            source = vesSourceData::Ptr(new vesSourceDataT2f());
+          }
+          else {
+            source = vesSourceData::Ptr(new vesSourceDataT3f());
+          }
+          break;
+        case vesVertexAttributeKeys::Color:
+          if (attribute.m_numberOfComponents == 3) {
+            source = vesSourceData::Ptr(new vesSourceDataC3f());
+          }
+          else {
+            source = vesSourceData::Ptr(new vesSourceDataC4f());
+          }
+          break;
+        default:
+          source = vesSourceData::Ptr(new vesSourceDataf());
+          break;
+      }
+
+      source->resize(this->m_numberOfVertices);
+      this->writeAttribute(attribute, *source);
+      geometryData->addSource(source);
+    }
+
+    for (size_t i = 0; i < this->m_primitives.size(); ++i) {
+      vesPrimitive::Ptr primitive(new vesPrimitive());
+      primitive->setPrimitiveType(this->m_primitives[i].m_type);
+      primitive->setIndexCount(this->m_primitives[i].m_indexCount);
+      primitive->indices()->swap(this->m_indices[i]);
+      geometryData->addPrimitive(primitive);
+    }
+
+    if (computeNormals) {
+      geometryData->computeNormals();
+    }
+    return geometryData;
+  }
+
+  std::string m_name;
+  unsigned int m_numberOfVertices;
+  unsigned int m_flags;
+  std::vector<vesCodedAttribute> m_attributes;
+  std::vector<vesCodedPrimitive> m_primitives;
+  std::vector<vesPrimitive::Indices> m_indices;
+
+  int m_next;
+  bool m_failed;
+  std::vector<vesRangeDecoder> m_decoders;
+  vesValueModel m_connectivityModels[4];
+};
+
+} // end namespace
+
+
+class vesMeshCodec::vesInternal
+{
+public:
+  vesInternal()
+  {
+    this->m_bits[vesVertexAttributeKeys::Position] = 14;
+    this->m_bits[vesVertexAttributeKeys::Normal] = 10;
+    this->m_bits[vesVertexAttributeKeys::TextureCoordinate] = 12;
+    this->m_bits[vesVertexAttributeKeys::Color] = 8;
+    this->m_bits[vesVertexAttributeKeys::Scalar] = 16;
+  }
+
+  int m_bits[vesVertexAttributeKeys::CountAttributeIndex];
+  std::string m_errorMessage;
+};
+
+
+vesMeshCodec::vesMeshCodec()
+{
+  this->m_internal = new vesInternal();
+}
+
+
+vesMeshCodec::~vesMeshCodec()
+{
+  delete this->m_internal;
+}
+
+
+void vesMeshCodec::setQuantizationBits(int key, int bits)
+{
+  if (key < 0 || key >= vesVertexAttributeKeys::CountAttributeIndex) {
+    return;
+  }
+
+  const int minimum = key == vesVertexAttributeKeys::Normal ? 0 : 1;
+  this->m_internal->m_bits[key] = std::max(minimum, std::min(24, bits));
+}
+
+
+int vesMeshCodec::quantizationBits(int key) const
+{
+  if (key < 0 || key >= vesVertexAttributeKeys::CountAttributeIndex) {
+    return 0;
+  }
+  return this->m_internal->m_bits[key];
+}
+
+
+bool vesMeshCodec::encode(vesGeometryData &geometryData,
+                          std::vector<unsigned char> &output)
+{
+  this->m_internal->m_errorMessage.clear();
+  output.clear();
+
+  if (!geometryData.lockData()) {
+    this->m_internal->m_errorMessage = "Cannot restore the geometry data";
+    return false;
+  }
+
+  vesMeshEncoder encoder(this->m_internal->m_bits);
+  const bool success = encoder.encode(geometryData, output,
+                                      this->m_internal->m_errorMessage);
+  geometryData.unlockData();
+
+  if (!success) {
+    output.clear();
+  }
+  return success;
+}
+
+
+vesSharedPtr<vesGeometryData> vesMeshCodec::decode(const unsigned char *data,
+                                                   size_t size)
+{
+  this->m_internal->m_errorMessage.clear();
+
+  vesMeshDecoder decoder;
+  return decoder.decode(data, size, this->m_internal->m_errorMessage);
+}
+
+
+bool vesMeshCodec::writeFile(vesGeometryData &geometryData,
+                             const std::string &fileName)
+{
+  std::vector<unsigned char> output;
+  if (!this->encode(geometryData, output)) {
+    return false;
+  }
+
+  FILE *file = fopen(fileName.c_str(), "wb");
+  if (!file) {
+    this->m_internal->m_errorMessage = "Cannot open " + fileName;
+    return false;
+  }
+
+  const bool success = fwrite(&output[0], 1, output.size(), file) == output.size();
+  if (fclose(file) != 0 || !success) {
+    remove(fileName.c_str());
+    this->m_internal->m_errorMessage = "Cannot write " + fileName;
+    return false;
+  }
+  return true;
+}
+
+
+vesSharedPtr<vesGeometryData> vesMeshCodec::readFile(const std::string &fileName)
+{
+  this->m_internal->m_errorMessage.clear();
+
+  FILE *file = fopen(fileName.c_str(), "rb");
+  if (!file) {
+    this->m_internal->m_errorMessage = "Cannot open " + fileName;
+    return vesGeometryData::Ptr();
+  }
+
+  std::vector<unsigned char> input;
+  unsigned char buffer[65536];
+  size_t size;
+  while ((size = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+    input.insert(input.end(), buffer, buffer + size);
+  }
+  const bool success = !ferror(file);
+  fclose(file);
+
+  if (!success || input.empty()) {
+    this->m_internal->m_errorMessage = "Cannot read " + fileName;
+    return vesGeometryData::Ptr();
+  }
+  return this->decode(&input[0], input.size());
+}
+
+
+bool vesMeshCodec::canReadFile(const std::string &fileName)
+{
+  const std::string extension = ".vesz";
+  if (fileName.size() <= extension.size()) {
+    return false;
+  }
+
+  for (size_t i = 0; i < extension.size(); ++i) {
+    if (tolower(fileName[fileName.size() - extension.size() + i]) != extension[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+
+const std::string& vesMeshCodec::errorMessage() const
+{
+  return this->m_internal->m_errorMessage;
+}
@@ -0,0 +1,96 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+/// \class vesMeshCodec
+/// \ingroup ves
+/// \brief Compact transport format for vesGeometryData.
+///
+/// Meant for meshes sent over the network: attributes are quantized, then
+/// coded together with the connectivity by an adaptive range coder.
+///
+/// Vertices are renumbered in the order the primitives first use them, so
+/// an index is coded as the distance back from the next new vertex, mostly
+/// zero or small. A new vertex is coded as its difference to a prediction
+/// from vertices already sent. Within triangles, that is the parallelogram
+/// completing the neighbouring triangle across the shared edge.
+///
+/// Positions are quantized on a grid over their bounding box and normals
+/// in octahedral coordinates. Colors are quantized over [0, 1] and other
+/// attributes over their range. Normals can be left out to be recomputed
+/// when decoding.
+///
+/// The data ends in a CRC-32 of the bytes before it, and the decoder checks
+/// every count and index it reads, so truncated or corrupt input fails to
+/// decode instead of producing a wrong mesh. Files use the .vesz extension.
+
+#ifndef VESMESHCODEC_H
+#define VESMESHCODEC_H
+
+// VES includes
+#include "vesSetGet.h"
+
+// C/C++ includes
+#include <string>
+#include <vector>
+
+// Forward declarations
+class vesGeometryData;
+
+class vesMeshCodec
+{
+public:
+  vesTypeMacro(vesMeshCodec);
+
+  vesMeshCodec();
+  ~vesMeshCodec();
+
+  /// Set the bits per component of the attribute \p key, one of
+  /// vesVertexAttributeKeys, between 1 and 24. Defaults are 14 for
+  /// positions, 10 for normals, 12 for texture coordinates, 8 for colors
+  /// and 16 for scalars. 0 bits drops the normals, which are computed again
+  /// when decoding.
+  void setQuantizationBits(int key, int bits);
+  int quantizationBits(int key) const;
+
+  /// Encode \p geometryData into \p output. Return false and set
+  /// errorMessage() for geometry that cannot be encoded, e.g. without
+  /// positions or with attributes that are not floats.
+  bool encode(vesGeometryData &geometryData, std::vector<unsigned char> &output);
+
+  /// Decode \p size bytes at \p data. Return an empty pointer and set
+  /// errorMessage() on failure.
+  vesSharedPtr<vesGeometryData> decode(const unsigned char *data, size_t size);
+
+  bool writeFile(vesGeometryData &geometryData, const std::string &fileName);
+  vesSharedPtr<vesGeometryData> readFile(const std::string &fileName);
+
+  /// Return true if \p fileName has the extension of encoded meshes.
+  static bool canReadFile(const std::string &fileName);
+
+  const std::string& errorMessage() const;
+
+private:
+  class vesInternal;
+  vesInternal *m_internal;
+
+  vesMeshCodec(const vesMeshCodec&);    // Not implemented
+  void operator=(const vesMeshCodec&); // Not implemented
+};
+
+#endif // VESMESHCODEC_H
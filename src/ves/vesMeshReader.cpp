@@ -0,0 +1,1698 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+
+#include "vesMeshReader.h"
+
+// VES includes
+#include "vesGeometryData.h"
+#include "vesThread.h"
+#include "vesThreadPool.h"
+
+// C/C++ includes
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+// Vertices addressable by the 16 bit indices of vesPrimitive
+const size_t MaximumNumberOfVertices = 65536;
+
+// Items per chunk of the binary decoding loops
+const size_t GrainSize = 16384;
+
+// Bytes per chunk of the text parsing loops
+const size_t TextChunkSize = 65536;
+
+
+class vesMappedFile
+{
+public:
+  vesMappedFile() : m_data(0x0), m_size(0), m_descriptor(-1)
+  {
+  }
+
+  ~vesMappedFile()
+  {
+    if (this->m_data) {
+      munmap(const_cast<char*>(this->m_data), this->m_size);
+    }
+    if (this->m_descriptor >= 0) {
+      close(this->m_descriptor);
+    }
+  }
+
+  bool open(const std::string &fileName)
+  {
+    this->m_descriptor = ::open(fileName.c_str(), O_RDONLY);
+    struct stat status;
+    if (this->m_descriptor < 0 || fstat(this->m_descriptor, &status) != 0
+        || status.st_size <= 0) {
+      return false;
+    }
+
+    this->m_size = static_cast<size_t>(status.st_size);
+    void *data = mmap(0x0, this->m_size, PROT_READ, MAP_PRIVATE,
+                      this->m_descriptor, 0);
+    if (data == MAP_FAILED) {
+      return false;
+    }
+    this->m_data = static_cast<const char*>(data);
+    return true;
+  }
+
+  const char* data() const { return this->m_data; }
+  size_t size() const { return this->m_size; }
+
+private:
+  const char *m_data;
+  size_t m_size;
+  int m_descriptor;
+};
+
+
+// Runs kernel.execute(begin, end) over [0, count) in chunks of GrainSize on
+// the shared pool. Every chunk writes its own part of the output, the order
+// chunks run in does not matter.
+template <class Kernel>
+void parallelFor(size_t count, int numberOfThreads, Kernel &kernel)
+{
+  vesThreadPool::instance()->parallelFor(count, GrainSize, kernel, numberOfThreads);
+}
+
+
+// Runs kernel.execute(chunk) for every chunk of text.
+template <class Kernel>
+class vesTextLoop
+{
+public:
+  vesTextLoop(Kernel &kernel) : m_kernel(kernel)
+  {
+  }
+
+  void execute(size_t begin, size_t end)
+  {
+    for (size_t chunk = begin; chunk < end; ++chunk) {
+      this->m_kernel.execute(chunk);
+    }
+  }
+
+private:
+  Kernel &m_kernel;
+};
+
+
+template <class Kernel>
+void parallelForChunks(size_t numberOfChunks, int numberOfThreads, Kernel &kernel)
+{
+  vesTextLoop<Kernel> loop(kernel);
+  vesThreadPool::instance()->parallelFor(numberOfChunks, 1, loop, numberOfThreads);
+}
+
+
+// Text cut into chunks of whole lines.
+class vesTextChunks
+{
+public:
+  vesTextChunks(const char *begin, const char *end, int numberOfThreads)
+  {
+    const size_t size = end - begin;
+    const size_t numberOfChunks = std::max(size_t(1), std::min(
+      size / TextChunkSize, static_cast<size_t>(16 * std::max(numberOfThreads, 1))));
+
+    this->m_boundaries.push_back(begin);
+    for (size_t i = 1; i < numberOfChunks; ++i) {
+      const char *p = std::max(begin + size * i / numberOfChunks,
+                               this->m_boundaries.back());
+      const char *newline = static_cast<const char*>(memchr(p, '\n', end - p));
+      this->m_boundaries.push_back(newline ? newline + 1 : end);
+    }
+    this->m_boundaries.push_back(end);
+  }
+
+  size_t size() const { return this->m_boundaries.size() - 1; }
+  const char* begin(size_t chunk) const { return this->m_boundaries[chunk]; }
+  const char* end(size_t chunk) const { return this->m_boundaries[chunk + 1]; }
+
+private:
+  std::vector<const char*> m_boundaries;
+};
+
+
+inline const char* lineEnd(const char *p, const char *end)
+{
+  const char *newline = static_cast<const char*>(memchr(p, '\n', end - p));
+  return newline ? newline : end;
+}
+
+
+inline bool isSpace(char c)
+{
+  return c == ' ' || c == '\t' || c == '\r' || c == '\f' || c == '\v';
+}
+
+
+// Copy the next whitespace separated token of [p, end) into buffer, which
+// can hold 64 characters, and advance p past it.
+bool nextToken(const char *&p, const char *end, char *buffer)
+{
+  while (p < end && isSpace(*p)) {
+    ++p;
+  }
+  const char *begin = p;
+  while (p < end && !isSpace(*p)) {
+    ++p;
+  }
+  const size_t length = p - begin;
+  if (!length || length > 63) {
+    return false;
+  }
+  memcpy(buffer, begin, length);
+  buffer[length] = '\0';
+  return true;
+}
+
+
+bool parseDouble(const char *&p, const char *end, double &value)
+{
+  char buffer[64];
+  if (!nextToken(p, end, buffer)) {
+    return false;
+  }
+  char *last;
+  value = strtod(buffer, &last);
+  return *last == '\0';
+}
+
+
+bool parseLong(const char *&p, const char *end, long &value)
+{
+  char buffer[64];
+  if (!nextToken(p, end, buffer)) {
+    return false;
+  }
+  char *last;
+  value = strtol(buffer, &last, 10);
+  return *last == '\0';
+}
+
+
+// Return true if the line at p starts with keyword followed by whitespace,
+// leaving p after the keyword.
+bool startsWith(const char *&p, const char *end, const char *keyword)
+{
+  const char *q = p;
+  while (q < end && isSpace(*q)) {
+    ++q;
+  }
+  const size_t length = strlen(keyword);
+  if (static_cast<size_t>(end - q) < length || memcmp(q, keyword, length) != 0
+      || (q + length < end && !isSpace(q[length]) && q[length] != '\n')) {
+    return false;
+  }
+  p = q + length;
+  return true;
+}
+
+
+bool isLittleEndian()
+{
+  const unsigned short value = 1;
+  return *reinterpret_cast<const unsigned char*>(&value) == 1;
+}
+
+
+template <typename T>
+inline T readValue(const char *p, bool swapBytes)
+{
+  T value;
+  if (!swapBytes) {
+    memcpy(&value, p, sizeof(T));
+  }
+  else {
+    char *bytes = reinterpret_cast<char*>(&value);
+    for (size_t i = 0; i < sizeof(T); ++i) {
+      bytes[i] = p[sizeof(T) - 1 - i];
+    }
+  }
+  return value;
+}
+
+
+// Mesh as it is parsed, moved into the geometry data sources at the end.
+struct vesMesh
+{
+  vesMesh() : m_hasNormals(false), m_hasFaces(false)
+  {
+  }
+
+  std::vector<vesVertexDataP3N3f> m_vertices;
+  std::vector<vesVertexDataC3f> m_colors;
+  std::vector<vesVertexDataT2f> m_textureCoordinates;
+  vesPrimitive::Indices m_triangles;
+  bool m_hasNormals;
+  bool m_hasFaces;
+};
+
+
+class vesPointsKernel
+{
+public:
+  vesPointsKernel(const vesVertexDataP3N3f *vertices, vesVertexDataP3f *points) :
+    m_vertices(vertices), m_points(points)
+  {
+  }
+
+  void execute(size_t begin, size_t end)
+  {
+    for (size_t i = begin; i < end; ++i) {
+      this->m_points[i].m_position = this->m_vertices[i].m_position;
+    }
+  }
+
+private:
+  const vesVertexDataP3N3f *m_vertices;
+  vesVertexDataP3f *m_points;
+};
+
+
+vesGeometryData::Ptr createGeometryData(vesMesh &mesh, int numberOfThreads)
+{
+  vesGeometryData::Ptr geometryData(new vesGeometryData());
+  geometryData->setName("PolyData");
+
+  if (!mesh.m_hasFaces) {
+    vesSourceDataP3f::Ptr sourceData(new vesSourceDataP3f());
+    sourceData->arrayReference().resize(mesh.m_vertices.size());
+    if (!mesh.m_vertices.empty()) {
+      vesPointsKernel kernel(&mesh.m_vertices[0], &sourceData->arrayReference()[0]);
+      parallelFor(mesh.m_vertices.size(), numberOfThreads, kernel);
+    }
+    geometryData->addSource(sourceData);
+
+    vesPrimitive::Ptr points(new vesPrimitive());
+    points->setPrimitiveType(vesPrimitiveRenderType::Points);
+    points->setIndexCount(1);
+    geometryData->addPrimitive(points);
+  }
+  else {
+    vesSourceDataP3N3f::Ptr sourceData(new vesSourceDataP3N3f());
+    sourceData->arrayReference().swap(mesh.m_vertices);
+    geometryData->addSource(sourceData);
+
+    vesPrimitive::Ptr triangles(new vesPrimitive());
+    triangles->setPrimitiveType(vesPrimitiveRenderType::Triangles);
+    triangles->setIndexCount(3);
+    triangles->indices()->swap(mesh.m_triangles);
+    geometryData->addPrimitive(triangles);
+
+    if (!mesh.m_hasNormals) {
+      geometryData->computeNormals();
+    }
+  }
+
+  if (!mesh.m_colors.empty()) {
+    vesSourceDataC3f::Ptr colors(new vesSourceDataC3f());
+    colors->arrayReference().swap(mesh.m_colors);
+    geometryData->addSource(colors);
+  }
+
+  if (!mesh.m_textureCoordinates.empty()) {
+    vesSourceDataT2f::Ptr textureCoordinates(new vesSourceDataT2f());
+    textureCoordinates->arrayReference().swap(mesh.m_textureCoordinates);
+    geometryData->addSource(textureCoordinates);
+  }
+
+  return geometryData;
+}
+
+
+// Merges positions that compare equal into one vertex, numbering vertices
+// in the order they first appear.
+class vesVertexWelder
+{
+public:
+  vesVertexWelder(size_t expectedNumberOfPositions)
+  {
+    size_t size = 1024;
+    while (size < 2 * expectedNumberOfPositions) {
+      size *= 2;
+    }
+    this->m_table.resize(size, -1);
+  }
+
+  /// Return the index of \p position, -1 once there are too many vertices.
+  int weld(const vesVector3f &position, std::vector<vesVertexDataP3N3f> &vertices)
+  {
+    const size_t mask = this->m_table.size() - 1;
+    for (size_t slot = hash(position) & mask; ; slot = (slot + 1) & mask) {
+      const int index = this->m_table[slot];
+      if (index < 0) {
+        if (vertices.size() >= MaximumNumberOfVertices) {
+          return -1;
+        }
+        vesVertexDataP3N3f vertex;
+        vertex.m_position = position;
+        vertices.push_back(vertex);
+        this->m_table[slot] = static_cast<int>(vertices.size() - 1);
+        return this->m_table[slot];
+      }
+      if (vertices[index].m_position == position) {
+        return index;
+      }
+    }
+  }
+
+private:
+  static size_t hash(const vesVector3f &position)
+  {
+    size_t value = 0;
+    for (int i = 0; i < 3; ++i) {
+      // Adding zero turns -0 into 0, which compares equal to it.
+      const float component = position[i] + 0.0f;
+      unsigned int bits;
+      memcpy(&bits, &component, sizeof(bits));
+      value = (value ^ bits) * 16777619u + 2166136261u;
+    }
+    return value ^ (value >> 15);
+  }
+
+  std::vector<int> m_table;
+};
+
+
+bool weldTriangles(const std::vector<vesVector3f> &corners, vesMesh &mesh)
+{
+  vesVertexWelder welder(corners.size() / 2);
+  mesh.m_triangles.reserve(corners.size());
+  for (size_t i = 0; i + 2 < corners.size(); i += 3) {
+    int triangle[3];
+    for (int j = 0; j < 3; ++j) {
+      triangle[j] = welder.weld(corners[i + j], mesh.m_vertices);
+      if (triangle[j] < 0) {
+        return false;
+      }
+    }
+
+    // Corners welded together leave nothing to draw.
+    if (triangle[0] != triangle[1] && triangle[0] != triangle[2]
+        && triangle[1] != triangle[2]) {
+      mesh.m_triangles.push_back(triangle[0]);
+      mesh.m_triangles.push_back(triangle[1]);
+      mesh.m_triangles.push_back(triangle[2]);
+    }
+  }
+  mesh.m_hasFaces = true;
+  return true;
+}
+
+
+//----------------------------------------------------------------------------
+// STL
+
+class vesBinarySTLKernel
+{
+public:
+  vesBinarySTLKernel(const char *records, bool swapBytes, vesVector3f *corners) :
+    m_records(records), m_swapBytes(swapBytes), m_corners(corners)
+  {
+  }
+
+  void execute(size_t begin, size_t end)
+  {
+    // Records are 50 bytes: normal, three corners, attribute byte count.
+    for (size_t i = begin; i < end; ++i) {
+      const char *record = this->m_records + 50 * i + 12;
+      for (int j = 0; j < 3; ++j) {
+        vesVector3f &corner = this->m_corners[3 * i + j];
+        for (int k = 0; k < 3; ++k) {
+          corner[k] = readValue<float>(record + 12 * j + 4 * k, this->m_swapBytes);
+        }
+      }
+    }
+  }
+
+private:
+  const char *m_records;
+  bool m_swapBytes;
+  vesVector3f *m_corners;
+};
+
+
+class vesAsciiSTLKernel
+{
+public:
+  vesAsciiSTLKernel(const vesTextChunks &chunks) :
+    m_chunks(chunks), m_corners(chunks.size()), m_failed(0)
+  {
+  }
+
+  void execute(size_t chunk)
+  {
+    const char *end = this->m_chunks.end(chunk);
+    std::vector<vesVector3f> &corners = this->m_corners[chunk];
+    for (const char *p = this->m_chunks.begin(chunk); p < end; ) {
+      const char *next = lineEnd(p, end);
+      if (startsWith(p, next, "vertex")) {
+        double x, y, z;
+        if (!parseDouble(p, next, x) || !parseDouble(p, next, y)
+            || !parseDouble(p, next, z)) {
+          __sync_fetch_and_or(&this->m_failed, 1);
+          return;
+        }
+        corners.push_back(vesVector3f(x, y, z));
+      }
+      p = next + 1;
+    }
+  }
+
+  const vesTextChunks &m_chunks;
+  std::vector<std::vector<vesVector3f> > m_corners;
+  int m_failed;
+};
+
+
+bool readSTL(const vesMappedFile &file, int numberOfThreads, vesMesh &mesh,
+             std::string &errorMessage)
+{
+  const char *data = file.data();
+  const size_t size = file.size();
+  std::vector<vesVector3f> corners;
+
+  const size_t numberOfTriangles =
+    size >= 84 ? readValue<unsigned int>(data + 80, !isLittleEndian()) : 0;
+  if (size >= 84 && size == 84 + 50 * numberOfTriangles) {
+    corners.resize(3 * numberOfTriangles);
+    if (numberOfTriangles) {
+      vesBinarySTLKernel kernel(data + 84, !isLittleEndian(), &corners[0]);
+      parallelFor(numberOfTriangles, numberOfThreads, kernel);
+    }
+  }
+  else {
+    const char *p = data;
+    if (!startsWith(p, data + size, "solid")) {
+      errorMessage = "Not an STL file";
+      return false;
+    }
+
+    vesTextChunks chunks(data, data + size, numberOfThreads);
+    vesAsciiSTLKernel kernel(chunks);
+    parallelForChunks(chunks.size(), numberOfThreads, kernel);
+    if (kernel.m_failed) {
+      errorMessage = "Invalid vertex in STL file";
+      return false;
+    }
+
+    for (size_t i = 0; i < chunks.size(); ++i) {
+      corners.insert(corners.end(), kernel.m_corners[i].begin(),
+                     kernel.m_corners[i].end());
+    }
+    if (corners.size() % 3) {
+      errorMessage = "STL facets must have three vertices";
+      return false;
+    }
+  }
+
+  // Also catches binary files cut short whose header starts with "solid".
+  if (corners.empty()) {
+    errorMessage = "STL file without facets";
+    return false;
+  }
+
+  if (!weldTriangles(corners, mesh)) {
+    errorMessage = "Too many vertices";
+    return false;
+  }
+  return true;
+}
+
+
+//----------------------------------------------------------------------------
+// PLY
+
+enum vesPLYType
+{
+  PLYInvalid,
+  PLYInt8,
+  PLYUInt8,
+  PLYInt16,
+  PLYUInt16,
+  PLYInt32,
+  PLYUInt32,
+  PLYFloat32,
+  PLYFloat64
+};
+
+
+enum vesPLYRole
+{
+  PLYIgnored,
+  PLYX, PLYY, PLYZ,
+  PLYNX, PLYNY, PLYNZ,
+  PLYRed, PLYGreen, PLYBlue,
+  PLYU, PLYV
+};
+
+
+struct vesPLYProperty
+{
+  vesPLYType m_type;
+  vesPLYType m_countType;
+  bool m_isList;
+  std::string m_name;
+  vesPLYRole m_role;
+};
+
+
+struct vesPLYElement
+{
+  std::string m_name;
+  size_t m_count;
+  std::vector<vesPLYProperty> m_properties;
+};
+
+
+vesPLYType plyType(const std::string &name)
+{
+  if (name == "char" || name == "int8") {
+    return PLYInt8;
+  }
+  if (name == "uchar" || name == "uint8") {
+    return PLYUInt8;
+  }
+  if (name == "short" || name == "int16") {
+    return PLYInt16;
+  }
+  if (name == "ushort" || name == "uint16") {
+    return PLYUInt16;
+  }
+  if (name == "int" || name == "int32") {
+    return PLYInt32;
+  }
+  if (name == "uint" || name == "uint32") {
+    return PLYUInt32;
+  }
+  if (name == "float" || name == "float32") {
+    return PLYFloat32;
+  }
+  if (name == "double" || name == "float64") {
+    return PLYFloat64;
+  }
+  return PLYInvalid;
+}
+
+
+size_t plyTypeSize(vesPLYType type)
+{
+  switch (type) {
+    case PLYInt8:
+    case PLYUInt8:
+      return 1;
+    case PLYInt16:
+    case PLYUInt16:
+      return 2;
+    case PLYInt32:
+    case PLYUInt32:
+    case PLYFloat32:
+      return 4;
+    case PLYFloat64:
+      return 8;
+    default:
+      return 0;
+  }
+}
+
+
+vesPLYRole plyVertexRole(const std::string &name)
+{
+  const char *names[] = {
+    "x", "y", "z", "nx", "ny", "nz", "red", "green", "blue", "u", "v" };
+  const char *alternateNames[] = {
+    "", "", "", "", "", "", "diffuse_red", "diffuse_green", "diffuse_blue",
+    "texture_u", "texture_v" };
+  const char *otherNames[] = {
+    "", "", "", "", "", "", "", "", "", "s", "t" };
+  for (int i = 0; i < 11; ++i) {
+    if (name == names[i] || name == alternateNames[i] || name == otherNames[i]) {
+      return static_cast<vesPLYRole>(PLYX + i);
+    }
+  }
+  return PLYIgnored;
+}
+
+
+double readPLYValue(const char *p, vesPLYType type, bool swapBytes)
+{
+  switch (type) {
+    case PLYInt8:
+      return *reinterpret_cast<const signed char*>(p);
+    case PLYUInt8:
+      return *reinterpret_cast<const unsigned char*>(p);
+    case PLYInt16:
+      return readValue<short>(p, swapBytes);
+    case PLYUInt16:
+      return readValue<unsigned short>(p, swapBytes);
+    case PLYInt32:
+      return readValue<int>(p, swapBytes);
+    case PLYUInt32:
+      return readValue<unsigned int>(p, swapBytes);
+    case PLYFloat32:
+      return readValue<float>(p, swapBytes);
+    case PLYFloat64:
+      return readValue<double>(p, swapBytes);
+    default:
+      return 0.0;
+  }
+}
+
+
+// Stores a vertex property value according to its role.
+class vesPLYVertexWriter
+{
+public:
+  vesPLYVertexWriter(vesMesh &mesh, const vesPLYElement &element) :
+    m_vertices(&mesh.m_vertices[0]),
+    m_colors(mesh.m_colors.empty() ? 0x0 : &mesh.m_colors[0]),
+    m_textureCoordinates(mesh.m_textureCoordinates.empty()
+                         ? 0x0 : &mesh.m_textureCoordinates[0])
+  {
+    for (size_t i = 0; i < element.m_properties.size(); ++i) {
+      // Integer colors range over 0-255, floating point ones over 0-1.
+      const vesPLYType type = element.m_properties[i].m_type;
+      this->m_colorScales.push_back(
+        type == PLYFloat32 || type == PLYFloat64 ? 1.0 : 1.0 / 255.0);
+    }
+  }
+
+  inline void write(size_t vertex, size_t property, vesPLYRole role, double value)
+  {
+    switch (role) {
+      case PLYX:
+      case PLYY:
+      case PLYZ:
+        this->m_vertices[vertex].m_position[role - PLYX] = value;
+        break;
+      case PLYNX:
+      case PLYNY:
+      case PLYNZ:
+        this->m_vertices[vertex].m_normal[role - PLYNX] = value;
+        break;
+      case PLYRed:
+      case PLYGreen:
+      case PLYBlue:
+        this->m_colors[vertex].m_color[role - PLYRed] =
+          value * this->m_colorScales[property];
+        break;
+      case PLYU:
+      case PLYV:
+        this->m_textureCoordinates[vertex].m_textureCoordinate[role - PLYU] = value;
+        break;
+      default:
+        break;
+    }
+  }
+
+private:
+  vesVertexDataP3N3f *m_vertices;
+  vesVertexDataC3f *m_colors;
+  vesVertexDataT2f *m_textureCoordinates;
+  std::vector<double> m_colorScales;
+};
+
+
+class vesBinaryPLYVertexKernel
+{
+public:
+  vesBinaryPLYVertexKernel(const char *data, const vesPLYElement &element,
+                           bool swapBytes, vesPLYVertexWriter &writer) :
+    m_data(data), m_element(element), m_swapBytes(swapBytes), m_stride(0),
+    m_writer(writer)
+  {
+    for (size_t i = 0; i < element.m_properties.size(); ++i) {
+      this->m_offsets.push_back(this->m_stride);
+      this->m_stride += plyTypeSize(element.m_properties[i].m_type);
+    }
+  }
+
+  size_t stride() const { return this->m_stride; }
+
+  void execute(size_t begin, size_t end)
+  {
+    const std::vector<vesPLYProperty> &properties = this->m_element.m_properties;
+    for (size_t i = begin; i < end; ++i) {
+      const char *record = this->m_data + i * this->m_stride;
+      for (size_t j = 0; j < properties.size(); ++j) {
+        if (properties[j].m_role != PLYIgnored) {
+          this->m_writer.write(i, j, properties[j].m_role, readPLYValue(
+            record + this->m_offsets[j], properties[j].m_type, this->m_swapBytes));
+        }
+      }
+    }
+  }
+
+private:
+  const char *m_data;
+  const vesPLYElement &m_element;
+  bool m_swapBytes;
+  size_t m_stride;
+  std::vector<size_t> m_offsets;
+  vesPLYVertexWriter &m_writer;
+};
+
+
+// Fan of triangles of a face, checking that its vertices exist.
+inline bool writeFan(const unsigned int *corners, size_t numberOfCorners,
+                     size_t numberOfVertices, unsigned short *triangles)
+{
+  for (size_t i = 0; i < numberOfCorners; ++i) {
+    if (corners[i] >= numberOfVertices) {
+      return false;
+    }
+  }
+  for (size_t i = 2; i < numberOfCorners; ++i) {
+    *triangles++ = corners[0];
+    *triangles++ = corners[i - 1];
+    *triangles++ = corners[i];
+  }
+  return true;
+}
+
+
+class vesBinaryPLYFaceKernel
+{
+public:
+  vesBinaryPLYFaceKernel(const char *data, const vesPLYProperty &indices,
+                         const std::vector<size_t> &indexOffsets,
+                         const std::vector<size_t> &triangleOffsets,
+                         bool swapBytes, size_t numberOfVertices,
+                         unsigned short *triangles) :
+    m_data(data), m_indices(indices), m_indexOffsets(indexOffsets),
+    m_triangleOffsets(triangleOffsets), m_swapBytes(swapBytes),
+    m_numberOfVertices(numberOfVertices), m_triangles(triangles), m_failed(0)
+  {
+  }
+
+  void execute(size_t begin, size_t end)
+  {
+    const size_t countSize = plyTypeSize(this->m_indices.m_countType);
+    const size_t indexSize = plyTypeSize(this->m_indices.m_type);
+    std::vector<unsigned int> corners;
+    for (size_t i = begin; i < end; ++i) {
+      const char *list = this->m_data + this->m_indexOffsets[i];
+      const size_t count = static_cast<size_t>(
+        readPLYValue(list, this->m_indices.m_countType, this->m_swapBytes));
+      corners.resize(count);
+      for (size_t j = 0; j < count; ++j) {
+        const double index = readPLYValue(list + countSize + j * indexSize,
+                                          this->m_indices.m_type, this->m_swapBytes);
+        corners[j] = index < 0.0 ? this->m_numberOfVertices
+                                 : static_cast<unsigned int>(index);
+      }
+      if (count >= 3 && !writeFan(&corners[0], count, this->m_numberOfVertices,
+                                  this->m_triangles + 3 * this->m_triangleOffsets[i])) {
+        __sync_fetch_and_or(&this->m_failed, 1);
+        return;
+      }
+    }
+  }
+
+  int failed() const { return this->m_failed; }
+
+private:
+  const char *m_data;
+  const vesPLYProperty &m_indices;
+  const std::vector<size_t> &m_indexOffsets;
+  const std::vector<size_t> &m_triangleOffsets;
+  bool m_swapBytes;
+  size_t m_numberOfVertices;
+  unsigned short *m_triangles;
+  int m_failed;
+};
+
+
+// The body of an ASCII PLY file, one element item per line.
+class vesAsciiPLYKernel
+{
+public:
+  enum Pass
+  {
+    CountLines,
+    ReadVertices,
+    ReadFaces
+  };
+
+  vesAsciiPLYKernel(const vesTextChunks &chunks,
+                    const std::vector<vesPLYElement> &elements) :
+    m_chunks(chunks), m_elements(elements), m_pass(CountLines),
+    m_vertexElement(0), m_faceElement(0), m_indexProperty(0),
+    m_writer(0x0), m_triangles(0x0), m_numberOfVertices(0),
+    m_lineCounts(chunks.size()), m_firstLines(chunks.size()),
+    m_triangleCounts(chunks.size()), m_firstTriangles(chunks.size()),
+    m_failed(0)
+  {
+    size_t line = 0;
+    for (size_t i = 0; i < elements.size(); ++i) {
+      this->m_elementLines.push_back(line);
+      line += elements[i].m_count;
+    }
+    this->m_elementLines.push_back(line);
+  }
+
+  void execute(size_t chunk)
+  {
+    const char *end = this->m_chunks.end(chunk);
+    size_t line = this->m_firstLines[chunk];
+    size_t triangle = this->m_firstTriangles[chunk];
+    size_t lines = 0;
+    size_t triangles = 0;
+    std::vector<unsigned int> corners;
+
+    for (const char *p = this->m_chunks.begin(chunk); p < end; ++line, ++lines) {
+      const char *next = lineEnd(p, end);
+      if (this->m_pass == ReadVertices && this->isLineOf(line, this->m_vertexElement)) {
+        if (!this->readVertex(p, next, line - this->m_elementLines[this->m_vertexElement])) {
+          __sync_fetch_and_or(&this->m_failed, 1);
+          return;
+        }
+      }
+      else if (this->m_pass != CountLines && this->isLineOf(line, this->m_faceElement)) {
+        if (!this->readFace(p, next, corners)) {
+          __sync_fetch_and_or(&this->m_failed, 1);
+          return;
+        }
+        if (corners.size() >= 3) {
+          if (this->m_pass == ReadFaces && !writeFan(
+                &corners[0], corners.size(), this->m_numberOfVertices,
+                this->m_triangles + 3 * triangle)) {
+            __sync_fetch_and_or(&this->m_failed, 1);
+            return;
+          }
+          triangle += corners.size() - 2;
+          triangles += corners.size() - 2;
+        }
+      }
+      p = next + 1;
+    }
+
+    this->m_lineCounts[chunk] = lines;
+    this->m_triangleCounts[chunk] = triangles;
+  }
+
+  bool isLineOf(size_t line, size_t element) const
+  {
+    return element < this->m_elements.size() && line >= this->m_elementLines[element]
+      && line < this->m_elementLines[element + 1];
+  }
+
+  bool readVertex(const char *p, const char *end, size_t vertex)
+  {
+    const std::vector<vesPLYProperty> &properties =
+      this->m_elements[this->m_vertexElement].m_properties;
+    for (size_t i = 0; i < properties.size(); ++i) {
+      double value;
+      if (!parseDouble(p, end, value)) {
+        return false;
+      }
+      this->m_writer->write(vertex, i, properties[i].m_role, value);
+    }
+    return true;
+  }
+
+  bool readFace(const char *p, const char *end, std::vector<unsigned int> &corners)
+  {
+    corners.clear();
+    const std::vector<vesPLYProperty> &properties =
+      this->m_elements[this->m_faceElement].m_properties;
+    for (size_t i = 0; i < properties.size(); ++i) {
+      long count = 1;
+      if (properties[i].m_isList && (!parseLong(p, end, count) || count < 0)) {
+        return false;
+      }
+      for (long j = 0; j < count; ++j) {
+        double value;
+        if (!parseDouble(p, end, value)) {
+          return false;
+        }
+        if (i == this->m_indexProperty) {
+          corners.push_back(value < 0.0 ? this->m_numberOfVertices
+                                        : static_cast<unsigned int>(value));
+        }
+      }
+    }
+    return true;
+  }
+
+  const vesTextChunks &m_chunks;
+  const std::vector<vesPLYElement> &m_elements;
+  std::vector<size_t> m_elementLines;
+  Pass m_pass;
+  size_t m_vertexElement;
+  size_t m_faceElement;
+  size_t m_indexProperty;
+  vesPLYVertexWriter *m_writer;
+  unsigned short *m_triangles;
+  size_t m_numberOfVertices;
+  std::vector<size_t> m_lineCounts;
+  std::vector<size_t> m_firstLines;
+  std::vector<size_t> m_triangleCounts;
+  std::vector<size_t> m_firstTriangles;
+  int m_failed;
+};
+
+
+bool readPLYHeader(const vesMappedFile &file, std::vector<vesPLYElement> &elements,
+                   std::string &format, size_t &bodyOffset)
+{
+  const char *data = file.data();
+  const char *end = data + file.size();
+  const char *p = data;
+  if (!startsWith(p, end, "ply")) {
+    return false;
+  }
+
+  for (p = lineEnd(data, end) + 1; p < end; ) {
+    const char *next = lineEnd(p, end);
+    char keyword[64];
+    const char *q = p;
+    if (!nextToken(q, next, keyword)) {
+      p = next + 1;
+      continue;
+    }
+
+    const std::string word(keyword);
+    char buffer[64];
+    if (word == "format") {
+      if (!nextToken(q, next, buffer)) {
+        return false;
+      }
+      format = buffer;
+    }
+    else if (word == "element") {
+      long count;
+      if (!nextToken(q, next, buffer) || !parseLong(q, next, count) || count < 0) {
+        return false;
+      }
+      vesPLYElement element;
+      element.m_name = buffer;
+      element.m_count = static_cast<size_t>(count);
+      elements.push_back(element);
+    }
+    else if (word == "property") {
+      if (elements.empty() || !nextToken(q, next, buffer)) {
+        return false;
+      }
+      vesPLYProperty property;
+      property.m_isList = std::string(buffer) == "list";
+      property.m_countType = PLYInvalid;
+      if (property.m_isList) {
+        if (!nextToken(q, next, buffer)) {
+          return false;
+        }
+        property.m_countType = plyType(buffer);
+        if (!nextToken(q, next, buffer)) {
+          return false;
+        }
+      }
+      property.m_type = plyType(buffer);
+      if (!nextToken(q, next, buffer) || property.m_type == PLYInvalid
+          || (property.m_isList && property.m_countType == PLYInvalid)) {
+        return false;
+      }
+      property.m_name = buffer;
+      property.m_role = elements.back().m_name == "vertex"
+        ? plyVertexRole(property.m_name) : PLYIgnored;
+      elements.back().m_properties.push_back(property);
+    }
+    else if (word == "end_header") {
+      bodyOffset = (next - data) + 1;
+      return true;
+    }
+    p = next + 1;
+  }
+  return false;
+}
+
+
+bool readPLY(const vesMappedFile &file, int numberOfThreads, vesMesh &mesh,
+             std::string &errorMessage)
+{
+  std::vector<vesPLYElement> elements;
+  std::string format;
+  size_t bodyOffset = 0;
+  if (!readPLYHeader(file, elements, format, bodyOffset)) {
+    errorMessage = "Invalid PLY header";
+    return false;
+  }
+
+  const bool ascii = format == "ascii";
+  const bool swapBytes = (format == "binary_little_endian") != isLittleEndian();
+  if (!ascii && format != "binary_little_endian" && format != "binary_big_endian") {
+    errorMessage = "Unknown PLY format " + format;
+    return false;
+  }
+
+  // Find the vertex element, its roles, and the face element.
+  size_t vertexElement = elements.size();
+  size_t faceElement = elements.size();
+  size_t indexProperty = 0;
+  bool hasRole[PLYV + 1] = { false };
+  for (size_t i = 0; i < elements.size(); ++i) {
+    if (elements[i].m_name == "vertex" && vertexElement == elements.size()) {
+      vertexElement = i;
+      for (size_t j = 0; j < elements[i].m_properties.size(); ++j) {
+        if (elements[i].m_properties[j].m_isList) {
+          errorMessage = "PLY vertex list properties are not supported";
+          return false;
+        }
+        hasRole[elements[i].m_properties[j].m_role] = true;
+      }
+    }
+    else if (elements[i].m_name == "face" && faceElement == elements.size()) {
+      for (size_t j = 0; j < elements[i].m_properties.size(); ++j) {
+        const vesPLYProperty &property = elements[i].m_properties[j];
+        if (property.m_isList && (property.m_name == "vertex_indices"
+                                  || property.m_name == "vertex_index")) {
+          faceElement = i;
+          indexProperty = j;
+        }
+      }
+    }
+  }
+
+  if (vertexElement == elements.size() || !hasRole[PLYX] || !hasRole[PLYY]
+      || !hasRole[PLYZ]) {
+    errorMessage = "PLY file without vertex positions";
+    return false;
+  }
+
+  const size_t numberOfVertices = elements[vertexElement].m_count;
+  mesh.m_hasFaces = faceElement < elements.size() && elements[faceElement].m_count;
+  mesh.m_hasNormals = hasRole[PLYNX] && hasRole[PLYNY] && hasRole[PLYNZ];
+  if (mesh.m_hasFaces && numberOfVertices > MaximumNumberOfVertices) {
+    errorMessage = "Too many vertices";
+    return false;
+  }
+
+  vesVertexDataP3N3f vertex;
+  vertex.m_position = vesVector3f(0.0f, 0.0f, 0.0f);
+  vertex.m_normal = vesVector3f(0.0f, 0.0f, 0.0f);
+  mesh.m_vertices.resize(numberOfVertices, vertex);
+  if (!numberOfVertices) {
+    errorMessage = "PLY file without vertices";
+    return false;
+  }
+  if (hasRole[PLYRed] && hasRole[PLYGreen] && hasRole[PLYBlue]) {
+    mesh.m_colors.resize(numberOfVertices);
+  }
+  if (hasRole[PLYU] && hasRole[PLYV]) {
+    mesh.m_textureCoordinates.resize(numberOfVertices);
+  }
+  vesPLYVertexWriter writer(mesh, elements[vertexElement]);
+
+  const char *body = file.data() + bodyOffset;
+  const char *end = file.data() + file.size();
+
+  if (ascii) {
+    vesTextChunks chunks(body, end, numberOfThreads);
+    vesAsciiPLYKernel kernel(chunks, elements);
+    kernel.m_vertexElement = vertexElement;
+    kernel.m_faceElement = faceElement;
+    kernel.m_indexProperty = indexProperty;
+    kernel.m_writer = &writer;
+    kernel.m_numberOfVertices = numberOfVertices;
+
+    // Number the lines of every chunk first, so that they can be matched
+    // with the elements; faces are counted while reading the vertices.
+    parallelForChunks(chunks.size(), numberOfThreads, kernel);
+    size_t lines = 0;
+    for (size_t i = 0; i < chunks.size(); ++i) {
+      kernel.m_firstLines[i] = lines;
+      lines += kernel.m_lineCounts[i];
+    }
+    if (lines < kernel.m_elementLines.back()) {
+      errorMessage = "PLY file is truncated";
+      return false;
+    }
+
+    kernel.m_pass = vesAsciiPLYKernel::ReadVertices;
+    parallelForChunks(chunks.size(), numberOfThreads, kernel);
+    size_t triangles = 0;
+    for (size_t i = 0; i < chunks.size(); ++i) {
+      kernel.m_firstTriangles[i] = triangles;
+      triangles += kernel.m_triangleCounts[i];
+    }
+
+    mesh.m_triangles.resize(3 * triangles);
+    if (triangles && !kernel.m_failed) {
+      kernel.m_triangles = &mesh.m_triangles[0];
+      kernel.m_pass = vesAsciiPLYKernel::ReadFaces;
+      parallelForChunks(chunks.size(), numberOfThreads, kernel);
+    }
+    if (kernel.m_failed) {
+      errorMessage = "Invalid PLY element";
+      return false;
+    }
+    return true;
+  }
+
+  // Binary elements follow each other, their items being variable in size
+  // only if they have list properties.
+  const char *p = body;
+  for (size_t i = 0; i < elements.size(); ++i) {
+    const vesPLYElement &element = elements[i];
+
+    if (i == vertexElement) {
+      vesBinaryPLYVertexKernel kernel(p, element, swapBytes, writer);
+      if (static_cast<size_t>(end - p) / kernel.stride() < element.m_count) {
+        errorMessage = "PLY file is truncated";
+        return false;
+      }
+      parallelFor(element.m_count, numberOfThreads, kernel);
+      p += element.m_count * kernel.stride();
+      continue;
+    }
+
+    // Walk the items to find where each starts, recording the faces.
+    std::vector<size_t> indexOffsets;
+    std::vector<size_t> triangleOffsets;
+    size_t triangles = 0;
+    if (i == faceElement) {
+      indexOffsets.resize(element.m_count);
+      triangleOffsets.resize(element.m_count);
+    }
+    for (size_t j = 0; j < element.m_count; ++j) {
+      for (size_t k = 0; k < element.m_properties.size(); ++k) {
+        const vesPLYProperty &property = element.m_properties[k];
+        size_t size = plyTypeSize(property.m_type);
+        if (property.m_isList) {
+          const size_t countSize = plyTypeSize(property.m_countType);
+          if (static_cast<size_t>(end - p) < countSize) {
+            errorMessage = "PLY file is truncated";
+            return false;
+          }
+          const double count = readPLYValue(p, property.m_countType, swapBytes);
+          if (count < 0.0) {
+            errorMessage = "Invalid PLY list";
+            return false;
+          }
+          if (i == faceElement && k == indexProperty) {
+            indexOffsets[j] = p - body;
+            triangleOffsets[j] = triangles;
+            triangles += count >= 3.0 ? static_cast<size_t>(count) - 2 : 0;
+          }
+          size = countSize + static_cast<size_t>(count) * size;
+        }
+        if (static_cast<size_t>(end - p) < size) {
+          errorMessage = "PLY file is truncated";
+          return false;
+        }
+        p += size;
+      }
+    }
+
+    if (i == faceElement && triangles) {
+      mesh.m_triangles.resize(3 * triangles);
+      vesBinaryPLYFaceKernel kernel(body, element.m_properties[indexProperty],
+                                    indexOffsets, triangleOffsets, swapBytes,
+                                    numberOfVertices, &mesh.m_triangles[0]);
+      parallelFor(element.m_count, numberOfThreads, kernel);
+      if (kernel.failed()) {
+        errorMessage = "Invalid PLY face";
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+
+//----------------------------------------------------------------------------
+// OBJ
+
+// Index of a face corner, counted from the first item of the file, or from
+// the first item of the chunk when the file gave it relative to the end.
+struct vesOBJIndex
+{
+  int m_value;
+  bool m_relative;
+};
+
+
+struct vesOBJCorner
+{
+  vesOBJIndex m_position;
+  vesOBJIndex m_textureCoordinate;
+  vesOBJIndex m_normal;
+};
+
+
+struct vesOBJChunk
+{
+  std::vector<vesVector3f> m_positions;
+  std::vector<vesVector3f> m_normals;
+  std::vector<vesVector2f> m_textureCoordinates;
+  std::vector<vesOBJCorner> m_corners;
+  std::vector<unsigned int> m_faceSizes;
+};
+
+
+class vesOBJKernel
+{
+public:
+  vesOBJKernel(const vesTextChunks &chunks) :
+    m_chunks(chunks), m_results(chunks.size()), m_failed(0), m_unsupported(0)
+  {
+  }
+
+  void execute(size_t chunk)
+  {
+    const char *end = this->m_chunks.end(chunk);
+    vesOBJChunk &result = this->m_results[chunk];
+    for (const char *p = this->m_chunks.begin(chunk); p < end; ) {
+      const char *next = lineEnd(p, end);
+      if (!this->readLine(p, next, result)) {
+        __sync_fetch_and_or(&this->m_failed, 1);
+        return;
+      }
+      p = next + 1;
+    }
+  }
+
+  bool readLine(const char *p, const char *end, vesOBJChunk &result)
+  {
+    double values[3];
+    if (startsWith(p, end, "v")) {
+      for (int i = 0; i < 3; ++i) {
+        if (!parseDouble(p, end, values[i])) {
+          return false;
+        }
+      }
+      result.m_positions.push_back(vesVector3f(values[0], values[1], values[2]));
+    }
+    else if (startsWith(p, end, "vn")) {
+      for (int i = 0; i < 3; ++i) {
+        if (!parseDouble(p, end, values[i])) {
+          return false;
+        }
+      }
+      result.m_normals.push_back(vesVector3f(values[0], values[1], values[2]));
+    }
+    else if (startsWith(p, end, "vt")) {
+      if (!parseDouble(p, end, values[0])) {
+        return false;
+      }
+      if (!parseDouble(p, end, values[1])) {
+        values[1] = 0.0;
+      }
+      result.m_textureCoordinates.push_back(vesVector2f(values[0], values[1]));
+    }
+    else if (startsWith(p, end, "f")) {
+      char buffer[64];
+      unsigned int size = 0;
+      while (nextToken(p, end, buffer)) {
+        vesOBJCorner corner;
+        if (!this->readCorner(buffer, result, corner)) {
+          return false;
+        }
+        result.m_corners.push_back(corner);
+        ++size;
+      }
+      result.m_faceSizes.push_back(size);
+    }
+    else if (startsWith(p, end, "l") || startsWith(p, end, "p")) {
+      __sync_fetch_and_or(&this->m_unsupported, 1);
+    }
+    return true;
+  }
+
+  // Parse "v", "v/vt", "v//vn" or "v/vt/vn".
+  bool readCorner(const char *token, const vesOBJChunk &result, vesOBJCorner &corner)
+  {
+    vesOBJIndex *indices[3] = {
+      &corner.m_position, &corner.m_textureCoordinate, &corner.m_normal };
+    const size_t counts[3] = {
+      result.m_positions.size(), result.m_textureCoordinates.size(),
+      result.m_normals.size() };
+
+    for (int i = 0; i < 3; ++i) {
+      indices[i]->m_value = -1;
+      indices[i]->m_relative = false;
+    }
+
+    for (int i = 0; i < 3; ++i) {
+      if (*token && *token != '/') {
+        char *last;
+        const long value = strtol(token, &last, 10);
+        if (last == token || value == 0) {
+          return false;
+        }
+        if (value > 0) {
+          indices[i]->m_value = static_cast<int>(value - 1);
+        }
+        else {
+          indices[i]->m_value = static_cast<int>(counts[i] + value);
+          indices[i]->m_relative = true;
+        }
+        token = last;
+      }
+      else if (i == 0) {
+        return false;
+      }
+
+      if (*token != '/') {
+        break;
+      }
+      ++token;
+    }
+    return *token == '\0';
+  }
+
+  const vesTextChunks &m_chunks;
+  std::vector<vesOBJChunk> m_results;
+  int m_failed;
+  int m_unsupported;
+};
+
+
+// Vertex of a face corner, merging corners with identical indices.
+class vesOBJCornerWelder
+{
+public:
+  vesOBJCornerWelder(size_t expectedNumberOfCorners)
+  {
+    size_t size = 1024;
+    while (size < 2 * expectedNumberOfCorners) {
+      size *= 2;
+    }
+    this->m_table.resize(size, -1);
+  }
+
+  int weld(const int corner[3])
+  {
+    const size_t mask = this->m_table.size() - 1;
+    size_t hash = 2166136261u;
+    for (int i = 0; i < 3; ++i) {
+      hash = (hash ^ static_cast<unsigned int>(corner[i])) * 16777619u;
+    }
+    for (size_t slot = (hash ^ (hash >> 15)) & mask; ; slot = (slot + 1) & mask) {
+      const int index = this->m_table[slot];
+      if (index < 0) {
+        if (this->m_corners.size() / 3 >= MaximumNumberOfVertices) {
+          return -1;
+        }
+        this->m_corners.insert(this->m_corners.end(), corner, corner + 3);
+        this->m_table[slot] = static_cast<int>(this->m_corners.size() / 3 - 1);
+        return this->m_table[slot];
+      }
+      if (std::equal(corner, corner + 3, &this->m_corners[3 * index])) {
+        return index;
+      }
+    }
+  }
+
+  const std::vector<int>& corners() const { return this->m_corners; }
+
+private:
+  std::vector<int> m_table;
+  std::vector<int> m_corners;
+};
+
+
+bool readOBJ(const vesMappedFile &file, int numberOfThreads, vesMesh &mesh,
+             std::string &errorMessage)
+{
+  vesTextChunks chunks(file.data(), file.data() + file.size(), numberOfThreads);
+  vesOBJKernel kernel(chunks);
+  parallelForChunks(chunks.size(), numberOfThreads, kernel);
+  if (kernel.m_failed) {
+    errorMessage = "Invalid OBJ statement";
+    return false;
+  }
+  if (kernel.m_unsupported) {
+    errorMessage = "OBJ lines and points are not supported";
+    return false;
+  }
+
+  // Gather the items and resolve the corner indices.
+  std::vector<vesVector3f> positions;
+  std::vector<vesVector3f> normals;
+  std::vector<vesVector2f> textureCoordinates;
+  std::vector<int> corners;
+  std::vector<unsigned int> faceSizes;
+  bool allTextureCoordinates = true;
+  bool allNormals = true;
+  bool sharedIndices = true;
+  bool missingVertex = false;
+  for (size_t i = 0; i < chunks.size(); ++i) {
+    const vesOBJChunk &chunk = kernel.m_results[i];
+    const int bases[3] = {
+      static_cast<int>(positions.size()),
+      static_cast<int>(textureCoordinates.size()),
+      static_cast<int>(normals.size()) };
+
+    for (size_t j = 0; j < chunk.m_corners.size(); ++j) {
+      const vesOBJIndex *indices[3] = {
+        &chunk.m_corners[j].m_position, &chunk.m_corners[j].m_textureCoordinate,
+        &chunk.m_corners[j].m_normal };
+      int corner[3];
+      for (int k = 0; k < 3; ++k) {
+        corner[k] = indices[k]->m_value;
+        // A relative index reaching before the first item must not pass
+        // for an absent one.
+        if (indices[k]->m_relative) {
+          corner[k] += bases[k];
+          missingVertex = missingVertex || corner[k] < 0;
+        }
+      }
+      allTextureCoordinates = allTextureCoordinates && corner[1] >= 0;
+      allNormals = allNormals && corner[2] >= 0;
+      sharedIndices = sharedIndices && (corner[1] < 0 || corner[1] == corner[0])
+        && (corner[2] < 0 || corner[2] == corner[0]);
+      corners.insert(corners.end(), corner, corner + 3);
+    }
+
+    positions.insert(positions.end(), chunk.m_positions.begin(),
+                     chunk.m_positions.end());
+    normals.insert(normals.end(), chunk.m_normals.begin(), chunk.m_normals.end());
+    textureCoordinates.insert(textureCoordinates.end(),
+                              chunk.m_textureCoordinates.begin(),
+                              chunk.m_textureCoordinates.end());
+    faceSizes.insert(faceSizes.end(), chunk.m_faceSizes.begin(),
+                     chunk.m_faceSizes.end());
+  }
+
+  if (positions.empty()) {
+    errorMessage = "OBJ file without vertices";
+    return false;
+  }
+
+  const size_t counts[3] = {
+    positions.size(), textureCoordinates.size(), normals.size() };
+  if (missingVertex) {
+    errorMessage = "OBJ face refers to a missing vertex";
+    return false;
+  }
+  for (size_t i = 0; i < corners.size(); ++i) {
+    if (corners[i] >= static_cast<int>(counts[i % 3])
+        || (i % 3 == 0 && corners[i] < 0)) {
+      errorMessage = "OBJ face refers to a missing vertex";
+      return false;
+    }
+  }
+
+  // Attributes given for only some corners are dropped.
+  const bool useTextureCoordinates = allTextureCoordinates && !corners.empty();
+  const bool useNormals = allNormals && !corners.empty();
+  mesh.m_hasFaces = !faceSizes.empty();
+  mesh.m_hasNormals = useNormals;
+
+  // Corners index positions, texture coordinates and normals separately,
+  // vertices need them to match: unless the file shares its indices,
+  // every distinct combination becomes a vertex.
+  std::vector<int> vertexCorners;
+  std::vector<int> cornerVertices(corners.size() / 3);
+  if (sharedIndices && (!useTextureCoordinates || counts[1] >= counts[0])
+      && (!useNormals || counts[2] >= counts[0])) {
+    for (size_t i = 0; i < counts[0]; ++i) {
+      const int corner[3] = { static_cast<int>(i), static_cast<int>(i),
+                              static_cast<int>(i) };
+      vertexCorners.insert(vertexCorners.end(), corner, corner + 3);
+    }
+    for (size_t i = 0; i < cornerVertices.size(); ++i) {
+      cornerVertices[i] = corners[3 * i];
+    }
+    if (mesh.m_hasFaces && counts[0] > MaximumNumberOfVertices) {
+      errorMessage = "Too many vertices";
+      return false;
+    }
+  }
+  else {
+    vesOBJCornerWelder welder(cornerVertices.size());
+    for (size_t i = 0; i < cornerVertices.size(); ++i) {
+      int corner[3] = { corners[3 * i],
+                        useTextureCoordinates ? corners[3 * i + 1] : -1,
+                        useNormals ? corners[3 * i + 2] : -1 };
+      cornerVertices[i] = welder.weld(corner);
+      if (cornerVertices[i] < 0) {
+        errorMessage = "Too many vertices";
+        return false;
+      }
+    }
+    vertexCorners = welder.corners();
+  }
+
+  const size_t numberOfVertices = vertexCorners.size() / 3;
+  mesh.m_vertices.resize(numberOfVertices);
+  if (useTextureCoordinates) {
+    mesh.m_textureCoordinates.resize(numberOfVertices);
+  }
+  for (size_t i = 0; i < numberOfVertices; ++i) {
+    mesh.m_vertices[i].m_position = positions[vertexCorners[3 * i]];
+    if (useNormals) {
+      mesh.m_vertices[i].m_normal = normals[vertexCorners[3 * i + 2]];
+    }
+    if (useTextureCoordinates) {
+      mesh.m_textureCoordinates[i].m_textureCoordinate =
+        textureCoordinates[vertexCorners[3 * i + 1]];
+    }
+  }
+
+  size_t numberOfTriangles = 0;
+  for (size_t i = 0; i < faceSizes.size(); ++i) {
+    numberOfTriangles += faceSizes[i] >= 3 ? faceSizes[i] - 2 : 0;
+  }
+  mesh.m_triangles.reserve(3 * numberOfTriangles);
+  const int *faceVertices = cornerVertices.empty() ? 0x0 : &cornerVertices[0];
+  for (size_t i = 0; i < faceSizes.size(); faceVertices += faceSizes[i++]) {
+    for (unsigned int j = 2; j < faceSizes[i]; ++j) {
+      mesh.m_triangles.push_back(faceVertices[0]);
+      mesh.m_triangles.push_back(faceVertices[j - 1]);
+      mesh.m_triangles.push_back(faceVertices[j]);
+    }
+  }
+  return true;
+}
+
+
+std::string lowerCaseExtension(const std::string &fileName)
+{
+  const size_t dot = fileName.find_last_of('.');
+  const size_t slash = fileName.find_last_of('/');
+  if (dot == std::string::npos || (slash != std::string::npos && slash > dot)) {
+    return std::string();
+  }
+  std::string extension = fileName.substr(dot + 1);
+  for (size_t i = 0; i < extension.size(); ++i) {
+    extension[i] = static_cast<char>(tolower(extension[i]));
+  }
+  return extension;
+}
+
+} // end namespace
+
+
+class vesMeshReader::vesInternal
+{
+public:
+  vesInternal() : m_numberOfThreads(0)
+  {
+  }
+
+  int m_numberOfThreads;
+  std::string m_errorMessage;
+};
+
+
+vesMeshReader::vesMeshReader()
+{
+  this->m_internal = new vesInternal();
+}
+
+
+vesMeshReader::~vesMeshReader()
+{
+  delete this->m_internal;
+}
+
+
+void vesMeshReader::setNumberOfThreads(int numberOfThreads)
+{
+  this->m_internal->m_numberOfThreads = std::max(0, numberOfThreads);
+}
+
+
+int vesMeshReader::numberOfThreads() const
+{
+  return this->m_internal->m_numberOfThreads;
+}
+
+
+bool vesMeshReader::canReadFile(const std::string &fileName)
+{
+  const std::string extension = lowerCaseExtension(fileName);
+  return extension == "stl" || extension == "ply" || extension == "obj";
+}
+
+
+vesSharedPtr<vesGeometryData> vesMeshReader::read(const std::string &fileName)
+{
+  this->m_internal->m_errorMessage.clear();
+
+  const int numberOfThreads = this->m_internal->m_numberOfThreads > 0
+    ? this->m_internal->m_numberOfThreads : vesThread::numberOfProcessors();
+
+  vesMappedFile file;
+  if (!file.open(fileName)) {
+    this->m_internal->m_errorMessage = "Cannot open " + fileName;
+    return vesGeometryData::Ptr();
+  }
+
+  vesMesh mesh;
+  const std::string extension = lowerCaseExtension(fileName);
+  bool success = false;
+  if (extension == "stl") {
+    success = readSTL(file, numberOfThreads, mesh, this->m_internal->m_errorMessage);
+  }
+  else if (extension == "ply") {
+    success = readPLY(file, numberOfThreads, mesh, this->m_internal->m_errorMessage);
+  }
+  else if (extension == "obj") {
+    success = readOBJ(file, numberOfThreads, mesh, this->m_internal->m_errorMessage);
+  }
+  else {
+    this->m_internal->m_errorMessage = "Unsupported file format";
+  }
+
+  if (!success) {
+    return vesGeometryData::Ptr();
+  }
+  return createGeometryData(mesh, numberOfThreads);
+}
+
+
+const std::string& vesMeshReader::errorMessage() const
+{
+  return this->m_internal->m_errorMessage;
+}
@@ -0,0 +1,85 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+/// \class vesMeshReader
+/// \ingroup ves
+/// \brief Reads STL, PLY and OBJ files straight into vesGeometryData.
+///
+/// The file is mapped into memory and parsed without intermediate copies.
+/// Binary STL triangles are copied out of their records and welded into
+/// shared vertices, PLY bodies, ASCII or binary, are decoded in chunks of
+/// vertices and faces, and OBJ files are tokenized in chunks of lines. The
+/// chunks run on at most numberOfThreads() threads of the shared
+/// vesThreadPool and write disjoint parts of the output, so the result does
+/// not depend on the number of threads.
+///
+/// Meshes come out as a position and normal source and a triangle
+/// primitive, polygons being split into fans; normals missing from the file
+/// are computed. Files without faces come out as a point primitive. PLY
+/// vertex colors and PLY or OBJ texture coordinates get sources of their
+/// own.
+///
+/// read() fails on anything it does not handle, e.g. OBJ lines and points,
+/// PLY list properties on vertices or meshes needing more vertices than 16
+/// bit indices address. Callers are expected to fall back to a general
+/// reader then.
+
+#ifndef VESMESHREADER_H
+#define VESMESHREADER_H
+
+// VES includes
+#include "vesSetGet.h"
+
+// C/C++ includes
+#include <string>
+
+// Forward declarations
+class vesGeometryData;
+
+class vesMeshReader
+{
+public:
+  vesTypeMacro(vesMeshReader);
+
+  vesMeshReader();
+  ~vesMeshReader();
+
+  /// Set the number of threads parsing a file, the calling thread included.
+  /// 0, the default, uses one thread per processor.
+  void setNumberOfThreads(int numberOfThreads);
+  int numberOfThreads() const;
+
+  /// Return true if \p fileName has an extension read by this class.
+  static bool canReadFile(const std::string &fileName);
+
+  /// Read \p fileName. Return an empty pointer and set errorMessage() on
+  /// failure.
+  vesSharedPtr<vesGeometryData> read(const std::string &fileName);
+
+  const std::string& errorMessage() const;
+
+private:
+  class vesInternal;
+  vesInternal *m_internal;
+
+  vesMeshReader(const vesMeshReader&);  // Not implemented
+  void operator=(const vesMeshReader&); // Not implemented
+};
+
+#endif // VESMESHREADER_H
@@ -0,0 +1,50 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+
+#include "vesMutex.h"
+
+vesMutex::vesMutex()
+{
+  pthread_mutex_init(&this->m_mutex, 0);
+}
+
+
+vesMutex::~vesMutex()
+{
+  pthread_mutex_destroy(&this->m_mutex);
+}
+
+
+void vesMutex::lock()
+{
+  pthread_mutex_lock(&this->m_mutex);
+}
+
+
+void vesMutex::unlock()
+{
+  pthread_mutex_unlock(&this->m_mutex);
+}
+
+
+bool vesMutex::tryLock()
+{
+  return pthread_mutex_trylock(&this->m_mutex) == 0;
+}
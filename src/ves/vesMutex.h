@@ -0,0 +1,78 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+/// \class vesMutex
+/// \ingroup ves
+/// \brief Non recursive mutual exclusion lock.
+///
+/// Use vesMutexLocker to hold the lock for the duration of a scope.
+/// \see vesMutexLocker vesConditionVariable vesThread
+
+#ifndef VESMUTEX_H
+#define VESMUTEX_H
+
+// C/C++ includes
+#include <pthread.h>
+
+class vesMutex
+{
+public:
+  vesMutex();
+  ~vesMutex();
+
+  void lock();
+  void unlock();
+
+  /// Lock the mutex if it is free. Return true on success.
+  bool tryLock();
+
+private:
+  friend class vesConditionVariable;
+
+  pthread_mutex_t m_mutex;
+
+  vesMutex(const vesMutex&);      // Not implemented
+  void operator=(const vesMutex&); // Not implemented
+};
+
+
+/// \class vesMutexLocker
+/// \ingroup ves
+/// \brief Lock a vesMutex on construction and unlock it on destruction.
+class vesMutexLocker
+{
+public:
+  explicit vesMutexLocker(vesMutex &mutex) : m_mutex(mutex)
+  {
+    this->m_mutex.lock();
+  }
+
+  ~vesMutexLocker()
+  {
+    this->m_mutex.unlock();
+  }
+
+private:
+  vesMutex &m_mutex;
+
+  vesMutexLocker(const vesMutexLocker&);  // Not implemented
+  void operator=(const vesMutexLocker&);  // Not implemented
+};
+
+#endif // VESMUTEX_H
@@ -48,6 +48,16 @@ void vesNode::setMaterial(vesSharedPtr<vesMaterial> material)
 {
   if (material) {
     this->m_material = material;
+    vesObject::modified();
+  }
+}
+
+
+void vesNode::setVisible(bool value)
+{
+  if (value != this->m_visible) {
+    this->m_visible = value;
+    vesObject::modified();
   }
 }
 
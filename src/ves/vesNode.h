@@ -74,7 +74,11 @@ public:
 
   /// Set if this node is an overlay node. Overlay nodes are drawn
   /// on top of scene nodes.
-  inline void setIsOverlayNode(bool value) { this->m_isOverlayNode = value; }
+  inline void setIsOverlayNode(bool value)
+  {
+    this->m_isOverlayNode = value;
+    vesObject::modified();
+  }
 
   /// Return if node is an overlay node
   inline bool isOverlayNode() const { return this->m_isOverlayNode; }
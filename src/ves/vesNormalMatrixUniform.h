@@ -42,6 +42,12 @@ public:
                       const vesShaderProgram &program)
   {
     vesNotUsed(program);
+
+    if (renderState.m_normalMatrix) {
+      this->set(*renderState.m_normalMatrix);
+      return;
+    }
+
     vesMatrix3x3f normalMatrix =
       makeNormalMatrix3x3f(makeTransposeMatrix4x4(makeInverseMatrix4x4
       (*(renderState.m_modelViewMatrix))));
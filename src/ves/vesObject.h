@@ -36,13 +36,44 @@ public:
 
   virtual ~vesObject() {}
 
-  void setDirty(const bool &value) { this->m_dirtyState = value; }
+  void setDirty(const bool &value)
+  {
+    this->m_dirtyState = value;
+    if (value) {
+      vesObject::modified();
+    }
+  }
   void setDirtyStateOn() { this->setDirty(true); }
   void setDirtyStateOff() { this->setDirty(false); }
   bool dirtyState() { return this->m_dirtyState; }
   const bool& dirtyState() const { return this->m_dirtyState; }
 
+  /// Record that some state affecting the rendered image has changed.
+  /// Dirtying any object does this implicitly; classes that are not
+  /// vesObject (uniforms) or whose changes do not set the dirty state
+  /// (scene structure, transforms) call it directly. The counter is
+  /// atomic, but bumps made while render() runs count as rendered; worker
+  /// threads publishing data for the next frame need their own check in
+  /// vesRenderer::isRenderNeeded() instead.
+  static void modified()
+  {
+    __sync_add_and_fetch(&vesObject::modificationCounter(), 1);
+  }
+
+  /// Number of modifications recorded so far in the process. Compare two
+  /// values to find out whether anything changed in between.
+  static unsigned int modificationCount()
+  {
+    return __sync_add_and_fetch(&vesObject::modificationCounter(), 0);
+  }
+
 protected:
+  static unsigned int& modificationCounter()
+  {
+    static unsigned int counter = 0;
+    return counter;
+  }
+
   bool m_dirtyState;
 };
 
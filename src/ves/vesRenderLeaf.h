@@ -18,6 +18,17 @@
   limitations under the License.
  ========================================================================*/
 
+/// \class vesRenderLeaf
+/// \ingroup ves
+/// \brief Drawable collected by the cull traversal.
+///
+/// Leaves are rebuilt every frame and only point at what they draw, the
+/// matrices, material, mapper and actor must stay alive and unchanged until
+/// the next cull. Matrices that are not stored in the scene graph are
+/// copied into the renderer's vesFrameArena. A pipelined renderer detaches
+/// the leaves from the scene, see vesRenderStage::detachFromScene().
+/// \see vesRenderStage vesCullVisitor
+
 #ifndef VESRENDERLEAF_H
 #define VESRENDERLEAF_H
 
@@ -27,6 +38,7 @@
 #include "vesSetGet.h"
 
 // Forward declarations
+class vesActor;
 class vesMapper;
 class vesMaterial;
 
@@ -36,10 +48,12 @@ public:
   vesTypeMacro(vesRenderLeaf);
 
   vesRenderLeaf(
-    int depth, const vesMatrix4x4f &modelViewMatrix,
-    const vesMatrix4x4f &projectionMatrix,
-    const vesSharedPtr<vesMaterial> &material,
-    const vesSharedPtr<vesMapper> &mapper)
+    float depth, const vesMatrix4x4f *modelViewMatrix,
+    const vesMatrix4x4f *projectionMatrix,
+    vesMaterial *material,
+    vesMapper *mapper,
+    const vesActor *actor=0x0,
+    const vesMatrix3x3f *normalMatrix=0x0)
   {
     this->m_depth = depth;
     this->m_modelViewMatrix = modelViewMatrix;
@@ -55,10 +69,8 @@ public:
     }
 
     this->m_mapper = mapper;
-  }
-
-  ~vesRenderLeaf()
-  {
+    this->m_actor = actor;
+    this->m_normalMatrix = normalMatrix;
   }
 
   void render(vesRenderState &renderState, vesRenderLeaf *previous)
@@ -67,8 +79,9 @@ public:
       renderState.removeMaterial(previous->m_material);
     }
 
-    renderState.applyProjectionMatrix (&this->m_projectionMatrix);
-    renderState.applyModelViewMatrix  (&this->m_modelViewMatrix);
+    renderState.applyProjectionMatrix (this->m_projectionMatrix);
+    renderState.applyModelViewMatrix  (this->m_modelViewMatrix);
+    renderState.applyNormalMatrix     (this->m_normalMatrix);
 
     if (this->m_material) {
       renderState.applyMaterial(this->m_material);
@@ -89,14 +102,23 @@ public:
     }
   }
 
-  int m_depth;
+  /// View space depth used to order the leaves of a bin, see
+  /// vesRenderStage::sort()
+  float m_depth;
   int m_bin;
 
-  vesMatrix4x4f m_projectionMatrix;
-  vesMatrix4x4f m_modelViewMatrix;
+  const vesMatrix4x4f *m_projectionMatrix;
+  const vesMatrix4x4f *m_modelViewMatrix;
+
+  vesMaterial *m_material;
+  vesMapper *m_mapper;
+
+  /// Actor the leaf was culled from
+  const vesActor *m_actor;
 
-  vesSharedPtr<vesMaterial> m_material;
-  vesSharedPtr<vesMapper> m_mapper;
+  /// Normal matrix cached by the actor, or 0x0 to derive it from the
+  /// model view matrix
+  const vesMatrix3x3f *m_normalMatrix;
 };
 
 #endif // VESRENDERLEAF_H
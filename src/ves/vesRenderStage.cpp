@@ -20,8 +20,192 @@
 
 #include "vesRenderStage.h"
 
-void vesRenderStage::addPreRenderStage(vesSharedPtr<vesRenderStage> renderStage,
-                                       int priority)
+// VES includes
+#include "vesActor.h"
+
+// C/C++ includes
+#include <algorithm>
+
+namespace {
+
+struct vesBackToFront
+{
+  bool operator()(const vesRenderLeaf &a, const vesRenderLeaf &b) const
+  {
+    // The camera looks down -z, farther leaves have a smaller depth.
+    return a.m_depth < b.m_depth;
+  }
+};
+
+struct vesFrontToBack
+{
+  bool operator()(const vesRenderLeaf &a, const vesRenderLeaf &b) const
+  {
+    return a.m_depth > b.m_depth;
+  }
+};
+
+float leafDepth(const vesRenderLeaf &leaf)
+{
+  if (!leaf.m_mapper || !leaf.m_mapper->geometryData()) {
+    return 0.0f;
+  }
+
+  if (leaf.m_mapper->boundsDirty()) {
+    leaf.m_mapper->computeBounds();
+  }
+
+  const vesVector3f &center = leaf.m_mapper->boundsCenter();
+  const vesMatrix4x4f &matrix = *leaf.m_modelViewMatrix;
+  return matrix(2, 0) * center[0] + matrix(2, 1) * center[1]
+    + matrix(2, 2) * center[2] + matrix(2, 3);
+}
+
+} // end namespace
+
+
+void vesRenderStage::sort(SortMode mode, int firstBin, int lastBin)
+{
+  if (mode != SortByState) {
+    BinRenderLeavesMap::iterator itr =
+      this->m_binRenderLeavesMap.lower_bound(firstBin);
+    for (; itr != this->m_binRenderLeavesMap.end() && itr->first < lastBin;
+         ++itr) {
+      RenderLeaves &leaves = itr->second;
+      if (leaves.size() < 2) {
+        continue;
+      }
+
+      for (size_t i = 0; i < leaves.size(); ++i) {
+        leaves[i].m_depth = leafDepth(leaves[i]);
+      }
+
+      if (mode == BackToFront) {
+        std::stable_sort(leaves.begin(), leaves.end(), vesBackToFront());
+      }
+      else {
+        std::stable_sort(leaves.begin(), leaves.end(), vesFrontToBack());
+      }
+    }
+  }
+
+  RenderStageList::iterator stageItr = this->m_preRenderList.begin();
+  for (; stageItr != this->m_preRenderList.end(); ++stageItr) {
+    stageItr->second->sort(mode, firstBin, lastBin);
+  }
+
+  for (stageItr = this->m_postRenderList.begin();
+       stageItr != this->m_postRenderList.end(); ++stageItr) {
+    stageItr->second->sort(mode, firstBin, lastBin);
+  }
+}
+
+
+void vesRenderStage::detachFromScene(vesFrameArena &frameArena)
+{
+  // Leaves of an actor, or of a camera, mostly share their matrices.
+  const vesMatrix4x4f *projection = 0x0;
+  const vesMatrix4x4f *projectionCopy = 0x0;
+  const vesMatrix4x4f *modelView = 0x0;
+  const vesMatrix4x4f *modelViewCopy = 0x0;
+  const vesMatrix3x3f *normal = 0x0;
+  const vesMatrix3x3f *normalCopy = 0x0;
+
+  BinRenderLeavesMap::iterator itr = this->m_binRenderLeavesMap.begin();
+  for (; itr != this->m_binRenderLeavesMap.end(); ++itr) {
+    RenderLeaves &leaves = itr->second;
+    for (size_t i = 0; i < leaves.size(); ++i) {
+      vesRenderLeaf &leaf = leaves[i];
+
+      if (leaf.m_projectionMatrix != projection) {
+        projection = leaf.m_projectionMatrix;
+        projectionCopy = frameArena.copy(*projection);
+      }
+      leaf.m_projectionMatrix = projectionCopy;
+
+      if (leaf.m_modelViewMatrix != modelView) {
+        modelView = leaf.m_modelViewMatrix;
+        modelViewCopy = frameArena.copy(*modelView);
+      }
+      leaf.m_modelViewMatrix = modelViewCopy;
+
+      if (leaf.m_normalMatrix && leaf.m_normalMatrix != normal) {
+        normal = leaf.m_normalMatrix;
+        normalCopy = frameArena.copy(*normal);
+      }
+      if (leaf.m_normalMatrix) {
+        leaf.m_normalMatrix = normalCopy;
+      }
+
+      // The actor owns what the leaf draws, unless it changed its mapper
+      // or material since it was culled.
+      if (leaf.m_actor) {
+        if (leaf.m_actor->mapper().get() == leaf.m_mapper) {
+          this->m_detachedMappers.push_back(leaf.m_actor->mapper());
+        }
+        if (leaf.m_actor->material().get() == leaf.m_material) {
+          this->m_detachedMaterials.push_back(leaf.m_actor->material());
+        }
+      }
+    }
+  }
+
+  RenderStageList::iterator stageItr = this->m_preRenderList.begin();
+  for (; stageItr != this->m_preRenderList.end(); ++stageItr) {
+    stageItr->second->detachFromScene(frameArena);
+  }
+
+  for (stageItr = this->m_postRenderList.begin();
+       stageItr != this->m_postRenderList.end(); ++stageItr) {
+    stageItr->second->detachFromScene(frameArena);
+  }
+}
+
+
+void vesRenderStage::releaseScene()
+{
+  this->m_detachedMappers.clear();
+  this->m_detachedMaterials.clear();
+
+  RenderStageList::iterator stageItr = this->m_preRenderList.begin();
+  for (; stageItr != this->m_preRenderList.end(); ++stageItr) {
+    stageItr->second->releaseScene();
+  }
+
+  for (stageItr = this->m_postRenderList.begin();
+       stageItr != this->m_postRenderList.end(); ++stageItr) {
+    stageItr->second->releaseScene();
+  }
+}
+
+
+void vesRenderStage::collectTriangleSorters(
+  std::vector< vesWeakPtr<vesTriangleSorter> > &sorters) const
+{
+  BinRenderLeavesMap::const_iterator itr = this->m_binRenderLeavesMap.begin();
+  for (; itr != this->m_binRenderLeavesMap.end(); ++itr) {
+    const RenderLeaves &leaves = itr->second;
+    for (size_t i = 0; i < leaves.size(); ++i) {
+      vesMapper *mapper = leaves[i].m_mapper;
+      if (mapper && mapper->sortTriangles()) {
+        sorters.push_back(mapper->triangleSorter());
+      }
+    }
+  }
+
+  RenderStageList::const_iterator stageItr = this->m_preRenderList.begin();
+  for (; stageItr != this->m_preRenderList.end(); ++stageItr) {
+    stageItr->second->collectTriangleSorters(sorters);
+  }
+
+  for (stageItr = this->m_postRenderList.begin();
+       stageItr != this->m_postRenderList.end(); ++stageItr) {
+    stageItr->second->collectTriangleSorters(sorters);
+  }
+}
+
+
+void vesRenderStage::addPreRenderStage(vesRenderStage *renderStage, int priority)
 {
   if (renderStage) {
     RenderStageList::iterator itr;
@@ -40,8 +224,7 @@ void vesRenderStage::addPreRenderStage(vesSharedPtr<vesRenderStage> renderStage,
 }
 
 
-void vesRenderStage::addPostRenderStage(vesSharedPtr<vesRenderStage> renderStage,
-                                        int priority)
+void vesRenderStage::addPostRenderStage(vesRenderStage *renderStage, int priority)
 {
   if (renderStage) {
     RenderStageList::iterator itr;
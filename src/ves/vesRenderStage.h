@@ -19,26 +19,37 @@
  ========================================================================*/
 /// \class vesRenderStage
 /// \ingroup ves
+/// \brief Bins of render leaves drawn for one camera.
+///
+/// clearAll() empties the bins but keeps them and their capacity, so that a
+/// frame culling as many leaves as the previous one does not allocate. The
+/// pre and post render stages are not owned, their cameras keep them alive.
+///
+/// A pipelined renderer draws a stage while the scene is culled again, see
+/// detachFromScene().
 /// \see vesRenderLeaf vesRenderState vesRenderer
 
 #ifndef VESRENDERSTAGE_H
 #define VESRENDERSTAGE_H
 
 // VES includes.
+#include "vesFrameArena.h"
 #include "vesGL.h"
 #include "vesMapper.h"
 #include "vesMaterial.h"
 #include "vesMath.h"
 #include "vesRenderLeaf.h"
+#include "vesRenderStatistics.h"
 #include "vesSetGet.h"
 #include "vesStateAttributeBits.h"
 #include "vesViewport.h"
 
 // C++ includes
-#include <list>
 #include <map>
 #include <vector>
 
+class vesTriangleSorter;
+
 class vesRenderStage
 {
 public:
@@ -70,17 +81,24 @@ public:
   void addRenderLeaf(const vesRenderLeaf &renderLeaf)
   {
     this->m_binRenderLeavesMap[renderLeaf.m_bin].push_back(renderLeaf);
+    vesRenderStatistics::addRenderLeaf();
+  }
+
+  const BinRenderLeavesMap& binRenderLeaves() const
+  {
+    return this->m_binRenderLeavesMap;
   }
 
   void setViewport(vesSharedPtr<vesViewport> viewport) { this->m_viewport = viewport; }
   const vesSharedPtr<vesViewport> viewport() const { return this->m_viewport; }
   vesSharedPtr<vesViewport> viewport() { return this->m_viewport; }
 
-  void sort(SortMode mode)
-  {
-    // \todo: Implement this.
-    vesNotUsed(mode);
-  }
+  /// Order the leaves of the bins in [\p firstBin, \p lastBin) by the view
+  /// space depth of their bounds center, then sort the pre and post render
+  /// stages the same way. Leaves at the same depth keep their cull order.
+  /// SortByState leaves the bins untouched.
+  void sort(SortMode mode, int firstBin=vesMaterial::Default,
+            int lastBin=vesMaterial::Overlay);
 
   void render(vesRenderState &renderState, vesRenderLeaf *previous)
   {
@@ -96,7 +114,7 @@ public:
 
       if (this->m_clearMask & GL_DEPTH_BUFFER_BIT) {
         glClearDepthf(this->m_clearDepth);
-        glDepthMask( GL_TRUE );
+        renderState.m_glState->depthMask(true);
       }
 
       glClear(this->m_clearMask);
@@ -123,13 +141,33 @@ public:
 
   void clearAll()
   {
-    this->m_binRenderLeavesMap.clear();
+    BinRenderLeavesMap::iterator itr = this->m_binRenderLeavesMap.begin();
+    for (; itr != this->m_binRenderLeavesMap.end(); ++itr) {
+      itr->second.clear();
+    }
     this->m_preRenderList.clear();
     this->m_postRenderList.clear();
   }
 
-  void addPreRenderStage(vesSharedPtr<vesRenderStage> renderStage, int priority);
-  void addPostRenderStage(vesSharedPtr<vesRenderStage>, int priority);
+  /// Copy the matrices the leaves point at into \p frameArena and hold on
+  /// to their mappers and materials, in this stage and the pre and post
+  /// render stages, so that the leaves stay valid while the scene graph is
+  /// traversed or edited before the stage is drawn.
+  void detachFromScene(vesFrameArena &frameArena);
+
+  /// Drop the mappers and materials held by detachFromScene(). Call it from
+  /// the rendering thread, the last reference to a mapper deletes its GL
+  /// buffers.
+  void releaseScene();
+
+  /// Append the triangle sorters of the mappers of the leaves, in this
+  /// stage and the pre and post render stages, to \p sorters.
+  /// \see vesMapper::setSortTriangles()
+  void collectTriangleSorters(
+    std::vector< vesWeakPtr<vesTriangleSorter> > &sorters) const;
+
+  void addPreRenderStage(vesRenderStage *renderStage, int priority);
+  void addPostRenderStage(vesRenderStage *renderStage, int priority);
 
   void renderPreRenderStages(vesRenderState &renderState, vesRenderLeaf *previous);
   void renderPostRenderStages(vesRenderState &renderState, vesRenderLeaf *previous);
@@ -147,14 +185,17 @@ public:
 private:
   vesSharedPtr<vesViewport> m_viewport;
 
-  typedef std::pair< int, vesSharedPtr<vesRenderStage> > RenderStageOrderPair;
-  typedef std::list< RenderStageOrderPair > RenderStageList;
+  typedef std::pair< int, vesRenderStage* > RenderStageOrderPair;
+  typedef std::vector< RenderStageOrderPair > RenderStageList;
 
   BinRenderLeavesMap  m_binRenderLeavesMap;
 
   RenderStageList m_preRenderList;
   RenderStageList m_postRenderList;
 
+  std::vector< vesSharedPtr<vesMapper> > m_detachedMappers;
+  std::vector< vesSharedPtr<vesMaterial> > m_detachedMaterials;
+
   unsigned int m_clearMask;
   vesVector4f m_clearColor;
   double m_clearDepth;
@@ -23,6 +23,7 @@
 #define VESRENDERSTATE_H
 
 // VES includes
+#include "vesGLState.h"
 #include "vesMaterial.h"
 #include "vesMath.h"
 #include "vesSetGet.h"
@@ -38,21 +39,28 @@ public:
 
   vesRenderState()
   {
-    this->m_identity = new vesMatrix4x4f;
-    m_identity->setIdentity();
+    this->m_identityMatrix.setIdentity();
+    this->m_identity = &this->m_identityMatrix;
 
     this->m_modelViewMatrix   = this->m_identity;
     this->m_projectionMatrix  = this->m_identity;
+    this->m_normalMatrix      = 0x0;
+
+    this->m_material = 0x0;
+    this->m_mapper = 0x0;
+
+    // Kept inside the render state, which is created every frame.
+    this->m_glState = &this->m_glStateStorage;
   }
 
 
   ~vesRenderState()
   {
-    delete this->m_identity; this->m_identity = 0x0;
+    this->m_glState->restore();
   }
 
 
-  void applyMaterial(const vesSharedPtr<vesMaterial> &material)
+  void applyMaterial(vesMaterial *material)
   {
     if (material && material != this->m_material) {
       this->m_material = material;
@@ -60,7 +68,7 @@ public:
   }
 
 
-  void removeMaterial(const vesSharedPtr<vesMaterial> &material)
+  void removeMaterial(vesMaterial *material)
   {
     if (material && material == this->m_material) {
       this->m_material->remove(*this);
@@ -68,7 +76,7 @@ public:
   }
 
 
-  void applyMapper(const vesSharedPtr<vesMapper> &mapper)
+  void applyMapper(vesMapper *mapper)
   {
     if (mapper && mapper != this->m_mapper) {
       this->m_mapper = mapper;
@@ -76,7 +84,7 @@ public:
   }
 
 
-  void applyModelViewMatrix(vesMatrix4x4f *modelViewMatrix)
+  void applyModelViewMatrix(const vesMatrix4x4f *modelViewMatrix)
   {
     if (modelViewMatrix && modelViewMatrix != this->m_modelViewMatrix) {
       this->m_modelViewMatrix = modelViewMatrix;
@@ -84,19 +92,39 @@ public:
   }
 
 
-  void applyProjectionMatrix(vesMatrix4x4f *projectionMatrix)
+  /// A null normal matrix means it has to be derived from the model view
+  /// matrix.
+  void applyNormalMatrix(const vesMatrix3x3f *normalMatrix)
+  {
+    this->m_normalMatrix = normalMatrix;
+  }
+
+
+  void applyProjectionMatrix(const vesMatrix4x4f *projectionMatrix)
   {
     if (projectionMatrix  && projectionMatrix != m_projectionMatrix) {
       this->m_projectionMatrix = projectionMatrix;
     }
   }
 
-  vesSharedPtr<vesMaterial> m_material;
-  vesSharedPtr<vesMapper> m_mapper;
+  vesMaterial *m_material;
+  vesMapper *m_mapper;
+
+  const vesMatrix4x4f *m_identity;
+  const vesMatrix4x4f *m_projectionMatrix;
+  const vesMatrix4x4f *m_modelViewMatrix;
+  const vesMatrix3x3f *m_normalMatrix;
+
+  /// Shadow of the GL state, GL calls made while rendering with this state
+  /// should go through it.
+  vesGLState *m_glState;
+
+private:
+  vesMatrix4x4f m_identityMatrix;
+  vesGLState m_glStateStorage;
 
-  vesMatrix4x4f *m_identity;
-  vesMatrix4x4f *m_projectionMatrix;
-  vesMatrix4x4f *m_modelViewMatrix;
+  vesRenderState(const vesRenderState&); // Not implemented
+  void operator=(const vesRenderState&); // Not implemented
 };
 
 #endif // VESRENDERSTATE_H
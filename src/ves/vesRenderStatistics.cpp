@@ -0,0 +1,167 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+
+#include "vesRenderStatistics.h"
+
+// VES includes
+#include "vesGL.h"
+
+// C/C++ includes
+#include <pthread.h>
+#include <sstream>
+#include <sys/time.h>
+
+namespace {
+
+#ifdef VES_NO_THREADS
+vesRenderStatistics *currentStatistics = 0;
+#else
+pthread_key_t currentStatisticsKey;
+pthread_once_t currentStatisticsOnce = PTHREAD_ONCE_INIT;
+
+void createCurrentStatisticsKey()
+{
+  pthread_key_create(&currentStatisticsKey, 0);
+}
+#endif
+
+} // end namespace
+
+vesRenderStatistics::vesRenderStatistics() :
+  m_gpuTime(-1.0)
+{
+  this->reset();
+}
+
+
+void vesRenderStatistics::reset()
+{
+  this->m_drawCalls = 0;
+  this->m_triangles = 0;
+  this->m_lines = 0;
+  this->m_points = 0;
+  this->m_programBinds = 0;
+  this->m_textureBinds = 0;
+  this->m_bufferBinds = 0;
+  this->m_avoidedGLCalls = 0;
+  this->m_uniformUploads = 0;
+  this->m_bytesUploaded = 0;
+  this->m_renderLeaves = 0;
+  this->m_cullRejects = 0;
+  this->m_updateTime = 0.0;
+  this->m_cullTime = 0.0;
+  this->m_drawTime = 0.0;
+}
+
+
+vesRenderStatistics* vesRenderStatistics::current()
+{
+#ifdef VES_NO_THREADS
+  return currentStatistics;
+#else
+  pthread_once(&currentStatisticsOnce, &createCurrentStatisticsKey);
+  return static_cast<vesRenderStatistics*>(
+    pthread_getspecific(currentStatisticsKey));
+#endif
+}
+
+
+void vesRenderStatistics::setCurrent(vesRenderStatistics *statistics)
+{
+#ifdef VES_NO_THREADS
+  currentStatistics = statistics;
+#else
+  pthread_once(&currentStatisticsOnce, &createCurrentStatisticsKey);
+  pthread_setspecific(currentStatisticsKey, statistics);
+#endif
+}
+
+
+std::string vesRenderStatistics::toJSON() const
+{
+  std::ostringstream json;
+  json << "{"
+       << "\"drawCalls\": " << this->m_drawCalls
+       << ", \"triangles\": " << this->m_triangles
+       << ", \"lines\": " << this->m_lines
+       << ", \"points\": " << this->m_points
+       << ", \"programBinds\": " << this->m_programBinds
+       << ", \"textureBinds\": " << this->m_textureBinds
+       << ", \"bufferBinds\": " << this->m_bufferBinds
+       << ", \"avoidedGLCalls\": " << this->m_avoidedGLCalls
+       << ", \"uniformUploads\": " << this->m_uniformUploads
+       << ", \"bytesUploaded\": " << this->m_bytesUploaded
+       << ", \"renderLeaves\": " << this->m_renderLeaves
+       << ", \"cullRejects\": " << this->m_cullRejects
+       << ", \"updateTime\": " << this->m_updateTime
+       << ", \"cullTime\": " << this->m_cullTime
+       << ", \"drawTime\": " << this->m_drawTime
+       << ", \"gpuTime\": ";
+  if (this->m_gpuTime < 0.0) {
+    json << "null";
+  }
+  else {
+    json << this->m_gpuTime;
+  }
+  json << "}";
+  return json.str();
+}
+
+
+void vesRenderStatistics::addDraw(unsigned int primitiveType,
+                                  unsigned int count)
+{
+  vesRenderStatistics *statistics = current();
+  if (!statistics) {
+    return;
+  }
+
+  ++statistics->m_drawCalls;
+
+  switch (primitiveType) {
+    case GL_TRIANGLES:
+      statistics->m_triangles += count / 3;
+      break;
+    case GL_TRIANGLE_STRIP:
+    case GL_TRIANGLE_FAN:
+      statistics->m_triangles += count > 2 ? count - 2 : 0;
+      break;
+    case GL_LINES:
+      statistics->m_lines += count / 2;
+      break;
+    case GL_LINE_STRIP:
+      statistics->m_lines += count > 1 ? count - 1 : 0;
+      break;
+    case GL_LINE_LOOP:
+      statistics->m_lines += count > 1 ? count : 0;
+      break;
+    case GL_POINTS:
+      statistics->m_points += count;
+      break;
+  }
+}
+
+
+double vesRenderStatistics::currentTime()
+{
+  timeval time;
+  gettimeofday(&time, 0);
+  return time.tv_sec + time.tv_usec * 1e-6;
+}
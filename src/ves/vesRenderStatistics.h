@@ -0,0 +1,152 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+/// \class vesRenderStatistics
+/// \ingroup ves
+/// \brief Counters and phase timings of one rendered frame.
+///
+/// vesRenderer fills in its statistics on every render() and makes them
+/// the current statistics for the duration of the frame, so that mappers,
+/// shader programs, textures and uniforms can count the GL work they submit
+/// without knowing about the renderer. Outside of render() there are no
+/// current statistics and counting is a no-op. The current statistics are
+/// per thread, a pipelined renderer counts its cull thread separately.
+///
+/// Times are in seconds. The GPU time is measured with
+/// EXT_disjoint_timer_query where available and is reported a few frames
+/// late, since queries are read back without stalling; it is negative while
+/// unavailable.
+///
+/// \see vesRenderer::statistics()
+
+#ifndef VESRENDERSTATISTICS_H
+#define VESRENDERSTATISTICS_H
+
+// VES includes
+#include "vesSetGet.h"
+
+// C/C++ includes
+#include <string>
+
+class vesRenderStatistics
+{
+public:
+  vesTypeMacro(vesRenderStatistics);
+
+  vesRenderStatistics();
+
+  /// Zero the counters and timings, except for the GPU time.
+  void reset();
+
+  /// Write the statistics as a JSON object.
+  std::string toJSON() const;
+
+  /// Statistics of the frame being rendered by the calling thread, or a
+  /// null pointer.
+  static vesRenderStatistics* current();
+  static void setCurrent(vesRenderStatistics *statistics);
+
+  /// Count a glDraw* call of \p count vertices drawn as \p primitiveType.
+  static void addDraw(unsigned int primitiveType, unsigned int count);
+
+  static void addProgramBind()
+  {
+    if (vesRenderStatistics *statistics = current()) {
+      ++statistics->m_programBinds;
+    }
+  }
+
+  static void addTextureBind()
+  {
+    if (vesRenderStatistics *statistics = current()) {
+      ++statistics->m_textureBinds;
+    }
+  }
+
+  static void addBufferBind()
+  {
+    if (vesRenderStatistics *statistics = current()) {
+      ++statistics->m_bufferBinds;
+    }
+  }
+
+  /// Count GL calls vesGLState skipped because they would not have
+  /// changed the GL state.
+  static void addAvoidedGLCalls(unsigned int count)
+  {
+    if (vesRenderStatistics *statistics = current()) {
+      statistics->m_avoidedGLCalls += count;
+    }
+  }
+
+  static void addUniformUpload()
+  {
+    if (vesRenderStatistics *statistics = current()) {
+      ++statistics->m_uniformUploads;
+    }
+  }
+
+  /// Count \p bytes of buffer or texture data sent to the GPU.
+  static void addBytesUploaded(unsigned long bytes)
+  {
+    if (vesRenderStatistics *statistics = current()) {
+      statistics->m_bytesUploaded += bytes;
+    }
+  }
+
+  static void addRenderLeaf()
+  {
+    if (vesRenderStatistics *statistics = current()) {
+      ++statistics->m_renderLeaves;
+    }
+  }
+
+  static void addCullRejects(unsigned int count)
+  {
+    if (vesRenderStatistics *statistics = current()) {
+      statistics->m_cullRejects += count;
+    }
+  }
+
+  /// Seconds since an arbitrary point in time, for the phase timings.
+  static double currentTime();
+
+  unsigned int m_drawCalls;
+  unsigned int m_triangles;
+  unsigned int m_lines;
+  unsigned int m_points;
+
+  unsigned int m_programBinds;
+  unsigned int m_textureBinds;
+  unsigned int m_bufferBinds;
+  unsigned int m_avoidedGLCalls;
+
+  unsigned int m_uniformUploads;
+  unsigned long m_bytesUploaded;
+
+  unsigned int m_renderLeaves;
+  unsigned int m_cullRejects;
+
+  double m_updateTime;
+  double m_cullTime;
+  double m_drawTime;
+  double m_gpuTime;
+};
+
+#endif // VESRENDERSTATISTICS_H
@@ -22,28 +22,147 @@
 #include "vesActor.h"
 #include "vesBackground.h"
 #include "vesCamera.h"
+#include "vesConditionVariable.h"
 #include "vesCullVisitor.h"
+#include "vesFrameArena.h"
+#include "vesGPUTimer.h"
 #include "vesGroupNode.h"
+#include "vesIdBufferPicker.h"
 #include "vesRenderer.h"
 #include "vesRenderStage.h"
+#include "vesResolutionScaler.h"
+#include "vesSceneCommand.h"
+#include "vesSceneStore.h"
 #include "vesShaderProgram.h"
+#include "vesThread.h"
+#include "vesTriangleSorter.h"
 #include "vesVisitor.h"
 
 // C/C++ includes
+#include <algorithm>
 #include <cassert>
 #include <iostream>
 #include <string>
 
+namespace {
+
+vesSharedPtr<vesActor> findActor(const vesGroupNode &groupNode,
+                                 const vesActor *actor)
+{
+  vesGroupNode::Children::const_iterator itr = groupNode.children().begin();
+  for (; itr != groupNode.children().end(); ++itr) {
+    if ((*itr).get() == actor) {
+      return std::tr1::static_pointer_cast<vesActor>(*itr);
+    }
+    if ((*itr)->asGroupNode()) {
+      vesSharedPtr<vesActor> found = findActor(*(*itr)->asGroupNode(), actor);
+      if (found) {
+        return found;
+      }
+    }
+  }
+  return vesSharedPtr<vesActor>();
+}
+
+} // end namespace
+
+
+class vesRenderer::vesCullThread : public vesThread
+{
+public:
+  explicit vesCullThread(vesRenderer *renderer) :
+    m_renderer(renderer),
+    m_buffer(0),
+    m_busy(false),
+    m_quit(false)
+  {
+  }
+
+  ~vesCullThread()
+  {
+    {
+      vesMutexLocker locker(this->m_mutex);
+      this->m_quit = true;
+      this->m_workAvailable.signal();
+    }
+    this->join();
+  }
+
+  /// Start culling the next frame into \p buffer.
+  void cull(int buffer)
+  {
+    vesMutexLocker locker(this->m_mutex);
+    this->m_buffer = buffer;
+    this->m_busy = true;
+    this->m_workAvailable.signal();
+  }
+
+  /// Wait for the last cull() to finish.
+  void wait()
+  {
+    vesMutexLocker locker(this->m_mutex);
+    while (this->m_busy) {
+      this->m_workDone.wait(this->m_mutex);
+    }
+  }
+
+protected:
+  virtual void run()
+  {
+    for (;;) {
+      int buffer;
+      {
+        vesMutexLocker locker(this->m_mutex);
+        while (!this->m_quit && !this->m_busy) {
+          this->m_workAvailable.wait(this->m_mutex);
+        }
+        if (this->m_quit) {
+          return;
+        }
+        buffer = this->m_buffer;
+      }
+
+      this->m_renderer->cullFrame(buffer);
+
+      vesMutexLocker locker(this->m_mutex);
+      this->m_busy = false;
+      this->m_workDone.signal();
+    }
+  }
+
+  vesRenderer *m_renderer;
+
+  vesMutex m_mutex;
+  vesConditionVariable m_workAvailable;
+  vesConditionVariable m_workDone;
+  int m_buffer;
+  bool m_busy;
+  bool m_quit;
+};
+
+
 vesRenderer::vesRenderer():
   m_width(100),
   m_height(100),
   m_camera(new vesCamera()),
   m_sceneRoot(new vesGroupNode()),
-  m_renderStage(new vesRenderStage()),
-  m_background (new vesBackground())
+  m_cullBuffer(0),
+  m_background (new vesBackground()),
+  m_resolutionScale(1.0f),
+  m_firstTranslucentBin(vesMaterial::Transparent),
+  m_renderRequested(true),
+  m_renderedModificationCount(0),
+  m_gpuTimer(new vesGPUTimer()),
+  m_pipelined(false),
+  m_cullThread(0x0),
+  m_drawBuffer(-1),
+  m_pendingFrameChanged(false)
 {
   this->m_aspect[0] = this->m_aspect[1] = 1.0;
 
+  this->m_renderStages[0] = vesRenderStage::Ptr(new vesRenderStage());
+  this->m_frameArenas[0] = vesSharedPtr<vesFrameArena>(new vesFrameArena());
+
   this->m_camera->addChild(this->m_sceneRoot);
 
   this->setupBackground();
@@ -52,22 +171,84 @@ vesRenderer::vesRenderer():
 
 vesRenderer::~vesRenderer()
 {
+  delete this->m_cullThread; this->m_cullThread = 0x0;
 }
 
 
 void vesRenderer::render()
 {
+  this->executeSceneCommands();
+
+  // A frame culled ahead was culled before the changes made since the last
+  // render(), which then only show up in the frame culled now.
+  const bool pendingFrameChanged = this->m_pipelined &&
+    this->m_drawBuffer >= 0 && this->isSceneModified();
+
+  this->m_statistics.reset();
+  vesRenderStatistics::setCurrent(&this->m_statistics);
+
   // By default enable depth test.
   glEnable(GL_DEPTH_TEST);
 
   if (this->m_sceneRoot) {
 
-    // Update traversal.
-    this->updateTraverseScene();
+    this->m_gpuTimer->begin();
+
+    // Render into a smaller offscreen buffer which is then upsampled.
+    vesSharedPtr<vesViewport> viewport = this->m_camera->viewport();
+    const int viewportSize[4] = { viewport->x(), viewport->y(),
+                                  viewport->width(), viewport->height() };
+    const bool scaled = this->m_resolutionScale < 1.0f;
+    if (scaled) {
+      if (!this->m_resolutionScaler) {
+        this->m_resolutionScaler =
+          vesResolutionScaler::Ptr(new vesResolutionScaler());
+      }
+      const int width = std::max(1, static_cast<int>(
+        viewportSize[2] * this->m_resolutionScale + 0.5f));
+      const int height = std::max(1, static_cast<int>(
+        viewportSize[3] * this->m_resolutionScale + 0.5f));
+      this->m_resolutionScaler->begin(width, height);
+      viewport->setViewport(0, 0, width, height);
+      this->updateBackgroundViewport();
+    }
+
+    int drawBuffer = 0;
+    double startTime = vesRenderStatistics::currentTime();
+    double cullTime = startTime;
 
-    // Cull traversal.
-    this->cullTraverseScene();
+    if (!this->m_pipelined) {
+      // Nothing refers to the previous frame anymore, the stage was cleared.
+      this->m_cullBuffer = 0;
+      this->m_frameArenas[0]->reset();
 
+      // Update traversal.
+      this->updateTraverseScene();
+
+      // Cull traversal.
+      cullTime = vesRenderStatistics::currentTime();
+      this->cullTraverseScene();
+      this->m_renderStages[0]->sort(vesRenderStage::BackToFront,
+                                    this->m_firstTranslucentBin,
+                                    vesMaterial::Overlay);
+    }
+    else {
+      // Nothing was culled ahead on the first frame.
+      if (this->m_drawBuffer < 0) {
+        this->cullFrame(0);
+        this->m_drawBuffer = 0;
+      }
+      drawBuffer = this->m_drawBuffer;
+
+      // Cull the next frame while this one is drawn.
+      this->m_cullThread->cull(1 - drawBuffer);
+
+      const vesRenderStatistics &culled = this->m_cullStatistics[drawBuffer];
+      this->m_statistics.m_renderLeaves = culled.m_renderLeaves;
+      this->m_statistics.m_cullRejects = culled.m_cullRejects;
+    }
+
+    double drawTime = vesRenderStatistics::currentTime();
     vesRenderState renderState;
 
     // Clear all the previous render targets.
@@ -77,13 +258,190 @@ void vesRenderer::render()
     // render on render target of the current camera.
     this->m_camera->renderTarget()->render(renderState);
 
-    this->m_renderStage->render(renderState, 0);
+    this->m_renderStages[drawBuffer]->render(renderState, 0);
+
+    // Cleared, not freed, so that steady state frames do not allocate.
+    this->m_triangleSorters.clear();
+    this->m_renderStages[drawBuffer]->collectTriangleSorters(
+      this->m_triangleSorters);
 
     // \note: For now clear the stage.
     // \todo: Add an optimization where we could save whole or
     // part of the the stage.
-    this->m_renderStage->clearAll();
+    this->m_renderStages[drawBuffer]->releaseScene();
+    this->m_renderStages[drawBuffer]->clearAll();
+
+    double endTime = vesRenderStatistics::currentTime();
+
+    if (this->m_pipelined) {
+      this->m_cullThread->wait();
+      this->m_drawBuffer = 1 - drawBuffer;
+    }
+
+    if (scaled) {
+      viewport->setViewport(viewportSize[0], viewportSize[1],
+                            viewportSize[2], viewportSize[3]);
+      this->updateBackgroundViewport();
+      this->m_resolutionScaler->end(viewportSize[0], viewportSize[1],
+                                    viewportSize[2], viewportSize[3]);
+    }
+
+    this->m_gpuTimer->end();
+
+    if (!this->m_pipelined) {
+      this->m_statistics.m_updateTime = cullTime - startTime;
+      this->m_statistics.m_cullTime = drawTime - cullTime;
+    }
+    else {
+      this->m_statistics.m_updateTime =
+        this->m_cullStatistics[drawBuffer].m_updateTime;
+      this->m_statistics.m_cullTime =
+        this->m_cullStatistics[drawBuffer].m_cullTime;
+    }
+    this->m_statistics.m_drawTime = endTime - drawTime;
+    this->m_statistics.m_gpuTime = this->m_gpuTimer->elapsedTime();
   }
+
+  vesRenderStatistics::setCurrent(0x0);
+
+  // Whatever was modified while rendering is part of this frame.
+  this->m_renderRequested = false;
+  this->m_pendingFrameChanged = pendingFrameChanged;
+  this->m_renderedModificationCount = vesObject::modificationCount();
+  this->m_renderedViewMatrix = this->m_camera->modelViewMatrix();
+  this->m_renderedProjectionMatrix = this->m_camera->projectionMatrix();
+}
+
+
+void vesRenderer::cullFrame(int buffer)
+{
+  // Called with the frame statistics current on the rendering thread.
+  vesRenderStatistics *frameStatistics = vesRenderStatistics::current();
+  vesRenderStatistics &statistics = this->m_cullStatistics[buffer];
+  statistics.reset();
+  vesRenderStatistics::setCurrent(&statistics);
+
+  // The stage of this buffer was drawn and cleared by the last render().
+  this->m_cullBuffer = buffer;
+  this->m_frameArenas[buffer]->reset();
+
+  double startTime = vesRenderStatistics::currentTime();
+  this->updateTraverseScene();
+
+  double cullTime = vesRenderStatistics::currentTime();
+  this->cullTraverseScene();
+  this->m_renderStages[buffer]->sort(vesRenderStage::BackToFront,
+                                     this->m_firstTranslucentBin,
+                                     vesMaterial::Overlay);
+
+  // The next cull rewrites the matrices cached by the scene.
+  this->m_renderStages[buffer]->detachFromScene(*this->m_frameArenas[buffer]);
+
+  statistics.m_updateTime = cullTime - startTime;
+  statistics.m_cullTime = vesRenderStatistics::currentTime() - cullTime;
+
+  vesRenderStatistics::setCurrent(frameStatistics);
+}
+
+
+void vesRenderer::executeSceneCommands()
+{
+  {
+    vesMutexLocker locker(this->m_commandMutex);
+    if (this->m_commands.empty()) {
+      return;
+    }
+    this->m_commands.swap(this->m_executedCommands);
+  }
+
+  for (size_t i = 0; i < this->m_executedCommands.size(); ++i) {
+    this->m_executedCommands[i]->execute(*this);
+  }
+  this->m_executedCommands.clear();
+
+  this->requestRender();
+}
+
+
+void vesRenderer::enqueueSceneCommand(vesSharedPtr<vesSceneCommand> command)
+{
+  if (!command) {
+    return;
+  }
+
+  {
+    vesMutexLocker locker(this->m_commandMutex);
+    this->m_commands.push_back(command);
+  }
+
+  // Wake up hosts waiting on isRenderNeeded().
+  vesObject::modified();
+}
+
+
+void vesRenderer::setPipelined(bool enable)
+{
+  if (enable == this->m_pipelined) {
+    return;
+  }
+
+  if (enable) {
+    if (!this->m_cullThread) {
+      this->m_cullThread = new vesCullThread(this);
+      if (!this->m_cullThread->start()) {
+        delete this->m_cullThread; this->m_cullThread = 0x0;
+        return;
+      }
+    }
+    if (!this->m_renderStages[1]) {
+      this->m_renderStages[1] = vesRenderStage::Ptr(new vesRenderStage());
+      this->m_frameArenas[1] =
+        vesSharedPtr<vesFrameArena>(new vesFrameArena());
+    }
+  }
+  else {
+    // Drop the frame culled ahead.
+    if (this->m_drawBuffer >= 0) {
+      this->m_renderStages[this->m_drawBuffer]->releaseScene();
+      this->m_renderStages[this->m_drawBuffer]->clearAll();
+    }
+    this->m_drawBuffer = -1;
+    this->m_pendingFrameChanged = false;
+    delete this->m_cullThread; this->m_cullThread = 0x0;
+  }
+
+  this->m_pipelined = enable;
+  this->requestRender();
+}
+
+
+bool vesRenderer::isRenderNeeded()
+{
+  return this->m_pendingFrameChanged || this->isSceneModified() ||
+    this->hasPendingSortedTriangles();
+}
+
+
+bool vesRenderer::hasPendingSortedTriangles()
+{
+  // The sorters publish on their worker threads, possibly while render()
+  // runs, so the modification count cannot tell.
+  for (size_t i = 0; i < this->m_triangleSorters.size(); ++i) {
+    vesSharedPtr<vesTriangleSorter> sorter = this->m_triangleSorters[i].lock();
+    if (sorter && sorter->hasSortedIndices()) {
+      return true;
+    }
+  }
+  return false;
+}
+
+
+bool vesRenderer::isSceneModified()
+{
+  return this->m_renderRequested ||
+    this->m_renderedModificationCount != vesObject::modificationCount() ||
+    this->m_renderedViewMatrix != this->m_camera->modelViewMatrix() ||
+    this->m_renderedProjectionMatrix != this->m_camera->projectionMatrix();
 }
 
 
@@ -100,16 +458,41 @@ void vesRenderer::resize(int width, int height, float scale)
 
   this->m_aspect[0] = this->m_camera->viewport()->inverseAspect();
   this->m_aspect[1] = this->m_camera->viewport()->aspect();
+
+  this->requestRender();
 }
 
 
 vesVector3f vesRenderer::computeWorldToDisplay(vesVector3f world)
 {
-  // WorldToView
+  return this->computeWorldToDisplay(this->computeWorldToViewTransform(), world);
+}
+
+
+void vesRenderer::computeWorldToDisplay(const std::vector<vesVector3f> &world,
+                                        std::vector<vesVector3f> &display)
+{
+  const vesMatrix4x4f t = this->computeWorldToViewTransform();
+  display.resize(world.size());
+  for (size_t i = 0; i < world.size(); ++i) {
+    display[i] = this->computeWorldToDisplay(t, world[i]);
+  }
+}
+
+
+vesMatrix4x4f vesRenderer::computeWorldToViewTransform()
+{
   vesMatrix4x4f proj_mat = this->m_camera->computeProjectionTransform(this->m_aspect[1],
                                                                     0, 1);
   vesMatrix4x4f view_mat = this->m_camera->computeViewTransform();
-  vesMatrix4x4f t(proj_mat * view_mat);
+  return proj_mat * view_mat;
+}
+
+
+vesVector3f vesRenderer::computeWorldToDisplay(const vesMatrix4x4f &t,
+                                               const vesVector3f &world) const
+{
+  // WorldToView
   vesVector4f world4(world[0], world[1], world[2], 1);
   vesVector4f view = t * world4;
   view[0] /= view[3];
@@ -148,6 +531,86 @@ vesVector3f vesRenderer::computeDisplayToWorld(vesVector3f display)
 }
 
 
+vesSharedPtr<vesActor> vesRenderer::pickActor(int x, int y)
+{
+  return this->pickActor(x, y, std::vector< vesSharedPtr<vesActor> >());
+}
+
+
+vesSharedPtr<vesActor> vesRenderer::pickActor(
+  int x, int y, const std::vector< vesSharedPtr<vesActor> > &actors)
+{
+  if (!this->m_sceneRoot) {
+    return vesSharedPtr<vesActor>();
+  }
+
+  if (!this->m_idBufferPicker) {
+    this->m_idBufferPicker =
+      vesIdBufferPicker::Ptr(new vesIdBufferPicker());
+  }
+
+  std::vector<const vesActor*> candidates;
+  for (size_t i = 0; i < actors.size(); ++i) {
+    candidates.push_back(actors[i].get());
+  }
+
+  // Cull again, the leaves of the last frame may refer to actors that have
+  // been removed since. A frame culled ahead keeps its buffer.
+  const int buffer = (this->m_drawBuffer < 0) ? 0 : 1 - this->m_drawBuffer;
+  this->m_cullBuffer = buffer;
+  this->m_frameArenas[buffer]->reset();
+  this->updateTraverseScene();
+  this->cullTraverseScene();
+
+  const vesActor *picked = 0x0;
+  if (this->m_camera->renderStage()) {
+    picked = this->m_idBufferPicker->pick(*this->m_camera->renderStage(),
+                                          x, y, candidates);
+  }
+
+  this->m_renderStages[buffer]->clearAll();
+
+  return picked ? findActor(*this->m_sceneRoot, picked)
+                : vesSharedPtr<vesActor>();
+}
+
+
+void vesRenderer::setSceneStoreEnabled(bool enable)
+{
+  if (enable && !this->m_sceneStore) {
+    this->m_sceneStore = vesSceneStore::Ptr(new vesSceneStore());
+  }
+  else if (!enable) {
+    this->m_sceneStore.reset();
+  }
+}
+
+
+bool vesRenderer::isSceneStoreEnabled() const
+{
+  return this->m_sceneStore.get() != 0x0;
+}
+
+
+void vesRenderer::setResolutionScale(float scale)
+{
+  scale = (scale > 0.0f) ? std::min(scale, 1.0f) : 1.0f;
+  if (scale != this->m_resolutionScale) {
+    this->m_resolutionScale = scale;
+    this->requestRender();
+  }
+}
+
+
+void vesRenderer::setFirstTranslucentBin(int bin)
+{
+  if (bin != this->m_firstTranslucentBin) {
+    this->m_firstTranslucentBin = bin;
+    this->requestRender();
+  }
+}
+
+
 void vesRenderer::resetCamera()
 {
   if (!this->m_sceneRoot) {
@@ -315,6 +778,7 @@ void vesRenderer::setBackgroundColor(float r, float g, float b, float a)
     this->m_background->setColor(vesVector4f(r, g, b, a));
   }
   this->m_camera->setClearColor(vesVector4f(r, g, b, a));
+  this->requestRender();
 }
 
 
@@ -350,7 +814,8 @@ void vesRenderer::updateTraverseScene()
 {
   // Update traversal.
   vesVisitor updateVisitor(vesVisitor::UpdateVisitor,
-                           vesVisitor::TraverseAllChildren);
+                           vesVisitor::TraverseAllChildren,
+                           this->m_frameArenas[this->m_cullBuffer].get());
 
   this->m_camera->accept(updateVisitor);
 }
@@ -358,12 +823,17 @@ void vesRenderer::updateTraverseScene()
 
 void vesRenderer::cullTraverseScene()
 {
-  vesCullVisitor cullVisitor;
+  vesCullVisitor cullVisitor(*this->m_frameArenas[this->m_cullBuffer]);
+  cullVisitor.setStageBuffer(this->m_cullBuffer);
 
   vesMatrix4x4f projection2DMatrix = vesOrtho(0, this->width(), 0, this->height(), -1, 1);
   cullVisitor.setProjection2DMatrix(projection2DMatrix);
 
-  cullVisitor.setRenderStage(this->m_renderStage);
+  cullVisitor.setRenderStage(this->m_renderStages[this->m_cullBuffer]);
+
+  if (this->m_sceneStore) {
+    cullVisitor.setSceneStore(this->m_sceneStore, this->m_sceneRoot.get());
+  }
 
   this->m_camera->accept(cullVisitor);
 }
@@ -25,7 +25,8 @@
 /// vesRenderer is the backbone of the rendering in VES.  It performs
 /// the rendering by visiting registered actors with the renderer. Rendering
 /// in VES is a three pass algorithm. Scene gets updated first, culled afterwards
-/// and then gets rendered.
+/// and then gets rendered. When pipelined, the update and cull of the next
+/// frame run on a worker thread while the current frame is drawn.
 ///
 /// \see vesActor vesMapper vesVisitor
 
@@ -35,18 +36,28 @@
 // VES includes
 #include "vesGL.h"
 #include "vesMath.h"
+#include "vesMutex.h"
+#include "vesRenderStatistics.h"
 #include "vesSetGet.h"
 
 // C++ includes
 #include <string>
+#include <vector>
 
 // Forward declarations
 class vesActor;
 class vesBackground;
 class vesCamera;
+class vesFrameArena;
+class vesGPUTimer;
 class vesGroupNode;
+class vesIdBufferPicker;
 class vesRenderStage;
+class vesResolutionScaler;
+class vesSceneCommand;
+class vesSceneStore;
 class vesTexture;
+class vesTriangleSorter;
 
 class vesRenderer
 {
@@ -100,9 +111,78 @@ public:
   /// Transform a vector in world space to display space
   vesVector3f computeWorldToDisplay(vesVector3f world);
 
+  /// Transform many vectors in world space to display space at once,
+  /// computing the camera transforms only once
+  void computeWorldToDisplay(const std::vector<vesVector3f> &world,
+                             std::vector<vesVector3f> &display);
+
   /// Transform a vector in display space to world space
   vesVector3f computeDisplayToWorld(vesVector3f display);
 
+  /// Return the front most actor drawn at the display position, with the
+  /// origin at the bottom left, or a null pointer. The scene is culled and
+  /// drawn offscreen with actor ids, so call it with the context current.
+  vesSharedPtr<vesActor> pickActor(int x, int y);
+
+  /// Same as above, but only \p actors are drawn and can be picked.
+  vesSharedPtr<vesActor> pickActor(
+    int x, int y, const std::vector< vesSharedPtr<vesActor> > &actors);
+
+  /// Cull the scene through a flattened copy of it, in parallel, instead of
+  /// traversing the scene graph. Pays off for scenes with many actors.
+  /// Disabled by default.
+  /// \see vesSceneStore
+  void setSceneStoreEnabled(bool enable);
+  bool isSceneStoreEnabled() const;
+
+  /// Get the scene store, a null pointer unless it is enabled
+  vesSharedPtr<vesSceneStore> sceneStore() { return this->m_sceneStore; }
+
+  /// Queue \p command to run on the rendering thread at the start of the
+  /// next render(). Safe to call from any thread.
+  /// \see vesSceneCommand
+  void enqueueSceneCommand(vesSharedPtr<vesSceneCommand> command);
+
+  /// Update and cull the next frame on a worker thread while the current
+  /// one is drawn. Each render() then draws the frame culled by the previous
+  /// one, so edits made between two render() calls, or queued with
+  /// enqueueSceneCommand(), are drawn one render() later than without
+  /// pipelining, and isRenderNeeded() stays true until they are. The worker
+  /// only runs inside render(), the rendering thread can edit the scene
+  /// between calls as usual. Disabled by default.
+  void setPipelined(bool enable);
+  bool pipelined() const { return this->m_pipelined; }
+
+  /// Render the scene offscreen at \p scale times the window resolution
+  /// and upsample it to the window, trading sharpness for speed. Clamped
+  /// to (0, 1], 1 by default renders directly to the window.
+  /// \see vesFrameRateGovernor
+  void setResolutionScale(float scale);
+  float resolutionScale() const { return this->m_resolutionScale; }
+
+  /// Bins from \p bin up to, not including, vesMaterial::Overlay hold
+  /// translucent geometry and are rendered back to front. Defaults to
+  /// vesMaterial::Transparent.
+  void setFirstTranslucentBin(int bin);
+  int firstTranslucentBin() const { return this->m_firstTranslucentBin; }
+
+  /// Return true if anything that affects the rendered image changed since
+  /// the last render(): the scene, materials, uniforms, the camera or the
+  /// renderer settings, or a drawn mapper's triangles were sorted in a new
+  /// order. Host applications can stop rendering, and save power, for as
+  /// long as it returns false.
+  /// \see vesObject::modified() vesTriangleSorter::hasSortedIndices()
+  bool isRenderNeeded();
+
+  /// Make isRenderNeeded() return true until the next render(), for
+  /// changes that are not tracked, e.g. geometry data edited in place
+  /// without vesGeometryData::setDataModified().
+  void requestRender() { this->m_renderRequested = true; }
+
+  /// Draw calls, state changes, uploads and phase timings of the last
+  /// render(), see vesRenderStatistics.
+  const vesRenderStatistics& statistics() const { return this->m_statistics; }
+
 protected:
 
   virtual void updateTraverseScene();
@@ -112,7 +192,23 @@ protected:
 
   void resetCameraClippingRange(float bounds[6]);
 
+  /// The world to view transform of the camera, and the single point math
+  /// shared by both computeWorldToDisplay() overloads.
+  vesMatrix4x4f computeWorldToViewTransform();
+  vesVector3f computeWorldToDisplay(const vesMatrix4x4f &t,
+                                    const vesVector3f &world) const;
+
 private:
+  class vesCullThread;
+
+  /// Update and cull the scene into \p buffer, ready to be drawn after the
+  /// scene changed again. Runs on the cull thread when pipelined.
+  void cullFrame(int buffer);
+
+  void executeSceneCommands();
+  bool isSceneModified();
+  bool hasPendingSortedTriangles();
+
   double m_aspect[2];
   int m_width;
   int m_height;
@@ -120,8 +216,45 @@ private:
   vesSharedPtr<vesCamera> m_camera;
   vesSharedPtr<vesGroupNode> m_sceneRoot;
 
-  vesSharedPtr<vesRenderStage> m_renderStage;
+  /// Render stages, and the frame arenas holding their leaves, matrices and
+  /// traversal stacks. Only the first ones are used unless pipelined.
+  vesSharedPtr<vesRenderStage> m_renderStages[2];
+  vesSharedPtr<vesFrameArena> m_frameArenas[2];
+  int m_cullBuffer;
   vesSharedPtr<vesBackground> m_background;
+  vesSharedPtr<vesIdBufferPicker> m_idBufferPicker;
+  vesSharedPtr<vesSceneStore> m_sceneStore;
+
+  float m_resolutionScale;
+  vesSharedPtr<vesResolutionScaler> m_resolutionScaler;
+
+  int m_firstTranslucentBin;
+
+  bool m_renderRequested;
+  unsigned int m_renderedModificationCount;
+  vesMatrix4x4f m_renderedViewMatrix;
+  vesMatrix4x4f m_renderedProjectionMatrix;
+
+  vesRenderStatistics m_statistics;
+  vesSharedPtr<vesGPUTimer> m_gpuTimer;
+
+  bool m_pipelined;
+  vesCullThread *m_cullThread;
+  /// Buffer culled ahead by the last render(), -1 if none
+  int m_drawBuffer;
+  bool m_pendingFrameChanged;
+  vesRenderStatistics m_cullStatistics[2];
+
+  /// Sorters of the mappers drawn by the last render(). An order they
+  /// publish afterwards needs another render().
+  std::vector< vesWeakPtr<vesTriangleSorter> > m_triangleSorters;
+
+  vesMutex m_commandMutex;
+  std::vector< vesSharedPtr<vesSceneCommand> > m_commands;
+  std::vector< vesSharedPtr<vesSceneCommand> > m_executedCommands;
+
+  vesRenderer(const vesRenderer&);      // Not implemented
+  void operator=(const vesRenderer&);   // Not implemented
 };
 
 #endif
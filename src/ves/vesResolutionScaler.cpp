@@ -0,0 +1,182 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+
+#include "vesResolutionScaler.h"
+
+// VES includes
+#include "vesDepth.h"
+#include "vesFBO.h"
+#include "vesGeometryData.h"
+#include "vesGL.h"
+#include "vesGLTypes.h"
+#include "vesMapper.h"
+#include "vesMaterial.h"
+#include "vesPrimitive.h"
+#include "vesRenderState.h"
+#include "vesShader.h"
+#include "vesShaderProgram.h"
+#include "vesSourceData.h"
+#include "vesTexture.h"
+#include "vesVertexAttribute.h"
+#include "vesVertexAttributeKeys.h"
+
+// C/C++ includes
+#include <string>
+
+class vesResolutionScaler::vesInternal
+{
+public:
+  vesInternal() :
+    m_fbo(new vesFBO()),
+    m_texture(new vesTexture()),
+    m_mapper(new vesMapper()),
+    m_material(new vesMaterial()),
+    m_shaderProgram(new vesShaderProgram()),
+    m_vertexShader(new vesShader(vesShader::Vertex)),
+    m_fragmentShader(new vesShader(vesShader::Fragment)),
+    m_positionVertexAttribute(new vesPositionVertexAttribute()),
+    m_depth(new vesDepth()),
+    m_previousFrameBuffer(0)
+  {
+    this->m_texture->setInternalFormat(vesColorDataType::RGBA);
+    this->m_texture->setPixelFormat(vesColorDataType::RGBA);
+    this->m_texture->setPixelDataType(vesColorDataType::UnsignedByte);
+    this->m_fbo->setTexture(vesFBO::ColorAttachment0, this->m_texture.get());
+
+    this->m_depth->disable();
+
+    // The quad covers the clip space, the texture coordinates follow.
+    const std::string vertexShaderSource =
+      "attribute highp vec4 vertexPosition;\n \
+       varying mediump vec2 textureCoordinate;\n \
+       void main()\n \
+       {\n \
+         gl_Position = vertexPosition;\n \
+         textureCoordinate = vertexPosition.xy * 0.5 + 0.5;\n \
+       }";
+
+    const std::string fragmentShaderSource =
+      "uniform sampler2D image;\n \
+       varying mediump vec2 textureCoordinate;\n \
+       void main()\n \
+       {\n \
+         gl_FragColor = texture2D(image, textureCoordinate);\n \
+       }";
+
+    this->m_vertexShader->setShaderSource(vertexShaderSource);
+    this->m_fragmentShader->setShaderSource(fragmentShaderSource);
+
+    this->m_shaderProgram->addShader(this->m_vertexShader);
+    this->m_shaderProgram->addShader(this->m_fragmentShader);
+    this->m_shaderProgram->addVertexAttribute(this->m_positionVertexAttribute,
+                                              vesVertexAttributeKeys::Position);
+
+    this->m_material->addAttribute(this->m_shaderProgram);
+    this->m_material->addAttribute(this->m_depth);
+    this->m_material->addAttribute(this->m_texture);
+
+    this->m_mapper->setGeometryData(this->createQuad());
+  }
+
+  vesSharedPtr<vesGeometryData> createQuad();
+
+  vesSharedPtr<vesFBO> m_fbo;
+  vesSharedPtr<vesTexture> m_texture;
+  vesSharedPtr<vesMapper> m_mapper;
+  vesSharedPtr<vesMaterial> m_material;
+  vesSharedPtr<vesShaderProgram> m_shaderProgram;
+  vesSharedPtr<vesShader> m_vertexShader;
+  vesSharedPtr<vesShader> m_fragmentShader;
+  vesSharedPtr<vesPositionVertexAttribute> m_positionVertexAttribute;
+  vesSharedPtr<vesDepth> m_depth;
+
+  GLint m_previousFrameBuffer;
+};
+
+
+vesSharedPtr<vesGeometryData> vesResolutionScaler::vesInternal::createQuad()
+{
+  vesSourceDataP3f::Ptr sourceData(new vesSourceDataP3f());
+  vesVertexDataP3f vertex;
+  vertex.m_position = vesVector3f(-1.0f, -1.0f, 0.0f);
+  sourceData->pushBack(vertex);
+  vertex.m_position = vesVector3f(1.0f, -1.0f, 0.0f);
+  sourceData->pushBack(vertex);
+  vertex.m_position = vesVector3f(1.0f, 1.0f, 0.0f);
+  sourceData->pushBack(vertex);
+  vertex.m_position = vesVector3f(-1.0f, 1.0f, 0.0f);
+  sourceData->pushBack(vertex);
+
+  vesPrimitive::Ptr triangles(new vesPrimitive());
+  triangles->pushBackIndices(0, 1, 2);
+  triangles->pushBackIndices(0, 2, 3);
+  triangles->setPrimitiveType(vesPrimitiveRenderType::Triangles);
+  triangles->setIndexCount(3);
+
+  vesGeometryData::Ptr geometryData(new vesGeometryData());
+  geometryData->setName("ResolutionScalerQuad");
+  geometryData->addSource(sourceData);
+  geometryData->addPrimitive(triangles);
+  return geometryData;
+}
+
+
+vesResolutionScaler::vesResolutionScaler()
+{
+  this->m_internal = new vesInternal();
+}
+
+
+vesResolutionScaler::~vesResolutionScaler()
+{
+  delete this->m_internal; this->m_internal = 0x0;
+}
+
+
+void vesResolutionScaler::begin(int width, int height)
+{
+  glGetIntegerv(GL_FRAMEBUFFER_BINDING, &this->m_internal->m_previousFrameBuffer);
+
+  vesFBO *fbo = this->m_internal->m_fbo.get();
+  if (fbo->width() != width || fbo->height() != height) {
+    fbo->setWidth(width);
+    fbo->setHeight(height);
+  }
+
+  vesRenderState renderState;
+  fbo->render(renderState);
+}
+
+
+void vesResolutionScaler::end(int x, int y, int width, int height)
+{
+  glBindFramebuffer(GL_FRAMEBUFFER, this->m_internal->m_previousFrameBuffer);
+  glViewport(x, y, width, height);
+  glDisable(GL_BLEND);
+
+  vesRenderState renderState;
+  const vesSharedPtr<vesMaterial> &material = this->m_internal->m_material;
+  renderState.applyMaterial(material.get());
+  renderState.applyMapper(this->m_internal->m_mapper.get());
+
+  material->render(renderState);
+  this->m_internal->m_mapper->render(renderState);
+  material->remove(renderState);
+}
@@ -0,0 +1,61 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+/// \class vesResolutionScaler
+/// \ingroup ves
+/// \brief Renders frames offscreen at reduced resolution and upsamples them.
+///
+/// begin() redirects rendering into a framebuffer object with a color
+/// texture of the given size, end() draws that texture stretched over the
+/// viewport of the framebuffer that was bound before, with linear
+/// filtering. The offscreen buffers are reallocated only when the size
+/// changes.
+///
+/// \see vesRenderer::setResolutionScale vesFrameRateGovernor vesFBO
+
+#ifndef VESRESOLUTIONSCALER_H
+#define VESRESOLUTIONSCALER_H
+
+// VES includes
+#include "vesSetGet.h"
+
+class vesResolutionScaler
+{
+public:
+  vesTypeMacro(vesResolutionScaler);
+
+  vesResolutionScaler();
+  ~vesResolutionScaler();
+
+  /// Bind an offscreen framebuffer of \p width by \p height pixels.
+  void begin(int width, int height);
+
+  /// Bind the framebuffer that was bound on begin() again and draw the
+  /// offscreen color buffer into the given viewport.
+  void end(int x, int y, int width, int height);
+
+private:
+  class vesInternal;
+  vesInternal *m_internal;
+
+  vesResolutionScaler(const vesResolutionScaler&); // Not implemented
+  void operator=(const vesResolutionScaler&);      // Not implemented
+};
+
+#endif // VESRESOLUTIONSCALER_H
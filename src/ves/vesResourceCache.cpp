@@ -0,0 +1,375 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+
+#include "vesResourceCache.h"
+
+// VES includes
+#include "vesGeometryData.h"
+#include "vesImage.h"
+#include "vesPrimitive.h"
+#include "vesSourceData.h"
+#include "vesTexture.h"
+
+// C/C++ includes
+#include <cstring>
+#include <map>
+#include <vector>
+
+namespace {
+
+// FNV-1a, good enough to bucket payloads; equality is always verified
+// byte by byte before a resource is shared.
+class vesHash
+{
+public:
+  vesHash() : m_value(2166136261u)
+  {
+  }
+
+  void add(const void *data, unsigned int size)
+  {
+    const unsigned char *bytes = static_cast<const unsigned char*>(data);
+    for (unsigned int i = 0; i < size; ++i) {
+      this->m_value = (this->m_value ^ bytes[i]) * 16777619u;
+    }
+  }
+
+  void add(unsigned int value)
+  {
+    this->add(&value, sizeof(value));
+  }
+
+  unsigned int value() const
+  {
+    return this->m_value;
+  }
+
+private:
+  unsigned int m_value;
+};
+
+unsigned int hashImage(const vesImage &image)
+{
+  vesHash hash;
+  hash.add(image.width());
+  hash.add(image.height());
+  hash.add(image.depth());
+  hash.add(image.pixelFormat());
+  hash.add(image.pixelDataType());
+  hash.add(image.dataSize());
+  if (image.data()) {
+    hash.add(image.data(), image.dataSize());
+  }
+  return hash.value();
+}
+
+bool sameImage(const vesImage &a, const vesImage &b)
+{
+  if (a.width() != b.width() || a.height() != b.height() ||
+      a.depth() != b.depth() || a.pixelFormat() != b.pixelFormat() ||
+      a.pixelDataType() != b.pixelDataType() ||
+      a.dataSize() != b.dataSize()) {
+    return false;
+  }
+
+  if (!a.data() || !b.data()) {
+    return a.data() == b.data();
+  }
+
+  return memcmp(a.data(), b.data(), a.dataSize()) == 0;
+}
+
+unsigned int hashGeometryData(vesGeometryData &geometryData)
+{
+  vesHash hash;
+
+  hash.add(geometryData.numberOfSources());
+  for (unsigned int i = 0; i < geometryData.numberOfSources(); ++i) {
+    vesSharedPtr<vesSourceData> source = geometryData.source(i);
+    std::vector<int> keys = source->keys();
+    for (size_t j = 0; j < keys.size(); ++j) {
+      hash.add(keys[j]);
+      hash.add(source->numberOfComponents(keys[j]));
+      hash.add(source->attributeDataType(keys[j]));
+      hash.add(source->attributeStride(keys[j]));
+      hash.add(source->attributeOffset(keys[j]));
+    }
+    hash.add(source->sizeInBytes());
+    if (source->sizeInBytes()) {
+      hash.add(source->data(), source->sizeInBytes());
+    }
+  }
+
+  hash.add(geometryData.numberOfPrimitiveTypes());
+  for (unsigned int i = 0; i < geometryData.numberOfPrimitiveTypes(); ++i) {
+    vesSharedPtr<vesPrimitive> primitive = geometryData.primitive(i);
+    hash.add(primitive->primitiveType());
+    hash.add(primitive->indexCount());
+    hash.add(primitive->sizeInBytes());
+    if (primitive->sizeInBytes()) {
+      hash.add(primitive->data(), primitive->sizeInBytes());
+    }
+  }
+
+  return hash.value();
+}
+
+bool sameSourceData(vesSourceData &a, vesSourceData &b)
+{
+  std::vector<int> keys = a.keys();
+  if (keys != b.keys() || a.sizeInBytes() != b.sizeInBytes()) {
+    return false;
+  }
+
+  for (size_t i = 0; i < keys.size(); ++i) {
+    int key = keys[i];
+    if (a.numberOfComponents(key) != b.numberOfComponents(key) ||
+        a.attributeDataType(key) != b.attributeDataType(key) ||
+        a.sizeOfAttributeDataType(key) != b.sizeOfAttributeDataType(key) ||
+        a.isAttributeNormalized(key) != b.isAttributeNormalized(key) ||
+        a.attributeStride(key) != b.attributeStride(key) ||
+        a.attributeOffset(key) != b.attributeOffset(key)) {
+      return false;
+    }
+  }
+
+  return !a.sizeInBytes() || memcmp(a.data(), b.data(), a.sizeInBytes()) == 0;
+}
+
+bool samePrimitive(const vesPrimitive &a, const vesPrimitive &b)
+{
+  return a.primitiveType() == b.primitiveType() &&
+         a.indexCount() == b.indexCount() &&
+         *a.indices() == *b.indices();
+}
+
+bool sameGeometryData(vesGeometryData &a, vesGeometryData &b)
+{
+  if (a.numberOfSources() != b.numberOfSources() ||
+      a.numberOfPrimitiveTypes() != b.numberOfPrimitiveTypes()) {
+    return false;
+  }
+
+  for (unsigned int i = 0; i < a.numberOfSources(); ++i) {
+    if (!sameSourceData(*a.source(i), *b.source(i))) {
+      return false;
+    }
+  }
+
+  for (unsigned int i = 0; i < a.numberOfPrimitiveTypes(); ++i) {
+    if (!samePrimitive(*a.primitive(i), *b.primitive(i))) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+unsigned long geometryDataSizeInBytes(vesGeometryData &geometryData)
+{
+  unsigned long size = 0;
+  for (unsigned int i = 0; i < geometryData.numberOfSources(); ++i) {
+    size += geometryData.source(i)->sizeInBytes();
+  }
+  for (unsigned int i = 0; i < geometryData.numberOfPrimitiveTypes(); ++i) {
+    size += geometryData.primitive(i)->sizeInBytes();
+  }
+  return size;
+}
+
+} // end namespace
+
+
+class vesResourceCache::vesInternal
+{
+public:
+  typedef std::multimap<unsigned int, vesWeakPtr<vesImage> > ImageMap;
+  typedef std::multimap<unsigned int, vesWeakPtr<vesTexture> > TextureMap;
+  typedef std::multimap<unsigned int, vesWeakPtr<vesGeometryData> >
+    GeometryDataMap;
+
+  /// Remove entries whose resource has been released by every client.
+  template <typename MapType>
+  static void removeExpired(MapType &map, unsigned int key)
+  {
+    typename MapType::iterator itr = map.lower_bound(key);
+    while (itr != map.end() && itr->first == key) {
+      if (itr->second.expired()) {
+        map.erase(itr++);
+      }
+      else {
+        ++itr;
+      }
+    }
+  }
+
+  ImageMap m_images;
+  TextureMap m_textures;
+  GeometryDataMap m_geometryData;
+
+  vesResourceCache::Statistics m_imageStatistics;
+  vesResourceCache::Statistics m_geometryStatistics;
+};
+
+
+vesResourceCache::vesResourceCache()
+{
+  this->m_internal = new vesInternal();
+}
+
+
+vesResourceCache::~vesResourceCache()
+{
+  delete this->m_internal; this->m_internal = 0x0;
+}
+
+
+vesResourceCache* vesResourceCache::instance()
+{
+  static vesResourceCache cache;
+  return &cache;
+}
+
+
+vesSharedPtr<vesImage> vesResourceCache::image(vesSharedPtr<vesImage> image)
+{
+  if (!image) {
+    return image;
+  }
+
+  unsigned int key = hashImage(*image);
+  vesInternal::removeExpired(this->m_internal->m_images, key);
+
+  vesInternal::ImageMap::iterator itr =
+    this->m_internal->m_images.lower_bound(key);
+  for (; itr != this->m_internal->m_images.end() && itr->first == key; ++itr) {
+    vesSharedPtr<vesImage> cached = itr->second.lock();
+    if (cached == image) {
+      return image;
+    }
+    if (sameImage(*cached, *image)) {
+      ++this->m_internal->m_imageStatistics.m_hits;
+      this->m_internal->m_imageStatistics.m_bytesSaved += image->dataSize();
+      return cached;
+    }
+  }
+
+  ++this->m_internal->m_imageStatistics.m_misses;
+  this->m_internal->m_images.insert(
+    std::make_pair(key, vesWeakPtr<vesImage>(image)));
+  return image;
+}
+
+
+vesSharedPtr<vesTexture> vesResourceCache::texture(vesSharedPtr<vesImage> image)
+{
+  if (!image || !image->data()) {
+    return vesSharedPtr<vesTexture>();
+  }
+
+  unsigned int key = hashImage(*image);
+  vesInternal::removeExpired(this->m_internal->m_textures, key);
+
+  vesInternal::TextureMap::iterator itr =
+    this->m_internal->m_textures.lower_bound(key);
+  for (; itr != this->m_internal->m_textures.end() && itr->first == key; ++itr) {
+    vesSharedPtr<vesTexture> cached = itr->second.lock();
+    if (cached->image() && sameImage(*cached->image(), *image)) {
+      ++this->m_internal->m_imageStatistics.m_hits;
+      this->m_internal->m_imageStatistics.m_bytesSaved += image->dataSize();
+      return cached;
+    }
+  }
+
+  ++this->m_internal->m_imageStatistics.m_misses;
+  vesSharedPtr<vesTexture> texture(new vesTexture());
+  texture->setImage(image);
+  this->m_internal->m_textures.insert(
+    std::make_pair(key, vesWeakPtr<vesTexture>(texture)));
+  return texture;
+}
+
+
+vesSharedPtr<vesGeometryData> vesResourceCache::geometryData(
+  vesSharedPtr<vesGeometryData> geometryData)
+{
+  if (!geometryData) {
+    return geometryData;
+  }
+
+  unsigned int key = hashGeometryData(*geometryData);
+  vesInternal::removeExpired(this->m_internal->m_geometryData, key);
+
+  vesInternal::GeometryDataMap::iterator itr =
+    this->m_internal->m_geometryData.lower_bound(key);
+  for (; itr != this->m_internal->m_geometryData.end() && itr->first == key;
+       ++itr) {
+    vesSharedPtr<vesGeometryData> cached = itr->second.lock();
+    if (cached == geometryData) {
+      return geometryData;
+    }
+
+    // The arrays of the cached copy may have been released after upload.
+    if (!cached->lockData()) {
+      continue;
+    }
+    const bool same = sameGeometryData(*cached, *geometryData);
+    cached->unlockData();
+
+    if (same) {
+      ++this->m_internal->m_geometryStatistics.m_hits;
+      this->m_internal->m_geometryStatistics.m_bytesSaved +=
+        geometryDataSizeInBytes(*geometryData);
+      return cached;
+    }
+  }
+
+  ++this->m_internal->m_geometryStatistics.m_misses;
+  this->m_internal->m_geometryData.insert(
+    std::make_pair(key, vesWeakPtr<vesGeometryData>(geometryData)));
+  return geometryData;
+}
+
+
+const vesResourceCache::Statistics& vesResourceCache::imageStatistics() const
+{
+  return this->m_internal->m_imageStatistics;
+}
+
+
+const vesResourceCache::Statistics& vesResourceCache::geometryStatistics() const
+{
+  return this->m_internal->m_geometryStatistics;
+}
+
+
+void vesResourceCache::resetStatistics()
+{
+  this->m_internal->m_imageStatistics = Statistics();
+  this->m_internal->m_geometryStatistics = Statistics();
+}
+
+
+void vesResourceCache::clear()
+{
+  this->m_internal->m_images.clear();
+  this->m_internal->m_textures.clear();
+  this->m_internal->m_geometryData.clear();
+}
@@ -0,0 +1,112 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+/// \class vesResourceCache
+/// \ingroup ves
+/// \brief Process wide cache that de-duplicates images, textures and
+/// geometry data by content.
+///
+/// Callers hand in a freshly built resource and get back a shared handle to
+/// an already registered resource with identical content, or the given
+/// resource itself if none exists yet. Since textures and mappers upload
+/// their GPU data per object, sharing the handle means identical payloads
+/// are uploaded only once.
+///
+/// The cache keeps weak references only; a resource is dropped from the
+/// cache when the last client releases it. Shared resources must be
+/// treated as read-only by the clients.
+///
+/// \see vesImage vesTexture vesGeometryData
+
+#ifndef VESRESOURCECACHE_H
+#define VESRESOURCECACHE_H
+
+// VES includes
+#include "vesSetGet.h"
+
+// Forward declarations
+class vesGeometryData;
+class vesImage;
+class vesTexture;
+
+class vesResourceCache
+{
+public:
+  vesTypeMacro(vesResourceCache);
+
+  struct Statistics
+  {
+    Statistics() : m_hits(0), m_misses(0), m_bytesSaved(0)
+    {
+    }
+
+    /// Ratio of lookups that returned an existing resource
+    double hitRate() const
+    {
+      unsigned int lookups = this->m_hits + this->m_misses;
+      return lookups ? static_cast<double>(this->m_hits) / lookups : 0.0;
+    }
+
+    unsigned int m_hits;
+    unsigned int m_misses;
+    unsigned long m_bytesSaved;
+  };
+
+  /// Get the process wide cache
+  static vesResourceCache* instance();
+
+  /// Return the registered image with the same content as \p image,
+  /// registering \p image if there is none.
+  vesSharedPtr<vesImage> image(vesSharedPtr<vesImage> image);
+
+  /// Return the registered texture whose image has the same content as
+  /// \p image, creating a new texture if there is none.
+  vesSharedPtr<vesTexture> texture(vesSharedPtr<vesImage> image);
+
+  /// Return the registered geometry data with the same sources and
+  /// primitives as \p geometryData, registering \p geometryData if there
+  /// is none. Only pass geometry data that will not be modified anymore.
+  vesSharedPtr<vesGeometryData> geometryData(
+    vesSharedPtr<vesGeometryData> geometryData);
+
+  /// Statistics of image and texture lookups
+  const Statistics& imageStatistics() const;
+
+  /// Statistics of geometry data lookups
+  const Statistics& geometryStatistics() const;
+
+  /// Reset the statistics counters
+  void resetStatistics();
+
+  /// Forget all registered resources. Handles given out before remain valid.
+  void clear();
+
+protected:
+  vesResourceCache();
+  ~vesResourceCache();
+
+  class vesInternal;
+  vesInternal *m_internal;
+
+private:
+  vesResourceCache(const vesResourceCache&); // Not implemented
+  void operator=(const vesResourceCache&);   // Not implemented
+};
+
+#endif // VESRESOURCECACHE_H
@@ -0,0 +1,50 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+/// \class vesSceneCommand
+/// \ingroup ves
+/// \brief Edit of the scene deferred to the rendering thread.
+///
+/// Threads other than the rendering thread must not touch the scene graph.
+/// They hand their edits to vesRenderer::enqueueSceneCommand() instead,
+/// which runs them on the rendering thread at the start of the next
+/// render(), in the order they were queued, before the scene is culled.
+/// \see vesRenderer
+
+#ifndef VESSCENECOMMAND_H
+#define VESSCENECOMMAND_H
+
+// VES includes
+#include "vesSetGet.h"
+
+// Forward declarations
+class vesRenderer;
+
+class vesSceneCommand
+{
+public:
+  vesTypeMacro(vesSceneCommand);
+
+  virtual ~vesSceneCommand() {}
+
+  /// Apply the edit to the scene of \p renderer.
+  virtual void execute(vesRenderer &renderer) = 0;
+};
+
+#endif // VESSCENECOMMAND_H
@@ -0,0 +1,597 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+
+#include "vesSceneStore.h"
+
+// VES includes
+#include "vesActor.h"
+#include "vesConditionVariable.h"
+#include "vesGroupNode.h"
+#include "vesMapper.h"
+#include "vesMaterial.h"
+#include "vesMutex.h"
+#include "vesRenderLeaf.h"
+#include "vesRenderStage.h"
+#include "vesRenderStatistics.h"
+#include "vesThread.h"
+#include "vesTransformNode.h"
+#include "vesVisitor.h"
+
+// C/C++ includes
+#include <algorithm>
+#include <vector>
+
+namespace {
+
+// Return false if the box, given in the coordinates \p matrix maps to clip
+// coordinates, is entirely outside of one of the clip planes. Empty boxes
+// are never rejected.
+bool intersectsFrustum(const vesMatrix4x4f &matrix,
+                       const vesVector3f &minimum, const vesVector3f &maximum)
+{
+  if (minimum[0] > maximum[0] || minimum[1] > maximum[1] ||
+      minimum[2] > maximum[2]) {
+    return true;
+  }
+
+  vesVector3f center = 0.5f * (minimum + maximum);
+  vesVector3f extent = 0.5f * (maximum - minimum);
+  vesVector4f w = matrix.row(3).transpose();
+
+  for (int i = 0; i < 3; ++i) {
+    vesVector4f row = matrix.row(i).transpose();
+    for (int side = 0; side < 2; ++side) {
+      // -w <= x_i <= w
+      vesVector4f plane = side ? vesVector4f(w - row) : vesVector4f(w + row);
+      float distance = plane.head<3>().dot(center) + plane[3];
+      float radius = plane.head<3>().cwiseAbs().dot(extent);
+      if (distance + radius < 0.0f) {
+        return false;
+      }
+    }
+  }
+
+  return true;
+}
+
+} // end namespace
+
+
+class vesSceneStore::vesInternal
+{
+public:
+  class Worker : public vesThread
+  {
+  public:
+    explicit Worker(vesInternal *internal) : m_internal(internal)
+    {
+    }
+
+    ~Worker()
+    {
+      this->join();
+    }
+
+  protected:
+    virtual void run()
+    {
+      this->m_internal->workerLoop();
+    }
+
+    vesInternal *m_internal;
+  };
+
+  vesInternal() :
+    m_visitor(vesVisitor::CullVisitor, vesVisitor::TraverseNone),
+    m_root(0x0),
+    m_structureVersion(0),
+    m_flattened(false),
+    m_valid(false),
+    m_numberOfThreads(0),
+    m_chunkSize(256),
+    m_frustumCulling(true),
+    m_numberOfCulledActors(0),
+    m_projectionMatrix(0x0),
+    m_projection2DMatrix(0x0),
+    m_generation(0),
+    m_numberOfChunks(0),
+    m_nextChunk(0),
+    m_chunksDone(0),
+    m_requestedWorkers(0),
+    m_quit(false)
+  {
+  }
+
+  ~vesInternal()
+  {
+    this->stopWorkers();
+  }
+
+  bool flatten(vesNode &node, int parent);
+  void refresh(const vesMatrix4x4f &viewMatrix, unsigned int viewVersion);
+  void cullChunk(int chunk);
+  void cullChunks(int numberOfThreads);
+
+  void startWorkers(int numberOfWorkers);
+  void stopWorkers();
+  void workerLoop();
+  void processChunks();
+
+  int resolvedNumberOfThreads() const
+  {
+    return this->m_numberOfThreads > 0 ? this->m_numberOfThreads
+                                       : vesThread::numberOfProcessors();
+  }
+
+  // Only handed to vesTransformNode::localToWorldMatrix()
+  vesVisitor m_visitor;
+
+  vesGroupNode *m_root;
+  unsigned int m_structureVersion;
+  bool m_flattened;
+  bool m_valid;
+
+  int m_numberOfThreads;
+  int m_chunkSize;
+  bool m_frustumCulling;
+  int m_numberOfCulledActors;
+
+  // Nodes, parents before children
+  std::vector<vesNode*> m_nodes;
+  std::vector<int> m_parents;
+  std::vector<vesTransformNode*> m_transformNodes;
+  std::vector<const vesMatrix4x4f*> m_nodeMatrices;
+  std::vector<unsigned int> m_nodeVersions;
+  std::vector<unsigned char> m_nodeVisible;
+
+  // Actors
+  std::vector<int> m_actorNodes;
+  std::vector<vesActor*> m_actors;
+  std::vector<vesMatrix4x4f> m_modelViewMatrices;
+  std::vector<unsigned int> m_modelViewVersions;
+  std::vector<const vesMatrix3x3f*> m_normalMatrices;
+  std::vector<vesVector3f> m_boundsMinimum;
+  std::vector<vesVector3f> m_boundsMaximum;
+  std::vector<unsigned char> m_visible;
+  std::vector<unsigned char> m_overlay;
+  std::vector< vesSharedPtr<vesMapper> > m_mappers;
+  std::vector< vesSharedPtr<vesMaterial> > m_materials;
+
+  // Per chunk results of the current cull
+  std::vector<vesRenderStage::RenderLeaves> m_chunkLeaves;
+  std::vector<int> m_chunkCulled;
+  const vesMatrix4x4f *m_projectionMatrix;
+  const vesMatrix4x4f *m_projection2DMatrix;
+
+  // Work distribution, guarded by m_mutex
+  std::vector<Worker*> m_workers;
+  vesMutex m_mutex;
+  vesConditionVariable m_workAvailable;
+  vesConditionVariable m_workDone;
+  unsigned int m_generation;
+  int m_numberOfChunks;
+  int m_nextChunk;
+  int m_chunksDone;
+  // Size of the worker set last asked for, only used by cullChunks()
+  int m_requestedWorkers;
+  bool m_quit;
+};
+
+
+bool vesSceneStore::vesInternal::flatten(vesNode &node, int parent)
+{
+  // A camera culls its subgraph into a render stage of its own.
+  if (node.asCamera()) {
+    return false;
+  }
+
+  int index = static_cast<int>(this->m_nodes.size());
+  this->m_nodes.push_back(&node);
+  this->m_parents.push_back(parent);
+  this->m_transformNodes.push_back(node.asTransformNode());
+  this->m_nodeMatrices.push_back(0x0);
+  this->m_nodeVersions.push_back(0);
+  this->m_nodeVisible.push_back(1);
+
+  if (vesActor *actor = node.asActor()) {
+    this->m_actorNodes.push_back(index);
+    this->m_actors.push_back(actor);
+    this->m_modelViewMatrices.push_back(vesMatrix4x4f::Identity());
+    this->m_modelViewVersions.push_back(0);
+    this->m_normalMatrices.push_back(0x0);
+    this->m_boundsMinimum.push_back(vesVector3f(1, 1, 1));
+    this->m_boundsMaximum.push_back(vesVector3f(0, 0, 0));
+    this->m_visible.push_back(1);
+    this->m_overlay.push_back(0);
+    this->m_mappers.push_back(vesSharedPtr<vesMapper>());
+    this->m_materials.push_back(vesSharedPtr<vesMaterial>());
+  }
+
+  if (vesGroupNode *groupNode = node.asGroupNode()) {
+    vesGroupNode::Children::iterator itr = groupNode->children().begin();
+    for (; itr != groupNode->children().end(); ++itr) {
+      if (!this->flatten(**itr, index)) {
+        return false;
+      }
+    }
+  }
+
+  return true;
+}
+
+
+void vesSceneStore::vesInternal::refresh(const vesMatrix4x4f &viewMatrix,
+                                         unsigned int viewVersion)
+{
+  for (size_t i = 0; i < this->m_nodes.size(); ++i) {
+    int parent = this->m_parents[i];
+    bool parentVisible = parent < 0 || this->m_nodeVisible[parent];
+    this->m_nodeVisible[i] = parentVisible && this->m_nodes[i]->isVisible();
+
+    const vesMatrix4x4f *parentMatrix =
+      parent < 0 ? &viewMatrix : this->m_nodeMatrices[parent];
+    unsigned int parentVersion =
+      parent < 0 ? viewVersion : this->m_nodeVersions[parent];
+
+    // Invisible subgraphs keep their old matrices, which are recomputed
+    // when they show up again since the parent versions will not match.
+    vesTransformNode *transformNode = this->m_transformNodes[i];
+    if (transformNode && this->m_nodeVisible[i]) {
+      this->m_nodeMatrices[i] = &transformNode->localToWorldMatrix(
+        *parentMatrix, parentVersion, this->m_visitor);
+      this->m_nodeVersions[i] = transformNode->localToWorldVersion();
+    }
+    else {
+      this->m_nodeMatrices[i] = parentMatrix;
+      this->m_nodeVersions[i] = parentVersion;
+    }
+  }
+
+  for (size_t i = 0; i < this->m_actors.size(); ++i) {
+    int node = this->m_actorNodes[i];
+    this->m_visible[i] = this->m_nodeVisible[node];
+    if (!this->m_visible[i]) {
+      continue;
+    }
+
+    vesActor *actor = this->m_actors[i];
+    this->m_overlay[i] = actor->isOverlayNode();
+    if (this->m_overlay[i]) {
+      // Overlays are drawn with their local matrix in display coordinates.
+      this->m_modelViewMatrices[i] = actor->modelViewMatrix();
+      this->m_modelViewVersions[i] = 0;
+    }
+    else {
+      if (this->m_modelViewVersions[i] != this->m_nodeVersions[node] ||
+          !this->m_nodeVersions[node]) {
+        this->m_modelViewMatrices[i] = *this->m_nodeMatrices[node];
+        this->m_modelViewVersions[i] = this->m_nodeVersions[node];
+      }
+      this->m_normalMatrices[i] = &actor->normalMatrix();
+    }
+
+    this->m_mappers[i] = actor->mapper();
+    this->m_materials[i] = actor->material();
+
+    if (this->m_mappers[i]) {
+      this->m_boundsMinimum[i] = this->m_mappers[i]->boundsMinimum();
+      this->m_boundsMaximum[i] = this->m_mappers[i]->boundsMaximum();
+    }
+    else {
+      this->m_boundsMinimum[i] = vesVector3f(1, 1, 1);
+      this->m_boundsMaximum[i] = vesVector3f(0, 0, 0);
+    }
+  }
+}
+
+
+void vesSceneStore::vesInternal::cullChunk(int chunk)
+{
+  int begin = chunk * this->m_chunkSize;
+  int end = std::min(begin + this->m_chunkSize,
+                     static_cast<int>(this->m_actors.size()));
+
+  vesRenderStage::RenderLeaves &leaves = this->m_chunkLeaves[chunk];
+  leaves.clear();
+  int culled = 0;
+
+  vesMatrix4x4f clipMatrix;
+  for (int i = begin; i < end; ++i) {
+    if (!this->m_visible[i]) {
+      continue;
+    }
+
+    if (this->m_overlay[i]) {
+      leaves.push_back(vesRenderLeaf(1, &this->m_modelViewMatrices[i],
+        this->m_projection2DMatrix, this->m_materials[i].get(),
+        this->m_mappers[i].get(), this->m_actors[i]));
+      continue;
+    }
+
+    if (this->m_frustumCulling) {
+      clipMatrix.noalias() =
+        (*this->m_projectionMatrix) * this->m_modelViewMatrices[i];
+      if (!intersectsFrustum(clipMatrix, this->m_boundsMinimum[i],
+                             this->m_boundsMaximum[i])) {
+        ++culled;
+        continue;
+      }
+    }
+
+    leaves.push_back(vesRenderLeaf(1, &this->m_modelViewMatrices[i],
+      this->m_projectionMatrix, this->m_materials[i].get(),
+      this->m_mappers[i].get(), this->m_actors[i], this->m_normalMatrices[i]));
+  }
+
+  this->m_chunkCulled[chunk] = culled;
+}
+
+
+void vesSceneStore::vesInternal::cullChunks(int numberOfThreads)
+{
+  int numberOfChunks = static_cast<int>(this->m_chunkLeaves.size());
+  numberOfThreads = std::min(numberOfThreads, numberOfChunks);
+
+  if (numberOfThreads <= 1) {
+    for (int i = 0; i < numberOfChunks; ++i) {
+      this->cullChunk(i);
+    }
+    return;
+  }
+
+  // Compared with what was asked for, not what started, so that workers
+  // failing to start are not retried every frame.
+  if (this->m_requestedWorkers != numberOfThreads - 1) {
+    this->stopWorkers();
+    this->startWorkers(numberOfThreads - 1);
+  }
+
+  {
+    vesMutexLocker locker(this->m_mutex);
+    this->m_numberOfChunks = numberOfChunks;
+    this->m_nextChunk = 0;
+    this->m_chunksDone = 0;
+    ++this->m_generation;
+    this->m_workAvailable.broadcast();
+  }
+
+  // The calling thread takes its share as well.
+  this->processChunks();
+
+  vesMutexLocker locker(this->m_mutex);
+  while (this->m_chunksDone < this->m_numberOfChunks) {
+    this->m_workDone.wait(this->m_mutex);
+  }
+}
+
+
+void vesSceneStore::vesInternal::processChunks()
+{
+  this->m_mutex.lock();
+  while (this->m_nextChunk < this->m_numberOfChunks) {
+    int chunk = this->m_nextChunk++;
+    this->m_mutex.unlock();
+
+    this->cullChunk(chunk);
+
+    this->m_mutex.lock();
+    if (++this->m_chunksDone == this->m_numberOfChunks) {
+      this->m_workDone.signal();
+    }
+  }
+  this->m_mutex.unlock();
+}
+
+
+void vesSceneStore::vesInternal::workerLoop()
+{
+  unsigned int generation = 0;
+
+  for (;;) {
+    {
+      vesMutexLocker locker(this->m_mutex);
+      while (!this->m_quit && this->m_generation == generation) {
+        this->m_workAvailable.wait(this->m_mutex);
+      }
+      if (this->m_quit) {
+        return;
+      }
+      generation = this->m_generation;
+    }
+
+    this->processChunks();
+  }
+}
+
+
+void vesSceneStore::vesInternal::startWorkers(int numberOfWorkers)
+{
+  // Workers started now must not mistake the current generation for work.
+  this->m_numberOfChunks = 0;
+  this->m_nextChunk = 0;
+  this->m_requestedWorkers = numberOfWorkers;
+
+  for (int i = 0; i < numberOfWorkers; ++i) {
+    Worker *worker = new Worker(this);
+    if (!worker->start()) {
+      delete worker;
+      break;
+    }
+    this->m_workers.push_back(worker);
+  }
+}
+
+
+void vesSceneStore::vesInternal::stopWorkers()
+{
+  {
+    vesMutexLocker locker(this->m_mutex);
+    this->m_quit = true;
+    this->m_workAvailable.broadcast();
+  }
+
+  for (size_t i = 0; i < this->m_workers.size(); ++i) {
+    delete this->m_workers[i];
+  }
+  this->m_workers.clear();
+
+  vesMutexLocker locker(this->m_mutex);
+  this->m_quit = false;
+}
+
+
+vesSceneStore::vesSceneStore()
+{
+  this->m_internal = new vesInternal();
+}
+
+
+vesSceneStore::~vesSceneStore()
+{
+  delete this->m_internal; this->m_internal = 0x0;
+}
+
+
+void vesSceneStore::setNumberOfThreads(int numberOfThreads)
+{
+  this->m_internal->m_numberOfThreads = std::max(0, numberOfThreads);
+}
+
+
+int vesSceneStore::numberOfThreads() const
+{
+  return this->m_internal->m_numberOfThreads;
+}
+
+
+void vesSceneStore::setChunkSize(int chunkSize)
+{
+  this->m_internal->m_chunkSize = std::max(1, chunkSize);
+}
+
+
+int vesSceneStore::chunkSize() const
+{
+  return this->m_internal->m_chunkSize;
+}
+
+
+void vesSceneStore::setFrustumCulling(bool enable)
+{
+  this->m_internal->m_frustumCulling = enable;
+}
+
+
+bool vesSceneStore::frustumCulling() const
+{
+  return this->m_internal->m_frustumCulling;
+}
+
+
+bool vesSceneStore::cull(vesGroupNode &root,
+                         const vesMatrix4x4f &viewMatrix,
+                         unsigned int viewVersion,
+                         const vesMatrix4x4f &projectionMatrix,
+                         const vesMatrix4x4f &projection2DMatrix,
+                         vesRenderStage &renderStage)
+{
+  vesInternal *internal = this->m_internal;
+
+  if (!internal->m_flattened || internal->m_root != &root ||
+      internal->m_structureVersion != vesGroupNode::structureVersion()) {
+    this->invalidate();
+    internal->m_root = &root;
+    internal->m_structureVersion = vesGroupNode::structureVersion();
+    internal->m_flattened = true;
+    internal->m_valid = internal->flatten(root, -1);
+  }
+
+  internal->m_numberOfCulledActors = 0;
+  if (!internal->m_valid) {
+    return false;
+  }
+
+  internal->refresh(viewMatrix, viewVersion);
+
+  int numberOfActors = static_cast<int>(internal->m_actors.size());
+  int numberOfChunks =
+    (numberOfActors + internal->m_chunkSize - 1) / internal->m_chunkSize;
+  internal->m_chunkLeaves.resize(numberOfChunks);
+  internal->m_chunkCulled.resize(numberOfChunks);
+  internal->m_projectionMatrix = &projectionMatrix;
+  internal->m_projection2DMatrix = &projection2DMatrix;
+
+  internal->cullChunks(internal->resolvedNumberOfThreads());
+
+  for (int i = 0; i < numberOfChunks; ++i) {
+    const vesRenderStage::RenderLeaves &leaves = internal->m_chunkLeaves[i];
+    for (size_t j = 0; j < leaves.size(); ++j) {
+      renderStage.addRenderLeaf(leaves[j]);
+    }
+    internal->m_numberOfCulledActors += internal->m_chunkCulled[i];
+  }
+  vesRenderStatistics::addCullRejects(internal->m_numberOfCulledActors);
+
+  internal->m_projectionMatrix = 0x0;
+  internal->m_projection2DMatrix = 0x0;
+
+  return true;
+}
+
+
+void vesSceneStore::invalidate()
+{
+  vesInternal *internal = this->m_internal;
+
+  internal->m_root = 0x0;
+  internal->m_flattened = false;
+  internal->m_valid = false;
+
+  internal->m_nodes.clear();
+  internal->m_parents.clear();
+  internal->m_transformNodes.clear();
+  internal->m_nodeMatrices.clear();
+  internal->m_nodeVersions.clear();
+  internal->m_nodeVisible.clear();
+
+  internal->m_actorNodes.clear();
+  internal->m_actors.clear();
+  internal->m_modelViewMatrices.clear();
+  internal->m_modelViewVersions.clear();
+  internal->m_normalMatrices.clear();
+  internal->m_boundsMinimum.clear();
+  internal->m_boundsMaximum.clear();
+  internal->m_visible.clear();
+  internal->m_overlay.clear();
+  internal->m_mappers.clear();
+  internal->m_materials.clear();
+}
+
+
+int vesSceneStore::numberOfActors() const
+{
+  return static_cast<int>(this->m_internal->m_actors.size());
+}
+
+
+int vesSceneStore::numberOfCulledActors() const
+{
+  return this->m_internal->m_numberOfCulledActors;
+}
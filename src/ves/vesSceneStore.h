@@ -0,0 +1,111 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+/// \class vesSceneStore
+/// \ingroup ves
+/// \brief Flattened copy of a scene graph that is culled in parallel.
+///
+/// The nodes below a root group node are flattened once into arrays, parents
+/// before children, and every actor gets a slot in a set of per attribute
+/// arrays: model view matrix, normal matrix, mapper bounds, visibility,
+/// overlay flag, mapper and material. Each cull refreshes the slots from the
+/// graph, copying a model view matrix only when its version changed, and
+/// the graph is flattened again only when vesGroupNode::structureVersion()
+/// or the root changed.
+///
+/// Culling then runs over the actor arrays in chunks shared between the
+/// calling thread and a set of worker threads. Invisible actors are skipped,
+/// actors whose mapper bounds are outside of the view frustum are rejected,
+/// and the render leaves of each chunk are appended to the render stage in
+/// chunk order, so the stage receives the leaves in the same order as with
+/// vesCullVisitor.
+///
+/// Subgraphs containing a camera need their own render stage and cannot be
+/// flattened; cull() returns false for them and the caller traverses the
+/// graph instead.
+///
+/// \see vesCullVisitor vesRenderer::setSceneStoreEnabled
+
+#ifndef VESSCENESTORE_H
+#define VESSCENESTORE_H
+
+// VES includes
+#include "vesMath.h"
+#include "vesSetGet.h"
+
+// Forward declarations
+class vesGroupNode;
+class vesRenderStage;
+
+class vesSceneStore
+{
+public:
+  vesTypeMacro(vesSceneStore);
+
+  vesSceneStore();
+  ~vesSceneStore();
+
+  /// Set the number of threads culling, the calling thread included. 0,
+  /// the default, uses one thread per processor.
+  void setNumberOfThreads(int numberOfThreads);
+  int numberOfThreads() const;
+
+  /// Set the number of actors culled as one unit of work. Smaller chunks
+  /// balance better, larger chunks synchronize less. Defaults to 256.
+  void setChunkSize(int chunkSize);
+  int chunkSize() const;
+
+  /// Enable or disable rejecting actors outside of the view frustum.
+  /// Enabled by default. Disable it for mappers whose shaders move vertices
+  /// outside of the mapper bounds.
+  void setFrustumCulling(bool enable);
+  bool frustumCulling() const;
+
+  /// Cull the subgraph below \p root into \p renderStage, flattening it
+  /// first if needed. \p viewMatrix is the model view matrix at the root
+  /// and \p viewVersion its version, see
+  /// vesTransformNode::localToWorldVersion(). Overlay actors use
+  /// \p projection2DMatrix. The leaves point at the projection matrices,
+  /// which must stay valid until the stage is drawn. Return false without
+  /// adding anything if the subgraph cannot be flattened.
+  bool cull(vesGroupNode &root,
+            const vesMatrix4x4f &viewMatrix, unsigned int viewVersion,
+            const vesMatrix4x4f &projectionMatrix,
+            const vesMatrix4x4f &projection2DMatrix,
+            vesRenderStage &renderStage);
+
+  /// Drop the flattened scene, it is rebuilt by the next cull. Needed only
+  /// after changing vesGroupNode::children() directly.
+  void invalidate();
+
+  /// Number of actors in the flattened scene
+  int numberOfActors() const;
+
+  /// Number of actors rejected by the frustum test during the last cull
+  int numberOfCulledActors() const;
+
+private:
+  class vesInternal;
+  vesInternal *m_internal;
+
+  vesSceneStore(const vesSceneStore&);  // Not implemented
+  void operator=(const vesSceneStore&); // Not implemented
+};
+
+#endif // VESSCENESTORE_H
@@ -0,0 +1,198 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+
+#include "vesShaderPermutations.h"
+
+// VES includes
+#include "vesShader.h"
+#include "vesShaderProgram.h"
+#include "vesUniform.h"
+#include "vesVertexAttribute.h"
+
+// C/C++ includes
+#include <cassert>
+#include <map>
+#include <vector>
+
+
+class vesShaderPermutations::vesInternal
+{
+public:
+  struct UniformEntry
+  {
+    vesSharedPtr<vesUniform> m_uniform;
+    unsigned int m_requiredFeatures;
+  };
+
+  struct AttributeEntry
+  {
+    vesSharedPtr<vesVertexAttribute> m_attribute;
+    int m_key;
+    unsigned int m_requiredFeatures;
+  };
+
+  vesInternal(const std::string &vertexSource,
+              const std::string &fragmentSource) :
+    m_vertexSource(vertexSource),
+    m_fragmentSource(fragmentSource),
+    m_definedFeatures(0)
+  {
+  }
+
+  std::string defines(unsigned int features) const;
+  vesSharedPtr<vesShaderProgram> createProgram(unsigned int features) const;
+
+  std::string m_vertexSource;
+  std::string m_fragmentSource;
+
+  unsigned int m_definedFeatures;
+  std::map<unsigned int, std::string> m_featureDefines;
+
+  std::vector<UniformEntry> m_uniforms;
+  std::vector<AttributeEntry> m_attributes;
+
+  std::map<unsigned int, vesSharedPtr<vesShaderProgram> > m_programs;
+};
+
+
+std::string vesShaderPermutations::vesInternal::defines(
+  unsigned int features) const
+{
+  std::string result;
+  std::map<unsigned int, std::string>::const_iterator itr =
+    this->m_featureDefines.begin();
+  for (; itr != this->m_featureDefines.end(); ++itr) {
+    if (features & itr->first) {
+      result += "#define " + itr->second + "\n";
+    }
+  }
+  return result;
+}
+
+
+vesSharedPtr<vesShaderProgram> vesShaderPermutations::vesInternal::createProgram(
+  unsigned int features) const
+{
+  const std::string header = this->defines(features);
+
+  vesSharedPtr<vesShaderProgram> program(new vesShaderProgram());
+  program->addShader(vesSharedPtr<vesShader>(
+    new vesShader(vesShader::Vertex, header + this->m_vertexSource)));
+  program->addShader(vesSharedPtr<vesShader>(
+    new vesShader(vesShader::Fragment, header + this->m_fragmentSource)));
+
+  for (size_t i = 0; i < this->m_uniforms.size(); ++i) {
+    const UniformEntry &entry = this->m_uniforms[i];
+    if ((features & entry.m_requiredFeatures) == entry.m_requiredFeatures) {
+      program->addUniform(entry.m_uniform);
+    }
+  }
+
+  for (size_t i = 0; i < this->m_attributes.size(); ++i) {
+    const AttributeEntry &entry = this->m_attributes[i];
+    if ((features & entry.m_requiredFeatures) == entry.m_requiredFeatures) {
+      program->addVertexAttribute(entry.m_attribute, entry.m_key);
+    }
+  }
+
+  return program;
+}
+
+
+vesShaderPermutations::vesShaderPermutations(const std::string &vertexSource,
+                                             const std::string &fragmentSource)
+{
+  this->m_internal = new vesInternal(vertexSource, fragmentSource);
+}
+
+
+vesShaderPermutations::~vesShaderPermutations()
+{
+  delete this->m_internal;
+}
+
+
+void vesShaderPermutations::setFeatureDefine(unsigned int feature,
+                                             const std::string &symbol)
+{
+  assert(this->m_internal->m_programs.empty());
+
+  this->m_internal->m_featureDefines[feature] = symbol;
+  this->m_internal->m_definedFeatures |= feature;
+}
+
+
+void vesShaderPermutations::addUniform(vesSharedPtr<vesUniform> uniform,
+                                       unsigned int requiredFeatures)
+{
+  vesInternal::UniformEntry entry;
+  entry.m_uniform = uniform;
+  entry.m_requiredFeatures = requiredFeatures;
+  this->m_internal->m_uniforms.push_back(entry);
+
+  // Variants that already exist get it too.
+  std::map<unsigned int, vesSharedPtr<vesShaderProgram> >::iterator itr =
+    this->m_internal->m_programs.begin();
+  for (; itr != this->m_internal->m_programs.end(); ++itr) {
+    if ((itr->first & requiredFeatures) == requiredFeatures) {
+      itr->second->addUniform(uniform);
+    }
+  }
+}
+
+
+void vesShaderPermutations::addVertexAttribute(
+  vesSharedPtr<vesVertexAttribute> attribute, int key,
+  unsigned int requiredFeatures)
+{
+  vesInternal::AttributeEntry entry;
+  entry.m_attribute = attribute;
+  entry.m_key = key;
+  entry.m_requiredFeatures = requiredFeatures;
+  this->m_internal->m_attributes.push_back(entry);
+
+  std::map<unsigned int, vesSharedPtr<vesShaderProgram> >::iterator itr =
+    this->m_internal->m_programs.begin();
+  for (; itr != this->m_internal->m_programs.end(); ++itr) {
+    if ((itr->first & requiredFeatures) == requiredFeatures) {
+      itr->second->addVertexAttribute(attribute, key);
+    }
+  }
+}
+
+
+vesSharedPtr<vesShaderProgram> vesShaderPermutations::program(
+  unsigned int features)
+{
+  features &= this->m_internal->m_definedFeatures;
+
+  vesSharedPtr<vesShaderProgram> &program =
+    this->m_internal->m_programs[features];
+  if (!program) {
+    program = this->m_internal->createProgram(features);
+  }
+  return program;
+}
+
+
+int vesShaderPermutations::numberOfPrograms() const
+{
+  return static_cast<int>(this->m_internal->m_programs.size());
+}
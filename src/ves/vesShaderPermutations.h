@@ -0,0 +1,86 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+/// \class vesShaderPermutations
+/// \ingroup ves
+/// \brief Builds shader program variants of one annotated source on demand.
+///
+/// The vertex and fragment sources are written once, with the optional parts
+/// guarded by preprocessor symbols. Each feature bit is given the symbol it
+/// enables, and program() returns the variant for a mask of those bits. A
+/// variant is created the first time its mask is asked for and is reused
+/// afterwards; like any vesShaderProgram it is only compiled and linked when
+/// it is first bound, so masks that are never drawn cost nothing.
+///
+/// Uniforms and vertex attributes are shared by the variants. Those only
+/// used by some features are added to the variants that have them.
+/// \see vesShaderProgram
+
+#ifndef VESSHADERPERMUTATIONS_H
+#define VESSHADERPERMUTATIONS_H
+
+// VES includes
+#include "vesSetGet.h"
+
+// C/C++ includes
+#include <string>
+
+// Forward declarations
+class vesShaderProgram;
+class vesUniform;
+class vesVertexAttribute;
+
+class vesShaderPermutations
+{
+public:
+  vesTypeMacro(vesShaderPermutations);
+
+  vesShaderPermutations(const std::string &vertexSource,
+                        const std::string &fragmentSource);
+  ~vesShaderPermutations();
+
+  /// Define \p symbol in the variants whose mask has \p feature, a single
+  /// bit. Must be called before the first variant is created.
+  void setFeatureDefine(unsigned int feature, const std::string &symbol);
+
+  /// Add \p uniform to every variant having all of \p requiredFeatures.
+  void addUniform(vesSharedPtr<vesUniform> uniform,
+                  unsigned int requiredFeatures=0);
+
+  /// Add \p attribute, bound to vertex data \p key, to every variant
+  /// having all of \p requiredFeatures.
+  void addVertexAttribute(vesSharedPtr<vesVertexAttribute> attribute, int key,
+                          unsigned int requiredFeatures=0);
+
+  /// Return the variant for \p features. Bits without a define are ignored,
+  /// so masks that only differ by them share a program.
+  vesSharedPtr<vesShaderProgram> program(unsigned int features);
+
+  /// Number of variants created so far.
+  int numberOfPrograms() const;
+
+private:
+  class vesInternal;
+  vesInternal *m_internal;
+
+  vesShaderPermutations(const vesShaderPermutations&); // Not implemented
+  void operator=(const vesShaderPermutations&);        // Not implemented
+};
+
+#endif // VESSHADERPERMUTATIONS_H
@@ -24,6 +24,8 @@
 // VES includes
 #include "vesBooleanUniform.h"
 #include "vesEngineUniform.h"
+#include "vesRenderState.h"
+#include "vesRenderStatistics.h"
 #include "vesShader.h"
 #include "vesUniform.h"
 #include "vesVertexAttribute.h"
@@ -205,6 +207,7 @@ int vesShaderProgram::attributeLocation(const std::string &name) const
 void vesShaderProgram::use()
 {
   glUseProgram(this->m_internal->m_programHandle);
+  vesRenderStatistics::addProgramBind();
 }
 
 
@@ -412,7 +415,9 @@ void vesShaderProgram::bind(const vesRenderState &renderState)
       this->cleanUp();
     }
 
-    this->use();
+    // The new program may have reused the name of the deleted one.
+    renderState.m_glState->invalidateProgram();
+    renderState.m_glState->useProgram(this->m_internal->m_programHandle);
 
     this->bindUniforms();
 
@@ -420,7 +425,7 @@ void vesShaderProgram::bind(const vesRenderState &renderState)
   }
   else
   {
-    this->use();
+    renderState.m_glState->useProgram(this->m_internal->m_programHandle);
   }
 
   // Call update callback.
@@ -147,6 +147,16 @@ public:
   virtual unsigned int sizeOfArray() const = 0;
   virtual unsigned int sizeInBytes() const = 0;
 
+  /// Size in bytes of one array element, all of its attributes included.
+  virtual unsigned int sizeOfElement() const = 0;
+
+  /// Set the number of array elements. Added elements are default
+  /// constructed.
+  virtual void resize(unsigned int count) = 0;
+
+  /// Free the array memory, keeping the attribute layout.
+  virtual void clear() = 0;
+
   virtual bool hasKey(int key) const = 0;
   virtual std::vector<int> keys() const = 0;
 
@@ -220,6 +230,21 @@ public:
     return sizeInByes;
   }
 
+  virtual unsigned int sizeOfElement() const
+  {
+    return sizeof(T);
+  }
+
+  virtual void resize(unsigned int count)
+  {
+    this->m_data.resize(count);
+  }
+
+  virtual void clear()
+  {
+    std::vector<T>().swap(this->m_data);
+  }
+
   virtual bool hasKey(int key) const
   {
     bool success = true;
@@ -24,6 +24,7 @@
 // VES includes
 #include "vesGL.h"
 #include "vesRenderState.h"
+#include "vesRenderStatistics.h"
 #include "vesShaderProgram.h"
 #include "vesUniform.h"
 
@@ -55,18 +56,14 @@ vesTexture::~vesTexture()
 
 void vesTexture::bind(const vesRenderState &renderState)
 {
-  vesNotUsed(renderState);
-
-  glActiveTexture(GL_TEXTURE0 + this->m_textureUnit);
-  glBindTexture(GL_TEXTURE_2D, this->m_textureHandle);
+  renderState.m_glState->bindTexture(this->m_textureUnit,
+                                     this->m_textureHandle);
 }
 
 
 void vesTexture::unbind(const vesRenderState &renderState)
 {
-  vesNotUsed(renderState);
-
-  glBindTexture(GL_TEXTURE_2D, 0);
+  renderState.m_glState->bindTexture(this->m_textureUnit, 0);
 }
 
 
@@ -230,12 +227,14 @@ vesColorDataType::PixelDataType vesTexture::pixelDataType() const
 
 void vesTexture::setup(const vesRenderState &renderState)
 {
-  vesNotUsed(renderState);
-
   if (this->dirtyState()) {
     glDeleteTextures(1, &this->m_textureHandle);
     glGenTextures(1, &this->m_textureHandle);
-    glBindTexture(GL_TEXTURE_2D, this->m_textureHandle);
+
+    // Deleting unbinds the texture and the new one may reuse its name.
+    renderState.m_glState->invalidateTextures();
+    renderState.m_glState->bindTexture(this->m_textureUnit,
+                                       this->m_textureHandle);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
@@ -249,6 +248,7 @@ void vesTexture::setup(const vesRenderState &renderState)
       glTexImage2D(GL_TEXTURE_2D, 0, this->m_internalFormat, this->m_width, this->m_height, 0,
                    this->m_pixelFormat ? this->m_pixelFormat : this->m_internalFormat,
                    this->m_pixelDataType ? this->m_pixelDataType : GL_UNSIGNED_BYTE, this->m_image->data());
+      vesRenderStatistics::addBytesUploaded(this->m_image->dataSize());
     }
     else {
       glTexImage2D(GL_TEXTURE_2D, 0, this->m_internalFormat, this->m_width, this->m_height, 0,
@@ -0,0 +1,83 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+
+#include "vesThread.h"
+
+// C/C++ includes
+#include <cassert>
+#include <unistd.h>
+
+vesThread::vesThread() :
+  m_started(false)
+{
+}
+
+
+vesThread::~vesThread()
+{
+  // Subclasses are expected to have joined already, see class documentation.
+  assert(!this->m_started);
+  this->join();
+}
+
+
+bool vesThread::start()
+{
+  if (this->m_started) {
+    return false;
+  }
+
+#ifdef VES_NO_THREADS
+  return false;
+#else
+  this->m_started =
+    pthread_create(&this->m_thread, 0, &vesThread::threadMain, this) == 0;
+  return this->m_started;
+#endif
+}
+
+
+void vesThread::join()
+{
+#ifndef VES_NO_THREADS
+  if (this->m_started) {
+    pthread_join(this->m_thread, 0);
+    this->m_started = false;
+  }
+#endif
+}
+
+
+int vesThread::numberOfProcessors()
+{
+#ifdef VES_NO_THREADS
+  return 1;
+#else
+  long count = sysconf(_SC_NPROCESSORS_ONLN);
+  return count > 0 ? static_cast<int>(count) : 1;
+#endif
+}
+
+
+void* vesThread::threadMain(void *thread)
+{
+  static_cast<vesThread*>(thread)->run();
+  return 0;
+}
@@ -0,0 +1,68 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+/// \class vesThread
+/// \ingroup ves
+/// \brief Base class for work running on its own thread.
+///
+/// Subclasses implement run(), which is executed on a new thread by start().
+/// A subclass must join() in its destructor at the latest, since run() must
+/// not outlive the object it belongs to.
+/// \see vesMutex vesConditionVariable
+
+#ifndef VESTHREAD_H
+#define VESTHREAD_H
+
+// C/C++ includes
+#include <pthread.h>
+
+class vesThread
+{
+public:
+  vesThread();
+  virtual ~vesThread();
+
+  /// Start executing run() on a new thread. Return false if the thread could
+  /// not be created or is already started, and always when VES is built
+  /// without VES_USE_THREADS.
+  bool start();
+
+  /// Wait for run() to return. Does nothing if the thread is not started.
+  void join();
+
+  bool isStarted() const { return this->m_started; }
+
+  /// Number of processors available to run threads, at least one. One
+  /// when VES is built without VES_USE_THREADS.
+  static int numberOfProcessors();
+
+protected:
+  virtual void run() = 0;
+
+private:
+  static void* threadMain(void *thread);
+
+  pthread_t m_thread;
+  bool m_started;
+
+  vesThread(const vesThread&);     // Not implemented
+  void operator=(const vesThread&); // Not implemented
+};
+
+#endif // VESTHREAD_H
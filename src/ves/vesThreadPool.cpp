@@ -0,0 +1,311 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+
+#include "vesThreadPool.h"
+
+// VES includes
+#include "vesConditionVariable.h"
+#include "vesMutex.h"
+#include "vesThread.h"
+
+// C/C++ includes
+#include <algorithm>
+#include <vector>
+
+namespace {
+
+// Run of chunks dealt to one thread. The owner takes chunks from the front,
+// thieves from the back.
+struct vesChunkQueue
+{
+  vesChunkQueue() : m_begin(0), m_end(0)
+  {
+  }
+
+  bool takeFront(size_t &chunk)
+  {
+    vesMutexLocker locker(this->m_mutex);
+    if (this->m_begin == this->m_end) {
+      return false;
+    }
+    chunk = this->m_begin++;
+    return true;
+  }
+
+  bool takeBack(size_t &chunk)
+  {
+    vesMutexLocker locker(this->m_mutex);
+    if (this->m_begin == this->m_end) {
+      return false;
+    }
+    chunk = --this->m_end;
+    return true;
+  }
+
+  void reset(size_t begin, size_t end)
+  {
+    vesMutexLocker locker(this->m_mutex);
+    this->m_begin = begin;
+    this->m_end = end;
+  }
+
+  vesMutex m_mutex;
+  size_t m_begin;
+  size_t m_end;
+};
+
+} // end namespace
+
+
+class vesThreadPool::vesInternal
+{
+public:
+  class Worker : public vesThread
+  {
+  public:
+    Worker(vesInternal *internal, int index) : m_internal(internal), m_index(index)
+    {
+    }
+
+    ~Worker()
+    {
+      this->join();
+    }
+
+  protected:
+    virtual void run()
+    {
+      this->m_internal->workerLoop(this->m_index);
+    }
+
+    vesInternal *m_internal;
+    int m_index;
+  };
+
+  vesInternal() :
+    m_queues(0x0),
+    m_numberOfQueues(0),
+    m_task(0x0),
+    m_count(0),
+    m_grainSize(1),
+    m_numberOfChunks(0),
+    m_loopQueues(0),
+    m_chunksDone(0),
+    m_activeWorkers(0),
+    m_generation(0),
+    m_quit(false)
+  {
+  }
+
+  void workerLoop(int queue);
+  void runChunks(int queue, vesThreadPool::Task *task);
+
+  std::vector<Worker*> m_workers;
+  vesChunkQueue *m_queues;
+  int m_numberOfQueues;
+
+  // Held by the thread running a loop.
+  vesMutex m_loopMutex;
+
+  // Current loop, guarded by m_mutex. Only the first m_loopQueues threads
+  // take part in it.
+  vesMutex m_mutex;
+  vesConditionVariable m_workAvailable;
+  vesConditionVariable m_finished;
+  vesThreadPool::Task *m_task;
+  size_t m_count;
+  size_t m_grainSize;
+  size_t m_numberOfChunks;
+  int m_loopQueues;
+  size_t m_chunksDone;
+  int m_activeWorkers;
+  unsigned int m_generation;
+  bool m_quit;
+};
+
+
+void vesThreadPool::vesInternal::workerLoop(int queue)
+{
+  unsigned int generation = 0;
+
+  this->m_mutex.lock();
+  for (;;) {
+    while (!this->m_quit && this->m_generation == generation) {
+      this->m_workAvailable.wait(this->m_mutex);
+    }
+    if (this->m_quit) {
+      break;
+    }
+    generation = this->m_generation;
+    if (queue >= this->m_loopQueues) {
+      continue;
+    }
+    vesThreadPool::Task *task = this->m_task;
+    ++this->m_activeWorkers;
+    this->m_mutex.unlock();
+
+    this->runChunks(queue, task);
+
+    this->m_mutex.lock();
+    if (--this->m_activeWorkers == 0) {
+      this->m_finished.broadcast();
+    }
+  }
+  this->m_mutex.unlock();
+}
+
+
+void vesThreadPool::vesInternal::runChunks(int queue, vesThreadPool::Task *task)
+{
+  const int numberOfQueues = this->m_loopQueues;
+  size_t chunk;
+  for (;;) {
+    bool found = this->m_queues[queue].takeFront(chunk);
+    for (int i = 1; !found && i < numberOfQueues; ++i) {
+      found = this->m_queues[(queue + i) % numberOfQueues].takeBack(chunk);
+    }
+    if (!found) {
+      return;
+    }
+
+    const size_t begin = chunk * this->m_grainSize;
+    task->execute(begin, std::min(begin + this->m_grainSize, this->m_count));
+
+    if (__sync_add_and_fetch(&this->m_chunksDone, 1) == this->m_numberOfChunks) {
+      vesMutexLocker locker(this->m_mutex);
+      this->m_finished.broadcast();
+    }
+  }
+}
+
+
+vesThreadPool::vesThreadPool(int numberOfThreads)
+{
+  this->m_internal = new vesInternal();
+
+  if (numberOfThreads <= 0) {
+    numberOfThreads = vesThread::numberOfProcessors();
+  }
+
+  for (int i = 1; i < numberOfThreads; ++i) {
+    vesInternal::Worker *worker = new vesInternal::Worker(this->m_internal, i);
+    if (!worker->start()) {
+      delete worker;
+      break;
+    }
+    this->m_internal->m_workers.push_back(worker);
+  }
+
+  this->m_internal->m_numberOfQueues =
+    static_cast<int>(this->m_internal->m_workers.size()) + 1;
+  this->m_internal->m_queues = new vesChunkQueue[this->m_internal->m_numberOfQueues];
+}
+
+
+vesThreadPool::~vesThreadPool()
+{
+  {
+    vesMutexLocker locker(this->m_internal->m_mutex);
+    this->m_internal->m_quit = true;
+    this->m_internal->m_workAvailable.broadcast();
+  }
+
+  for (size_t i = 0; i < this->m_internal->m_workers.size(); ++i) {
+    delete this->m_internal->m_workers[i];
+  }
+
+  delete [] this->m_internal->m_queues;
+  delete this->m_internal;
+}
+
+
+int vesThreadPool::numberOfThreads() const
+{
+  return this->m_internal->m_numberOfQueues;
+}
+
+
+void vesThreadPool::parallelFor(size_t count, size_t grainSize, Task &task,
+                                int maximumNumberOfThreads)
+{
+  grainSize = std::max(grainSize, size_t(1));
+  const size_t numberOfChunks = (count + grainSize - 1) / grainSize;
+
+  vesInternal *internal = this->m_internal;
+  int numberOfQueues = internal->m_numberOfQueues;
+  if (maximumNumberOfThreads > 0) {
+    numberOfQueues = std::min(numberOfQueues, maximumNumberOfThreads);
+  }
+  numberOfQueues = static_cast<int>(
+    std::min(static_cast<size_t>(numberOfQueues), numberOfChunks));
+
+  if (numberOfQueues < 2 || !internal->m_loopMutex.tryLock()) {
+    if (count) {
+      task.execute(0, count);
+    }
+    return;
+  }
+
+  {
+    vesMutexLocker locker(internal->m_mutex);
+
+    // Workers that woke up too late for the last loop must be gone before
+    // the queues are dealt out again.
+    while (internal->m_activeWorkers > 0) {
+      internal->m_finished.wait(internal->m_mutex);
+    }
+
+    for (int i = 0; i < numberOfQueues; ++i) {
+      internal->m_queues[i].reset(numberOfChunks * i / numberOfQueues,
+                                  numberOfChunks * (i + 1) / numberOfQueues);
+    }
+
+    internal->m_task = &task;
+    internal->m_count = count;
+    internal->m_grainSize = grainSize;
+    internal->m_numberOfChunks = numberOfChunks;
+    internal->m_loopQueues = numberOfQueues;
+    internal->m_chunksDone = 0;
+    ++internal->m_generation;
+    internal->m_workAvailable.broadcast();
+  }
+
+  // The calling thread works through the first queue.
+  internal->runChunks(0, &task);
+
+  {
+    vesMutexLocker locker(internal->m_mutex);
+    // m_chunksDone is only ever updated atomically.
+    while (__sync_add_and_fetch(&internal->m_chunksDone, 0) < internal->m_numberOfChunks ||
+           internal->m_activeWorkers > 0) {
+      internal->m_finished.wait(internal->m_mutex);
+    }
+    internal->m_task = 0x0;
+  }
+
+  internal->m_loopMutex.unlock();
+}
+
+
+vesThreadPool* vesThreadPool::instance()
+{
+  static vesThreadPool pool;
+  return &pool;
+}
@@ -0,0 +1,104 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+/// \class vesThreadPool
+/// \ingroup ves
+/// \brief Work stealing thread pool for data parallel loops.
+///
+/// parallelFor() cuts an index range into chunks and deals them out to the
+/// calling thread and the workers, one contiguous run of chunks each. A
+/// thread that runs out of chunks steals from the far end of another
+/// thread's run, so uneven chunks still keep every core busy. The workers
+/// are started once and sleep between loops.
+///
+/// Chunks are executed in no particular order and on any thread. Loops that
+/// write each output element from the chunk owning its index produce the
+/// same result on any number of threads.
+///
+/// One loop runs at a time. A parallelFor() issued while the pool is busy,
+/// from another thread or from inside a chunk, runs on its calling thread.
+
+#ifndef VESTHREADPOOL_H
+#define VESTHREADPOOL_H
+
+// VES includes
+#include "vesSetGet.h"
+
+// C/C++ includes
+#include <cstddef>
+
+class vesThreadPool
+{
+public:
+  vesTypeMacro(vesThreadPool);
+
+  /// Body of a parallelFor() loop.
+  class Task
+  {
+  public:
+    virtual ~Task() {}
+
+    /// Process the indices [begin, end).
+    virtual void execute(size_t begin, size_t end) = 0;
+  };
+
+  /// Start \p numberOfThreads - 1 workers, the calling thread of
+  /// parallelFor() being the last one. Defaults to the number of processors.
+  explicit vesThreadPool(int numberOfThreads=0);
+  ~vesThreadPool();
+
+  int numberOfThreads() const;
+
+  /// Run \p task over [0, count) in chunks of \p grainSize indices and
+  /// return when all of them are done. At most \p maximumNumberOfThreads
+  /// threads, the calling one included, take part; 0 lets all of them.
+  void parallelFor(size_t count, size_t grainSize, Task &task,
+                   int maximumNumberOfThreads=0);
+
+  /// Same as above for any object with an execute(size_t, size_t) method.
+  template <class Functor>
+  void parallelFor(size_t count, size_t grainSize, Functor &functor,
+                   int maximumNumberOfThreads=0)
+  {
+    vesFunctorTask<Functor> task(functor);
+    this->parallelFor(count, grainSize, static_cast<Task&>(task),
+                      maximumNumberOfThreads);
+  }
+
+  /// Pool shared by the data parallel loops of ves and kiwi.
+  static vesThreadPool* instance();
+
+private:
+  template <class Functor>
+  class vesFunctorTask : public Task
+  {
+  public:
+    explicit vesFunctorTask(Functor &functor) : m_body(functor) {}
+    virtual void execute(size_t begin, size_t end) { this->m_body.execute(begin, end); }
+    Functor &m_body;
+  };
+
+  class vesInternal;
+  vesInternal *m_internal;
+
+  vesThreadPool(const vesThreadPool&);  // Not implemented
+  void operator=(const vesThreadPool&); // Not implemented
+};
+
+#endif // VESTHREADPOOL_H
@@ -23,12 +23,47 @@
 // VES includes
 #include "vesVisitor.h"
 
+namespace {
+
+// Version 0 stands for unknown, and 1 for the identity at the root.
+unsigned int nextMatrixVersion()
+{
+  static unsigned int version = 1;
+  if (++version < 2) {
+    version = 2;
+  }
+  return version;
+}
+
+} // end namespace
+
+
 class vesTransformNode::vesInternal
 {
 private:
   vesMatrix4x4f T,C,R,SR,S,SRinv,Cinv;
 
 public:
+  vesInternal() :
+    m_matrixDirty(true),
+    m_localToWorldDirty(true),
+    m_normalMatrixDirty(true),
+    m_parentVersion(0),
+    m_version(nextMatrixVersion())
+  {
+    this->m_matrix.setIdentity();
+    this->m_localToWorldMatrix.setIdentity();
+  }
+
+  vesMatrix4x4f m_matrix;
+  vesMatrix4x4f m_localToWorldMatrix;
+  vesMatrix3x3f m_normalMatrix;
+  bool m_matrixDirty;
+  bool m_localToWorldDirty;
+  bool m_normalMatrixDirty;
+  unsigned int m_parentVersion;
+  unsigned int m_version;
+
   vesMatrix4x4f Eval()
   {
     return T * C * R * SR * S * SRinv * Cinv;
@@ -83,14 +118,19 @@ vesTransformNode::~vesTransformNode()
 
 vesMatrix4x4f vesTransformNode::matrix()
 {
-  this->setInternals();
-  return m_internal->Eval();
+  if (this->m_internal->m_matrixDirty) {
+    this->setInternals();
+    this->m_internal->m_matrix = this->m_internal->Eval();
+    this->m_internal->m_matrixDirty = false;
+  }
+  return this->m_internal->m_matrix;
 }
 
 
 void vesTransformNode::setCenter(const vesVector3f &center)
 {
   this->m_center = center;
+  this->setMatrixDirty();
   this->setBoundsDirty(true);
 }
 
@@ -104,6 +144,7 @@ const vesVector3f& vesTransformNode::center() const
 void vesTransformNode::setRotation(const vesVector4f &rotation)
 {
   this->m_rotation = rotation;
+  this->setMatrixDirty();
   this->setBoundsDirty(true);
 }
 
@@ -117,6 +158,7 @@ const vesVector4f& vesTransformNode::rotation() const
 void vesTransformNode::setScale(const vesVector3f &scale)
 {
   this->m_scale = scale;
+  this->setMatrixDirty();
   this->setBoundsDirty(true);
 }
 
@@ -130,6 +172,7 @@ const vesVector3f& vesTransformNode::scale() const
 void vesTransformNode::setScaleOrientation(const vesVector4f &scaleOrientation)
 {
   this->m_scaleOrientation = scaleOrientation;
+  this->setMatrixDirty();
   this->setBoundsDirty(true);
 }
 
@@ -143,6 +186,7 @@ const vesVector4f& vesTransformNode::scaleOrientation() const
 void vesTransformNode::setTranslation(const vesVector3f &translation)
 {
   this->m_translation = translation;
+  this->setMatrixDirty();
   this->setBoundsDirty(true);
 }
 
@@ -160,6 +204,7 @@ bool vesTransformNode::setReferenceFrame(ReferenceFrame referenceFrame)
   if (this->m_referenceFrame != referenceFrame) {
     this->setBoundsDirty(true);
     this->m_referenceFrame = referenceFrame;
+    this->setMatrixDirty();
     return success;
   }
 
@@ -229,6 +274,67 @@ bool vesTransformNode::computeWorldToLocalMatrix(vesMatrix4x4f &matrix,
 }
 
 
+const vesMatrix4x4f& vesTransformNode::localToWorldMatrix(
+  const vesMatrix4x4f &parentMatrix, unsigned int parentVersion,
+  vesVisitor &visitor)
+{
+  const bool parentChanged = this->m_referenceFrame != Absolute &&
+    (parentVersion == 0 || parentVersion != this->m_internal->m_parentVersion);
+
+  if (!parentChanged && !this->isMatrixDirty()) {
+    return this->m_internal->m_localToWorldMatrix;
+  }
+
+  vesMatrix4x4f matrix = parentMatrix;
+  this->computeLocalToWorldMatrix(matrix, visitor);
+
+  // Keep the version when the value did not change, so that the cached
+  // matrices of the children remain valid.
+  if (matrix != this->m_internal->m_localToWorldMatrix) {
+    this->m_internal->m_localToWorldMatrix = matrix;
+    this->m_internal->m_version = nextMatrixVersion();
+    this->m_internal->m_normalMatrixDirty = true;
+  }
+
+  this->m_internal->m_parentVersion = parentVersion;
+  this->m_internal->m_localToWorldDirty = false;
+
+  return this->m_internal->m_localToWorldMatrix;
+}
+
+
+unsigned int vesTransformNode::localToWorldVersion() const
+{
+  return this->m_internal->m_version;
+}
+
+
+const vesMatrix3x3f& vesTransformNode::normalMatrix()
+{
+  if (this->m_internal->m_normalMatrixDirty) {
+    this->m_internal->m_normalMatrix =
+      makeNormalMatrix3x3f(makeTransposeMatrix4x4(makeInverseMatrix4x4(
+        this->m_internal->m_localToWorldMatrix)));
+    this->m_internal->m_normalMatrixDirty = false;
+  }
+  return this->m_internal->m_normalMatrix;
+}
+
+
+void vesTransformNode::setMatrixDirty()
+{
+  this->m_internal->m_matrixDirty = true;
+  this->m_internal->m_localToWorldDirty = true;
+  vesObject::modified();
+}
+
+
+bool vesTransformNode::isMatrixDirty() const
+{
+  return this->m_internal->m_localToWorldDirty;
+}
+
+
 void vesTransformNode::updateBounds(vesNode &child)
 {
   if (!this->boundsDirty()) {
@@ -23,6 +23,10 @@
 ///
 /// vesTransformNode is a group node that provides interface for affine
 /// transformations.
+///
+/// The local matrix and the local to world matrix are cached. The setters
+/// only mark them dirty, and the local to world matrix is recomputed by
+/// localToWorldMatrix() only when this node or the parent matrix changed.
 /// \see vesNode vesGroupNode
 
 #ifndef __VESTRANSFORMNODE_H
@@ -106,7 +110,30 @@ public:
   virtual bool computeWorldToLocalMatrix(vesMatrix4x4f& matrix,
                                          vesVisitor& visitor);
 
+  /// Return the local to world matrix for a parent matrix whose version is
+  /// \p parentVersion, see localToWorldVersion(). The cached matrix is
+  /// returned unless this node or the parent matrix changed since the last
+  /// call. A parent version of 0 means unknown and always recomputes.
+  const vesMatrix4x4f& localToWorldMatrix(const vesMatrix4x4f &parentMatrix,
+                                          unsigned int parentVersion,
+                                          vesVisitor &visitor);
+
+  /// Return the version of the cached local to world matrix. It changes
+  /// only when the value of the matrix changes.
+  unsigned int localToWorldVersion() const;
+
+  /// Return the normal matrix of the cached local to world matrix,
+  /// computed at most once per change.
+  const vesMatrix3x3f& normalMatrix();
+
 protected:
+  /// Mark the cached matrices as outdated.
+  void setMatrixDirty();
+
+  /// Return true if the local matrix may have changed since the local to
+  /// world matrix was cached.
+  virtual bool isMatrixDirty() const;
+
   void updateBounds(vesNode &child);
 
   void setInternals();
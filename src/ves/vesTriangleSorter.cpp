@@ -0,0 +1,377 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+
+#include "vesTriangleSorter.h"
+
+// VES includes
+#include "vesConditionVariable.h"
+#include "vesGeometryData.h"
+#include "vesGLTypes.h"
+#include "vesMutex.h"
+#include "vesPrimitive.h"
+#include "vesThread.h"
+#include "vesVertexAttributeKeys.h"
+
+// C/C++ includes
+#include <algorithm>
+
+namespace {
+
+struct vesDepthLess
+{
+  explicit vesDepthLess(const std::vector<float> &depths) : m_depths(depths)
+  {
+  }
+
+  bool operator()(unsigned int a, unsigned int b) const
+  {
+    return this->m_depths[a] < this->m_depths[b];
+  }
+
+  const std::vector<float> &m_depths;
+};
+
+} // end namespace
+
+
+class vesTriangleSorter::vesInternal
+{
+public:
+  class Worker : public vesThread
+  {
+  public:
+    explicit Worker(vesInternal *internal) : m_internal(internal)
+    {
+    }
+
+    ~Worker()
+    {
+      this->join();
+    }
+
+  protected:
+    virtual void run()
+    {
+      this->m_internal->workerLoop();
+    }
+
+    vesInternal *m_internal;
+  };
+
+  vesInternal() :
+    m_uploadThreshold(0.05f),
+    m_hasRequest(false),
+    m_hasResult(false),
+    m_quit(false),
+    m_worker(0x0)
+  {
+  }
+
+  ~vesInternal()
+  {
+    this->stopWorker();
+  }
+
+  void stopWorker()
+  {
+    if (!this->m_worker) {
+      return;
+    }
+
+    this->m_mutex.lock();
+    this->m_quit = true;
+    this->m_condition.signal();
+    this->m_mutex.unlock();
+
+    delete this->m_worker; this->m_worker = 0x0;
+    this->m_quit = false;
+    this->m_hasRequest = false;
+  }
+
+  void workerLoop();
+  void sort(const vesVector4f &depthRow);
+  size_t numberOfChangedTriangles() const;
+
+  // Owned by the worker while it runs.
+  std::vector<float> m_centroids;
+  std::vector<unsigned short> m_triangleIndices;
+  std::vector<unsigned int> m_order;
+  std::vector<unsigned int> m_publishedOrder;
+  std::vector<float> m_depths;
+  std::vector<unsigned short> m_output;
+
+  float m_uploadThreshold;
+  vesVector4f m_lastRequestedRow;
+
+  // Shared with the worker, guarded by m_mutex.
+  vesMutex m_mutex;
+  vesConditionVariable m_condition;
+  vesVector4f m_requestedRow;
+  bool m_hasRequest;
+  std::vector<unsigned short> m_result;
+  bool m_hasResult;
+  bool m_quit;
+
+  Worker *m_worker;
+};
+
+
+void vesTriangleSorter::vesInternal::workerLoop()
+{
+  for (;;) {
+    vesVector4f depthRow;
+    float threshold;
+    {
+      vesMutexLocker locker(this->m_mutex);
+      while (!this->m_hasRequest && !this->m_quit) {
+        this->m_condition.wait(this->m_mutex);
+      }
+      if (this->m_quit) {
+        return;
+      }
+      depthRow = this->m_requestedRow;
+      threshold = this->m_uploadThreshold;
+      this->m_hasRequest = false;
+    }
+
+    this->sort(depthRow);
+
+    size_t changed = this->numberOfChangedTriangles();
+    if (changed == 0 || changed < threshold * this->m_order.size()) {
+      continue;
+    }
+
+    // Buffers only change hands from here on, a resize allocates just
+    // when the caller handed back a smaller one.
+    std::vector<unsigned short> &indices = this->m_output;
+    indices.resize(this->m_triangleIndices.size());
+    for (size_t i = 0; i < this->m_order.size(); ++i) {
+      const unsigned short *triangle =
+        &this->m_triangleIndices[3 * this->m_order[i]];
+      indices[3 * i] = triangle[0];
+      indices[3 * i + 1] = triangle[1];
+      indices[3 * i + 2] = triangle[2];
+    }
+    std::copy(this->m_order.begin(), this->m_order.end(),
+              this->m_publishedOrder.begin());
+
+    // The renderer asks hasSortedIndices() to get it drawn.
+    vesMutexLocker locker(this->m_mutex);
+    this->m_result.swap(indices);
+    this->m_hasResult = true;
+  }
+}
+
+
+void vesTriangleSorter::vesInternal::sort(const vesVector4f &depthRow)
+{
+  const size_t numberOfTriangles = this->m_order.size();
+  for (size_t i = 0; i < numberOfTriangles; ++i) {
+    const float *centroid = &this->m_centroids[3 * i];
+    this->m_depths[i] = depthRow[0] * centroid[0] + depthRow[1] * centroid[1]
+      + depthRow[2] * centroid[2] + depthRow[3];
+  }
+
+  // Farthest first, the camera looks down -z. Insertion sort starting from
+  // the previous order is cheap as long as the view changed little; give
+  // up on it once it has moved more than a few times the triangle count.
+  const std::vector<float> &depths = this->m_depths;
+  std::vector<unsigned int> &order = this->m_order;
+  const size_t budget = 4 * numberOfTriangles;
+  size_t moves = 0;
+  for (size_t i = 1; i < numberOfTriangles; ++i) {
+    const unsigned int triangle = order[i];
+    const float depth = depths[triangle];
+    size_t j = i;
+    while (j > 0 && depths[order[j - 1]] > depth && moves <= budget) {
+      order[j] = order[j - 1];
+      --j;
+      ++moves;
+    }
+    order[j] = triangle;
+
+    if (moves > budget) {
+      std::sort(order.begin(), order.end(), vesDepthLess(depths));
+      break;
+    }
+  }
+}
+
+
+size_t vesTriangleSorter::vesInternal::numberOfChangedTriangles() const
+{
+  size_t changed = 0;
+  for (size_t i = 0; i < this->m_order.size(); ++i) {
+    if (this->m_order[i] != this->m_publishedOrder[i]) {
+      ++changed;
+    }
+  }
+  return changed;
+}
+
+
+vesTriangleSorter::vesTriangleSorter() :
+  m_internal(new vesInternal())
+{
+}
+
+
+vesTriangleSorter::~vesTriangleSorter()
+{
+  delete this->m_internal; this->m_internal = 0x0;
+}
+
+
+bool vesTriangleSorter::setTriangles(
+  const vesSharedPtr<vesGeometryData> &geometryData,
+  const vesSharedPtr<vesPrimitive> &triangles)
+{
+  this->m_internal->stopWorker();
+
+  vesInternal &internal = *this->m_internal;
+  internal.m_centroids.clear();
+  internal.m_triangleIndices.clear();
+  internal.m_order.clear();
+  internal.m_publishedOrder.clear();
+  internal.m_depths.clear();
+  internal.m_result.clear();
+  internal.m_hasResult = false;
+
+  if (!geometryData || !triangles ||
+      triangles->primitiveType() != vesPrimitiveRenderType::Triangles) {
+    return false;
+  }
+
+  vesSharedPtr<vesSourceData> positions =
+    geometryData->sourceData(vesVertexAttributeKeys::Position);
+  if (!positions ||
+      positions->attributeDataType(vesVertexAttributeKeys::Position)
+        != vesDataType::Float ||
+      positions->numberOfComponents(vesVertexAttributeKeys::Position) < 3) {
+    return false;
+  }
+
+  const int key = vesVertexAttributeKeys::Position;
+  const unsigned char *data =
+    static_cast<const unsigned char*>(positions->data());
+  const size_t stride = positions->attributeStride(key) > 0
+    ? positions->attributeStride(key)
+    : positions->numberOfComponents(key) * sizeof(float);
+  const size_t offset = positions->attributeOffset(key);
+  const size_t numberOfVertices = positions->sizeOfArray();
+
+  const size_t numberOfTriangles = triangles->numberOfIndices() / 3;
+  internal.m_triangleIndices.assign(triangles->data(),
+    triangles->data() + 3 * numberOfTriangles);
+  internal.m_centroids.resize(3 * numberOfTriangles);
+  for (size_t i = 0; i < numberOfTriangles; ++i) {
+    float *centroid = &internal.m_centroids[3 * i];
+    centroid[0] = centroid[1] = centroid[2] = 0.0f;
+    for (int k = 0; k < 3; ++k) {
+      const size_t vertex = internal.m_triangleIndices[3 * i + k];
+      if (vertex >= numberOfVertices) {
+        internal.m_centroids.clear();
+        internal.m_triangleIndices.clear();
+        return false;
+      }
+      const float *position =
+        reinterpret_cast<const float*>(data + vertex * stride + offset);
+      centroid[0] += position[0] / 3.0f;
+      centroid[1] += position[1] / 3.0f;
+      centroid[2] += position[2] / 3.0f;
+    }
+  }
+
+  internal.m_order.resize(numberOfTriangles);
+  for (size_t i = 0; i < numberOfTriangles; ++i) {
+    internal.m_order[i] = static_cast<unsigned int>(i);
+  }
+  internal.m_publishedOrder = internal.m_order;
+  internal.m_depths.resize(numberOfTriangles);
+  internal.m_output.resize(3 * numberOfTriangles);
+  internal.m_result.resize(3 * numberOfTriangles);
+  internal.m_lastRequestedRow = vesVector4f::Zero();
+
+  return numberOfTriangles > 0;
+}
+
+
+void vesTriangleSorter::setUploadThreshold(float fraction)
+{
+  vesMutexLocker locker(this->m_internal->m_mutex);
+  this->m_internal->m_uploadThreshold = std::max(0.0f, std::min(fraction, 1.0f));
+}
+
+
+float vesTriangleSorter::uploadThreshold() const
+{
+  vesMutexLocker locker(this->m_internal->m_mutex);
+  return this->m_internal->m_uploadThreshold;
+}
+
+
+void vesTriangleSorter::requestSort(const vesMatrix4x4f &modelViewMatrix)
+{
+  vesInternal &internal = *this->m_internal;
+  if (internal.m_order.size() < 2) {
+    return;
+  }
+
+  // Only the view depth of the centroids matters.
+  vesVector4f depthRow(modelViewMatrix(2, 0), modelViewMatrix(2, 1),
+                       modelViewMatrix(2, 2), modelViewMatrix(2, 3));
+  if (depthRow == internal.m_lastRequestedRow) {
+    return;
+  }
+  internal.m_lastRequestedRow = depthRow;
+
+  if (!internal.m_worker) {
+    internal.m_worker = new vesInternal::Worker(&internal);
+    if (!internal.m_worker->start()) {
+      delete internal.m_worker; internal.m_worker = 0x0;
+      return;
+    }
+  }
+
+  vesMutexLocker locker(internal.m_mutex);
+  internal.m_requestedRow = depthRow;
+  internal.m_hasRequest = true;
+  internal.m_condition.signal();
+}
+
+
+bool vesTriangleSorter::hasSortedIndices() const
+{
+  vesMutexLocker locker(this->m_internal->m_mutex);
+  return this->m_internal->m_hasResult;
+}
+
+
+bool vesTriangleSorter::takeSortedIndices(std::vector<unsigned short> &indices)
+{
+  vesMutexLocker locker(this->m_internal->m_mutex);
+  if (!this->m_internal->m_hasResult) {
+    return false;
+  }
+
+  indices.swap(this->m_internal->m_result);
+  this->m_internal->m_hasResult = false;
+  return true;
+}
@@ -0,0 +1,91 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+/// \class vesTriangleSorter
+/// \ingroup ves
+/// \brief Orders the triangles of a translucent primitive back to front on a
+/// worker thread.
+///
+/// The sorter keeps the triangle centroids of the primitive and, for every
+/// requested view, re-sorts the order found for the previous one. Between
+/// frames most triangles keep their place, so the insertion sort used for
+/// that runs in near linear time; large view changes fall back to a full
+/// sort. A new index array is only published once the order differs from
+/// the last published one by more than the upload threshold, which keeps
+/// index buffer uploads rare while the camera moves slowly.
+/// \see vesMapper::setSortTriangles()
+
+#ifndef VESTRIANGLESORTER_H
+#define VESTRIANGLESORTER_H
+
+// VES includes
+#include "vesMath.h"
+#include "vesSetGet.h"
+
+// C/C++ includes
+#include <vector>
+
+// Forward declarations
+class vesGeometryData;
+class vesPrimitive;
+
+class vesTriangleSorter
+{
+public:
+  vesTypeMacro(vesTriangleSorter);
+
+  vesTriangleSorter();
+  ~vesTriangleSorter();
+
+  /// Take the triangles to sort from \p triangles, whose vertices are the
+  /// float positions of \p geometryData. Return false, and sort nothing,
+  /// if the data cannot be sorted.
+  bool setTriangles(const vesSharedPtr<vesGeometryData> &geometryData,
+                    const vesSharedPtr<vesPrimitive> &triangles);
+
+  /// Fraction of the triangles, in [0, 1], that must have changed position
+  /// before a new order is published. Default is 0.05.
+  void setUploadThreshold(float fraction);
+  float uploadThreshold() const;
+
+  /// Ask for the triangles to be sorted for a model view matrix. Returns
+  /// immediately, the sort runs on the worker thread. Requests arriving
+  /// while the worker is busy replace each other.
+  void requestSort(const vesMatrix4x4f &modelViewMatrix);
+
+  /// Swap the order published since the last call into \p indices and
+  /// return true, or return false if there is none. The sorter reuses the
+  /// buffer handed back in \p indices, so keeping it sized to the triangle
+  /// indices makes steady state sorting allocation free.
+  bool takeSortedIndices(std::vector<unsigned short> &indices);
+
+  /// Return true if an order was published that takeSortedIndices() has
+  /// not taken yet. The worker does not mark the scene modified, the
+  /// renderer checks this for the sorters it drew.
+  bool hasSortedIndices() const;
+
+private:
+  class vesInternal;
+  vesInternal *m_internal;
+
+  vesTriangleSorter(const vesTriangleSorter&); // Not implemented
+  void operator=(const vesTriangleSorter&);    // Not implemented
+};
+
+#endif // VESTRIANGLESORTER_H
@@ -22,6 +22,8 @@
 #include "vesUniform.h"
 
 // VES includes
+#include "vesObject.h"
+#include "vesRenderStatistics.h"
 #include "vesShaderProgram.h"
 
 // C++ includes
@@ -289,7 +291,7 @@ bool vesUniform::setElement(unsigned int index, float value)
 
   (*this->m_floatArray)[j] = value;
 
-  // \todo: Make state dirty.
+  vesObject::modified();
 
   return true;
 }
@@ -304,7 +306,7 @@ bool vesUniform::setElement(unsigned int index, int value)
 
   (*this->m_intArray)[j] = value;
 
-  // \todo: Make state dirty.
+  vesObject::modified();
 
   return true;
 }
@@ -319,7 +321,7 @@ bool vesUniform::setElement(unsigned int index, bool value)
 
     (*this->m_intArray)[j] = value;
 
-    // \todo: Make state dirty.
+    vesObject::modified();
 
     return true;
 }
@@ -335,7 +337,7 @@ bool vesUniform::setElement(unsigned int index, const vesVector2f &vector)
   (*this->m_floatArray)[j]   = vector[0];
   (*this->m_floatArray)[j+1] = vector[1];
 
-  // \todo: Make state dirty.
+  vesObject::modified();
 
   return true;
 }
@@ -352,7 +354,7 @@ bool vesUniform::setElement(unsigned int index, const vesVector3f &vector)
   (*this->m_floatArray)[j+1] = vector[1];
   (*this->m_floatArray)[j+2] = vector[2];
 
-  // \todo: Make state dirty.
+  vesObject::modified();
 
   return true;
 }
@@ -370,7 +372,7 @@ bool vesUniform::setElement(unsigned int index, const vesVector4f &vector)
   (*this->m_floatArray)[j+2] = vector[2];
   (*this->m_floatArray)[j+3] = vector[3];
 
-  // \todo: Make state dirty.
+  vesObject::modified();
 
   return true;
 }
@@ -386,7 +388,7 @@ bool vesUniform::setElement(unsigned int index, const vesMatrix3x3f &matrix)
   for (int i = 0; i < 9; ++i)
     (*this->m_floatArray)[j+i] = matrix.data()[i];
 
-  // \todo: Make state dirty.
+  vesObject::modified();
 
   return true;
 }
@@ -402,7 +404,7 @@ bool vesUniform::setElement(unsigned int index, const vesMatrix4x4f &matrix)
   for (int i = 0; i < 16; ++i)
     (*this->m_floatArray)[j+i] = matrix.data()[i];
 
-  // \todo: Make state dirty.
+  vesObject::modified();
 
   return true;
 }
@@ -515,6 +517,8 @@ void vesUniform::callGL(int location) const
   if (this->m_numberElements < 1)
     return;
 
+  vesRenderStatistics::addUniformUpload();
+
   switch (this->m_type)
   {
     case Bool:
@@ -101,8 +101,8 @@ public:
                           sourceData->attributeStride(key),
                           (void*)sourceData->attributeOffset(key));
 
-    glEnableVertexAttribArray(renderState.m_material->shaderProgram()->
-                              attributeLocation(this->m_name));
+    renderState.m_glState->enableVertexAttribArray(
+      renderState.m_material->shaderProgram()->attributeLocation(this->m_name));
   }
 
   virtual void unbindVertexData(const vesRenderState &renderState, int key)
@@ -110,8 +110,8 @@ public:
     vesNotUsed(key);
     assert(renderState.m_material && renderState.m_material->shaderProgram());
 
-    glDisableVertexAttribArray(renderState.m_material->shaderProgram()->
-                               attributeLocation(this->m_name));
+    renderState.m_glState->disableVertexAttribArray(
+      renderState.m_material->shaderProgram()->attributeLocation(this->m_name));
   }
 };
 
@@ -155,4 +155,14 @@ public:
   }
 };
 
+
+class vesScalarVertexAttribute : public vesGenericVertexAttribute
+{
+public:
+  vesScalarVertexAttribute(const std::string &name="vertexScalar") :
+    vesGenericVertexAttribute(name)
+  {
+  }
+};
+
 #endif // VESVERTEXATTRIBUTE_H
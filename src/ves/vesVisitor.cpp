@@ -23,36 +23,63 @@
 
 #include "vesActor.h"
 #include "vesCamera.h"
+#include "vesFrameArena.h"
 #include "vesGroupNode.h"
 #include "vesMapper.h"
 #include "vesNode.h"
 #include "vesTransformNode.h"
 
 // C++ includes
-#include <deque>
 #include <vector>
 
 class vesVisitor::vesInternal
 {
 public:
+  typedef vesFrameArenaAllocator< vesSharedPtr<vesActor> > ActorAllocator;
+  typedef vesFrameArenaAllocator<const vesMatrix4x4f*> MatrixAllocator;
+  typedef vesFrameArenaAllocator<unsigned int> VersionAllocator;
+
+  vesInternal(vesFrameArena *arena) :
+    m_actorStack(ActorAllocator(arena)),
+    m_modelViewMatrixStack(MatrixAllocator(arena)),
+    m_modelViewMatrixVersionStack(VersionAllocator(arena)),
+    m_projectionMatrixStack(MatrixAllocator(arena))
+  {
+    this->m_identity.setIdentity();
+  }
 
-  std::deque < vesSharedPtr<vesActor> > m_actorStack;
-  std::vector<const vesMatrix4x4f*> m_modelViewMatrixStack;
-  std::vector<const vesMatrix4x4f*> m_projectionMatrixStack;
+  std::vector<vesSharedPtr<vesActor>, ActorAllocator> m_actorStack;
+  std::vector<const vesMatrix4x4f*, MatrixAllocator> m_modelViewMatrixStack;
+  std::vector<unsigned int, VersionAllocator> m_modelViewMatrixVersionStack;
+  std::vector<const vesMatrix4x4f*, MatrixAllocator> m_projectionMatrixStack;
+  vesMatrix4x4f m_identity;
 };
 
 
-vesVisitor::vesVisitor(VisitorType type, TraversalMode mode) :
+vesVisitor::vesVisitor(VisitorType type, TraversalMode mode,
+                       vesFrameArena *frameArena) :
   m_visitorType   (type),
-  m_traversalMode (mode)
+  m_traversalMode (mode),
+  m_frameArena    (frameArena)
 {
-  this->m_internal = new vesInternal();
+  if (frameArena) {
+    this->m_internal = new (frameArena->allocate(sizeof(vesInternal)))
+      vesInternal(frameArena);
+  }
+  else {
+    this->m_internal = new vesInternal(0x0);
+  }
 }
 
 
 vesVisitor::~vesVisitor()
 {
-  delete this->m_internal;
+  if (this->m_frameArena) {
+    this->m_internal->~vesInternal();
+  }
+  else {
+    delete this->m_internal;
+  }
 }
 
 
@@ -74,15 +101,18 @@ vesSharedPtr<vesActor> vesVisitor::actor() const
 }
 
 
-void vesVisitor::pushModelViewMatrix(const vesMatrix4x4f &matrix)
+void vesVisitor::pushModelViewMatrix(const vesMatrix4x4f &matrix,
+                                     unsigned int version)
 {
   this->m_internal->m_modelViewMatrixStack.push_back(&matrix);
+  this->m_internal->m_modelViewMatrixVersionStack.push_back(version);
 }
 
 
 void vesVisitor::popModelViewMatrix()
 {
   this->m_internal->m_modelViewMatrixStack.pop_back();
+  this->m_internal->m_modelViewMatrixVersionStack.pop_back();
 }
 
 
@@ -98,28 +128,34 @@ void vesVisitor::popProjectionMatrix()
 }
 
 
-vesMatrix4x4f vesVisitor::modelViewMatrix()
+const vesMatrix4x4f& vesVisitor::modelViewMatrix() const
 {
-  vesMatrix4x4f matrix;
-  matrix.setIdentity();
+  if (this->m_internal->m_modelViewMatrixStack.empty()) {
+    return this->m_internal->m_identity;
+  }
+
+  return *this->m_internal->m_modelViewMatrixStack.back();
+}
 
-  if (!this->m_internal->m_modelViewMatrixStack.empty()) {
-    matrix = *this->m_internal->m_modelViewMatrixStack.back();
+
+unsigned int vesVisitor::modelViewMatrixVersion() const
+{
+  // The identity at the root has version 1.
+  if (this->m_internal->m_modelViewMatrixVersionStack.empty()) {
+    return 1;
   }
 
-  return matrix;
+  return this->m_internal->m_modelViewMatrixVersionStack.back();
 }
 
 
-vesMatrix4x4f vesVisitor::projectionMatrix()
+const vesMatrix4x4f& vesVisitor::projectionMatrix() const
 {
-  vesMatrix4x4f matrix;
-  matrix.setIdentity();
-  if (!this->m_internal->m_projectionMatrixStack.empty()) {
-    matrix = *this->m_internal->m_projectionMatrixStack.back();
+  if (this->m_internal->m_projectionMatrixStack.empty()) {
+    return this->m_internal->m_identity;
   }
 
-  return matrix;
+  return *this->m_internal->m_projectionMatrixStack.back();
 }
 
 
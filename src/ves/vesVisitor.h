@@ -31,6 +31,7 @@
 // Forward declarations
 class vesActor;
 class vesCamera;
+class vesFrameArena;
 class vesGroupNode;
 class vesMapper;
 class vesMaterial;
@@ -58,21 +59,36 @@ public:
     CullVisitor   = 0x8
   };
 
-  vesVisitor(VisitorType type, TraversalMode=TraverseNone);
+  /// With a \p frameArena the visitor and its stacks take their memory
+  /// from it, which must then outlive the visitor.
+  vesVisitor(VisitorType type, TraversalMode=TraverseNone,
+             vesFrameArena *frameArena=0x0);
   virtual ~vesVisitor();
 
+  vesFrameArena* frameArena() const { return this->m_frameArena; }
+
   void pushActor(const vesSharedPtr<vesActor> &actor);
   void popActor();
   vesSharedPtr<vesActor> actor() const;
 
-  void pushModelViewMatrix(const vesMatrix4x4f& matrix);
+  /// Push a model view matrix, which must outlive its place on the stack.
+  /// \p version identifies its value, see
+  /// vesTransformNode::localToWorldVersion(); 0 means unknown.
+  void pushModelViewMatrix(const vesMatrix4x4f& matrix,
+                           unsigned int version=0);
   void popModelViewMatrix ();
 
   void pushProjectionMatrix(const vesMatrix4x4f& matrix);
   void popProjectionMatrix ();
 
-  vesMatrix4x4f modelViewMatrix();
-  vesMatrix4x4f projectionMatrix();
+  /// Model view matrix on top of the stack, identity if empty
+  const vesMatrix4x4f& modelViewMatrix() const;
+
+  /// Version of the model view matrix on top of the stack
+  unsigned int modelViewMatrixVersion() const;
+
+  /// Projection matrix on top of the stack, identity if empty
+  const vesMatrix4x4f& projectionMatrix() const;
 
   vesMatrix4x4f projection2DMatrix() { return this->m_projection2DMatrix; }
   void setProjection2DMatrix(const vesMatrix4x4f& matrix) { this->m_projection2DMatrix = matrix; }
@@ -103,6 +119,8 @@ protected:
 
   vesMatrix4x4f m_projection2DMatrix;
 
+  vesFrameArena *m_frameArena;
+
   class vesInternal;
   vesInternal* m_internal;
 };